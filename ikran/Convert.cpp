@@ -1,5 +1,39 @@
 #include "Convert.h"
 
+#include "base/cpu.h"
+
+/*
+ * The SSE2 kernels need the intrinsics to be usable without extra
+ * compiler flags, which holds for MSVC and for gcc/clang targets that
+ * enable SSE2 by default (x86_64, Mac OS X).
+ */
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || \
+	(defined(__GNUC__) && defined(__SSE2__))
+#define CONVERT_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/*
+ * The AVX2 kernels are built into every SSE2 build whose compiler can
+ * target AVX2 per function, and only run when the CPU and the OS support
+ * it.  base::CPU has no AVX2 bit, so the check is done here.
+ */
+#if defined(CONVERT_HAVE_SSE2) && \
+	((defined(_MSC_VER) && _MSC_VER >= 1700) || \
+	 (defined(__clang__) && (__clang_major__ > 3 || \
+		(__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+	 (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || \
+		(__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define CONVERT_HAVE_AVX2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CONVERT_TARGET_AVX2
+#else
+#define CONVERT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 enum {
 	CLIP_SIZE = 811,
 	CLIP_OFFSET = 277,
@@ -22,6 +56,23 @@ static unsigned long yuv2rgb_clip[CLIP_SIZE];
 static unsigned long yuv2rgb_clip8[CLIP_SIZE];
 static unsigned long yuv2rgb_clip16[CLIP_SIZE];
 
+/*
+ * Row kernels convert the widest prefix of a row (pair) they can and
+ * return the number of pixels done; the C kernels finish the rest.
+ */
+typedef int (*i420_row_fn)(const unsigned char *y_even,
+	const unsigned char *y_odd, const unsigned char *u,
+	const unsigned char *v, unsigned int *dst_even,
+	unsigned int *dst_odd, int width);
+typedef int (*rgb32_row_fn)(const unsigned char *src_even,
+	const unsigned char *src_odd, unsigned char *y_even,
+	unsigned char *y_odd, unsigned char *u, unsigned char *v, int width);
+
+static int kernels_initialized = 0;
+static int cpu_kernels = CONVERT_KERNELS_C;
+static i420_row_fn i420_row_simd = 0;
+static rgb32_row_fn rgb32_row_simd = 0;
+
 #define COMPOSE_RGB(yc, rc, gc, bc)		\
 	( 0xff000000 |				\
 	  yuv2rgb_clip16[(yc) + (rc)] |		\
@@ -58,58 +109,607 @@ static void init_yuv2rgb_tables(void)
 	tables_initialized = 1;
 }
 
+/*
+ * C row kernel for I420 to RGB32, starting at pixel x (even).  The odd
+ * row pointers are NULL for the last row of an odd height image.
+ */
+static void
+I420toRGB32Row_C(const unsigned char *y_even, const unsigned char *y_odd,
+	const unsigned char *u, const unsigned char *v,
+	unsigned int *dst_even, unsigned int *dst_odd, int x, int width)
+{
+	int j;
+
+	for (j = x; j < width; j += 2) {
+		const int c = j >> 1;
+		const int rc = yuv2rgb_r[v[c]];
+		const int gc = yuv2rgb_g1[v[c]] + yuv2rgb_g2[u[c]];
+		const int bc = yuv2rgb_b[u[c]];
+		const int last = (j + 1 >= width);
+		int yc;
+
+		yc = CLIP_OFFSET + yuv2rgb_y[y_even[j]];
+		dst_even[j] = COMPOSE_RGB(yc, bc, gc, rc);
+		if (!last) {
+			yc = CLIP_OFFSET + yuv2rgb_y[y_even[j + 1]];
+			dst_even[j + 1] = COMPOSE_RGB(yc, bc, gc, rc);
+		}
+		if (y_odd) {
+			yc = CLIP_OFFSET + yuv2rgb_y[y_odd[j]];
+			dst_odd[j] = COMPOSE_RGB(yc, bc, gc, rc);
+			if (!last) {
+				yc = CLIP_OFFSET + yuv2rgb_y[y_odd[j + 1]];
+				dst_odd[j + 1] = COMPOSE_RGB(yc, bc, gc, rc);
+			}
+		}
+	}
+}
+
+#define RGB_TO_Y(r, g, b) \
+	((unsigned char)((((r) * 66 + (g) * 129 + (b) * 25 + 128) >> 8) + 16))
+#define RGB_TO_U(r, g, b) \
+	((unsigned char)((((r) * -38 - (g) * 74 + (b) * 112 + 128) >> 8) + 128))
+#define RGB_TO_V(r, g, b) \
+	((unsigned char)((((r) * 112 - (g) * 94 - (b) * 18 + 128) >> 8) + 128))
+
+/*
+ * C row kernel for RGB32 to I420, starting at pixel x (even).  Chroma
+ * is taken from the top left pixel of each 2x2 block.
+ */
+static void
+RGB32toI420Row_C(const unsigned char *src_even, const unsigned char *src_odd,
+	unsigned char *y_even, unsigned char *y_odd,
+	unsigned char *u, unsigned char *v, int x, int width)
+{
+	int j;
+
+	for (j = x; j < width; ++j) {
+		const unsigned char *p = src_even + j * 4;
+		short r = p[0], g = p[1], b = p[2];
+
+		y_even[j] = RGB_TO_Y(r, g, b);
+		if (!(j & 1)) {
+			u[j >> 1] = RGB_TO_U(r, g, b);
+			v[j >> 1] = RGB_TO_V(r, g, b);
+		}
+		if (src_odd) {
+			p = src_odd + j * 4;
+			r = p[0];
+			g = p[1];
+			b = p[2];
+			y_odd[j] = RGB_TO_Y(r, g, b);
+		}
+	}
+}
+
+#ifdef CONVERT_HAVE_SSE2
+/*
+ * The SSE2 kernels are bit exact with the tables above: every table
+ * product is split so the intermediate fits in 16 bits, e.g.
+ * (298 * y + 128) >> 8 == y + ((42 * y + 128) >> 8), and packus does
+ * the clipping.
+ */
+static inline void
+StoreRGB32x16_SSE2(const unsigned char *y, __m128i rc_lo, __m128i rc_hi,
+	__m128i gc_lo, __m128i gc_hi, __m128i bc_lo, __m128i bc_hi,
+	unsigned int *dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i k16 = _mm_set1_epi16(16);
+	const __m128i kymul = _mm_set1_epi16(YMUL - 256);
+	const __m128i kround = _mm_set1_epi16(128);
+	const __m128i alpha = _mm_set1_epi8((char)0xff);
+	__m128i y8 = _mm_loadu_si128((const __m128i *)y);
+	__m128i y_lo = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), k16);
+	__m128i y_hi = _mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), k16);
+	__m128i r, g, b, rg, ba;
+
+	y_lo = _mm_add_epi16(y_lo, _mm_srai_epi16(
+		_mm_add_epi16(_mm_mullo_epi16(y_lo, kymul), kround), 8));
+	y_hi = _mm_add_epi16(y_hi, _mm_srai_epi16(
+		_mm_add_epi16(_mm_mullo_epi16(y_hi, kymul), kround), 8));
+
+	r = _mm_packus_epi16(_mm_add_epi16(y_lo, rc_lo), _mm_add_epi16(y_hi, rc_hi));
+	g = _mm_packus_epi16(_mm_add_epi16(y_lo, gc_lo), _mm_add_epi16(y_hi, gc_hi));
+	b = _mm_packus_epi16(_mm_add_epi16(y_lo, bc_lo), _mm_add_epi16(y_hi, bc_hi));
+
+	rg = _mm_unpacklo_epi8(r, g);
+	ba = _mm_unpacklo_epi8(b, alpha);
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(rg, ba));
+	rg = _mm_unpackhi_epi8(r, g);
+	ba = _mm_unpackhi_epi8(b, alpha);
+	_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *)(dst + 12), _mm_unpackhi_epi16(rg, ba));
+}
+
+static int
+I420toRGB32Row_SSE2(const unsigned char *y_even, const unsigned char *y_odd,
+	const unsigned char *u, const unsigned char *v,
+	unsigned int *dst_even, unsigned int *dst_odd, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i k128 = _mm_set1_epi16(128);
+	const __m128i krmul = _mm_set1_epi16(RMUL - 256);
+	const __m128i kg1mul = _mm_set1_epi16(G1MUL);
+	const __m128i kg2mul = _mm_set1_epi16(G2MUL);
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i uu = _mm_sub_epi16(_mm_unpacklo_epi8(
+			_mm_loadl_epi64((const __m128i *)(u + (x >> 1))), zero), k128);
+		__m128i vv = _mm_sub_epi16(_mm_unpacklo_epi8(
+			_mm_loadl_epi64((const __m128i *)(v + (x >> 1))), zero), k128);
+		/* 409 = 256 + 153, 516 = 512 + 4 */
+		__m128i rc = _mm_add_epi16(vv,
+			_mm_srai_epi16(_mm_mullo_epi16(vv, krmul), 8));
+		__m128i gc = _mm_add_epi16(
+			_mm_srai_epi16(_mm_mullo_epi16(vv, kg1mul), 8),
+			_mm_srai_epi16(_mm_mullo_epi16(uu, kg2mul), 8));
+		__m128i bc = _mm_add_epi16(_mm_slli_epi16(uu, 1),
+			_mm_srai_epi16(_mm_slli_epi16(uu, 2), 8));
+		__m128i rc_lo = _mm_unpacklo_epi16(rc, rc);
+		__m128i rc_hi = _mm_unpackhi_epi16(rc, rc);
+		__m128i gc_lo = _mm_unpacklo_epi16(gc, gc);
+		__m128i gc_hi = _mm_unpackhi_epi16(gc, gc);
+		__m128i bc_lo = _mm_unpacklo_epi16(bc, bc);
+		__m128i bc_hi = _mm_unpackhi_epi16(bc, bc);
+
+		StoreRGB32x16_SSE2(y_even + x, rc_lo, rc_hi, gc_lo, gc_hi,
+			bc_lo, bc_hi, dst_even + x);
+		if (y_odd)
+			StoreRGB32x16_SSE2(y_odd + x, rc_lo, rc_hi, gc_lo, gc_hi,
+				bc_lo, bc_hi, dst_odd + x);
+	}
+
+	return x;
+}
+
+/* Split 8 RGB32 pixels into 16 bit r, g and b lanes. */
+static inline void
+LoadRGB32x8_SSE2(const unsigned char *src, __m128i *r, __m128i *g, __m128i *b)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	__m128i p0 = _mm_loadu_si128((const __m128i *)src);
+	__m128i p1 = _mm_loadu_si128((const __m128i *)(src + 16));
+
+	*r = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+	*g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+		_mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+	*b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+		_mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+/* Y for 8 pixels; the weighted sum stays below 65536 so unsigned 16 bit lanes are exact. */
+static inline __m128i
+RGBToY8_SSE2(__m128i r, __m128i g, __m128i b)
+{
+	__m128i sum = _mm_add_epi16(
+		_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+			_mm_mullo_epi16(g, _mm_set1_epi16(129))),
+		_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)),
+			_mm_set1_epi16(128)));
+
+	return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+static inline __m128i
+RGBToChroma8_SSE2(__m128i r, __m128i g, __m128i b,
+	short rmul, short gmul, short bmul)
+{
+	__m128i sum = _mm_add_epi16(
+		_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(rmul)),
+			_mm_mullo_epi16(g, _mm_set1_epi16(gmul))),
+		_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(bmul)),
+			_mm_set1_epi16(128)));
+
+	return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+}
+
+/* Keep the even (top left of each 2x2 block) lanes of two chroma vectors. */
+static inline __m128i
+PackEvenLanes_SSE2(__m128i c0, __m128i c1)
+{
+	const __m128i mask = _mm_set1_epi32(0xffff);
+	__m128i even = _mm_packs_epi32(_mm_and_si128(c0, mask),
+		_mm_and_si128(c1, mask));
+
+	return _mm_packus_epi16(even, even);
+}
+
+static int
+RGB32toI420Row_SSE2(const unsigned char *src_even, const unsigned char *src_odd,
+	unsigned char *y_even, unsigned char *y_odd,
+	unsigned char *u, unsigned char *v, int width)
+{
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i r0, g0, b0, r1, g1, b1;
+
+		LoadRGB32x8_SSE2(src_even + x * 4, &r0, &g0, &b0);
+		LoadRGB32x8_SSE2(src_even + x * 4 + 32, &r1, &g1, &b1);
+		_mm_storeu_si128((__m128i *)(y_even + x), _mm_packus_epi16(
+			RGBToY8_SSE2(r0, g0, b0), RGBToY8_SSE2(r1, g1, b1)));
+		_mm_storel_epi64((__m128i *)(u + (x >> 1)), PackEvenLanes_SSE2(
+			RGBToChroma8_SSE2(r0, g0, b0, -38, -74, 112),
+			RGBToChroma8_SSE2(r1, g1, b1, -38, -74, 112)));
+		_mm_storel_epi64((__m128i *)(v + (x >> 1)), PackEvenLanes_SSE2(
+			RGBToChroma8_SSE2(r0, g0, b0, 112, -94, -18),
+			RGBToChroma8_SSE2(r1, g1, b1, 112, -94, -18)));
+
+		if (src_odd) {
+			LoadRGB32x8_SSE2(src_odd + x * 4, &r0, &g0, &b0);
+			LoadRGB32x8_SSE2(src_odd + x * 4 + 32, &r1, &g1, &b1);
+			_mm_storeu_si128((__m128i *)(y_odd + x), _mm_packus_epi16(
+				RGBToY8_SSE2(r0, g0, b0), RGBToY8_SSE2(r1, g1, b1)));
+		}
+	}
+
+	return x;
+}
+#endif /* CONVERT_HAVE_SSE2 */
+
+#ifdef CONVERT_HAVE_AVX2
+/*
+ * The AVX2 kernels do the same arithmetic as the SSE2 ones on 32 pixels.
+ * The 256 bit unpack and pack instructions work within each 128 bit
+ * half, so the lanes are put back in pixel order with a permute after
+ * each pack.
+ */
+static inline CONVERT_TARGET_AVX2 void
+StoreRGB32x32_AVX2(const unsigned char *y, __m256i rc, __m256i gc,
+	__m256i bc, unsigned int *dst)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i k16 = _mm256_set1_epi16(16);
+	const __m256i kymul = _mm256_set1_epi16(YMUL - 256);
+	const __m256i kround = _mm256_set1_epi16(128);
+	const __m256i alpha = _mm256_set1_epi8((char)0xff);
+	__m256i y8 = _mm256_loadu_si256((const __m256i *)y);
+	/* pixels 0-7 and 16-23, then 8-15 and 24-31 */
+	__m256i y_lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(y8, zero), k16);
+	__m256i y_hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(y8, zero), k16);
+	__m256i rc_lo = _mm256_unpacklo_epi16(rc, rc);
+	__m256i rc_hi = _mm256_unpackhi_epi16(rc, rc);
+	__m256i gc_lo = _mm256_unpacklo_epi16(gc, gc);
+	__m256i gc_hi = _mm256_unpackhi_epi16(gc, gc);
+	__m256i bc_lo = _mm256_unpacklo_epi16(bc, bc);
+	__m256i bc_hi = _mm256_unpackhi_epi16(bc, bc);
+	__m256i r, g, b, rg_lo, rg_hi, ba_lo, ba_hi, q0, q1, q2, q3;
+
+	y_lo = _mm256_add_epi16(y_lo, _mm256_srai_epi16(
+		_mm256_add_epi16(_mm256_mullo_epi16(y_lo, kymul), kround), 8));
+	y_hi = _mm256_add_epi16(y_hi, _mm256_srai_epi16(
+		_mm256_add_epi16(_mm256_mullo_epi16(y_hi, kymul), kround), 8));
+
+	/* packing the two halves back together restores pixel order */
+	r = _mm256_packus_epi16(_mm256_add_epi16(y_lo, rc_lo),
+		_mm256_add_epi16(y_hi, rc_hi));
+	g = _mm256_packus_epi16(_mm256_add_epi16(y_lo, gc_lo),
+		_mm256_add_epi16(y_hi, gc_hi));
+	b = _mm256_packus_epi16(_mm256_add_epi16(y_lo, bc_lo),
+		_mm256_add_epi16(y_hi, bc_hi));
+
+	rg_lo = _mm256_unpacklo_epi8(r, g);
+	rg_hi = _mm256_unpackhi_epi8(r, g);
+	ba_lo = _mm256_unpacklo_epi8(b, alpha);
+	ba_hi = _mm256_unpackhi_epi8(b, alpha);
+	q0 = _mm256_unpacklo_epi16(rg_lo, ba_lo);	/* 0-3, 16-19 */
+	q1 = _mm256_unpackhi_epi16(rg_lo, ba_lo);	/* 4-7, 20-23 */
+	q2 = _mm256_unpacklo_epi16(rg_hi, ba_hi);	/* 8-11, 24-27 */
+	q3 = _mm256_unpackhi_epi16(rg_hi, ba_hi);	/* 12-15, 28-31 */
+	_mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(q0, q1, 0x20));
+	_mm256_storeu_si256((__m256i *)(dst + 8), _mm256_permute2x128_si256(q2, q3, 0x20));
+	_mm256_storeu_si256((__m256i *)(dst + 16), _mm256_permute2x128_si256(q0, q1, 0x31));
+	_mm256_storeu_si256((__m256i *)(dst + 24), _mm256_permute2x128_si256(q2, q3, 0x31));
+}
+
+static CONVERT_TARGET_AVX2 int
+I420toRGB32Row_AVX2(const unsigned char *y_even, const unsigned char *y_odd,
+	const unsigned char *u, const unsigned char *v,
+	unsigned int *dst_even, unsigned int *dst_odd, int width)
+{
+	const __m256i k128 = _mm256_set1_epi16(128);
+	const __m256i krmul = _mm256_set1_epi16(RMUL - 256);
+	const __m256i kg1mul = _mm256_set1_epi16(G1MUL);
+	const __m256i kg2mul = _mm256_set1_epi16(G2MUL);
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i uu = _mm256_sub_epi16(_mm256_cvtepu8_epi16(
+			_mm_loadu_si128((const __m128i *)(u + (x >> 1)))), k128);
+		__m256i vv = _mm256_sub_epi16(_mm256_cvtepu8_epi16(
+			_mm_loadu_si128((const __m128i *)(v + (x >> 1)))), k128);
+		__m256i rc = _mm256_add_epi16(vv,
+			_mm256_srai_epi16(_mm256_mullo_epi16(vv, krmul), 8));
+		__m256i gc = _mm256_add_epi16(
+			_mm256_srai_epi16(_mm256_mullo_epi16(vv, kg1mul), 8),
+			_mm256_srai_epi16(_mm256_mullo_epi16(uu, kg2mul), 8));
+		__m256i bc = _mm256_add_epi16(_mm256_slli_epi16(uu, 1),
+			_mm256_srai_epi16(_mm256_slli_epi16(uu, 2), 8));
+
+		StoreRGB32x32_AVX2(y_even + x, rc, gc, bc, dst_even + x);
+		if (y_odd)
+			StoreRGB32x32_AVX2(y_odd + x, rc, gc, bc, dst_odd + x);
+	}
+
+	/* one more block of 16 for the SSE2 kernel */
+	return x + I420toRGB32Row_SSE2(y_even + x, y_odd ? y_odd + x : 0,
+		u + (x >> 1), v + (x >> 1), dst_even + x,
+		dst_odd ? dst_odd + x : 0, width - x);
+}
+
+/* Split 16 RGB32 pixels into 16 bit r, g and b lanes, in pixel order. */
+static inline CONVERT_TARGET_AVX2 void
+LoadRGB32x16_AVX2(const unsigned char *src, __m256i *r, __m256i *g, __m256i *b)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	__m256i p0 = _mm256_loadu_si256((const __m256i *)src);
+	__m256i p1 = _mm256_loadu_si256((const __m256i *)(src + 32));
+
+	*r = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+		_mm256_and_si256(p0, mask), _mm256_and_si256(p1, mask)), 0xd8);
+	*g = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+		_mm256_and_si256(_mm256_srli_epi32(p0, 8), mask),
+		_mm256_and_si256(_mm256_srli_epi32(p1, 8), mask)), 0xd8);
+	*b = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+		_mm256_and_si256(_mm256_srli_epi32(p0, 16), mask),
+		_mm256_and_si256(_mm256_srli_epi32(p1, 16), mask)), 0xd8);
+}
+
+static inline CONVERT_TARGET_AVX2 __m256i
+RGBToY16_AVX2(__m256i r, __m256i g, __m256i b)
+{
+	__m256i sum = _mm256_add_epi16(
+		_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(66)),
+			_mm256_mullo_epi16(g, _mm256_set1_epi16(129))),
+		_mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(25)),
+			_mm256_set1_epi16(128)));
+
+	return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(16));
+}
+
+static inline CONVERT_TARGET_AVX2 __m256i
+RGBToChroma16_AVX2(__m256i r, __m256i g, __m256i b,
+	short rmul, short gmul, short bmul)
+{
+	__m256i sum = _mm256_add_epi16(
+		_mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(rmul)),
+			_mm256_mullo_epi16(g, _mm256_set1_epi16(gmul))),
+		_mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(bmul)),
+			_mm256_set1_epi16(128)));
+
+	return _mm256_add_epi16(_mm256_srai_epi16(sum, 8), _mm256_set1_epi16(128));
+}
+
+/* The 16 even lanes of two chroma vectors, as bytes in pixel order. */
+static inline CONVERT_TARGET_AVX2 __m128i
+PackEvenLanes_AVX2(__m256i c0, __m256i c1)
+{
+	const __m256i mask = _mm256_set1_epi32(0xffff);
+	__m256i even = _mm256_permute4x64_epi64(_mm256_packs_epi32(
+		_mm256_and_si256(c0, mask), _mm256_and_si256(c1, mask)), 0xd8);
+
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(
+		_mm256_packus_epi16(even, even), 0xd8));
+}
+
+static inline CONVERT_TARGET_AVX2 __m256i
+PackY32_AVX2(__m256i y0, __m256i y1)
+{
+	return _mm256_permute4x64_epi64(_mm256_packus_epi16(y0, y1), 0xd8);
+}
+
+static CONVERT_TARGET_AVX2 int
+RGB32toI420Row_AVX2(const unsigned char *src_even, const unsigned char *src_odd,
+	unsigned char *y_even, unsigned char *y_odd,
+	unsigned char *u, unsigned char *v, int width)
+{
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i r0, g0, b0, r1, g1, b1;
+
+		LoadRGB32x16_AVX2(src_even + x * 4, &r0, &g0, &b0);
+		LoadRGB32x16_AVX2(src_even + x * 4 + 64, &r1, &g1, &b1);
+		_mm256_storeu_si256((__m256i *)(y_even + x), PackY32_AVX2(
+			RGBToY16_AVX2(r0, g0, b0), RGBToY16_AVX2(r1, g1, b1)));
+		_mm_storeu_si128((__m128i *)(u + (x >> 1)), PackEvenLanes_AVX2(
+			RGBToChroma16_AVX2(r0, g0, b0, -38, -74, 112),
+			RGBToChroma16_AVX2(r1, g1, b1, -38, -74, 112)));
+		_mm_storeu_si128((__m128i *)(v + (x >> 1)), PackEvenLanes_AVX2(
+			RGBToChroma16_AVX2(r0, g0, b0, 112, -94, -18),
+			RGBToChroma16_AVX2(r1, g1, b1, 112, -94, -18)));
+
+		if (src_odd) {
+			LoadRGB32x16_AVX2(src_odd + x * 4, &r0, &g0, &b0);
+			LoadRGB32x16_AVX2(src_odd + x * 4 + 64, &r1, &g1, &b1);
+			_mm256_storeu_si256((__m256i *)(y_odd + x), PackY32_AVX2(
+				RGBToY16_AVX2(r0, g0, b0), RGBToY16_AVX2(r1, g1, b1)));
+		}
+	}
+
+	/* one more block of 16 for the SSE2 kernel */
+	return x + RGB32toI420Row_SSE2(src_even + x * 4,
+		src_odd ? src_odd + x * 4 : 0, y_even + x, y_odd ? y_odd + x : 0,
+		u + (x >> 1), v + (x >> 1), width - x);
+}
+
+/* AVX2 needs the OS to save the ymm registers as well as the CPU bit. */
+static int
+cpu_has_avx2(void)
+{
+#ifdef _MSC_VER
+	int regs[4];
+
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return 0;
+	__cpuid(regs, 1);
+	/* OSXSAVE and AVX */
+	if ((regs[2] & 0x18000000) != 0x18000000)
+		return 0;
+	if ((_xgetbv(0) & 6) != 6)
+		return 0;
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & 0x20) != 0;
+#else
+	/* checks XGETBV as well */
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif /* CONVERT_HAVE_AVX2 */
+
+static void select_kernels(int kernels)
+{
+	i420_row_simd = 0;
+	rgb32_row_simd = 0;
+	switch (kernels) {
+#ifdef CONVERT_HAVE_AVX2
+	case CONVERT_KERNELS_AVX2:
+		i420_row_simd = I420toRGB32Row_AVX2;
+		rgb32_row_simd = RGB32toI420Row_AVX2;
+		break;
+#endif
+#ifdef CONVERT_HAVE_SSE2
+	case CONVERT_KERNELS_SSE2:
+		i420_row_simd = I420toRGB32Row_SSE2;
+		rgb32_row_simd = RGB32toI420Row_SSE2;
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+static void init_kernels(void)
+{
+	if (!tables_initialized)
+		init_yuv2rgb_tables();
+
+#ifdef CONVERT_HAVE_SSE2
+	{
+		base::CPU cpu;
+
+		if (cpu.has_sse2())
+			cpu_kernels = CONVERT_KERNELS_SSE2;
+	}
+#endif
+#ifdef CONVERT_HAVE_AVX2
+	if (cpu_kernels == CONVERT_KERNELS_SSE2 && cpu_has_avx2())
+		cpu_kernels = CONVERT_KERNELS_AVX2;
+#endif
+	select_kernels(cpu_kernels);
+
+	kernels_initialized = 1;
+}
+
+int
+ConvertSetKernels(int kernels)
+{
+	if (!kernels_initialized)
+		init_kernels();
+	if (kernels > cpu_kernels)
+		kernels = cpu_kernels;
+	if (kernels < CONVERT_KERNELS_C)
+		kernels = CONVERT_KERNELS_C;
+	select_kernels(kernels);
+	return kernels;
+}
+
+/*
+ * Convert i420 planes to RGB32, same pixel layout as I420toRGB32.
+ * NOTE: dst must hold height rows of dst_stride >= width * 4 bytes
+ *
+ * The C kernels use precalculated tables that are initialized on the
+ * first run; the SIMD kernel is picked once from the CPU features.
+ */
+int
+I420toRGB32Planes(int width, int height,
+	const char *src_y, int stride_y,
+	const char *src_u, int stride_u,
+	const char *src_v, int stride_v,
+	char *dst, int dst_stride)
+{
+	i420_row_fn row_simd;
+	int i;
+
+	if (!kernels_initialized)
+		init_kernels();
+	row_simd = i420_row_simd;
+
+	for (i = 0; i < height; i += 2) {
+		const unsigned char *y_even =
+			(const unsigned char *)src_y + i * stride_y;
+		const unsigned char *y_odd =
+			(i + 1 < height) ? y_even + stride_y : 0;
+		const unsigned char *u =
+			(const unsigned char *)src_u + (i >> 1) * stride_u;
+		const unsigned char *v =
+			(const unsigned char *)src_v + (i >> 1) * stride_v;
+		unsigned int *dst_even = (unsigned int *)(dst + i * dst_stride);
+		unsigned int *dst_odd = y_odd ?
+			(unsigned int *)(dst + (i + 1) * dst_stride) : 0;
+		int x = 0;
+
+		if (row_simd)
+			x = row_simd(y_even, y_odd, u, v, dst_even, dst_odd, width);
+		I420toRGB32Row_C(y_even, y_odd, u, v, dst_even, dst_odd, x, width);
+	}
+
+	return 0;
+}
+
 /*
  * Convert i420 to RGB32 (0xBBGGRRAA).
  * NOTE: size of dest must be >= width * height * 4
- *
- * This function uses precalculated tables that are initialized
- * on the first run.
  */
 int
 I420toRGB32(int width, int height, const char *src, char *dst)
 {
-	int i, j;
-	unsigned int *dst_odd;
-	unsigned int *dst_even;
-	const unsigned char *u;
-	const unsigned char *v;
-	const unsigned char *y_odd;
-	const unsigned char *y_even;
+	const int chroma_width = (width + 1) >> 1;
+	const int chroma_height = (height + 1) >> 1;
+	const char *u = src + width * height;
+	const char *v = u + chroma_width * chroma_height;
 
-	if (!tables_initialized)
-		init_yuv2rgb_tables();
+	return I420toRGB32Planes(width, height, src, width, u, chroma_width,
+		v, chroma_width, dst, width * 4);
+}
 
-	dst_even = (unsigned int *)dst;
-	dst_odd = dst_even + width;
-
-	y_even = (const unsigned char *)src;
-	y_odd = y_even + width;
-	u = y_even + width * height;
-	v = u + ((width * height) >> 2);
-
-	for (i = 0; i < height / 2; ++i) {
-		for (j = 0; j < width / 2; ++j) {
-			const int rc = yuv2rgb_r[*v];
-			const int gc = yuv2rgb_g1[*v] + yuv2rgb_g2[*u];
-			const int bc = yuv2rgb_b[*u];
-			const int yc0_even = CLIP_OFFSET + yuv2rgb_y[*y_even++];
-			const int yc1_even = CLIP_OFFSET + yuv2rgb_y[*y_even++];
-			const int yc0_odd = CLIP_OFFSET + yuv2rgb_y[*y_odd++];
-			const int yc1_odd = CLIP_OFFSET + yuv2rgb_y[*y_odd++];
-
-			*dst_even++ = COMPOSE_RGB(yc0_even, bc, gc, rc);
-			*dst_even++ = COMPOSE_RGB(yc1_even, bc, gc, rc);
-			*dst_odd++ = COMPOSE_RGB(yc0_odd, bc, gc, rc);
-			*dst_odd++ = COMPOSE_RGB(yc1_odd, bc, gc, rc);
-
-			++u;
-			++v;
-		}
+/*
+ * Convert RGB32 to i420 planes.  Chroma is sampled from the top left
+ * pixel of each 2x2 block.
+ * Based on formulas found at http://en.wikipedia.org/wiki/YUV  (libvidcap)
+ */
+int
+RGB32toI420Planes(int width, int height,
+	const char *src, int src_stride,
+	char *dst_y, int stride_y,
+	char *dst_u, int stride_u,
+	char *dst_v, int stride_v)
+{
+	rgb32_row_fn row_simd;
+	int i;
 
-		y_even += width;
-		y_odd += width;
-		dst_even += width;
-		dst_odd += width;
+	if (!kernels_initialized)
+		init_kernels();
+	row_simd = rgb32_row_simd;
+
+	for (i = 0; i < height; i += 2) {
+		const unsigned char *src_even =
+			(const unsigned char *)src + i * src_stride;
+		const unsigned char *src_odd =
+			(i + 1 < height) ? src_even + src_stride : 0;
+		unsigned char *y_even = (unsigned char *)dst_y + i * stride_y;
+		unsigned char *y_odd = src_odd ? y_even + stride_y : 0;
+		unsigned char *u = (unsigned char *)dst_u + (i >> 1) * stride_u;
+		unsigned char *v = (unsigned char *)dst_v + (i >> 1) * stride_v;
+		int x = 0;
+
+		if (row_simd)
+			x = row_simd(src_even, src_odd, y_even, y_odd, u, v, width);
+		RGB32toI420Row_C(src_even, src_odd, y_even, y_odd, u, v, x, width);
 	}
 
 	return 0;
@@ -117,70 +717,15 @@ I420toRGB32(int width, int height, const char *src, char *dst)
 
 /*
  * Convert RGB32 to i420. NOTE: size of dest must be >= width * height * 3 / 2
- * Based on formulas found at http://en.wikipedia.org/wiki/YUV  (libvidcap)
  */
 int
 RGB32toI420(int width, int height, const char *src, char *dst)
 {
-    int i, j;
-    unsigned char *dst_y_even;
-    unsigned char *dst_y_odd;
-    unsigned char *dst_u;
-    unsigned char *dst_v;
-    const unsigned char *src_even;
-    const unsigned char *src_odd;
-
-    src_even = (const unsigned char *)src;
-    src_odd = src_even + width * 4;
-
-    dst_y_even = (unsigned char *)dst;
-    dst_y_odd = dst_y_even + width;
-    dst_u = dst_y_even + width * height;
-    dst_v = dst_u + ((width * height) >> 2);
-
-    for (i = 0; i < height / 2; ++i) {
-        for (j = 0; j < width / 2; ++j) {
-            short r, g, b;
-            r = *src_even++;
-            g = *src_even++;
-            b = *src_even++;
-
-            ++src_even;
-            *dst_y_even++ = (unsigned char)
-                ((( r * 66 + g * 129 + b * 25 + 128 ) >> 8 ) + 16);
-            *dst_u++ = (unsigned char)
-                ((( r * -38 - g * 74 + b * 112 + 128 ) >> 8 ) + 128);
-            *dst_v++ = (unsigned char)
-                ((( r * 112 - g * 94 - b * 18 + 128 ) >> 8 ) + 128);
-
-            r = *src_even++;
-            g = *src_even++;
-            b = *src_even++;
-            ++src_even;
-            *dst_y_even++ = (unsigned char)
-                ((( r * 66 + g * 129 + b * 25 + 128 ) >> 8 ) + 16);
-
-            r = *src_odd++;
-            g = *src_odd++;
-            b = *src_odd++;
-            ++src_odd;
-            *dst_y_odd++ = (unsigned char)
-                ((( r * 66 + g * 129 + b * 25 + 128 ) >> 8 ) + 16);
-
-            r = *src_odd++;
-            g = *src_odd++;
-            b = *src_odd++;
-            ++src_odd;
-            *dst_y_odd++ = (unsigned char)
-                ((( r * 66 + g * 129 + b * 25 + 128 ) >> 8 ) + 16);
-        }
-
-        dst_y_odd += width;
-        dst_y_even += width;
-        src_odd += width * 4;
-        src_even += width * 4;
-    }
-
-    return 0;
-}
+	const int chroma_width = (width + 1) >> 1;
+	const int chroma_height = (height + 1) >> 1;
+	char *u = dst + width * height;
+	char *v = u + chroma_width * chroma_height;
 
+	return RGB32toI420Planes(width, height, src, width * 4, dst, width,
+		u, chroma_width, v, chroma_width);
+}
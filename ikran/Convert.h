@@ -2,3 +2,31 @@
 int RGB32toI420(int width, int height, const char *src, char *dst);
 int I420toRGB32(int width, int height, const char *src, char *dst);
 
+/*
+ * Plane/stride variants of the above.  Odd widths and heights are
+ * allowed; chroma planes then hold (width + 1) / 2 by (height + 1) / 2
+ * samples.  Strides are in bytes.
+ */
+int I420toRGB32Planes(int width, int height,
+		const char *src_y, int stride_y,
+		const char *src_u, int stride_u,
+		const char *src_v, int stride_v,
+		char *dst, int dst_stride);
+int RGB32toI420Planes(int width, int height,
+		const char *src, int src_stride,
+		char *dst_y, int stride_y,
+		char *dst_u, int stride_u,
+		char *dst_v, int stride_v);
+
+/*
+ * Kernel sets, slowest first.  ConvertSetKernels() uses the fastest set
+ * up to the one asked for that the build and the CPU support, and returns
+ * the set it picked.  CONVERT_KERNELS_BEST is the default.
+ */
+enum {
+	CONVERT_KERNELS_C = 0,
+	CONVERT_KERNELS_SSE2,
+	CONVERT_KERNELS_AVX2,
+	CONVERT_KERNELS_BEST = CONVERT_KERNELS_AVX2
+};
+int ConvertSetKernels(int kernels);
@@ -38,16 +38,165 @@
 #include "Logger.h"
 #define MICROSECONDS 1000000
 
+/* Paints whatever frame is in the mailbox when the main thread gets to it. */
+class CanvasPaintRunnable : public nsRunnable {
+public:
+    CanvasPaintRunnable(CanvasFrameMailbox *pMailbox) : m_pMailbox(pMailbox) {}
+
+    NS_IMETHOD Run() {
+        m_pMailbox->Paint();
+        return NS_OK;
+    }
+
+private:
+    nsRefPtr<CanvasFrameMailbox> m_pMailbox;
+};
+
+CanvasFrameMailbox::CanvasFrameMailbox(nsIDOMCanvasRenderingContext2D *ctx) :
+    lock(PR_NewLock()), canvas(ctx), freeCount(0), allocated(0), bufferSize(0),
+    pending(NULL), pendingWidth(0), pendingHeight(0), pendingSize(0),
+    paintScheduled(false), posted(0), painted(0), dropped(0)
+{
+}
+
+CanvasFrameMailbox::~CanvasFrameMailbox()
+{
+    for (int i = 0; i < freeCount; i++) {
+        delete [] freeBuffers[i];
+    }
+    delete [] pending;
+    PR_DestroyLock(lock);
+}
+
+PRUint8 *
+CanvasFrameMailbox::AcquireBuffer(PRUint32 size)
+{
+    PRUint8 *buf = NULL;
+
+    PR_Lock(lock);
+    if (size != bufferSize) {
+        /* Frame size changed; in-flight buffers are freed as they come back. */
+        for (int i = 0; i < freeCount; i++) {
+            delete [] freeBuffers[i];
+        }
+        allocated -= freeCount;
+        freeCount = 0;
+        bufferSize = size;
+    }
+    if (freeCount > 0) {
+        buf = freeBuffers[--freeCount];
+    } else if (allocated < POOL_SIZE) {
+        buf = new PRUint8[size];
+        allocated++;
+    } else {
+        dropped++;
+    }
+    PR_Unlock(lock);
+
+    return buf;
+}
+
+void
+CanvasFrameMailbox::ReturnBufferLocked(PRUint8 *buf, PRUint32 size)
+{
+    if (size == bufferSize && freeCount < POOL_SIZE) {
+        freeBuffers[freeCount++] = buf;
+    } else {
+        delete [] buf;
+        allocated--;
+    }
+}
+
+void
+CanvasFrameMailbox::PostFrame(PRUint8 *buf, PRUint32 width, PRUint32 height, PRUint32 size)
+{
+    bool dispatch = false;
+
+    PR_Lock(lock);
+    if (pending) {
+        /* The main thread has not caught up; only the newest frame matters. */
+        ReturnBufferLocked(pending, pendingSize);
+        dropped++;
+    }
+    pending = buf;
+    pendingWidth = width;
+    pendingHeight = height;
+    pendingSize = size;
+    posted++;
+    if (canvas && !paintScheduled) {
+        paintScheduled = true;
+        dispatch = true;
+    }
+    PR_Unlock(lock);
+
+    if (dispatch) {
+        nsCOMPtr<nsIRunnable> paint = new CanvasPaintRunnable(this);
+        NS_DispatchToMainThread(paint);
+    }
+}
+
+void
+CanvasFrameMailbox::Paint()
+{
+    nsIDOMCanvasRenderingContext2D *ctx;
+    PRUint8 *buf;
+    PRUint32 w, h, size;
+
+    PR_Lock(lock);
+    /* Clear first so frames posted while painting schedule another run. */
+    paintScheduled = false;
+    ctx = canvas;
+    buf = pending;
+    w = pendingWidth;
+    h = pendingHeight;
+    size = pendingSize;
+    pending = NULL;
+    PR_Unlock(lock);
+
+    if (!buf) {
+        return;
+    }
+    if (ctx) {
+        ctx->PutImageData_explicit(0, 0, w, h, buf, size, PR_TRUE, 0, 0, w, h);
+    }
+
+    PR_Lock(lock);
+    if (ctx) {
+        painted++;
+    }
+    ReturnBufferLocked(buf, size);
+    PR_Unlock(lock);
+}
+
+void
+CanvasFrameMailbox::Detach()
+{
+    PR_Lock(lock);
+    canvas = NULL;
+    if (pending) {
+        ReturnBufferLocked(pending, pendingSize);
+        pending = NULL;
+        dropped++;
+    }
+    PR_Unlock(lock);
+}
+
 VideoRenderer::VideoRenderer(int w, int h,nsIDOMCanvasRenderingContext2D *ctx) :width(w),
 										    height(h),
-											vCanvas(ctx)
+											vCanvas(ctx),
+											mailbox(new CanvasFrameMailbox(ctx))
 {
 	Logger::Instance()->logIt(" VideoRenderer Created for Canvas");
 }
 
 VideoRenderer::~VideoRenderer()
 {
-	Logger::Instance()->logIt(" VideoRenderer Destroyed" );
+	char stats[128];
+
+	mailbox->Detach();
+	snprintf(stats, sizeof(stats), " VideoRenderer Destroyed: frames posted %u painted %u dropped %u",
+		mailbox->FramesPosted(), mailbox->FramesPainted(), mailbox->FramesDropped());
+	Logger::Instance()->logIt(stats);
 }
 
 int
@@ -68,17 +217,17 @@ VideoRenderer::DeliverFrame(unsigned char* buffer, int buffer_size, uint32_t tim
 
     int fsize = width * height * 4;
     if (vCanvas) {
-        /* Convert i420 to RGB32 to write on canvas */
-        nsAutoArrayPtr<PRUint8> rgb32(new PRUint8[fsize]);
+        /* Convert i420 to RGB32 straight into a pooled buffer for the canvas */
+        PRUint8 *rgb32 = mailbox->AcquireBuffer(fsize);
+        if (!rgb32) {
+            /* Every buffer is in flight; the drop is counted by the mailbox */
+            return 0;
+        }
         I420toRGB32(width, height,
-            (const char *)buffer, (char *)rgb32.get()
-        );
-
-        nsCOMPtr<nsIRunnable> render = new CanvasRenderer(
-            vCanvas, width, height, rgb32, fsize
+            (const char *)buffer, (char *)rgb32
         );
 
-        NS_DispatchToMainThread(render);
+        mailbox->PostFrame(rgb32, width, height, fsize);
     }
 
     return 0;
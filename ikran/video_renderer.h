@@ -38,12 +38,62 @@
 #include <stdio.h>
 #include "VideoSource.h"
 #include <prmem.h>
+#include <prlock.h>
+#include <nsAutoPtr.h>
+#include <nsISupportsImpl.h>
 #include "vie_base.h"
 #include "vie_codec.h"
 #include "vie_render.h"
 #include "vie_capture.h"
 #include "common_types.h"
 
+/* Hands converted frames from the engine's render thread to the main thread.
+ * Frames come from a fixed pool of POOL_SIZE buffers (one being filled, one
+ * pending, one being painted) and at most one frame waits for the canvas:
+ * a newer frame replaces a pending one that was not painted yet, so a busy
+ * main thread never builds a backlog.
+ */
+class CanvasFrameMailbox {
+public:
+    enum { POOL_SIZE = 3 };
+
+    CanvasFrameMailbox(nsIDOMCanvasRenderingContext2D *ctx);
+    ~CanvasFrameMailbox();
+
+    NS_INLINE_DECL_THREADSAFE_REFCOUNTING(CanvasFrameMailbox)
+
+    /* Render thread: get a buffer of size bytes, NULL if all are in flight. */
+    PRUint8 *AcquireBuffer(PRUint32 size);
+    /* Render thread: publish a filled buffer, replacing any unpainted frame. */
+    void PostFrame(PRUint8 *buf, PRUint32 width, PRUint32 height, PRUint32 size);
+    /* Main thread: paint the pending frame, if any. */
+    void Paint();
+    /* Stop painting; pending and later frames are dropped. */
+    void Detach();
+
+    PRUint32 FramesPosted() const { return posted; }
+    PRUint32 FramesPainted() const { return painted; }
+    PRUint32 FramesDropped() const { return dropped; }
+
+private:
+    void ReturnBufferLocked(PRUint8 *buf, PRUint32 size);
+
+    PRLock *lock;
+    nsIDOMCanvasRenderingContext2D *canvas;
+    PRUint8 *freeBuffers[POOL_SIZE];
+    int freeCount;
+    int allocated;
+    PRUint32 bufferSize;
+    PRUint8 *pending;
+    PRUint32 pendingWidth;
+    PRUint32 pendingHeight;
+    PRUint32 pendingSize;
+    bool paintScheduled;
+    PRUint32 posted;
+    PRUint32 painted;
+    PRUint32 dropped;
+};
+
 class VideoRenderer: public webrtc::ExternalRenderer {
 public:
     VideoRenderer(int w, int h,nsIDOMCanvasRenderingContext2D *ctx);
@@ -57,6 +107,7 @@ protected:
 	int width;
 	int height;	
     nsIDOMCanvasRenderingContext2D *vCanvas;
+    nsRefPtr<CanvasFrameMailbox> mailbox;
 };
 
 /* can remove after I rule out rendering using nsIDOMCanvasRenderingContext2D in firefox */
@@ -41,7 +41,9 @@
 
 #include "CC_Common.h"
 #include "CC_Observer.h"
+#include "ECC_Types.h"
 
+#include <string>
 #include <vector>
 
 extern "C"
@@ -115,6 +117,16 @@ namespace CSF
         virtual bool setROAPProxyMode(bool mode) = 0;
         virtual bool setROAPClientMode(bool mode) = 0;
 
+        /**
+         * Call admission control. Calls are refused with CC_CAUSE_CONGESTION once their worst case
+         * media bandwidth would take the reservations on the active local address over its budget.
+         * A budget for "" applies to addresses without one of their own; 0 kbps removes a budget
+         * and with none in force every call is admitted. A measured capacity only ever lowers the budget.
+         */
+        virtual bool setBandwidthBudget(const std::string& localAddress, int kbps) = 0;
+        virtual bool setMeasuredBandwidth(const std::string& localAddress, int kbps) = 0;
+        virtual bool getBandwidthUtilization(MediaBandwidthUtilization& utilization) = 0;
+
     private:
         CC_Service(const CC_Service& rhs);
         CC_Service& operator=(const CC_Service& rhs);
@@ -40,6 +40,7 @@
 #pragma once
 
 #include "CC_Common.h"
+#include "ECC_Types.h"
 
 namespace CSF
 {
@@ -64,6 +65,12 @@ namespace CSF
         virtual bool setRingerVolume( int ) = 0;
         virtual int getRingerVolume() = 0;
 
+        // RTP statistics; sampling is shared by audio and video and is off while the interval is 0
+        virtual void setStatsSampleInterval( int ms ) = 0;
+        virtual bool getStreamStats( int streamId, MediaStreamStats & stats ) = 0;
+        virtual std::vector<MediaStreamStats> getStreamStatsHistory( int streamId ) = 0;
+        virtual bool getStreamSummary( int streamId, MediaStreamSummary & summary ) = 0;
+
         virtual ~AudioControl(){};
 	};
 };
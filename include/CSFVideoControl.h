@@ -62,6 +62,12 @@ namespace CSF
 
 		virtual std::string getCaptureDevice() = 0;
 		virtual bool setCaptureDevice( const std::string& name ) = 0;
+
+		// RTP statistics; sampling is shared by audio and video and is off while the interval is 0
+		virtual void setStatsSampleInterval( int ms ) = 0;
+		virtual bool getStreamStats( int streamId, MediaStreamStats & stats ) = 0;
+		virtual std::vector<MediaStreamStats> getStreamStatsHistory( int streamId ) = 0;
+		virtual bool getStreamSummary( int streamId, MediaStreamSummary & summary ) = 0;
 	};
 
 }; // namespace
@@ -183,4 +183,54 @@ namespace CSF
     typedef void *VideoWindowHandle;
 	typedef void* ExternalRendererHandle;
 	typedef unsigned int VideoFormat;	
+
+	typedef struct				// one sample of a media stream's RTP/RTCP statistics
+	{
+		int streamId;
+		int timeMs;					// since the stream was first sampled
+		unsigned int packetsReceived;	// counters are cumulative
+		unsigned int bytesReceived;
+		unsigned int packetsLost;
+		unsigned int packetsSent;
+		unsigned int bytesSent;
+		int fractionLost;			// in 1/256ths, from the last RTCP report
+		int jitterMs;
+		int rttMs;
+		int rxKbps;					// over the last sample interval
+		int txKbps;
+
+	} MediaStreamStats;
+
+	typedef struct				// whole-stream aggregate of the samples taken
+	{
+		int streamId;
+		int durationMs;
+		int samples;
+		unsigned int packetsReceived;
+		unsigned int bytesReceived;
+		unsigned int packetsLost;
+		unsigned int packetsSent;
+		unsigned int bytesSent;
+		int maxFractionLost;
+		int avgJitterMs;
+		int maxJitterMs;
+		int avgRttMs;
+		int maxRttMs;
+		int avgRxKbps;
+		int minRxKbps;				// lowest interval rate seen, the first sign of a degrading call
+		int avgTxKbps;
+
+	} MediaStreamSummary;
+
+	typedef struct				// call admission control on the active local address
+	{
+		int budgetKbps;				// 0 when no budget applies, admission is then off
+		int reservedKbps;
+		int peakReservedKbps;
+		int reservations;			// calls holding bandwidth
+		int sessionCostKbps;		// what one more session would reserve
+		unsigned int admitted;		// requests since start
+		unsigned int rejected;
+
+	} MediaBandwidthUtilization;
 };
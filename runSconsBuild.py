@@ -134,6 +134,9 @@ for arg in sys.argv:
   if (arg == 'x64'):
     buildArgs += ['x64=yes']
 
+  if (arg == 'nullmedia'):
+    buildArgs += ['nullmedia=yes']
+
   if (arg == 'noaddon'):
     buildArgs += ['noaddon=yes']
     gen_addon = 'no'
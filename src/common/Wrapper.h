@@ -63,15 +63,21 @@
  *                to remain.  This is the case for the "fake" CC_DPCall generated on CC_DPLine::CreateCall(), where
  *                the correct IDPCall* is provided later.
  * reset() is a cleanup step to wipe the handle map and allow memory to be reclaimed.
+ * release() drops the map's own reference for a handle.  The object itself lives on while clients hold a FooPtr,
+ *           and its destructor releases the underlying handle when the last of those goes.  Owners should call
+ *           it once the handle is no longer current - for snapshot handles (call info, line info, ...) as soon as
+ *           the event carrying them has been delivered, for calls when the call ends - so that the map only holds
+ *           live handles and memory stays flat over long running processes.
+ * find() returns the existing FooPtr for a handle, or NULL if there is none, without creating one.
  *
- * Future enhancements:
- * - For now, objects remain in the map forever.  Better would be to add a releaseHandle() function which would
- *   allow the map to be emptied as underlying handles expired.  While we can't force the client to give up its
- *   shared_ptr<Foo> objects, we can remove our own copy, for instance on a call ended event.
+ * The map is split into shards, each with its own lock, so that lookups on different handles (e.g. the CCApp thread
+ * delivering events while the media thread registers streams) rarely contend.  getLiveCount() reports how many Foo
+ * objects exist, whether mapped or only held by clients, and getMappedCount() how many the map holds.
  */
 
 #include <map>
 #include "SharedPtr.h"
+#include "base/atomicops.h"
 #include "base/synchronization/lock.h"
 
 template <class T>
@@ -79,74 +85,197 @@ class Wrapper
 {
 private:
     typedef std::map<typename T::Handle, typename T::Ptr>      	HandleMapType;
-	HandleMapType 	handleMap;
-	base::Lock 		handleMapMutex;
+
+	enum { NumShards = 16 };
+
+	struct Shard
+	{
+		HandleMapType 	handleMap;
+		base::Lock 		handleMapMutex;
+	};
+
+	Shard 					shards[NumShards];
+	base::subtle::Atomic32 	liveCount;
+	base::subtle::Atomic32 	mappedCount;
+
+	// FNV-1a over the bytes of the handle; handles are pointers, ints or other plain values.
+	static Shard & shardFor(Wrapper & w, const typename T::Handle & handle)
+	{
+		const unsigned char * p = reinterpret_cast<const unsigned char *>(&handle);
+		unsigned int h = 2166136261u;
+		for (size_t i = 0; i < sizeof(handle); i++)
+		{
+			h = (h ^ p[i]) * 16777619u;
+		}
+		return w.shards[h % NumShards];
+	}
+
+	// Holds the locks of two shards.  They are always taken in array order so that two threads moving handles
+	// in opposite directions cannot deadlock, and only once when both are the same shard.
+	class ShardPairLock
+	{
+	public:
+		ShardPairLock(Shard & a, Shard & b)
+			: first(&a < &b ? a : b), second(&a < &b ? b : a)
+		{
+			first.handleMapMutex.Acquire();
+			if (&second != &first)
+			{
+				second.handleMapMutex.Acquire();
+			}
+		}
+		~ShardPairLock()
+		{
+			if (&second != &first)
+			{
+				second.handleMapMutex.Release();
+			}
+			first.handleMapMutex.Release();
+		}
+	private:
+		Shard & first;
+		Shard & second;
+		ShardPairLock(const ShardPairLock &);
+		ShardPairLock & operator=(const ShardPairLock &);
+	};
 
 public:
+	/*
+	 * Counts the live objects of T.  CSF_DECLARE_WRAP makes one of these a member of T.
+	 */
+	class Instance
+	{
+	public:
+		Instance() { base::subtle::NoBarrier_AtomicIncrement(&T::wrapper.liveCount, 1); }
+		Instance(const Instance &) { base::subtle::NoBarrier_AtomicIncrement(&T::wrapper.liveCount, 1); }
+		~Instance() { base::subtle::NoBarrier_AtomicIncrement(&T::wrapper.liveCount, -1); }
+	private:
+		Instance & operator=(const Instance &);
+	};
+
+	Wrapper() : liveCount(0), mappedCount(0) {}
+
 	typename T::Ptr wrap(typename T::Handle handle)
 	{
-		base::AutoLock lock(handleMapMutex);
-		typename HandleMapType::iterator it = handleMap.find(handle);
-		if(it != handleMap.end())
+		Shard & shard = shardFor(*this, handle);
+		base::AutoLock lock(shard.handleMapMutex);
+		typename HandleMapType::iterator it = shard.handleMap.find(handle);
+		if(it != shard.handleMap.end())
 		{
 			return it->second;
 		}
 		else
 		{
 			typename T::Ptr p(new T(handle));
-			handleMap[handle] = p;
+			shard.handleMap[handle] = p;
+			base::subtle::NoBarrier_AtomicIncrement(&mappedCount, 1);
 			return p;
 		}
 	}
 
-	bool changeHandle(typename T::Handle oldHandle, typename T::Handle newHandle)
+	typename T::Ptr find(typename T::Handle handle)
 	{
-		base::AutoLock lock(handleMapMutex);
-		typename HandleMapType::iterator it = handleMap.find(oldHandle);
-		if(it != handleMap.end())
+		Shard & shard = shardFor(*this, handle);
+		base::AutoLock lock(shard.handleMapMutex);
+		typename HandleMapType::iterator it = shard.handleMap.find(handle);
+		if(it != shard.handleMap.end())
 		{
-			typename T::Ptr p = it->second;
-			handleMap.erase(it);
-			handleMap[newHandle] = p;
-			return true;
+			return it->second;
 		}
-		else
+		return typename T::Ptr();
+	}
+
+	bool changeHandle(typename T::Handle oldHandle, typename T::Handle newHandle)
+	{
+		// An object already mapped to newHandle is dropped outside the locks, its destructor calls back into sipcc.
+		typename T::Ptr replaced;
 		{
-			return false;
+			// Both shards are held so no lookup sees the object unmapped halfway through the move.
+			Shard & oldShard = shardFor(*this, oldHandle);
+			Shard & newShard = shardFor(*this, newHandle);
+			ShardPairLock lock(oldShard, newShard);
+			typename HandleMapType::iterator it = oldShard.handleMap.find(oldHandle);
+			if(it == oldShard.handleMap.end())
+			{
+				return false;
+			}
+			typename T::Ptr p = it->second;
+			oldShard.handleMap.erase(it);
+
+			it = newShard.handleMap.find(newHandle);
+			if (it != newShard.handleMap.end())
+			{
+				// the old object is replaced, it is no longer mapped
+				replaced = it->second;
+				it->second = p;
+				base::subtle::NoBarrier_AtomicIncrement(&mappedCount, -1);
+			}
+			else
+			{
+				newShard.handleMap[newHandle] = p;
+			}
 		}
+		return true;
 	}
 
 	bool release(typename T::Handle handle)
 	{
-		base::AutoLock lock(handleMapMutex);
-		typename HandleMapType::iterator it = handleMap.find(handle);
-		if(it != handleMap.end())
+		// Drop the object outside the lock, its destructor calls back into sipcc.
+		typename T::Ptr p;
 		{
-			handleMap.erase(it);
-			return true;
+			Shard & shard = shardFor(*this, handle);
+			base::AutoLock lock(shard.handleMapMutex);
+			typename HandleMapType::iterator it = shard.handleMap.find(handle);
+			if(it == shard.handleMap.end())
+			{
+				return false;
+			}
+			p = it->second;
+			shard.handleMap.erase(it);
+			base::subtle::NoBarrier_AtomicIncrement(&mappedCount, -1);
 		}
-		else
+		return true;
+	}
+
+	void reset()
+	{
+		for (int i = 0; i < NumShards; i++)
 		{
-			return false;
+			HandleMapType dropped;
+			{
+				base::AutoLock lock(shards[i].handleMapMutex);
+				base::subtle::NoBarrier_AtomicIncrement(&mappedCount,
+						-static_cast<base::subtle::Atomic32>(shards[i].handleMap.size()));
+				dropped.swap(shards[i].handleMap);
+			}
 		}
 	}
 
-	void reset()
+	int getLiveCount() const
 	{
-		base::AutoLock lock(handleMapMutex);
-		handleMap.clear();
+		return base::subtle::NoBarrier_Load(&liveCount);
+	}
+
+	int getMappedCount() const
+	{
+		return base::subtle::NoBarrier_Load(&mappedCount);
 	}
 };
 
 #define CSF_DECLARE_WRAP(classname, handletype) \
 	public: \
 		static classname ## Ptr wrap(handletype handle); \
+		static classname ## Ptr find(handletype handle); \
+		static bool release(handletype handle); \
 		static void reset(); \
+		static int getLiveCount(); \
+		static int getMappedCount(); \
 	private: \
 		friend class Wrapper<classname>; \
 		typedef classname ## Ptr Ptr; \
 		typedef handletype Handle; \
-		static Wrapper<classname> wrapper;
+		static Wrapper<classname> wrapper; \
+		Wrapper<classname>::Instance wrapperInstance;
 
 #define CSF_IMPLEMENT_WRAP(classname, handletype) \
 	Wrapper<classname> classname::wrapper; \
@@ -154,8 +283,23 @@ public:
 	{ \
 		return wrapper.wrap(handle); \
 	} \
+	classname ## Ptr classname::find(handletype handle) \
+	{ \
+		return wrapper.find(handle); \
+	} \
+	bool classname::release(handletype handle) \
+	{ \
+		return wrapper.release(handle); \
+	} \
 	void classname::reset() \
 	{ \
 		wrapper.reset(); \
+	} \
+	int classname::getLiveCount() \
+	{ \
+		return wrapper.getLiveCount(); \
+	} \
+	int classname::getMappedCount() \
+	{ \
+		return wrapper.getMappedCount(); \
 	}
-
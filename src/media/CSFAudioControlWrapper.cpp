@@ -176,6 +176,58 @@ namespace CSF {
 		}
     }
 
+	void AudioControlWrapper::setStatsSampleInterval( int ms )
+	{
+		if (_realAudioControl != NULL)
+		{
+			_realAudioControl->setStatsSampleInterval(ms);
+		}
+		else
+		{
+			CSFLogWarn( logTag, "Attempt to setStatsSampleInterval for expired audio control");
+		}
+	}
+
+	bool AudioControlWrapper::getStreamStats( int streamId, MediaStreamStats & stats )
+	{
+		if (_realAudioControl != NULL)
+		{
+			return _realAudioControl->getStreamStats(streamId, stats);
+		}
+		else
+		{
+			CSFLogWarn( logTag, "Attempt to getStreamStats for expired audio control");
+			return false;
+		}
+	}
+
+	std::vector<MediaStreamStats> AudioControlWrapper::getStreamStatsHistory( int streamId )
+	{
+		if (_realAudioControl != NULL)
+		{
+			return _realAudioControl->getStreamStatsHistory(streamId);
+		}
+		else
+		{
+			CSFLogWarn( logTag, "Attempt to getStreamStatsHistory for expired audio control");
+			std::vector<MediaStreamStats> vec;
+			return vec;
+		}
+	}
+
+	bool AudioControlWrapper::getStreamSummary( int streamId, MediaStreamSummary & summary )
+	{
+		if (_realAudioControl != NULL)
+		{
+			return _realAudioControl->getStreamSummary(streamId, summary);
+		}
+		else
+		{
+			CSFLogWarn( logTag, "Attempt to getStreamSummary for expired audio control");
+			return false;
+		}
+	}
+
     AudioControlWrapper::~AudioControlWrapper()
     {
         delete _realAudioControl;        
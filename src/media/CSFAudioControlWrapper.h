@@ -66,6 +66,11 @@ namespace CSF
         virtual bool setRingerVolume( int volume );
         virtual int getRingerVolume();
 
+		virtual void setStatsSampleInterval( int ms );
+		virtual bool getStreamStats( int streamId, MediaStreamStats & stats );
+		virtual std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+		virtual bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
 		virtual void setAudioControl(AudioControl * audioControl){_realAudioControl = audioControl;};
 
         virtual ~AudioControlWrapper();
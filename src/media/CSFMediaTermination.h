@@ -82,6 +82,8 @@ namespace CSF
         virtual void setLocalIP    ( const char* addr ) = 0;
         virtual void setMediaPorts ( int startPort, int endPort ) = 0;
         virtual void setDSCPValue ( int value ) = 0;
+        // marks the streams of one call, overriding setDSCPValue for them
+        virtual void setGroupDSCPValue ( int groupId, int value ) = 0;
     };
 } // namespace
 
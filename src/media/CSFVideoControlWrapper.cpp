@@ -123,4 +123,56 @@ bool VideoControlWrapper::setCaptureDevice( const std::string& name )
 	}
 }
 
+void VideoControlWrapper::setStatsSampleInterval( int ms )
+{
+	if (_realVideoControl != NULL)
+	{
+		_realVideoControl->setStatsSampleInterval(ms);
+	}
+	else
+	{
+		CSFLogWarn( logTag, "Attempt to setStatsSampleInterval for expired video control");
+	}
+}
+
+bool VideoControlWrapper::getStreamStats( int streamId, MediaStreamStats & stats )
+{
+	if (_realVideoControl != NULL)
+	{
+		return _realVideoControl->getStreamStats(streamId, stats);
+	}
+	else
+	{
+		CSFLogWarn( logTag, "Attempt to getStreamStats for expired video control");
+		return false;
+	}
+}
+
+std::vector<MediaStreamStats> VideoControlWrapper::getStreamStatsHistory( int streamId )
+{
+	if (_realVideoControl != NULL)
+	{
+		return _realVideoControl->getStreamStatsHistory(streamId);
+	}
+	else
+	{
+		CSFLogWarn( logTag, "Attempt to getStreamStatsHistory for expired video control");
+		std::vector<MediaStreamStats> vec;
+		return vec;
+	}
+}
+
+bool VideoControlWrapper::getStreamSummary( int streamId, MediaStreamSummary & summary )
+{
+	if (_realVideoControl != NULL)
+	{
+		return _realVideoControl->getStreamSummary(streamId, summary);
+	}
+	else
+	{
+		CSFLogWarn( logTag, "Attempt to getStreamSummary for expired video control");
+		return false;
+	}
+}
+
 }
@@ -70,6 +70,11 @@ namespace CSF
 		virtual std::string getCaptureDevice();
 		virtual bool setCaptureDevice( const std::string& name );
 
+		virtual void setStatsSampleInterval( int ms );
+		virtual bool getStreamStats( int streamId, MediaStreamStats & stats );
+		virtual std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+		virtual bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
 		virtual void setVideoControl( VideoControl * videoControl ){_realVideoControl = videoControl;};
 
 	private:
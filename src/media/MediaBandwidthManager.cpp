@@ -0,0 +1,211 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "MediaBandwidthManager.h"
+#include "CSFLogStream.h"
+
+static const char* logTag = "MediaBandwidthManager";
+
+namespace CSF {
+
+	MediaBandwidthManager * MediaBandwidthManager::getInstance()
+	{
+		static MediaBandwidthManager instance;
+		return &instance;
+	}
+
+	int MediaBandwidthManager::addPacketOverhead( int payloadKbps, int packetsPerSecond )
+	{
+		return payloadKbps + (packetsPerSecond * PACKET_OVERHEAD_BYTES * 8 + 999) / 1000;
+	}
+
+	MediaBandwidthManager::MediaBandwidthManager() :
+		reservedKbps(0),
+		peakReservedKbps(0),
+		admitted(0),
+		rejected(0)
+	{
+	}
+
+	void MediaBandwidthManager::setSource( MediaStreamRegistry::MediaType type, MediaBandwidthSource * source )
+	{
+		base::AutoLock l(lock);
+		if ( source == NULL )
+		{
+			sources.erase(type);
+		}
+		else
+		{
+			sources[type] = source;
+		}
+	}
+
+	void MediaBandwidthManager::setBudget( const std::string & localAddress, int kbps )
+	{
+		base::AutoLock l(lock);
+		if ( kbps > 0 )
+		{
+			budgets[localAddress] = kbps;
+		}
+		else
+		{
+			budgets.erase(localAddress);
+		}
+		CSFLogInfoS( logTag, "budget for '" << localAddress << "' " << kbps << " kbps, now " << getBudgetKbps() <<
+			" kbps on '" << activeAddress << "' with " << reservedKbps << " kbps reserved" );
+	}
+
+	void MediaBandwidthManager::setMeasuredCapacity( const std::string & localAddress, int kbps )
+	{
+		base::AutoLock l(lock);
+		if ( kbps > 0 )
+		{
+			measured[localAddress] = kbps;
+		}
+		else
+		{
+			measured.erase(localAddress);
+		}
+	}
+
+	void MediaBandwidthManager::setActiveAddress( const std::string & localAddress )
+	{
+		base::AutoLock l(lock);
+		activeAddress = localAddress;
+	}
+
+	bool MediaBandwidthManager::isEnabled()
+	{
+		base::AutoLock l(lock);
+		return getBudgetKbps() > 0;
+	}
+
+	int MediaBandwidthManager::getBudgetKbps()
+	{
+		std::map<std::string, int>::const_iterator it = budgets.find(activeAddress);
+		if ( it == budgets.end() )
+		{
+			it = budgets.find("");
+		}
+		int budget = (it != budgets.end()) ? it->second : 0;
+
+		it = measured.find(activeAddress);
+		if ( it == measured.end() )
+		{
+			it = measured.find("");
+		}
+		// a measurement only ever lowers the budget, it does not turn admission on by itself
+		if ( budget > 0 && it != measured.end() && it->second < budget )
+		{
+			budget = it->second;
+		}
+		return budget;
+	}
+
+	int MediaBandwidthManager::getSessionCostKbps()
+	{
+		int cost = 0;
+		for ( std::map<MediaStreamRegistry::MediaType, MediaBandwidthSource *>::const_iterator it = sources.begin(); it != sources.end(); it++ )
+		{
+			cost += it->second->getSessionCostKbps();
+		}
+		return cost;
+	}
+
+	bool MediaBandwidthManager::reserve( int callId, int sessions )
+	{
+		base::AutoLock l(lock);
+		int kbps = getSessionCostKbps() * (sessions > 0 ? sessions : 1);
+		int budget = getBudgetKbps();
+
+		// a call asking again (offhook, then digits, then setup) only needs the difference
+		std::map<int, int>::iterator it = reservations.find(callId);
+		int held = (it != reservations.end()) ? it->second : 0;
+
+		if ( budget > 0 && reservedKbps - held + kbps > budget )
+		{
+			rejected++;
+			CSFLogInfoS( logTag, "call " << callId << " refused: " << kbps << " kbps for " << sessions << " session(s), " <<
+				reservedKbps << " of " << budget << " kbps reserved" );
+			return false;
+		}
+
+		reservations[callId] = kbps;
+		reservedKbps += kbps - held;
+		if ( reservedKbps > peakReservedKbps )
+		{
+			peakReservedKbps = reservedKbps;
+		}
+		admitted++;
+		CSFLogDebugS( logTag, "call " << callId << " reserved " << kbps << " kbps, " << reservedKbps << " of " << budget << " kbps reserved" );
+		return true;
+	}
+
+	void MediaBandwidthManager::release( int callId )
+	{
+		base::AutoLock l(lock);
+		std::map<int, int>::iterator it = reservations.find(callId);
+		if ( it == reservations.end() )
+		{
+			return;
+		}
+		reservedKbps -= it->second;
+		reservations.erase(it);
+		CSFLogDebugS( logTag, "call " << callId << " released, " << reservedKbps << " kbps reserved" );
+	}
+
+	int MediaBandwidthManager::getReservedKbps( int callId )
+	{
+		base::AutoLock l(lock);
+		std::map<int, int>::const_iterator it = reservations.find(callId);
+		return (it != reservations.end()) ? it->second : 0;
+	}
+
+	void MediaBandwidthManager::getUtilization( MediaBandwidthUtilization & utilization )
+	{
+		base::AutoLock l(lock);
+		utilization.budgetKbps = getBudgetKbps();
+		utilization.reservedKbps = reservedKbps;
+		utilization.peakReservedKbps = peakReservedKbps;
+		utilization.reservations = (int) reservations.size();
+		utilization.sessionCostKbps = getSessionCostKbps();
+		utilization.admitted = admitted;
+		utilization.rejected = rejected;
+	}
+}
@@ -0,0 +1,115 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include "ECC_Types.h"
+#include "MediaStreamRegistry.h"
+#include "base/synchronization/lock.h"
+
+namespace CSF
+{
+	// Implemented by the media providers: what one session of their media type costs on the wire.
+	class MediaBandwidthSource
+	{
+	public:
+		// Worst case over the codecs the provider offers, including IP/UDP/RTP headers. 0 if it sends nothing.
+		virtual int getSessionCostKbps() = 0;
+		virtual ~MediaBandwidthSource() {}
+	};
+
+	/*
+	 * Call admission control behind vcmAllocateBandwidth and vcmRemoveBandwidth.
+	 *
+	 * Each local address can have a configured budget, which a measured capacity can
+	 * lower; a budget for "" covers addresses without one of their own. A call reserves
+	 * the worst case cost of its sessions, summed over the audio and video providers,
+	 * before GSM sees it, and gives it back when it ends.
+	 * A call that does not fit is refused, so fsmcac fails it with CC_CAUSE_CONGESTION
+	 * rather than letting it degrade every call on the link.
+	 *
+	 * With no budget for the active address every request is admitted, but still
+	 * reserved so the metrics stay right if a budget is set mid-call.
+	 */
+	class MediaBandwidthManager
+	{
+	public:
+		enum { PACKET_OVERHEAD_BYTES = 40 };	// IPv4, UDP and RTP headers
+
+		static MediaBandwidthManager * getInstance();
+		static int addPacketOverhead( int payloadKbps, int packetsPerSecond );
+
+		MediaBandwidthManager();
+
+		// NULL removes the provider.
+		void setSource( MediaStreamRegistry::MediaType type, MediaBandwidthSource * source );
+
+		// kbps of 0 removes the budget or measurement.
+		void setBudget( const std::string & localAddress, int kbps );
+		void setMeasuredCapacity( const std::string & localAddress, int kbps );
+		void setActiveAddress( const std::string & localAddress );
+		// True if a budget applies to the active address.
+		bool isEnabled();
+
+		// Reserving again for a call replaces its reservation.
+		bool reserve( int callId, int sessions );
+		void release( int callId );
+		int getReservedKbps( int callId );
+
+		void getUtilization( MediaBandwidthUtilization & utilization );
+
+	private:
+		// Called with lock held.
+		int getBudgetKbps();
+		int getSessionCostKbps();
+
+		base::Lock lock;
+		std::map<MediaStreamRegistry::MediaType, MediaBandwidthSource *> sources;
+		std::map<std::string, int> budgets;
+		std::map<std::string, int> measured;
+		std::string activeAddress;
+		std::map<int, int> reservations;	// call id -> kbps
+		int reservedKbps;
+		int peakReservedKbps;
+		unsigned int admitted;
+		unsigned int rejected;
+	};
+};
@@ -0,0 +1,276 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "MediaPortAllocator.h"
+#include "CSFLog.h"
+
+static const char* logTag = "MediaPortAllocator";
+
+// Long enough for late RTP/RTCP of a torn down stream to drain.
+static const int DEFAULT_QUARANTINE_MS = 2000;
+// Ports taken by other processes tend to stay taken.
+static const int DEFAULT_BACKOFF_MS = 60000;
+
+namespace CSF {
+
+	MediaPortAllocator * MediaPortAllocator::getInstance()
+	{
+		static MediaPortAllocator instance;
+		return &instance;
+	}
+
+	MediaPortAllocator::MediaPortAllocator() :
+		startPort(0),
+		endPort(0),
+		quarantineMs(DEFAULT_QUARANTINE_MS),
+		backoffMs(DEFAULT_BACKOFF_MS),
+		owned(0),
+		quarantinedCount(0),
+		unavailableCount(0),
+		maxOwned(0),
+		allocations(0),
+		failures(0)
+	{
+		setRange(1024, 65535);
+	}
+
+	void MediaPortAllocator::setRange( int start, int end )
+	{
+		base::AutoLock l(lock);
+
+		// RTP goes on even ports, so round the start up and drop a trailing odd port.
+		start += (start & 1);
+		if ( start == startPort && end == endPort )
+		{
+			return;
+		}
+
+		int pairs = (end > start) ? (end - start) / 2 : 0;
+		std::vector<unsigned char> newState(pairs, PAIR_FREE);
+		int stillOwned = 0;
+
+		for ( size_t i = 0; i < state.size(); i++ )
+		{
+			int port = startPort + (int) i * 2;
+			if ( state[i] == PAIR_OWNED && port >= start && port + 1 < start + pairs * 2 )
+			{
+				newState[(port - start) / 2] = PAIR_OWNED;
+				stillOwned++;
+			}
+		}
+
+		startPort = start;
+		endPort = end;
+		state.swap(newState);
+		owned = stillOwned;
+		quarantine.clear();
+		unavailable.clear();
+		quarantinedCount = 0;
+		unavailableCount = 0;
+		freeList.clear();
+		for ( int i = 0; i < pairs; i++ )
+		{
+			if ( state[i] == PAIR_FREE )
+			{
+				freeList.push_back(i);
+			}
+		}
+
+		CSFLogInfo( logTag, "setRange: ports %d-%d, %d pairs", startPort, endPort, pairs );
+	}
+
+	void MediaPortAllocator::setQuarantineMs( int ms )
+	{
+		base::AutoLock l(lock);
+		quarantineMs = ms;
+	}
+
+	void MediaPortAllocator::setUnavailableBackoffMs( int ms )
+	{
+		base::AutoLock l(lock);
+		backoffMs = ms;
+	}
+
+	int MediaPortAllocator::indexForPort( int port ) const
+	{
+		if ( port < startPort || (port & 1) != 0 )
+		{
+			return -1;
+		}
+		int index = (port - startPort) / 2;
+		return (index < (int) state.size()) ? index : -1;
+	}
+
+	void MediaPortAllocator::reclaimExpired( std::deque<HeldPair>& held, PairState heldState, base::TimeTicks now )
+	{
+		// Entries are pushed with the same hold period, so the deque is ordered by expiry;
+		// changing the period only delays reclaiming a few entries.
+		while ( !held.empty() && held.front().until <= now )
+		{
+			int index = held.front().index;
+			held.pop_front();
+			if ( state[index] == heldState )
+			{
+				state[index] = PAIR_FREE;
+				freeList.push_back(index);
+				if ( heldState == PAIR_QUARANTINED )
+				{
+					quarantinedCount--;
+				}
+				else
+				{
+					unavailableCount--;
+				}
+			}
+		}
+	}
+
+	void MediaPortAllocator::hold( std::deque<HeldPair>& held, int index, PairState heldState, int ms )
+	{
+		HeldPair entry;
+		entry.index = index;
+		entry.until = base::TimeTicks::Now() + base::TimeDelta::FromMilliseconds(ms);
+		state[index] = (unsigned char) heldState;
+		held.push_back(entry);
+	}
+
+	int MediaPortAllocator::takeLocked( int index )
+	{
+		state[index] = PAIR_OWNED;
+		owned++;
+		allocations++;
+		if ( owned > maxOwned )
+		{
+			maxOwned = owned;
+		}
+		return startPort + index * 2;
+	}
+
+	int MediaPortAllocator::allocate( int requestedPort )
+	{
+		base::AutoLock l(lock);
+		base::TimeTicks now = base::TimeTicks::Now();
+
+		reclaimExpired(quarantine, PAIR_QUARANTINED, now);
+		reclaimExpired(unavailable, PAIR_UNAVAILABLE, now);
+
+		int index = indexForPort(requestedPort);
+		if ( index >= 0 && state[index] == PAIR_FREE )
+		{
+			// its free list entry goes stale and is skipped when popped
+			return takeLocked(index);
+		}
+
+		while ( !freeList.empty() )
+		{
+			index = freeList.front();
+			freeList.pop_front();
+			if ( state[index] == PAIR_FREE )
+			{
+				return takeLocked(index);
+			}
+		}
+
+		failures++;
+		CSFLogWarn( logTag, "allocate: no free port pairs in %d-%d (owned %d, quarantined %d, unavailable %d)",
+				startPort, endPort, owned, quarantinedCount, unavailableCount );
+		return 0;
+	}
+
+	void MediaPortAllocator::release( int port )
+	{
+		base::AutoLock l(lock);
+		int index = indexForPort(port);
+		if ( index < 0 || state[index] != PAIR_OWNED )
+		{
+			return;
+		}
+		owned--;
+		quarantinedCount++;
+		hold(quarantine, index, PAIR_QUARANTINED, quarantineMs);
+	}
+
+	void MediaPortAllocator::markUnavailable( int port )
+	{
+		base::AutoLock l(lock);
+		int index = indexForPort(port);
+		if ( index < 0 || state[index] != PAIR_OWNED )
+		{
+			return;
+		}
+		owned--;
+		unavailableCount++;
+		hold(unavailable, index, PAIR_UNAVAILABLE, backoffMs);
+	}
+
+	void MediaPortAllocator::cancel( int port )
+	{
+		base::AutoLock l(lock);
+		int index = indexForPort(port);
+		if ( index < 0 || state[index] != PAIR_OWNED )
+		{
+			return;
+		}
+		owned--;
+		state[index] = PAIR_FREE;
+		freeList.push_front(index);
+	}
+
+	MediaPortAllocator::Stats MediaPortAllocator::getStats()
+	{
+		base::AutoLock l(lock);
+		base::TimeTicks now = base::TimeTicks::Now();
+
+		reclaimExpired(quarantine, PAIR_QUARANTINED, now);
+		reclaimExpired(unavailable, PAIR_UNAVAILABLE, now);
+
+		Stats stats;
+		stats.startPort = startPort;
+		stats.endPort = endPort;
+		stats.totalPairs = (int) state.size();
+		stats.owned = owned;
+		stats.quarantined = quarantinedCount;
+		stats.unavailable = unavailableCount;
+		stats.freePairs = stats.totalPairs - owned - quarantinedCount - unavailableCount;
+		stats.maxOwned = maxOwned;
+		stats.allocations = allocations;
+		stats.failures = failures;
+		return stats;
+	}
+}
@@ -0,0 +1,130 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+
+namespace CSF
+{
+	/*
+	 * Hands out RTP/RTCP port pairs (even RTP port, RTCP on the next port) from
+	 * one range shared by the audio and video providers.
+	 *
+	 * Each pair has a state slot, and free pairs are kept in a FIFO, so allocation
+	 * is O(1) and a just-released pair is the last to be reused. Released pairs sit
+	 * in quarantine for a while so late packets of the old stream do not reach a new
+	 * one. Pairs the media engine fails to bind (owned by another process) are held
+	 * out for a longer back-off before they are tried again.
+	 *
+	 * Has no media engine dependency, so it can be driven on its own.
+	 */
+	class MediaPortAllocator
+	{
+	public:
+		struct Stats
+		{
+			int startPort;
+			int endPort;
+			int totalPairs;
+			int owned;
+			int freePairs;
+			int quarantined;
+			int unavailable;
+			int maxOwned;
+			unsigned int allocations;
+			unsigned int failures;
+		};
+
+		static MediaPortAllocator * getInstance();
+
+		MediaPortAllocator();
+
+		// Ports in [startPort, endPort) are used; the range is rounded in to whole even pairs.
+		// Pairs owned at the time stay owned until released.
+		void setRange( int startPort, int endPort );
+		void setQuarantineMs( int ms );
+		void setUnavailableBackoffMs( int ms );
+
+		// Returns the RTP port of a pair now owned by the caller, or 0 if none is free.
+		// requestedPort is honoured when its pair is free.
+		int allocate( int requestedPort );
+		// Owner is done with the pair, it goes into quarantine.
+		void release( int port );
+		// The pair could not be bound; hold it out for the back-off period.
+		void markUnavailable( int port );
+		// The pair was never used (setup failed for other reasons); make it free again at once.
+		void cancel( int port );
+
+		Stats getStats();
+
+	private:
+		enum PairState { PAIR_FREE, PAIR_OWNED, PAIR_QUARANTINED, PAIR_UNAVAILABLE };
+
+		struct HeldPair
+		{
+			int index;
+			base::TimeTicks until;
+		};
+
+		int indexForPort( int port ) const;
+		void reclaimExpired( std::deque<HeldPair>& held, PairState state, base::TimeTicks now );
+		void hold( std::deque<HeldPair>& held, int index, PairState state, int ms );
+		int takeLocked( int index );
+
+		base::Lock lock;
+		int startPort;
+		int endPort;
+		std::vector<unsigned char> state;
+		std::deque<int> freeList;		// may hold stale entries, state is authoritative
+		std::deque<HeldPair> quarantine;
+		std::deque<HeldPair> unavailable;
+		int quarantineMs;
+		int backoffMs;
+		int owned;
+		int quarantinedCount;
+		int unavailableCount;
+		int maxOwned;
+		unsigned int allocations;
+		unsigned int failures;
+	};
+};
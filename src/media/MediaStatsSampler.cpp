@@ -0,0 +1,407 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <string.h>
+#include "MediaStatsSampler.h"
+#include "CSFLogStream.h"
+
+static const char* logTag = "MediaStatsSampler";
+
+namespace CSF {
+
+	MediaStatsSampler * MediaStatsSampler::getInstance()
+	{
+		static MediaStatsSampler instance;
+		return &instance;
+	}
+
+	MediaStatsSampler::MediaStatsSampler() :
+		wakeup(&lock),
+		intervalMs(0),
+		stopping(false),
+		nextGeneration(0),
+		thread(NULL)
+	{
+	}
+
+	MediaStatsSampler::~MediaStatsSampler()
+	{
+		stopThread();
+	}
+
+	void MediaStatsSampler::setIntervalMs( int ms )
+	{
+		if ( ms < 0 )
+		{
+			ms = 0;
+		}
+
+		base::AutoLock c(controlLock);
+		{
+			base::AutoLock l(lock);
+			base::subtle::NoBarrier_Store(&intervalMs, ms);
+			if ( ms == 0 )
+			{
+				streams.clear();
+			}
+			wakeup.Signal();
+		}
+
+		if ( ms == 0 )
+		{
+			stopThread();
+		}
+		else if ( thread == NULL )
+		{
+			{
+				base::AutoLock l(lock);
+				stopping = false;
+			}
+			thread = new base::DelegateSimpleThread(this, "MediaStats");
+			thread->Start();
+		}
+		CSFLogInfoS( logTag, "RTP statistics sampling interval " << ms << " ms" );
+	}
+
+	int MediaStatsSampler::getIntervalMs()
+	{
+		return base::subtle::NoBarrier_Load(&intervalMs);
+	}
+
+	void MediaStatsSampler::stopThread()
+	{
+		{
+			base::AutoLock l(lock);
+			stopping = true;
+			wakeup.Signal();
+		}
+		if ( thread != NULL )
+		{
+			thread->Join();
+			delete thread;
+			thread = NULL;
+		}
+	}
+
+	void MediaStatsSampler::addStream( MediaStreamRegistry::MediaType type, int streamId, MediaStatsSource * source )
+	{
+		if ( base::subtle::NoBarrier_Load(&intervalMs) == 0 )
+		{
+			return;
+		}
+
+		base::AutoLock l(lock);
+		if ( base::subtle::NoBarrier_Load(&intervalMs) == 0 )
+		{
+			return;
+		}
+
+		StreamRecord & record = streams[Key(type, streamId)];
+		memset(&record.ring, 0, sizeof(record.ring));
+		memset(&record.summary, 0, sizeof(record.summary));
+		record.source = source;
+		record.generation = ++nextGeneration;
+		record.started = base::TimeTicks::Now();
+		record.next = 0;
+		record.count = 0;
+		record.summary.streamId = streamId;
+		record.jitterSum = 0;
+		record.rttSum = 0;
+		record.rttSamples = 0;
+	}
+
+	void MediaStatsSampler::removeStream( MediaStreamRegistry::MediaType type, int streamId )
+	{
+		if ( base::subtle::NoBarrier_Load(&intervalMs) == 0 )
+		{
+			return;
+		}
+
+		Key key(type, streamId);
+		MediaStatsSource * source;
+		unsigned int generation;
+		{
+			base::AutoLock l(lock);
+			std::map<Key, StreamRecord>::iterator it = streams.find(key);
+			if ( it == streams.end() )
+			{
+				return;
+			}
+			source = it->second.source;
+			generation = it->second.generation;
+		}
+
+		// The channel still exists, so the counters are complete up to here.
+		sampleStream(key, source, generation);
+
+		MediaStreamSummary summary;
+		{
+			base::AutoLock l(lock);
+			std::map<Key, StreamRecord>::iterator it = streams.find(key);
+			if ( it == streams.end() || it->second.generation != generation )
+			{
+				return;
+			}
+			summary = it->second.summary;
+			streams.erase(it);
+
+			ended.push_back(std::make_pair(key, summary));
+			if ( ended.size() > MAX_ENDED )
+			{
+				ended.pop_front();
+			}
+		}
+
+		CSFLogInfoS( logTag, (type == MediaStreamRegistry::VIDEO_STREAM ? "video" : "audio") << " stream " << streamId <<
+				" ended: duration " << summary.durationMs << " ms, " << summary.samples << " samples" <<
+				", rx " << summary.packetsReceived << " pkts/" << summary.bytesReceived << " bytes" <<
+				", tx " << summary.packetsSent << " pkts/" << summary.bytesSent << " bytes" <<
+				", lost " << summary.packetsLost << " (max fraction " << summary.maxFractionLost << "/256)" <<
+				", jitter avg " << summary.avgJitterMs << " max " << summary.maxJitterMs << " ms" <<
+				", rtt avg " << summary.avgRttMs << " max " << summary.maxRttMs << " ms" <<
+				", rx avg " << summary.avgRxKbps << " min " << summary.minRxKbps << " kbps" <<
+				", tx avg " << summary.avgTxKbps << " kbps" );
+	}
+
+	bool MediaStatsSampler::getLatest( MediaStreamRegistry::MediaType type, int streamId, MediaStreamStats & stats )
+	{
+		base::AutoLock l(lock);
+		std::map<Key, StreamRecord>::const_iterator it = streams.find(Key(type, streamId));
+		if ( it == streams.end() || it->second.count == 0 )
+		{
+			return false;
+		}
+		stats = it->second.ring[(it->second.next + RING_SIZE - 1) % RING_SIZE];
+		return true;
+	}
+
+	std::vector<MediaStreamStats> MediaStatsSampler::getHistory( MediaStreamRegistry::MediaType type, int streamId )
+	{
+		std::vector<MediaStreamStats> history;
+
+		base::AutoLock l(lock);
+		std::map<Key, StreamRecord>::const_iterator it = streams.find(Key(type, streamId));
+		if ( it != streams.end() )
+		{
+			const StreamRecord & record = it->second;
+			history.reserve(record.count);
+			for ( int i = record.count; i > 0; i-- )
+			{
+				history.push_back(record.ring[(record.next + RING_SIZE - i) % RING_SIZE]);
+			}
+		}
+		return history;
+	}
+
+	bool MediaStatsSampler::getSummary( MediaStreamRegistry::MediaType type, int streamId, MediaStreamSummary & summary )
+	{
+		Key key(type, streamId);
+
+		base::AutoLock l(lock);
+		std::map<Key, StreamRecord>::const_iterator it = streams.find(key);
+		if ( it != streams.end() )
+		{
+			if ( it->second.count == 0 )
+			{
+				return false;
+			}
+			summary = it->second.summary;
+			return true;
+		}
+
+		// Stream ids get reused, so the newest ended entry wins.
+		for ( std::deque<std::pair<Key, MediaStreamSummary> >::reverse_iterator e = ended.rbegin(); e != ended.rend(); e++ )
+		{
+			if ( e->first == key )
+			{
+				summary = e->second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void MediaStatsSampler::Run()
+	{
+		base::TimeTicks next = base::TimeTicks::Now();
+		for (;;)
+		{
+			{
+				base::AutoLock l(lock);
+				base::TimeDelta interval = base::TimeDelta::FromMilliseconds(base::subtle::NoBarrier_Load(&intervalMs));
+				next += interval;
+
+				base::TimeTicks now;
+				for (;;)
+				{
+					if ( stopping )
+					{
+						return;
+					}
+					now = base::TimeTicks::Now();
+					if ( now >= next )
+					{
+						break;
+					}
+					wakeup.TimedWait(next - now);
+				}
+
+				// After a stall, carry on from now rather than catching up with a burst of samples.
+				if ( now - next > interval )
+				{
+					next = now;
+				}
+			}
+			sampleAll();
+		}
+	}
+
+	void MediaStatsSampler::sampleAll()
+	{
+		std::vector<Pending> pending;
+		{
+			base::AutoLock l(lock);
+			pending.reserve(streams.size());
+			for ( std::map<Key, StreamRecord>::const_iterator it = streams.begin(); it != streams.end(); it++ )
+			{
+				Pending p = { it->first, it->second.source, it->second.generation };
+				pending.push_back(p);
+			}
+		}
+
+		// The engine calls are made without the lock held.
+		for ( std::vector<Pending>::const_iterator it = pending.begin(); it != pending.end(); it++ )
+		{
+			sampleStream(it->key, it->source, it->generation);
+		}
+	}
+
+	bool MediaStatsSampler::sampleStream( const Key & key, MediaStatsSource * source, unsigned int generation )
+	{
+		MediaStreamStats stats;
+		memset(&stats, 0, sizeof(stats));
+		if ( !source->readRtpStats(key.second, stats) )
+		{
+			return false;
+		}
+		base::TimeTicks now = base::TimeTicks::Now();
+
+		base::AutoLock l(lock);
+		std::map<Key, StreamRecord>::iterator it = streams.find(key);
+		if ( it == streams.end() || it->second.generation != generation )
+		{
+			// removed, or removed and added again, while the engine was being read
+			return false;
+		}
+		stats.streamId = key.second;
+		stats.timeMs = (int) (now - it->second.started).InMilliseconds();
+		accumulate(it->second, stats);
+		return true;
+	}
+
+	void MediaStatsSampler::accumulate( StreamRecord & record, MediaStreamStats & stats )
+	{
+		// Rates cover the time since the previous sample, or since the stream started for the first one.
+		int sinceMs = stats.timeMs;
+		unsigned int rxBytes = stats.bytesReceived;
+		unsigned int txBytes = stats.bytesSent;
+		if ( record.count > 0 )
+		{
+			const MediaStreamStats & prev = record.ring[(record.next + RING_SIZE - 1) % RING_SIZE];
+			sinceMs = stats.timeMs - prev.timeMs;
+			rxBytes = stats.bytesReceived - prev.bytesReceived;
+			txBytes = stats.bytesSent - prev.bytesSent;
+		}
+		if ( sinceMs > 0 )
+		{
+			stats.rxKbps = (int) ((long long) rxBytes * 8 / sinceMs);
+			stats.txKbps = (int) ((long long) txBytes * 8 / sinceMs);
+		}
+
+		bool fullInterval = (record.count > 0);
+		record.ring[record.next] = stats;
+		record.next = (record.next + 1) % RING_SIZE;
+		if ( record.count < RING_SIZE )
+		{
+			record.count++;
+		}
+
+		MediaStreamSummary & summary = record.summary;
+		summary.samples++;
+		summary.durationMs = stats.timeMs;
+		summary.packetsReceived = stats.packetsReceived;
+		summary.bytesReceived = stats.bytesReceived;
+		summary.packetsLost = stats.packetsLost;
+		summary.packetsSent = stats.packetsSent;
+		summary.bytesSent = stats.bytesSent;
+		if ( stats.fractionLost > summary.maxFractionLost )
+		{
+			summary.maxFractionLost = stats.fractionLost;
+		}
+
+		record.jitterSum += stats.jitterMs;
+		summary.avgJitterMs = (int) (record.jitterSum / summary.samples);
+		if ( stats.jitterMs > summary.maxJitterMs )
+		{
+			summary.maxJitterMs = stats.jitterMs;
+		}
+
+		// No RTT until the first RTCP round trip has completed.
+		if ( stats.rttMs > 0 )
+		{
+			record.rttSum += stats.rttMs;
+			record.rttSamples++;
+			summary.avgRttMs = (int) (record.rttSum / record.rttSamples);
+			if ( stats.rttMs > summary.maxRttMs )
+			{
+				summary.maxRttMs = stats.rttMs;
+			}
+		}
+
+		if ( summary.durationMs > 0 )
+		{
+			summary.avgRxKbps = (int) ((long long) summary.bytesReceived * 8 / summary.durationMs);
+			summary.avgTxKbps = (int) ((long long) summary.bytesSent * 8 / summary.durationMs);
+		}
+		if ( fullInterval && (summary.samples == 2 || stats.rxKbps < summary.minRxKbps) )
+		{
+			summary.minRxKbps = stats.rxKbps;
+		}
+	}
+};
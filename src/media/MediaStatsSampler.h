@@ -0,0 +1,141 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "ECC_Types.h"
+#include "MediaStreamRegistry.h"
+#include "base/atomicops.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+
+namespace CSF
+{
+	// Implemented by the media providers: reads the engine's RTP/RTCP counters for one stream.
+	class MediaStatsSource
+	{
+	public:
+		// Fills the cumulative counters, loss, jitter and RTT. Returns false if the stream has no channel.
+		virtual bool readRtpStats( int streamId, MediaStreamStats & stats ) = 0;
+		virtual ~MediaStatsSource() {}
+	};
+
+	/*
+	 * Samples the RTP/RTCP statistics of every active audio and video stream on a
+	 * fixed interval, from one thread shared by both providers.
+	 *
+	 * Each stream keeps its last RING_SIZE samples and a running summary. When a
+	 * stream is removed its summary is logged and kept in a short list of ended
+	 * streams so call end processing can still read it.
+	 *
+	 * With the interval at 0 (the default) there is no thread and streams are not
+	 * tracked at all; addStream and removeStream return without taking a lock.
+	 */
+	class MediaStatsSampler : public base::DelegateSimpleThread::Delegate
+	{
+	public:
+		enum { RING_SIZE = 32, MAX_ENDED = 16 };
+
+		static MediaStatsSampler * getInstance();
+
+		MediaStatsSampler();
+		~MediaStatsSampler();
+
+		// 0 stops sampling and drops all tracked streams.
+		void setIntervalMs( int ms );
+		int getIntervalMs();
+
+		// Streams added while sampling is off are not tracked.
+		void addStream( MediaStreamRegistry::MediaType type, int streamId, MediaStatsSource * source );
+		// Takes a last sample, logs the summary and moves it to the ended list.
+		void removeStream( MediaStreamRegistry::MediaType type, int streamId );
+
+		bool getLatest( MediaStreamRegistry::MediaType type, int streamId, MediaStreamStats & stats );
+		// Oldest first.
+		std::vector<MediaStreamStats> getHistory( MediaStreamRegistry::MediaType type, int streamId );
+		// Active streams first, then recently ended ones.
+		bool getSummary( MediaStreamRegistry::MediaType type, int streamId, MediaStreamSummary & summary );
+
+		virtual void Run();
+
+	private:
+		typedef std::pair<int, int> Key;
+
+		struct StreamRecord
+		{
+			MediaStatsSource * source;
+			unsigned int generation;
+			base::TimeTicks started;
+			MediaStreamStats ring[RING_SIZE];
+			int next;
+			int count;
+			MediaStreamSummary summary;
+			long long jitterSum;
+			long long rttSum;
+			int rttSamples;
+		};
+
+		struct Pending
+		{
+			Key key;
+			MediaStatsSource * source;
+			unsigned int generation;
+		};
+
+		void sampleAll();
+		bool sampleStream( const Key & key, MediaStatsSource * source, unsigned int generation );
+		static void accumulate( StreamRecord & record, MediaStreamStats & stats );
+		void stopThread();
+
+		base::Lock controlLock;			// serialises starting and stopping the thread
+		base::Lock lock;
+		base::ConditionVariable wakeup;
+		base::subtle::Atomic32 intervalMs;	// read without the lock on the stream add/remove paths
+		bool stopping;
+		unsigned int nextGeneration;
+		std::map<Key, StreamRecord> streams;
+		std::deque<std::pair<Key, MediaStreamSummary> > ended;
+		base::DelegateSimpleThread * thread;
+	};
+};
@@ -0,0 +1,215 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "MediaStreamRegistry.h"
+
+namespace CSF {
+
+	MediaStreamRegistry * MediaStreamRegistry::getInstance()
+	{
+		static MediaStreamRegistry instance;
+		return &instance;
+	}
+
+	MediaStreamRegistry::MediaStreamRegistry() :
+		current(reinterpret_cast<base::subtle::AtomicWord>(new Snapshot())),
+		activeReaders(0)
+	{
+	}
+
+	MediaStreamRegistry::~MediaStreamRegistry()
+	{
+		delete reinterpret_cast<Snapshot *>(base::subtle::NoBarrier_Load(&current));
+		for ( std::vector<Snapshot *>::iterator it = retired.begin(); it != retired.end(); it++ )
+		{
+			delete *it;
+		}
+	}
+
+	const MediaStreamRegistry::Snapshot * MediaStreamRegistry::acquire()
+	{
+		base::subtle::Barrier_AtomicIncrement(&activeReaders, 1);
+		return reinterpret_cast<const Snapshot *>(base::subtle::Acquire_Load(&current));
+	}
+
+	void MediaStreamRegistry::release()
+	{
+		base::subtle::Barrier_AtomicIncrement(&activeReaders, -1);
+	}
+
+	// A reader that starts after the store sees the new snapshot, so the retired ones can go as soon as
+	// no reader is active; otherwise they wait for the next change.
+	void MediaStreamRegistry::publish( Snapshot * snapshot )
+	{
+		Snapshot * old = reinterpret_cast<Snapshot *>(base::subtle::NoBarrier_Load(&current));
+		base::subtle::Release_Store(&current, reinterpret_cast<base::subtle::AtomicWord>(snapshot));
+		base::subtle::MemoryBarrier();
+		retired.push_back(old);
+
+		if ( base::subtle::Acquire_Load(&activeReaders) != 0 )
+		{
+			return;
+		}
+		for ( std::vector<Snapshot *>::iterator it = retired.begin(); it != retired.end(); it++ )
+		{
+			delete *it;
+		}
+		retired.clear();
+	}
+
+	void MediaStreamRegistry::addStream( MediaType type, int streamId, int channel )
+	{
+		base::AutoLock lock(writerLock);
+		Snapshot * snapshot = new Snapshot(*reinterpret_cast<Snapshot *>(base::subtle::NoBarrier_Load(&current)));
+
+		Key key(type, streamId);
+		std::map<Key, Entry>::iterator it = snapshot->byStream.find(key);
+		if ( it == snapshot->byStream.end() )
+		{
+			Entry entry;
+			entry.type = type;
+			entry.streamId = streamId;
+			entry.channel = -1;
+			entry.callHandle = 0;
+			it = snapshot->byStream.insert(std::make_pair(key, entry)).first;
+		}
+		if ( it->second.channel >= 0 )
+		{
+			snapshot->channelToStream.erase(Key(type, it->second.channel));
+		}
+		it->second.channel = channel;
+		snapshot->channelToStream[Key(type, channel)] = streamId;
+
+		publish(snapshot);
+	}
+
+	void MediaStreamRegistry::removeStream( MediaType type, int streamId )
+	{
+		base::AutoLock lock(writerLock);
+		const Snapshot * cur = reinterpret_cast<Snapshot *>(base::subtle::NoBarrier_Load(&current));
+		std::map<Key, Entry>::const_iterator found = cur->byStream.find(Key(type, streamId));
+		if ( found == cur->byStream.end() )
+		{
+			return;
+		}
+
+		Snapshot * snapshot = new Snapshot(*cur);
+		if ( found->second.channel >= 0 )
+		{
+			snapshot->channelToStream.erase(Key(type, found->second.channel));
+		}
+		snapshot->byStream.erase(Key(type, streamId));
+
+		publish(snapshot);
+	}
+
+	void MediaStreamRegistry::bindCall( MediaType type, int streamId, unsigned int callHandle )
+	{
+		base::AutoLock lock(writerLock);
+		const Snapshot * cur = reinterpret_cast<Snapshot *>(base::subtle::NoBarrier_Load(&current));
+		std::map<Key, Entry>::const_iterator found = cur->byStream.find(Key(type, streamId));
+		if ( found != cur->byStream.end() && found->second.callHandle == callHandle )
+		{
+			return;
+		}
+
+		Snapshot * snapshot = new Snapshot(*cur);
+		Entry & entry = snapshot->byStream[Key(type, streamId)];
+		if ( found == cur->byStream.end() )
+		{
+			// stream registered before the provider reported its channel
+			entry.type = type;
+			entry.streamId = streamId;
+			entry.channel = -1;
+		}
+		entry.callHandle = callHandle;
+
+		publish(snapshot);
+	}
+
+	bool MediaStreamRegistry::findByStream( MediaType type, int streamId, Entry & entry )
+	{
+		const Snapshot * snapshot = acquire();
+		std::map<Key, Entry>::const_iterator it = snapshot->byStream.find(Key(type, streamId));
+		bool found = (it != snapshot->byStream.end());
+		if ( found )
+		{
+			entry = it->second;
+		}
+		release();
+		return found;
+	}
+
+	bool MediaStreamRegistry::findByChannel( MediaType type, int channel, Entry & entry )
+	{
+		const Snapshot * snapshot = acquire();
+		bool found = false;
+		std::map<Key, int>::const_iterator it = snapshot->channelToStream.find(Key(type, channel));
+		if ( it != snapshot->channelToStream.end() )
+		{
+			std::map<Key, Entry>::const_iterator e = snapshot->byStream.find(Key(type, it->second));
+			if ( e != snapshot->byStream.end() )
+			{
+				entry = e->second;
+				found = true;
+			}
+		}
+		release();
+		return found;
+	}
+
+	int MediaStreamRegistry::channelForStream( MediaType type, int streamId )
+	{
+		Entry entry;
+		return findByStream(type, streamId, entry) ? entry.channel : -1;
+	}
+
+	void MediaStreamRegistry::getCallStreams( MediaType type, std::vector<Entry> & entries )
+	{
+		const Snapshot * snapshot = acquire();
+		for ( std::map<Key, Entry>::const_iterator it = snapshot->byStream.begin(); it != snapshot->byStream.end(); it++ )
+		{
+			if ( it->first.first == type && it->second.callHandle != 0 )
+			{
+				entries.push_back(it->second);
+			}
+		}
+		release();
+	}
+}
@@ -0,0 +1,108 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include "base/atomicops.h"
+#include "base/synchronization/lock.h"
+
+namespace CSF
+{
+	/*
+	 * Maps stream ids to media engine channels (and back) for the audio and video
+	 * providers, along with the call that owns each stream.
+	 *
+	 * Lookups from media engine callbacks take no lock: the maps are published as an
+	 * immutable snapshot and replaced wholesale on every change, which only happens at
+	 * stream setup and teardown. A replaced snapshot is freed once no reader is inside
+	 * a lookup.
+	 */
+	class MediaStreamRegistry
+	{
+	public:
+		enum MediaType { AUDIO_STREAM = 0, VIDEO_STREAM = 1 };
+
+		struct Entry
+		{
+			MediaType type;
+			int streamId;
+			int channel;			// -1 until the provider has a channel for it
+			unsigned int callHandle;	// 0 until the call is bound
+		};
+
+		static MediaStreamRegistry * getInstance();
+
+		MediaStreamRegistry();
+		~MediaStreamRegistry();
+
+		// Provider side, from rxAlloc and rxRelease.
+		void addStream( MediaType type, int streamId, int channel );
+		void removeStream( MediaType type, int streamId );
+		// Signaling side, from stream registration.
+		void bindCall( MediaType type, int streamId, unsigned int callHandle );
+
+		bool findByStream( MediaType type, int streamId, Entry & entry );
+		bool findByChannel( MediaType type, int channel, Entry & entry );
+		// -1 if the stream has no channel
+		int channelForStream( MediaType type, int streamId );
+		// All streams of a type that are bound to a call, in stream id order.
+		void getCallStreams( MediaType type, std::vector<Entry> & entries );
+
+	private:
+		typedef std::pair<int, int> Key;	// (type, streamId) or (type, channel)
+
+		struct Snapshot
+		{
+			std::map<Key, Entry> byStream;
+			std::map<Key, int> channelToStream;
+		};
+
+		const Snapshot * acquire();
+		void release();
+		// Called with writerLock held.
+		void publish( Snapshot * snapshot );
+
+		base::Lock writerLock;
+		base::subtle::AtomicWord current;
+		base::subtle::Atomic32 activeReaders;
+		std::vector<Snapshot *> retired;
+	};
+};
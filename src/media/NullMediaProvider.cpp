@@ -0,0 +1,727 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "NullMediaProvider.h"
+#include "CSFLogStream.h"
+
+static const char* logTag = "NullMediaProvider";
+
+// G.711 payload rate, and a typical video call rate of 384 kbps.
+static const int AUDIO_BYTES_PER_SECOND = 8000;
+static const int VIDEO_BYTES_PER_SECOND = 48000;
+static const int AUDIO_PACK_PERIOD_MS = 20;
+static const int VIDEO_PACK_PERIOD_MS = 33;
+
+static const size_t DEFAULT_MAX_EVENTS = 1024;
+
+namespace CSF {
+
+//
+// NullStreamSet
+//
+
+NullStreamSet::NullStreamSet( NullMediaProvider * provider, MediaStreamRegistry::MediaType type, int bytesPerSecond, int defaultPackPeriod )
+: provider(provider),
+  type(type),
+  bytesPerSecond(bytesPerSecond),
+  defaultPackPeriod(defaultPackPeriod),
+  nextChannel(0)
+{
+    sessionCostKbps = MediaBandwidthManager::addPacketOverhead( bytesPerSecond * 8 / 1000, 1000 / defaultPackPeriod );
+}
+
+NullStreamSet::~NullStreamSet()
+{
+    base::AutoLock l(lock);
+    for (std::map<int, Stream>::iterator it = streams.begin(); it != streams.end(); it++)
+    {
+        MediaStatsSampler::getInstance()->removeStream( type, it->first );
+        MediaStreamRegistry::getInstance()->removeStream( type, it->first );
+    }
+}
+
+void NullStreamSet::advance( Stream & stream, base::TimeTicks now, bool loopback )
+{
+    long long elapsedMs = (now - stream.updated).InMilliseconds();
+    if (elapsedMs <= 0)
+    {
+        return;
+    }
+    // A muted stream still sends (silence), so only the running state matters.
+    if (stream.txRunning)
+    {
+        stream.txMs += elapsedMs;
+        if (loopback && stream.rxRunning)
+        {
+            stream.rxMs += elapsedMs;
+        }
+    }
+    stream.updated = now;
+}
+
+int NullStreamSet::rxAlloc( int groupId, int streamId, int requestedPort )
+{
+    int port = provider->allocatePort( requestedPort );
+    if (port == 0)
+    {
+        CSFLogErrorS( logTag, "rxAlloc: no virtual port free for stream " << streamId );
+        return 0;
+    }
+
+    int channel;
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it != streams.end())
+        {
+            // stream id reused without a release; give back its old port
+            provider->releasePort( it->second.port );
+        }
+        Stream & stream = streams[streamId];
+        stream.groupId = groupId;
+        stream.port = port;
+        stream.channel = channel = nextChannel++;
+        stream.packPeriod = defaultPackPeriod;
+        stream.muted = false;
+        stream.rxRunning = false;
+        stream.txRunning = false;
+        stream.updated = base::TimeTicks::Now();
+        stream.rxMs = 0;
+        stream.txMs = 0;
+    }
+
+    MediaStreamRegistry::getInstance()->addStream( type, streamId, channel );
+    MediaStatsSampler::getInstance()->addStream( type, streamId, this );
+    provider->recordEvent( NullMediaEvent::RX_ALLOC, isVideo(), groupId, streamId, port );
+    return port;
+}
+
+int NullStreamSet::rxOpen( int groupId, int streamId, int requestedPort )
+{
+    if (!hasStream( streamId ))
+    {
+        return 0;
+    }
+    provider->recordEvent( NullMediaEvent::RX_OPEN, isVideo(), groupId, streamId, requestedPort );
+    return requestedPort;
+}
+
+int NullStreamSet::rxStart( int groupId, int streamId, int payloadType, int packPeriod )
+{
+    bool loopback = provider->getLoopback();
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it == streams.end())
+        {
+            return -1;
+        }
+        advance( it->second, base::TimeTicks::Now(), loopback );
+        it->second.rxRunning = true;
+    }
+    provider->recordEvent( NullMediaEvent::RX_START, isVideo(), groupId, streamId, payloadType );
+    return 0;
+}
+
+void NullStreamSet::rxClose( int groupId, int streamId )
+{
+    bool loopback = provider->getLoopback();
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it == streams.end())
+        {
+            return;
+        }
+        advance( it->second, base::TimeTicks::Now(), loopback );
+        it->second.rxRunning = false;
+    }
+    provider->recordEvent( NullMediaEvent::RX_CLOSE, isVideo(), groupId, streamId, 0 );
+}
+
+void NullStreamSet::rxRelease( int groupId, int streamId, int port )
+{
+    // Final stats sample while the stream is still known.
+    MediaStatsSampler::getInstance()->removeStream( type, streamId );
+    MediaStreamRegistry::getInstance()->removeStream( type, streamId );
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it == streams.end())
+        {
+            CSFLogErrorS( logTag, "rxRelease: no stream " << streamId );
+            return;
+        }
+        port = it->second.port;
+        streams.erase( it );
+    }
+    provider->releasePort( port );
+    provider->recordEvent( NullMediaEvent::RX_RELEASE, isVideo(), groupId, streamId, port );
+}
+
+int NullStreamSet::txStart( int groupId, int streamId, int payloadType, int packPeriod )
+{
+    bool loopback = provider->getLoopback();
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it == streams.end())
+        {
+            return -1;
+        }
+        advance( it->second, base::TimeTicks::Now(), loopback );
+        it->second.txRunning = true;
+        if (packPeriod > 0)
+        {
+            it->second.packPeriod = packPeriod;
+        }
+    }
+    provider->recordEvent( NullMediaEvent::TX_START, isVideo(), groupId, streamId, payloadType );
+    return 0;
+}
+
+void NullStreamSet::txClose( int groupId, int streamId )
+{
+    bool loopback = provider->getLoopback();
+    {
+        base::AutoLock l(lock);
+        std::map<int, Stream>::iterator it = streams.find( streamId );
+        if (it == streams.end())
+        {
+            return;
+        }
+        advance( it->second, base::TimeTicks::Now(), loopback );
+        it->second.txRunning = false;
+    }
+    provider->recordEvent( NullMediaEvent::TX_CLOSE, isVideo(), groupId, streamId, 0 );
+}
+
+bool NullStreamSet::setMuted( int streamId, bool muted )
+{
+    base::AutoLock l(lock);
+    std::map<int, Stream>::iterator it = streams.find( streamId );
+    if (it == streams.end())
+    {
+        return false;
+    }
+    it->second.muted = muted;
+    return true;
+}
+
+bool NullStreamSet::isMuted( int streamId )
+{
+    base::AutoLock l(lock);
+    std::map<int, Stream>::const_iterator it = streams.find( streamId );
+    return it != streams.end() && it->second.muted;
+}
+
+bool NullStreamSet::hasStream( int streamId )
+{
+    base::AutoLock l(lock);
+    return streams.find( streamId ) != streams.end();
+}
+
+int NullStreamSet::getStreamCount()
+{
+    base::AutoLock l(lock);
+    return (int) streams.size();
+}
+
+bool NullStreamSet::readRtpStats( int streamId, MediaStreamStats & stats )
+{
+    bool loopback = provider->getLoopback();
+
+    base::AutoLock l(lock);
+    std::map<int, Stream>::iterator it = streams.find( streamId );
+    if (it == streams.end())
+    {
+        return false;
+    }
+    Stream & stream = it->second;
+    advance( stream, base::TimeTicks::Now(), loopback );
+
+    unsigned int packetBytes = (unsigned int) (bytesPerSecond * stream.packPeriod / 1000);
+    stats.packetsSent = (unsigned int) (stream.txMs / stream.packPeriod);
+    stats.bytesSent = stats.packetsSent * packetBytes;
+    stats.packetsReceived = (unsigned int) (stream.rxMs / stream.packPeriod);
+    stats.bytesReceived = stats.packetsReceived * packetBytes;
+    // a perfect network
+    stats.packetsLost = 0;
+    stats.fractionLost = 0;
+    stats.jitterMs = 0;
+    stats.rttMs = 0;
+    return true;
+}
+
+int NullStreamSet::getSessionCostKbps()
+{
+    base::AutoLock l(lock);
+    return sessionCostKbps;
+}
+
+void NullStreamSet::setSessionCostKbps( int kbps )
+{
+    base::AutoLock l(lock);
+    sessionCostKbps = kbps;
+}
+
+//
+// NullAudioProvider
+//
+
+const char * const NullAudioProvider::NULL_DEVICE = "Null Audio Device";
+
+NullAudioProvider::NullAudioProvider( NullMediaProvider * provider )
+: provider(provider),
+  streams(provider, MediaStreamRegistry::AUDIO_STREAM, AUDIO_BYTES_PER_SECOND, AUDIO_PACK_PERIOD_MS),
+  defaultVolume(100),
+  ringerVolume(100)
+{
+}
+
+std::vector<std::string> NullAudioProvider::getRecordingDevices()
+{
+    return std::vector<std::string>(1, NULL_DEVICE);
+}
+
+std::vector<std::string> NullAudioProvider::getPlayoutDevices()
+{
+    return std::vector<std::string>(1, NULL_DEVICE);
+}
+
+bool NullAudioProvider::setDefaultVolume( int volume )
+{
+    base::AutoLock l(lock);
+    defaultVolume = volume;
+    return true;
+}
+
+int NullAudioProvider::getDefaultVolume()
+{
+    base::AutoLock l(lock);
+    return defaultVolume;
+}
+
+bool NullAudioProvider::setRingerVolume( int volume )
+{
+    base::AutoLock l(lock);
+    ringerVolume = volume;
+    return true;
+}
+
+int NullAudioProvider::getRingerVolume()
+{
+    base::AutoLock l(lock);
+    return ringerVolume;
+}
+
+void NullAudioProvider::setStatsSampleInterval( int ms )
+{
+    MediaStatsSampler::getInstance()->setIntervalMs( ms );
+}
+
+bool NullAudioProvider::getStreamStats( int streamId, MediaStreamStats & stats )
+{
+    if (MediaStatsSampler::getInstance()->getLatest( MediaStreamRegistry::AUDIO_STREAM, streamId, stats ))
+    {
+        return true;
+    }
+    memset( &stats, 0, sizeof(stats) );
+    stats.streamId = streamId;
+    return streams.readRtpStats( streamId, stats );
+}
+
+std::vector<MediaStreamStats> NullAudioProvider::getStreamStatsHistory( int streamId )
+{
+    return MediaStatsSampler::getInstance()->getHistory( MediaStreamRegistry::AUDIO_STREAM, streamId );
+}
+
+bool NullAudioProvider::getStreamSummary( int streamId, MediaStreamSummary & summary )
+{
+    return MediaStatsSampler::getInstance()->getSummary( MediaStreamRegistry::AUDIO_STREAM, streamId, summary );
+}
+
+int NullAudioProvider::rxStart( int groupId, int streamId, int payloadType, int packPeriod, int localPort, int rfc2833PayloadType,
+        EncryptionAlgorithm algorithm, unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party )
+{
+    return streams.rxStart( groupId, streamId, payloadType, packPeriod );
+}
+
+int NullAudioProvider::txStart( int groupId, int streamId, int payloadType, int packPeriod, bool vad, short tos,
+        char* remoteIpAddr, int remotePort, int rfc2833PayloadType, EncryptionAlgorithm algorithm,
+        unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party )
+{
+    return streams.txStart( groupId, streamId, payloadType, packPeriod );
+}
+
+void NullAudioProvider::setMediaPorts( int startPort, int endPort )
+{
+    provider->setPortRange( startPort, endPort );
+}
+
+int NullAudioProvider::toneStart( ToneType type, ToneDirection direction, int alertInfo, int groupId, int streamId, bool useBackup )
+{
+    provider->recordEvent( NullMediaEvent::TONE_START, false, groupId, streamId, type );
+    return 0;
+}
+
+int NullAudioProvider::toneStop( ToneType type, int groupId, int streamId )
+{
+    provider->recordEvent( NullMediaEvent::TONE_STOP, false, groupId, streamId, type );
+    return 0;
+}
+
+int NullAudioProvider::ringStart( int lineId, RingMode mode, bool once )
+{
+    provider->recordEvent( NullMediaEvent::RING_START, false, lineId, -1, mode );
+    return 0;
+}
+
+int NullAudioProvider::ringStop( int lineId )
+{
+    provider->recordEvent( NullMediaEvent::RING_STOP, false, lineId, -1, 0 );
+    return 0;
+}
+
+int NullAudioProvider::sendDtmf( int streamId, int digit )
+{
+    if (!streams.hasStream( streamId ))
+    {
+        return -1;
+    }
+    provider->recordEvent( NullMediaEvent::DTMF, false, -1, streamId, digit );
+    return 0;
+}
+
+bool NullAudioProvider::mute( int streamId, bool mute )
+{
+    if (!streams.setMuted( streamId, mute ))
+    {
+        return false;
+    }
+    provider->recordEvent( mute ? NullMediaEvent::MUTE : NullMediaEvent::UNMUTE, false, -1, streamId, 0 );
+    return true;
+}
+
+bool NullAudioProvider::setVolume( int streamId, int volume )
+{
+    if (!streams.hasStream( streamId ))
+    {
+        return false;
+    }
+    {
+        base::AutoLock l(lock);
+        volumes[streamId] = volume;
+    }
+    provider->recordEvent( NullMediaEvent::VOLUME, false, -1, streamId, volume );
+    return true;
+}
+
+int NullAudioProvider::getVolume( int streamId )
+{
+    base::AutoLock l(lock);
+    std::map<int, int>::const_iterator it = volumes.find( streamId );
+    return it != volumes.end() ? it->second : defaultVolume;
+}
+
+//
+// NullVideoProvider
+//
+
+const char * const NullVideoProvider::NULL_DEVICE = "Null Capture Device";
+
+NullVideoProvider::NullVideoProvider( NullMediaProvider * provider )
+: provider(provider),
+  streams(provider, MediaStreamRegistry::VIDEO_STREAM, VIDEO_BYTES_PER_SECOND, VIDEO_PACK_PERIOD_MS),
+  videoMode(false),
+  audioStreamId(-1)
+{
+}
+
+std::vector<std::string> NullVideoProvider::getCaptureDevices()
+{
+    return std::vector<std::string>(1, NULL_DEVICE);
+}
+
+void NullVideoProvider::setStatsSampleInterval( int ms )
+{
+    MediaStatsSampler::getInstance()->setIntervalMs( ms );
+}
+
+bool NullVideoProvider::getStreamStats( int streamId, MediaStreamStats & stats )
+{
+    if (MediaStatsSampler::getInstance()->getLatest( MediaStreamRegistry::VIDEO_STREAM, streamId, stats ))
+    {
+        return true;
+    }
+    memset( &stats, 0, sizeof(stats) );
+    stats.streamId = streamId;
+    return streams.readRtpStats( streamId, stats );
+}
+
+std::vector<MediaStreamStats> NullVideoProvider::getStreamStatsHistory( int streamId )
+{
+    return MediaStatsSampler::getInstance()->getHistory( MediaStreamRegistry::VIDEO_STREAM, streamId );
+}
+
+bool NullVideoProvider::getStreamSummary( int streamId, MediaStreamSummary & summary )
+{
+    return MediaStatsSampler::getInstance()->getSummary( MediaStreamRegistry::VIDEO_STREAM, streamId, summary );
+}
+
+int NullVideoProvider::rxStart( int groupId, int streamId, int payloadType, int packPeriod, int localPort, int rfc2833PayloadType,
+        EncryptionAlgorithm algorithm, unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party )
+{
+    return streams.rxStart( groupId, streamId, payloadType, packPeriod );
+}
+
+int NullVideoProvider::txStart( int groupId, int streamId, int payloadType, int packPeriod, bool vad, short tos,
+        char* remoteIpAddr, int remotePort, int rfc2833PayloadType, EncryptionAlgorithm algorithm,
+        unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party )
+{
+    return streams.txStart( groupId, streamId, payloadType, packPeriod );
+}
+
+void NullVideoProvider::setMediaPorts( int startPort, int endPort )
+{
+    provider->setPortRange( startPort, endPort );
+}
+
+void NullVideoProvider::sendIFrame( int streamId )
+{
+    provider->recordEvent( NullMediaEvent::IFRAME, true, -1, streamId, 0 );
+}
+
+bool NullVideoProvider::mute( int streamId, bool mute )
+{
+    if (!streams.setMuted( streamId, mute ))
+    {
+        return false;
+    }
+    provider->recordEvent( mute ? NullMediaEvent::MUTE : NullMediaEvent::UNMUTE, true, -1, streamId, 0 );
+    return true;
+}
+
+//
+// NullMediaProvider
+//
+
+NullMediaProvider * NullMediaProvider::_pSelf = NULL;
+
+NullMediaProvider * NullMediaProvider::getInstance()
+{
+    return _pSelf;
+}
+
+bool NullMediaProvider::isSelected()
+{
+#ifdef CSF_NULL_MEDIA
+    return true;
+#else
+    const char * selected = getenv( "CSF_MEDIA_PROVIDER" );
+    return selected != NULL && strcmp( selected, "null" ) == 0;
+#endif
+}
+
+NullMediaProvider::NullMediaProvider()
+: audio(this),
+  video(this),
+  loopback(false),
+  maxEvents(DEFAULT_MAX_EVENTS),
+  startPort(0),
+  endPort(0),
+  nextPort(0)
+{
+    memset( eventCounts, 0, sizeof(eventCounts) );
+
+    const char * loop = getenv( "CSF_NULL_MEDIA_LOOPBACK" );
+    loopback = (loop != NULL && strcmp( loop, "1" ) == 0);
+
+    // Same default as the real providers.
+    setPortRange( 1024, 65535 );
+
+    MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::AUDIO_STREAM, &audio.getStreams() );
+    MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::VIDEO_STREAM, &video.getStreams() );
+    _pSelf = this;
+}
+
+NullMediaProvider::~NullMediaProvider()
+{
+    // the sampler thread reads the stream sets, so it has to be gone first
+    MediaStatsSampler::getInstance()->setIntervalMs( 0 );
+    MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::AUDIO_STREAM, NULL );
+    MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::VIDEO_STREAM, NULL );
+    if (_pSelf == this)
+    {
+        _pSelf = NULL;
+    }
+}
+
+int NullMediaProvider::init()
+{
+    CSFLogInfoS( logTag, "Using the null media provider, loopback " << (loopback ? "on" : "off") );
+    return 0;
+}
+
+void NullMediaProvider::shutdown()
+{
+}
+
+void NullMediaProvider::setLoopback( bool enable )
+{
+    base::AutoLock l(eventLock);
+    loopback = enable;
+}
+
+bool NullMediaProvider::getLoopback()
+{
+    base::AutoLock l(eventLock);
+    return loopback;
+}
+
+void NullMediaProvider::setMaxEvents( size_t max )
+{
+    base::AutoLock l(eventLock);
+    maxEvents = max;
+    while (events.size() > maxEvents)
+    {
+        events.pop_front();
+    }
+}
+
+std::vector<NullMediaEvent> NullMediaProvider::getEvents()
+{
+    base::AutoLock l(eventLock);
+    return std::vector<NullMediaEvent>( events.begin(), events.end() );
+}
+
+unsigned int NullMediaProvider::getEventCount( NullMediaEvent::Type type )
+{
+    base::AutoLock l(eventLock);
+    return (type >= 0 && type < NullMediaEvent::EVENT_TYPE_MAX) ? eventCounts[type] : 0;
+}
+
+void NullMediaProvider::clearEvents()
+{
+    base::AutoLock l(eventLock);
+    events.clear();
+    memset( eventCounts, 0, sizeof(eventCounts) );
+}
+
+void NullMediaProvider::recordEvent( NullMediaEvent::Type type, bool video, int groupId, int streamId, int value )
+{
+    base::AutoLock l(eventLock);
+    eventCounts[type]++;
+    if (maxEvents == 0)
+    {
+        return;
+    }
+
+    NullMediaEvent event;
+    event.type = type;
+    event.video = video;
+    event.groupId = groupId;
+    event.streamId = streamId;
+    event.value = value;
+    event.when = base::TimeTicks::Now();
+    if (events.size() >= maxEvents)
+    {
+        events.pop_front();
+    }
+    events.push_back( event );
+}
+
+void NullMediaProvider::setPortRange( int start, int end )
+{
+    base::AutoLock l(portLock);
+    // RTP on even ports, RTCP on the next one.
+    startPort = start + (start & 1);
+    endPort = end;
+    nextPort = startPort;
+}
+
+int NullMediaProvider::allocatePort( int requestedPort )
+{
+    base::AutoLock l(portLock);
+    int pairs = (endPort - startPort) / 2;
+    if (pairs <= 0)
+    {
+        return 0;
+    }
+
+    if (requestedPort >= startPort && requestedPort + 1 < endPort && (requestedPort & 1) == 0 &&
+        portsInUse.find( requestedPort ) == portsInUse.end())
+    {
+        portsInUse.insert( requestedPort );
+        return requestedPort;
+    }
+
+    // Round robin, so a port just given back is the last to be reused.
+    for (int i = 0; i < pairs; i++)
+    {
+        int port = nextPort;
+        nextPort += 2;
+        if (nextPort + 1 >= endPort)
+        {
+            nextPort = startPort;
+        }
+        if (portsInUse.find( port ) == portsInUse.end())
+        {
+            portsInUse.insert( port );
+            return port;
+        }
+    }
+    return 0;
+}
+
+void NullMediaProvider::releasePort( int port )
+{
+    base::AutoLock l(portLock);
+    portsInUse.erase( port );
+}
+
+int NullMediaProvider::getPortsInUse()
+{
+    base::AutoLock l(portLock);
+    return (int) portsInUse.size();
+}
+
+} // namespace CSF
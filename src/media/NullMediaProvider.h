@@ -0,0 +1,324 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NULLMEDIAPROVIDER_H_
+#define NULLMEDIAPROVIDER_H_
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "CSFMediaProvider.h"
+#include "CSFAudioControl.h"
+#include "CSFVideoControl.h"
+#include "CSFAudioTermination.h"
+#include "CSFVideoTermination.h"
+#include "MediaBandwidthManager.h"
+#include "MediaStatsSampler.h"
+#include "MediaStreamRegistry.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+
+namespace CSF
+{
+	// A media call the null provider saw, kept so tests can check what the stack asked for.
+	struct NullMediaEvent
+	{
+		enum Type
+		{
+			RX_ALLOC, RX_OPEN, RX_START, RX_CLOSE, RX_RELEASE, TX_START, TX_CLOSE,
+			TONE_START, TONE_STOP, RING_START, RING_STOP, DTMF, MUTE, UNMUTE, VOLUME, IFRAME,
+			EVENT_TYPE_MAX
+		};
+
+		Type type;
+		bool video;
+		int groupId;
+		int streamId;
+		int value;		// port, payload type, tone, ring mode, digit or volume, depending on the type
+		base::TimeTicks when;
+	};
+
+	class NullMediaProvider;
+
+	/*
+	 * The streams of one media type. Nothing is opened: ports come from the
+	 * provider's virtual range and RTP is synthesised. A transmitting stream
+	 * "sends" one packet per packetisation period, and with loopback on a
+	 * receiving stream gets back what it sends. Counters are worked out from the
+	 * time spent in each state, so an idle stream costs nothing between calls.
+	 */
+	class NullStreamSet : public MediaStatsSource, public MediaBandwidthSource
+	{
+	public:
+		NullStreamSet( NullMediaProvider * provider, MediaStreamRegistry::MediaType type, int bytesPerSecond, int defaultPackPeriod );
+		~NullStreamSet();
+
+		int  rxAlloc( int groupId, int streamId, int requestedPort );
+		int  rxOpen( int groupId, int streamId, int requestedPort );
+		int  rxStart( int groupId, int streamId, int payloadType, int packPeriod );
+		void rxClose( int groupId, int streamId );
+		void rxRelease( int groupId, int streamId, int port );
+		int  txStart( int groupId, int streamId, int payloadType, int packPeriod );
+		void txClose( int groupId, int streamId );
+
+		bool setMuted( int streamId, bool muted );
+		bool isMuted( int streamId );
+		bool hasStream( int streamId );
+		int  getStreamCount();
+
+		// MediaStatsSource
+		bool readRtpStats( int streamId, MediaStreamStats & stats );
+
+		// MediaBandwidthSource. Defaults to the synthesised stream's rate, tests can charge what they like.
+		int  getSessionCostKbps();
+		void setSessionCostKbps( int kbps );
+
+	private:
+		struct Stream
+		{
+			int groupId;
+			int port;
+			int channel;
+			int packPeriod;
+			bool muted;
+			bool rxRunning;
+			bool txRunning;
+			base::TimeTicks updated;
+			long long rxMs;
+			long long txMs;
+		};
+
+		static void advance( Stream & stream, base::TimeTicks now, bool loopback );
+		bool isVideo() const { return type == MediaStreamRegistry::VIDEO_STREAM; }
+
+		NullMediaProvider * provider;
+		MediaStreamRegistry::MediaType type;
+		int bytesPerSecond;
+		int defaultPackPeriod;
+		int sessionCostKbps;
+		base::Lock lock;
+		std::map<int, Stream> streams;
+		int nextChannel;
+	};
+
+	class NullAudioProvider : public AudioControl, public AudioTermination
+	{
+	public:
+		NullAudioProvider( NullMediaProvider * provider );
+
+		// AudioControl
+		std::vector<std::string> getRecordingDevices();
+		std::vector<std::string> getPlayoutDevices();
+		std::string getRecordingDevice() { return NULL_DEVICE; }
+		std::string getPlayoutDevice() { return NULL_DEVICE; }
+		bool setRecordingDevice( const std::string& name ) { return name == NULL_DEVICE; }
+		bool setPlayoutDevice( const std::string& name ) { return name == NULL_DEVICE; }
+		bool setDefaultVolume( int volume );
+		int  getDefaultVolume();
+		bool setRingerVolume( int volume );
+		int  getRingerVolume();
+		void setStatsSampleInterval( int ms );
+		bool getStreamStats( int streamId, MediaStreamStats & stats );
+		std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+		bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
+		// MediaTermination
+		int  getCodecList( CodecRequestType requestType ) { return AudioCodecMask_G711 | AudioCodecMask_G722; }
+		int  rxAlloc    ( int groupId, int streamId, int requestedPort ) { return streams.rxAlloc( groupId, streamId, requestedPort ); }
+		int  rxOpen     ( int groupId, int streamId, int requestedPort, int listenIp, bool isMulticast ) { return streams.rxOpen( groupId, streamId, requestedPort ); }
+		int  rxStart    ( int groupId, int streamId, int payloadType, int packPeriod, int localPort, int rfc2833PayloadType,
+						  EncryptionAlgorithm algorithm, unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party );
+		void rxClose    ( int groupId, int streamId ) { streams.rxClose( groupId, streamId ); }
+		void rxRelease  ( int groupId, int streamId, int port ) { streams.rxRelease( groupId, streamId, port ); }
+		int  txStart    ( int groupId, int streamId, int payloadType, int packPeriod, bool vad, short tos,
+						  char* remoteIpAddr, int remotePort, int rfc2833PayloadType, EncryptionAlgorithm algorithm,
+						  unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party );
+		void txClose    ( int groupId, int streamId ) { streams.txClose( groupId, streamId ); }
+		void setLocalIP ( const char* addr ) {}
+		void setMediaPorts ( int startPort, int endPort );
+		void setDSCPValue ( int value ) {}
+		void setGroupDSCPValue ( int groupId, int value ) {}
+
+		// AudioTermination
+		int  toneStart  ( ToneType type, ToneDirection direction, int alertInfo, int groupId, int streamId, bool useBackup );
+		int  toneStop   ( ToneType type, int groupId, int streamId );
+		int  ringStart  ( int lineId, RingMode mode, bool once );
+		int  ringStop   ( int lineId );
+		int  sendDtmf   ( int streamId, int digit );
+		bool mute       ( int streamId, bool mute );
+		bool isMuted    ( int streamId ) { return streams.isMuted( streamId ); }
+		bool setVolume  ( int streamId, int volume );
+		int  getVolume  ( int streamId );
+		void setVADEnabled ( bool vadEnabled ) {}
+
+		NullStreamSet & getStreams() { return streams; }
+
+	private:
+		static const char * const NULL_DEVICE;
+
+		NullMediaProvider * provider;
+		NullStreamSet streams;
+		base::Lock lock;
+		int defaultVolume;
+		int ringerVolume;
+		std::map<int, int> volumes;
+	};
+
+	class NullVideoProvider : public VideoControl, public VideoTermination
+	{
+	public:
+		NullVideoProvider( NullMediaProvider * provider );
+
+		// VideoControl
+		void setVideoMode( bool enable ) { videoMode = enable; }
+		void setPreviewWindow( VideoWindowHandle window, int top, int left, int bottom, int right, RenderScaling style ) {}
+		void showPreviewWindow( bool show ) {}
+		std::vector<std::string> getCaptureDevices();
+		std::string getCaptureDevice() { return NULL_DEVICE; }
+		bool setCaptureDevice( const std::string& name ) { return name == NULL_DEVICE; }
+		void setStatsSampleInterval( int ms );
+		bool getStreamStats( int streamId, MediaStreamStats & stats );
+		std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+		bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
+		// MediaTermination
+		int  getCodecList( CodecRequestType requestType ) { return VideoCodecMask_H264; }
+		int  rxAlloc    ( int groupId, int streamId, int requestedPort ) { return streams.rxAlloc( groupId, streamId, requestedPort ); }
+		int  rxOpen     ( int groupId, int streamId, int requestedPort, int listenIp, bool isMulticast ) { return streams.rxOpen( groupId, streamId, requestedPort ); }
+		int  rxStart    ( int groupId, int streamId, int payloadType, int packPeriod, int localPort, int rfc2833PayloadType,
+						  EncryptionAlgorithm algorithm, unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party );
+		void rxClose    ( int groupId, int streamId ) { streams.rxClose( groupId, streamId ); }
+		void rxRelease  ( int groupId, int streamId, int port ) { streams.rxRelease( groupId, streamId, port ); }
+		int  txStart    ( int groupId, int streamId, int payloadType, int packPeriod, bool vad, short tos,
+						  char* remoteIpAddr, int remotePort, int rfc2833PayloadType, EncryptionAlgorithm algorithm,
+						  unsigned char* key, int keyLen, unsigned char* salt, int saltLen, int mode, int party );
+		void txClose    ( int groupId, int streamId ) { streams.txClose( groupId, streamId ); }
+		void setLocalIP ( const char* addr ) {}
+		void setMediaPorts ( int startPort, int endPort );
+		void setDSCPValue ( int value ) {}
+		void setGroupDSCPValue ( int groupId, int value ) {}
+
+		// VideoTermination
+		void setRemoteWindow( int streamId, VideoWindowHandle window ) {}
+		int  setExternalRenderer( int streamId, VideoFormat videoFormat, ExternalRendererHandle renderer ) { return 0; }
+		void sendIFrame ( int streamId );
+		bool mute       ( int streamId, bool mute );
+		void setAudioStreamId( int streamId ) { audioStreamId = streamId; }
+
+		NullStreamSet & getStreams() { return streams; }
+
+	private:
+		static const char * const NULL_DEVICE;
+
+		NullMediaProvider * provider;
+		NullStreamSet streams;
+		bool videoMode;
+		int audioStreamId;
+	};
+
+	/*
+	 * MediaProvider with no devices, engines or sockets, for running the signalling
+	 * stack on machines without a sound card and for loading it with many calls.
+	 *
+	 * MediaProvider::create() returns one when the tree is built with CSF_NULL_MEDIA
+	 * or when CSF_MEDIA_PROVIDER=null is set in the environment. Loopback starts
+	 * on if CSF_NULL_MEDIA_LOOPBACK=1 is set.
+	 */
+	class NullMediaProvider : public MediaProvider
+	{
+		friend class MediaProvider;
+
+	public:
+		// The live provider, or NULL.
+		static NullMediaProvider * getInstance();
+		static bool isSelected();
+
+		int init();
+		void shutdown();
+
+		AudioControl* getAudioControl() { return &audio; }
+		VideoControl* getVideoControl() { return &video; }
+		AudioTermination* getAudioTermination() { return &audio; }
+		VideoTermination* getVideoTermination() { return &video; }
+		void addMediaProviderObserver( MediaProviderObserver* observer ) {}
+
+		void setLoopback( bool enable );
+		bool getLoopback();
+
+		// 0 keeps only the per-type counts.
+		void setMaxEvents( size_t max );
+		std::vector<NullMediaEvent> getEvents();
+		unsigned int getEventCount( NullMediaEvent::Type type );
+		void clearEvents();
+		void recordEvent( NullMediaEvent::Type type, bool video, int groupId, int streamId, int value );
+
+		// Virtual RTP port pairs shared by audio and video; 0 when the range is used up.
+		void setPortRange( int startPort, int endPort );
+		int allocatePort( int requestedPort );
+		void releasePort( int port );
+		int getPortsInUse();
+
+	protected:
+		NullMediaProvider();
+		~NullMediaProvider();
+
+	private:
+		static NullMediaProvider * _pSelf;
+
+		NullAudioProvider audio;
+		NullVideoProvider video;
+
+		base::Lock eventLock;
+		bool loopback;
+		size_t maxEvents;
+		std::deque<NullMediaEvent> events;
+		unsigned int eventCounts[NullMediaEvent::EVENT_TYPE_MAX];
+
+		base::Lock portLock;
+		int startPort;
+		int endPort;
+		int nextPort;
+		std::set<int> portsInUse;
+	};
+
+} // namespace
+
+#endif /* NULLMEDIAPROVIDER_H_ */
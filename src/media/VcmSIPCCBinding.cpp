@@ -42,13 +42,17 @@
 #include "CSFLogStream.h"
 
 #include "CSFMediaProvider.h"
+#include "CSFAudioControl.h"
+#include "CSFVideoControl.h"
 #include "CSFAudioTermination.h"
 #include "CSFVideoTermination.h"
 #include "VcmSIPCCBinding.h"
+#include "MediaBandwidthManager.h"
 #include "csf_common.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 extern "C" {
 #include "ccsdp.h"
@@ -213,6 +217,36 @@ VideoControl * VcmSIPCCBinding::getVideoControl()
 #define VCM_DEFAULT_RINGER_VOLUME 80
 #define VCM_VOLUME_ADJUST_LEVEL   8
 
+// The sampler's summary covers the whole stream; without one (sampling off) the engine
+// counters are read once and the duration is unknown.
+template <class Control>
+static bool getStreamSummary( Control * control, int streamId, MediaStreamSummary & summary )
+{
+    if ( control == NULL )
+    {
+        return false;
+    }
+    if ( control->getStreamSummary( streamId, summary ) )
+    {
+        return true;
+    }
+
+    MediaStreamStats stats;
+    if ( !control->getStreamStats( streamId, stats ) )
+    {
+        return false;
+    }
+    memset( &summary, 0, sizeof(summary) );
+    summary.streamId = streamId;
+    summary.packetsReceived = stats.packetsReceived;
+    summary.bytesReceived = stats.bytesReceived;
+    summary.packetsLost = stats.packetsLost;
+    summary.packetsSent = stats.packetsSent;
+    summary.bytesSent = stats.bytesSent;
+    summary.avgJitterMs = stats.jitterMs;
+    return true;
+}
+
 
 extern "C" {
 
@@ -1258,6 +1292,23 @@ int vcmGetRtpStats(cc_mcapid_t mcap_id,
         char *rx_stats,
         char *tx_stats)
 {
+    MediaStreamSummary summary;
+    bool haveSummary = CC_IS_VIDEO(mcap_id) ?
+            getStreamSummary( VcmSIPCCBinding::getVideoControl(), stream_id, summary ) :
+            getStreamSummary( VcmSIPCCBinding::getAudioControl(), stream_id, summary );
+
+    if ( !haveSummary )
+    {
+        CSFLogDebugS( logTag, "vcmGetRtpStats: no statistics for stream " << stream_id );
+        return 0;
+    }
+
+    // Format as described in vcm.h; late packets are not counted separately by the engine.
+    csf_sprintf( rx_stats, CC_KFACTOR_STAT_LEN, "Dur=%d,Pkt=%u,Oct=%u,LatePkt=%d,LostPkt=%u,AvgJit=%d,VQMetrics=\"\"",
+                 summary.durationMs / 1000, summary.packetsReceived, summary.bytesReceived, 0,
+                 summary.packetsLost, summary.avgJitterMs );
+    csf_sprintf( tx_stats, CC_KFACTOR_STAT_LEN, "Dur=%d,Pkt=%u,Oct=%u",
+                 summary.durationMs / 1000, summary.packetsSent, summary.bytesSent );
     return 0;
 }
 
@@ -1272,39 +1323,42 @@ int vcmGetRtpStats(cc_mcapid_t mcap_id,
 
 void vcmSetRtcpDscp(cc_groupid_t group_id, int dscp)
 {
-    // do nothing
+    CSFLogDebug( logTag, "vcmSetRtcpDscp(): group_id=%d, dscp=%d", group_id, dscp);
+
+    // RTP and RTCP share a socket pair per stream, so this marks both
+    if ( VcmSIPCCBinding::getAudioTermination() != NULL )
+        VcmSIPCCBinding::getAudioTermination()->setGroupDSCPValue( group_id, dscp );
+    if ( VcmSIPCCBinding::getVideoTermination() != NULL )
+        VcmSIPCCBinding::getVideoTermination()->setGroupDSCPValue( group_id, dscp );
 }
 
 /**
  *
- * The wlan interface puts into unique situation where call control
- * has to allocate the worst case bandwith before creating a
- * inbound or outbound call. The function call will interface through
- * media API into wlan to get the call bandwidth. The function
- * return is asynchronous and will block till the return media
- * callback signals to continue the execution.
+ * Call control allocates the worst case bandwidth before creating an
+ * inbound or outbound call. The reservation is made against the
+ * budget of the active local address in MediaBandwidthManager, from
+ * the per session cost of the audio and video providers.
  *
- * @note If not using WLAN interface simply return true
+ * @note Reservations are keyed by call id: the line in the handle is
+ * not known yet when fsmcac asks, but is by the time the call ends.
  *
  * @return true if the bandwidth can be allocated else false.
  */
 
 cc_boolean vcmAllocateBandwidth(cc_call_handle_t  call_handle, int sessions)
 {
-    return(TRUE);
+    return MediaBandwidthManager::getInstance()->reserve(GET_CALL_ID(call_handle), sessions) ? TRUE : FALSE;
 }
 
 /**
  *
  * Free the bandwidth allocated for this call
  * using the vcmAllocateBandwidth API
- *
- * @note  If not using WLAN provide a stub
  */
 
 void vcmRemoveBandwidth(cc_call_handle_t  call_handle)
 {
-    //do nothing
+    MediaBandwidthManager::getInstance()->release(GET_CALL_ID(call_handle));
 }
 
 /**
@@ -43,6 +43,7 @@
 #include "WebrtcLogging.h"
 
 #include "WebrtcAudioCodecSelector.h"
+#include "MediaBandwidthManager.h"
 #include "voe_codec.h"
 #include "csf_common.h"
 
@@ -390,4 +391,28 @@ int WebrtcAudioCodecSelector::setReceive(int channel, const webrtc::CodecInst& c
     return 0;
 }
 
+int WebrtcAudioCodecSelector::getMaxSessionKbps()
+{
+    int maxKbps = 0;
+
+    std::map<int, webrtc::CodecInst*>::iterator iterVoeCodecs;
+    for( iterVoeCodecs = codecMap.begin(); iterVoeCodecs != codecMap.end(); ++iterVoeCodecs )
+    {
+        webrtc::CodecInst* codec = iterVoeCodecs->second;
+
+        // select() leaves empty entries for payloads it was asked about, and telephone events ride in the audio packets
+        if (codec == NULL || iterVoeCodecs->first == AudioPayloadType_RFC2833 || codec->pacsize <= 0)
+        {
+            continue;
+        }
+
+        int kbps = MediaBandwidthManager::addPacketOverhead( codec->rate / 1000, codec->plfreq / codec->pacsize );
+        if (kbps > maxKbps)
+        {
+            maxKbps = kbps;
+        }
+    }
+    return maxKbps;
+}
+
 #endif
@@ -97,6 +97,9 @@ public:
 	// return 0 if codec could be applied
 	int setReceive(int channel, const webrtc::CodecInst& codec);
 
+	// the most one call's audio can take on the wire over the mapped codecs, in kbps
+	int getMaxSessionKbps();
+
 private:
 	// the reference to the GIPS Codec sub-interface
 	webrtc::VoECodec* voeCodec;
@@ -43,12 +43,15 @@
 
 #include "string.h"
 #include <stdio.h>
+#include <vector>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
 #include "WebrtcMediaProvider.h"
 #include "WebrtcAudioProvider.h"
+#include "MediaPortAllocator.h"
+#include "MediaStreamRegistry.h"
 #include "WebrtcToneGenerator.h"
 #include "WebrtcRingGenerator.h"
 #include "voe_file.h"
@@ -79,15 +82,17 @@ bool IsVistaOrNewer();
 
 class WebrtcAudioStream {
 public:
-	WebrtcAudioStream(int _streamId, int _channelId):
-		streamId(_streamId), channelId(_channelId),
-		isRxStarted(false), isTxStarted(false), isAlive(false)
+	WebrtcAudioStream(int _groupId, int _streamId, int _channelId):
+		groupId(_groupId), streamId(_streamId), channelId(_channelId),
+		isRxStarted(false), isTxStarted(false), isAlive(false), DSCPValue(-1)
 		{}
+	int groupId;
 	int streamId;
 	int channelId;
 	bool isRxStarted;
 	bool isTxStarted;
 	bool isAlive;
+	int DSCPValue;	// set per call by setGroupDSCPValue, -1 to use the provider's value
 };
 
 WebrtcAudioProvider::WebrtcAudioProvider( WebrtcMediaProvider* provider )
@@ -101,6 +106,7 @@ WebrtcAudioProvider::WebrtcAudioProvider( WebrtcMediaProvider* provider )
   voeVolumeControl(NULL), 
   voeVoiceQuality(NULL), 
   voeEncryption(NULL),
+  voeRtpRtcp(NULL),
   toneGen(NULL), 
   ringGen(NULL), 
   startPort(1024), 
@@ -155,14 +161,16 @@ int WebrtcAudioProvider::init()
 	voeVolumeControl = webrtc::VoEVolumeControl::GetInterface( voeVoice );
 	voeVoiceQuality = webrtc::VoEAudioProcessing::GetInterface( voeVoice );
     voeEncryption = webrtc::VoEEncryption::GetInterface(voeVoice);
+    voeRtpRtcp = webrtc::VoERTP_RTCP::GetInterface(voeVoice);
 
-	if ((!voeDTMF) || (!voeFile) || (!voeHw) ||(!voeNetwork) || (!voeVolumeControl) || (!voeVoiceQuality) || (!voeEncryption)) {
-		LOG_WEBRTC_ERROR( logTag, "WebrtcAudioProvider(): voeVE_GetInterface failed voeDTMF=%p voeFile=%p voeHw=%p voeNetwork=%p voeVolumeControl=%p voeVoiceQuality=%p voeEncryption=%p",
-		voeDTMF,voeFile,voeHw,voeNetwork,voeVolumeControl,voeVoiceQuality,voeEncryption);
+	if ((!voeDTMF) || (!voeFile) || (!voeHw) ||(!voeNetwork) || (!voeVolumeControl) || (!voeVoiceQuality) || (!voeEncryption) || (!voeRtpRtcp)) {
+		LOG_WEBRTC_ERROR( logTag, "WebrtcAudioProvider(): voeVE_GetInterface failed voeDTMF=%p voeFile=%p voeHw=%p voeNetwork=%p voeVolumeControl=%p voeVoiceQuality=%p voeEncryption=%p voeRtpRtcp=%p",
+		voeDTMF,voeFile,voeHw,voeNetwork,voeVolumeControl,voeVoiceQuality,voeEncryption,voeRtpRtcp);
 		return -1;
 	}
 
 	codecSelector.init(voeVoice, false, true);
+	MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::AUDIO_STREAM, this );
 	voeBase->Init();
 
 	localRingChannel = voeBase->CreateChannel();
@@ -219,6 +227,9 @@ WebrtcAudioProvider::~WebrtcAudioProvider() {
 
 	int num_ifs=0;
 	stopping = true;
+	// the sampler thread reads the engine, so it has to be gone first
+	MediaStatsSampler::getInstance()->setIntervalMs( 0 );
+	MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::AUDIO_STREAM, NULL );
 	// tear down in reverse order, for symmetry
 	codecSelector.release();
 
@@ -244,6 +255,8 @@ WebrtcAudioProvider::~WebrtcAudioProvider() {
 		LOG_WEBRTC_ERROR( logTag, "~WebrtcAudioProvider(): voeVoiceQuality->Release() failed, num_ifs left= %d ",num_ifs );
     if((num_ifs=voeEncryption->Release())!=0)
         LOG_WEBRTC_ERROR( logTag, "~WebrtcAudioProvider(): voeEncryption->Release() failed, num_ifs left= %d ",num_ifs );
+    if((num_ifs=voeRtpRtcp->Release())!=0)
+        LOG_WEBRTC_ERROR( logTag, "~WebrtcAudioProvider(): voeRtpRtcp->Release() failed, num_ifs left= %d ",num_ifs );
 	if(webrtc::VoiceEngine::Delete( voeVoice, true ) == false)
 		LOG_WEBRTC_ERROR( logTag, "~WebrtcAudioProvider(): voeVoiceEngine::Delete failed" );
 
@@ -387,13 +400,10 @@ bool WebrtcAudioProvider::setPlayoutDevice( const std::string& device ) {
 }
 
 WebrtcAudioStreamPtr WebrtcAudioProvider::getStreamByChannel( int channel ) {
-	base::AutoLock lock(streamMapMutex);
-	for( std::map<int, WebrtcAudioStreamPtr>::const_iterator it = streamMap.begin(); it != streamMap.end(); it++ ) {
-		WebrtcAudioStreamPtr stream = it->second;
-		if(stream->channelId == channel)
-			return stream;
-	}
-	return WebrtcAudioStreamPtr();
+	MediaStreamRegistry::Entry entry;
+	if ( !MediaStreamRegistry::getInstance()->findByChannel( MediaStreamRegistry::AUDIO_STREAM, channel, entry ) )
+		return WebrtcAudioStreamPtr();
+	return getStream( entry.streamId );
 }
 
 WebrtcAudioStreamPtr WebrtcAudioProvider::getStream( int streamId ) {
@@ -403,8 +413,47 @@ WebrtcAudioStreamPtr WebrtcAudioProvider::getStream( int streamId ) {
 }
 
 int WebrtcAudioProvider::getChannelForStreamId( int streamId ) {
-	WebrtcAudioStreamPtr stream = getStream(streamId);
-	return ( stream != NULL ) ? stream->channelId : -1;
+	return MediaStreamRegistry::getInstance()->channelForStream( MediaStreamRegistry::AUDIO_STREAM, streamId );
+}
+
+void WebrtcAudioProvider::setSendTOS( int channel, int dscp ) {
+	unsigned char dscpSixBit = dscp>>2;
+#ifdef WIN32
+	if (IsVistaOrNewer()) {
+		LOG_WEBRTC_DEBUG( logTag, "Vista or later");
+		if(voeNetwork->SetSendTOS(channel, dscpSixBit, false ) == -1) {
+			LOG_WEBRTC_DEBUG( logTag, "openIngressChannel():voeVE_SetSendTOS() returned error");
+		}
+		LOG_WEBRTC_DEBUG( logTag, " Wrapper::openIngressChannel:- voeVE_SetSendTOS(), useSetSockOpt = false");
+	}
+	else {
+		if(voeNetwork->SetSendTOS(channel, dscpSixBit, true ) == -1) {
+			LOG_WEBRTC_DEBUG( logTag, "openIngressChannel():voeVE_SetSendTOS() returned error");
+		}
+		LOG_WEBRTC_DEBUG( logTag, "Wrapper::openIngressChannel:- voeVE_SetSendTOS(), useSetSockOpt = true");
+	}
+#else
+	voeNetwork->SetSendTOS(channel, dscpSixBit, -1, true );
+#endif
+}
+
+void WebrtcAudioProvider::setGroupDSCPValue( int groupId, int value ) {
+	base::AutoLock lock(m_lock);
+	LOG_WEBRTC_INFO( logTag, "setGroupDSCPValue: groupId=%d, dscp=%d", groupId, value );
+	std::vector<WebrtcAudioStreamPtr> streams;
+	{
+		base::AutoLock lock(streamMapMutex);
+		for( std::map<int, WebrtcAudioStreamPtr>::const_iterator it = streamMap.begin(); it != streamMap.end(); it++ ) {
+			if ( it->second->groupId == groupId )
+				streams.push_back( it->second );
+		}
+	}
+	// streams not sending yet pick the value up in txStart
+	for( std::vector<WebrtcAudioStreamPtr>::const_iterator it = streams.begin(); it != streams.end(); it++ ) {
+		(*it)->DSCPValue = value;
+		if ( (*it)->isTxStarted )
+			setSendTOS( (*it)->channelId, value );
+	}
 }
 
 int WebrtcAudioProvider::getCodecList( CodecRequestType requestType ) {
@@ -423,23 +472,16 @@ int WebrtcAudioProvider::rxAlloc( int groupId, int streamId, int requestedPort )
 	LOG_WEBRTC_DEBUG( logTag, "rxAllocAudio: Created channel %d", channel );
 	voeNetwork->SetPeriodicDeadOrAliveStatus(channel, true);
 
-	int beginPort;		// where we started
-	int tryPort;		// where we are now
-
-	if ( requestedPort == 0  || requestedPort < startPort || requestedPort >= endPort )
-		tryPort = startPort;
-	else
-		tryPort = requestedPort;
-
-	beginPort = tryPort;
-
 	const char * pLocalAddr = NULL;
 
 	if (localIP.size() > 0) {
 		pLocalAddr = localIP.c_str();
 	}
 
-	do {
+	MediaPortAllocator * ports = MediaPortAllocator::getInstance();
+	int tryPort = ports->allocate( requestedPort );
+
+	while ( tryPort != 0 ) {
 		if ( voeBase->SetLocalReceiver( channel, tryPort, webrtc::kVoEDefault, pLocalAddr ) == 0 ) {
 			int port, RTCPport;
 			char ipaddr[64];
@@ -449,10 +491,12 @@ int WebrtcAudioProvider::rxAlloc( int groupId, int streamId, int requestedPort )
 			localIP = ipaddr;
 			LOG_WEBRTC_DEBUG( logTag, "rxAllocAudio: IPAddr: %d", ipaddr );
 			LOG_WEBRTC_DEBUG( logTag, "rxAllocAudio: Allocated port %d", tryPort );
-			WebrtcAudioStreamPtr stream(new WebrtcAudioStream(streamId, channel)); {
+			WebrtcAudioStreamPtr stream(new WebrtcAudioStream(groupId, streamId, channel)); {
 				base::AutoLock lock(streamMapMutex);
 				streamMap[streamId] = stream;
 			}
+			MediaStreamRegistry::getInstance()->addStream( MediaStreamRegistry::AUDIO_STREAM, streamId, channel );
+			MediaStatsSampler::getInstance()->addStream( MediaStreamRegistry::AUDIO_STREAM, streamId, this );
 			setVolume(streamId, defaultVolume);
 			return tryPort;
 		}
@@ -461,17 +505,17 @@ int WebrtcAudioProvider::rxAlloc( int groupId, int streamId, int requestedPort )
 		if ( errCode == VE_SOCKET_ERROR ||			
 			 errCode == VE_BINDING_SOCKET_TO_LOCAL_ADDRESS_FAILED ||
 			errCode == VE_RTCP_SOCKET_ERROR ) {
-	        tryPort += 2;
-	        if ( tryPort >= endPort )
-	        	tryPort = startPort;
+			// someone else has this pair, back off from it and take the next free one
+			ports->markUnavailable( tryPort );
+			tryPort = ports->allocate( 0 );
         }
 		else {
 			LOG_WEBRTC_ERROR( logTag, "rxAllocAudio: SetLocalReceiver returned error %d", errCode );
+			ports->cancel( tryPort );
 			voeBase->DeleteChannel( channel );
 			return 0;
 		}
 	}
-	while ( tryPort != beginPort );
 
 	LOG_WEBRTC_WARN( logTag, "rxAllocAudio: No ports available?" );
 	voeBase->DeleteChannel( channel );
@@ -591,12 +635,15 @@ void WebrtcAudioProvider::rxRelease( int groupId, int streamId, int port )
 	LOG_WEBRTC_INFO( logTag, "rxReleaseAudio: groupId=%d, streamId=%d", groupId, streamId );
 	int channel = getChannelForStreamId( streamId );
 	if ( channel >= 0 ) {
+		MediaStatsSampler::getInstance()->removeStream( MediaStreamRegistry::AUDIO_STREAM, streamId );
+		MediaStreamRegistry::getInstance()->removeStream( MediaStreamRegistry::AUDIO_STREAM, streamId );
 		voeBase->StopReceive( channel );
 		voeBase->DeleteChannel( channel ); {
 			base::AutoLock lock(streamMapMutex);
 			streamMap.erase(streamId);
 		}
 		LOG_WEBRTC_DEBUG( logTag, "rxReleaseAudio: Delete channel %d, release port %d", channel, port);
+		MediaPortAllocator::getInstance()->release( port );
 	}
 	else {
 		LOG_WEBRTC_ERROR( logTag, "rxReleaseAudio: getChannelForStreamId failed streamId %d",streamId );
@@ -668,27 +715,10 @@ int WebrtcAudioProvider::txStart( int groupId, int streamId, int payloadType, in
             }  
         }
 
-        unsigned char dscpSixBit = DSCPValue>>2;
 		voeBase->SetSendDestination( channel, remotePort, remoteIpAddr );
-#ifdef WIN32
-		if (IsVistaOrNewer()) {
-			LOG_WEBRTC_DEBUG( logTag, "Vista or later");
-			if(voeNetwork->SetSendTOS(channel, dscpSixBit, false ) == -1) {
-				LOG_WEBRTC_DEBUG( logTag, "openIngressChannel():voeVE_SetSendTOS() returned error");
-			}
-			LOG_WEBRTC_DEBUG( logTag, " Wrapper::openIngressChannel:- voeVE_SetSendTOS(), useSetSockOpt = false");
-		}
-		else {
-			if(voeNetwork->SetSendTOS(channel, dscpSixBit, true ) == -1) {
-				LOG_WEBRTC_DEBUG( logTag, "openIngressChannel():voeVE_SetSendTOS() returned error");
-			}
-			LOG_WEBRTC_DEBUG( logTag, "Wrapper::openIngressChannel:- voeVE_SetSendTOS(), useSetSockOpt = true");
-		}
-#else
-		voeNetwork->SetSendTOS(channel, dscpSixBit, -1, true );
-#endif
-		voeBase->StartSend( channel );
 		WebrtcAudioStreamPtr stream = getStream(streamId);
+		setSendTOS( channel, ( stream != NULL && stream->DSCPValue >= 0 ) ? stream->DSCPValue : DSCPValue );
+		voeBase->StartSend( channel );
 		if(stream != NULL)
 			stream->isTxStarted = true;
 		LOG_WEBRTC_DEBUG( logTag, "txStartAudio: Sending to %s:%d on channel %d", remoteIpAddr, remotePort, channel );
@@ -850,6 +880,61 @@ int WebrtcAudioProvider::getRingerVolume() {
     return ringerVolume;
 }
 
+void WebrtcAudioProvider::setStatsSampleInterval( int ms ) {
+	MediaStatsSampler::getInstance()->setIntervalMs( ms );
+}
+
+bool WebrtcAudioProvider::getStreamStats( int streamId, MediaStreamStats & stats ) {
+	if ( MediaStatsSampler::getInstance()->getLatest( MediaStreamRegistry::AUDIO_STREAM, streamId, stats ) ) {
+		return true;
+	}
+	// not sampled, read the engine directly (no rates or timing then)
+	memset( &stats, 0, sizeof(stats) );
+	stats.streamId = streamId;
+	return readRtpStats( streamId, stats );
+}
+
+std::vector<MediaStreamStats> WebrtcAudioProvider::getStreamStatsHistory( int streamId ) {
+	return MediaStatsSampler::getInstance()->getHistory( MediaStreamRegistry::AUDIO_STREAM, streamId );
+}
+
+bool WebrtcAudioProvider::getStreamSummary( int streamId, MediaStreamSummary & summary ) {
+	return MediaStatsSampler::getInstance()->getSummary( MediaStreamRegistry::AUDIO_STREAM, streamId, summary );
+}
+
+// Called from the sampler thread, so no provider locks; the channel comes from the stream registry.
+bool WebrtcAudioProvider::readRtpStats( int streamId, MediaStreamStats & stats ) {
+	int channel = getChannelForStreamId( streamId );
+	if ( channel < 0 || voeRtpRtcp == NULL ) {
+		return false;
+	}
+
+	webrtc::CallStatistics callStats;
+	if ( voeRtpRtcp->GetRTCPStatistics( channel, callStats ) != 0 ) {
+		LOG_WEBRTC_DEBUG( logTag, "readRtpStats: GetRTCPStatistics failed on channel %d, error %d", channel, voeBase->LastError() );
+		return false;
+	}
+	unsigned int averageJitterMs = 0;
+	unsigned int maxJitterMs = 0;
+	unsigned int discardedPackets = 0;
+	voeRtpRtcp->GetRTPStatistics( channel, averageJitterMs, maxJitterMs, discardedPackets );
+
+	stats.packetsReceived = callStats.packetsReceived;
+	stats.bytesReceived = callStats.bytesReceived;
+	stats.packetsLost = callStats.cumulativeLost;
+	stats.packetsSent = callStats.packetsSent;
+	stats.bytesSent = callStats.bytesSent;
+	stats.fractionLost = callStats.fractionLost;
+	stats.jitterMs = averageJitterMs;
+	stats.rttMs = callStats.rttMs;
+	return true;
+}
+
+// Called from the GSM thread during admission; the codec map is only written by init and the destructor.
+int WebrtcAudioProvider::getSessionCostKbps() {
+	return codecSelector.getMaxSessionKbps();
+}
+
 bool WebrtcAudioProvider::setVolume( int streamId, int volume ) {
 	LOG_WEBRTC_INFO( logTag, "setVolume: streamId=%d, volume=%d", streamId, volume );
 	int channel = getChannelForStreamId( streamId );
@@ -55,9 +55,13 @@
 #include "voe_audio_processing.h"
 #include "voe_volume_control.h"
 #include "voe_encryption.h"
+#include "voe_rtp_rtcp.h"
 #include <string>
 #include <map>
 #include "base/synchronization/lock.h"
+#include "MediaPortAllocator.h"
+#include "MediaStatsSampler.h"
+#include "MediaBandwidthManager.h"
 
 
 namespace CSF
@@ -69,7 +73,7 @@ namespace CSF
     class WebrtcVideoProvider;
     DECLARE_PTR(WebrtcAudioStream);
 
-    class WebrtcAudioProvider : public AudioControl, AudioTermination, webrtc::VoiceEngineObserver,
+    class WebrtcAudioProvider : public AudioControl, AudioTermination, MediaStatsSource, MediaBandwidthSource, webrtc::VoiceEngineObserver,
             webrtc::VoEConnectionObserver
             ,webrtc::TraceCallback {
     friend class WebrtcVideoProvider;
@@ -106,6 +110,17 @@ namespace CSF
         bool setVolume( int streamId, int volume );
         int  getVolume( int streamId );
 
+        void setStatsSampleInterval( int ms );
+        bool getStreamStats( int streamId, MediaStreamStats & stats );
+        std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+        bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
+        // MediaStatsSource
+        bool readRtpStats( int streamId, MediaStreamStats & stats );
+
+        // MediaBandwidthSource
+        int getSessionCostKbps();
+
         AudioTermination * getAudioTermination() { return this; }
 
         int  getCodecList( CodecRequestType requestType );
@@ -129,8 +144,9 @@ namespace CSF
         int  sendDtmf    ( int streamId, int digit);
         bool  mute        ( int streamId, bool mute );
         bool isMuted    ( int streamId );
-        void setMediaPorts( int startPort, int endPort ) { this->startPort = startPort; this->endPort = endPort; }
+        void setMediaPorts( int startPort, int endPort ) { this->startPort = startPort; this->endPort = endPort; MediaPortAllocator::getInstance()->setRange( startPort, endPort ); }
         void setDSCPValue (int value){this->DSCPValue = value;}
+        void setGroupDSCPValue (int groupId, int value);
         void setVADEnabled(bool VADEnabled){this->VADEnabled = VADEnabled;}
 
         // used by video, for lip sync
@@ -146,6 +162,7 @@ namespace CSF
         int getChannelForStreamId( int streamId );
         WebrtcAudioStreamPtr getStream( int streamId );
         WebrtcAudioStreamPtr getStreamByChannel( int channelId );
+        void setSendTOS( int channel, int dscp );
 
     private:
         WebrtcMediaProvider* provider;
@@ -158,6 +175,7 @@ namespace CSF
         webrtc::VoEVolumeControl* voeVolumeControl;
         webrtc::VoEAudioProcessing* voeVoiceQuality; 
         webrtc::VoEEncryption* voeEncryption;
+        webrtc::VoERTP_RTCP* voeRtpRtcp;
         int localToneChannel;
         int localRingChannel;
         std::string recordingDevice;
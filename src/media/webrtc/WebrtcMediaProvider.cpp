@@ -51,6 +51,7 @@
 #include "WebrtcVideoProvider.h"
 #endif
 #include "WebrtcLogging.h"
+#include "NullMediaProvider.h"
 
 using namespace std;
 
@@ -80,6 +81,13 @@ MediaProvider * MediaProvider::create( )
 {
     LOG_WEBRTC_DEBUG( logTag, "MediaProvider::create");
 
+    if ( NullMediaProvider::isSelected() )
+    {
+        NullMediaProvider* nullProvider = new NullMediaProvider();
+        nullProvider->init();
+        return nullProvider;
+    }
+
     WebrtcMediaProvider* mediaProvider = new WebrtcMediaProvider();
     LOG_WEBRTC_DEBUG( logTag, "MediaProvider::create new instance");
 
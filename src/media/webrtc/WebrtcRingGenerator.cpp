@@ -39,7 +39,6 @@
 
 #ifndef _USE_CPVE
 
-#include <string.h>
 #include "WebrtcRingGenerator.h"
 
 namespace CSF {
@@ -88,12 +87,7 @@ typedef struct
 
 } RingCadence;
 
-#ifndef min
-#define min(a, b)  (((a) < (b)) ? (a) : (b))
-#endif
-
 #define MILLIS_TO_SAMPLES(millis)	((millis) * (8000/1000))
-#define SAMPLES_TO_MILLIS(samples)	((samples) / (8000/1000))
 
 #define SILENCE NULL
 
@@ -198,11 +192,8 @@ static RingCadence* CadenceTable[] =
 
 // ----------------------------------------------------------------------------
 WebrtcRingGenerator::WebrtcRingGenerator( RingMode mode, bool once )
-: mode(mode), once(once), currentStep(0), done(false), scaleFactor(100)
+: cursor( WebrtcToneCache::getInstance()->getRing( mode ), once ), scaleFactor(100)
 {
-	timeRemaining = CadenceTable[mode]->stepDuration;
-	// if sole entry is empty (FLASHONLY_RING case), generate no samples
-	if ( timeRemaining == 0 ) done = true;
 }
 
 void WebrtcRingGenerator::SetScaleFactor(int scaleFactor)
@@ -210,70 +201,28 @@ void WebrtcRingGenerator::SetScaleFactor(int scaleFactor)
 	this->scaleFactor = scaleFactor;
 }
 
-// Webrtc InStream implementation
-int WebrtcRingGenerator::Read( void *buf, int len /* bytes */ )
+// The ring samples are static PCM already, so the steps point at them rather than copies.
+void WebrtcRingGenerator::render( RingMode mode, PcmSequence& sequence )
 {
-	int result = generateTone( (short *)buf, len/sizeof(short) );
-	applyScaleFactor( (short *)buf, len/sizeof(short) );
-	return result;
-}
+	RingCadence* step = CadenceTable[mode];
+	bool noSilence = false;
 
-int WebrtcRingGenerator::generateTone( short *buf, int numSamples )
-{
-	RingCadence* cadence = CadenceTable[mode];
-	int samplesGenerated = 0;
-
-	while ( !done && samplesGenerated < numSamples )
+	for ( ; step->stepDuration != 0; step++ )
 	{
-		RingCadence* step = &cadence[currentStep];
-
-		int samplesToCopy = min( numSamples, MILLIS_TO_SAMPLES(timeRemaining) );
-		if ( step->samples != SILENCE )
-		{
-			int elapsedSamples = MILLIS_TO_SAMPLES(step->stepDuration - timeRemaining);
-			int sampleOffset = elapsedSamples % step->sampleCnt;
-			int samplesRemaining = step->sampleCnt - sampleOffset;
-
-			if ( samplesRemaining < samplesToCopy )
-				samplesToCopy = samplesRemaining;
-
-			memcpy( buf, &step->samples[sampleOffset], samplesToCopy*sizeof(short) );
-		}
-		else
-		{
-			memset( buf, 0, samplesToCopy*sizeof(short) );
-		}
-		samplesGenerated += samplesToCopy;
-		timeRemaining -= SAMPLES_TO_MILLIS(samplesToCopy);
-
-		if ( timeRemaining <= 0 )
-		{
-			// if there's no SILENCE at the end of a sequence, it's a one-shot
-			bool noSilence = (step->samples != SILENCE);
-
-			step = &cadence[++currentStep];
-			if ( step->stepDuration == 0 )	// end of sequence, start over
-			{
-				step = cadence;
-				currentStep = 0;
-
-				if ( once || noSilence )	// one-shot
-				{
-					done = true;
-				}
-			}
-			timeRemaining = step->stepDuration;
-		}
+		sequence.addStep( step->samples, step->sampleCnt, MILLIS_TO_SAMPLES(step->stepDuration) );
+		noSilence = (step->samples != SILENCE);
 	}
-	return samplesGenerated * sizeof(short);
+
+	// if there's no SILENCE at the end of a sequence, it's a one-shot
+	sequence.repeatCount = noSilence ? 0 : PCM_REPEAT_FOREVER;
 }
 
-void WebrtcRingGenerator::applyScaleFactor( short *buf, int numSamples )
+// Webrtc InStream implementation
+int WebrtcRingGenerator::Read( void *buf, int len /* bytes */ )
 {
-	for(int i = 0; i < numSamples; i++)
-	{
-		buf[i] = (short)((buf[i] * scaleFactor)/100);
-	}
+	int samples = cursor.read( (short *)buf, len/sizeof(short) );
+	WebrtcToneCache::scaleSamples( (short *)buf, samples, scaleFactor );
+	return samples * sizeof(short);
 }
 
 } // namespace CSF
@@ -44,6 +44,7 @@
 
 #include <CSFAudioTermination.h>
 #include "common_types.h"
+#include "WebrtcToneCache.h"
 
 namespace CSF {
 
@@ -56,16 +57,12 @@ namespace CSF {
 		int Read( void *buf, int len );
 		void SetScaleFactor(int scaleFactor); // 0-100
 
+		// Builds the cadence for WebrtcToneCache.
+		static void render( RingMode mode, PcmSequence& sequence );
+
 	private:
-		RingMode mode;
-		bool once;
-		int currentStep;
-		int timeRemaining;	// in current step
-		bool done;
+		PcmCursor cursor;
 		int scaleFactor;
-
-		int generateTone( short *buf, int numSamples );
-		void applyScaleFactor( short *buf, int numSamples );
 	};
 
 } // namespace CSF
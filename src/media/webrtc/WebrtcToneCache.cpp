@@ -0,0 +1,232 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _USE_CPVE
+
+#include <string.h>
+#include "WebrtcToneCache.h"
+#include "WebrtcToneGenerator.h"
+#include "WebrtcRingGenerator.h"
+
+/*
+ * The SSE2 path needs the intrinsics without extra compiler flags, which
+ * holds for MSVC and for gcc/clang targets that enable SSE2 by default.
+ */
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || \
+	(defined(__GNUC__) && defined(__SSE2__))
+#define TONECACHE_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace CSF {
+
+// ----------------------------------------------------------------------------
+const short* PcmSequence::store( const short* samples, int sampleCnt )
+{
+	pcm.push_back( std::vector<short>( samples, samples + sampleCnt ) );
+	return &pcm.back()[0];
+}
+
+void PcmSequence::addStep( const short* samples, int sampleCnt, int duration )
+{
+	PcmStep step = { samples, sampleCnt, duration };
+	steps.push_back( step );
+}
+
+// ----------------------------------------------------------------------------
+PcmCursor::PcmCursor( const PcmSequence* sequence, bool once )
+: sequence(sequence), step(0), position(0)
+{
+	passesLeft = once ? 0 : sequence->repeatCount;
+	// FLASHONLY_RING has no steps at all, it generates no samples
+	done = sequence->steps.empty();
+}
+
+int PcmCursor::read( short* dst, int numSamples )
+{
+	int samplesRead = 0;
+
+	while ( !done && samplesRead < numSamples )
+	{
+		const PcmStep& current = sequence->steps[step];
+
+		int count = numSamples - samplesRead;
+		if ( current.duration != PCM_CONTINUOUS && current.duration - position < count )
+		{
+			count = current.duration - position;
+		}
+
+		if ( current.samples != NULL )
+		{
+			int offset = position % current.sampleCnt;
+			if ( current.sampleCnt - offset < count )
+			{
+				count = current.sampleCnt - offset;
+			}
+			memcpy( dst + samplesRead, current.samples + offset, count * sizeof(short) );
+		}
+		else
+		{
+			memset( dst + samplesRead, 0, count * sizeof(short) );
+		}
+		samplesRead += count;
+		position += count;
+
+		if ( current.duration == PCM_CONTINUOUS )
+		{
+			// keep the position bounded, a continuous tone can play for days
+			position = (current.samples != NULL) ? position % current.sampleCnt : 0;
+		}
+		else if ( position >= current.duration )
+		{
+			position = 0;
+			if ( ++step == sequence->steps.size() )	// end of sequence, start over
+			{
+				step = 0;
+				if ( passesLeft == 0 )
+				{
+					done = true;
+				}
+				else if ( passesLeft != PCM_REPEAT_FOREVER )
+				{
+					passesLeft--;
+				}
+			}
+		}
+	}
+	return samplesRead;
+}
+
+// ----------------------------------------------------------------------------
+WebrtcToneCache* WebrtcToneCache::getInstance()
+{
+	static WebrtcToneCache instance;
+	return &instance;
+}
+
+WebrtcToneCache::~WebrtcToneCache()
+{
+	for ( std::map<int, PcmSequence*>::iterator it = tones.begin(); it != tones.end(); it++ )
+	{
+		delete it->second;
+	}
+	for ( std::map<int, PcmSequence*>::iterator it = rings.begin(); it != rings.end(); it++ )
+	{
+		delete it->second;
+	}
+}
+
+const PcmSequence* WebrtcToneCache::getTone( ToneType type )
+{
+	base::AutoLock lock(cacheLock);
+	std::map<int, PcmSequence*>::iterator it = tones.find( type );
+	if ( it == tones.end() )
+	{
+		PcmSequence* sequence = new PcmSequence();
+		WebrtcToneGenerator::render( type, *sequence );
+		it = tones.insert( std::make_pair( (int)type, sequence ) ).first;
+	}
+	return it->second;
+}
+
+const PcmSequence* WebrtcToneCache::getRing( RingMode mode )
+{
+	base::AutoLock lock(cacheLock);
+	std::map<int, PcmSequence*>::iterator it = rings.find( mode );
+	if ( it == rings.end() )
+	{
+		PcmSequence* sequence = new PcmSequence();
+		WebrtcRingGenerator::render( mode, *sequence );
+		it = rings.insert( std::make_pair( (int)mode, sequence ) ).first;
+	}
+	return it->second;
+}
+
+// ----------------------------------------------------------------------------
+#ifdef TONECACHE_HAVE_SSE2
+/*
+ * Bit exact with the C loop: the 32-bit products are at most 3276800, so
+ * they and the correctly rounded float quotient are exact enough for the
+ * truncating conversion to match integer division.
+ */
+static int ScaleSamples_SSE2( short* buf, int numSamples, int scaleFactor )
+{
+	const __m128i factor = _mm_set1_epi16( (short)scaleFactor );
+	const __m128 hundred = _mm_set1_ps( 100.0f );
+	int i = 0;
+
+	for ( ; i + 8 <= numSamples; i += 8 )
+	{
+		__m128i s = _mm_loadu_si128( (const __m128i *)(buf + i) );
+		__m128i lo = _mm_mullo_epi16( s, factor );
+		__m128i hi = _mm_mulhi_epi16( s, factor );
+		__m128 p0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, hi ) );
+		__m128 p1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, hi ) );
+		__m128i q0 = _mm_cvttps_epi32( _mm_div_ps( p0, hundred ) );
+		__m128i q1 = _mm_cvttps_epi32( _mm_div_ps( p1, hundred ) );
+		_mm_storeu_si128( (__m128i *)(buf + i), _mm_packs_epi32( q0, q1 ) );
+	}
+	return i;
+}
+#endif
+
+void WebrtcToneCache::scaleSamples( short* buf, int numSamples, int scaleFactor )
+{
+	if ( scaleFactor >= 100 )
+	{
+		return;
+	}
+	if ( scaleFactor < 0 )
+	{
+		scaleFactor = 0;
+	}
+
+	int i = 0;
+#ifdef TONECACHE_HAVE_SSE2
+	i = ScaleSamples_SSE2( buf, numSamples, scaleFactor );
+#endif
+	for ( ; i < numSamples; i++ )
+	{
+		buf[i] = (short)((buf[i] * scaleFactor)/100);
+	}
+}
+
+} // namespace CSF
+
+#endif
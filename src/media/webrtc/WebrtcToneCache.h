@@ -0,0 +1,123 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef WEBRTCTONECACHE_H
+#define WEBRTCTONECACHE_H
+
+#ifndef _USE_CPVE
+
+#include <list>
+#include <map>
+#include <vector>
+#include <CSFAudioTermination.h>
+#include "base/synchronization/lock.h"
+
+#define PCM_CONTINUOUS		-1	// step plays until the generator is stopped
+#define PCM_REPEAT_FOREVER	-1
+
+namespace CSF {
+
+	// One step of a cadence at 8kHz: samples are replayed as needed to fill the duration,
+	// NULL samples is silence.
+	typedef struct {
+		const short*	samples;
+		int				sampleCnt;
+		int				duration;	// in samples, or PCM_CONTINUOUS
+	} PcmStep;
+
+	// A rendered cadence. Never changes once it is handed out by WebrtcToneCache.
+	class PcmSequence
+	{
+	public:
+		PcmSequence() : repeatCount(0) {}
+
+		// Copies samples into storage owned by the sequence, returns the stable copy.
+		const short* store( const short* samples, int sampleCnt );
+		void addStep( const short* samples, int sampleCnt, int duration );
+
+		std::vector<PcmStep> steps;
+		int repeatCount;	// passes after the first one, or PCM_REPEAT_FOREVER
+
+	private:
+		std::list< std::vector<short> > pcm;
+	};
+
+	// Playback position in a PcmSequence; reads only copy out of the cache.
+	class PcmCursor
+	{
+	public:
+		PcmCursor( const PcmSequence* sequence, bool once );
+
+		// Returns the number of samples written, less than numSamples once the sequence has ended.
+		int read( short* dst, int numSamples );
+		bool finished() const { return done; }
+
+	private:
+		const PcmSequence* sequence;
+		int passesLeft;		// PCM_REPEAT_FOREVER or remaining passes after this one
+		size_t step;
+		int position;		// samples played in the current step
+		bool done;
+	};
+
+	// Tones and ring cadences rendered once per process and shared by every generator.
+	class WebrtcToneCache
+	{
+	public:
+		static WebrtcToneCache* getInstance();
+
+		const PcmSequence* getTone( ToneType type );
+		const PcmSequence* getRing( RingMode mode );
+
+		// buf[i] = buf[i] * scaleFactor / 100, scaleFactor clamped to 0-100. Uses SSE2 when the target has it.
+		static void scaleSamples( short* buf, int numSamples, int scaleFactor );
+
+	private:
+		WebrtcToneCache() {}
+		~WebrtcToneCache();
+
+		base::Lock cacheLock;
+		std::map<int, PcmSequence*> tones;
+		std::map<int, PcmSequence*> rings;
+	};
+
+} // namespace CSF
+
+#endif
+#endif // WEBRTCTONECACHE_H
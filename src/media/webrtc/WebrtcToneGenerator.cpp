@@ -39,7 +39,9 @@
 
 #ifndef _USE_CPVE
 
+#include <math.h>
 #include <string.h>
+#include <vector>
 #include "WebrtcToneGenerator.h"
 #include "CSFToneDefinitions.h"
 
@@ -250,26 +252,93 @@ static TONE_TABLE_TYPE ToneTable[] =
 */
 };
 
+// one second at 8kHz holds a whole number of cycles of every tone frequency
+#define TONE_LOOP_SAMPLES	8000
+#define TONE_PI				3.14159265358979323846
+
 // ----------------------------------------------------------------------------
 WebrtcToneGenerator::WebrtcToneGenerator( ToneType type )
+: m_Cursor( WebrtcToneCache::getInstance()->getTone( type ), false )
+{
+}
+
+// ----------------------------------------------------------------------------
+void WebrtcToneGenerator::render( ToneType type, PcmSequence& sequence )
 {
 	TONE_TABLE_TYPE *tone = &ToneTable[type];
+	const unsigned short *cadence = (const unsigned short *)tone->Cadence;
+	unsigned long sinewaveIdx = 0;
 
-	// fill in tone memory
-	m_SinewaveIdx = 0;
-	m_CadenceIdx = 0;
-	memcpy( m_Cadence, tone->Cadence, sizeof( m_Cadence ) );
-	for ( int i = 0; i < MAX_TONEGENS; i++ )
+	// the ON/OFF sequence is the first MAX_CADENCES durations, zero durations are skipped
+	for ( unsigned long cadenceIdx = 0; cadenceIdx < MAX_CADENCES; cadenceIdx++ )
 	{
-		m_Sinewave[i].Coef = tone->Coefmem[i].FilterCoef;
-		m_Sinewave[i].Yn_1 = 0;
-		m_Sinewave[i].Yn_2 = tone->Coefmem[i].FilterMemory;
+		unsigned long duration = cadence[cadenceIdx];
+		if ( duration == 0 )
+		{
+			continue;
+		}
+
+		// OFF duration
+		if ( (cadenceIdx & 0x1) != 0 )
+		{
+			sequence.addStep( NULL, 0, duration );
+			continue;
+		}
+
+		unsigned long numTone = (tone->Descriptor >> (cadenceIdx << 1)) & 0xf;
+		if ( duration == TGN_INFINITE_REPEAT )
+		{
+			std::vector<short> pcm( TONE_LOOP_SAMPLES );
+			ToneLoop( &tone->Coefmem[sinewaveIdx], &pcm[0], TONE_LOOP_SAMPLES, numTone );
+			sequence.addStep( sequence.store( &pcm[0], TONE_LOOP_SAMPLES ), TONE_LOOP_SAMPLES, PCM_CONTINUOUS );
+			// nothing after a continuous tone is ever played
+			break;
+		}
+
+		SINEWAVE sinewave[MAX_TONEGENS];
+		for ( unsigned long i = 0; i < numTone; i++ )
+		{
+			sinewave[i].Coef = tone->Coefmem[sinewaveIdx + i].FilterCoef;
+			sinewave[i].Yn_1 = 0;
+			sinewave[i].Yn_2 = tone->Coefmem[sinewaveIdx + i].FilterMemory;
+		}
+		std::vector<short> pcm( duration );
+		ToneGen( sinewave, &pcm[0], duration, numTone );
+		sequence.addStep( sequence.store( &pcm[0], duration ), duration, duration );
+
+		sinewaveIdx += numTone;
 	}
-	m_RepeatCount = tone->RepeatCount;
-	m_Descriptor  = tone->Descriptor;
 
-	// set first sample
-	m_Sample = m_Cadence[0];
+	sequence.repeatCount = (tone->RepeatCount == TGN_INFINITE_REPEAT) ? PCM_REPEAT_FOREVER : tone->RepeatCount;
+}
+
+// ----------------------------------------------------------------------------
+// The recursive oscillator is a fraction of a Hz off the nominal frequency, so its output clicks
+// wherever it is looped. Continuous tones are rendered from the nominal frequencies instead, with
+// the oscillator's amplitude and starting phase: y[n] = A * sin(w * (n + 1)), A = -Yn_2 / sin(w).
+void WebrtcToneGenerator::ToneLoop( const FREQ_COEF_TABLE *coef, short *dst, unsigned long length, unsigned long numTones )
+{
+	for ( unsigned long j = 0; j < length; j++ )
+	{
+		double sample = 0;
+		for ( unsigned long i = 0; i < numTones; i++ )
+		{
+			double w = acos( coef[i].FilterCoef / 32768.0 );
+			double frequency = floor( w * 8000 / (2 * TONE_PI) + 0.5 );
+			double amplitude = -coef[i].FilterMemory / sin( w );
+			sample += amplitude * sin( 2 * TONE_PI * frequency * (j + 1) / 8000 );
+		}
+		sample = floor( sample + 0.5 );
+		if ( sample > 32767 )
+		{
+			sample = 32767;
+		}
+		if ( sample < -32768 )
+		{
+			sample = -32768;
+		}
+		dst[j] = (short)sample;
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -311,86 +380,16 @@ void WebrtcToneGenerator::ToneGen( PSINEWAVE param, short *dst, unsigned long le
 // Webrtc InStream implementation
 int WebrtcToneGenerator::Read( void *buf, int len )
 {
-	return TGNGenerateTone( (short *)buf, (unsigned long)(len/sizeof(short)) ) ? len : 0;
-}
-
-// ----------------------------------------------------------------------------
-bool WebrtcToneGenerator::TGNGenerateTone( short *dst, unsigned long length )
-{
-	unsigned long numTone = 0;
-
-	// tone or silent period done
-	if ( m_Sample == 0 )
+	int numSamples = len/sizeof(short);
+	int samples = m_Cursor.read( (short *)buf, numSamples );
+	if ( samples == 0 )
 	{
-		// the current ON or OFF duration has expired
-
-		// go to the next ON or OFF duration
-		m_CadenceIdx = (m_CadenceIdx + 1) & (MAX_CADENCES - 1);
-
-		// look for the next non-zero ON or OFF duration in the sequence
-		while ( (m_CadenceIdx != 0) && (m_Cadence[m_CadenceIdx] == 0) )
-		{
-			m_CadenceIdx = (m_CadenceIdx + 1) & (MAX_CADENCES - 1);
-		}
-
-		// set the duration to the next ON or OFF duration
-		m_Sample = m_Cadence[m_CadenceIdx];
-
-		// the complete ON/OFF sequence has been done => decrease the number of repeats
-		if ( m_CadenceIdx == 0 )
-		{
-			// reset to beginning of parameters
-			m_SinewaveIdx = 0;
-
-			// finite number of repeats
-			if ( m_RepeatCount != TGN_INFINITE_REPEAT )
-			{
-				// no more repeats -> stop the tone generator
-				if ( m_RepeatCount <= 0 )
-				{
-					return false;
-				}
-				else
-				{
-					m_RepeatCount--;
-				}
-			}
-		}
+		return 0;
 	}
 
-	// corresponds to the ON duration
-	if ( (m_CadenceIdx & 0x1) == 0 )
-	{
-		numTone = (m_Descriptor >> (m_CadenceIdx << 1)) & 0xf;
-
-		ToneGen( &m_Sinewave[m_SinewaveIdx], dst, length, numTone );
-	}
-	else	// insert silence
-	{
-		memset( dst, 0, length * sizeof( short ) );
-	}
-
-	if ( m_Sample != TGN_INFINITE_REPEAT )
-	{
-		if ( (length) < m_Sample )
-		{
-			m_Sample -= length;
-		}
-		else
-		{
-			m_Sample = 0;
-		}
-
-		if ( !m_Sample )
-		{
-			// corresponds to the ON duration
-			if ( (m_CadenceIdx & 0x1) == 0 )
-			{
-				m_SinewaveIdx += numTone;
-			}
-		}
-	}
-	return true;
+	// the engine reads whole frames, pad the one the tone ends in
+	memset( (short *)buf + samples, 0, (numSamples - samples) * sizeof(short) );
+	return len;
 }
 
 } // namespace CSF
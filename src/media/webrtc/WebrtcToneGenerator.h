@@ -44,6 +44,7 @@
 
 #include <CSFAudioTermination.h>
 #include "common_types.h"
+#include "WebrtcToneCache.h"
 
 #define MAX_TONEGENS		4
 #define MAX_CADENCES		4
@@ -86,6 +87,9 @@ namespace CSF {
 		// InStream interface
 		int Read( void *buf, int len );
 
+		// Renders one pass of the tone's cadence for WebrtcToneCache.
+		static void render( ToneType type, PcmSequence& sequence );
+
 	private:
 		typedef struct {
 			short Coef;
@@ -93,18 +97,10 @@ namespace CSF {
 			short Yn_2;
 		} SINEWAVE, *PSINEWAVE;
 
-		SINEWAVE			m_Sinewave[MAX_TONEGENS];
-		unsigned long		m_SinewaveIdx;
-		unsigned short		m_Cadence[TG_MAX_CADENCES];
-		unsigned long		m_CadenceIdx;
-		short				m_rCount[TG_MAX_REPEATCNTS];
-		unsigned long		m_Sample;
-		int					m_RepeatCount;
-		unsigned short		m_Descriptor;
-		short				m_CadenceRepeatCount;
-
-		bool	TGNGenerateTone( short *dst, unsigned long length );
-		void	ToneGen( PSINEWAVE param, short *dst, unsigned long length, unsigned long numTones );
+		PcmCursor			m_Cursor;
+
+		static void	ToneGen( PSINEWAVE param, short *dst, unsigned long length, unsigned long numTones );
+		static void	ToneLoop( const FREQ_COEF_TABLE *coef, short *dst, unsigned long length, unsigned long numTones );
 	};
 
 } // namespace CSF
@@ -50,11 +50,15 @@
 #include "WebrtcMediaProvider.h"
 #include "WebrtcAudioProvider.h"
 #include "WebrtcVideoProvider.h"
+#include "MediaPortAllocator.h"
+#include "MediaStreamRegistry.h"
 #include "WebrtcLogging.h"
 #include "vie_encryption.h"
 
 #include "base/synchronization/lock.h"
 
+#include <vector>
+
 using namespace std;
 #include "string.h"
 
@@ -85,6 +89,7 @@ WebrtcVideoProvider::WebrtcVideoProvider( WebrtcMediaProvider* provider )
   localRenderId(0),
   webCaptureId(0),
   vp8Idx(0),
+  sendMaxBitrate(0),
   previewWindow(NULL), 
   DSCPValue(0)
 {
@@ -167,6 +172,7 @@ WebrtcVideoProvider::WebrtcVideoProvider( WebrtcMediaProvider* provider )
 		{
 			//defaulting to VP8 for now
 			vp8Idx = codecIdx;
+			sendMaxBitrate = videoCodec.maxBitrate;
 		}	
         LOG_WEBRTC_INFO( logTag, "codec @ %d %s pltype %d ", codecIdx,  
 						           videoCodec.plName, videoCodec.plType );
@@ -178,6 +184,7 @@ WebrtcVideoProvider::WebrtcVideoProvider( WebrtcMediaProvider* provider )
 		LOG_WEBRTC_INFO( logTag, "height is %d", videoCodec.height );
             //break;
     }
+	MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::VIDEO_STREAM, this );
 #ifdef LINUX
     currentTime=lastRequestTime=clock();
 #endif
@@ -265,6 +272,9 @@ int WebrtcVideoProvider::init()
 
 WebrtcVideoProvider::~WebrtcVideoProvider()
 {
+	// the sampler thread reads the engine, so it has to be gone first
+	MediaStatsSampler::getInstance()->setIntervalMs( 0 );
+	MediaBandwidthManager::getInstance()->setSource( MediaStreamRegistry::VIDEO_STREAM, NULL );
     if(vieEncryption)
     {
         vieEncryption->Release();
@@ -443,25 +453,90 @@ int WebrtcVideoProvider::getCodecList( CodecRequestType requestType )
 
 WebrtcVideoStreamPtr WebrtcVideoProvider::getStreamByChannel( int channel )
 {
-	//base::AutoLock lock(streamMapMutex);
-    for( std::map<int, WebrtcVideoStreamPtr>::const_iterator it = streamMap.begin(); it != streamMap.end(); it++ )
-    {
-        WebrtcVideoStreamPtr stream = it->second;
-        if(stream->channelId == channel)
-            return stream;
-    }
-    return WebrtcVideoStreamPtr();
+	MediaStreamRegistry::Entry entry;
+	if ( !MediaStreamRegistry::getInstance()->findByChannel( MediaStreamRegistry::VIDEO_STREAM, channel, entry ) )
+		return WebrtcVideoStreamPtr();
+	return getStream( entry.streamId );
 }
 
 int WebrtcVideoProvider::getChannelForStreamId( int streamId )
 {
-    for( std::map<int, WebrtcVideoStreamPtr>::const_iterator it = streamMap.begin(); it != streamMap.end(); it++ )
-    {
-    	WebrtcVideoStreamPtr stream = it->second;
-        if(stream->streamId == streamId)
-            return stream->channelId;
-    }
-    return -1;
+	return MediaStreamRegistry::getInstance()->channelForStream( MediaStreamRegistry::VIDEO_STREAM, streamId );
+}
+
+void WebrtcVideoProvider::setStatsSampleInterval( int ms )
+{
+	MediaStatsSampler::getInstance()->setIntervalMs( ms );
+}
+
+bool WebrtcVideoProvider::getStreamStats( int streamId, MediaStreamStats & stats )
+{
+	if ( MediaStatsSampler::getInstance()->getLatest( MediaStreamRegistry::VIDEO_STREAM, streamId, stats ) )
+	{
+		return true;
+	}
+	// not sampled, read the engine directly (no rates or timing then)
+	memset( &stats, 0, sizeof(stats) );
+	stats.streamId = streamId;
+	return readRtpStats( streamId, stats );
+}
+
+std::vector<MediaStreamStats> WebrtcVideoProvider::getStreamStatsHistory( int streamId )
+{
+	return MediaStatsSampler::getInstance()->getHistory( MediaStreamRegistry::VIDEO_STREAM, streamId );
+}
+
+bool WebrtcVideoProvider::getStreamSummary( int streamId, MediaStreamSummary & summary )
+{
+	return MediaStatsSampler::getInstance()->getSummary( MediaStreamRegistry::VIDEO_STREAM, streamId, summary );
+}
+
+// Called from the sampler thread, so no provider locks; the channel comes from the stream registry.
+bool WebrtcVideoProvider::readRtpStats( int streamId, MediaStreamStats & stats )
+{
+	int channel = getChannelForStreamId( streamId );
+	if ( channel < 0 || vieRtpRtcp == NULL )
+	{
+		return false;
+	}
+
+	unsigned int bytesSent = 0, packetsSent = 0, bytesReceived = 0, packetsReceived = 0;
+	if ( vieRtpRtcp->GetRTPStatistics( channel, bytesSent, packetsSent, bytesReceived, packetsReceived ) != 0 )
+	{
+		LOG_WEBRTC_DEBUG( logTag, "readRtpStats: GetRTPStatistics failed on channel %d, error %d", channel, vieBase->LastError() );
+		return false;
+	}
+	stats.packetsReceived = packetsReceived;
+	stats.bytesReceived = bytesReceived;
+	stats.packetsSent = packetsSent;
+	stats.bytesSent = bytesSent;
+
+	// What we report to the sender describes the quality of the stream we receive.
+	unsigned short fractionLost = 0;
+	unsigned int cumulativeLost = 0, extendedMax = 0, jitter = 0;
+	int rttMs = 0;
+	if ( vieRtpRtcp->GetSentRTCPStatistics( channel, fractionLost, cumulativeLost, extendedMax, jitter, rttMs ) == 0 )
+	{
+		stats.packetsLost = cumulativeLost;
+		stats.fractionLost = fractionLost;
+		stats.jitterMs = jitter / 90;	// 90 kHz RTP clock
+		stats.rttMs = rttMs;
+	}
+	return true;
+}
+
+// Called from the GSM thread during admission. Video is charged at the send codec's maximum rate
+// in full size packets, and not at all while video is off.
+int WebrtcVideoProvider::getSessionCostKbps()
+{
+	const int packetBytes = 1200;
+
+	if ( !videoMode )
+	{
+		return 0;
+	}
+	int packetsPerSecond = (sendMaxBitrate * 1000 / 8 + packetBytes - 1) / packetBytes;
+	return MediaBandwidthManager::addPacketOverhead( sendMaxBitrate, packetsPerSecond );
 }
 
 WebrtcVideoStreamPtr WebrtcVideoProvider::getStream( int streamId )
@@ -484,6 +559,30 @@ void WebrtcVideoProvider::setMuteForStreamId( int streamId, bool muteVideo )
 	}
 }
 
+void WebrtcVideoProvider::setGroupDSCPValue( int groupId, int value )
+{
+	base::AutoLock lock(m_lock);
+	LOG_WEBRTC_INFO( logTag, "setGroupDSCPValue: groupId=%d, dscp=%d", groupId, value );
+	std::vector<WebrtcVideoStreamPtr> streams;
+	{
+		base::AutoLock lock(streamMapMutex);
+		for( std::map<int, WebrtcVideoStreamPtr>::const_iterator it = streamMap.begin(); it != streamMap.end(); it++ )
+		{
+			if ( it->second->groupId == groupId )
+				streams.push_back( it->second );
+		}
+	}
+	// streams not sending yet pick the value up in txStart
+	for( std::vector<WebrtcVideoStreamPtr>::const_iterator it = streams.begin(); it != streams.end(); it++ )
+	{
+		(*it)->DSCPValue = value;
+		if ( (*it)->txInitialised && vieNetwork->SetSendToS( (*it)->channelId, value>>2 ) != 0 )
+		{
+			LOG_WEBRTC_DEBUG( logTag, "setGroupDSCPValue: SetSendToS on channel %d failed, error %d", (*it)->channelId, vieBase->LastError() );
+		}
+	}
+}
+
 void WebrtcVideoProvider::setTxInitiatedForStreamId( int streamId, bool txInitiatedValue )
 {
 	WebrtcVideoStreamPtr stream = getStream(streamId);
@@ -548,45 +647,40 @@ int WebrtcVideoProvider::rxAlloc( int groupId, int streamId, int requestedPort )
     }
     LOG_WEBRTC_INFO( logTag, "rxAllocVideo: Created channel %d", channel );
 
-    int beginPort;        // where we started
-    int tryPort;        // where we are now
+    MediaPortAllocator * ports = MediaPortAllocator::getInstance();
+    int tryPort = ports->allocate( requestedPort );
 
-    if ( requestedPort == 0  || requestedPort < startPort || requestedPort >= endPort )
-        tryPort = startPort;
-    else
-        tryPort = requestedPort;
-
-    beginPort = tryPort;
-
-    do
+    while ( tryPort != 0 )
     {
         if ( vieNetwork->SetLocalReceiver( channel, tryPort, 0, (char *)localIP.c_str() ) == 0 )
         {
             LOG_WEBRTC_DEBUG( logTag, "rxAllocVideo: Allocated port %d", tryPort );
-			WebrtcVideoStreamPtr stream(new WebrtcVideoStream(streamId, channel));
+			WebrtcVideoStreamPtr stream(new WebrtcVideoStream(groupId, streamId, channel));
 			{
 				base::AutoLock lock(streamMapMutex);
 				streamMap[streamId] = stream;
 				LOG_WEBRTC_DEBUG( logTag, "rxAllocVideo: created stream" );
 			}
+			MediaStreamRegistry::getInstance()->addStream( MediaStreamRegistry::VIDEO_STREAM, streamId, channel );
+			MediaStatsSampler::getInstance()->addStream( MediaStreamRegistry::VIDEO_STREAM, streamId, this );
             return tryPort;
         }
 
         int errCode = vieBase->LastError();
         if ( errCode == 12061 /* Can't bind socket */ )        
         {
-            tryPort += 2;
-            if ( tryPort >= endPort )
-                tryPort = startPort;
+            // someone else has this pair, back off from it and take the next free one
+            ports->markUnavailable( tryPort );
+            tryPort = ports->allocate( 0 );
         }
         else
         {
             LOG_WEBRTC_ERROR( logTag, "rxAllocVideo: SetLocalReceiver returned error %d", errCode );
+            ports->cancel( tryPort );
             vieBase->DeleteChannel( channel );
             return 0;
         }
     }
-    while ( tryPort != beginPort );
 
     LOG_WEBRTC_WARN( logTag, "rxAllocVideo: No ports available?" );
     vieBase->DeleteChannel( channel );
@@ -780,6 +874,8 @@ void WebrtcVideoProvider::rxRelease( int groupId, int streamId, int port )
     int channel = getChannelForStreamId( streamId );
     if ( channel >= 0 )
     {
+		MediaStatsSampler::getInstance()->removeStream( MediaStreamRegistry::VIDEO_STREAM, streamId );
+		MediaStreamRegistry::getInstance()->removeStream( MediaStreamRegistry::VIDEO_STREAM, streamId );
 		vieBase->DisconnectAudioChannel( channel );
 		vieBase->StopReceive(channel);
 		vieRender->RemoveRenderer(channel);
@@ -789,6 +885,7 @@ void WebrtcVideoProvider::rxRelease( int groupId, int streamId, int port )
         	streamMap.erase(streamId);
         }
         LOG_WEBRTC_DEBUG( logTag, "rxReleaseVideo: Delete channel %d, release port %d", channel, port);
+        MediaPortAllocator::getInstance()->release( port );
     }
 }
 
@@ -818,8 +915,13 @@ int WebrtcVideoProvider::txStart( int groupId, int streamId, int payloadType, in
         }
 
         vieNetwork->SetSendDestination( channel, remoteIpAddr, remotePort );
-        // We might be muted - for example in the case where the call is being resumed, so respect that setting
 		WebrtcVideoStreamPtr stream = getStream(streamId);
+		int dscp = ( stream != NULL && stream->DSCPValue >= 0 ) ? stream->DSCPValue : DSCPValue;
+		if ( vieNetwork->SetSendToS( channel, dscp>>2 ) != 0 )
+		{
+			LOG_WEBRTC_DEBUG( logTag, "txStartVideo: SetSendToS on channel %d failed, error %d", channel, vieBase->LastError() );
+		}
+        // We might be muted - for example in the case where the call is being resumed, so respect that setting
 		
 		if (stream != NULL && ! stream->isMuted)
     	{
@@ -983,10 +1085,10 @@ void WebrtcVideoProvider::RequestNewKeyFrame		(int channel)
 #endif
 
     LOG_WEBRTC_INFO(logTag, "Send Request for I-frame to originator" );
-    WebrtcVideoStreamPtr stream= getStreamByChannel(channel);
+    MediaStreamRegistry::Entry entry;
     MediaProviderObserver *mpobs = VcmSIPCCBinding::getMediaProviderObserver();
-    if (mpobs != NULL)
-        mpobs->onKeyFrameRequested(stream->streamId);
+    if (mpobs != NULL && MediaStreamRegistry::getInstance()->findByChannel( MediaStreamRegistry::VIDEO_STREAM, channel, entry ))
+        mpobs->onKeyFrameRequested(entry.streamId);
 #ifdef LINUX
     lastRequestTime = clock();
 #endif
@@ -65,6 +65,9 @@ typedef void*                    WebrtcPlatformWindow;
 
 #include <string>
 #include <map>
+#include "MediaPortAllocator.h"
+#include "MediaStatsSampler.h"
+#include "MediaBandwidthManager.h"
 
 namespace CSF
 {
@@ -72,13 +75,15 @@ namespace CSF
 	class WebrtcVideoStream
 	{
 	public:
-		WebrtcVideoStream(int _streamId, int _channelId):
-			streamId(_streamId), channelId(_channelId),	isMuted(false), txInitialised(false)
+		WebrtcVideoStream(int _groupId, int _streamId, int _channelId):
+			groupId(_groupId), streamId(_streamId), channelId(_channelId), isMuted(false), txInitialised(false), DSCPValue(-1)
 			{}
+        int groupId;
         int streamId;
         int channelId;
         bool isMuted;
         bool txInitialised;
+        int DSCPValue;  // set per call by setGroupDSCPValue, -1 to use the provider's value
 	};
 
     class WebrtcMediaProvider;
@@ -86,6 +91,8 @@ namespace CSF
     DECLARE_PTR(WebrtcVideoStream);
 
     class WebrtcVideoProvider : public VideoControl, 
+								MediaStatsSource,
+								MediaBandwidthSource,
 								VideoTermination, 
 								webrtc::ViEEncoderObserver,
 								webrtc::ViEDecoderObserver,
@@ -109,6 +116,17 @@ namespace CSF
         std::string getCaptureDevice() { return captureDevice; }
         bool setCaptureDevice( const std::string& name );
 
+        void setStatsSampleInterval( int ms );
+        bool getStreamStats( int streamId, MediaStreamStats & stats );
+        std::vector<MediaStreamStats> getStreamStatsHistory( int streamId );
+        bool getStreamSummary( int streamId, MediaStreamSummary & summary );
+
+        // MediaStatsSource
+        bool readRtpStats( int streamId, MediaStreamStats & stats );
+
+        // MediaBandwidthSource
+        int getSessionCostKbps();
+
         // VideoTermination
         VideoTermination* getMediaTermination() { return this; }
 
@@ -137,8 +155,9 @@ namespace CSF
         void txClose    ( int groupId, int streamId );
 
         void setLocalIP    ( const char* addr ) { localIP = addr; }
-        void setMediaPorts ( int startPort, int endPort ) { this->startPort = startPort; this->endPort = endPort; }
+        void setMediaPorts ( int startPort, int endPort ) { this->startPort = startPort; this->endPort = endPort; MediaPortAllocator::getInstance()->setRange( startPort, endPort ); }
         void setDSCPValue (int value){this->DSCPValue = value;}
+        void setGroupDSCPValue (int groupId, int value);
         //void Print(const Webrtc::TraceLevel level, const char* message, const int length);
 
         bool mute(int streamID, bool muteVideo);
@@ -197,6 +216,7 @@ namespace CSF
 	int localRenderId;
 	int webCaptureId;
 	int vp8Idx;
+	int sendMaxBitrate;	// kbps, of the VP8 send codec
         RenderWindow* previewWindow;
         int DSCPValue;
         // Synchronisation (to avoid data corruption and worse given that so many threads call the media provider)
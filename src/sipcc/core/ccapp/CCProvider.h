@@ -89,7 +89,7 @@ typedef struct cc_call_log_t_ {
 } cc_call_log_t;
 
 typedef struct cc_call_info_t_{
-    uint32_t     ref_count;
+    volatile int32_t ref_count;
     session_id_t  sess_id;
     line_t        line;
     callid_t      id;
@@ -130,6 +130,17 @@ typedef struct cc_call_info_t_{
     cc_boolean    audio_mute;
     cc_boolean    video_mute;
     cc_call_conference_Info_t call_conference;
+    /*
+     * Immutable snapshot published for the current contents of a live
+     * session, shared by every CCAPI_Call_getCallInfo() until the session
+     * changes.  Always NULL in the snapshots themselves.
+     */
+    struct cc_call_info_t_ *snapshot;
+    /*
+     * Set while the ccapp thread is changing the session's fields;
+     * snapshots taken meanwhile are not cached.
+     */
+    cc_boolean    snapshot_pending;
 } session_data_t;
 
 typedef enum {
@@ -169,6 +180,10 @@ extern void getLineIdAndCallId (line_t *line_id, callid_t *call_id);
 extern void ccp_handler(void* msg, int type);
 extern session_data_t * getDeepCopyOfSessionData(session_data_t *data);
 extern void cleanSessionData(session_data_t *data);
+extern session_data_t * ccappGetSessionSnapshot(session_data_t *data);
+extern void ccappInvalidateSessionSnapshot(session_data_t *data);
+extern void ccappBeginSessionUpdate(session_data_t *data);
+extern void ccappEndSessionUpdate(session_data_t *data);
 extern cc_call_handle_t ccappGetConnectedCall();
 
 #endif
@@ -38,6 +38,7 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include "cpr_stdio.h"
+#include "cpr_locks.h"
 #include "ccapi_call.h"
 #include "sessionHash.h"
 #include "CCProvider.h"
@@ -50,6 +51,8 @@
 
 /**
  * Get call info snapshot
+ * The snapshot is shared with other holders until the call changes and
+ * must be treated as read only.
  * @param [in] handle - call handle
  * @return cc_call_info_snap_t
  */
@@ -61,11 +64,7 @@ cc_callinfo_ref_t CCAPI_Call_getCallInfo(cc_call_handle_t handle) {
    if ( session_id != 0 ) {
       data = findhash(session_id);
       if ( data != NULL ) {
-        snapshot = getDeepCopyOfSessionData(data);
-        if (snapshot == NULL) {
-            return NULL;
-        }
-        snapshot->ref_count = 1;
+        snapshot = ccappGetSessionSnapshot(data);
       }
    }
    return snapshot;
@@ -77,7 +76,7 @@ cc_callinfo_ref_t CCAPI_Call_getCallInfo(cc_call_handle_t handle) {
  */
 void CCAPI_Call_retainCallInfo(cc_callinfo_ref_t ref) {
     if (ref != NULL ) {
-        ref->ref_count++;
+        (void) cprAtomicIncrement(&ref->ref_count);
     }
 }
 /**
@@ -89,8 +88,7 @@ void CCAPI_Call_releaseCallInfo(cc_callinfo_ref_t ref) {
     if (ref != NULL ) {
 	DEF_DEBUG(DEB_F_PREFIX"ref=0x%x: count=%d", 
            DEB_F_PREFIX_ARGS(SIP_CC_PROV, "CCAPI_Call_releaseCallInfo"), ref, ref->ref_count);
-	ref->ref_count--;
-	if ( ref->ref_count == 0 ) {
+	if ( cprAtomicDecrement(&ref->ref_count) == 0 ) {
             cleanSessionData(ref);
             cpr_free(ref);
 	}
@@ -367,6 +365,7 @@ cc_return_t CCAPI_Call_setAudioMute (cc_call_handle_t handle, cc_boolean val) {
            DEB_F_PREFIX_ARGS(SIP_CC_PROV, "CCAPI_Call_setAudioMute"), val, handle, sess_data_p);
 	if ( sess_data_p != NULL ) {
 		sess_data_p->audio_mute = val;
+		ccappInvalidateSessionSnapshot(sess_data_p);
 	}
         return CC_SUCCESS;
 }
@@ -385,6 +384,7 @@ cc_return_t CCAPI_Call_setVideoMute (cc_call_handle_t handle, cc_boolean val){
            DEB_F_PREFIX_ARGS(SIP_CC_PROV, "CCAPI_Call_setVideoMute"), val, handle, sess_data_p);
 	if ( sess_data_p != NULL ) {
 		sess_data_p->video_mute = val;
+		ccappInvalidateSessionSnapshot(sess_data_p);
 		lsm_set_video_mute(GET_CALL_ID(handle), val);
 	}
         return CC_SUCCESS;
@@ -52,6 +52,7 @@
 #include "cc_service_listener.h"
 #include "plat_api.h"
 #include "util_string.h"
+#include "cc_capacity.h"
 
 int sendResetUpdates  = 0;         // default is not to send updates
 
@@ -92,6 +93,18 @@ cc_return_t CCAPI_Service_create() {
     //return (service_processEvent(EV_SRVC_CREATE));
 }
 
+/**
+ * Set the call capacity used to size the stack tables.
+ * @return
+ */
+cc_return_t CCAPI_Service_setMaxCalls(int max_calls) {
+    if (cc_capacity_set_max_calls((int32_t) max_calls) == FALSE) {
+        CCAPP_ERROR("CCAPI_Service_setMaxCalls - rejected %d\n", max_calls);
+        return (CC_FAILURE);
+    }
+    return (CC_SUCCESS);
+}
+
 /**
  * Gracefully unload the Sipcc stack
  * @return
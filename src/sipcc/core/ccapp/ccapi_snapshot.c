@@ -49,6 +49,7 @@
 #include "ccapi_call.h"
 #include "ccapi_call_listener.h"
 #include "CCProvider.h"
+#include "sessionHash.h"
 #include "capability_set.h"
 #include "phone_debug.h"
 
@@ -475,7 +476,11 @@ void ccsnap_gen_lineEvent(ccapi_line_event_e event, cc_lineid_t handle){
 
 void ccsnap_gen_callEvent(ccapi_call_event_e event, cc_call_handle_t handle){
 
-    session_data_t *call_info = CCAPI_Call_getCallInfo(handle);
+    session_data_t *call_info;
+
+    // the session is final for this event, its snapshot can be cached
+    ccappEndSessionUpdate(findhash(ccpro_get_sessionId_by_callid(GET_CALL_ID(handle))));
+    call_info = CCAPI_Call_getCallInfo(handle);
 
     if ( call_info == NULL ) {
         call_info = getDeepCopyOfSessionData(NULL);
@@ -511,12 +516,35 @@ void ccsnap_update_ccm_status(cc_string_t addr, cc_ccm_status_t status)
     }
 }
 
+/*
+ * The call info of a call as a private copy; the published snapshot is
+ * shared with other listeners and must not be changed.
+ */
+static session_data_t *ccsnap_get_call_info_copy (cc_call_handle_t handle)
+{
+    session_data_t *snap = CCAPI_Call_getCallInfo(handle);
+    session_data_t *copy;
+
+    if (snap == NULL) {
+        return NULL;
+    }
+    copy = getDeepCopyOfSessionData(snap);
+    CCAPI_Call_releaseCallInfo(snap);
+    return copy;
+}
+
 void ccsnap_handle_mnc_reached (cc_line_info_t *line_info, cc_boolean mnc_reached, cc_cucm_mode_t mode) 
 {
-    cc_call_handle_t handles[MAX_CALLS];
+    cc_call_handle_t *handles;
     int count = MAX_CALLS, i;
     session_data_t *cinfo;
 
+    /* MAX_CALLS is a run time value, keep the handle list off the stack */
+    handles = (cc_call_handle_t *) cpr_malloc(MAX_CALLS * sizeof(cc_call_handle_t));
+    if (handles == NULL) {
+        return;
+    }
+
     if (mnc_reached) {
  	line_info->allowed_features[CCAPI_CALL_CAP_NEWCALL] = FALSE;
         line_info->allowed_features[CCAPI_CALL_CAP_REDIAL] = FALSE;
@@ -528,7 +556,7 @@ void ccsnap_handle_mnc_reached (cc_line_info_t *line_info, cc_boolean mnc_reache
     // update connected calls caps on this line
     CCAPI_LineInfo_getCallsByState(line_info->line_id, CONNECTED, handles, &count);
     for ( i=0; i<count; i++) {
-	cinfo = CCAPI_Call_getCallInfo(handles[i]);
+	cinfo = ccsnap_get_call_info_copy(handles[i]);
 	if (cinfo) {
 	    if ( cinfo->attr == (cc_call_attr_t) CONF_CONSULT ||
 	         cinfo->attr == (cc_call_attr_t) XFR_CONSULT ) {
@@ -542,12 +570,14 @@ void ccsnap_handle_mnc_reached (cc_line_info_t *line_info, cc_boolean mnc_reache
                 printCallInfo(cinfo, "ccsnap_handle_mnc_reached");
             }
             CCAPI_CallListener_onCallEvent(CCAPI_CALL_EV_CAPABILITY, handles[i], cinfo, "");
+            CCAPI_Call_releaseCallInfo(cinfo);
 	}
     }
     // update RIU call caps on this line
+    count = MAX_CALLS;
     CCAPI_LineInfo_getCallsByState(line_info->line_id, REMINUSE, handles, &count);
     for ( i=0; i<count; i++) {
-        cinfo = CCAPI_Call_getCallInfo(handles[i]);
+        cinfo = ccsnap_get_call_info_copy(handles[i]);
         if (cinfo) {
             cinfo->allowed_features[CCAPI_CALL_CAP_BARGE] = mnc_reached?FALSE:TRUE;
             //print call info
@@ -555,8 +585,10 @@ void ccsnap_handle_mnc_reached (cc_line_info_t *line_info, cc_boolean mnc_reache
                 printCallInfo(cinfo, "ccsnap_handle_mnc_reached");
             }
             CCAPI_CallListener_onCallEvent(CCAPI_CALL_EV_CAPABILITY, handles[i], cinfo, "");
+            CCAPI_Call_releaseCallInfo(cinfo);
         }
     }
+    cpr_free(handles);
 }
 
 void ccsnap_gen_blfFeatureEvent(cc_blf_state_t state, int appId)
@@ -40,11 +40,15 @@
 #include "ccapp_task.h"
 #include "phone.h"
 #include "CCProvider.h"
+#include "cc_latency.h"
 
 extern cprMsgQueue_t ccapp_msgq;
 extern void CCAppInit();
 static sll_lite_list_t sll_list;
 
+/* Messages taken off the queue per wakeup */
+#define CCAPP_MSG_BATCH_SIZE 8
+
 /**
  * Add/Get ccapp task listener
  */
@@ -158,6 +162,7 @@ ccappTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, uint32_t UsrInfo)
     syshdr->Cmd = cmd;
     syshdr->Len = len;
     syshdr->Usr.UsrInfo = UsrInfo;
+    cc_latency_stamp(syshdr);
 
     if (cprSendMessage(ccapp_msgq , (cprBuffer_t*)msg, (void **)&syshdr) == CPR_FAILURE) {
         cprReleaseSysHeader(syshdr);
@@ -166,6 +171,57 @@ ccappTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, uint32_t UsrInfo)
     return CPR_SUCCESS;
 }
 
+/**
+ *
+ * Set up the listener list and the CC provider. Called on the CCApp thread
+ * before it starts taking messages, or by a driver that runs the task
+ * inline.
+ *
+ * @return  void
+ *
+ * @pre     None
+ */
+void ccappTaskInit(void)
+{
+    //initialize the listener list
+    sll_lite_init(&sll_list);
+
+    CCAppInit();
+}
+
+/**
+ *
+ * Hand one message taken off the CCApp queue to its listener. The message
+ * and its system header are released here.
+ *
+ * @param   syshdr - system header of the message
+ * @param   msg - msg ptr
+ *
+ * @return  void
+ *
+ * @pre     (syshdr != NULL)
+ */
+void ccappTaskProcessMsg(phn_syshdr_t *syshdr, void *msg)
+{
+    static const char fname[] = "ccappTaskProcessMsg";
+    appListener *listener = NULL;
+
+    CCAPP_DEBUG(DEB_F_PREFIX"Received Cmd[%d] for app[%d]\n", DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname),
+            syshdr->Cmd, syshdr->Usr.UsrInfo);
+
+    cc_latency_begin(CC_LATENCY_QUEUE_CCAPP, syshdr);
+    listener = getCcappListener(syshdr->Usr.UsrInfo);
+    if (listener != NULL) {
+        (* ((appListener)(listener)))(msg, syshdr->Cmd);
+    } else {
+        CCAPP_DEBUG(DEB_F_PREFIX"Event[%d] doesn't have a dedicated listener.\n", DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname),
+                syshdr->Usr.UsrInfo);
+    }
+    cc_latency_end(CC_LATENCY_QUEUE_CCAPP);
+    cprReleaseSysHeader(syshdr);
+    cprReleaseBuffer(msg);
+}
+
 /**
  *
  * CCApp Provider main routine.
@@ -178,31 +234,15 @@ ccappTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, uint32_t UsrInfo)
  */
 void CCApp_task(void * arg)
 {
-    static const char fname[] = "CCApp_task";
-    phn_syshdr_t   *syshdr = NULL;
-    appListener *listener = NULL;
-    void * msg;
+    cprMsgBatchEntry_t batch[CCAPP_MSG_BATCH_SIZE];
+    uint16_t count, i;
 
-    //initialize the listener list
-    sll_lite_init(&sll_list);
-
-    CCAppInit();
+    ccappTaskInit();
 
     while (1) {
-        msg = cprGetMessage(ccapp_msgq, TRUE, (void **) &syshdr);
-        if ( msg) {
-            CCAPP_DEBUG(DEB_F_PREFIX"Received Cmd[%d] for app[%d]\n", DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname),
-                    syshdr->Cmd, syshdr->Usr.UsrInfo);
-
-            listener = getCcappListener(syshdr->Usr.UsrInfo);
-            if (listener != NULL) {
-                (* ((appListener)(listener)))(msg, syshdr->Cmd);
-            } else {
-                CCAPP_DEBUG(DEB_F_PREFIX"Event[%d] doesn't have a dedicated listener.\n", DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname),
-                        syshdr->Usr.UsrInfo);
-            }
-            cprReleaseSysHeader(syshdr);
-            cprReleaseBuffer(msg);
+        count = cprGetMessageBatch(ccapp_msgq, TRUE, batch, CCAPP_MSG_BATCH_SIZE);
+        for (i = 0; i < count; i++) {
+            ccappTaskProcessMsg((phn_syshdr_t *) batch[i].usrPtr, batch[i].msg);
         }
     }
 }
@@ -38,6 +38,7 @@
  * ***** END LICENSE BLOCK ***** */
 
 #include "sll_lite.h"
+#include "phone.h"
 
 //Define app id for ccapp task
 #define CCAPP_CCPROVIER     1
@@ -53,3 +54,5 @@ typedef struct {
 extern void addCcappListener(appListener* listener, int type);
 appListener *getCcappListener(int type);
 cpr_status_e ccappTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, uint32_t usrInfo);
+void ccappTaskInit(void);
+void ccappTaskProcessMsg(phn_syshdr_t *syshdr, void *msg);
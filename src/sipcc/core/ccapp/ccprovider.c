@@ -70,6 +70,7 @@
 #include "plat_debug.h"
 
 #include "config_api.h"
+#include "ccapi_call.h"
 #include "ccapi_call_info.h"
 #include "ccapi_call_listener.h"
 #include "ccapi_snapshot.h"
@@ -82,6 +83,7 @@
 #include "ccapi_device_info.h"
 #include "conf_roster.h"
 #include "reset_api.h"
+#include "cc_shutdown.h"
 
 /*---------------------------------------------------------
  *
@@ -152,6 +154,8 @@
  *
  */
 static CCAppGlobal_t gCCApp;
+/* guards the published snapshot pointer of every live session */
+static cprMutex_t ccapp_snapshot_lock = NULL;
 cc_int32_t g_CCAppDebug=TRUE;
 cc_int32_t g_CCLogDebug=TRUE;
 cc_int32_t g_NotifyCallDebug=TRUE;
@@ -334,6 +338,9 @@ void CCAppInit()
     gCCApp.cause = CC_CAUSE_NONE;
     gCCApp.mode = CC_MODE_INVALID;
     gCCApp.cucm_mode = NONE_AVAIL;
+    if (ccapp_snapshot_lock == NULL) {
+        ccapp_snapshot_lock = cprCreateMutex("CCApp snapshot");
+    }
     if (platThreadInit("CCApp_Task") != 0) {
         return;
     }
@@ -950,6 +957,8 @@ session_data_t * getDeepCopyOfSessionData(session_data_t *data)
        if ( data != NULL ) {
            *newData = *data;
 	   newData->ref_count = 1;
+           newData->snapshot = NULL;
+           newData->snapshot_pending = FALSE;
            newData->clg_name =  strlib_copy(data->clg_name);
            newData->clg_number =  strlib_copy(data->clg_number);
            newData->cld_name =  strlib_copy(data->cld_name);
@@ -988,6 +997,123 @@ session_data_t * getDeepCopyOfSessionData(session_data_t *data)
    return newData;
 }
 
+/**
+ * Get the published snapshot of a live session, creating it if the
+ * session changed since the last one was handed out.
+ *
+ * Snapshots are never modified once published, so any number of
+ * listeners and application threads can read the same one without
+ * locking; the mutex only covers swapping the cached pointer.  While
+ * an update is changing the session the copy is the caller's own, so
+ * that a half-updated session is never cached.
+ *
+ * @param data - live session data from the session hash
+ *
+ * @return snapshot with one reference owned by the caller, or NULL
+ */
+session_data_t * ccappGetSessionSnapshot(session_data_t *data)
+{
+   session_data_t *snap;
+
+   if ( data == NULL ) {
+       return NULL;
+   }
+
+   if ( ccapp_snapshot_lock == NULL ) {
+       return getDeepCopyOfSessionData(data);
+   }
+
+   (void) cprGetMutex(ccapp_snapshot_lock);
+   if ( data->snapshot_pending ) {
+       snap = getDeepCopyOfSessionData(data);
+   } else {
+       snap = data->snapshot;
+       if ( snap == NULL ) {
+           snap = getDeepCopyOfSessionData(data);
+           data->snapshot = snap;
+       }
+       if ( snap != NULL ) {
+           (void) cprAtomicIncrement(&snap->ref_count);
+       }
+   }
+   (void) cprReleaseMutex(ccapp_snapshot_lock);
+
+   return snap;
+}
+
+/**
+ * Drop the published snapshot of a live session and mark whether its
+ * fields are being changed.
+ */
+static void ccappResetSessionSnapshot(session_data_t *data, cc_boolean pending)
+{
+   session_data_t *snap;
+
+   if ( data == NULL ) {
+       return;
+   }
+
+   if ( ccapp_snapshot_lock != NULL ) {
+       (void) cprGetMutex(ccapp_snapshot_lock);
+   }
+   snap = data->snapshot;
+   data->snapshot = NULL;
+   data->snapshot_pending = pending;
+   if ( ccapp_snapshot_lock != NULL ) {
+       (void) cprReleaseMutex(ccapp_snapshot_lock);
+   }
+
+   if ( snap != NULL ) {
+       CCAPI_Call_releaseCallInfo(snap);
+   }
+}
+
+/**
+ * Drop the published snapshot of a live session; must be called
+ * after a field of the session has changed.  Holders of the old
+ * snapshot keep it until they release it.
+ *
+ * @param data - live session data from the session hash
+ */
+void ccappInvalidateSessionSnapshot(session_data_t *data)
+{
+   ccappResetSessionSnapshot(data, FALSE);
+}
+
+/**
+ * Start changing the fields of a live session.  The published snapshot
+ * is dropped and none is cached until ccappEndSessionUpdate(), so a
+ * reader cannot cache the fields as they were before the change.
+ *
+ * @param data - live session data from the session hash
+ */
+void ccappBeginSessionUpdate(session_data_t *data)
+{
+   ccappResetSessionSnapshot(data, TRUE);
+}
+
+/**
+ * The fields changed since ccappBeginSessionUpdate() are final; the
+ * next snapshot taken is cached again.  Called by ccsnap_gen_callEvent()
+ * before it takes the event's snapshot.
+ *
+ * @param data - live session data from the session hash, may be NULL
+ */
+void ccappEndSessionUpdate(session_data_t *data)
+{
+   if ( data == NULL ) {
+       return;
+   }
+
+   if ( ccapp_snapshot_lock != NULL ) {
+       (void) cprGetMutex(ccapp_snapshot_lock);
+   }
+   data->snapshot_pending = FALSE;
+   if ( ccapp_snapshot_lock != NULL ) {
+       (void) cprReleaseMutex(ccapp_snapshot_lock);
+   }
+}
+
 
 /**
  *
@@ -1001,6 +1127,7 @@ session_data_t * getDeepCopyOfSessionData(session_data_t *data)
 void cleanSessionData(session_data_t *data)
 {
    if ( data != NULL ) {
+        ccappInvalidateSessionSnapshot(data);
 	strlib_free(data->clg_name);
         data->clg_name = strlib_empty();
 	strlib_free(data->clg_number);
@@ -1056,6 +1183,7 @@ boolean ccappPreserveCall()
         gCCApp.inPreservation = TRUE;
         gCCApp.preservID = data->sess_id;
         capset_get_allowed_features(gCCApp.mode, PRESERVATION, data->allowed_features);
+        ccappInvalidateSessionSnapshot(data);
 	ccsnap_gen_callEvent(CCAPI_CALL_EV_PRESERVATION, CREATE_CALL_HANDLE_FROM_SESSION_ID(data->sess_id));
         retVal = TRUE;
       } else {
@@ -1402,6 +1530,20 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
 
     CCAPP_DEBUG(DEB_F_PREFIX"Found data for sessid %x event %d\n",
             DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname), sessUpd->sessionID, sessUpd->eventID);
+    switch(sessUpd->eventID) {
+    case CALL_DELETE_LAST_DIGIT:
+    case CALL_FEATURE_CANCEL:
+    case CALL_RECV_INFO_LIST:
+    case MEDIA_INTERFACE_UPDATE_BEGIN:
+    case MEDIA_INTERFACE_UPDATE_SUCCESSFUL:
+    case MEDIA_INTERFACE_UPDATE_FAIL:
+        // no session fields change, listeners keep sharing the last snapshot
+        break;
+    default:
+        // ended by ccsnap_gen_callEvent() or below for updates without one
+        ccappBeginSessionUpdate(data);
+        break;
+    }
 	switch(sessUpd->eventID) {
 	case CALL_SESSION_CLOSED:
 	    // find and deep free then delete
@@ -1488,10 +1630,12 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
 
 	case CALL_CALLREF:
             data->callref = sessUpd->update.ccSessionUpd.data.callref;
+            ccappEndSessionUpdate(data);
             break;
 	case CALL_GCID:
 		if ( ! strncasecmp(data->gci, sessUpd->update.ccSessionUpd.data.gcid, CC_MAX_GCID)) {
 		  // No change in gci we can ignore the update
+		  ccappEndSessionUpdate(data);
 		  return;
 		}
 		sstrncpy(data->gci, sessUpd->update.ccSessionUpd.data.gcid, CC_MAX_GCID);
@@ -1502,6 +1646,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
         data->line = sessUpd->update.ccSessionUpd.data.state_data.line_id;
         data->attr = sessUpd->update.ccSessionUpd.data.state_data.attr;
         data->inst = sessUpd->update.ccSessionUpd.data.state_data.inst;
+        ccappEndSessionUpdate(data);
         return;
 		break;
 
@@ -1531,6 +1676,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
         if ((data->cld_number[0]) && ccappCldNumIsCfwdallString(data->cld_number)) {
             DEF_DEBUG(DEB_F_PREFIX"Not updating the UI. Called Number = %s\n",
                     DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname), data->cld_number);
+            ccappEndSessionUpdate(data);
             return;
         }
         /*
@@ -1555,6 +1701,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
 		data->plcd_number = strlib_update(data->plcd_number, sessUpd->update.ccSessionUpd.data.plcd_info.cldNum);
 		data->plcd_name = ccsnap_EscapeStrToLocaleStr(data->plcd_name, sessUpd->update.ccSessionUpd.data.plcd_info.cldName, LEN_UNKNOWN);
                 calllogger_setPlacedCallInfo(data);
+                ccappEndSessionUpdate(data);
 
 		break;
 
@@ -1594,6 +1741,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
                  "callStatusChange", data->line, data->id,
                   NOTIFY_CALL_STATUS);
         //>
+        ccappEndSessionUpdate(data);
 
 	break;
        if(strcmp(data->status, strlib_empty()) != 0){
@@ -1615,6 +1763,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
     case VIDEO_AVAIL:
         if ( data->vid_dir == sessUpd->update.ccSessionUpd.data.action ) {
             // no change don't update
+            ccappEndSessionUpdate(data);
             return;
         }
         data->vid_dir = sessUpd->update.ccSessionUpd.data.action;
@@ -1635,6 +1784,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
     case CALL_LOGDISP:
         data->log_disp = sessUpd->update.ccSessionUpd.data.action;
         calllogger_updateLogDisp(data);
+        ccappEndSessionUpdate(data);
         // No need to generate this event anymore
 	// ccsnap_gen_callEvent(CCAPI_CALL_EV_LOG_DISP, CREATE_CALL_HANDLE_FROM_SESSION_ID(sessUpd->sessionID));
         break;
@@ -1662,6 +1812,7 @@ static void ccappUpdateSessionData (session_update_t *sessUpd)
     default:
         DEF_DEBUG(DEB_F_PREFIX"Unknown event, id = %d\n",
                             DEB_F_PREFIX_ARGS(SIP_CC_PROV, fname), sessUpd->eventID);
+        ccappEndSessionUpdate(data);
         break;
 	}
     return;
@@ -1907,6 +2058,7 @@ void ccp_handler(void* msg, int type) {
             data->info_package = rcvdInfo->info.generic_raw.info_package;
             data->info_type = rcvdInfo->info.generic_raw.content_type;
             data->info_body = rcvdInfo->info.generic_raw.message_body;
+            ccappInvalidateSessionSnapshot(data);
 
             ccsnap_gen_callEvent(CCAPI_CALL_EV_RECEIVED_INFO, CREATE_CALL_HANDLE_FROM_SESSION_ID(rcvdInfo->sessionID));
                    
@@ -1922,6 +2074,7 @@ void ccp_handler(void* msg, int type) {
             data->info_package = strlib_empty();
             data->info_type = strlib_empty();
             data->info_body = strlib_empty();
+            ccappInvalidateSessionSnapshot(data);
         }
         freeRcvdInfo(rcvdInfo);
         break;
@@ -1961,6 +2114,7 @@ void destroy_ccapp_thread()
         DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
     platform_initialized = FALSE;
     CCAppShutdown();
+    cc_shutdown_phase_unloaded(CC_SHUTDOWN_PHASE_CCAPP);
     (void)cprDestroyThread(ccapp_thread);
 }
 
@@ -0,0 +1,269 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "cpr.h"
+#include "cpr_stdlib.h"
+#include "cpr_string.h"
+#include "cpr_locks.h"
+#include "phone_debug.h"
+#include "debug.h"
+#include "cc_capacity.h"
+
+#define CC_CAPACITY_MAX_TABLES 32
+
+typedef struct {
+    const char *name;
+    void       *table;
+    uint32_t    count;
+    uint32_t    elem_size;
+} cc_capacity_table_t;
+
+int32_t g_cc_max_calls = CC_MAX_CALLS_DEFAULT;
+
+static boolean capacity_frozen = FALSE;
+static cprMutex_t capacity_mutex = NULL;
+static cc_capacity_table_t capacity_tables[CC_CAPACITY_MAX_TABLES];
+
+/*
+ *  Function: cc_capacity_set_max_calls()
+ *
+ *  Description: Sets the number of simultaneous calls the stack is sized
+ *               for. Only honoured before the stack is created, since the
+ *               tables are allocated from it during initialization.
+ *
+ *  Parameters:  max_calls - number of calls, including the spare call that
+ *                           MAX_CALLS has always reserved.
+ *
+ *  Returns:     TRUE if the value was accepted.
+ */
+boolean
+cc_capacity_set_max_calls (int32_t max_calls)
+{
+    static const char fname[] = "cc_capacity_set_max_calls";
+
+    if (capacity_frozen) {
+        err_msg(DEB_F_PREFIX"capacity is fixed once the stack is created\n",
+                DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
+        return FALSE;
+    }
+    if ((max_calls < CC_MAX_CALLS_MIN) || (max_calls > CC_MAX_CALLS_LIMIT)) {
+        err_msg(DEB_F_PREFIX"max calls %d out of range %d..%d\n",
+                DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname), max_calls,
+                CC_MAX_CALLS_MIN, CC_MAX_CALLS_LIMIT);
+        return FALSE;
+    }
+    g_cc_max_calls = max_calls;
+    return TRUE;
+}
+
+/*
+ *  Function: cc_capacity_freeze()
+ *
+ *  Description: Called from ccPreInit before any task is started. From
+ *               here on the capacity can no longer change.
+ */
+void
+cc_capacity_freeze (void)
+{
+    if (capacity_frozen) {
+        return;
+    }
+    capacity_mutex = cprCreateMutex("capacity");
+    capacity_frozen = TRUE;
+}
+
+static void
+cc_capacity_lock (void)
+{
+    if (capacity_mutex) {
+        (void) cprGetMutex(capacity_mutex);
+    }
+}
+
+static void
+cc_capacity_unlock (void)
+{
+    if (capacity_mutex) {
+        (void) cprReleaseMutex(capacity_mutex);
+    }
+}
+
+/*
+ *  Function: cc_capacity_table_register()
+ *
+ *  Description: Records a table sized from the call capacity that is not
+ *               allocated through cc_capacity_table_alloc().
+ */
+void
+cc_capacity_table_register (const char *name, uint32_t count,
+                            uint32_t elem_size)
+{
+    int i;
+
+    cc_capacity_lock();
+    for (i = 0; i < CC_CAPACITY_MAX_TABLES; i++) {
+        if (capacity_tables[i].name == NULL ||
+            capacity_tables[i].name == name) {
+            capacity_tables[i].name = name;
+            capacity_tables[i].table = NULL;
+            capacity_tables[i].count = count;
+            capacity_tables[i].elem_size = elem_size;
+            break;
+        }
+    }
+    cc_capacity_unlock();
+}
+
+/*
+ *  Function: cc_capacity_table_alloc()
+ *
+ *  Description: Allocates a zeroed table of count elements and records it
+ *               for the capacity report. The table is a single contiguous
+ *               block so index based iteration stays as cheap as it was
+ *               with the static arrays.
+ *
+ *  Returns:     the table or NULL on allocation failure.
+ */
+void *
+cc_capacity_table_alloc (const char *name, uint32_t count, uint32_t elem_size)
+{
+    void *table;
+    int i;
+
+    table = cpr_calloc(count, elem_size);
+    if (table == NULL) {
+        err_msg("capacity: unable to allocate %s (%u x %u bytes)\n",
+                name, count, elem_size);
+        return NULL;
+    }
+
+    cc_capacity_lock();
+    for (i = 0; i < CC_CAPACITY_MAX_TABLES; i++) {
+        if (capacity_tables[i].name == NULL) {
+            capacity_tables[i].name = name;
+            capacity_tables[i].table = table;
+            capacity_tables[i].count = count;
+            capacity_tables[i].elem_size = elem_size;
+            break;
+        }
+    }
+    cc_capacity_unlock();
+    return table;
+}
+
+/*
+ *  Function: cc_capacity_table_free()
+ *
+ *  Description: Releases a table allocated by cc_capacity_table_alloc().
+ */
+void
+cc_capacity_table_free (void *table)
+{
+    int i;
+
+    if (table == NULL) {
+        return;
+    }
+    cc_capacity_lock();
+    for (i = 0; i < CC_CAPACITY_MAX_TABLES; i++) {
+        if (capacity_tables[i].table == table) {
+            memset(&capacity_tables[i], 0, sizeof(cc_capacity_table_t));
+            break;
+        }
+    }
+    cc_capacity_unlock();
+    cpr_free(table);
+}
+
+/*
+ *  Function: cc_capacity_total_bytes()
+ *
+ *  Returns:     bytes currently held by the capacity sized tables.
+ */
+uint32_t
+cc_capacity_total_bytes (void)
+{
+    uint32_t total = 0;
+    int i;
+
+    cc_capacity_lock();
+    for (i = 0; i < CC_CAPACITY_MAX_TABLES; i++) {
+        if (capacity_tables[i].name) {
+            total += capacity_tables[i].count * capacity_tables[i].elem_size;
+        }
+    }
+    cc_capacity_unlock();
+    return total;
+}
+
+/*
+ *  Function: show_capacity_cmd()
+ *
+ *  Description: "show capacity" callback. Lists every capacity sized table
+ *               with its element count and memory use.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_capacity_cmd (cc_int32_t argc, const char *argv[])
+{
+    uint32_t total = 0;
+    uint32_t bytes;
+    int i;
+
+    debugif_printf("\n------ Call Capacity ------\n");
+    debugif_printf("max calls: %d\n", g_cc_max_calls);
+    debugif_printf("%-24s %8s %8s %10s\n", "table", "entries", "size", "bytes");
+
+    cc_capacity_lock();
+    for (i = 0; i < CC_CAPACITY_MAX_TABLES; i++) {
+        if (capacity_tables[i].name == NULL) {
+            continue;
+        }
+        bytes = capacity_tables[i].count * capacity_tables[i].elem_size;
+        total += bytes;
+        debugif_printf("%-24s %8u %8u %10u\n", capacity_tables[i].name,
+                       capacity_tables[i].count, capacity_tables[i].elem_size,
+                       bytes);
+    }
+    cc_capacity_unlock();
+
+    debugif_printf("total: %u bytes\n", total);
+    return (0);
+}
@@ -0,0 +1,445 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "cpr.h"
+#include "cpr_stdlib.h"
+#include "cpr_string.h"
+#include "cpr_locks.h"
+#include "cpr_timers.h"
+#include "phone_debug.h"
+#include "debug.h"
+#include "cc_latency.h"
+
+#ifndef SIP_OS_WINDOWS
+#include <pthread.h>
+#endif
+
+typedef struct {
+    boolean  active;
+    uint32_t slot;
+    uint32_t start;
+    uint32_t wait;
+} cc_latency_current_t;
+
+static const char *latency_queue_names[CC_LATENCY_QUEUE_MAX] = {
+    "SIP", "GSM", "CCAPP", "MISC"
+};
+
+static const uint32_t latency_bucket_bounds[CC_LATENCY_BUCKETS - 1] = {
+    10, 50, 100, 500, 1000, 5000, 50000
+};
+
+static boolean latency_enabled = TRUE;
+
+/* written only by the consumer of each queue */
+static cc_latency_stats_t latency_stats[CC_LATENCY_QUEUE_MAX]
+                                       [CC_LATENCY_MAX_CMDS];
+static cc_latency_current_t latency_current[CC_LATENCY_QUEUE_MAX];
+/* set by cc_latency_reset(), acted upon by the consumer */
+static volatile boolean latency_reset_pending[CC_LATENCY_QUEUE_MAX];
+
+static cprMutex_t latency_trace_mutex = NULL;
+static uint32_t latency_next_trace = 0;
+
+static cprTimer_t latency_dump_timer = NULL;
+static uint32_t latency_dump_interval = 0;
+
+/*
+ * Trace id of the message the calling thread is processing, 0 if none.
+ */
+#ifdef SIP_OS_WINDOWS
+static __declspec(thread) uint32_t latency_thread_trace;
+
+static uint32_t
+cc_latency_get_thread_trace (void)
+{
+    return latency_thread_trace;
+}
+
+static void
+cc_latency_set_thread_trace (uint32_t trace)
+{
+    latency_thread_trace = trace;
+}
+#else
+static pthread_key_t latency_trace_key;
+static pthread_once_t latency_trace_once = PTHREAD_ONCE_INIT;
+static boolean latency_trace_key_valid = FALSE;
+
+static void
+cc_latency_create_trace_key (void)
+{
+    if (pthread_key_create(&latency_trace_key, NULL) == 0) {
+        latency_trace_key_valid = TRUE;
+    }
+}
+
+static uint32_t
+cc_latency_get_thread_trace (void)
+{
+    (void) pthread_once(&latency_trace_once, cc_latency_create_trace_key);
+    if (!latency_trace_key_valid) {
+        return 0;
+    }
+    return (uint32_t)(long) pthread_getspecific(latency_trace_key);
+}
+
+static void
+cc_latency_set_thread_trace (uint32_t trace)
+{
+    (void) pthread_once(&latency_trace_once, cc_latency_create_trace_key);
+    if (latency_trace_key_valid) {
+        (void) pthread_setspecific(latency_trace_key, (void *)(long) trace);
+    }
+}
+#endif
+
+static uint32_t
+cc_latency_new_trace (void)
+{
+    uint32_t trace;
+
+    if (latency_trace_mutex) {
+        (void) cprGetMutex(latency_trace_mutex);
+    }
+    if (++latency_next_trace == 0) {
+        latency_next_trace = 1;
+    }
+    trace = latency_next_trace;
+    if (latency_trace_mutex) {
+        (void) cprReleaseMutex(latency_trace_mutex);
+    }
+    return trace;
+}
+
+static uint32_t
+cc_latency_bucket (uint32_t us)
+{
+    uint32_t i;
+
+    for (i = 0; i < CC_LATENCY_BUCKETS - 1; i++) {
+        if (us < latency_bucket_bounds[i]) {
+            return i;
+        }
+    }
+    return CC_LATENCY_BUCKETS - 1;
+}
+
+static uint32_t
+cc_latency_slot (uint32_t cmd)
+{
+    return (cmd < CC_LATENCY_MAX_CMDS) ? cmd : CC_LATENCY_MAX_CMDS - 1;
+}
+
+/*
+ *  Function: cc_latency_init()
+ *
+ *  Description: Called from ccPreInit before any task is started.
+ */
+void
+cc_latency_init (void)
+{
+    if (latency_trace_mutex == NULL) {
+        latency_trace_mutex = cprCreateMutex("latency trace");
+    }
+}
+
+/*
+ *  Function: cc_latency_set_enabled()
+ *
+ *  Description: Turns stamping and accounting on or off. Accounting for a
+ *               message only happens when it was stamped, so messages
+ *               already queued when it is switched on are not counted.
+ */
+void
+cc_latency_set_enabled (boolean enabled)
+{
+    latency_enabled = enabled;
+}
+
+/*
+ *  Function: cc_latency_stamp()
+ *
+ *  Description: Records the enqueue time of a message and the trace it
+ *               belongs to.
+ */
+void
+cc_latency_stamp (phn_syshdr_t *syshdr)
+{
+    uint32_t now;
+
+    if (!latency_enabled || syshdr == NULL) {
+        return;
+    }
+    /* 0 means not stamped; the clock reads 0 once every 71 minutes */
+    now = cprGetTimeUs();
+    syshdr->EnqTime = now ? now : 1;
+    syshdr->TraceId = cc_latency_get_thread_trace();
+    if (syshdr->TraceId == 0) {
+        syshdr->TraceId = cc_latency_new_trace();
+    }
+}
+
+/*
+ *  Function: cc_latency_begin()
+ *
+ *  Description: Called by the consumer of a queue before it processes a
+ *               message. The message's trace becomes the trace of the
+ *               calling thread until cc_latency_end().
+ */
+void
+cc_latency_begin (cc_latency_queue_e queue, phn_syshdr_t *syshdr)
+{
+    cc_latency_current_t *cur;
+    uint32_t now;
+
+    if (queue >= CC_LATENCY_QUEUE_MAX || syshdr == NULL) {
+        return;
+    }
+    cur = &latency_current[queue];
+    cur->active = FALSE;
+
+    if (latency_reset_pending[queue]) {
+        memset(latency_stats[queue], 0, sizeof(latency_stats[queue]));
+        latency_reset_pending[queue] = FALSE;
+    }
+
+    if (!latency_enabled || syshdr->EnqTime == 0) {
+        return;
+    }
+
+    /* timer expirations are stamped by CPR without a trace */
+    if (syshdr->TraceId == 0) {
+        syshdr->TraceId = cc_latency_new_trace();
+    }
+    cc_latency_set_thread_trace(syshdr->TraceId);
+
+    now = cprGetTimeUs();
+    cur->active = TRUE;
+    cur->slot = cc_latency_slot(syshdr->Cmd);
+    cur->start = now;
+    cur->wait = now - syshdr->EnqTime;
+}
+
+/*
+ *  Function: cc_latency_end()
+ *
+ *  Description: Called by the consumer of a queue once the message passed
+ *               to cc_latency_begin() has been processed.
+ */
+void
+cc_latency_end (cc_latency_queue_e queue)
+{
+    cc_latency_current_t *cur;
+    cc_latency_stats_t *stats;
+    uint32_t service;
+
+    if (queue >= CC_LATENCY_QUEUE_MAX) {
+        return;
+    }
+    cur = &latency_current[queue];
+    if (!cur->active) {
+        return;
+    }
+    cur->active = FALSE;
+    cc_latency_set_thread_trace(0);
+
+    service = cprGetTimeUs() - cur->start;
+    stats = &latency_stats[queue][cur->slot];
+
+    stats->count++;
+    stats->wait_total += cur->wait;
+    if (cur->wait > stats->wait_max) {
+        stats->wait_max = cur->wait;
+    }
+    stats->wait_hist[cc_latency_bucket(cur->wait)]++;
+
+    stats->service_total += service;
+    if (service > stats->service_max) {
+        stats->service_max = service;
+    }
+    stats->service_hist[cc_latency_bucket(service)]++;
+}
+
+/*
+ *  Function: cc_latency_current_trace()
+ *
+ *  Returns:     the trace id of the message the calling thread is
+ *               processing or 0. Meant for log lines that want to be
+ *               correlated with the latency figures.
+ */
+uint32_t
+cc_latency_current_trace (void)
+{
+    return cc_latency_get_thread_trace();
+}
+
+/*
+ *  Function: cc_latency_get_stats()
+ *
+ *  Description: Copies the counters for one command of one queue.
+ *
+ *  Returns:     FALSE if the queue is invalid or the command has not been
+ *               seen since the last reset.
+ */
+boolean
+cc_latency_get_stats (cc_latency_queue_e queue, uint32_t cmd,
+                      cc_latency_stats_t *stats)
+{
+    if (queue >= CC_LATENCY_QUEUE_MAX || stats == NULL) {
+        return FALSE;
+    }
+    *stats = latency_stats[queue][cc_latency_slot(cmd)];
+    return (stats->count != 0);
+}
+
+/*
+ *  Function: cc_latency_reset()
+ *
+ *  Description: Clears the counters of a queue. The consumer does the
+ *               clearing before its next message so it stays the only
+ *               writer.
+ */
+void
+cc_latency_reset (cc_latency_queue_e queue)
+{
+    if (queue < CC_LATENCY_QUEUE_MAX) {
+        latency_reset_pending[queue] = TRUE;
+    }
+}
+
+/*
+ *  Function: cc_latency_set_dump_interval()
+ *
+ *  Description: Sets the period, in seconds, of the latency dump. 0 turns
+ *               the dump off.
+ */
+void
+cc_latency_set_dump_interval (uint32_t secs)
+{
+    latency_dump_interval = secs;
+    if (latency_dump_timer == NULL) {
+        return;
+    }
+    (void) cprCancelTimer(latency_dump_timer);
+    if (secs) {
+        (void) cprStartTimer(latency_dump_timer, secs * 1000, NULL);
+    }
+}
+
+/*
+ *  Function: cc_latency_attach_dump_timer()
+ *
+ *  Description: Hands over the timer used for the periodic dump, or NULL
+ *               when its owner is shutting down.
+ */
+void
+cc_latency_attach_dump_timer (cprTimer_t timer)
+{
+    latency_dump_timer = timer;
+    if (timer && latency_dump_interval) {
+        (void) cprStartTimer(timer, latency_dump_interval * 1000, NULL);
+    }
+}
+
+void
+cc_latency_dump_timer_expired (void)
+{
+    cc_latency_dump();
+    if (latency_dump_timer && latency_dump_interval) {
+        (void) cprStartTimer(latency_dump_timer,
+                             latency_dump_interval * 1000, NULL);
+    }
+}
+
+/*
+ *  Function: cc_latency_dump()
+ *
+ *  Description: Prints every command seen on every queue with its average
+ *               and maximum wait and service times and both histograms.
+ */
+void
+cc_latency_dump (void)
+{
+    cc_latency_stats_t stats;
+    uint32_t q, cmd;
+
+    debugif_printf("\n------ Message Latency (us) ------\n");
+    debugif_printf("buckets: <10 <50 <100 <500 <1000 <5000 <50000 >=50000\n");
+    debugif_printf("%-6s %4s %8s %6s %6s %6s %6s\n", "queue", "cmd",
+                   "count", "w-avg", "w-max", "s-avg", "s-max");
+
+    for (q = 0; q < CC_LATENCY_QUEUE_MAX; q++) {
+        for (cmd = 0; cmd < CC_LATENCY_MAX_CMDS; cmd++) {
+            if (!cc_latency_get_stats((cc_latency_queue_e) q, cmd, &stats)) {
+                continue;
+            }
+            debugif_printf("%-6s %4u %8u %6u %6u %6u %6u\n",
+                           latency_queue_names[q], cmd, stats.count,
+                           (uint32_t) (stats.wait_total / stats.count),
+                           stats.wait_max,
+                           (uint32_t) (stats.service_total / stats.count),
+                           stats.service_max);
+            debugif_printf("       wait %u %u %u %u %u %u %u %u\n",
+                           stats.wait_hist[0], stats.wait_hist[1],
+                           stats.wait_hist[2], stats.wait_hist[3],
+                           stats.wait_hist[4], stats.wait_hist[5],
+                           stats.wait_hist[6], stats.wait_hist[7]);
+            debugif_printf("       serv %u %u %u %u %u %u %u %u\n",
+                           stats.service_hist[0], stats.service_hist[1],
+                           stats.service_hist[2], stats.service_hist[3],
+                           stats.service_hist[4], stats.service_hist[5],
+                           stats.service_hist[6], stats.service_hist[7]);
+        }
+    }
+}
+
+/*
+ *  Function: show_msg_latency_cmd()
+ *
+ *  Description: "show msg-latency" callback.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_msg_latency_cmd (cc_int32_t argc, const char *argv[])
+{
+    cc_latency_dump();
+    return (0);
+}
@@ -0,0 +1,492 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "cpr.h"
+#include "cpr_stdlib.h"
+#include "cpr_string.h"
+#include "cpr_locks.h"
+#include "cpr_errno.h"
+#include "phone_debug.h"
+#include "debug.h"
+#include "ccapi.h"
+#include "ccsip_task.h"
+#include "cc_shutdown.h"
+
+/* Shutdown waits on at most this many transactions; more wait out the deadline */
+#define CC_SHUTDOWN_MAX_TXNS   256
+#define CC_SHUTDOWN_CALL_ID_LEN 128
+
+typedef struct {
+    boolean           active;
+    cc_shutdown_txn_e type;
+    uint32_t          cseq;
+    char              call_id[CC_SHUTDOWN_CALL_ID_LEN];
+} cc_shutdown_txn_t;
+
+static const char *shutdown_phase_names[CC_SHUTDOWN_PHASE_MAX] = {
+    "SIP", "GSM", "CCApp", "Misc App"
+};
+
+static const cc_srcs_t shutdown_phase_tasks[CC_SHUTDOWN_PHASE_MAX] = {
+    CC_SRC_SIP, CC_SRC_GSM, CC_SRC_CCAPP, CC_SRC_MISC_APP
+};
+
+static const char *shutdown_state_names[] = {
+    "idle", "draining", "drained", "unloaded"
+};
+
+static cprMutex_t shutdown_mutex = NULL;
+static cprSignal_t shutdown_done_signal = NULL;
+
+/* an unload sequence started by cc_shutdown_start() is in progress */
+static boolean shutdown_running = FALSE;
+static boolean shutdown_done = FALSE;
+static cc_shutdown_stats_t shutdown_stats[CC_SHUTDOWN_PHASE_MAX];
+static uint32_t shutdown_phase_start[CC_SHUTDOWN_PHASE_MAX];
+static uint32_t shutdown_total_ms = 0;
+
+static boolean shutdown_tracking = FALSE;
+static boolean shutdown_txn_overflow = FALSE;
+static cc_shutdown_txn_t shutdown_txns[CC_SHUTDOWN_MAX_TXNS];
+static uint32_t shutdown_txn_pending_count[CC_SHUTDOWN_TXN_MAX];
+
+extern void send_task_unload_msg(cc_srcs_t dest_id);
+
+static void
+cc_shutdown_lock (void)
+{
+    if (shutdown_mutex) {
+        (void) cprGetMutex(shutdown_mutex);
+    }
+}
+
+static void
+cc_shutdown_unlock (void)
+{
+    if (shutdown_mutex) {
+        (void) cprReleaseMutex(shutdown_mutex);
+    }
+}
+
+/* called with the lock held */
+static void
+cc_shutdown_clear_txns (void)
+{
+    memset(shutdown_txns, 0, sizeof(shutdown_txns));
+    memset(shutdown_txn_pending_count, 0, sizeof(shutdown_txn_pending_count));
+    shutdown_txn_overflow = FALSE;
+}
+
+/* called with the lock held */
+static cc_shutdown_txn_t *
+cc_shutdown_find_txn (cc_shutdown_txn_e type, const char *call_id,
+                      uint32_t cseq)
+{
+    int i;
+
+    for (i = 0; i < CC_SHUTDOWN_MAX_TXNS; i++) {
+        if (shutdown_txns[i].active && shutdown_txns[i].type == type &&
+            shutdown_txns[i].cseq == cseq &&
+            strncmp(shutdown_txns[i].call_id, call_id,
+                    CC_SHUTDOWN_CALL_ID_LEN - 1) == 0) {
+            return &shutdown_txns[i];
+        }
+    }
+    return NULL;
+}
+
+/* called with the lock held */
+static void
+cc_shutdown_begin_phase (cc_shutdown_phase_e phase)
+{
+    shutdown_stats[phase].state = CC_SHUTDOWN_DRAINING;
+    shutdown_phase_start[phase] = cprGetTimeMs();
+}
+
+/*
+ *  Function: cc_shutdown_init()
+ *
+ *  Description: Called from ccPreInit before any task is started.
+ */
+void
+cc_shutdown_init (void)
+{
+    if (shutdown_mutex == NULL) {
+        shutdown_mutex = cprCreateMutex("shutdown");
+    }
+    if (shutdown_done_signal == NULL) {
+        shutdown_done_signal = cprCreateSignal("shutdown done");
+    }
+}
+
+/*
+ *  Function: cc_shutdown_start()
+ *
+ *  Description: Starts the unload sequence with the SIP phase. The SIP
+ *               task unregisters, ends its calls and subscriptions and
+ *               reports back through cc_shutdown_phase_drained(). Does
+ *               nothing if a sequence is already running.
+ */
+void
+cc_shutdown_start (void)
+{
+    static const char fname[] = "cc_shutdown_start";
+
+    cc_shutdown_lock();
+    if (shutdown_running) {
+        cc_shutdown_unlock();
+        DEF_DEBUG(DEB_F_PREFIX"shutdown already in progress\n",
+                  DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
+        return;
+    }
+    shutdown_running = TRUE;
+    shutdown_done = FALSE;
+    memset(shutdown_stats, 0, sizeof(shutdown_stats));
+    cc_shutdown_begin_phase(CC_SHUTDOWN_PHASE_SIP);
+    cc_shutdown_unlock();
+
+    DEF_DEBUG(DEB_F_PREFIX"draining SIP\n",
+              DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
+    SIPTaskPostShutdown(SIP_EXTERNAL, CC_CAUSE_SHUTDOWN, "");
+}
+
+/*
+ *  Function: cc_shutdown_wait()
+ *
+ *  Description: Waits for the unload sequence to finish.
+ *
+ *  Returns:     TRUE if every task has unloaded, FALSE on timeout.
+ */
+boolean
+cc_shutdown_wait (uint32_t timeout)
+{
+    uint32_t start = cprGetTimeMs();
+    uint32_t elapsed;
+    boolean done;
+
+    cc_shutdown_lock();
+    while (!shutdown_done && shutdown_done_signal) {
+        elapsed = cprGetTimeMs() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        (void) cprWaitSignal(shutdown_done_signal, shutdown_mutex,
+                             timeout - elapsed);
+    }
+    done = shutdown_done;
+    cc_shutdown_unlock();
+    return done;
+}
+
+/*
+ *  Function: cc_shutdown_phase_drained()
+ *
+ *  Description: A task has nothing left to wait for. Only SIP drains
+ *               separately from unloading; when it does, transactions
+ *               still open are counted as abandoned and the SIP thread is
+ *               told to unload.
+ */
+void
+cc_shutdown_phase_drained (cc_shutdown_phase_e phase)
+{
+    cc_shutdown_stats_t *stats;
+    boolean unload;
+
+    if (phase >= CC_SHUTDOWN_PHASE_MAX) {
+        return;
+    }
+    cc_shutdown_lock();
+    stats = &shutdown_stats[phase];
+    unload = (shutdown_running && stats->state == CC_SHUTDOWN_DRAINING);
+    if (unload) {
+        stats->state = CC_SHUTDOWN_DRAINED;
+        stats->drain_ms = cprGetTimeMs() - shutdown_phase_start[phase];
+    }
+    if (phase == CC_SHUTDOWN_PHASE_SIP) {
+        if (unload) {
+            stats->abandoned =
+                shutdown_txn_pending_count[CC_SHUTDOWN_TXN_REGISTER] +
+                shutdown_txn_pending_count[CC_SHUTDOWN_TXN_BYE] +
+                shutdown_txn_pending_count[CC_SHUTDOWN_TXN_UNSUBSCRIBE];
+        }
+        shutdown_tracking = FALSE;
+        cc_shutdown_clear_txns();
+    }
+    cc_shutdown_unlock();
+
+    if (unload) {
+        send_task_unload_msg(shutdown_phase_tasks[phase]);
+    }
+}
+
+/*
+ *  Function: cc_shutdown_phase_unloaded()
+ *
+ *  Description: Called by a task on its way out, just before its thread
+ *               is destroyed. Starts the next phase, or once Misc App is
+ *               gone, reports the timings and wakes cc_shutdown_wait().
+ */
+void
+cc_shutdown_phase_unloaded (cc_shutdown_phase_e phase)
+{
+    static const char fname[] = "cc_shutdown_phase_unloaded";
+    cc_shutdown_stats_t *stats;
+    cc_shutdown_phase_e next = CC_SHUTDOWN_PHASE_MAX;
+    uint32_t now;
+    int i;
+
+    if (phase >= CC_SHUTDOWN_PHASE_MAX) {
+        return;
+    }
+    cc_shutdown_lock();
+    if (!shutdown_running) {
+        /* unloaded outside of cc_shutdown_start() */
+        cc_shutdown_unlock();
+        return;
+    }
+    now = cprGetTimeMs();
+    stats = &shutdown_stats[phase];
+    if (stats->state == CC_SHUTDOWN_DRAINING) {
+        /* the task's queue drained up to its THREAD_UNLOAD */
+        stats->drain_ms = now - shutdown_phase_start[phase];
+    } else {
+        stats->unload_ms = now - shutdown_phase_start[phase] - stats->drain_ms;
+    }
+    stats->state = CC_SHUTDOWN_UNLOADED;
+
+    if (phase + 1 < CC_SHUTDOWN_PHASE_MAX) {
+        next = (cc_shutdown_phase_e) (phase + 1);
+        cc_shutdown_begin_phase(next);
+    } else {
+        shutdown_total_ms = now - shutdown_phase_start[CC_SHUTDOWN_PHASE_SIP];
+        for (i = 0; i < CC_SHUTDOWN_PHASE_MAX; i++) {
+            DEF_DEBUG(DEB_F_PREFIX"%s: drain %u ms unload %u ms txns %u"
+                      " abandoned %u\n", DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname),
+                      shutdown_phase_names[i], shutdown_stats[i].drain_ms,
+                      shutdown_stats[i].unload_ms, shutdown_stats[i].txns,
+                      shutdown_stats[i].abandoned);
+        }
+        DEF_DEBUG(DEB_F_PREFIX"shutdown complete in %u ms\n",
+                  DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname), shutdown_total_ms);
+        shutdown_running = FALSE;
+        shutdown_done = TRUE;
+        if (shutdown_done_signal) {
+            (void) cprPostSignal(shutdown_done_signal);
+        }
+    }
+    cc_shutdown_unlock();
+
+    if (next != CC_SHUTDOWN_PHASE_MAX) {
+        send_task_unload_msg(shutdown_phase_tasks[next]);
+    }
+}
+
+/*
+ *  Function: cc_shutdown_track_txns()
+ *
+ *  Description: Starts or stops recording the transactions SIP sends
+ *               while it drains. Either way the table starts out empty.
+ */
+void
+cc_shutdown_track_txns (boolean enable)
+{
+    cc_shutdown_lock();
+    shutdown_tracking = enable;
+    cc_shutdown_clear_txns();
+    cc_shutdown_unlock();
+}
+
+boolean
+cc_shutdown_tracking_txns (void)
+{
+    return shutdown_tracking;
+}
+
+/*
+ *  Function: cc_shutdown_txn_sent()
+ *
+ *  Description: Records a request the drain waits for. Sending the same
+ *               Call-ID and CSeq again, as a retransmission does, records
+ *               nothing new.
+ */
+void
+cc_shutdown_txn_sent (cc_shutdown_txn_e type, const char *call_id,
+                      uint32_t cseq)
+{
+    static const char fname[] = "cc_shutdown_txn_sent";
+    int i;
+
+    if (type >= CC_SHUTDOWN_TXN_MAX || call_id == NULL) {
+        return;
+    }
+    cc_shutdown_lock();
+    if (!shutdown_tracking ||
+        cc_shutdown_find_txn(type, call_id, cseq) != NULL) {
+        cc_shutdown_unlock();
+        return;
+    }
+    for (i = 0; i < CC_SHUTDOWN_MAX_TXNS; i++) {
+        if (!shutdown_txns[i].active) {
+            break;
+        }
+    }
+    if (i == CC_SHUTDOWN_MAX_TXNS) {
+        /* cannot tell when this one is answered, wait for the deadline */
+        if (!shutdown_txn_overflow) {
+            err_msg("%s: more than %d transactions, draining to the deadline\n",
+                    fname, CC_SHUTDOWN_MAX_TXNS);
+        }
+        shutdown_txn_overflow = TRUE;
+        cc_shutdown_unlock();
+        return;
+    }
+    shutdown_txns[i].active = TRUE;
+    shutdown_txns[i].type = type;
+    shutdown_txns[i].cseq = cseq;
+    sstrncpy(shutdown_txns[i].call_id, call_id, CC_SHUTDOWN_CALL_ID_LEN);
+    shutdown_txn_pending_count[type]++;
+    shutdown_stats[CC_SHUTDOWN_PHASE_SIP].txns++;
+    cc_shutdown_unlock();
+}
+
+/*
+ *  Function: cc_shutdown_txn_answered()
+ *
+ *  Description: A final response has arrived.
+ *
+ *  Returns:     TRUE if it answered a recorded transaction.
+ */
+boolean
+cc_shutdown_txn_answered (cc_shutdown_txn_e type, const char *call_id,
+                          uint32_t cseq)
+{
+    cc_shutdown_txn_t *txn;
+
+    if (type >= CC_SHUTDOWN_TXN_MAX || call_id == NULL) {
+        return FALSE;
+    }
+    cc_shutdown_lock();
+    txn = shutdown_tracking ? cc_shutdown_find_txn(type, call_id, cseq) : NULL;
+    if (txn) {
+        txn->active = FALSE;
+        shutdown_txn_pending_count[type]--;
+    }
+    cc_shutdown_unlock();
+    return (txn != NULL);
+}
+
+/*
+ *  Function: cc_shutdown_txn_pending()
+ *
+ *  Returns:     the number of recorded transactions of 'type' still
+ *               unanswered, of all types for CC_SHUTDOWN_TXN_MAX. Never
+ *               zero once the table has overflowed.
+ */
+uint32_t
+cc_shutdown_txn_pending (cc_shutdown_txn_e type)
+{
+    uint32_t count = 0;
+    int i;
+
+    cc_shutdown_lock();
+    if (type < CC_SHUTDOWN_TXN_MAX) {
+        count = shutdown_txn_pending_count[type];
+    } else {
+        for (i = 0; i < CC_SHUTDOWN_TXN_MAX; i++) {
+            count += shutdown_txn_pending_count[i];
+        }
+    }
+    if (shutdown_txn_overflow && count == 0) {
+        count = 1;
+    }
+    cc_shutdown_unlock();
+    return count;
+}
+
+/*
+ *  Function: cc_shutdown_get_stats()
+ *
+ *  Description: Copies the figures of one phase of the last (or current)
+ *               unload sequence.
+ *
+ *  Returns:     FALSE if the phase is invalid.
+ */
+boolean
+cc_shutdown_get_stats (cc_shutdown_phase_e phase, cc_shutdown_stats_t *stats)
+{
+    if (phase >= CC_SHUTDOWN_PHASE_MAX || stats == NULL) {
+        return FALSE;
+    }
+    cc_shutdown_lock();
+    *stats = shutdown_stats[phase];
+    cc_shutdown_unlock();
+    return TRUE;
+}
+
+/*
+ *  Function: show_shutdown_cmd()
+ *
+ *  Description: "show shutdown" callback.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_shutdown_cmd (cc_int32_t argc, const char *argv[])
+{
+    cc_shutdown_stats_t stats;
+    int i;
+
+    debugif_printf("\n------ Shutdown ------\n");
+    debugif_printf("%-9s %-9s %8s %9s %5s %9s\n", "phase", "state",
+                   "drain-ms", "unload-ms", "txns", "abandoned");
+    for (i = 0; i < CC_SHUTDOWN_PHASE_MAX; i++) {
+        (void) cc_shutdown_get_stats((cc_shutdown_phase_e) i, &stats);
+        debugif_printf("%-9s %-9s %8u %9u %5u %9u\n", shutdown_phase_names[i],
+                       shutdown_state_names[stats.state], stats.drain_ms,
+                       stats.unload_ms, stats.txns, stats.abandoned);
+    }
+    debugif_printf("pending: register %u bye %u unsubscribe %u\n",
+                   cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_REGISTER),
+                   cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_BYE),
+                   cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_UNSUBSCRIBE));
+    if (shutdown_done) {
+        debugif_printf("complete in %u ms\n", shutdown_total_ms);
+    }
+    return (0);
+}
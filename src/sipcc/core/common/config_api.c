@@ -41,6 +41,7 @@
 #include "cpr_stdio.h"
 #include "cpr_string.h"
 #include "config.h"
+#include "config_snapshot.h"
 #include "dns_utils.h"
 #include "phone_debug.h"
 #include "ccapi.h"
@@ -57,7 +58,35 @@ cc_int32_t ConfigDebug;
  *
  * We should be able to set and retrieve any type of value
  * using one of these routines.
+ *
+ * Sets go to the staging block and are then published as a new
+ * snapshot; gets read the current snapshot (see config_snapshot.h).
+ */
+
+/*
+ *  Function: config_view_entry()
+ *
+ *  Description: Point a copy of a table entry at the value in a pinned
+ *               snapshot, so its print function reads from there.
+ *
+ *  Parameters: id   - The id of the config entry
+ *              snap - pinned snapshot, or NULL for the staging block
+ *              view - copy of the entry to fill in
+ *
+ *  Returns: view
  */
+static const var_t *
+config_view_entry (int id, const config_snapshot_t *snap, var_t *view)
+{
+    const void *addr;
+
+    *view = prot_cfg_table[id];
+    addr = config_snapshot_addr(snap, id);
+    if (addr != NULL) {
+        view->addr = (void *) addr;
+    }
+    return view;
+}
 
 
 /*
@@ -75,6 +104,8 @@ void
 config_get_string (int id, char *buffer, int buffer_len)
 {
     const var_t *entry;
+    const config_snapshot_t *snap;
+    var_t view;
     char *buf_start;
 
     /*
@@ -88,7 +119,10 @@ config_get_string (int id, char *buffer, int buffer_len)
                     id);
         } else {
             buf_start = buffer;
-            entry->print_func(entry, buffer, buffer_len);
+            snap = config_snapshot_acquire();
+            entry->print_func(config_view_entry(id, snap, &view), buffer,
+                              buffer_len);
+            config_snapshot_release(snap);
             CONFIG_DEBUG(DEB_F_PREFIX"CFGID %d: get str: %s = %s\n", DEB_F_PREFIX_ARGS(CONFIG_API, "config_get_string"), id, entry->name,
                          buf_start);
         }
@@ -112,10 +146,14 @@ void
 config_set_string (int id, char *buffer)
 {
     const var_t *entry;
+    int rc;
 
     if ((id >= 0) && (id < CFGID_PROTOCOL_MAX)) {
         entry = &prot_cfg_table[id];
-        if (entry->parse_func(entry, buffer)) {
+        config_snapshot_write_lock();
+        rc = entry->parse_func(entry, buffer);
+        config_snapshot_write_unlock();
+        if (rc) {
             /* Parse function returned an error */
             CONFIG_ERROR(CFG_F_PREFIX"Parse function failed. ID: %d %s:%s\n", "config_set_string", id, entry->name, buffer);
         } else {
@@ -213,6 +251,9 @@ void
 config_get_value (int id, void *buffer, int length)
 {
     const var_t *entry;
+    const config_snapshot_t *snap;
+    const void *addr;
+    int32_t value;
 
     /*
      *  Retrieve raw entry from table.....
@@ -220,7 +261,16 @@ config_get_value (int id, void *buffer, int length)
     if ((id >= 0) && (id < CFGID_PROTOCOL_MAX)) {
         entry = &prot_cfg_table[id];
         if (length == entry->length) {
-            memcpy(buffer, entry->addr, entry->length);
+            if (config_snapshot_fields[id].length == sizeof(int32_t)) {
+                /* no pin needed, see config_snapshot.h */
+                value = cprAtomicLoad(&config_snapshot_ints[id]);
+                memcpy(buffer, &value, sizeof(value));
+            } else {
+                snap = config_snapshot_acquire();
+                addr = config_snapshot_addr(snap, id);
+                memcpy(buffer, addr ? addr : entry->addr, entry->length);
+                config_snapshot_release(snap);
+            }
 
             if (ConfigDebug) {
                 print_config_value(id, "Get Val", entry->name, buffer, length);
@@ -263,7 +313,9 @@ config_set_value (int id, void *buffer, int length)
                     "config_set_value", entry->name, entry->length, length);
             return;
         }
+        config_snapshot_write_lock();
         memcpy(entry->addr, buffer, entry->length);
+        config_snapshot_write_unlock();
         if (ConfigDebug) {
             print_config_value(id, "Set Val", entry->name, buffer, length);
         }
@@ -284,6 +336,8 @@ char *
 get_printable_cfg(unsigned int indx, char *buf, unsigned int len)
 {
    const var_t *table;
+   const config_snapshot_t *snap;
+   var_t view;
    buf[0]=0;
    
    table = &prot_cfg_table[indx];
@@ -293,7 +347,9 @@ get_printable_cfg(unsigned int indx, char *buf, unsigned int len)
      // and add an invisible one
      strncpy(buf, "**********", MAX_CONFIG_VAL_PRINT_LEN);
    } else if ( table->print_func ) {
-     table->print_func(table, buf, len);
+     snap = config_snapshot_acquire();
+     table->print_func(config_view_entry(indx, snap, &view), buf, len);
+     config_snapshot_release(snap);
    }
 
    if ( buf[0] == 0 ) {
@@ -316,15 +372,20 @@ cc_int32_t
 show_config_cmd (cc_int32_t argc, const char *argv[])
 {
     const var_t *table;
+    const config_snapshot_t *snap;
+    var_t view;
     char buf[MAX_CONFIG_VAL_PRINT_LEN];
     int i, feat;
 
     debugif_printf("\n------ Current *Cache* Configuration ------\n");
     table = prot_cfg_table;
 
+    /* one version for the whole device section */
+    snap = config_snapshot_acquire();
     for ( i=0; i < CFGID_LINE_FEATURE; i++ ) {
         if (table->print_func) {
-            table->print_func(table, buf, sizeof(buf));
+            table->print_func(config_view_entry(i, snap, &view), buf,
+                              sizeof(buf));
 
             // If this field has a password, print the param name, but NOT the
             // real password
@@ -336,6 +397,7 @@ show_config_cmd (cc_int32_t argc, const char *argv[])
         }
         table++;
     }
+    config_snapshot_release(snap);
 
     debugif_printf("%s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s %s\n",
         prot_cfg_table[CFGID_LINE_INDEX].name,
@@ -53,6 +53,7 @@
 #include "cc_device_feature.h"
 #include "ccapi_snapshot.h"
 #include "config_api.h"
+#include "config_snapshot.h"
 #include "capability_set.h"
 #include "util_string.h"
 
@@ -664,8 +665,11 @@ void config_parser_handle_fcp_file (char* fcpTemplateFile)
  */
 int config_setup_main( const char *sipUser, const char *sipPassword, const char *sipDomain)
 {
+    /* the parsed settings go live as one version */
+    config_snapshot_begin_update();
     config_setup_elements(sipUser, sipPassword, sipDomain);
 	update_security_mode_and_ports();
+    config_snapshot_end_update();
 
     // Take care of Fetch and apply of FCP and DialPlan if configured and necessary
     if (apply_config == FALSE) {
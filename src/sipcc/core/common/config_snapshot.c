@@ -0,0 +1,612 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cpr_string.h"
+#include "cpr_locks.h"
+#include "phone_debug.h"
+#include "debug.h"
+#include "config.h"
+#include "config_snapshot.h"
+
+typedef struct {
+    boolean                  active;
+    int                      first_id;
+    int                      count;
+    config_snapshot_notify_t notify;
+    void                    *data;
+} config_snapshot_sub_t;
+
+typedef struct {
+    config_snapshot_notify_t notify;
+    void                    *data;
+    int                      id;
+} config_snapshot_change_t;
+
+/*
+ * A snapshot buffer. Buffers are never freed, only rewritten once they
+ * are neither current nor pinned, so a reader may pin one it found
+ * current a moment ago: the pin only counts if the buffer is still the
+ * current one afterwards.
+ */
+typedef struct config_snapshot_buf_s {
+    config_snapshot_t             snap;     /* first, readers get &snap */
+    volatile int32_t              readers;
+    struct config_snapshot_buf_s *next;
+} config_snapshot_buf_t;
+
+extern var_t prot_cfg_table[];
+
+config_snapshot_field_t config_snapshot_fields[CFGID_PROTOCOL_MAX];
+volatile int32_t config_snapshot_ints[CFGID_PROTOCOL_MAX];
+
+static cprMutex_t snapshot_mutex = NULL;
+static char *snapshot_staging = NULL;
+static uint32_t snapshot_size = 0;
+
+/* NULL until the first version is published */
+static void * volatile snapshot_current = NULL;
+static volatile int32_t snapshot_version = 0;
+
+/* guarded by snapshot_mutex */
+static config_snapshot_buf_t *snapshot_bufs = NULL;
+static uint32_t snapshot_batch_depth = 0;
+static config_snapshot_sub_t snapshot_subs[CONFIG_SNAPSHOT_MAX_SUBSCRIBERS];
+static config_snapshot_stats_t snapshot_stats;
+
+/*
+ *  Function: config_snapshot_acquire()
+ *
+ *  Description: Pin the current snapshot. The pin is taken on the buffer
+ *               and then the buffer is checked to still be the current
+ *               one, since a publish only rewrites a buffer it finds
+ *               unpinned after it stopped being current.
+ *
+ *  Returns: the snapshot, to be given back with config_snapshot_release(),
+ *           or NULL before the snapshots are set up
+ */
+const config_snapshot_t *
+config_snapshot_acquire (void)
+{
+    config_snapshot_buf_t *buf;
+
+    for (;;) {
+        buf = (config_snapshot_buf_t *) cprAtomicLoadPtr(&snapshot_current);
+        if (buf == NULL) {
+            return NULL;
+        }
+        (void) cprAtomicIncrement(&buf->readers);
+        if (cprAtomicLoadPtr(&snapshot_current) == buf) {
+            return &buf->snap;
+        }
+        /* a publish got in between; the buffer may be rewritten */
+        (void) cprAtomicDecrement(&buf->readers);
+    }
+}
+
+/*
+ *  Function: config_snapshot_release()
+ *
+ *  Description: Drop a pin taken by config_snapshot_acquire().
+ *
+ *  Parameters: snap - the snapshot, may be NULL
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_release (const config_snapshot_t *snap)
+{
+    if (snap != NULL) {
+        (void) cprAtomicDecrement(&((config_snapshot_buf_t *) snap)->readers);
+    }
+}
+
+/*
+ *  Function: config_snapshot_version()
+ *
+ *  Returns: the version of the current snapshot, 0 before there is one
+ */
+uint32_t
+config_snapshot_version (void)
+{
+    return (uint32_t) cprAtomicLoad(&snapshot_version);
+}
+
+/*
+ *  Function: config_snapshot_diff()
+ *
+ *  Description: Collect the subscribed ids that differ between two
+ *               versions. Called with the lock held.
+ *
+ *  Parameters: prev, next - the old and new blocks
+ *              count      - set to the number of changes returned
+ *
+ *  Returns: cpr_malloc'ed list of changes, or NULL if there are none
+ */
+static config_snapshot_change_t *
+config_snapshot_diff (const char *prev, const char *next, int *count)
+{
+    config_snapshot_change_t *changes;
+    const config_snapshot_sub_t *sub;
+    const config_snapshot_field_t *field;
+    int max = 0;
+    int i, id;
+
+    *count = 0;
+    for (i = 0; i < CONFIG_SNAPSHOT_MAX_SUBSCRIBERS; i++) {
+        if (snapshot_subs[i].active) {
+            max += snapshot_subs[i].count;
+        }
+    }
+    if (max == 0) {
+        return NULL;
+    }
+    changes = (config_snapshot_change_t *)
+        cpr_malloc(max * sizeof(config_snapshot_change_t));
+    if (changes == NULL) {
+        CONFIG_ERROR(CFG_F_PREFIX"no memory for %d changes\n",
+                     "config_snapshot_diff", max);
+        return NULL;
+    }
+    for (i = 0; i < CONFIG_SNAPSHOT_MAX_SUBSCRIBERS; i++) {
+        sub = &snapshot_subs[i];
+        if (!sub->active) {
+            continue;
+        }
+        for (id = sub->first_id; id < sub->first_id + sub->count; id++) {
+            field = &config_snapshot_fields[id];
+            if (field->length != 0 &&
+                memcmp(prev + field->offset, next + field->offset,
+                       field->length) != 0) {
+                changes[*count].notify = sub->notify;
+                changes[*count].data = sub->data;
+                changes[*count].id = id;
+                (*count)++;
+            }
+        }
+    }
+    if (*count == 0) {
+        cpr_free(changes);
+        return NULL;
+    }
+    snapshot_stats.notifications += *count;
+    return changes;
+}
+
+/*
+ *  Function: config_snapshot_spare()
+ *
+ *  Description: Find a buffer to publish the next version in: one that
+ *               is not current and has no readers, or a new one if all
+ *               of them are pinned. Called with the lock held.
+ *
+ *  Parameters: cur - the current buffer, NULL before the first version
+ *
+ *  Returns: the buffer, or NULL if there is no memory for another
+ */
+static config_snapshot_buf_t *
+config_snapshot_spare (config_snapshot_buf_t *cur)
+{
+    config_snapshot_buf_t *buf;
+
+    for (buf = snapshot_bufs; buf != NULL; buf = buf->next) {
+        if (buf != cur && cprAtomicRead(&buf->readers) == 0) {
+            return buf;
+        }
+    }
+
+    buf = (config_snapshot_buf_t *) cpr_calloc(1, sizeof(*buf));
+    if (buf != NULL) {
+        buf->snap.block = (const char *) cpr_malloc(snapshot_size);
+    }
+    if (buf == NULL || buf->snap.block == NULL) {
+        CONFIG_ERROR(CFG_F_PREFIX"no memory for a snapshot of %u bytes\n",
+                     "config_snapshot_spare", snapshot_size);
+        cpr_free(buf);
+        return NULL;
+    }
+    buf->next = snapshot_bufs;
+    snapshot_bufs = buf;
+    snapshot_stats.buffers++;
+    return buf;
+}
+
+/*
+ *  Function: config_snapshot_store_ints()
+ *
+ *  Description: Copy the int fields that differ from the previous
+ *               version to config_snapshot_ints[]. Called with the lock
+ *               held.
+ *
+ *  Parameters: prev - the old block, NULL to copy them all
+ *              next - the new block
+ *
+ *  Returns: None
+ */
+static void
+config_snapshot_store_ints (const char *prev, const char *next)
+{
+    const config_snapshot_field_t *field;
+    int32_t value;
+    int id;
+
+    for (id = 0; id < CFGID_PROTOCOL_MAX; id++) {
+        field = &config_snapshot_fields[id];
+        if (field->length != sizeof(int32_t)) {
+            continue;
+        }
+        value = *(const int32_t *) (next + field->offset);
+        if (prev == NULL ||
+            value != *(const int32_t *) (prev + field->offset)) {
+            cprAtomicStore(&config_snapshot_ints[id], value);
+        }
+    }
+}
+
+/*
+ *  Function: config_snapshot_publish()
+ *
+ *  Description: Copy staging into a spare buffer and make it current,
+ *               unless nothing changed. Readers are never waited for.
+ *               Called with the lock held.
+ *
+ *  Parameters: count - set to the number of changes returned
+ *
+ *  Returns: the changes to report once the lock is released, or NULL
+ */
+static config_snapshot_change_t *
+config_snapshot_publish (int *count)
+{
+    config_snapshot_buf_t *cur, *spare;
+
+    *count = 0;
+    cur = (config_snapshot_buf_t *) cprAtomicLoadPtr(&snapshot_current);
+    if (cur != NULL &&
+        memcmp(cur->snap.block, snapshot_staging, snapshot_size) == 0) {
+        snapshot_stats.unchanged++;
+        return NULL;
+    }
+
+    spare = config_snapshot_spare(cur);
+    if (spare == NULL) {
+        /* staging stays ahead; the next set publishes it */
+        return NULL;
+    }
+
+    memcpy((char *) spare->snap.block, snapshot_staging, snapshot_size);
+    spare->snap.version = (cur != NULL) ? cur->snap.version + 1 : 1;
+    cprAtomicStorePtr(&snapshot_current, spare);
+    config_snapshot_store_ints(cur ? cur->snap.block : NULL,
+                               spare->snap.block);
+    cprAtomicStore(&snapshot_version, (int32_t) spare->snap.version);
+
+    snapshot_stats.version = spare->snap.version;
+    snapshot_stats.publishes++;
+    CONFIG_DEBUG(DEB_F_PREFIX"published version %u\n",
+                 DEB_F_PREFIX_ARGS(CONFIG_API, "config_snapshot_publish"),
+                 spare->snap.version);
+
+    if (cur == NULL) {
+        return NULL;
+    }
+    return config_snapshot_diff(cur->snap.block, spare->snap.block, count);
+}
+
+/*
+ *  Function: config_snapshot_notify()
+ *
+ *  Description: Report the changes of one publish, without the lock.
+ *
+ *  Parameters: changes - list from config_snapshot_publish(), freed here
+ *              count   - number of changes
+ *              version - the version they were published in
+ *
+ *  Returns: None
+ */
+static void
+config_snapshot_notify (config_snapshot_change_t *changes, int count,
+                        uint32_t version)
+{
+    int i;
+
+    if (changes == NULL) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        changes[i].notify(changes[i].id, version, changes[i].data);
+    }
+    cpr_free(changes);
+}
+
+/*
+ *  Function: config_snapshot_init()
+ *
+ *  Description: Set up the snapshots for the staging block and publish
+ *               its contents. Called by protCfgTblInit() once the table
+ *               is built; called again on restart, it publishes the
+ *               reset block as the next version and keeps subscriptions.
+ *
+ *  Parameters: staging - prot_cfg_block
+ *              size    - its size
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_init (void *staging, uint32_t size)
+{
+    config_snapshot_change_t *changes;
+    const var_t *entry;
+    char *addr;
+    uint32_t version;
+    int count;
+    int id;
+
+    if (snapshot_mutex == NULL) {
+        snapshot_mutex = cprCreateMutex("config snapshot");
+        if (snapshot_mutex == NULL) {
+            CONFIG_ERROR(CFG_F_PREFIX"unable to create lock\n",
+                         "config_snapshot_init");
+            return;
+        }
+    }
+
+    (void) cprGetMutex(snapshot_mutex);
+    snapshot_staging = (char *) staging;
+    snapshot_size = size;
+
+    for (id = 0; id < CFGID_PROTOCOL_MAX; id++) {
+        entry = &prot_cfg_table[id];
+        addr = (char *) entry->addr;
+        if (addr != NULL && addr >= snapshot_staging &&
+            addr + entry->length <= snapshot_staging + size) {
+            config_snapshot_fields[id].offset = addr - snapshot_staging;
+            config_snapshot_fields[id].length = entry->length;
+        } else {
+            config_snapshot_fields[id].offset = 0;
+            config_snapshot_fields[id].length = 0;
+        }
+    }
+
+    changes = config_snapshot_publish(&count);
+    version = snapshot_stats.version;
+    (void) cprReleaseMutex(snapshot_mutex);
+
+    config_snapshot_notify(changes, count, version);
+}
+
+/*
+ *  Function: config_snapshot_write_lock()
+ *
+ *  Description: Take the writer lock before changing the staging block.
+ *               Before the snapshots are set up there is no lock and
+ *               nothing to publish.
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_write_lock (void)
+{
+    if (snapshot_mutex != NULL) {
+        (void) cprGetMutex(snapshot_mutex);
+    }
+}
+
+/*
+ *  Function: config_snapshot_write_unlock()
+ *
+ *  Description: Publish the staging block, unless an update is open, and
+ *               release the writer lock. Subscribers are then told what
+ *               changed.
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_write_unlock (void)
+{
+    config_snapshot_change_t *changes = NULL;
+    uint32_t version;
+    int count = 0;
+
+    if (snapshot_mutex == NULL) {
+        return;
+    }
+    if (snapshot_batch_depth == 0 &&
+        cprAtomicLoadPtr(&snapshot_current) != NULL) {
+        changes = config_snapshot_publish(&count);
+    }
+    version = snapshot_stats.version;
+    (void) cprReleaseMutex(snapshot_mutex);
+
+    config_snapshot_notify(changes, count, version);
+}
+
+/*
+ *  Function: config_snapshot_begin_update()
+ *
+ *  Description: Hold back publishing until the matching
+ *               config_snapshot_end_update(). Updates nest.
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_begin_update (void)
+{
+    if (snapshot_mutex == NULL) {
+        return;
+    }
+    (void) cprGetMutex(snapshot_mutex);
+    snapshot_batch_depth++;
+    (void) cprReleaseMutex(snapshot_mutex);
+}
+
+/*
+ *  Function: config_snapshot_end_update()
+ *
+ *  Description: Close an update; the outermost one publishes everything
+ *               set since it began as one version.
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_end_update (void)
+{
+    if (snapshot_mutex == NULL) {
+        return;
+    }
+    (void) cprGetMutex(snapshot_mutex);
+    if (snapshot_batch_depth == 0) {
+        (void) cprReleaseMutex(snapshot_mutex);
+        CONFIG_ERROR(CFG_F_PREFIX"no update open\n",
+                     "config_snapshot_end_update");
+        return;
+    }
+    snapshot_batch_depth--;
+    config_snapshot_write_unlock();
+}
+
+/*
+ *  Function: config_snapshot_subscribe()
+ *
+ *  Description: Be told about changes to a range of config ids.
+ *
+ *  Parameters: first_id - first id of the range
+ *              count    - number of ids
+ *              notify   - called once per changed id after a publish
+ *              data     - passed to notify
+ *
+ *  Returns: a handle for config_snapshot_unsubscribe(), or -1
+ */
+int
+config_snapshot_subscribe (int first_id, int count,
+                           config_snapshot_notify_t notify, void *data)
+{
+    int i;
+
+    if (first_id < 0 || count <= 0 || notify == NULL ||
+        first_id + count > CFGID_PROTOCOL_MAX || snapshot_mutex == NULL) {
+        CONFIG_ERROR(CFG_F_PREFIX"invalid range %d+%d\n",
+                     "config_snapshot_subscribe", first_id, count);
+        return -1;
+    }
+    (void) cprGetMutex(snapshot_mutex);
+    for (i = 0; i < CONFIG_SNAPSHOT_MAX_SUBSCRIBERS; i++) {
+        if (!snapshot_subs[i].active) {
+            snapshot_subs[i].active = TRUE;
+            snapshot_subs[i].first_id = first_id;
+            snapshot_subs[i].count = count;
+            snapshot_subs[i].notify = notify;
+            snapshot_subs[i].data = data;
+            snapshot_stats.subscribers++;
+            (void) cprReleaseMutex(snapshot_mutex);
+            return i;
+        }
+    }
+    (void) cprReleaseMutex(snapshot_mutex);
+    CONFIG_ERROR(CFG_F_PREFIX"all %d subscriptions in use\n",
+                 "config_snapshot_subscribe", CONFIG_SNAPSHOT_MAX_SUBSCRIBERS);
+    return -1;
+}
+
+/*
+ *  Function: config_snapshot_unsubscribe()
+ *
+ *  Description: Cancel a subscription. A publish that collected its
+ *               changes before this may still report them.
+ *
+ *  Parameters: handle - from config_snapshot_subscribe()
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_unsubscribe (int handle)
+{
+    if (handle < 0 || handle >= CONFIG_SNAPSHOT_MAX_SUBSCRIBERS ||
+        snapshot_mutex == NULL) {
+        return;
+    }
+    (void) cprGetMutex(snapshot_mutex);
+    if (snapshot_subs[handle].active) {
+        snapshot_subs[handle].active = FALSE;
+        snapshot_stats.subscribers--;
+    }
+    (void) cprReleaseMutex(snapshot_mutex);
+}
+
+/*
+ *  Function: config_snapshot_get_stats()
+ *
+ *  Parameters: stats - filled in with the counters
+ *
+ *  Returns: None
+ */
+void
+config_snapshot_get_stats (config_snapshot_stats_t *stats)
+{
+    if (snapshot_mutex == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    (void) cprGetMutex(snapshot_mutex);
+    *stats = snapshot_stats;
+    stats->batch_depth = snapshot_batch_depth;
+    (void) cprReleaseMutex(snapshot_mutex);
+}
+
+/*
+ *  Function: show_config_snapshot_cmd()
+ *
+ *  Description: "show config-snapshot" callback.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_config_snapshot_cmd (cc_int32_t argc, const char *argv[])
+{
+    config_snapshot_stats_t stats;
+
+    config_snapshot_get_stats(&stats);
+    debugif_printf("\n------ Config Snapshot ------\n");
+    debugif_printf("version %u, %u bytes\n", stats.version, snapshot_size);
+    debugif_printf("publishes %u, skipped %u, snapshot buffers %u\n",
+                   stats.publishes, stats.unchanged, stats.buffers);
+    debugif_printf("subscribers %u, notifications %u, open updates %u\n",
+                   stats.subscribers, stats.notifications, stats.batch_depth);
+    return (0);
+}
@@ -0,0 +1,179 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CONFIG_SNAPSHOT_H_
+#define _CONFIG_SNAPSHOT_H_
+
+#include "cpr_types.h"
+#include "cpr_locks.h"
+#include "prot_configmgr.h"
+
+/*
+ * Published copies of the config table.
+ *
+ * The set routines in config_api.c write prot_cfg_block, the staging
+ * copy, under a writer lock and then publish it: the block is copied
+ * into a snapshot buffer no reader holds, which then becomes the current
+ * one. Readers pin the current buffer with a counter on it and read it
+ * without a lock, so a value is never seen half written and all the
+ * values read through one pinned snapshot belong to the same version.
+ * A publish never waits for readers; when every other buffer is pinned
+ * it adds one. Buffers are kept for reuse, so there are only as many as
+ * versions were ever pinned at once, plus the current one.
+ *
+ * Single int values take no pin. A publish also stores the int fields
+ * that changed in config_snapshot_ints[], and config_get_int(), like
+ * config_get_value() of an int sized id, is one acquire load from
+ * there. Such a value may already be the one of a version still being
+ * published; pin a snapshot to read several values of one version.
+ *
+ * A set that leaves the block as it was does not publish. Between
+ * config_snapshot_begin_update() and config_snapshot_end_update() sets
+ * from any thread only go to staging, and the changes are published
+ * together at the end; reads meanwhile return the previous version.
+ *
+ * Subscribers name a range of config ids. After each publish, the ids
+ * in their range that differ between the old and new versions are
+ * reported to them, one call per id, on the thread that published and
+ * without the lock held. Publishes from two threads may be reported out
+ * of order; compare versions to drop a stale report.
+ *
+ * Until protCfgTblInit() sets the snapshots up, config_snapshot_acquire()
+ * returns NULL and the config routines use the staging copy directly.
+ */
+
+#define CONFIG_SNAPSHOT_MAX_SUBSCRIBERS 32
+
+typedef struct {
+    uint32_t    version;
+    const char *block;
+} config_snapshot_t;
+
+/* Where each config id lives in a snapshot block; length 0 if it does not */
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} config_snapshot_field_t;
+
+typedef void (*config_snapshot_notify_t)(int id, uint32_t version,
+                                         void *data);
+
+typedef struct {
+    uint32_t version;
+    uint32_t publishes;
+    uint32_t unchanged;     /* publishes skipped, block as it was */
+    uint32_t buffers;       /* snapshot buffers allocated */
+    uint32_t notifications;
+    uint32_t subscribers;
+    uint32_t batch_depth;
+} config_snapshot_stats_t;
+
+extern config_snapshot_field_t config_snapshot_fields[];
+extern volatile int32_t config_snapshot_ints[];
+
+void config_snapshot_init(void *staging, uint32_t size);
+void config_snapshot_write_lock(void);
+void config_snapshot_write_unlock(void);
+void config_snapshot_begin_update(void);
+void config_snapshot_end_update(void);
+
+const config_snapshot_t *config_snapshot_acquire(void);
+void config_snapshot_release(const config_snapshot_t *snap);
+uint32_t config_snapshot_version(void);
+
+int config_snapshot_subscribe(int first_id, int count,
+                              config_snapshot_notify_t notify, void *data);
+void config_snapshot_unsubscribe(int handle);
+
+void config_snapshot_get_stats(config_snapshot_stats_t *stats);
+cc_int32_t show_config_snapshot_cmd(cc_int32_t argc, const char *argv[]);
+
+/*
+ * Address of a config id in a pinned snapshot, or NULL if the id has
+ * no field there.
+ */
+static INLINE const void *
+config_snapshot_addr (const config_snapshot_t *snap, int id)
+{
+    if (snap == NULL || id < 0 || id >= CFGID_PROTOCOL_MAX ||
+        config_snapshot_fields[id].length == 0) {
+        return NULL;
+    }
+    return snap->block + config_snapshot_fields[id].offset;
+}
+
+/*
+ * Integer config values, read from config_snapshot_ints[] without going
+ * through config_get_value(). Ids that are not an int, or reads before
+ * the snapshots exist, go through config_get_value() and its error
+ * reporting.
+ */
+static INLINE int
+config_get_int (int id)
+{
+    int value = 0;
+
+    if (id >= 0 && id < CFGID_PROTOCOL_MAX &&
+        config_snapshot_fields[id].length == sizeof(int32_t)) {
+        return (int) cprAtomicLoad(&config_snapshot_ints[id]);
+    }
+    config_get_value(id, &value, sizeof(value));
+    return value;
+}
+
+static INLINE boolean
+config_get_boolean (int id)
+{
+    return (config_get_int(id) ? TRUE : FALSE);
+}
+
+/* Line based form: line runs from 1 to MAX_REG_LINES */
+static INLINE int
+config_get_line_int (int id, int line)
+{
+    int value = 0;
+
+    if (line >= 1 && line <= MAX_REG_LINES) {
+        return config_get_int(id + line - 1);
+    }
+    config_get_line_value(id, &value, sizeof(value), line);
+    return value;
+}
+
+#endif /* _CONFIG_SNAPSHOT_H_ */
@@ -58,6 +58,10 @@
 #include "ccapp_task.h"
 
 #include "phone_platform_constants.h"
+#include "ccsip_core.h"
+#include "cc_latency.h"
+#include "string_lib.h"
+#include "cc_shutdown.h"
 /** The following defines are used to tune the total memory that pSIPCC
  * allocates and uses. */
 /** Block size for emulated heap space, i.e. 1kB */
@@ -125,6 +129,8 @@ extern void cpr_crashdump(void);
  * depth of GSM thread is given to 3 times MAX_CALLS (or 153) and
  * 2 times (or 102) for SIP thread for 7970 case.
  *
+ * MAX_CALLS is the run time capacity (see cc_capacity.h), so the queue
+ * depths follow whatever value was configured before ccPreInit.
  */
 #define  GSMQSZ        (MAX_CALLS*3) /* GSM message queue size           */
 #define  SIPQSZ        (MAX_CALLS*2) /* SIP message queue size           */
@@ -249,9 +255,14 @@ ccPreInit ()
 
 	if (ccPreInit_called == FALSE) {
 		ccPreInit_called = TRUE;
+		//Capacity can no longer change once tables are sized
+		cc_capacity_freeze();
 		//Initializes the memory first
 		ccMemInit(PRIVATE_SYS_MEM_SIZE);
 		cprPreInit();
+		cc_latency_init();
+		cc_shutdown_init();
+		strlib_init();
 	}
 
     return CPR_SUCCESS;
@@ -292,6 +303,12 @@ thread_init ()
 
     PHNChangeState(STATE_FILE_CFG);
 
+    /* size the SIP call tables before any thread can touch them */
+    if (sip_sm_alloc_tables() != SIP_OK) {
+        err_msg("failed to allocate SIP call tables for %d calls\n", MAX_CALLS);
+        return CPR_FAILURE;
+    }
+
     /* initialize message queues */
     sip_msgq = cprCreateMessageQueue("SIPQ", SIPQSZ);
     gsm_msgq = cprCreateMessageQueue("GSMQ", GSMQSZ);
@@ -480,8 +497,9 @@ send_protocol_config_msg (void)
  *  Function: send_task_unload_msg
  *
  *  Description:
- *         - send shutdown and thread destroy msg to sip, gsm, ccapp, misc
- *           threads
+ *         - send the thread destroy msg to the sip, gsm, ccapp or misc
+ *           thread. The shutdown coordinator calls this once the task
+ *           is drained.
  *  Parameters:  destination thread
  *
  *  Returns: none
@@ -492,12 +510,7 @@ send_task_unload_msg(cc_srcs_t dest_id)
 {
     const char *fname = "send_task_unload_msg";
     uint16_t len = 4;
-    cprBuffer_t  msg =  gsm_get_buffer(len);
-
-    if (msg == NULL) {
-        err_msg("%s: failed to allocate  msg cprBuffer_t\n", fname);
-        return;
-    }
+    cprBuffer_t  msg;
 
     DEF_DEBUG(DEB_F_PREFIX"send Unload message to %s task ..\n",
         DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname),
@@ -509,10 +522,6 @@ send_task_unload_msg(cc_srcs_t dest_id)
     switch(dest_id) {
         case CC_SRC_SIP:
         {
-            /* send this msg so phone can send unRegister msg */
-            SIPTaskPostShutdown(SIP_EXTERNAL, CC_CAUSE_SHUTDOWN, "");
-            /* allow unRegister msg to sent out and shutdown to complete */
-            cprSleep(2000);
             /* send a unload message to the SIP Task to kill sip thread*/
             msg =  SIPTaskGetBuffer(len);
             if (msg == NULL) {
@@ -596,12 +605,10 @@ ccUnload (void)
         return;
     }
     /*
-     * We are going to send an unload msg to each of the thread, which on
-     * receiving the msg, will kill itself.
-    */
-    send_task_unload_msg(CC_SRC_SIP);
-    send_task_unload_msg(CC_SRC_GSM);
-    send_task_unload_msg(CC_SRC_MISC_APP);
-    send_task_unload_msg(CC_SRC_CCAPP);
+     * The shutdown coordinator drains SIP, then sends an unload msg to
+     * each thread in turn, SIP, GSM, CCApp and Misc App; on receiving it
+     * a thread kills itself and the next one is sent its msg.
+     */
+    cc_shutdown_start();
 }
 
@@ -126,6 +126,13 @@ extern cc_int32_t show_subsmanager_stats(cc_int32_t argc, const char *argv[]);
 extern cc_int32_t show_publish_stats(cc_int32_t argc, const char *argv[]);
 extern cc_int32_t show_register_cmd(cc_int32_t argc, const char *argv[]);
 extern cc_int32_t show_dialplan_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_capacity_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_msg_latency_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_sip_parse_cache_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_sip_trx_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_strlib_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_shutdown_cmd(cc_int32_t argc, const char *argv[]);
+extern cc_int32_t show_config_snapshot_cmd(cc_int32_t argc, const char *argv[]);
 /* CPR MEMORY ARCHIVE DECLARATIONS. These are considered to be part of core */
 extern int32_t cpr_show_memory(int32_t argc, const char *argv[]);
 extern int32_t cpr_clear_memory (int32_t argc, const char *argv[]);
@@ -156,6 +163,14 @@ debugShowStruct_t debugShowTable[] = {
     {CC_DEBUG_SHOW_REGISTER, "register", show_register_cmd, TRUE},
     {CC_DEBUG_SHOW_DIALPLAN, "dialplan", show_dialplan_cmd, TRUE},
     {CC_DEBUG_SHOW_CPR_MEMORY, "cpr-memory", cpr_show_memory, FALSE},
+    {CC_DEBUG_SHOW_CAPACITY, "capacity", show_capacity_cmd, TRUE},
+    {CC_DEBUG_SHOW_CPR_MSGQ, "cpr-msgq", cprShowMessageQueueStats, TRUE},
+    {CC_DEBUG_SHOW_MSG_LATENCY, "msg-latency", show_msg_latency_cmd, TRUE},
+    {CC_DEBUG_SHOW_SIP_PARSE_CACHE, "sip-parse-cache", show_sip_parse_cache_cmd, TRUE},
+    {CC_DEBUG_SHOW_SIP_TRX, "sip-trx", show_sip_trx_cmd, TRUE},
+    {CC_DEBUG_SHOW_STRLIB, "strlib", show_strlib_cmd, TRUE},
+    {CC_DEBUG_SHOW_SHUTDOWN, "shutdown", show_shutdown_cmd, TRUE},
+    {CC_DEBUG_SHOW_CONFIG_SNAPSHOT, "config-snapshot", show_config_snapshot_cmd, TRUE},
     {CC_DEBUG_SHOW_MAX, "not-used", NULL, FALSE} /* MUST BE THE LAST ELEMENT */
 };
 
@@ -49,6 +49,7 @@
 #include "ccsip_core.h"
 #include "prot_configmgr.h"
 #include "prot_cfgmgr_private.h"
+#include "config_snapshot.h"
 #include "sip_common_transport.h"
 #include "phone_debug.h"
 #include "regmgrapi.h"
@@ -138,6 +139,7 @@ int i;
   }
 
   initCfgTblEntry(CFGID_PROTOCOL_MAX, 0, 0, 0, 0, 0, 0);
+  config_snapshot_init(&prot_cfg_block, sizeof(prot_cfg_block));
 }
 
 /*
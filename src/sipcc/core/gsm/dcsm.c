@@ -55,6 +55,7 @@
 #include "gsm.h"
 #include "prot_configmgr.h"
 #include "singly_link_list.h"
+#include "cc_capacity.h"
 
 typedef enum dcsm_state {
     DCSM_S_MIN = -1,
@@ -66,7 +67,7 @@ typedef enum dcsm_state {
 #define DCSM_MAX_CALL_IDS     (LSM_MAX_CALLS)
 
 static struct dcsm_icb_t {
-    callid_t            call_ids[DCSM_MAX_CALL_IDS];
+    callid_t           *call_ids;   /* DCSM_MAX_CALL_IDS entries */
     line_t              line;
     int                 gsm_state;
     sll_handle_t        s_msg_list;
@@ -705,6 +706,15 @@ dcsm_init (void)
     
     dcsm_cb.state = DCSM_S_READY;
 
+    dcsm_cb.call_ids = (callid_t *)
+        cc_capacity_table_alloc("dcsm call ids", DCSM_MAX_CALL_IDS,
+                                sizeof(callid_t));
+    if (dcsm_cb.call_ids == NULL) {
+        DCSM_ERROR(DCSM_F_PREFIX"DCSM call id table allocation failed.\n",
+                                    DEB_F_PREFIX_ARGS("DCSM", fname));
+        return;
+    }
+
     for (i=0; i< DCSM_MAX_CALL_IDS; i++) {
         dcsm_cb.call_ids[i] = CC_NO_CALL_ID;
     }
@@ -736,6 +746,9 @@ dcsm_shutdown (void)
 {
     void *msg_ptr;
     
+    cc_capacity_table_free(dcsm_cb.call_ids);
+    dcsm_cb.call_ids = NULL;
+
     if (dcsm_cb.s_msg_list == NULL) {
         return;
     }
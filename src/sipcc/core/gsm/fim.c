@@ -53,6 +53,7 @@
 #include "gsm_sdp.h"
 #include "ccsip_sdp.h"
 #include "platform_api.h"
+#include "cc_capacity.h"
 
 extern void set_next_sess_video_pref(int pref);
 extern sm_rcs_t dcsm_process_event(void *event, int event_id);
@@ -95,7 +96,8 @@ fim_init_call_chns (void)
         return;
     }
 
-    fim_icbs = (fim_icb_t *) cpr_calloc(FIM_MAX_ICBS, sizeof(fim_icb_t));
+    fim_icbs = (fim_icb_t *)
+        cc_capacity_table_alloc("gsm icbs", FIM_MAX_ICBS, sizeof(fim_icb_t));
     if (fim_icbs == NULL) {
         GSM_DEBUG_ERROR(GSM_F_PREFIX"Failed to allocate FIM ICBs.\n", fname);
         cpr_free(fim_scbs);
@@ -770,7 +772,7 @@ void
 fim_shutdown (void)
 {
     cpr_free(fim_scbs);
-    cpr_free(fim_icbs);
+    cc_capacity_table_free(fim_icbs);
     fim_scbs = NULL;
     fim_icbs = NULL;
 }
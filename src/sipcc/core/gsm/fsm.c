@@ -52,6 +52,7 @@
 #include "sip_interface_regmgr.h"
 #include "resource_manager.h"
 #include "platform_api.h"
+#include "cc_capacity.h"
 
 #define FSM_MAX_FCBS (LSM_MAX_CALLS * (FSM_TYPE_MAX - 1))
 #define FSM_S_IDLE   0
@@ -471,7 +472,8 @@ fsm_init (void)
     /*
      * Initialize the fcbs.
      */
-    fsm_fcbs = (fsm_fcb_t *) cpr_calloc(FSM_MAX_FCBS, sizeof(fsm_fcb_t));
+    fsm_fcbs = (fsm_fcb_t *)
+        cc_capacity_table_alloc("gsm fcbs", FSM_MAX_FCBS, sizeof(fsm_fcb_t));
     if (fsm_fcbs == NULL) {
         GSM_ERR_MSG(GSM_F_PREFIX"Failed to allcoate FSM FCBs.\n", "fsm_init");
         return;
@@ -499,7 +501,7 @@ fsm_shutdown (void)
 
     fsm_cac_shutdown();
 
-    cpr_free(fsm_fcbs);
+    cc_capacity_table_free(fsm_fcbs);
     fsm_fcbs = NULL;
 
     /*
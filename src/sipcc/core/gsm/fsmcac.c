@@ -524,6 +524,10 @@ void fsm_cac_call_release_cleanup (callid_t call_id)
 
     if (cac_data) {
 
+        if (cac_data->cac_state == FSM_CAC_REQ_PENDING) {
+            lsm_release_call_bandwidth(cac_data->call_id);
+        }
+
         sll_remove(s_cac_list, cac_data);
 
         fsm_clear_cac_data(cac_data);
@@ -678,6 +682,9 @@ fsm_cac_process_bw_failed_resp (void)
             DEF_DEBUG(DEB_F_PREFIX"Process pending responses even after failure.\n",
                 DEB_F_PREFIX_ARGS("CAC", fname));
 
+            /* The allocation was granted but is not going to be used */
+            lsm_release_call_bandwidth(cac_data->call_id);
+
             /* Let GSM process completed request */ 
             fsm_cac_notify_failure(cac_data);
 
@@ -68,6 +68,7 @@
 #include "subapi.h"
 #include "text_strings.h"
 #include "platform_api.h"
+#include "cc_capacity.h"
 
 extern void update_kpmlconfig(int kpmlVal);
 extern boolean g_disable_mass_reg_debug_print;
@@ -1448,7 +1449,7 @@ fsmdef_find_and_handle_ring_connecting_releasing_calls (callid_t call_id, boolea
     int               i;
     int               act_dcb_cnt;
     fsmdef_dcb_t     *act_dcb;
-    fsmdef_dcb_t     *act_dcbs[LSM_MAX_CALLS];
+    fsmdef_dcb_t    **act_dcbs;
     cc_feature_data_t data;
 
     *wait = FALSE;
@@ -1456,6 +1457,13 @@ fsmdef_find_and_handle_ring_connecting_releasing_calls (callid_t call_id, boolea
     data.endcall.cause         = CC_CAUSE_NORMAL;
     data.endcall.dialstring[0] = '\0';
 
+    /* LSM_MAX_CALLS is a run time value, keep the list off the stack */
+    act_dcbs = (fsmdef_dcb_t **)
+        cpr_malloc(LSM_MAX_CALLS * sizeof(fsmdef_dcb_t *));
+    if (act_dcbs == NULL) {
+        return;
+    }
+
     act_dcb_cnt = fsmdef_get_ringing_n_error_call_dcbs(act_dcbs, call_id);
     for (i = 0; i < act_dcb_cnt; i++) {
         act_dcb = act_dcbs[i];
@@ -1477,6 +1485,7 @@ fsmdef_find_and_handle_ring_connecting_releasing_calls (callid_t call_id, boolea
             *wait = TRUE;
         }
     }
+    cpr_free(act_dcbs);
 }
 
 void
@@ -7663,7 +7672,8 @@ fsmdef_init (void)
      *  Initialize the dcbs.
      */
     fsmdef_dcbs = (fsmdef_dcb_t *)
-        cpr_calloc(FSMDEF_MAX_DCBS, sizeof(fsmdef_dcb_t));
+        cc_capacity_table_alloc("gsm dcbs", FSMDEF_MAX_DCBS,
+                                sizeof(fsmdef_dcb_t));
     if (fsmdef_dcbs == NULL) {
         FSM_DEBUG_SM(DEB_F_PREFIX"cpr_calloc returned NULL\n",
                      DEB_F_PREFIX_ARGS(FSM, fname));
@@ -7768,7 +7778,7 @@ fsmdef_shutdown (void)
     /* destroy free media structure list */
     gsmsdp_destroy_free_media_list();
 
-    cpr_free(fsmdef_dcbs);
+    cc_capacity_table_free(fsmdef_dcbs);
     fsmdef_dcbs = NULL;
 }
 
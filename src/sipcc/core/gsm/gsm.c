@@ -61,6 +61,8 @@
 #include "dialplanint.h"
 #include "kpmlmap.h"
 #include "subapi.h"
+#include "cc_latency.h"
+#include "cc_shutdown.h"
 
 static void sub_process_feature_msg(uint32_t cmd, void *msg);
 static void sub_process_feature_notify(ccsip_sub_not_data_t *msg, callid_t call_id,
@@ -75,11 +77,15 @@ extern void dcsm_process_jobs(void);
 extern void dcsm_init(void);
 extern void dcsm_shutdown(void);
 
+/* Messages taken off the GSM queue per wakeup */
+#define GSM_MSG_BATCH_SIZE 8
+
 /* Flag to see whether we can start processing events */
 
 static boolean gsm_initialized = FALSE;
 extern cprThread_t gsm_thread;
 static media_timer_callback_fp* media_timer_callback = NULL;
+static cprTimer_t gsm_latency_dump_timer = NULL;
 
 /**
  * Add media falsh one time timer call back. It's for ROUNDTABLE only.
@@ -119,6 +125,7 @@ gsm_send_msg (uint32_t cmd, cprBuffer_t buf, uint16_t len)
     }
     syshdr->Cmd = cmd;
     syshdr->Len = len;
+    cc_latency_stamp(syshdr);
 
     if (cprSendMessage(gsm_msg_queue, buf, (void **) &syshdr) == CPR_FAILURE) {
         cprReleaseSysHeader(syshdr);
@@ -248,6 +255,9 @@ gsm_process_timer_expiration (void *msg)
 	case GSM_TONE_DURATION_TIMER:
 		lsm_tone_duration_tmr_callback(timerMsg->usrData);
 		break;
+    case GSM_LATENCY_DUMP_TIMER:
+        cc_latency_dump_timer_expired();
+        break;
     default:
         GSM_ERR_MSG(GSM_F_PREFIX"unknown timer %d\n", fname,
                     timerMsg->expiredTimerName);
@@ -268,7 +278,14 @@ gsm_process_timer_expiration (void *msg)
 static void
 gsm_init (void)
 {
-    /* Placeholder for any initialization tasks */
+    /*
+     * The latency dump runs on the GSM task so that it does not need a
+     * thread of its own; the timer is idle until an interval is set.
+     */
+    gsm_latency_dump_timer = cprCreateTimer("latency dump",
+                                            GSM_LATENCY_DUMP_TIMER,
+                                            TIMER_EXPIRATION, gsm_msg_queue);
+    cc_latency_attach_dump_timer(gsm_latency_dump_timer);
 }
 
 void
@@ -276,6 +293,13 @@ gsm_shutdown (void)
 {
     gsm_initialized = FALSE;
 
+    cc_latency_attach_dump_timer(NULL);
+    if (gsm_latency_dump_timer) {
+        (void) cprCancelTimer(gsm_latency_dump_timer);
+        (void) cprDestroyTimer(gsm_latency_dump_timer);
+        gsm_latency_dump_timer = NULL;
+    }
+
     lsm_shutdown();
     fsm_shutdown();
     fim_shutdown();
@@ -290,34 +314,13 @@ gsm_reset (void)
     fsmutil_free_all_shown_calls_ci_map();
 }
 
+/*
+ * Initialize the GSM modules. Called on the GSM thread before it starts
+ * taking messages, or by a driver that runs the task inline.
+ */
 void
-GSMTask (void *arg)
+gsm_task_init (void)
 {
-    static const char fname[] = "GSMTask";
-    void           *msg;
-    phn_syshdr_t   *syshdr;
-    boolean        release_msg = TRUE;
-
-    /*
-     * Get the GSM message queue handle
-     * A hack until the tasks in irx are
-     * CPRized.
-     */
-    gsm_msg_queue = (cprMsgQueue_t) arg;
-    if (!gsm_msg_queue) {
-        GSM_ERR_MSG(GSM_F_PREFIX"invalid input, exiting\n", fname);
-        return;
-    }
-
-    if (platThreadInit("GSMTask") != 0) {
-        return;
-    }
-
-    /*
-     * Adjust relative priority of GSM thread.
-     */
-    (void) cprAdjustRelativeThreadPriority(GSM_THREAD_RELATIVE_PRIORITY);
-
     /*
      * Initialize all the GSM modules
      */
@@ -342,78 +345,126 @@ GSMTask (void *arg)
      * Cache random numbers for SRTP keys
      */
     gsmsdp_cache_crypto_keys();
+}
 
-    while (1) {
+/*
+ * Process one message taken off the GSM queue. The message and its system
+ * header are released here.
+ */
+void
+gsm_task_process_msg (phn_syshdr_t *syshdr, void *msg)
+{
+    static const char fname[] = "gsm_task_process_msg";
+    boolean release_msg = TRUE;
 
-        release_msg = TRUE;
-
-        msg = cprGetMessage(gsm_msg_queue, TRUE, (void **) &syshdr);
-        if (msg) {
-            switch (syshdr->Cmd) {
-            case TIMER_EXPIRATION:
-                gsm_process_timer_expiration(msg);
-                break;
-
-            case GSM_SIP:
-            case GSM_GSM:
-                release_msg = gsm_process_msg(syshdr->Cmd, msg);
-                break;
-
-            case DP_MSG_INIT_DIALING:
-            case DP_MSG_DIGIT_STR:
-            case DP_MSG_STORE_DIGIT:
-            case DP_MSG_DIGIT:
-            case DP_MSG_DIAL_IMMEDIATE:
-            case DP_MSG_REDIAL:
-            case DP_MSG_ONHOOK:
-            case DP_MSG_OFFHOOK:
-            case DP_MSG_UPDATE:
-            case DP_MSG_DIGIT_TIMER:
-            case DP_MSG_CANCEL_OFFHOOK_TIMER:
-                dp_process_msg(syshdr->Cmd, msg);
-                break;
-
-            case SUB_MSG_B2BCNF_SUBSCRIBE_RESP:
-            case SUB_MSG_B2BCNF_NOTIFY:
-            case SUB_MSG_B2BCNF_TERMINATE:
-                sub_process_b2bcnf_msg(syshdr->Cmd, msg);
-                break;
-
-            case SUB_MSG_FEATURE_SUBSCRIBE_RESP:
-            case SUB_MSG_FEATURE_NOTIFY:
-            case SUB_MSG_FEATURE_TERMINATE:
-                sub_process_feature_msg(syshdr->Cmd, msg);
-                break;
-
-            case SUB_MSG_KPML_SUBSCRIBE:
-            case SUB_MSG_KPML_TERMINATE:
-            case SUB_MSG_KPML_NOTIFY_ACK:
-            case SUB_MSG_KPML_SUBSCRIBE_TIMER:
-            case SUB_MSG_KPML_DIGIT_TIMER:
-                kpml_process_msg(syshdr->Cmd, msg);
-                break;
-
-            case REG_MGR_STATE_CHANGE:
-                gsm_reset();
-                break;
-            case THREAD_UNLOAD:
-                destroy_gsm_thread();
-                break;
-
-            default:
-                GSM_ERR_MSG(GSM_F_PREFIX"Unknown message\n", fname);
-                break;
-            }
+    cc_latency_begin(CC_LATENCY_QUEUE_GSM, syshdr);
 
-            cprReleaseSysHeader(syshdr);
-            if (release_msg == TRUE) {
-                cprReleaseBuffer(msg);
-            }
-            
-            /* Check if there are pending messages for dcsm 
-             * if it in the right state perform its operation 
-             */
-            dcsm_process_jobs();
+    switch (syshdr->Cmd) {
+    case TIMER_EXPIRATION:
+        gsm_process_timer_expiration(msg);
+        break;
+
+    case GSM_SIP:
+    case GSM_GSM:
+        release_msg = gsm_process_msg(syshdr->Cmd, msg);
+        break;
+
+    case DP_MSG_INIT_DIALING:
+    case DP_MSG_DIGIT_STR:
+    case DP_MSG_STORE_DIGIT:
+    case DP_MSG_DIGIT:
+    case DP_MSG_DIAL_IMMEDIATE:
+    case DP_MSG_REDIAL:
+    case DP_MSG_ONHOOK:
+    case DP_MSG_OFFHOOK:
+    case DP_MSG_UPDATE:
+    case DP_MSG_DIGIT_TIMER:
+    case DP_MSG_CANCEL_OFFHOOK_TIMER:
+        dp_process_msg(syshdr->Cmd, msg);
+        break;
+
+    case SUB_MSG_B2BCNF_SUBSCRIBE_RESP:
+    case SUB_MSG_B2BCNF_NOTIFY:
+    case SUB_MSG_B2BCNF_TERMINATE:
+        sub_process_b2bcnf_msg(syshdr->Cmd, msg);
+        break;
+
+    case SUB_MSG_FEATURE_SUBSCRIBE_RESP:
+    case SUB_MSG_FEATURE_NOTIFY:
+    case SUB_MSG_FEATURE_TERMINATE:
+        sub_process_feature_msg(syshdr->Cmd, msg);
+        break;
+
+    case SUB_MSG_KPML_SUBSCRIBE:
+    case SUB_MSG_KPML_TERMINATE:
+    case SUB_MSG_KPML_NOTIFY_ACK:
+    case SUB_MSG_KPML_SUBSCRIBE_TIMER:
+    case SUB_MSG_KPML_DIGIT_TIMER:
+        kpml_process_msg(syshdr->Cmd, msg);
+        break;
+
+    case REG_MGR_STATE_CHANGE:
+        gsm_reset();
+        break;
+    case THREAD_UNLOAD:
+        destroy_gsm_thread();
+        break;
+
+    default:
+        GSM_ERR_MSG(GSM_F_PREFIX"Unknown message\n", fname);
+        break;
+    }
+
+    cc_latency_end(CC_LATENCY_QUEUE_GSM);
+    cprReleaseSysHeader(syshdr);
+    if (release_msg == TRUE) {
+        cprReleaseBuffer(msg);
+    }
+
+    /* Check if there are pending messages for dcsm 
+     * if it in the right state perform its operation.
+     * This stays per message so that deferred dcsm events
+     * are replayed ahead of newer events in the batch.
+     */
+    dcsm_process_jobs();
+}
+
+void
+GSMTask (void *arg)
+{
+    static const char fname[] = "GSMTask";
+    cprMsgBatchEntry_t batch[GSM_MSG_BATCH_SIZE];
+    uint16_t       count, i;
+
+    /*
+     * Get the GSM message queue handle
+     * A hack until the tasks in irx are
+     * CPRized.
+     */
+    gsm_msg_queue = (cprMsgQueue_t) arg;
+    if (!gsm_msg_queue) {
+        GSM_ERR_MSG(GSM_F_PREFIX"invalid input, exiting\n", fname);
+        return;
+    }
+
+    if (platThreadInit("GSMTask") != 0) {
+        return;
+    }
+
+    /*
+     * Adjust relative priority of GSM thread.
+     */
+    (void) cprAdjustRelativeThreadPriority(GSM_THREAD_RELATIVE_PRIORITY);
+
+    gsm_task_init();
+
+    while (1) {
+
+        count = cprGetMessageBatch(gsm_msg_queue, TRUE, batch,
+                                   GSM_MSG_BATCH_SIZE);
+        for (i = 0; i < count; i++) {
+            gsm_task_process_msg((phn_syshdr_t *) batch[i].usrPtr,
+                                 batch[i].msg);
         }
     }
 }
@@ -639,5 +690,6 @@ void destroy_gsm_thread()
     gsm_shutdown();
     dp_shutdown();
     kpml_shutdown();
+    cc_shutdown_phase_unloaded(CC_SHUTDOWN_PHASE_GSM);
     (void) cprDestroyThread(gsm_thread);
 }
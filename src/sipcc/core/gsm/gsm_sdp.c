@@ -56,6 +56,7 @@
 #include "sip_interface_regmgr.h"
 #include "platform_api.h"
 #include "vcm.h"
+#include "cc_capacity.h"
 
 //TODO Need to place this in a portable location
 #define MULTICAST_START_ADDRESS 0xe1000000
@@ -93,10 +94,12 @@
 #define GSMSDP_PERM_MEDIA_ELEMS   (LSM_MAX_CALLS)
 
 /*
- * The permanent free media structure elements use static array. 
- * It is to ensure a low overhead for this a typical single audio call.
+ * The permanent free media structure elements use one contiguous chunk
+ * that is allocated the first time the free list is created and kept
+ * for the life of the process. It is to ensure a low overhead for this
+ * a typical single audio call.
  */ 
-static fsmdef_media_t gsmsdp_free_media_chunk[GSMSDP_PERM_MEDIA_ELEMS]; 
+static fsmdef_media_t *gsmsdp_free_media_chunk = NULL;
 static sll_lite_list_t gsmsdp_free_media_list;
 
 typedef enum {
@@ -202,6 +205,15 @@ gsmsdp_create_free_media_list (void)
     uint32_t i;
     fsmdef_media_t *media;
 
+    if (gsmsdp_free_media_chunk == NULL) {
+        gsmsdp_free_media_chunk = (fsmdef_media_t *)
+            cc_capacity_table_alloc("gsm media", GSMSDP_PERM_MEDIA_ELEMS,
+                                    sizeof(fsmdef_media_t));
+        if (gsmsdp_free_media_chunk == NULL) {
+            return (FALSE);
+        }
+    }
+
     /* initialize free media_list structure */
     (void)sll_lite_init(&gsmsdp_free_media_list);
 
@@ -298,7 +310,8 @@ gsmsdp_free_media (fsmdef_media_t *media)
      * Check to see if the element is part of the
      * free chunk space.
      */
-    if ((media >= &gsmsdp_free_media_chunk[0]) &&
+    if ((gsmsdp_free_media_chunk != NULL) &&
+        (media >= &gsmsdp_free_media_chunk[0]) &&
         (media <= &gsmsdp_free_media_chunk[GSMSDP_PERM_MEDIA_ELEMS-1])) {
         /* the element is part of free chunk, put it back to the list */
         (void)sll_lite_link_head(&gsmsdp_free_media_list, 
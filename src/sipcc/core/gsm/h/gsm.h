@@ -44,6 +44,7 @@
 #include "cpr_memory.h"
 #include "cpr_ipc.h"
 #include "cpr_stdio.h"
+#include "phone.h"
 
 #define GSM_ERR_MSG err_msg
 typedef void(* media_timer_callback_fp) (void);
@@ -53,6 +54,8 @@ void gsm_set_initialized(void);
 cpr_status_e gsm_send_msg(uint32_t cmd, cprBuffer_t buf, uint16_t len);
 cprBuffer_t gsm_get_buffer(uint16_t size);
 boolean gsm_is_idle(void);
+void gsm_task_init(void);
+void gsm_task_process_msg(phn_syshdr_t *syshdr, void *msg);
 
 /*
  * List of timers that the GSM task is responsible for.
@@ -75,7 +78,8 @@ typedef enum {
     GSM_REVERSION_TIMER,
     GSM_FLASH_ONCE_TIMER,
     GSM_CAC_FAILURE_TIMER,
-    GSM_TONE_DURATION_TIMER
+    GSM_TONE_DURATION_TIMER,
+    GSM_LATENCY_DUMP_TIMER
 } gsmTimerList_t;
 
 /*
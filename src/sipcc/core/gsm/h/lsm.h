@@ -190,6 +190,7 @@ extern line_t lsm_get_available_line (boolean incoming);
 extern boolean lsm_is_line_available(line_t line, boolean incoming);
 extern void lsm_ui_display_notify_str_index(int str_index);
 extern cc_causes_t lsm_allocate_call_bandwidth(callid_t call_id, int sessions);
+extern void lsm_release_call_bandwidth(callid_t call_id);
 extern void lsm_update_gcid(callid_t call_id, char * gcid);
 extern void lsm_set_lcb_prevent_ringing(callid_t call_id);
 extern void lsm_remove_lcb_prevent_ringing(callid_t call_id);
@@ -69,6 +69,7 @@
 #include "util_string.h"
 #include "platform_api.h"
 #include "vcm_util.h"
+#include "cc_capacity.h"
 
 #ifndef NO
 #define NO  (0)
@@ -2213,18 +2214,40 @@ cc_causes_t lsm_allocate_call_bandwidth (callid_t call_id, int sessions)
 {
     //get line for vcm
     line_t line = lsm_get_line_by_call_id(call_id);
-    //cc_feature(CC_SRC_GSM, call_id, 0, CC_FEATURE_CAC_RESP_PASS, NULL);
  
     /* Activate the wlan before allocating bandwidth */
     vcmActivateWlan(TRUE);
     
     if (vcmAllocateBandwidth(lsm_get_ms_ui_call_handle(line, call_id, CC_NO_CALL_ID), sessions)) {
+        /*
+         * The media layer decides on the spot, so answer the pending
+         * request now and let fsmcac release the held event.
+         */
+        cc_feature(CC_SRC_GSM, call_id, line, CC_FEATURE_CAC_RESP_PASS, NULL);
         return(CC_CAUSE_OK);
     }
 
     return(CC_CAUSE_CONGESTION);
 }
 
+/**
+ * lsm_release_call_bandwidth
+ *
+ * @param[in] call_id - gsm's call_id of the request.
+ *
+ * Gives back the bandwidth allocated by lsm_allocate_call_bandwidth
+ * for a call that is dropped before GSM has seen it. Calls that
+ * did reach GSM give it back in lsm_onhook.
+ *
+ * @return none
+ */
+void lsm_release_call_bandwidth (callid_t call_id)
+{
+    line_t line = lsm_get_line_by_call_id(call_id);
+
+    vcmRemoveBandwidth(lsm_get_ms_ui_call_handle(line, call_id, CC_NO_CALL_ID));
+}
+
 /**
  * lsm_get_facility_by_line
  * return facility by the given line
@@ -2871,7 +2894,7 @@ lsm_set_ringer (lsm_lcb_t *lcb, callid_t call_id, line_t line, int alerting)
     fsmxfr_xcb_t   *xcb;
     fsmcnf_ccb_t   *ccb;
     lsm_lcb_t *lcb2;
-    fsmdef_dcb_t   *dcbs[LSM_MAX_CALLS];
+    fsmdef_dcb_t  **dcbs;
     vcm_ring_mode_t ringerMode = VCM_INSIDE_RING;
     short           ringOnce = NO;
     boolean         alertInfo = NO;
@@ -3203,11 +3226,15 @@ lsm_set_ringer (lsm_lcb_t *lcb, callid_t call_id, line_t line, int alerting)
          */
         config_get_value(CFGID_CALL_HOLD_RINGBACK, &callHoldRingback,
                          sizeof(callHoldRingback));
-        if (callHoldRingback & 0x1) {
+        /* LSM_MAX_CALLS is a run time value, keep the list off the stack */
+        dcbs = (callHoldRingback & 0x1) ? (fsmdef_dcb_t **)
+            cpr_malloc(LSM_MAX_CALLS * sizeof(fsmdef_dcb_t *)) : NULL;
+        if (dcbs != NULL) {
             callid_t        ui_id;
 
             dcb_cnt = fsmdef_get_dcbs_in_held_state(dcbs, call_id);
-            for (i = 0, dcb = dcbs[i]; i < dcb_cnt; i++, dcb = dcbs[i]) {
+            for (i = 0; i < dcb_cnt; i++) {
+                dcb = dcbs[i];
               	ccb = fsmcnf_get_ccb_by_call_id(call_id);
                	xcb = fsmxfr_get_xcb_by_call_id(call_id);
                	if ((lsm_is_phone_inactive() == TRUE) &&
@@ -3228,6 +3255,7 @@ lsm_set_ringer (lsm_lcb_t *lcb, callid_t call_id, line_t line, int alerting)
                         	                  dcb->line, ui_id);
                 }
             }
+            cpr_free(dcbs);
         }
     }
 
@@ -4924,7 +4952,8 @@ lsm_init (void)
     /*
      * Init the lcbs.
      */
-    lsm_lcbs = (lsm_lcb_t *) cpr_calloc(LSM_MAX_LCBS, sizeof(lsm_lcb_t));
+    lsm_lcbs = (lsm_lcb_t *)
+        cc_capacity_table_alloc("gsm lcbs", LSM_MAX_LCBS, sizeof(lsm_lcb_t));
     if (lsm_lcbs == NULL) {
         LSM_ERR_MSG(LSM_F_PREFIX"lsm_lcbs cpr_calloc returned NULL\n", fname);
         return;
@@ -4966,7 +4995,8 @@ lsm_shutdown (void)
 
     (void) cprDestroyTimer(lsm_continuous_tmr_tones);
 
-    cpr_free(lsm_lcbs);
+    cc_capacity_table_free(lsm_lcbs);
+    lsm_lcbs = NULL;
 }
 
 /**
@@ -0,0 +1,79 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CC_CAPACITY_H_
+#define _CC_CAPACITY_H_
+
+#include "cpr_types.h"
+#include "cc_types.h"
+
+/*
+ * Run time call capacity.
+ *
+ * The number of simultaneous calls the stack supports used to be fixed
+ * by MAX_CALLS. It is now read from g_cc_max_calls, which the application
+ * may set through CCAPI_Service_setMaxCalls() before the stack is created.
+ * MAX_CALLS, and every table size derived from it (MAX_CCBS, MAX_SCBS,
+ * LSM_MAX_CALLS, ...), evaluates that value, and the tables themselves
+ * are allocated as contiguous arrays when each component initializes.
+ */
+#define CC_MAX_CALLS_DEFAULT   51
+#define CC_MAX_CALLS_MIN       2
+/* call ids and ccb indexes are 16 bit quantities */
+#define CC_MAX_CALLS_LIMIT     8192
+
+extern int32_t g_cc_max_calls;
+
+boolean cc_capacity_set_max_calls(int32_t max_calls);
+void cc_capacity_freeze(void);
+
+/*
+ * Every table sized from the call capacity registers itself here when it
+ * is allocated so that "show capacity" can report its memory use.
+ */
+void *cc_capacity_table_alloc(const char *name, uint32_t count,
+                              uint32_t elem_size);
+void cc_capacity_table_free(void *table);
+void cc_capacity_table_register(const char *name, uint32_t count,
+                                uint32_t elem_size);
+uint32_t cc_capacity_total_bytes(void);
+
+cc_int32_t show_capacity_cmd(cc_int32_t argc, const char *argv[]);
+
+#endif /* _CC_CAPACITY_H_ */
@@ -0,0 +1,118 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CC_LATENCY_H_
+#define _CC_LATENCY_H_
+
+#include "cpr_types.h"
+#include "cpr_timers.h"
+#include "cc_types.h"
+#include "phone.h"
+
+/*
+ * Message latency instrumentation.
+ *
+ * Every message sent through one of the task send wrappers has its system
+ * header stamped with the time it was queued and a trace id. The trace id
+ * is inherited from the message the sending thread is processing, so a
+ * SIP INVITE, the GSM events it causes and the CCApp updates they cause
+ * all carry the same id. Messages sent from outside a task (application
+ * API calls, timer expirations) start a new trace.
+ *
+ * The consumer of each queue records, per command, how long the message
+ * waited on the queue and how long it took to process. The counters of a
+ * queue are only ever written by its consumer thread so no lock is taken;
+ * a reader may see one message counted in some fields and not yet in
+ * others, which is fine for statistics.
+ */
+typedef enum {
+    CC_LATENCY_QUEUE_SIP,
+    CC_LATENCY_QUEUE_GSM,
+    CC_LATENCY_QUEUE_CCAPP,
+    CC_LATENCY_QUEUE_MISC,
+    CC_LATENCY_QUEUE_MAX
+} cc_latency_queue_e;
+
+/* Commands at or above this value share the last slot */
+#define CC_LATENCY_MAX_CMDS  256
+
+/*
+ * Times are in microseconds from cprGetTimeUs(). Histogram upper bounds:
+ * <10, <50, <100, <500, <1000, <5000, <50000, >=50000
+ */
+#define CC_LATENCY_BUCKETS   8
+
+typedef struct {
+    uint32_t count;
+    uint64_t wait_total;     /* us */
+    uint32_t wait_max;       /* us */
+    uint64_t service_total;  /* us */
+    uint32_t service_max;    /* us */
+    uint32_t wait_hist[CC_LATENCY_BUCKETS];
+    uint32_t service_hist[CC_LATENCY_BUCKETS];
+} cc_latency_stats_t;
+
+void cc_latency_init(void);
+void cc_latency_set_enabled(boolean enabled);
+
+/* Called by the send wrappers before the message is queued */
+void cc_latency_stamp(phn_syshdr_t *syshdr);
+
+/* Called by the consumer around the processing of each message */
+void cc_latency_begin(cc_latency_queue_e queue, phn_syshdr_t *syshdr);
+void cc_latency_end(cc_latency_queue_e queue);
+
+uint32_t cc_latency_current_trace(void);
+
+boolean cc_latency_get_stats(cc_latency_queue_e queue, uint32_t cmd,
+                             cc_latency_stats_t *stats);
+void cc_latency_reset(cc_latency_queue_e queue);
+
+/*
+ * Periodic dump. The GSM task owns the timer and hands it over once it is
+ * created; an interval of 0 stops the dump.
+ */
+void cc_latency_set_dump_interval(uint32_t secs);
+void cc_latency_attach_dump_timer(cprTimer_t timer);
+void cc_latency_dump_timer_expired(void);
+void cc_latency_dump(void);
+
+cc_int32_t show_msg_latency_cmd(cc_int32_t argc, const char *argv[]);
+
+#endif /* _CC_LATENCY_H_ */
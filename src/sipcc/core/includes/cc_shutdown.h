@@ -0,0 +1,127 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CC_SHUTDOWN_H_
+#define _CC_SHUTDOWN_H_
+
+#include "cpr_types.h"
+#include "cc_types.h"
+
+/*
+ * Shutdown coordinator.
+ *
+ * ccUnload() hands the tasks over to the coordinator, which takes them
+ * down one at a time in the order SIP, GSM, CCApp, Misc App. A task's
+ * phase starts with a request to drain and ends when the task reports
+ * back, so the next phase starts as soon as the previous one is done
+ * rather than after a fixed sleep:
+ *
+ *  - SIP drains by unregistering and releasing its calls and
+ *    subscriptions. It reports drained once every unREGISTER, BYE and
+ *    unSUBSCRIBE it sent has a final response, or at the deadline for
+ *    servers that never answer. It is then sent THREAD_UNLOAD.
+ *  - GSM, CCApp and Misc App are sent THREAD_UNLOAD, which queues behind
+ *    the messages already in flight to them; they report when they get
+ *    to it.
+ *
+ * While SIP drains, the transactions it waits for are recorded here by
+ * Call-ID and CSeq number, and retransmissions are absorbed. The SIP task
+ * is the only writer; the lock is for the show command and for threads
+ * waiting on a phase.
+ */
+
+typedef enum {
+    CC_SHUTDOWN_PHASE_SIP,
+    CC_SHUTDOWN_PHASE_GSM,
+    CC_SHUTDOWN_PHASE_CCAPP,
+    CC_SHUTDOWN_PHASE_MISC,
+    CC_SHUTDOWN_PHASE_MAX
+} cc_shutdown_phase_e;
+
+typedef enum {
+    CC_SHUTDOWN_IDLE,
+    CC_SHUTDOWN_DRAINING,
+    CC_SHUTDOWN_DRAINED,
+    CC_SHUTDOWN_UNLOADED
+} cc_shutdown_state_e;
+
+typedef enum {
+    CC_SHUTDOWN_TXN_REGISTER,
+    CC_SHUTDOWN_TXN_BYE,
+    CC_SHUTDOWN_TXN_UNSUBSCRIBE,
+    CC_SHUTDOWN_TXN_MAX         /* as a filter: any type */
+} cc_shutdown_txn_e;
+
+typedef struct {
+    cc_shutdown_state_e state;
+    uint32_t drain_ms;          /* phase start to drained */
+    uint32_t unload_ms;         /* drained to unloaded */
+    uint32_t txns;              /* transactions waited for */
+    uint32_t abandoned;         /* of those, still open at the deadline */
+} cc_shutdown_stats_t;
+
+void cc_shutdown_init(void);
+
+/* Runs the phases; returns at once, see cc_shutdown_wait() */
+void cc_shutdown_start(void);
+
+/*
+ * Blocks until every phase has unloaded or 'timeout' ms have passed.
+ * Must not be called from one of the task threads.
+ */
+boolean cc_shutdown_wait(uint32_t timeout);
+
+/* Reported by the tasks */
+void cc_shutdown_phase_drained(cc_shutdown_phase_e phase);
+void cc_shutdown_phase_unloaded(cc_shutdown_phase_e phase);
+
+/* Transaction tracking, used by the SIP task */
+void cc_shutdown_track_txns(boolean enable);
+boolean cc_shutdown_tracking_txns(void);
+void cc_shutdown_txn_sent(cc_shutdown_txn_e type, const char *call_id,
+                          uint32_t cseq);
+boolean cc_shutdown_txn_answered(cc_shutdown_txn_e type, const char *call_id,
+                                 uint32_t cseq);
+uint32_t cc_shutdown_txn_pending(cc_shutdown_txn_e type);
+
+boolean cc_shutdown_get_stats(cc_shutdown_phase_e phase,
+                              cc_shutdown_stats_t *stats);
+cc_int32_t show_shutdown_cmd(cc_int32_t argc, const char *argv[]);
+
+#endif /* _CC_SHUTDOWN_H_ */
@@ -136,6 +136,34 @@ extern DialMatchAction MatchDialTemplate(const char *pattern,
                                          char *rewrite, int rewritelen,
                                          RouteMode *pRouteMode,
                                          vcm_tones_t *pTone);
+extern DialMatchAction MatchDialTemplateLinear(const char *pattern,
+                                               const line_t line,
+                                               int *timeout,
+                                               char *rewrite, int rewritelen,
+                                               RouteMode *pRouteMode,
+                                               vcm_tones_t *pTone);
+
+/*
+ * A string being dialed, as walked through the compiled dial plan. Matching
+ * the string again after a key press only steps the new characters.
+ */
+typedef struct {
+    uint32_t generation;        /* compiled plan the walk is for, 0 for none */
+    boolean pound;              /* '#' was the dial now character */
+    int len;                    /* characters walked */
+    char digits[MAX_DIALSTRING];
+    uint16_t states[MAX_DIALSTRING + 1];
+} DialPlanCursor;
+
+void ResetDialCursor(DialPlanCursor *cursor);
+extern DialMatchAction MatchDialTemplateCursor(DialPlanCursor *cursor,
+                                               const char *pattern,
+                                               const line_t line,
+                                               int *timeout,
+                                               char *rewrite, int rewritelen,
+                                               RouteMode *pRouteMode,
+                                               vcm_tones_t *pTone);
+uint32_t DialPlanStateCount(void);
 void SaveDialTemplate(void);
 void RestoreDialPlan(void);
 void InitDialPlan(boolean);
@@ -77,6 +77,7 @@ typedef enum {
 
 typedef struct dp_data_t_ {
     char         gDialed[MAX_DIALSTRING];
+    DialPlanCursor gCursor;      /* gDialed as last matched */
     char         gReDialed[MAX_DIALSTRING];
     line_t       gRedialLine;
     char         empty_rewrite[MAX_DIALSTRING];
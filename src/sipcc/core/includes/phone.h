@@ -518,6 +518,8 @@ typedef struct
         uint32_t UsrInfo;
     } Usr;
     uint8_t Misc[MISC_LN];
+    uint32_t EnqTime;   /* us, monotonic; see cc_latency.h */
+    uint32_t TraceId;
  //  void  *TempPtr;
 } phn_syshdr_t;
 
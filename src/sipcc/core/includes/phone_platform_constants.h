@@ -40,6 +40,8 @@
 #ifndef _PHONE_PLATFORM_CONSTANTS_H_
 #define _PHONE_PLATFORM_CONSTANTS_H_
 
+#include "cc_capacity.h"
+
 // Defines for the various phone models. Note that the device numbers
 // appearing after the model name are pre-determined when new phone models
 // are added and must correspond to the ones programmed into CCM
@@ -227,8 +229,13 @@
 
 #define MAX_PHONE_LINES       8
 #define MAX_REG_LINES         8
-#define MAX_CALLS            51
-#define MAX_CALLS_PER_LINE   51
+/*
+ * MAX_CALLS is configured at run time, see cc_capacity.h. Anything sized
+ * from it must be allocated when its component initializes rather than
+ * declared as a static array.
+ */
+#define MAX_CALLS            (g_cc_max_calls)
+#define MAX_CALLS_PER_LINE   (g_cc_max_calls)
 /*
  * MAX_INSTANCES (call_instances) should equal to maximum number of calls
  * allowed by the phone but MAX_CALLS is defined to be 1 more than the 
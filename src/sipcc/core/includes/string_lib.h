@@ -44,17 +44,39 @@
 
 #define LEN_UNKNOWN -1
 
+/*
+ * Strings up to STRLIB_INTERN_MAX characters are interned: identical
+ * contents share one block, kept on a hash chain through next. Blocks
+ * come from per size class free lists (next links those too), larger
+ * strings are cpr_malloc'ed on their own.
+ */
+#define STRLIB_NUM_CLASSES  5
+#define STRLIB_INTERN_MAX   255
+
 typedef struct string_block_t_
 {
     struct string_block_t_ *next;
-    uint16_t    refcount;
+    volatile int32_t refcount;  /* updated with cprAtomicIncrement/Decrement */
+    uint32_t    hash;
     uint16_t    length;
+    uint8_t     size_class;
+    uint8_t     interned;
     const char *fname;
     int         line;
     short       signature;
     char        data[1];
 } string_block_t;
 
+typedef struct {
+    uint32_t lookups;       /* strlib_malloc calls eligible for interning */
+    uint32_t hits;          /* ... that found an existing block */
+    uint32_t bytes_saved;   /* block bytes not allocated thanks to hits */
+    uint32_t interned;      /* interned blocks currently live */
+    uint32_t class_allocs[STRLIB_NUM_CLASSES];
+    uint32_t class_reused[STRLIB_NUM_CLASSES];  /* served from a free list */
+    uint32_t class_cached[STRLIB_NUM_CLASSES];  /* blocks on the free list */
+} strlib_stats_t;
+
 
 /*
  * Prototypes for functions
@@ -74,6 +96,8 @@ char *strlib_open(string_t str, int length, const char *fname, int line);
 string_t strlib_close(char *str);
 string_t strlib_printf(const char *format, ...);
 string_t strlib_empty(void);
+void strlib_init(void);
+void strlib_get_stats(strlib_stats_t *stats);
 void strlib_debug_init(void);
 long strlib_mem_used(void);
 int strlib_test_memory_is_string(void *mem);
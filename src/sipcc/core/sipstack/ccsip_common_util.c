@@ -259,18 +259,15 @@ boolean ccsip_common_util_generate_auth (sipMessage_t *pSipMessage, ccsip_common
 void ccsip_util_get_from_entity (sipMessage_t *pSipMessage, char *entity)
 {
     const char     *sip_from = NULL;
-    sipLocation_t  *from_loc = NULL;
+    const sipLocation_t *from_loc = NULL;
 
     sip_from = sippmh_get_cached_header_val(pSipMessage, FROM);
     if (sip_from != NULL) {
-        from_loc = sippmh_parse_from_or_to((char *) sip_from, TRUE);
+        from_loc = sippmh_get_parsed_from(pSipMessage);
         if ((from_loc) && (from_loc->genUrl->schema == URL_TYPE_SIP) && (from_loc->genUrl->u.sipUrl->user)) {
             strncpy(entity, from_loc->genUrl->u.sipUrl->user, CC_MAX_DIALSTRING_LEN);       
         }
     }
-    if (from_loc) {
-        sippmh_free_location(from_loc);
-    }
 }
 
 /**
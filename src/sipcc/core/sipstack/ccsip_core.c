@@ -58,7 +58,9 @@
 #include "ccsip_callinfo.h"
 #include "ccsip_cc.h"
 #include "ccsip_task.h"
+#include "ccsip_trx.h"
 #include "config.h"
+#include "config_snapshot.h"
 #include "string_lib.h"
 #include "dialplan.h"
 #include "fsm.h"
@@ -73,6 +75,9 @@
 #include "text_strings.h"
 #include "platform_api.h"
 #include "misc_util.h"
+#include "ccsip_reldev.h"
+#include "cc_capacity.h"
+#include "cc_shutdown.h"
 
 
 /*
@@ -137,9 +142,9 @@ extern cc_int32_t dnsGetHostByName (const char *hname, cpr_ip_addr_t *ipaddr_ptr
 extern char *Basic_is_phone_forwarded(line_t line);
 
 /* External Declarations */
-extern sipPlatformUITimer_t sipPlatformUISMTimers[];
+extern sipPlatformUITimer_t *sipPlatformUISMTimers;
 extern sipGlobal_t sip;
-extern sipCallHistory_t gCallHistory[];
+extern sipCallHistory_t *gCallHistory;
 
 /* Globals */
 int      dns_error_code;  // Global DNS error code value
@@ -147,7 +152,7 @@ uint16_t server_caps = 0; // Server capabilities
 boolean  sip_reg_all_failed;
 
 ccsipGlobInfo_t  gGlobInfo;
-sipCallHistory_t gCallHistory[MAX_TEL_LINES];
+sipCallHistory_t *gCallHistory = NULL;
 
 typedef struct {
     int16_t sipValidEvent;
@@ -5940,7 +5945,7 @@ ccsip_handle_refer_sip_message (ccsipCCB_t *ccb, sipSMEvent_t *event)
     char            tempreferby[MAX_SIP_URL_LENGTH];
     char           *semi_token = NULL;
     int             rcode;
-    sipContact_t   *contact_info = NULL;
+    const sipContact_t *contact_info = NULL;
 
     memset(tempreferto, 0, MAX_SIP_URL_LENGTH);
 
@@ -5999,7 +6004,7 @@ ccsip_handle_refer_sip_message (ccsipCCB_t *ccb, sipSMEvent_t *event)
                                            ccb);
             return;
         }
-        contact_info = sippmh_parse_contact(contact);
+        contact_info = sippmh_get_parsed_contact(request);
         if (contact_info && contact_info->num_locations > 1) {
             CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Received REFER with multiple contacts!\n", fname);
             (void) sipSPISendErrorResponse(request, SIP_CLI_ERR_AMBIGUOUS,
@@ -6007,12 +6012,8 @@ ccsip_handle_refer_sip_message (ccsipCCB_t *ccb, sipSMEvent_t *event)
                                            SIP_WARN_MISC,
                                            SIP_WARN_REFER_AMBIGUOUS_PHRASE,
                                            ccb);
-            sippmh_free_contact(contact_info);
             return;
         }
-        if (contact_info) {
-            sippmh_free_contact(contact_info);
-        }
     } else { // If No contact header
         (void) sipSPISendErrorResponse(request, SIP_CLI_ERR_BAD_REQ,
                                        SIP_CLI_ERR_BAD_REQ_PHRASE,
@@ -6578,6 +6579,7 @@ sip_sm_call_cleanup (ccsipCCB_t *ccb)
      */
     if ((int) (ccb->index) <= TEL_CCB_END) {
         (void) sip_platform_supervision_disconnect_timer_stop(ccb->index);
+        sip_trx_ccb_cleanup(ccb->index);
         submanager_update_ccb_addr(ccb);
     }
 
@@ -7215,6 +7217,39 @@ sip_util_make_tag (char *pTagBuf)
              count, (unsigned int)cpr_rand(), (unsigned int)cpr_rand());
 }
 
+/*
+ * sip_sm_alloc_tables
+ *
+ * Allocates the ccb, call history, timer, scb and reliable delivery
+ * tables, all of which are sized from the configured call capacity.
+ * Called once from thread_init before the SIP task is created so that
+ * the tables exist before any task can look up a ccb.
+ */
+int
+sip_sm_alloc_tables (void)
+{
+    const char *fname = "sip_sm_alloc_tables";
+
+    if (gGlobInfo.ccbs == NULL) {
+        gGlobInfo.ccbs = (ccsipCCB_t *)
+            cc_capacity_table_alloc("sip ccbs", MAX_CCBS, sizeof(ccsipCCB_t));
+        gCallHistory = (sipCallHistory_t *)
+            cc_capacity_table_alloc("sip call history", MAX_TEL_LINES,
+                                    sizeof(sipCallHistory_t));
+    }
+
+    if ((gGlobInfo.ccbs == NULL) || (gCallHistory == NULL) ||
+        (sip_platform_timers_alloc() != SIP_OK) ||
+        (sip_trx_alloc() != SIP_OK) ||
+        (sip_subsManager_alloc_scbs() != SIP_OK) ||
+        (sipRelDevAllocList() != SIP_OK)) {
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"unable to allocate SIP tables for %d calls\n",
+                          fname, MAX_CALLS);
+        return SIP_ERROR;
+    }
+    return SIP_OK;
+}
+
 int
 sip_sm_init (void)
 {
@@ -7240,6 +7275,11 @@ sip_sm_init (void)
         return SIP_ERROR;
     }
 
+    if (sip_trx_init() == SIP_ERROR) {
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"transaction initialization failed\n", fname);
+        return SIP_ERROR;
+    }
+
     if (sipTransportInit() != SIP_OK) {
         return SIP_ERROR;
     }
@@ -7352,6 +7392,8 @@ ccsip_handle_sip_shutdown ()
                 break;
 
             case SIP_STATE_IDLE:
+            case SIP_STATE_IDLE_MSG_TIMER_OUTSTANDING:
+                // already released, e.g. by an earlier pass of a shutdown
                 break;
             }
 
@@ -7385,6 +7427,7 @@ sip_shutdown (void)
         sip_regmgr_shutdown();
 
         // Stop and deallocate timers
+        sip_trx_shutdown();
         sip_platform_timers_shutdown();
 
         // Shutdown Subscription Manager
@@ -7452,35 +7495,143 @@ sip_restart (void)
     cc_fail_fallback_gsm(CC_SRC_SIP, CC_RSP_COMPLETE, CC_REG_FAILOVER_RSP);
 }
 
-void
-sip_shutdown_phase2 (int action)
+/*
+ * A shutdown waits for the network twice: in phase 1 for the answers to
+ * the unREGISTERs, in phase 2 for the answers to the BYEs and
+ * unSUBSCRIBEs. Each wait ends when the last answer arrives or when the
+ * unregistration timer, used as the deadline, fires. Phase 3 takes the
+ * stack down.
+ */
+typedef enum {
+    SIP_SHUTDOWN_IDLE,
+    SIP_SHUTDOWN_UNREGISTERING,
+    SIP_SHUTDOWN_RELEASING
+} sip_shutdown_state_e;
+
+#define SIP_SHUTDOWN_DEADLINE_MSEC 2000
+
+static sip_shutdown_state_e sip_shutdown_state = SIP_SHUTDOWN_IDLE;
+static int sip_shutdown_action = SIP_INTERNAL;
+
+static void
+sip_shutdown_phase3 (int action)
 {
-    DEF_DEBUG(DEB_F_PREFIX"(%d)\n", 
-                     DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase2"), action);
+    DEF_DEBUG(DEB_F_PREFIX"(%d)\n",
+                     DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase3"), action);
+    sip_shutdown_state = SIP_SHUTDOWN_IDLE;
+    (void) sip_platform_unregistration_timer_stop();
     sip.taskInited = TRUE; // Forcing sip_shutdown() to execute
-    DEF_DEBUG(DEB_F_PREFIX"sip.taskInited is set to true\n", DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase2"));
+    DEF_DEBUG(DEB_F_PREFIX"sip.taskInited is set to true\n", DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase3"));
     sip_shutdown();
     if (action == SIP_EXTERNAL || action == SIP_STOP) {
+        cc_shutdown_phase_drained(CC_SHUTDOWN_PHASE_SIP);
         shutdownCCAck(action);
     } else if (action == SIP_INTERNAL) {
+        cc_shutdown_track_txns(FALSE);
         // Continue on to reinit
         sip_restart();
     }
 }
 
+void
+sip_shutdown_phase2 (int action)
+{
+    DEF_DEBUG(DEB_F_PREFIX"(%d)\n", 
+                     DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase2"), action);
+    (void) sip_platform_unregistration_timer_stop();
+
+    /*
+     * The stack is going away for good: end the calls and our own
+     * subscriptions while the transport is still up, and give the far
+     * ends until the deadline to answer.
+     */
+    if ((action == SIP_EXTERNAL || action == SIP_STOP) &&
+        (sip.taskInited == TRUE) &&
+        ((PHNGetState() == STATE_CONNECTED) ||
+         (PHNGetState() == STATE_DONE_LOADING) ||
+         (PHNGetState() == STATE_CFG_UPDATE))) {
+        (void) sip_subsManager_unsubscribe_all();
+        ccsip_handle_sip_shutdown();
+        if (cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_BYE) +
+            cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_UNSUBSCRIBE) != 0) {
+            sip_shutdown_state = SIP_SHUTDOWN_RELEASING;
+            (void) sip_platform_unregistration_timer_start(
+                       SIP_SHUTDOWN_DEADLINE_MSEC, (boolean) action);
+            return;
+        }
+    }
+    sip_shutdown_phase3(action);
+}
+
 void
 sip_shutdown_phase1 (int action, int reason)
 {
     DEF_DEBUG(DEB_F_PREFIX"In sip_shutdown_phase1 (%d)\n", 
                      DEB_F_PREFIX_ARGS(SIP_CTRL, "sip_shutdown_phase1"), action);
+    sip_shutdown_action = action;
+    cc_shutdown_track_txns(TRUE);
     if (sip_reg_all_failed) {
         // NO CCM available; need not wait for unreg timer
         sip_shutdown_phase2(action);
     } else {
+        sip_shutdown_state = SIP_SHUTDOWN_UNREGISTERING;
         // Unregister all lines
         ccsip_register_cancel(TRUE, TRUE);
-        // Start timer with a 2sec expiration
-        (void) sip_platform_unregistration_timer_start(2000, (boolean) action);
+        // The unregistration timer is the deadline for the answers
+        (void) sip_platform_unregistration_timer_start(
+                   SIP_SHUTDOWN_DEADLINE_MSEC, (boolean) action);
+        sip_shutdown_check_progress();
+    }
+}
+
+/*
+ *  Function: sip_shutdown_timer_expired()
+ *
+ *  Description: The deadline of the current shutdown phase has passed;
+ *               move on without the answers still missing.
+ */
+void
+sip_shutdown_timer_expired (int action)
+{
+    switch (sip_shutdown_state) {
+    case SIP_SHUTDOWN_UNREGISTERING:
+        sip_shutdown_state = SIP_SHUTDOWN_IDLE;
+        sip_shutdown_phase2(action);
+        break;
+    case SIP_SHUTDOWN_RELEASING:
+        sip_shutdown_phase3(action);
+        break;
+    default:
+        // expiry raced with the last answer
+        break;
+    }
+}
+
+/*
+ *  Function: sip_shutdown_check_progress()
+ *
+ *  Description: Called after each SIP message is processed while a
+ *               shutdown is waiting for answers, so that the next phase
+ *               starts with the last one instead of at the deadline.
+ */
+void
+sip_shutdown_check_progress (void)
+{
+    switch (sip_shutdown_state) {
+    case SIP_SHUTDOWN_UNREGISTERING:
+        if (cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_REGISTER) == 0) {
+            sip_shutdown_state = SIP_SHUTDOWN_IDLE;
+            sip_shutdown_phase2(sip_shutdown_action);
+        }
+        break;
+    case SIP_SHUTDOWN_RELEASING:
+        if (cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_BYE) +
+            cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_UNSUBSCRIBE) == 0) {
+            sip_shutdown_phase3(sip_shutdown_action);
+        }
+        break;
+    default:
+        break;
     }
 }
 
@@ -7701,8 +7852,8 @@ sip_sm_get_ccb_by_gsm_id (callid_t gsm_id)
  */
 static boolean
 sip_sm_ccb_match_branch_cseq (ccsipCCB_t *ccb,
-                              sipCseq_t  *sipCseq,
-                              sipVia_t   *via_this)
+                              const sipCseq_t *sipCseq,
+                              const sipVia_t *via_this)
 {
     const char       *fname = "sip_sm_ccb_match_branch_cseq";
     int16_t          trx_index = -1;
@@ -7742,7 +7893,7 @@ sip_sm_ccb_match_branch_cseq (ccsipCCB_t *ccb,
 // In addition to call-id, it also considers the Req-URI, CSeq, etc.
 uint16_t
 sip_sm_determine_ccb (const char *callid,
-                      sipCseq_t * sipCseq,
+                      const sipCseq_t * sipCseq,
                       sipMessage_t *pSipMessage,
                       boolean is_request,
                       ccsipCCB_t **ccb_ret)
@@ -7750,7 +7901,7 @@ sip_sm_determine_ccb (const char *callid,
 
     const char     *fname = "sip_sm_determine_ccb";
     const char     *to = NULL;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
     line_t          i;
     ccsipCCB_t     *ccb = NULL;
     sipReqLine_t   *requestURI = NULL;
@@ -7760,7 +7911,7 @@ sip_sm_determine_ccb (const char *callid,
     char            reqURI[MAX_SIP_URL_LENGTH];
     int16_t         trx_index = -1;
     sipTransaction_t *trx = NULL;
-    sipVia_t       *via_this = NULL;
+    const sipVia_t *via_this = NULL;
     sipVia_t       *via_last = NULL;
     const char     *pViaHeaderStr = NULL;
     boolean        match = FALSE;
@@ -7771,7 +7922,7 @@ sip_sm_determine_ccb (const char *callid,
     // First, obtain the CCB by matching call-id and to-tag, if present
     to = sippmh_get_cached_header_val(pSipMessage, TO);
     if (to) {
-        to_loc = sippmh_parse_from_or_to((char *)to, TRUE);
+        to_loc = sippmh_get_parsed_to(pSipMessage);
         if (to_loc) {
             if (to_loc->tag) {
                 for (i = 0; i < MAX_CCBS; i++) {
@@ -7793,14 +7944,13 @@ sip_sm_determine_ccb (const char *callid,
                     }
                 }
             }
-            sippmh_free_location(to_loc);
         }
     }
 
     // Get the VIA parameters so proper matching can be done
     pViaHeaderStr = sippmh_get_cached_header_val(pSipMessage, VIA);
     if (pViaHeaderStr) {
-        via_this = sippmh_parse_via(pViaHeaderStr);
+        via_this = sippmh_get_parsed_via(pSipMessage);
     }
     if (!pViaHeaderStr || !via_this) {
         return (SIP_CLI_ERR_BAD_REQ);
@@ -7933,7 +8083,6 @@ sip_sm_determine_ccb (const char *callid,
                                    via_last->branch_param)) {
                             // merged request
                             CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Found Merged Request\n", fname);
-                            sippmh_free_via(via_this);
                             sippmh_free_via(via_last);
                             return (SIP_CLI_ERR_LOOP_DETECT);
                         }
@@ -7954,7 +8103,6 @@ sip_sm_determine_ccb (const char *callid,
                 ccb = &(gGlobInfo.ccbs[i]);
                 match = sip_sm_ccb_match_branch_cseq(ccb, sipCseq,
                                                      via_this);
-                sippmh_free_via(via_this);
                 if (match) {
                      *ccb_ret = ccb;
                      return (0);
@@ -7978,7 +8126,6 @@ sip_sm_determine_ccb (const char *callid,
     if ((*ccb_ret != NULL) && !is_request) {
     	match = sip_sm_ccb_match_branch_cseq(*ccb_ret, sipCseq,
                                              via_this);
-        sippmh_free_via(via_this);
     	if (match) {
             return (0);
         } else {
@@ -7986,7 +8133,6 @@ sip_sm_determine_ccb (const char *callid,
         }
     }
 
-    sippmh_free_via(via_this);
     return (0);
 }
 
@@ -8213,11 +8359,11 @@ ccsip_restart_reTx_timer (ccsipCCB_t *ccb, sipMethod_t messageType)
     uint32_t        timeout = 0;
 
     /* Restart the reTx timer */
-    config_get_value(CFGID_TIMER_T1, &time_t1, sizeof(time_t1));
+    time_t1 = config_get_int(CFGID_TIMER_T1);
     timeout = time_t1 * (1 << ccb->retx_counter);
     // Adjust the max timer - but only for non INVITE transactions
     if (messageType != sipMethodInvite) {
-        config_get_value(CFGID_TIMER_T2, &time_t2, sizeof(time_t2));
+        time_t2 = config_get_int(CFGID_TIMER_T2);
         if (timeout > time_t2) {
             timeout = time_t2;
         }
@@ -8715,7 +8861,7 @@ sip_sm_200and300_update (ccsipCCB_t *ccb, sipMessage_t *response, int response_c
     const char     *from;
     const char     *contact;
     const char     *record_route = NULL;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
 
     to = sippmh_get_cached_header_val(response, TO);
     from = sippmh_get_cached_header_val(response, FROM);
@@ -8730,7 +8876,7 @@ sip_sm_200and300_update (ccsipCCB_t *ccb, sipMessage_t *response, int response_c
      */
     if (ccb->state < SIP_STATE_ACTIVE) {
         if (to) {
-            to_loc = sippmh_parse_from_or_to((char *) to, TRUE);
+            to_loc = sippmh_get_parsed_to(response);
             if (to_loc) {
                 if (to_loc->tag) {
                     ccb->sip_to_tag = strlib_update(ccb->sip_to_tag,
@@ -8746,7 +8892,6 @@ sip_sm_200and300_update (ccsipCCB_t *ccb, sipMessage_t *response, int response_c
                 CCSIP_DEBUG_STATE(DEB_L_C_F_PREFIX"%d: Recorded to_tag=<%s>\n",
                                   DEB_L_C_F_PREFIX_ARGS(SIP_CALL_STATUS, ccb->dn_line, ccb->gsm_id, fname),
                                   ccb->index, ccb->sip_to_tag);
-                sippmh_free_location(to_loc);
             }
         }
     }
@@ -8802,49 +8947,41 @@ sip_sm_purify_tag (char *tag)
 boolean
 sip_sm_is_invite_response (sipMessage_t *response)
 {
-    const char *cseq;
-    sipCseq_t  *sipCseq;
+    const sipCseq_t *sipCseq;
 
     if (response == NULL) {
         return FALSE;
     }
 
-    cseq = sippmh_get_cached_header_val(response, CSEQ);
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(response);
     if (!sipCseq) {
         return FALSE;
     }
 
     if (sipCseq->method == sipMethodInvite) {
-        cpr_free(sipCseq);
         return TRUE;
     }
-    cpr_free(sipCseq);
     return FALSE;
 }
 
 boolean
 sip_sm_is_bye_or_cancel_response (sipMessage_t *response)
 {
-    const char *cseq;
-    sipCseq_t  *sipCseq;
+    const sipCseq_t *sipCseq;
 
     if (response == NULL) {
         return FALSE;
     }
 
-    cseq = sippmh_get_cached_header_val(response, CSEQ);
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(response);
     if (!sipCseq) {
         return FALSE;
     }
 
     if ((sipCseq->method == sipMethodBye) ||
         (sipCseq->method == sipMethodCancel)) {
-        cpr_free(sipCseq);
         return TRUE;
     }
-    cpr_free(sipCseq);
     return FALSE;
 }
 
@@ -8882,6 +9019,7 @@ sip_sm_check_retx_timers (ccsipCCB_t *ccb, sipMessage_t *canceller_message)
     const char     *fname = "sip_sm_check_retx_timers";
     uint32_t        canceller_cseq;
     sipMethod_t     canceller_cseq_method;
+    const sipCseq_t *canceller_cseq_structure;
     const char     *canceller_callid;
 
     sipMessage_t   *retx_message = NULL;
@@ -8925,12 +9063,10 @@ sip_sm_check_retx_timers (ccsipCCB_t *ccb, sipMessage_t *canceller_message)
     /*
      * Get canceller_message callid, cseq number, cseq method
      */
-    cseq = sippmh_get_cached_header_val(canceller_message, CSEQ);
-    sipCseq = sippmh_parse_cseq(cseq);
-    if (sipCseq) {
-        canceller_cseq = sipCseq->number;
-        canceller_cseq_method = sipCseq->method;
-        cpr_free(sipCseq);
+    canceller_cseq_structure = sippmh_get_parsed_cseq(canceller_message);
+    if (canceller_cseq_structure) {
+        canceller_cseq = canceller_cseq_structure->number;
+        canceller_cseq_method = canceller_cseq_structure->method;
     } else {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
                           ccb->index, ccb->dn_line, fname,
@@ -9050,7 +9186,7 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
 {
     const char     *fname = "sip_sm_request_check_and_store";
     const char     *request_cseq = NULL;
-    sipCseq_t      *request_cseq_structure = NULL;
+    const sipCseq_t *request_cseq_structure = NULL;
     uint32_t        request_cseq_number = 0;
     sipMethod_t     request_cseq_method = sipMethodInvalid;
     const char     *callID = NULL;
@@ -9058,13 +9194,11 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
     boolean         request_uri_error = FALSE;
     sipReqLine_t   *requestURI = NULL;
     sipLocation_t  *uri_loc = NULL;
-    const char     *sip_from = NULL;
-    const char     *sip_to = NULL;
-    sipLocation_t  *to_loc = NULL;
-    sipLocation_t  *from_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
+    const sipLocation_t *from_loc = NULL;
     const char     *pViaHeaderStr = NULL;
     int16_t         trx_index = -1;
-    sipVia_t       *via = NULL;
+    const sipVia_t *via = NULL;
 
 
     /* test incoming parameter for NULL */
@@ -9101,7 +9235,7 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
                 SIP_WARNING_LENGTH);
         return (-1);
     }
-    request_cseq_structure = sippmh_parse_cseq(request_cseq);
+    request_cseq_structure = sippmh_get_parsed_cseq(request);
     if (!request_cseq_structure) {
         CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Unable to parse request's CSeq "
                           "header.\n", fname);
@@ -9113,7 +9247,6 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
     }
     request_cseq_number = request_cseq_structure->number;
     request_cseq_method = request_cseq_structure->method;
-    cpr_free(request_cseq_structure);
 
     /*
      * Parsing Request-Uri
@@ -9150,8 +9283,7 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
     /*
      * Parse From
      */
-    sip_from = sippmh_get_cached_header_val(request, FROM);
-    from_loc = sippmh_parse_from_or_to((char *)sip_from, TRUE);
+    from_loc = sippmh_get_parsed_from(request);
     if (!from_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, get_debug_string(DEBUG_FUNCTIONNAME_SIPPMH_PARSE_FROM));
@@ -9161,13 +9293,11 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
                 SIP_WARNING_LENGTH);
         return (-1);
     }
-    sippmh_free_location(from_loc);
 
     /*
      * Parse To
      */
-    sip_to = sippmh_get_cached_header_val(request, TO);
-    to_loc = sippmh_parse_from_or_to((char *)sip_to, TRUE);
+    to_loc = sippmh_get_parsed_to(request);
     if (!to_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, get_debug_string(DEBUG_FUNCTIONNAME_SIPPMH_PARSE_TO));
@@ -9177,14 +9307,13 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
                 SIP_WARNING_LENGTH);
         return (-1);
     }
-    sippmh_free_location(to_loc);
 
     /*
      * Parse Via
      */
     pViaHeaderStr = sippmh_get_cached_header_val(request, VIA);
     if (pViaHeaderStr) {
-        via = sippmh_parse_via(pViaHeaderStr);
+        via = sippmh_get_parsed_via(request);
     }
     if (!pViaHeaderStr || !via) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED), NULL,
@@ -9196,7 +9325,6 @@ sip_sm_request_check_and_store (ccsipCCB_t *ccb, sipMessage_t *request,
         return (-1);
 
     }
-    sippmh_free_via(via);
 
     /*
      * Check
@@ -9344,7 +9472,7 @@ sip_sm_update_to_from_on_callsetup_finalresponse (ccsipCCB_t *ccb,
     const char     *fname = "sip_sm_update_to_from_on_callsetup_finalresponse";
     const char     *to;
     const char     *from;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
 
     to = sippmh_get_cached_header_val(response, TO);
     from = sippmh_get_cached_header_val(response, FROM);
@@ -9353,7 +9481,7 @@ sip_sm_update_to_from_on_callsetup_finalresponse (ccsipCCB_t *ccb,
      * Record the "tag=" parameter
      */
     if (to) {
-        to_loc = sippmh_parse_from_or_to((char *)to, TRUE);
+        to_loc = sippmh_get_parsed_to(response);
         if (to_loc) {
             if (to_loc->tag) {
                 ccb->sip_to_tag = strlib_update(ccb->sip_to_tag, sip_sm_purify_tag(to_loc->tag));
@@ -9366,7 +9494,6 @@ sip_sm_update_to_from_on_callsetup_finalresponse (ccsipCCB_t *ccb,
             CCSIP_DEBUG_STATE(DEB_L_C_F_PREFIX"%d: Recorded to_tag=<%s>\n",
                               DEB_L_C_F_PREFIX_ARGS(SIP_CALL_STATUS, ccb->dn_line, ccb->gsm_id, fname), 
                               ccb->index, ccb->sip_to_tag);
-            sippmh_free_location(to_loc);
         }
     }
 
@@ -10141,7 +10268,7 @@ ccsip_handle_accept_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
     sipMessage_t   *response;
     int             response_code = 0;
     const char     *cseq = NULL;
-    sipCseq_t      *sipCseq = NULL;
+    const sipCseq_t *sipCseq = NULL;
     char           *fname = "ccsip_handle_accept_2xx";
     sipMethod_t     response_method;
 
@@ -10172,7 +10299,7 @@ ccsip_handle_accept_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
         free_sip_message(response);
         return;
     }
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(response);
     if (!sipCseq) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, "sippmh_parse_cseq()");
@@ -10180,7 +10307,6 @@ ccsip_handle_accept_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
         return;
     }
     response_method = sipCseq->method;
-    cpr_free(sipCseq);
 
     if ((response_code == SIP_SUCCESS_SETUP) &&
         (response_method == sipMethodNotify)) {
@@ -0,0 +1,1781 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+
+#include "cpr_types.h"
+#include "cpr_stdio.h"
+#include "cpr_string.h"
+#include "cpr_stdlib.h"
+#include "ccsip_eventbodies.h"
+#include "ccsip_protocol.h"
+
+/*
+ * Tokenizer
+ *
+ * xml_next() hands back one token at a time. START and END carry the
+ * local name of the element (any namespace prefix dropped) and an
+ * empty element <x/> produces both. TEXT is character data as it
+ * appears in the message, references still escaped unless the text
+ * came from a CDATA section. Declarations, processing instructions
+ * and comments are skipped. A DOCTYPE with an internal subset is
+ * refused so no entity can be defined, which keeps expansion bounded
+ * by the size of the body.
+ */
+#define XML_READER_MAX_DEPTH 32
+
+typedef struct {
+    const char *ptr;
+    uint32_t    len;
+} xml_slice_t;
+
+typedef enum {
+    XML_TOKEN_START,
+    XML_TOKEN_END,
+    XML_TOKEN_TEXT,
+    XML_TOKEN_EOF,
+    XML_TOKEN_ERROR
+} xml_token_e;
+
+typedef struct {
+    const char  *cur;
+    const char  *end;
+    xml_slice_t  name;          /* START and END */
+    xml_slice_t  text;          /* TEXT */
+    boolean      cdata;
+    const char  *attr_begin;    /* attributes of the last START */
+    const char  *attr_end;
+    boolean      close_pending; /* the last START was <x/> */
+    boolean      root_done;
+    boolean      failed;
+    uint16_t     depth;
+    xml_slice_t  open[XML_READER_MAX_DEPTH];
+} xml_reader_t;
+
+static const char *const xml_state_names[] = {
+    "partial", "full"
+};
+static const char *const xml_direction_names[] = {
+    "initiator", "recipient"
+};
+static const char *const xml_event_names[] = {
+    "cancelled", "rejected", "replaced", "local-bye", "remote-bye",
+    "error", "timeout"
+};
+static const char *const xml_dialog_state_names[] = {
+    "trying", "proceeding", "early", "confirmed", "terminated"
+};
+static const char *const xml_persist_names[] = {
+    "one-shot", "persist", "single-notify"
+};
+
+#define XML_NAMES(table) (table), (sizeof(table) / sizeof((table)[0]))
+
+
+static boolean
+xml_is_space (char c)
+{
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+/*
+ * Name characters: ASCII letters and digits, '_', ':', '-', '.' and any
+ * byte of a multi-byte UTF-8 sequence.
+ */
+static const uint8_t xml_name_chars[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+};
+
+static boolean
+xml_is_name_char (char c)
+{
+    return (boolean) xml_name_chars[(unsigned char) c];
+}
+
+static boolean
+xml_starts (const char *p, const char *end, const char *lit)
+{
+    size_t n = strlen(lit);
+
+    return ((size_t) (end - p) >= n && memcmp(p, lit, n) == 0);
+}
+
+static const char *
+xml_find (const char *p, const char *end, const char *lit)
+{
+    size_t n = strlen(lit);
+
+    while ((size_t) (end - p) >= n) {
+        p = memchr(p, lit[0], end - p - n + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (memcmp(p, lit, n) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static const char *
+xml_scan_name (const char *p, const char *end, xml_slice_t *name)
+{
+    name->ptr = p;
+    while (p < end && xml_is_name_char(*p)) {
+        p++;
+    }
+    name->len = (uint32_t) (p - name->ptr);
+    return p;
+}
+
+static xml_slice_t
+xml_local_name (xml_slice_t qname)
+{
+    uint32_t i = qname.len;
+
+    while (i > 0 && qname.ptr[i - 1] != ':') {
+        i--;
+    }
+    qname.ptr += i;
+    qname.len -= i;
+    return qname;
+}
+
+static boolean
+xml_eq (xml_slice_t s, const char *lit)
+{
+    return (s.len == strlen(lit) && memcmp(s.ptr, lit, s.len) == 0);
+}
+
+static xml_slice_t
+xml_trim (xml_slice_t s)
+{
+    while (s.len && xml_is_space(s.ptr[0])) {
+        s.ptr++;
+        s.len--;
+    }
+    while (s.len && xml_is_space(s.ptr[s.len - 1])) {
+        s.len--;
+    }
+    return s;
+}
+
+static void
+xml_reader_init (xml_reader_t *r, const char *body, uint32_t len)
+{
+    memset(r, 0, sizeof(*r));
+    r->cur = body;
+    r->end = body + len;
+    if (xml_starts(r->cur, r->end, "\xEF\xBB\xBF")) {
+        r->cur += 3;
+    }
+}
+
+static xml_token_e
+xml_fail (xml_reader_t *r)
+{
+    r->failed = TRUE;
+    r->cur = r->end;
+    return XML_TOKEN_ERROR;
+}
+
+/*
+ * Parses the start tag at r->cur. Attributes are checked here, so that
+ * xml_next_attr() can walk them later without looking for errors.
+ */
+static xml_token_e
+xml_start_tag (xml_reader_t *r)
+{
+    const char *p = r->cur + 1;
+    const char *end = r->end;
+    const char *ws;
+    const char *close;
+    xml_slice_t qname;
+    xml_slice_t aname;
+    boolean empty = FALSE;
+    char quote;
+
+    if (r->root_done || r->depth == XML_READER_MAX_DEPTH) {
+        return xml_fail(r);
+    }
+    p = xml_scan_name(p, end, &qname);
+    if (qname.len == 0) {
+        return xml_fail(r);
+    }
+    r->attr_begin = p;
+    for (;;) {
+        ws = p;
+        while (p < end && xml_is_space(*p)) {
+            p++;
+        }
+        if (p >= end) {
+            return xml_fail(r);
+        }
+        if (*p == '>') {
+            r->attr_end = p++;
+            break;
+        }
+        if (*p == '/') {
+            if (p + 1 >= end || p[1] != '>') {
+                return xml_fail(r);
+            }
+            r->attr_end = p;
+            p += 2;
+            empty = TRUE;
+            break;
+        }
+        if (p == ws) {
+            return xml_fail(r);
+        }
+        p = xml_scan_name(p, end, &aname);
+        if (aname.len == 0) {
+            return xml_fail(r);
+        }
+        while (p < end && xml_is_space(*p)) {
+            p++;
+        }
+        if (p >= end || *p != '=') {
+            return xml_fail(r);
+        }
+        p++;
+        while (p < end && xml_is_space(*p)) {
+            p++;
+        }
+        if (p >= end || (*p != '"' && *p != '\'')) {
+            return xml_fail(r);
+        }
+        quote = *p++;
+        close = memchr(p, quote, end - p);
+        if (close == NULL || memchr(p, '<', close - p) != NULL) {
+            return xml_fail(r);
+        }
+        p = close + 1;
+    }
+    r->open[r->depth++] = qname;
+    r->name = xml_local_name(qname);
+    r->close_pending = empty;
+    r->cur = p;
+    return XML_TOKEN_START;
+}
+
+static xml_token_e
+xml_end_tag (xml_reader_t *r)
+{
+    const char *p;
+    xml_slice_t qname;
+    xml_slice_t *top;
+
+    p = xml_scan_name(r->cur + 2, r->end, &qname);
+    while (p < r->end && xml_is_space(*p)) {
+        p++;
+    }
+    if (p >= r->end || *p != '>' || r->depth == 0) {
+        return xml_fail(r);
+    }
+    top = &r->open[r->depth - 1];
+    if (top->len != qname.len || memcmp(top->ptr, qname.ptr, qname.len) != 0) {
+        return xml_fail(r);
+    }
+    r->depth--;
+    r->root_done = (r->depth == 0);
+    r->name = xml_local_name(qname);
+    r->cur = p + 1;
+    return XML_TOKEN_END;
+}
+
+static xml_token_e
+xml_next (xml_reader_t *r)
+{
+    const char *p;
+    const char *stop;
+
+    if (r->failed) {
+        return XML_TOKEN_ERROR;
+    }
+    if (r->close_pending) {
+        r->close_pending = FALSE;
+        r->depth--;
+        r->root_done = (r->depth == 0);
+        r->name = xml_local_name(r->open[r->depth]);
+        return XML_TOKEN_END;
+    }
+    for (;;) {
+        p = r->cur;
+        if (p >= r->end) {
+            if (r->depth == 0 && r->root_done) {
+                return XML_TOKEN_EOF;
+            }
+            return xml_fail(r);
+        }
+        if (*p != '<') {
+            stop = memchr(p, '<', r->end - p);
+            if (stop == NULL) {
+                stop = r->end;
+            }
+            r->cur = stop;
+            if (r->depth == 0) {
+                /* only white space outside the root element */
+                while (p < stop && xml_is_space(*p)) {
+                    p++;
+                }
+                if (p != stop) {
+                    return xml_fail(r);
+                }
+                continue;
+            }
+            r->text.ptr = p;
+            r->text.len = (uint32_t) (stop - p);
+            r->cdata = FALSE;
+            return XML_TOKEN_TEXT;
+        }
+        if (p + 1 < r->end && p[1] != '?' && p[1] != '!') {
+            if (p[1] == '/') {
+                return xml_end_tag(r);
+            }
+            return xml_start_tag(r);
+        }
+        if (xml_starts(p, r->end, "<?")) {
+            stop = xml_find(p + 2, r->end, "?>");
+            if (stop == NULL) {
+                return xml_fail(r);
+            }
+            r->cur = stop + 2;
+        } else if (xml_starts(p, r->end, "<!--")) {
+            stop = xml_find(p + 4, r->end, "-->");
+            if (stop == NULL) {
+                return xml_fail(r);
+            }
+            r->cur = stop + 3;
+        } else if (xml_starts(p, r->end, "<![CDATA[")) {
+            stop = xml_find(p + 9, r->end, "]]>");
+            if (stop == NULL || r->depth == 0) {
+                return xml_fail(r);
+            }
+            r->text.ptr = p + 9;
+            r->text.len = (uint32_t) (stop - r->text.ptr);
+            r->cdata = TRUE;
+            r->cur = stop + 3;
+            return XML_TOKEN_TEXT;
+        } else if (xml_starts(p, r->end, "<!DOCTYPE")) {
+            if (r->depth != 0 || r->root_done) {
+                return xml_fail(r);
+            }
+            for (stop = p + 9; stop < r->end && *stop != '>'; stop++) {
+                if (*stop == '[') {
+                    return xml_fail(r);
+                }
+            }
+            if (stop >= r->end) {
+                return xml_fail(r);
+            }
+            r->cur = stop + 1;
+        } else {
+            return xml_fail(r);
+        }
+    }
+}
+
+/*
+ * Walks the attributes of the last START token. Only valid until the
+ * next call to xml_next().
+ */
+static boolean
+xml_next_attr (const char **pos, const char *end, xml_slice_t *name,
+               xml_slice_t *value)
+{
+    const char *p = *pos;
+    char quote;
+
+    while (p < end && xml_is_space(*p)) {
+        p++;
+    }
+    if (p >= end) {
+        return FALSE;
+    }
+    p = xml_scan_name(p, end, name);
+    *name = xml_local_name(*name);
+    while (*p != '=') {
+        p++;
+    }
+    p++;
+    while (xml_is_space(*p)) {
+        p++;
+    }
+    quote = *p++;
+    value->ptr = p;
+    value->len = (uint32_t) ((const char *) memchr(p, quote, end - p) - p);
+    *pos = p + value->len + 1;
+    return TRUE;
+}
+
+static uint32_t
+xml_put_utf8 (char *out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out[0] = (char) cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char) (0xC0 | (cp >> 6));
+        out[1] = (char) (0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char) (0xE0 | (cp >> 12));
+        out[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char) (0xF0 | (cp >> 18));
+    out[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char) (0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static boolean
+xml_char_ref (xml_slice_t ref, uint32_t *cp)
+{
+    uint32_t i = 1;
+    uint32_t base = 10;
+    uint32_t value = 0;
+    uint32_t digit;
+    char c;
+
+    if (ref.len > 1 && (ref.ptr[1] == 'x')) {
+        base = 16;
+        i = 2;
+    }
+    if (i >= ref.len) {
+        return FALSE;
+    }
+    for (; i < ref.len; i++) {
+        c = ref.ptr[i];
+        if (c >= '0' && c <= '9') {
+            digit = (uint32_t) (c - '0');
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = (uint32_t) (c - 'a' + 10);
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = (uint32_t) (c - 'A' + 10);
+        } else {
+            return FALSE;
+        }
+        value = value * base + digit;
+        if (value > 0x10FFFF) {
+            return FALSE;
+        }
+    }
+    if (value == 0 || (value >= 0xD800 && value <= 0xDFFF)) {
+        return FALSE;
+    }
+    *cp = value;
+    return TRUE;
+}
+
+/*
+ * Appends 'src' to the string in 'dst' ('size' bytes, '*used' of them
+ * taken), replacing character and predefined entity references unless
+ * the text is CDATA. What does not fit is dropped and *used is set to
+ * 'size' so nothing else gets in; 'dst' is always terminated. Returns
+ * FALSE for a malformed reference even when it would not have fit.
+ */
+static boolean
+xml_append_text (char *dst, uint32_t size, uint32_t *used, xml_slice_t src,
+                 boolean cdata)
+{
+    const char *p = src.ptr;
+    const char *end = src.ptr + src.len;
+    const char *run;
+    const char *semi;
+    xml_slice_t ref;
+    char buf[4];
+    uint32_t n;
+    uint32_t cp;
+
+    while (p < end) {
+        run = p;
+        if (!cdata) {
+            p = memchr(p, '&', end - p);
+            if (p == NULL) {
+                p = end;
+            }
+        } else {
+            p = end;
+        }
+        n = (uint32_t) (p - run);
+        if (n != 0 && *used < size) {
+            if (*used + n < size) {
+                memcpy(dst + *used, run, n);
+                *used += n;
+            } else {
+                memcpy(dst + *used, run, size - 1 - *used);
+                dst[size - 1] = '\0';
+                *used = size;
+            }
+        }
+        if (p == end) {
+            break;
+        }
+        semi = memchr(p, ';', end - p);
+        if (semi == NULL) {
+            return FALSE;
+        }
+        ref.ptr = p + 1;
+        ref.len = (uint32_t) (semi - ref.ptr);
+        p = semi + 1;
+        if (xml_eq(ref, "lt")) {
+            buf[0] = '<';
+            n = 1;
+        } else if (xml_eq(ref, "gt")) {
+            buf[0] = '>';
+            n = 1;
+        } else if (xml_eq(ref, "amp")) {
+            buf[0] = '&';
+            n = 1;
+        } else if (xml_eq(ref, "quot")) {
+            buf[0] = '"';
+            n = 1;
+        } else if (xml_eq(ref, "apos")) {
+            buf[0] = '\'';
+            n = 1;
+        } else if (ref.len > 0 && ref.ptr[0] == '#' && xml_char_ref(ref, &cp)) {
+            n = xml_put_utf8(buf, cp);
+        } else {
+            return FALSE;
+        }
+        if (*used < size) {
+            if (*used + n < size) {
+                memcpy(dst + *used, buf, n);
+                *used += n;
+            } else {
+                dst[*used] = '\0';
+                *used = size;
+            }
+        }
+    }
+    if (*used < size) {
+        dst[*used] = '\0';
+    }
+    return TRUE;
+}
+
+/*
+ * Strips leading and trailing white space from a decoded value in place.
+ */
+static void
+xml_strip (char *dst)
+{
+    xml_slice_t s;
+
+    s.ptr = dst;
+    s.len = (uint32_t) strlen(dst);
+    s = xml_trim(s);
+    memmove(dst, s.ptr, s.len);
+    dst[s.len] = '\0';
+}
+
+static boolean
+xml_copy (char *dst, uint32_t size, xml_slice_t value)
+{
+    uint32_t used = 0;
+
+    dst[0] = '\0';
+    if (!xml_append_text(dst, size, &used, value, FALSE)) {
+        return FALSE;
+    }
+    xml_strip(dst);
+    return TRUE;
+}
+
+/*
+ * Collects the character data of the element whose START was just read
+ * and consumes everything up to its END. Text inside child elements is
+ * not part of the value.
+ */
+static boolean
+xml_read_text (xml_reader_t *r, char *dst, uint32_t size)
+{
+    uint16_t depth = r->depth;
+    uint32_t used = 0;
+    xml_token_e tok;
+
+    dst[0] = '\0';
+    for (;;) {
+        tok = xml_next(r);
+        if (tok == XML_TOKEN_TEXT) {
+            if (r->depth == depth &&
+                !xml_append_text(dst, size, &used, r->text, r->cdata)) {
+                return FALSE;
+            }
+        } else if (tok == XML_TOKEN_END) {
+            if (r->depth < depth) {
+                xml_strip(dst);
+                return TRUE;
+            }
+        } else if (tok != XML_TOKEN_START) {
+            return FALSE;
+        }
+    }
+}
+
+/*
+ * Consumes the element whose START was just read.
+ */
+static boolean
+xml_skip (xml_reader_t *r)
+{
+    uint16_t depth = r->depth;
+    xml_token_e tok;
+
+    for (;;) {
+        tok = xml_next(r);
+        if (tok == XML_TOKEN_END) {
+            if (r->depth < depth) {
+                return TRUE;
+            }
+        } else if (tok == XML_TOKEN_EOF || tok == XML_TOKEN_ERROR) {
+            return FALSE;
+        }
+    }
+}
+
+/*
+ * Reads the next child of the current element. Returns TRUE with
+ * r->name set for a child START, FALSE with *ok TRUE once the END of
+ * the current element has been read, and FALSE with *ok FALSE on error.
+ */
+static boolean
+xml_next_child (xml_reader_t *r, boolean *ok)
+{
+    xml_token_e tok;
+
+    for (;;) {
+        tok = xml_next(r);
+        switch (tok) {
+        case XML_TOKEN_START:
+            return TRUE;
+        case XML_TOKEN_TEXT:
+            break;
+        case XML_TOKEN_END:
+            *ok = TRUE;
+            return FALSE;
+        default:
+            *ok = FALSE;
+            return FALSE;
+        }
+    }
+}
+
+static boolean
+xml_parse_u32 (xml_slice_t s, uint32_t *out)
+{
+    uint32_t value = 0;
+    uint32_t i;
+
+    s = xml_trim(s);
+    if (s.len == 0) {
+        return FALSE;
+    }
+    for (i = 0; i < s.len; i++) {
+        if (s.ptr[i] < '0' || s.ptr[i] > '9') {
+            return FALSE;
+        }
+        if (value > (0xFFFFFFFFUL - (uint32_t) (s.ptr[i] - '0')) / 10) {
+            return FALSE;
+        }
+        value = value * 10 + (uint32_t) (s.ptr[i] - '0');
+    }
+    *out = value;
+    return TRUE;
+}
+
+/*
+ * Boolean attributes are "true"/"false"; numbers are taken as is.
+ */
+static boolean
+xml_parse_flag (xml_slice_t s, uint32_t *out)
+{
+    s = xml_trim(s);
+    if (xml_eq(s, "true")) {
+        *out = 1;
+        return TRUE;
+    }
+    if (xml_eq(s, "false")) {
+        *out = 0;
+        return TRUE;
+    }
+    return xml_parse_u32(s, out);
+}
+
+static boolean
+xml_parse_enum (xml_slice_t s, const char *const *names, size_t count,
+                xml_signed32 *out)
+{
+    size_t i;
+
+    s = xml_trim(s);
+    for (i = 0; i < count; i++) {
+        if (xml_eq(s, names[i])) {
+            *out = (xml_signed32) i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static xml_slice_t
+xml_slice (const char *str)
+{
+    xml_slice_t s;
+
+    s.ptr = str;
+    s.len = (uint32_t) strlen(str);
+    return s;
+}
+
+#define XML_COPY(dst, value) xml_copy((dst), sizeof(dst), (value))
+#define XML_READ_TEXT(r, dst) xml_read_text((r), (dst), sizeof(dst))
+#define XML_FOR_EACH_ATTR(r, pos, name, value) \
+    for ((pos) = (r)->attr_begin; \
+         xml_next_attr(&(pos), (r)->attr_end, &(name), &(value)); )
+
+
+/*
+ * application/dialog-info+xml
+ */
+static boolean
+decode_participant (xml_reader_t *r, Participant *part)
+{
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = FALSE;
+    uint32_t num;
+    uint32_t nparam;
+    char buf[16];
+
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "identity")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "display") &&
+                    !XML_COPY(part->identity.display_name, value)) {
+                    return FALSE;
+                }
+            }
+            ok = XML_READ_TEXT(r, part->identity.uri);
+        } else if (xml_eq(r->name, "target")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "uri") &&
+                    !XML_COPY(part->target.uri, value)) {
+                    return FALSE;
+                }
+            }
+            nparam = 0;
+            while (xml_next_child(r, &ok)) {
+                if (xml_eq(r->name, "param") &&
+                    nparam < sizeof(part->target.param) /
+                             sizeof(part->target.param[0])) {
+                    XML_FOR_EACH_ATTR(r, pos, name, value) {
+                        if (xml_eq(name, "pname")) {
+                            ok = XML_COPY(part->target.param[nparam].pname, value);
+                        } else if (xml_eq(name, "pval")) {
+                            ok = XML_COPY(part->target.param[nparam].pval, value);
+                        } else {
+                            continue;
+                        }
+                        if (!ok) {
+                            return FALSE;
+                        }
+                    }
+                    nparam++;
+                }
+                if (!xml_skip(r)) {
+                    return FALSE;
+                }
+            }
+        } else if (xml_eq(r->name, "session-description")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "type") &&
+                    !XML_COPY(part->session_description.type, value)) {
+                    return FALSE;
+                }
+            }
+            ok = xml_skip(r);
+        } else if (xml_eq(r->name, "cseq")) {
+            ok = (XML_READ_TEXT(r, buf) &&
+                  xml_parse_u32(xml_slice(buf), &num) && num <= 0xFFFF);
+            part->cseq = (xml_unsigned16) num;
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+static boolean
+decode_dialog (xml_reader_t *r, DialogStruct *dialog)
+{
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = TRUE;
+    uint32_t num;
+    char buf[16];
+
+    dialog->direction = -1;
+    dialog->state.event = -1;
+    dialog->state.state = -1;
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "id")) {
+            ok = XML_COPY(dialog->id, value);
+        } else if (xml_eq(name, "call-id")) {
+            ok = XML_COPY(dialog->call_id, value);
+        } else if (xml_eq(name, "local-tag")) {
+            ok = XML_COPY(dialog->local_tag, value);
+        } else if (xml_eq(name, "remote-tag")) {
+            ok = XML_COPY(dialog->remote_tag, value);
+        } else if (xml_eq(name, "direction")) {
+            ok = xml_parse_enum(value, XML_NAMES(xml_direction_names),
+                                &dialog->direction);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "state")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "event")) {
+                    ok = xml_parse_enum(value, XML_NAMES(xml_event_names),
+                                        &dialog->state.event);
+                } else if (xml_eq(name, "code")) {
+                    ok = xml_parse_u32(value, &num) && num <= 999;
+                    dialog->state.code = (xml_signed32) num;
+                }
+                if (!ok) {
+                    return FALSE;
+                }
+            }
+            ok = (XML_READ_TEXT(r, buf) &&
+                  xml_parse_enum(xml_slice(buf),
+                                 XML_NAMES(xml_dialog_state_names),
+                                 &dialog->state.state));
+        } else if (xml_eq(r->name, "duration")) {
+            ok = (XML_READ_TEXT(r, buf) && xml_parse_u32(xml_slice(buf), &num));
+            dialog->duration = num;
+        } else if (xml_eq(r->name, "replaces")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "call-id")) {
+                    ok = XML_COPY(dialog->replaces.call_id, value);
+                } else if (xml_eq(name, "local-tag")) {
+                    ok = XML_COPY(dialog->replaces.local_tag, value);
+                } else if (xml_eq(name, "remote-tag")) {
+                    ok = XML_COPY(dialog->replaces.remote_tag, value);
+                }
+                if (!ok) {
+                    return FALSE;
+                }
+            }
+            ok = xml_skip(r);
+        } else if (xml_eq(r->name, "referred-by")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "display") &&
+                    !XML_COPY(dialog->referred_by.display_name, value)) {
+                    return FALSE;
+                }
+            }
+            ok = XML_READ_TEXT(r, dialog->referred_by.uri);
+        } else if (xml_eq(r->name, "local")) {
+            ok = decode_participant(r, &dialog->local);
+        } else if (xml_eq(r->name, "remote")) {
+            ok = decode_participant(r, &dialog->remote);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    /* RFC 4235: every dialog has a state */
+    return (ok && dialog->state.state != -1);
+}
+
+static boolean
+decode_dialog_info (xml_reader_t *r, ccsip_event_data_t *data)
+{
+    DialogInfoStruct *info = &data->u.dialog_info;
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = TRUE;
+    uint32_t num;
+
+    if (!xml_eq(r->name, "dialog-info")) {
+        return FALSE;
+    }
+    data->type = EVENT_DATA_DIALOG;
+    info->state = -1;
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "version")) {
+            ok = xml_parse_u32(value, &num);
+            info->version = num;
+        } else if (xml_eq(name, "state")) {
+            ok = xml_parse_enum(value, XML_NAMES(xml_state_names), &info->state);
+        } else if (xml_eq(name, "entity")) {
+            ok = XML_COPY(info->entity, value);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "dialog")) {
+            /* Dialogs past the ones kept are still checked, only counted */
+            if (info->num_dialogs < XML_MAX_DIALOGS) {
+                ok = decode_dialog(r, &info->dialog[info->num_dialogs++]);
+            } else {
+                ok = xml_skip(r);
+            }
+            info->total_dialogs++;
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+
+/*
+ * application/pidf+xml, with the RPID activities a BLF notifier sends
+ */
+static boolean
+decode_activities (xml_reader_t *r, ActivitiesStruct *activities,
+                   Presence_ext_t *ext)
+{
+    boolean ok = FALSE;
+
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "on-the-phone")) {
+            ext->onThePhone = TRUE;
+            ok = XML_READ_TEXT(r, activities->onThePhone);
+        } else if (xml_eq(r->name, "busy")) {
+            ext->busy = TRUE;
+            ok = XML_READ_TEXT(r, activities->busy);
+        } else if (xml_eq(r->name, "away")) {
+            ext->away = TRUE;
+            ok = XML_READ_TEXT(r, activities->away);
+        } else if (xml_eq(r->name, "meeting")) {
+            ext->meeting = TRUE;
+            ok = XML_READ_TEXT(r, activities->meeting);
+        } else if (xml_eq(r->name, "alerting")) {
+            ext->alerting = TRUE;
+            ok = XML_READ_TEXT(r, activities->alerting);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+static boolean
+decode_status (xml_reader_t *r, char *basic, uint32_t basic_size,
+               ActivitiesStruct *activities, Presence_ext_t *ext)
+{
+    boolean ok = FALSE;
+
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "basic")) {
+            ok = xml_read_text(r, basic, basic_size);
+        } else if (xml_eq(r->name, "activities")) {
+            ok = decode_activities(r, activities, ext);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+static boolean
+decode_tuple (xml_reader_t *r, TupleStruct *tuple, Presence_ext_t *ext)
+{
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = FALSE;
+
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "id") && !XML_COPY(tuple->id, value)) {
+            return FALSE;
+        }
+    }
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "status")) {
+            ok = decode_status(r, tuple->status.basic,
+                               sizeof(tuple->status.basic),
+                               &tuple->status.activities, ext);
+        } else if (xml_eq(r->name, "contact") && tuple->contact[0][0] == '\0') {
+            ok = XML_READ_TEXT(r, tuple->contact[0]);
+        } else if (xml_eq(r->name, "note") && tuple->note[0][0] == '\0') {
+            ok = XML_READ_TEXT(r, tuple->note[0]);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+static boolean
+decode_person (xml_reader_t *r, PersonStruct *person, Presence_ext_t *ext)
+{
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = FALSE;
+
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "id") && !XML_COPY(person->id, value)) {
+            return FALSE;
+        }
+    }
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "status")) {
+            ok = decode_status(r, person->personStatus.basic,
+                               sizeof(person->personStatus.basic),
+                               &person->activities, ext);
+        } else if (xml_eq(r->name, "activities")) {
+            ok = decode_activities(r, &person->activities, ext);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+static boolean
+decode_presence (xml_reader_t *r, ccsip_event_data_t *data)
+{
+    Presence_ext_t *ext = &data->u.presence_rpid;
+    PresenceRPIDStruct *pres = &ext->presence_body;
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = FALSE;
+    boolean tuple_seen = FALSE;
+    boolean person_seen = FALSE;
+    uint32_t notes = 0;
+
+    if (!xml_eq(r->name, "presence")) {
+        return FALSE;
+    }
+    data->type = EVENT_DATA_PRESENCE;
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "entity") && !XML_COPY(pres->entity, value)) {
+            return FALSE;
+        }
+    }
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "tuple") && !tuple_seen) {
+            tuple_seen = TRUE;
+            ok = decode_tuple(r, &pres->tuple[0], ext);
+        } else if (xml_eq(r->name, "person") && !person_seen) {
+            person_seen = TRUE;
+            ok = decode_person(r, &pres->person, ext);
+        } else if (xml_eq(r->name, "note") &&
+                   notes < sizeof(pres->note) / sizeof(pres->note[0])) {
+            ok = XML_READ_TEXT(r, pres->note[notes++]);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return ok;
+}
+
+
+/*
+ * application/kpml-request+xml and application/kpml-response+xml
+ */
+static boolean
+decode_pattern (xml_reader_t *r, Pattern *pattern)
+{
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = TRUE;
+    boolean regex_seen = FALSE;
+    uint32_t num = 0;
+    char buf[8];
+
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "persist")) {
+            ok = xml_parse_enum(value, XML_NAMES(xml_persist_names),
+                                &pattern->persist);
+        } else if (xml_eq(name, "interdigittimer")) {
+            ok = xml_parse_u32(value, &num);
+            pattern->interdigittimer = num;
+        } else if (xml_eq(name, "criticaldigittimer")) {
+            ok = xml_parse_u32(value, &num);
+            pattern->criticaldigittimer = num;
+        } else if (xml_eq(name, "extradigittimer")) {
+            ok = xml_parse_u32(value, &num);
+            pattern->extradigittimer = num;
+        } else if (xml_eq(name, "long")) {
+            ok = xml_parse_flag(value, &num) && num <= 0xFFFF;
+            pattern->longhold = (xml_unsigned16) num;
+        } else if (xml_eq(name, "longrepeat")) {
+            ok = xml_parse_flag(value, &num) && num <= 0xFF;
+            pattern->longrepeat = (xml_unsigned8) num;
+        } else if (xml_eq(name, "nopartial")) {
+            ok = xml_parse_flag(value, &num) && num <= 0xFF;
+            pattern->nopartial = (xml_unsigned8) num;
+        } else if (xml_eq(name, "enterkey")) {
+            ok = XML_COPY(pattern->enterkey, value);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "flush")) {
+            ok = XML_READ_TEXT(r, buf);
+            if (ok && !cpr_strcasecmp(buf, "yes")) {
+                pattern->flush = XML_YES;
+            } else if (ok && !cpr_strcasecmp(buf, "no")) {
+                pattern->flush = XML_NO;
+            } else {
+                ok = FALSE;
+            }
+        } else if (xml_eq(r->name, "regex") && !regex_seen) {
+            regex_seen = TRUE;
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "tag")) {
+                    ok = XML_COPY(pattern->regex.tag, value);
+                } else if (xml_eq(name, "pre")) {
+                    ok = XML_COPY(pattern->regex.pre, value);
+                }
+                if (!ok) {
+                    return FALSE;
+                }
+            }
+            ok = XML_READ_TEXT(r, pattern->regex.regexData);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return (ok && regex_seen);
+}
+
+static boolean
+decode_kpml_request (xml_reader_t *r, ccsip_event_data_t *data)
+{
+    KPMLRequest *req = &data->u.kpml_request;
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = FALSE;
+    boolean pattern_seen = FALSE;
+
+    if (!xml_eq(r->name, "kpml-request")) {
+        return FALSE;
+    }
+    data->type = EVENT_DATA_KPML_REQUEST;
+    /* RFC 4730 defaults */
+    req->pattern.persist = XML_PERSIST_TYPE_ONE_SHOT;
+    req->pattern.interdigittimer = 4000;
+    req->pattern.criticaldigittimer = 1000;
+    req->pattern.extradigittimer = 500;
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "version") && !XML_COPY(req->version, value)) {
+            return FALSE;
+        }
+    }
+    while (xml_next_child(r, &ok)) {
+        if (xml_eq(r->name, "pattern") && !pattern_seen) {
+            pattern_seen = TRUE;
+            ok = decode_pattern(r, &req->pattern);
+        } else if (xml_eq(r->name, "stream")) {
+            XML_FOR_EACH_ATTR(r, pos, name, value) {
+                if (xml_eq(name, "reverse") &&
+                    !XML_COPY(req->stream.reverse, value)) {
+                    return FALSE;
+                }
+            }
+            ok = xml_skip(r);
+        } else {
+            ok = xml_skip(r);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return (ok && pattern_seen);
+}
+
+static boolean
+decode_kpml_response (xml_reader_t *r, ccsip_event_data_t *data)
+{
+    KPMLResponse *resp = &data->u.kpml_response;
+    const char *pos;
+    xml_slice_t name;
+    xml_slice_t value;
+    boolean ok = TRUE;
+    uint32_t num;
+
+    if (!xml_eq(r->name, "kpml-response")) {
+        return FALSE;
+    }
+    data->type = EVENT_DATA_KPML_RESPONSE;
+    XML_FOR_EACH_ATTR(r, pos, name, value) {
+        if (xml_eq(name, "version")) {
+            ok = XML_COPY(resp->version, value);
+        } else if (xml_eq(name, "code")) {
+            ok = XML_COPY(resp->code, value);
+        } else if (xml_eq(name, "text")) {
+            ok = XML_COPY(resp->text, value);
+        } else if (xml_eq(name, "suppressed")) {
+            ok = xml_parse_flag(value, &num) && num <= 0xFF;
+            resp->suppressed = (xml_unsigned8) num;
+        } else if (xml_eq(name, "forced_flush")) {
+            ok = XML_COPY(resp->forced_flush, value);
+        } else if (xml_eq(name, "digits")) {
+            ok = XML_COPY(resp->digits, value);
+        } else if (xml_eq(name, "tag")) {
+            ok = XML_COPY(resp->tag, value);
+        }
+        if (!ok) {
+            return FALSE;
+        }
+    }
+    return xml_skip(r);
+}
+
+
+boolean
+ccsip_decode_event_body (uint8_t content_type, const char *body, uint32_t len,
+                         ccsip_event_data_t *data)
+{
+    xml_reader_t r;
+    boolean (*decode)(xml_reader_t *r, ccsip_event_data_t *data);
+
+    switch (content_type) {
+    case SIP_CONTENT_TYPE_DIALOG_VALUE:
+        decode = decode_dialog_info;
+        break;
+    case SIP_CONTENT_TYPE_PRESENCE_VALUE:
+        decode = decode_presence;
+        break;
+    case SIP_CONTENT_TYPE_KPML_REQUEST_VALUE:
+        decode = decode_kpml_request;
+        break;
+    case SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE:
+        decode = decode_kpml_response;
+        break;
+    default:
+        return FALSE;
+    }
+    if (body == NULL || data == NULL) {
+        return FALSE;
+    }
+
+    memset(data, 0, sizeof(*data));
+    xml_reader_init(&r, body, len);
+    if (xml_next(&r) != XML_TOKEN_START || !decode(&r, data) ||
+        xml_next(&r) != XML_TOKEN_EOF) {
+        data->type = EVENT_DATA_INVALID;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+/*
+ * Encoder
+ *
+ * Each document is written twice through the same function: once with
+ * no buffer to measure it, then into a single allocation of that size.
+ */
+typedef struct {
+    char     *buf;      /* NULL while measuring */
+    uint32_t  len;
+} xml_writer_t;
+
+static void
+xw_raw (xml_writer_t *w, const char *s, uint32_t n)
+{
+    if (w->buf) {
+        memcpy(w->buf + w->len, s, n);
+    }
+    w->len += n;
+}
+
+static void
+xw_str (xml_writer_t *w, const char *s)
+{
+    xw_raw(w, s, (uint32_t) strlen(s));
+}
+
+static void
+xw_escaped (xml_writer_t *w, const char *s)
+{
+    const char *run = s;
+    const char *ref;
+
+    for (; *s; s++) {
+        switch (*s) {
+        case '<':  ref = "&lt;";   break;
+        case '>':  ref = "&gt;";   break;
+        case '&':  ref = "&amp;";  break;
+        case '"':  ref = "&quot;"; break;
+        case '\'': ref = "&apos;"; break;
+        case '\t': ref = "&#9;";   break;
+        case '\n': ref = "&#10;";  break;
+        case '\r': ref = "&#13;";  break;
+        default:
+            continue;
+        }
+        xw_raw(w, run, (uint32_t) (s - run));
+        xw_str(w, ref);
+        run = s + 1;
+    }
+    xw_raw(w, run, (uint32_t) (s - run));
+}
+
+static void
+xw_attr (xml_writer_t *w, const char *name, const char *value)
+{
+    if (value[0] == '\0') {
+        return;
+    }
+    xw_str(w, " ");
+    xw_str(w, name);
+    xw_str(w, "=\"");
+    xw_escaped(w, value);
+    xw_str(w, "\"");
+}
+
+static void
+xw_attr_num (xml_writer_t *w, const char *name, unsigned long value)
+{
+    char buf[24];
+
+    snprintf(buf, sizeof(buf), "%lu", value);
+    xw_attr(w, name, buf);
+}
+
+static void
+xw_element (xml_writer_t *w, const char *name, const char *text)
+{
+    if (text[0] == '\0') {
+        return;
+    }
+    xw_str(w, "<");
+    xw_str(w, name);
+    xw_str(w, ">");
+    xw_escaped(w, text);
+    xw_str(w, "</");
+    xw_str(w, name);
+    xw_str(w, ">");
+}
+
+static void
+xw_element_num (xml_writer_t *w, const char *name, unsigned long value)
+{
+    char buf[24];
+
+    snprintf(buf, sizeof(buf), "%lu", value);
+    xw_element(w, name, buf);
+}
+
+static const char *
+xml_enum_name (xml_signed32 value, const char *const *names, size_t count)
+{
+    if (value < 0 || (size_t) value >= count) {
+        return "";
+    }
+    return names[value];
+}
+
+static void
+encode_participant (xml_writer_t *w, const char *tag, const Participant *part)
+{
+    size_t i;
+
+    if (part->identity.uri[0] == '\0' && part->target.uri[0] == '\0' &&
+        part->session_description.type[0] == '\0' && part->cseq == 0) {
+        return;
+    }
+    xw_str(w, "<");
+    xw_str(w, tag);
+    xw_str(w, ">");
+    if (part->identity.uri[0]) {
+        xw_str(w, "<identity");
+        xw_attr(w, "display", part->identity.display_name);
+        xw_str(w, ">");
+        xw_escaped(w, part->identity.uri);
+        xw_str(w, "</identity>");
+    }
+    if (part->target.uri[0]) {
+        xw_str(w, "<target");
+        xw_attr(w, "uri", part->target.uri);
+        xw_str(w, ">");
+        for (i = 0; i < sizeof(part->target.param) /
+                        sizeof(part->target.param[0]); i++) {
+            if (part->target.param[i].pname[0]) {
+                xw_str(w, "<param");
+                xw_attr(w, "pname", part->target.param[i].pname);
+                xw_attr(w, "pval", part->target.param[i].pval);
+                xw_str(w, "/>");
+            }
+        }
+        xw_str(w, "</target>");
+    }
+    if (part->session_description.type[0]) {
+        xw_str(w, "<session-description");
+        xw_attr(w, "type", part->session_description.type);
+        xw_str(w, "/>");
+    }
+    if (part->cseq) {
+        xw_element_num(w, "cseq", part->cseq);
+    }
+    xw_str(w, "</");
+    xw_str(w, tag);
+    xw_str(w, ">");
+}
+
+static void
+encode_dialog_info (xml_writer_t *w, const ccsip_event_data_t *data)
+{
+    const DialogInfoStruct *info = &data->u.dialog_info;
+    const DialogStruct *dialog;
+    uint16_t i;
+
+    xw_str(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\"");
+    xw_attr_num(w, "version", info->version);
+    xw_attr(w, "state", xml_enum_name(info->state, XML_NAMES(xml_state_names)));
+    xw_attr(w, "entity", info->entity);
+    xw_str(w, ">\n");
+    for (i = 0; i < info->num_dialogs && i < XML_MAX_DIALOGS; i++) {
+        dialog = &info->dialog[i];
+        xw_str(w, "<dialog");
+        xw_attr(w, "id", dialog->id);
+        xw_attr(w, "call-id", dialog->call_id);
+        xw_attr(w, "local-tag", dialog->local_tag);
+        xw_attr(w, "remote-tag", dialog->remote_tag);
+        xw_attr(w, "direction", xml_enum_name(dialog->direction,
+                                              XML_NAMES(xml_direction_names)));
+        xw_str(w, ">");
+        xw_str(w, "<state");
+        xw_attr(w, "event", xml_enum_name(dialog->state.event,
+                                          XML_NAMES(xml_event_names)));
+        if (dialog->state.code > 0) {
+            xw_attr_num(w, "code", (unsigned long) dialog->state.code);
+        }
+        xw_str(w, ">");
+        xw_str(w, xml_enum_name(dialog->state.state,
+                                XML_NAMES(xml_dialog_state_names)));
+        xw_str(w, "</state>");
+        if (dialog->duration) {
+            xw_element_num(w, "duration", dialog->duration);
+        }
+        if (dialog->replaces.call_id[0]) {
+            xw_str(w, "<replaces");
+            xw_attr(w, "call-id", dialog->replaces.call_id);
+            xw_attr(w, "local-tag", dialog->replaces.local_tag);
+            xw_attr(w, "remote-tag", dialog->replaces.remote_tag);
+            xw_str(w, "/>");
+        }
+        if (dialog->referred_by.uri[0]) {
+            xw_str(w, "<referred-by");
+            xw_attr(w, "display", dialog->referred_by.display_name);
+            xw_str(w, ">");
+            xw_escaped(w, dialog->referred_by.uri);
+            xw_str(w, "</referred-by>");
+        }
+        encode_participant(w, "local", &dialog->local);
+        encode_participant(w, "remote", &dialog->remote);
+        xw_str(w, "</dialog>\n");
+    }
+    xw_str(w, "</dialog-info>\n");
+}
+
+static void
+encode_activities (xml_writer_t *w, const ActivitiesStruct *activities,
+                   const Presence_ext_t *ext)
+{
+    static const char *const names[] = {
+        "on-the-phone", "busy", "away", "meeting", "alerting"
+    };
+    const char *text[5];
+    boolean set[5];
+    size_t i;
+
+    text[0] = activities->onThePhone;
+    text[1] = activities->busy;
+    text[2] = activities->away;
+    text[3] = activities->meeting;
+    text[4] = activities->alerting;
+    set[0] = ext->onThePhone;
+    set[1] = ext->busy;
+    set[2] = ext->away;
+    set[3] = ext->meeting;
+    set[4] = ext->alerting;
+    if (!set[0] && !set[1] && !set[2] && !set[3] && !set[4]) {
+        return;
+    }
+    xw_str(w, "<rpid:activities>");
+    for (i = 0; i < 5; i++) {
+        if (!set[i]) {
+            continue;
+        }
+        xw_str(w, "<rpid:");
+        xw_str(w, names[i]);
+        if (text[i][0]) {
+            xw_str(w, ">");
+            xw_escaped(w, text[i]);
+            xw_str(w, "</rpid:");
+            xw_str(w, names[i]);
+            xw_str(w, ">");
+        } else {
+            xw_str(w, "/>");
+        }
+    }
+    xw_str(w, "</rpid:activities>");
+}
+
+static void
+encode_presence (xml_writer_t *w, const ccsip_event_data_t *data)
+{
+    const Presence_ext_t *ext = &data->u.presence_rpid;
+    const PresenceRPIDStruct *pres = &ext->presence_body;
+    const TupleStruct *tuple = &pres->tuple[0];
+    size_t i;
+
+    xw_str(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\""
+              " xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\""
+              " xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\"");
+    xw_attr(w, "entity", pres->entity);
+    xw_str(w, ">\n");
+    if (tuple->id[0] || tuple->status.basic[0]) {
+        xw_str(w, "<tuple");
+        xw_attr(w, "id", tuple->id);
+        xw_str(w, "><status>");
+        xw_element(w, "basic", tuple->status.basic);
+        xw_str(w, "</status>");
+        xw_element(w, "contact", tuple->contact[0]);
+        xw_element(w, "note", tuple->note[0]);
+        xw_str(w, "</tuple>\n");
+    }
+    /* the activity flags belong to the person */
+    xw_str(w, "<dm:person");
+    xw_attr(w, "id", pres->person.id);
+    xw_str(w, ">");
+    if (pres->person.personStatus.basic[0]) {
+        xw_str(w, "<status>");
+        xw_element(w, "basic", pres->person.personStatus.basic);
+        xw_str(w, "</status>");
+    }
+    encode_activities(w, &pres->person.activities, ext);
+    xw_str(w, "</dm:person>\n");
+    for (i = 0; i < sizeof(pres->note) / sizeof(pres->note[0]); i++) {
+        xw_element(w, "note", pres->note[i]);
+    }
+    xw_str(w, "</presence>\n");
+}
+
+static void
+encode_kpml_request (xml_writer_t *w, const ccsip_event_data_t *data)
+{
+    const KPMLRequest *req = &data->u.kpml_request;
+    const Pattern *pattern = &req->pattern;
+
+    xw_str(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<kpml-request xmlns=\"urn:ietf:params:xml:ns:kpml-request\"");
+    xw_attr(w, "version", req->version);
+    xw_str(w, ">\n");
+    if (req->stream.reverse[0]) {
+        xw_str(w, "<stream");
+        xw_attr(w, "reverse", req->stream.reverse);
+        xw_str(w, "/>\n");
+    }
+    xw_str(w, "<pattern");
+    xw_attr(w, "persist", xml_enum_name(pattern->persist,
+                                        XML_NAMES(xml_persist_names)));
+    xw_attr_num(w, "interdigittimer", pattern->interdigittimer);
+    xw_attr_num(w, "criticaldigittimer", pattern->criticaldigittimer);
+    xw_attr_num(w, "extradigittimer", pattern->extradigittimer);
+    if (pattern->longhold) {
+        xw_attr_num(w, "long", pattern->longhold);
+    }
+    if (pattern->longrepeat) {
+        xw_attr(w, "longrepeat", "true");
+    }
+    if (pattern->nopartial) {
+        xw_attr(w, "nopartial", "true");
+    }
+    xw_attr(w, "enterkey", pattern->enterkey);
+    xw_str(w, ">");
+    if (pattern->flush == XML_YES) {
+        xw_str(w, "<flush>yes</flush>");
+    }
+    xw_str(w, "<regex");
+    xw_attr(w, "tag", pattern->regex.tag);
+    xw_attr(w, "pre", pattern->regex.pre);
+    xw_str(w, ">");
+    xw_escaped(w, pattern->regex.regexData);
+    xw_str(w, "</regex></pattern>\n</kpml-request>\n");
+}
+
+static void
+encode_kpml_response (xml_writer_t *w, const ccsip_event_data_t *data)
+{
+    const KPMLResponse *resp = &data->u.kpml_response;
+
+    xw_str(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<kpml-response xmlns=\"urn:ietf:params:xml:ns:kpml-response\"");
+    xw_attr(w, "version", resp->version);
+    xw_attr(w, "code", resp->code);
+    xw_attr(w, "text", resp->text);
+    if (resp->suppressed) {
+        xw_attr(w, "suppressed", "true");
+    }
+    xw_attr(w, "forced_flush", resp->forced_flush);
+    xw_attr(w, "digits", resp->digits);
+    xw_attr(w, "tag", resp->tag);
+    xw_str(w, "/>\n");
+}
+
+char *
+ccsip_encode_event_body (const ccsip_event_data_t *data, uint32_t *len,
+                         const char **content_type)
+{
+    void (*encode)(xml_writer_t *w, const ccsip_event_data_t *data);
+    xml_writer_t w;
+    char *body;
+
+    switch (data->type) {
+    case EVENT_DATA_RAW:
+        // Assume body is of type CMXML for now
+        if (data->u.raw_data.data == NULL || data->u.raw_data.length == 0) {
+            return NULL;
+        }
+        body = (char *) cpr_malloc(data->u.raw_data.length + 1);
+        if (body == NULL) {
+            return NULL;
+        }
+        memcpy(body, data->u.raw_data.data, data->u.raw_data.length);
+        body[data->u.raw_data.length] = '\0';
+        *len = data->u.raw_data.length;
+        *content_type = SIP_CONTENT_TYPE_CMXML;
+        return body;
+    case EVENT_DATA_DIALOG:
+        encode = encode_dialog_info;
+        *content_type = SIP_CONTENT_TYPE_DIALOG;
+        break;
+    case EVENT_DATA_PRESENCE:
+        encode = encode_presence;
+        *content_type = SIP_CONTENT_TYPE_PRESENCE;
+        break;
+    case EVENT_DATA_KPML_REQUEST:
+        encode = encode_kpml_request;
+        *content_type = SIP_CONTENT_TYPE_KPML_REQUEST;
+        break;
+    case EVENT_DATA_KPML_RESPONSE:
+        encode = encode_kpml_response;
+        *content_type = SIP_CONTENT_TYPE_KPML_RESPONSE;
+        break;
+    default:
+        return NULL;
+    }
+
+    w.buf = NULL;
+    w.len = 0;
+    encode(&w, data);
+    body = (char *) cpr_malloc(w.len + 1);
+    if (body == NULL) {
+        return NULL;
+    }
+    w.buf = body;
+    w.len = 0;
+    encode(&w, data);
+    body[w.len] = '\0';
+    *len = w.len;
+    return body;
+}
@@ -60,6 +60,7 @@
 #include "ccsip_credentials.h"
 #include "dns_utils.h"
 #include "config.h"
+#include "config_snapshot.h"
 #include "string_lib.h"
 #include "dialplan.h"
 #include "rtp_defs.h"
@@ -91,8 +92,8 @@
 
 /* External declarations */
 extern int dns_error_code; // DNS error code global
-extern sipPlatformUITimer_t sipPlatformUISMTimers[];
-extern sipCallHistory_t gCallHistory[];
+extern sipPlatformUITimer_t *sipPlatformUISMTimers;
+extern sipCallHistory_t *gCallHistory;
 extern ccsipGlobInfo_t gGlobInfo;
 extern int16_t clockIsSetup;
 extern struct tm *gmtime_r(const time_t *, struct tm *);
@@ -1062,7 +1063,7 @@ sipSPISendAck (ccsipCCB_t *ccb, sipMessage_t *response)
     sipRet_t        tflag = STATUS_SUCCESS;
     sipMessageFlag_t messageflag;
     uint32_t         response_cseq_number = 0;
-    sipCseq_t       *response_cseq_structure;
+    const sipCseq_t *response_cseq_structure;
     const char      *response_cseq;
     int16_t          trx_index = -1;
     boolean          retval;
@@ -1091,14 +1092,13 @@ sipSPISendAck (ccsipCCB_t *ccb, sipMessage_t *response)
                               "header.\n", fname);
             return (FALSE);
         }
-        response_cseq_structure = sippmh_parse_cseq(response_cseq);
+        response_cseq_structure = sippmh_get_parsed_cseq(response);
         if (!response_cseq_structure) {
             CCSIP_DEBUG_ERROR("%s: Error: Unable to parse response CSeq "
                               "header.\n", fname);
             return (FALSE);
         }
         response_cseq_number = response_cseq_structure->number;
-        cpr_free(response_cseq_structure);
         CCSIP_DEBUG_STATE(DEB_F_PREFIX"Cseq from response = %d \n", 
             DEB_F_PREFIX_ARGS(SIP_ACK, "sipSPISendAck"), response_cseq_number);
     } else {
@@ -1941,11 +1941,11 @@ sipSPISendInfo (ccsipCCB_t *ccb, const char *info_package,
         return FALSE;
     }
 
-    retval = SendRequest(ccb, request, sipMethodInfo, TRUE, FALSE, FALSE);
+    retval = SendRequest(ccb, request, sipMethodInfo, TRUE, TRUE, FALSE);
 
-    // Don't keep the trx so as not to mess up the retran timer of other requests
     /*
-     * FIXME fix it when the framework is modified to support concurrent requests
+     * The INFO is retransmitted by its own client transaction and its
+     * response never reaches the call state machine, so don't keep the trx
      */
     clean_method_request_trx(ccb, sipMethodInfo, TRUE);
 
@@ -2138,12 +2138,12 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
     const char    *sip_to         = NULL;
     const char    *request_callid = NULL;
     const char    *request_cseq   = NULL;
-    sipCseq_t     *request_cseq_structure = NULL;
+    const sipCseq_t *request_cseq_structure = NULL;
     char           temp[MAX_SIP_HEADER_LENGTH];
-    sipLocation_t *to_loc         = NULL;
+    const sipLocation_t *to_loc = NULL;
     char           sip_to_tag[MAX_SIP_TAG_LENGTH];
     char           sip_to_temp[MAX_SIP_URL_LENGTH];
-    sipLocation_t *from_loc       = NULL;
+    const sipLocation_t *from_loc = NULL;
     boolean        request_uri_error = FALSE;
     sipReqLine_t  *requestURI     = NULL;
     sipLocation_t *uri_loc        = NULL;
@@ -2219,7 +2219,7 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
     /*
      * Parse From
      */
-    from_loc = sippmh_parse_from_or_to((char *)sip_from, TRUE);
+    from_loc = sippmh_get_parsed_from(msg);
     if (!from_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname,
@@ -2237,16 +2237,10 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
         return (FALSE);
     }
 
-    /*
-     * From is parsed just to make sure we got valid From
-     * Header, so we free it now
-     */
-    sippmh_free_location(from_loc);
-
     /*
      * Parse To
      */
-    to_loc = sippmh_parse_from_or_to((char *)sip_to, TRUE);
+    to_loc = sippmh_get_parsed_to(msg);
     if (!to_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname,
@@ -2281,7 +2275,6 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                               fname, SIP_CLI_ERR_BAD_REQ);
         }
-        sippmh_free_location(to_loc);
         return (FALSE);
     } else {
         sip_util_make_tag(sip_to_tag);
@@ -2290,7 +2283,6 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
         strncat(sip_to_temp, sip_to_tag,
                 MAX_SIP_URL_LENGTH - strlen(sip_to_temp) - 1);
     }
-    sippmh_free_location(to_loc);
 
     tflag = sippmh_add_response_line(response, SIP_VERSION, SIP_STATUS_SUCCESS,
                                      SIP_SUCCESS_SETUP_PHRASE);
@@ -2311,7 +2303,7 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
     /* Write CSeq */
     request_cseq = sippmh_get_cached_header_val(msg, CSEQ);
     if (request_cseq) {
-        request_cseq_structure = sippmh_parse_cseq(request_cseq);
+        request_cseq_structure = sippmh_get_parsed_cseq(msg);
         if (!request_cseq_structure) {
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                               fname, "sippmh_parse_cseq()");
@@ -2335,11 +2327,9 @@ sipSPIsendNonActiveOptionResponse (sipMessage_t *msg,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_BAD_REQ);
             }
-            cpr_free(request_cseq_structure);
             return FALSE;
         }
         tflag = sippmh_add_text_header(response, SIP_HEADER_CSEQ, request_cseq);
-        cpr_free(request_cseq_structure);
         UPDATE_FLAGS(flag, tflag);
     }
 
@@ -2641,7 +2631,7 @@ sipSPISendErrorResponse (sipMessage_t *msg,
     const char   *sip_to   = NULL;
     const char   *request_callid = NULL;
     const char   *request_cseq   = NULL;
-    sipCseq_t    *request_cseq_structure = NULL;
+    const sipCseq_t *request_cseq_structure = NULL;
     sipMethod_t   method   = sipMethodInvalid;
     boolean       result   = FALSE;
     char          temp[MAX_SIP_HEADER_LENGTH];
@@ -2740,7 +2730,7 @@ sipSPISendErrorResponse (sipMessage_t *msg,
     /* Write CSeq */
     request_cseq = sippmh_get_cached_header_val(msg, CSEQ);
     if (request_cseq) {
-        request_cseq_structure = sippmh_parse_cseq(request_cseq);
+        request_cseq_structure = sippmh_get_parsed_cseq(msg);
         if (!request_cseq_structure) {
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                               fname, "sippmh_parse_cseq()");
@@ -2749,7 +2739,6 @@ sipSPISendErrorResponse (sipMessage_t *msg,
         }
         tflag = sippmh_add_text_header(response, SIP_HEADER_CSEQ, request_cseq);
         method = request_cseq_structure->method;
-        cpr_free(request_cseq_structure);
         UPDATE_FLAGS(flag, tflag);
     } else {
         CCSIP_DEBUG_ERROR("%s: Error: Did not find valid CSeq header. "
@@ -2808,7 +2797,7 @@ sipSPISendFailureResponseAck (ccsipCCB_t *ccb, sipMessage_t *response,
     cpr_ip_addr_t   src_ipaddr;
     uint32_t        dest_port = 0;
     uint32_t        cseq_number = 0;
-    sipCseq_t      *response_cseq_structure;
+    const sipCseq_t *response_cseq_structure;
     sipMethod_t     response_cseq_method = sipMethodInvalid;
     sipRespLine_t  *respLine = NULL;
     int             status_code = 0;
@@ -2881,7 +2870,7 @@ sipSPISendFailureResponseAck (ccsipCCB_t *ccb, sipMessage_t *response,
                           "header.\n", fname);
         return;
     }
-    response_cseq_structure = sippmh_parse_cseq(response_cseq);
+    response_cseq_structure = sippmh_get_parsed_cseq(response);
     if (!response_cseq_structure) {
         CCSIP_DEBUG_ERROR("%s: Error: Unable to parse request's CSeq "
                           "header.\n", fname);
@@ -2889,7 +2878,6 @@ sipSPISendFailureResponseAck (ccsipCCB_t *ccb, sipMessage_t *response,
     }
     cseq_number = response_cseq_structure->number;
     response_cseq_method = response_cseq_structure->method;
-    cpr_free(response_cseq_structure);
 
     // Process the Failure response
     response_to = sippmh_get_cached_header_val(response, TO);
@@ -3180,7 +3168,7 @@ sipGetResponseMethod (sipMessage_t *pResponse, sipMethod_t *pMethod)
     const char    *fname = "SIPGetResponseMethod";
     sipRespLine_t *pRespLine = NULL;
     const char    *cseq = NULL;
-    sipCseq_t     *sipCseq = NULL;
+    const sipCseq_t *sipCseq = NULL;
 
     pRespLine = sippmh_get_response_line(pResponse);
     if (pRespLine) {
@@ -3192,7 +3180,7 @@ sipGetResponseMethod (sipMessage_t *pResponse, sipMethod_t *pMethod)
             return (-1);
         }
         /* Extract method code */
-        sipCseq = sippmh_parse_cseq(cseq);
+        sipCseq = sippmh_get_parsed_cseq(pResponse);
         if (!sipCseq) {
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                               fname, "sippmh_parse_cseq()");
@@ -3200,7 +3188,6 @@ sipGetResponseMethod (sipMessage_t *pResponse, sipMethod_t *pMethod)
             return (-1);
         }
         *pMethod = sipCseq->method;
-        cpr_free(sipCseq);
     } else {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, "sippmh_get_response_line()");
@@ -3879,7 +3866,7 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
     char         *replaceshdr = NULL;
 
     const char   *request_cseq = NULL;
-    sipCseq_t    *request_cseq_structure = NULL;
+    const sipCseq_t *request_cseq_structure = NULL;
     uint32_t      request_cseq_number = 0;
     sipMethod_t   request_cseq_method = sipMethodInvalid;
     sipReqLine_t *requestURI;
@@ -3980,7 +3967,7 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
         return (SIP_MESSAGING_ERROR);
     }
 
-    request_cseq_structure = sippmh_parse_cseq(request_cseq);
+    request_cseq_structure = sippmh_get_parsed_cseq(request);
     if (!request_cseq_structure) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, "sippmh_parse_cseq()");
@@ -3988,7 +3975,6 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
     }
     request_cseq_number = request_cseq_structure->number;
     request_cseq_method = request_cseq_structure->method;
-    cpr_free(request_cseq_structure);
 
     // Check continuity of this request wrt CSeq number and method
     if (request_cseq_method != sipMethodAck &&
@@ -4063,10 +4049,10 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
         static sipRelDevMessageRecord_t requestRecord;
         int            handle = -1;
         const char    *reldev_to = NULL;
-        sipLocation_t *reldev_to_loc = NULL;
+        const sipLocation_t *reldev_to_loc = NULL;
         char           reldev_to_tag[MAX_SIP_TAG_LENGTH];
         const char    *reldev_from = NULL;
-        sipLocation_t *reldev_from_loc = NULL;
+        const sipLocation_t *reldev_from_loc = NULL;
         char           reldev_from_tag[MAX_SIP_TAG_LENGTH];
 
         memset(&requestRecord, 0, sizeof(requestRecord));
@@ -4077,12 +4063,11 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
         reldev_to = sippmh_get_cached_header_val(request, TO);
 
         if (reldev_to) {
-            reldev_to_loc = sippmh_parse_from_or_to((char *)reldev_to, TRUE);
+            reldev_to_loc = sippmh_get_parsed_to(request);
             if (reldev_to_loc) {
                 if (reldev_to_loc->genUrl->schema != URL_TYPE_SIP) {
                     CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_URL_ERROR),
                                       fname);
-                    sippmh_free_location(reldev_to_loc);
                     return (SIP_CLI_ERR_FORBIDDEN);
                 }
 
@@ -4094,7 +4079,6 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
                 sstrncpy(requestRecord.to_user,
                          reldev_to_loc->genUrl->u.sipUrl->user,
                          RELDEV_MAX_USER_NAME_LEN);
-                sippmh_free_location(reldev_to_loc);
 
             } else {
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
@@ -4111,7 +4095,7 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
         /* Store from_user and from_host */
         reldev_from = sippmh_get_cached_header_val(request, FROM);
         if (reldev_from) {
-            reldev_from_loc = sippmh_parse_from_or_to((char *)reldev_from, TRUE);
+            reldev_from_loc = sippmh_get_parsed_from(request);
             if (reldev_from_loc) {
                 sstrncpy(requestRecord.from_user,
                          reldev_from_loc->genUrl->u.sipUrl->user,
@@ -4124,7 +4108,6 @@ sipSPICheckRequest (ccsipCCB_t *ccb, sipMessage_t *request)
                              sip_sm_purify_tag(reldev_from_loc->tag),
                              MAX_SIP_TAG_LENGTH);
                 }
-                sippmh_free_location(reldev_from_loc);
             }
         }
 
@@ -4265,7 +4248,7 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
     const char    *to = NULL;
     const char    *callID = NULL;
     const char    *cseq = NULL;
-    sipCseq_t     *sipCseq = NULL;
+    const sipCseq_t *sipCseq = NULL;
     sipRespLine_t *pRespLine = NULL;
     uint32_t       response_cseq_number = 0;
     sipMethod_t    response_method = sipMethodInvalid;
@@ -4340,7 +4323,7 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
     /*
      * Extract response method and Cseq number from CSeq
      */
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(response);
     if (!sipCseq) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname, "sippmh_parse_cseq()");
@@ -4348,7 +4331,6 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
     }
     response_method      = sipCseq->method;
     response_cseq_number = sipCseq->number;
-    cpr_free(sipCseq);
 
     /*
      * If its a authentication response should not do any response
@@ -4387,15 +4369,15 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
          */
         static sipRelDevMessageRecord_t responseRecord;
         int handle = -1;
-        sipLocation_t *reldev_to_loc = NULL;
+        const sipLocation_t *reldev_to_loc = NULL;
         char reldev_to_tag[MAX_SIP_TAG_LENGTH];
-        sipLocation_t *reldev_from_loc = NULL;
+        const sipLocation_t *reldev_from_loc = NULL;
 
         memset(&responseRecord, 0, sizeof(responseRecord));
         memset(reldev_to_tag, 0, MAX_SIP_TAG_LENGTH);
 
         /* Get to_tag */
-        reldev_to_loc = sippmh_parse_from_or_to((char *)to, TRUE);
+        reldev_to_loc = sippmh_get_parsed_to(response);
         if (reldev_to_loc) {
             if (reldev_to_loc->tag) {
                 sstrncpy(reldev_to_tag,
@@ -4407,7 +4389,6 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
             sstrncpy(responseRecord.to_user,
                      reldev_to_loc->genUrl->u.sipUrl->user,
                      RELDEV_MAX_USER_NAME_LEN);
-            sippmh_free_location(reldev_to_loc);
         } else {
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                               fname,
@@ -4415,7 +4396,7 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
             return (SIP_MESSAGING_ERROR);
         }
 
-        reldev_from_loc = sippmh_parse_from_or_to((char *)from, TRUE);
+        reldev_from_loc = sippmh_get_parsed_from(response);
         if (reldev_from_loc) {
             sstrncpy(responseRecord.from_user,
                      reldev_from_loc->genUrl->u.sipUrl->user,
@@ -4428,7 +4409,6 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
             if (reldev_from_loc->tag) {
                 if (!(ccb->flags & INCOMING)) {
                     if (strcmp(reldev_from_loc->tag, ccb->sip_from_tag) != 0) {
-                        sippmh_free_location(reldev_from_loc);
                         CCSIP_DEBUG_ERROR("%s: Outgoing: From tag in response "
                                           "does not match stored value\n",
                                           fname);
@@ -4436,7 +4416,6 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
                     }
                 } else {
                     if (strcmp(reldev_from_loc->tag, ccb->sip_to_tag) != 0) {
-                        sippmh_free_location(reldev_from_loc);
                         CCSIP_DEBUG_ERROR("%s: Incoming: From tag in response "
                                           "does not match stored value\n",
                                           fname);
@@ -4445,7 +4424,6 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
                 }
             }
 
-            sippmh_free_location(reldev_from_loc);
         } else {
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                               fname,
@@ -4520,7 +4498,7 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
          */
         if (response_method == sipMethodInvite) {
             const char *resp_via = NULL;
-            sipVia_t *resp_via_parm = NULL;
+            const sipVia_t *resp_via_parm = NULL;
             int16_t trx_index_temp = -1;
             const char *sip_via_branch = NULL;
 
@@ -4580,7 +4558,7 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
                  */
                 resp_via = sippmh_get_cached_header_val(response, VIA);
                 if (resp_via) {
-                    resp_via_parm = sippmh_parse_via(resp_via);
+                    resp_via_parm = sippmh_get_parsed_via(response);
                     if (resp_via_parm) {
                         /* check for branch param match for transaction */
                         if ((resp_via_parm->branch_param) &&
@@ -4600,12 +4578,10 @@ sipSPICheckResponse (ccsipCCB_t *ccb, sipMessage_t *response)
                                             resp_via_parm->branch_param,
                                             // (char *) ccb->sip_via_branch);
                                             sip_via_branch);
-                                    sippmh_free_via(resp_via_parm);
                                     return (SIP_MESSAGING_ERROR_STALE_RESP);
                                 }
                             }
                         }
-                        sippmh_free_via(resp_via_parm);
                     }
                 }
                 sipSPISendFailureResponseAck(ccb, response, FALSE, 0xFF);
@@ -5153,14 +5129,14 @@ sipGetMessageCSeq (sipMessage_t *pMessage,
                    sipMethod_t *pResultCSeqMethod)
 {
     const char *cseq = NULL;
-    sipCseq_t  *sipCseq = NULL;
+    const sipCseq_t *sipCseq = NULL;
 
     cseq = sippmh_get_cached_header_val(pMessage, CSEQ);
     if (!cseq) {
         return (-1);
     }
 
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(pMessage);
     if (!sipCseq) {
         return (-1);
     }
@@ -5168,7 +5144,6 @@ sipGetMessageCSeq (sipMessage_t *pMessage,
     *pResultCSeqNumber = sipCseq->number;
     *pResultCSeqMethod = sipCseq->method;
 
-    cpr_free(sipCseq);
     return (0);
 }
 
@@ -5178,7 +5153,7 @@ sipGetMessageToTag (sipMessage_t *pMessage, char *to_tag,
                     int to_tag_max_length)
 {
     const char    *to = NULL;
-    sipLocation_t *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
 
     memset(to_tag, 0, to_tag_max_length);
     //For self generated methods (i.e. outgoing), the TO HEADER
@@ -5189,13 +5164,12 @@ sipGetMessageToTag (sipMessage_t *pMessage, char *to_tag,
     }
 
     if (to) {
-        to_loc = sippmh_parse_from_or_to((char *)to, TRUE);
+        to_loc = sippmh_get_parsed_to(pMessage);
         if (to_loc) {
             if (to_loc->tag) {
                 sstrncpy(to_tag, sip_sm_purify_tag(to_loc->tag),
                          to_tag_max_length);
             }
-            sippmh_free_location(to_loc);
         }
     }
 
@@ -5552,7 +5526,7 @@ sipSPISendByeAuth (sipMessage_t *pResponse,
     }
 
     /* Send message */
-    config_get_value(CFGID_TIMER_T1, &timeout, sizeof(timeout));
+    timeout = config_get_int(CFGID_TIMER_T1);
     ccb->retx_counter = 0;
     if (sipTransportChannelCreateSend(ccb, request, sipMethodBye,
                                       &request_uri_addr,
@@ -6646,7 +6620,7 @@ SendRequest (ccsipCCB_t *ccb, sipMessage_t *request, sipMethod_t method,
             cc_remote_ipaddr = ccb->reg.addr;
             cc_remote_port = ccb->reg.port;
         }
-        config_get_value(CFGID_TIMER_T1, &timeout, sizeof(timeout));
+        timeout = config_get_int(CFGID_TIMER_T1);
         isRegister = TRUE;
 
     } else if ((sipMethodInvite == method) && (midcall == FALSE)) {
@@ -6664,7 +6638,7 @@ SendRequest (ccsipCCB_t *ccb, sipMessage_t *request, sipMethod_t method,
 
         /* Enable reTx and send */
         if (TRUE == reTx) {
-            config_get_value(CFGID_TIMER_T1, &timeout, sizeof(timeout));
+            timeout = config_get_int(CFGID_TIMER_T1);
         }
         cc_remote_ipaddr = ccb->dest_sip_addr;
         cc_remote_port = (uint16_t) ccb->dest_sip_port;
@@ -6745,7 +6719,7 @@ SendRequest (ccsipCCB_t *ccb, sipMessage_t *request, sipMethod_t method,
             cc_remote_port = (uint16_t) ccb->dest_sip_port;
         }
         if (TRUE == reTx)
-            config_get_value(CFGID_TIMER_T1, &timeout, sizeof(timeout));
+            timeout = config_get_int(CFGID_TIMER_T1);
     }
 
     if (util_check_if_ip_valid(&cc_remote_ipaddr) == FALSE) {
@@ -6964,7 +6938,7 @@ sendResponse (ccsipCCB_t *ccb,
     cpr_free(request_cseq_structure);
     /* Enable reTx and send */
     if (retx) {
-        config_get_value(CFGID_TIMER_T1, &timeout, sizeof(timeout));
+        timeout = config_get_int(CFGID_TIMER_T1);
         if (ccb) {
             ccb->retx_counter = 0;
         }
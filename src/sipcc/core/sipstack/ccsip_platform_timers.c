@@ -49,6 +49,7 @@
 #include "ccsip_register.h"
 #include "ccsip_core.h"
 #include "ccsip_subsmanager.h"
+#include "cc_capacity.h"
 
 /*
  * Constants
@@ -56,22 +57,62 @@
 
 /*
  * Globals TODO: hang off of a single SIP global
+ *
+ * The per ccb and per scb timer tables hold MAX_CCBS, MAX_TEL_LINES and
+ * MAX_SCBS entries and are allocated by sip_platform_timers_alloc().
  */
-sipPlatformUITimer_t sipPlatformUISMTimers[MAX_CCBS];
-sipPlatformUIExpiresTimer_t sipPlatformUISMExpiresTimers[MAX_CCBS];
-sipPlatformUIExpiresTimer_t sipPlatformUISMRegExpiresTimers[MAX_CCBS];
-sipPlatformUIExpiresTimer_t sipPlatformUISMLocalExpiresTimers[MAX_CCBS];
+sipPlatformUITimer_t *sipPlatformUISMTimers = NULL;
+sipPlatformUIExpiresTimer_t *sipPlatformUISMExpiresTimers = NULL;
+sipPlatformUIExpiresTimer_t *sipPlatformUISMRegExpiresTimers = NULL;
+sipPlatformUIExpiresTimer_t *sipPlatformUISMLocalExpiresTimers = NULL;
 // This timer will kick in after 1xx in releasing state so if 2xx gets lost
 // we will be able to kill the ccb
-sipPlatformSupervisionTimer_t sipPlatformSupervisionTimers[MAX_TEL_LINES];
+sipPlatformSupervisionTimer_t *sipPlatformSupervisionTimers = NULL;
 
-sipPlatformUITimer_t sipPlatformUISMSubNotTimers[MAX_SCBS];
+sipPlatformUITimer_t *sipPlatformUISMSubNotTimers = NULL;
 sipPlatformSupervisionTimer_t sipPlatformSubNotPeriodicTimer;
 static cprTimer_t sipPlatformRegAllFailedTimer;
 static cprTimer_t sipPlatformNotifyTimer;
 static cprTimer_t sipPlatformStandbyKeepaliveTimer;
 static cprTimer_t sipPlatformUnRegistrationTimer;
 static cprTimer_t sipPassThroughTimer;
+
+/*
+ * Allocates the timer tables sized from the call capacity.
+ */
+int
+sip_platform_timers_alloc (void)
+{
+    if (sipPlatformUISMTimers != NULL) {
+        return SIP_OK;
+    }
+    sipPlatformUISMTimers = (sipPlatformUITimer_t *)
+        cc_capacity_table_alloc("sip msg timers", MAX_CCBS,
+                                sizeof(sipPlatformUITimer_t));
+    sipPlatformUISMExpiresTimers = (sipPlatformUIExpiresTimer_t *)
+        cc_capacity_table_alloc("sip expires timers", MAX_CCBS,
+                                sizeof(sipPlatformUIExpiresTimer_t));
+    sipPlatformUISMRegExpiresTimers = (sipPlatformUIExpiresTimer_t *)
+        cc_capacity_table_alloc("sip reg expires timers", MAX_CCBS,
+                                sizeof(sipPlatformUIExpiresTimer_t));
+    sipPlatformUISMLocalExpiresTimers = (sipPlatformUIExpiresTimer_t *)
+        cc_capacity_table_alloc("sip local expires timers", MAX_CCBS,
+                                sizeof(sipPlatformUIExpiresTimer_t));
+    sipPlatformSupervisionTimers = (sipPlatformSupervisionTimer_t *)
+        cc_capacity_table_alloc("sip supervision timers", MAX_TEL_LINES,
+                                sizeof(sipPlatformSupervisionTimer_t));
+    sipPlatformUISMSubNotTimers = (sipPlatformUITimer_t *)
+        cc_capacity_table_alloc("sip subnot timers", MAX_SCBS,
+                                sizeof(sipPlatformUITimer_t));
+
+    if (!sipPlatformUISMTimers || !sipPlatformUISMExpiresTimers ||
+        !sipPlatformUISMRegExpiresTimers || !sipPlatformUISMLocalExpiresTimers ||
+        !sipPlatformSupervisionTimers || !sipPlatformUISMSubNotTimers) {
+        return SIP_ERROR;
+    }
+    return SIP_OK;
+}
+
 int
 sip_platform_timers_init (void)
 {
@@ -355,31 +396,34 @@ sip_platform_msg_timer_start (uint32_t msec,
     }
 
     /* stop the timer if it is running */
-    if (cprCancelTimer(sipPlatformUISMTimers[idx].timer) == CPR_FAILURE) {
-        CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
-                          idx, 0, fname, "cprCancelTimer");
-        return SIP_ERROR;
-    }
-    if (cprCancelTimer(sipPlatformUISMTimers[idx].reg_timer) == CPR_FAILURE) {
-        CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
-                          idx, 0, fname, "cprCancelTimer");
-        return SIP_ERROR;
+    if (sipPlatformUISMTimers[idx].outstanding) {
+        if (cprCancelTimer(sipPlatformUISMTimers[idx].timer) == CPR_FAILURE) {
+            CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
+                              idx, 0, fname, "cprCancelTimer");
+            return SIP_ERROR;
+        }
+        if (cprCancelTimer(sipPlatformUISMTimers[idx].reg_timer) == CPR_FAILURE) {
+            CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
+                              idx, 0, fname, "cprCancelTimer");
+            return SIP_ERROR;
+        }
     }
 
+    /*
+     * The slot buffer holds the largest message and is kept for the life
+     * of the slot. A retransmission restarts the timer with the slot's
+     * own buffer, which is then already in place.
+     */
     if (sipPlatformUISMTimers[idx].message_buffer == NULL) {
-        sipPlatformUISMTimers[idx].message_buffer = (char *)cpr_malloc(message_buffer_len+1);
+        sipPlatformUISMTimers[idx].message_buffer = (char *)cpr_malloc(SIP_UDP_MESSAGE_SIZE);
         if (sipPlatformUISMTimers[idx].message_buffer == NULL) return SIP_ERROR;
     }
-    else if (message_buffer != sipPlatformUISMTimers[idx].message_buffer) {
-        cpr_free(sipPlatformUISMTimers[idx].message_buffer);
-        sipPlatformUISMTimers[idx].message_buffer = (char *)cpr_malloc(message_buffer_len+1);
-        if (sipPlatformUISMTimers[idx].message_buffer == NULL) return SIP_ERROR;
+    if (message_buffer != sipPlatformUISMTimers[idx].message_buffer) {
+        memcpy(sipPlatformUISMTimers[idx].message_buffer, message_buffer,
+               message_buffer_len);
     }
-
     sipPlatformUISMTimers[idx].message_buffer_len = message_buffer_len;
     sipPlatformUISMTimers[idx].message_buffer[message_buffer_len] = '\0';
-    memcpy(sipPlatformUISMTimers[idx].message_buffer, message_buffer,
-           message_buffer_len);
     sipPlatformUISMTimers[idx].message_type = (sipMethod_t) message_type;
     sipPlatformUISMTimers[idx].ipaddr = *ipaddr;
     sipPlatformUISMTimers[idx].port = port;
@@ -394,8 +438,6 @@ sip_platform_msg_timer_start (uint32_t msec,
     if (cprStartTimer(timer, msec, data) == CPR_FAILURE) {
         CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
                           idx, 0, fname, "cprStartTimer");
-        cpr_free(sipPlatformUISMTimers[idx].message_buffer);
-        sipPlatformUISMTimers[idx].message_buffer = NULL;
         sipPlatformUISMTimers[idx].message_buffer_len = 0;
         return SIP_ERROR;
     }
@@ -415,6 +457,10 @@ sip_platform_msg_timer_stop (int idx)
         return;
     }
 
+    /* neither timer can be running unless the slot is outstanding */
+    if (!sipPlatformUISMTimers[idx].outstanding) {
+        return;
+    }
     if ((cprCancelTimer(sipPlatformUISMTimers[idx].timer) == CPR_FAILURE) ||
         (cprCancelTimer(sipPlatformUISMTimers[idx].reg_timer) == CPR_FAILURE)) {
         CCSIP_DEBUG_STATE(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
@@ -54,6 +54,7 @@
 #include "cpr_memory.h"
 #include "ccsip_pmh.h"
 #include "phone_debug.h"
+#include "debug.h"
 #include "ccapi.h"
 #include "text_strings.h"
 #include "util_string.h"
@@ -2554,6 +2555,163 @@ sippmh_parse_cseq (const char *cseq)
     return (sipCseq);
 }
 
+/*
+ * Parse cache. The structured headers read on every request are parsed
+ * at most once per message: the first sippmh_get_parsed_*() call parses
+ * the cached header value into msg->parsed[] and later calls, from any
+ * function along the processing path, get the same object back.
+ */
+typedef enum {
+    PARSED_FROM,
+    PARSED_TO,
+    PARSED_VIA,
+    PARSED_CSEQ,
+    PARSED_CONTACT,
+    PARSED_MAX
+} sippmh_parsed_e;
+
+static const char *parsed_names[PARSED_MAX] = {
+    "From", "To", "Via", "CSeq", "Contact"
+};
+
+static uint32_t parse_cache_hits[PARSED_MAX];
+static uint32_t parse_cache_misses[PARSED_MAX];
+
+static void
+sippmh_parsed_free_location (void *obj)
+{
+    sippmh_free_location((sipLocation_t *) obj);
+}
+
+static void
+sippmh_parsed_free_via (void *obj)
+{
+    sippmh_free_via((sipVia_t *) obj);
+}
+
+static void
+sippmh_parsed_free_cseq (void *obj)
+{
+    cpr_free(obj);
+}
+
+static void
+sippmh_parsed_free_contact (void *obj)
+{
+    sippmh_free_contact((sipContact_t *) obj);
+}
+
+static void *
+sippmh_get_parsed (sipMessage_t *msg, sippmh_parsed_e which)
+{
+    httpish_parsed_t *slot;
+    const char       *val;
+
+    if (!msg) {
+        return (NULL);
+    }
+
+    slot = &msg->parsed[which];
+    if (slot->done) {
+        parse_cache_hits[which]++;
+        return (slot->obj);
+    }
+    parse_cache_misses[which]++;
+
+    slot->obj = NULL;
+    slot->free_fn = NULL;
+    slot->done = TRUE;
+
+    switch (which) {
+    case PARSED_FROM:
+    case PARSED_TO:
+        val = sippmh_get_cached_header_val(msg, (which == PARSED_FROM) ?
+                                           FROM : TO);
+        if (val) {
+            slot->obj = sippmh_parse_from_or_to((char *) val, TRUE);
+            slot->free_fn = sippmh_parsed_free_location;
+        }
+        break;
+    case PARSED_VIA:
+        val = sippmh_get_cached_header_val(msg, VIA);
+        if (val) {
+            slot->obj = sippmh_parse_via(val);
+            slot->free_fn = sippmh_parsed_free_via;
+        }
+        break;
+    case PARSED_CSEQ:
+        val = sippmh_get_cached_header_val(msg, CSEQ);
+        if (val) {
+            slot->obj = sippmh_parse_cseq(val);
+            slot->free_fn = sippmh_parsed_free_cseq;
+        }
+        break;
+    case PARSED_CONTACT:
+        val = sippmh_get_cached_header_val(msg, CONTACT);
+        if (val) {
+            slot->obj = sippmh_parse_contact(val);
+            slot->free_fn = sippmh_parsed_free_contact;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return (slot->obj);
+}
+
+const sipLocation_t *
+sippmh_get_parsed_from (sipMessage_t *msg)
+{
+    return ((const sipLocation_t *) sippmh_get_parsed(msg, PARSED_FROM));
+}
+
+const sipLocation_t *
+sippmh_get_parsed_to (sipMessage_t *msg)
+{
+    return ((const sipLocation_t *) sippmh_get_parsed(msg, PARSED_TO));
+}
+
+const sipVia_t *
+sippmh_get_parsed_via (sipMessage_t *msg)
+{
+    return ((const sipVia_t *) sippmh_get_parsed(msg, PARSED_VIA));
+}
+
+const sipCseq_t *
+sippmh_get_parsed_cseq (sipMessage_t *msg)
+{
+    return ((const sipCseq_t *) sippmh_get_parsed(msg, PARSED_CSEQ));
+}
+
+const sipContact_t *
+sippmh_get_parsed_contact (sipMessage_t *msg)
+{
+    return ((const sipContact_t *) sippmh_get_parsed(msg, PARSED_CONTACT));
+}
+
+/*
+ *  Function: show_sip_parse_cache_cmd()
+ *
+ *  Description: "show sip-parse-cache" callback. A hit is a parse
+ *               and its malloc/free pair that did not happen.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_sip_parse_cache_cmd (cc_int32_t argc, const char *argv[])
+{
+    int i;
+
+    debugif_printf("------ SIP Header Parse Cache ------\n");
+    debugif_printf("%-8s %10s %10s\n", "Header", "Parsed", "Hits");
+    for (i = 0; i < PARSED_MAX; i++) {
+        debugif_printf("%-8s %10u %10u\n", parsed_names[i],
+                       parse_cache_misses[i], parse_cache_hits[i]);
+    }
+    return (0);
+}
+
 sipRet_t
 sippmh_add_cseq (sipMessage_t *msg, const char *method, uint32_t seq_no)
 {
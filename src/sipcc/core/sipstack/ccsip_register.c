@@ -73,7 +73,7 @@
 #include "ccsip_common_cb.h"
 #include "misc_util.h"
 
-extern sipPlatformUITimer_t sipPlatformUISMTimers[];
+extern sipPlatformUITimer_t *sipPlatformUISMTimers;
 extern void *new_standby_available;
 extern boolean regall_fail_attempt;
 extern boolean registration_reject;
@@ -785,7 +785,7 @@ ccsip_handle_ev_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
     static const char fname[] = "ccsip_handle_ev_2xx";
     sipMessage_t   *response = event->u.pSipMessage;
     const char     *pViaHeaderStr = NULL;
-    sipVia_t       *via = NULL;
+    const sipVia_t *via = NULL;
     uint32_t        exp_time;
     //uint32_t        line_feature;
     int             dns_err_code;
@@ -956,7 +956,7 @@ ccsip_handle_ev_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
     if (nat_enable == 1 && nat_rx_proc_enable == 1) {
         pViaHeaderStr = sippmh_get_cached_header_val(response, VIA);
         if (pViaHeaderStr != NULL) {
-            via = sippmh_parse_via(pViaHeaderStr);
+            via = sippmh_get_parsed_via(response);
             if (via != NULL) {
                 if (via->recd_host != NULL) {
                     cpr_ip_addr_t received_ip;
@@ -996,9 +996,6 @@ ccsip_handle_ev_2xx (ccsipCCB_t *ccb, sipSMEvent_t *event)
                         }
                     }
                 }
-
-                // Cleanup memory
-                sippmh_free_via(via);
             }
         }
     }
@@ -46,12 +46,28 @@
 #include "ccsip_messaging.h"
 #include "sip_common_transport.h"
 #include "util_string.h"
+#include "cc_capacity.h"
 
 /* Constants */
 #define SIP_RRLIST_LENGTH (MAX_TEL_LINES)
 
 /* Global variables */
-sipRelDevMessageRecord_t gSIPRRList[SIP_RRLIST_LENGTH];
+sipRelDevMessageRecord_t *gSIPRRList = NULL;
+
+
+/*
+ * Allocates the reliable delivery list, one record per call.
+ */
+int
+sipRelDevAllocList (void)
+{
+    if (gSIPRRList == NULL) {
+        gSIPRRList = (sipRelDevMessageRecord_t *)
+            cc_capacity_table_alloc("sip reldev list", SIP_RRLIST_LENGTH,
+                                    sizeof(sipRelDevMessageRecord_t));
+    }
+    return (gSIPRRList != NULL) ? SIP_OK : SIP_ERROR;
+}
 
 
 void
@@ -44,6 +44,7 @@
 #include "cpr_string.h"
 #include "cpr_rand.h"
 #include "ccsip_subsmanager.h"
+#include "ccsip_eventbodies.h"
 #include "util_string.h"
 #include "ccapi.h"
 #include "phone_debug.h"
@@ -64,15 +65,16 @@
 #include "text_strings.h"
 #include "configapp.h"
 #include "kpmlmap.h"
+#include "cc_capacity.h"
 
 /*
  *  Global Variables
  */
-sipSCB_t subsManagerSCBS[MAX_SCBS]; // Array of SCBS
+sipSCB_t *subsManagerSCBS = NULL; // Array of MAX_SCBS SCBS
 sipSubsHistory_t gSubHistory[MAX_SCB_HISTORY];
 sipTimerCallbackFn_t callbackFunctionSubNot = sip_platform_subnot_msg_timer_callback;
 sipTimerCallbackFn_t callbackFunctionPeriodic = sip_platform_subnot_periodic_timer_callback;
-extern sipPlatformUITimer_t sipPlatformUISMSubNotTimers[]; // Array of timers
+extern sipPlatformUITimer_t *sipPlatformUISMSubNotTimers; // Array of timers
 const char kpmlRequestAcceptHeader[]      = SIP_CONTENT_TYPE_KPML_REQUEST;
 const char kpmlResponseAcceptHeader[]     = SIP_CONTENT_TYPE_KPML_RESPONSE;
 const char dialogAcceptHeader[]           = SIP_CONTENT_TYPE_DIALOG;
@@ -731,6 +733,46 @@ sip_subsManager_shut ()
     return (0);
 }
 
+/********************************************************
+ * Ask the notifiers of our own subscriptions to end them, as
+ * part of a graceful shutdown. Subscriptions tied to a call
+ * end with its BYE and are left alone. The SCBs are freed
+ * later by sip_subsManager_shut().
+ ********************************************************/
+int
+sip_subsManager_unsubscribe_all ()
+{
+    const char *fname = "sip_subsManager_unsubscribe_all";
+    int i;
+    int sent = 0;
+    sipSCB_t *scbp = NULL;
+
+    if (subsManagerRunning == 0) {
+        return (0);
+    }
+    for (i = 0; i < MAX_SCBS; i++) {
+        scbp = &(subsManagerSCBS[i]);
+        if (!scbp->internal || scbp->pendingClean || scbp->gsm_id != 0 ||
+            (scbp->smState != SUBS_STATE_RCVD_NOTIFY &&
+             scbp->smState != SUBS_STATE_ACTIVE)) {
+            continue;
+        }
+        scbp->hb.expires = 0;
+        scbp->hb.authen.cred_type = 0;
+        if (!sipSPISendSubscribe(scbp, TRUE, FALSE /* auth */)) {
+            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"failed to unsubscribe scb=%d"
+                              " sub_id=%x\n", fname, i, scbp->sub_id);
+            continue;
+        }
+        scbp->smState = SUBS_STATE_SENT_SUBSCRIBE_RCVD_NOTIFY;
+        outgoingSubscribes++;
+        sent++;
+    }
+    CCSIP_DEBUG_TASK(DEB_F_PREFIX"Sent %d unSUBSCRIBE requests\n",
+                     DEB_F_PREFIX_ARGS(SIP_SUB, fname), sent);
+    return (sent);
+}
+
 /********************************************************
  * Common code notifying application for a failover/fallback
  * or CCM new registration (reset) event. Send a notification to
@@ -910,6 +952,19 @@ initialize_scb (sipSCB_t *scbp)
     scbp->pendingRequests = NULL;
 }
 
+/*
+ * Allocates the SCB table. Its size follows the configured call capacity.
+ */
+int
+sip_subsManager_alloc_scbs (void)
+{
+    if (subsManagerSCBS == NULL) {
+        subsManagerSCBS = (sipSCB_t *)
+            cc_capacity_table_alloc("sip scbs", MAX_SCBS, sizeof(sipSCB_t));
+    }
+    return (subsManagerSCBS != NULL) ? SIP_OK : SIP_ERROR;
+}
+
 int
 sip_subsManager_init ()
 {
@@ -1471,32 +1526,48 @@ submanager_update_ccb_addr (ccsipCCB_t *ccb)
 
 
 /*
- * Takes care of all the parsing requirements
+ * Takes care of all the parsing requirements. A body with a decoder is
+ * turned into event data; other bodies (remotecc, configapp) have none
+ * and *eventDatapp is left NULL.
  */
 static int
-parse_body (cc_subscriptions_t event_type, char *msgBody, int msgLength,
+parse_body (cc_subscriptions_t event_type, msgBody_t *body,
             ccsip_event_data_t **eventDatapp,
             const char *fname)
 {
     const char     *fname1 = "parse_body";
-    ccsip_event_data_type_e type = EVENT_DATA_INVALID;
+    ccsip_event_data_t *eventData;
 
-    if (!msgBody) {
+    *eventDatapp = NULL;
+    if (!body->msgBody) {
         return SIP_ERROR;
     }
 
-    switch (event_type) {
-        case CC_SUBSCRIPTIONS_KPML:
-            type = EVENT_DATA_KPML_REQUEST;
+    switch (body->msgContentTypeValue) {
+    case SIP_CONTENT_TYPE_DIALOG_VALUE:
+    case SIP_CONTENT_TYPE_PRESENCE_VALUE:
+    case SIP_CONTENT_TYPE_KPML_REQUEST_VALUE:
+    case SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE:
         break;
-        case CC_SUBSCRIPTIONS_CONFIGAPP:
-            type = EVENT_DATA_CONFIGAPP_REQUEST;
-        break;
-        default:
-            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: unknown event type %d\n", fname1, fname, type);
-        return SIP_ERROR;
+    default:
+        return SIP_OK;
     }
 
+    eventData = (ccsip_event_data_t *) cpr_malloc(sizeof(ccsip_event_data_t));
+    if (eventData == NULL) {
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: malloc of eventData failed.\n",
+                          fname1, fname);
+        return SIP_ERROR;
+    }
+    if (!ccsip_decode_event_body(body->msgContentTypeValue, body->msgBody,
+                                 body->msgLength, eventData)) {
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: malformed %s body for event %d\n",
+                          fname1, fname, body->msgContentType ?
+                          body->msgContentType : "", event_type);
+        cpr_free(eventData);
+        return SIP_ERROR;
+    }
+    *eventDatapp = eventData;
     return SIP_OK;
 }
 
@@ -1505,32 +1576,20 @@ add_content (ccsip_event_data_t *eventData, sipMessage_t *request, const char *f
 {
     const char     *fname1 = "add_content";
     uint32_t        len;
-    char           *eventBody = NULL;
+    char           *eventBody;
+    const char     *content_type;
 
     while (eventData) {
-        len = strlen(eventBody);
-
-        switch (eventData->type) {
-        case EVENT_DATA_RAW:
-            // Assume body is of type CMXML for now
-            (void) sippmh_add_message_body(request, eventBody, len,
-                                           SIP_CONTENT_TYPE_CMXML,
-                                           SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
-            break;
-        case EVENT_DATA_KPML_REQUEST:
-            (void) sippmh_add_message_body(request, eventBody, len,
-                                           SIP_CONTENT_TYPE_KPML_REQUEST,
-                                           SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
-            break;
-        case EVENT_DATA_KPML_RESPONSE:
-            (void) sippmh_add_message_body(request, eventBody, len,
-                                           SIP_CONTENT_TYPE_KPML_RESPONSE,
-                                           SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
-            break;
-        default:
-            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: Data type not supported\n", fname1, fname);
+        eventBody = ccsip_encode_event_body(eventData, &len, &content_type);
+        if (eventBody == NULL) {
+            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: Data type %d not supported\n",
+                              fname1, fname, eventData->type);
+        } else if (sippmh_add_message_body(request, eventBody, len, content_type,
+                                           SIP_CONTENT_DISPOSITION_SESSION_VALUE,
+                                           TRUE, NULL) != HSTATUS_SUCCESS) {
+            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s: failed to add %s body\n",
+                              fname1, fname, content_type);
             cpr_free(eventBody);
-            break;
         }
 
         eventData = eventData->next;
@@ -2335,7 +2394,7 @@ subsmanager_handle_ev_sip_response (sipMessage_t *pSipMessage)
     long            expiry_time;
     const char     *to = NULL, *from = NULL;
     const char     *record_route = NULL;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
     sipCseq_t      *resp_cseq_structure = NULL;
     uint32_t        cseq;
 
@@ -2473,13 +2532,12 @@ subsmanager_handle_ev_sip_response (sipMessage_t *pSipMessage)
         from = sippmh_get_cached_header_val(pSipMessage, FROM);
         scbp->sip_to = strlib_update(scbp->sip_to, to);
         // grab the to-tag if present, and if this is a response to a SUBSCRIBE
-        to_loc = sippmh_parse_from_or_to((char *) to, TRUE);
+        to_loc = sippmh_get_parsed_to(pSipMessage);
         if (to_loc != NULL) {
             if (to_loc->tag != NULL) {
                 scbp->sip_to_tag = strlib_update(scbp->sip_to_tag,
                                                  sip_sm_purify_tag(to_loc->tag));
             }
-            sippmh_free_location(to_loc);
         }
         scbp->sip_from = strlib_update(scbp->sip_from, from);
     }
@@ -2584,8 +2642,8 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
     genUrl_t       *genUrl = NULL;
     const char     *sip_from = NULL;
     const char     *sip_to = NULL;
-    sipLocation_t  *to_loc = NULL;
-    sipLocation_t  *from_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
+    const sipLocation_t *from_loc = NULL;
     sipUrl_t       *sipUriUrl = NULL, *sipFromUrl = NULL;
     char           *pUser = NULL;
     char           *sip_to_tag_temp, *sip_to_temp;
@@ -2756,7 +2814,7 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
 
     // Parse From
     sip_from = sippmh_get_cached_header_val(pSipMessage, FROM);
-    from_loc = sippmh_parse_from_or_to((char *) sip_from, TRUE);
+    from_loc = sippmh_get_parsed_from(pSipMessage);
     if (!from_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname,
@@ -2773,7 +2831,7 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
     }
     // Parse To
     sip_to = sippmh_get_cached_header_val(pSipMessage, TO);
-    to_loc = sippmh_parse_from_or_to((char *) sip_to, TRUE);
+    to_loc = sippmh_get_parsed_to(pSipMessage);
     if (!to_loc) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
                           fname,
@@ -2786,7 +2844,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
             CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                               fname, SIP_CLI_ERR_BAD_REQ);
         }
-        sippmh_free_location(from_loc);
         return SIP_ERROR;
     }
     // Parse Req-URI
@@ -2810,10 +2867,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
     }
     if (request_uri_error) {
         CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Invalid Request URI" "failed.\n", fname);
-        if (to_loc)
-            sippmh_free_location(to_loc);
-        if (from_loc)
-            sippmh_free_location(from_loc);
         if (genUrl)
             sippmh_genurl_free(genUrl);
         if (requestURI)
@@ -2854,8 +2907,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_BAD_REQ);
             }
-            sippmh_free_location(to_loc);
-            sippmh_free_location(from_loc);
             sippmh_genurl_free(genUrl);
             SIPPMH_FREE_REQUEST_LINE(requestURI);
             return SIP_ERROR;
@@ -2873,15 +2924,11 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_SERV_ERR_INTERNAL);
             }
-            sippmh_free_location(to_loc);
-            sippmh_free_location(from_loc);
             sippmh_genurl_free(genUrl);
             SIPPMH_FREE_REQUEST_LINE(requestURI);
             return SIP_ERROR;
         }
 
-        sippmh_free_location(to_loc);
-        sippmh_free_location(from_loc);
         sippmh_genurl_free(genUrl);
         SIPPMH_FREE_REQUEST_LINE(requestURI);
     } else {
@@ -2902,8 +2949,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_CALLEG);
             }
-            sippmh_free_location(to_loc);
-            sippmh_free_location(from_loc);
             sippmh_genurl_free(genUrl);
             SIPPMH_FREE_REQUEST_LINE(requestURI);
             return SIP_ERROR;
@@ -2919,8 +2964,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_BAD_EVENT);
             }
-            sippmh_free_location(to_loc);
-            sippmh_free_location(from_loc);
             sippmh_genurl_free(genUrl);
             SIPPMH_FREE_REQUEST_LINE(requestURI);
             return SIP_ERROR;
@@ -2936,8 +2979,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_BAD_REQ);
             }
-            sippmh_free_location(to_loc);
-            sippmh_free_location(from_loc);
             sippmh_genurl_free(genUrl);
             SIPPMH_FREE_REQUEST_LINE(requestURI);
             show_scbs_inuse();
@@ -3009,8 +3050,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                        fname, SIP_CLI_ERR_BAD_REQ);
              }
              free_scb(scb_index, fname);
-             sippmh_free_location(to_loc);
-             sippmh_free_location(from_loc);
              sippmh_genurl_free(genUrl);
              SIPPMH_FREE_REQUEST_LINE(requestURI);
              return SIP_ERROR;
@@ -3038,8 +3077,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                                       fname, SIP_CLI_ERR_INTERVAL_TOO_SMALL);
                 }
                 free_scb(scb_index, fname);
-                sippmh_free_location(to_loc);
-                sippmh_free_location(from_loc);
                 sippmh_genurl_free(genUrl);
                 SIPPMH_FREE_REQUEST_LINE(requestURI);
                 return SIP_ERROR;
@@ -3063,8 +3100,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
                 CCSIP_DEBUG_TASK(DEB_F_PREFIX"Freeing SCB: scb=%d sub_id=%x\n", 
                                  DEB_F_PREFIX_ARGS(SIP_SUB, fname), scb_index, scbp->sub_id);
                 free_scb(scb_index, fname);
-                sippmh_free_location(to_loc);
-                sippmh_free_location(from_loc);
                 sippmh_genurl_free(genUrl);
                 SIPPMH_FREE_REQUEST_LINE(requestURI);
                 return SIP_ERROR;
@@ -3151,9 +3186,6 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
             scbp->sip_to = strlib_close(sip_to_temp);
         }
 
-        sippmh_free_location(to_loc);
-        sippmh_free_location(from_loc);
-
         sstrncpy(scbp->hb.sipCallID, callID, MAX_SIP_CALL_ID);
 
         // Parse Contact info
@@ -3363,8 +3395,8 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
             }
 
         } else {
-            result = parse_body(scbp->hb.event_type, pSipMessage->mesg_body[i].msgBody,
-                                pSipMessage->mesg_body[i].msgLength, &subDatap, fname);
+            result = parse_body(scbp->hb.event_type, &pSipMessage->mesg_body[i],
+                                &subDatap, fname);
             if (result == SIP_ERROR) {
                 if (sipSPISendErrorResponse(pSipMessage, SIP_CLI_ERR_BAD_REQ,
                                             SIP_CLI_ERR_BAD_REQ_PHRASE,
@@ -3390,6 +3422,7 @@ subsmanager_handle_ev_sip_subscribe (sipMessage_t *pSipMessage,
             append_event_data(subs_ind_data.u.subs_ind_data.eventData,
                               subDatap);
         }
+        subDatap = NULL;
         i++;
     }
 
@@ -3449,11 +3482,12 @@ decode_message_body (cc_subscriptions_t event_type, sipMessage_t *pSipMessage, c
     // Decode the body, if any
     while (i < HTTPISH_MAX_BODY_PARTS && pSipMessage->mesg_body[i].msgBody
             != NULL) {
-        if (pSipMessage->mesg_body[0].msgContentTypeValue != SIP_CONTENT_TYPE_DIALOG_VALUE &&
-            pSipMessage->mesg_body[0].msgContentTypeValue != SIP_CONTENT_TYPE_KPML_REQUEST_VALUE &&
-            pSipMessage->mesg_body[0].msgContentTypeValue != SIP_CONTENT_TYPE_REMOTECC_REQUEST_VALUE &&
-            pSipMessage->mesg_body[0].msgContentTypeValue != SIP_CONTENT_TYPE_REMOTECC_RESPONSE_VALUE &&
-            pSipMessage->mesg_body[0].msgContentTypeValue != SIP_CONTENT_TYPE_PRESENCE_VALUE) {
+        if (pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_DIALOG_VALUE &&
+            pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_KPML_REQUEST_VALUE &&
+            pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE &&
+            pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_REMOTECC_REQUEST_VALUE &&
+            pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_REMOTECC_RESPONSE_VALUE &&
+            pSipMessage->mesg_body[i].msgContentTypeValue != SIP_CONTENT_TYPE_PRESENCE_VALUE) {
 
             // Body can not be parsed - send it up as it is
             notDatap = (ccsip_event_data_t *) cpr_malloc(sizeof(ccsip_event_data_t));
@@ -3463,29 +3497,32 @@ decode_message_body (cc_subscriptions_t event_type, sipMessage_t *pSipMessage, c
                 return FALSE;
             }
 
-            notDatap->u.raw_data.data = pSipMessage->mesg_body[0].msgBody;
-            notDatap->u.raw_data.length = pSipMessage->mesg_body[0].msgLength;
-            pSipMessage->mesg_body[0].msgBody = NULL;
-            pSipMessage->mesg_body[0].msgLength = 0;
+            notDatap->u.raw_data.data = pSipMessage->mesg_body[i].msgBody;
+            notDatap->u.raw_data.length = pSipMessage->mesg_body[i].msgLength;
+            pSipMessage->mesg_body[i].msgBody = NULL;
+            pSipMessage->mesg_body[i].msgLength = 0;
             notDatap->type = EVENT_DATA_RAW;
             notDatap->next = NULL;
 
         } else {
 
-            result = parse_body(event_type, pSipMessage->mesg_body[i].msgBody,
-                                pSipMessage->mesg_body[i].msgLength, &notDatap, fname);
+            result = parse_body(event_type, &pSipMessage->mesg_body[i],
+                                &notDatap, fname);
             if (result == SIP_ERROR) {
-                free_event_data(notDatap);
                 free_event_data(*dataPP);
+                *dataPP = NULL;
                 return FALSE;
             }
         }
-        if ((*dataPP) == NULL) {
+        if (notDatap == NULL) {
+            // nothing decoded from this part
+        } else if ((*dataPP) == NULL) {
             (*dataPP) = notDatap;
             notDatap->next = NULL;
         } else {
             append_event_data((*dataPP), notDatap);
         }
+        notDatap = NULL;
         i++;
     }
     return TRUE;
@@ -3511,7 +3548,7 @@ subsmanager_handle_ev_sip_subscribe_notify (sipMessage_t *pSipMessage)
     const char     *from = NULL, *to = NULL;
     const char     *subs_state = NULL;
     boolean         subs_header_found = FALSE;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
     const char     *via = NULL;
 
     CCSIP_DEBUG_TASK(DEB_F_PREFIX"Processing a network generated NOTIFY\n", DEB_F_PREFIX_ARGS(SIP_SUB, fname));
@@ -3592,7 +3629,7 @@ subsmanager_handle_ev_sip_subscribe_notify (sipMessage_t *pSipMessage)
              * we have just terminated.
              */
             to = sippmh_get_cached_header_val(pSipMessage, TO);
-            to_loc = sippmh_parse_from_or_to((char *) to, TRUE);
+            to_loc = sippmh_get_parsed_to(pSipMessage);
             if ((to_loc == NULL) || (to_loc->tag == NULL)) {
                 if (eventPackage == CC_SUBSCRIPTIONS_DIALOG) {
                     notify_ind_data.line_id = 1;
@@ -3613,9 +3650,10 @@ subsmanager_handle_ev_sip_subscribe_notify (sipMessage_t *pSipMessage)
                         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                           fname, SIP_STATUS_SUCCESS);
                     }
+                    // No application takes unsolicited dialog NOTIFYs
+                    free_event_data(notify_ind_data.u.notify_ind_data.eventData);
 
                     incomingUnsolicitedNotifies++;
-                    sippmh_free_location(to_loc);
                     return (0);
                 } else if (eventPackage == CC_SUBSCRIPTIONS_PRESENCE) {
                     /* decode the body */
@@ -3638,11 +3676,9 @@ subsmanager_handle_ev_sip_subscribe_notify (sipMessage_t *pSipMessage)
                     }
 
                     incomingUnsolicitedNotifies++;
-                    sippmh_free_location(to_loc);
                     return (0);
                 }
             }
-            sippmh_free_location(to_loc);
             CCSIP_DEBUG_ERROR(SIP_F_PREFIX"No prior subscription", fname);
             if (sipSPISendErrorResponse(pSipMessage, SIP_CLI_ERR_CALLEG,
                                         SIP_CLI_ERR_SUBS_DOES_NOT_EXIST_PHRASE,
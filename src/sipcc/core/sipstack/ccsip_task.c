@@ -62,6 +62,7 @@
 #include "ccsip_register.h"
 #include "debug.h"
 #include "ccsip_reldev.h"
+#include "ccsip_trx.h"
 #include "ccsip_cc.h"
 #include "gsm.h"
 #include "fim.h"
@@ -78,6 +79,8 @@
 #include "sip_interface_regmgr.h"
 #include "ccsip_publish.h"
 #include "platform_api.h"
+#include "cc_latency.h"
+#include "cc_shutdown.h"
 
 #ifdef SAPP_SAPP_GSM
 #define SAPP_APP_GSM 3
@@ -190,7 +193,7 @@ boolean Is794x = FALSE;
  * External Variables
  * TODO reference through proper header files
  */
-extern sipCallHistory_t gCallHistory[];
+extern sipCallHistory_t *gCallHistory;
 
 
 /*---------------------------------------------------------
@@ -334,6 +337,39 @@ SIPTaskInit (void)
 }
 
 
+/*
+ * sip_msg_lane
+ *
+ * SIP timer expirations drive retransmissions and must not wait behind a
+ * burst of subscription traffic, so they take the control lane of the
+ * SIP queue. Everything else keeps the normal lane and its FIFO order.
+ */
+static cpr_msgq_lane_e
+sip_msg_lane (uint32_t cmd)
+{
+    switch (cmd) {
+    case SIP_TMR_REG_ACK:
+    case SIP_TMR_REG_EXPIRE:
+    case SIP_TMR_REG_WAIT:
+    case SIP_TMR_REG_RETRY:
+    case SIP_TMR_REG_STABLE:
+    case SIP_TMR_INV_LOCALEXPIRE:
+    case SIP_TMR_INV_EXPIRE:
+    case SIP_TMR_MSG_RETRY:
+    case SIP_TMR_SUPERVISION_DISCONNECT:
+    case SIP_TMR_CALL_DISCONNECT:
+    case SIP_TMR_MSG_RETRY_SUBNOT:
+    case SIP_TMR_PERIODIC_SUBNOT:
+    case SIP_TMR_GLARE_AVOIDANCE:
+    case SIP_TMR_STANDBY_KEEPALIVE:
+    case SIP_TMR_DM_SHR_WAIT_DM_UPD_EVENT:
+    case SIP_TMR_SHUTDOWN_PHASE2:
+        return CPR_MSGQ_LANE_CONTROL;
+    default:
+        return CPR_MSGQ_LANE_NORMAL;
+    }
+}
+
 /**
  *
  * SIPTaskSendMsg (API)
@@ -360,6 +396,7 @@ SIPTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, void *usr)
     syshdr->Cmd = cmd;
     syshdr->Len = len;
     syshdr->Usr.UsrPtr = usr;
+    cc_latency_stamp(syshdr);
 
     /*
      * If we send a message to the task too soon the sip variable is not set yet.
@@ -368,7 +405,8 @@ SIPTaskSendMsg (uint32_t cmd, void *msg, uint16_t len, void *usr)
      * This can be solved by waiting for an echo roundtrip from Thread before sending
      * any other message. Will do someday.
      */
-    if (cprSendMessage(sip_msgq /*sip.msgQueue */ , (cprBuffer_t)msg, (void **)&syshdr)
+    if (cprSendMessageLane(sip_msgq /*sip.msgQueue */ , (cprBuffer_t)msg,
+                           (void **)&syshdr, sip_msg_lane(cmd))
         == CPR_FAILURE) {
         cprReleaseSysHeader(syshdr);
         return CPR_FAILURE;
@@ -872,7 +910,7 @@ SIPTaskProcessListEvent (uint32_t cmd, void *msg, void *pUsr, uint16_t len)
 
     case SIP_TMR_SHUTDOWN_PHASE2:
         {
-            // Handle shutdown phase 2 event (after unregistration)
+            // Deadline of a shutdown phase waiting for answers
             // Note: boolean is 8 bits, but 32 bits have been allocated for it
             // so we need to dereference msg with 32 bits
             int action;
@@ -887,7 +925,7 @@ SIPTaskProcessListEvent (uint32_t cmd, void *msg, void *pUsr, uint16_t len)
 
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Received SIP_TMR_SHUTDOWN_PHASE2 event action= (%d)\n",
                              DEB_F_PREFIX_ARGS(SIP_EVT, fname),  action);
-            sip_shutdown_phase2(action);
+            sip_shutdown_timer_expired(action);
         }
         break;
 
@@ -1125,6 +1163,7 @@ SIPTaskProcessUDPMessage (cprBuffer_t msg,
 
     /* Process SIP message */
     SIPTaskProcessSIPMessage(pSipMessage);
+    sip_shutdown_check_progress();
     return SIP_OK;
 }
 
@@ -1162,13 +1201,14 @@ SIPTaskProcessTCPMessage (sipMessage_t *pSipMessage, cpr_sockaddr_storage from)
 
     /* Process SIP message */
     SIPTaskProcessSIPMessage(pSipMessage);
+    sip_shutdown_check_progress();
 }
 
 int
 SIPTaskRetransmitPreviousResponse (sipMessage_t *pSipMessage,
                                   const char *fname,
                                   const char *pCallID,
-                                  sipCseq_t *sipCseq,
+                                  const sipCseq_t *sipCseq,
                                   int response_code,
                                   boolean is_request)
 {
@@ -1176,8 +1216,8 @@ SIPTaskRetransmitPreviousResponse (sipMessage_t *pSipMessage,
     int             handle = -1;
     const char     *reldev_to = NULL;
     const char     *reldev_from = NULL;
-    sipLocation_t  *reldev_to_loc = NULL;
-    sipLocation_t  *reldev_from_loc = NULL;
+    const sipLocation_t *reldev_to_loc = NULL;
+    const sipLocation_t *reldev_from_loc = NULL;
 
     pRequestRecord = (sipRelDevMessageRecord_t *)
         cpr_calloc(1, sizeof(sipRelDevMessageRecord_t));
@@ -1190,7 +1230,7 @@ SIPTaskRetransmitPreviousResponse (sipMessage_t *pSipMessage,
     // Copy to-tag
     reldev_to = sippmh_get_cached_header_val(pSipMessage, TO);
     if (reldev_to) {
-        reldev_to_loc = sippmh_parse_from_or_to((char *)reldev_to, TRUE);
+        reldev_to_loc = sippmh_get_parsed_to(pSipMessage);
         if ((reldev_to_loc) && (reldev_to_loc->tag)) {
             sstrncpy(pRequestRecord->tag,
                      sip_sm_purify_tag(reldev_to_loc->tag),
@@ -1202,14 +1242,13 @@ SIPTaskRetransmitPreviousResponse (sipMessage_t *pSipMessage,
             sstrncpy(pRequestRecord->to_user,
                      reldev_to_loc->genUrl->u.sipUrl->user,
                      RELDEV_MAX_USER_NAME_LEN);
-            sippmh_free_location(reldev_to_loc);
         }
     }
 
     // Copy from-user and from-host
     reldev_from = sippmh_get_cached_header_val(pSipMessage, FROM);
     if (reldev_from) {
-        reldev_from_loc = sippmh_parse_from_or_to((char *)reldev_from, TRUE);
+        reldev_from_loc = sippmh_get_parsed_from(pSipMessage);
         if (reldev_from_loc) {
             sstrncpy(pRequestRecord->from_user,
                      reldev_from_loc->genUrl->u.sipUrl->user,
@@ -1217,8 +1256,6 @@ SIPTaskRetransmitPreviousResponse (sipMessage_t *pSipMessage,
             sstrncpy(pRequestRecord->from_host,
                      reldev_from_loc->genUrl->u.sipUrl->host,
                      RELDEV_MAX_HOST_NAME_LEN);
-
-            sippmh_free_location(reldev_from_loc);
         }
     }
 
@@ -1372,6 +1409,10 @@ SIPTaskProcessTimerExpiration (void *msg, uint32_t *cmd)
         sip_regmgr_regallfail_timer_callback(timerMsg->usrData);
         break;
 
+    case SIP_TRX_TIMER:
+        sip_trx_timer_expire(timerMsg->usrData);
+        break;
+
     default:
         err_msg("%s: unknown timer %s\n", fname, timerMsg->expiredTimerName);
         break;
@@ -1406,7 +1447,7 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
     int             requestStatus = SIP_MESSAGING_ERROR;
     char            errortext[MAX_SIP_URL_LENGTH];
     const char     *cseq = NULL;
-    sipCseq_t      *sipCseq = NULL;
+    const sipCseq_t *sipCseq = NULL;
     uint16_t        result_code = 0;
     const char     *max_fwd_hdr = NULL;
     int32_t         max_fwd_hdr_val;
@@ -1548,7 +1589,7 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
         free_sip_message(pSipMessage);
         return;
     }
-    sipCseq = sippmh_parse_cseq(cseq);
+    sipCseq = sippmh_get_parsed_cseq(pSipMessage);
     if (!sipCseq) {
         CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Unable to parse "
                           "CSeq from message.\n", fname);
@@ -1571,7 +1612,39 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
          * Since we have no Call-ID, we can't create a response;
          * therefore, we drop it.
          */
-        cpr_free(sipCseq);
+        free_sip_message(pSipMessage);
+        return;
+    }
+
+    /*
+     * A shutdown in progress may be waiting for this final response.
+     */
+    if (!is_request && code_class != codeClass1xx &&
+        cc_shutdown_tracking_txns()) {
+        switch (sipCseq->method) {
+        case sipMethodRegister:
+            (void) cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_REGISTER,
+                                            pCallID, sipCseq->number);
+            break;
+        case sipMethodBye:
+            (void) cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_BYE,
+                                            pCallID, sipCseq->number);
+            break;
+        case sipMethodSubscribe:
+            (void) cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_UNSUBSCRIBE,
+                                            pCallID, sipCseq->number);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /*
+     * Retransmissions within a non-INVITE transaction are answered or
+     * absorbed by the transaction layer and go no further.
+     */
+    if (is_request ? sip_trx_request_received(pSipMessage) :
+                     sip_trx_response_received(pSipMessage)) {
         free_sip_message(pSipMessage);
         return;
     }
@@ -1588,7 +1661,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 // This Notify is in response to a previous SUBSCRIBE or REFER
                 (void) subsmanager_handle_ev_sip_subscribe_notify(pSipMessage);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -1621,7 +1693,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             }
 
         }
-        cpr_free(sipCseq);
         free_sip_message(pSipMessage);
         return;
     }
@@ -1631,7 +1702,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Recv Subs Response.\n", 
                 DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
             (void) subsmanager_handle_ev_sip_response(pSipMessage);
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
      
@@ -1641,7 +1711,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 CCSIP_DEBUG_TASK(DEB_F_PREFIX"Recv Notify response\n", 
                     DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
                 (void) subsmanager_handle_ev_sip_response(pSipMessage);
-                cpr_free(sipCseq);
                 free_sip_message(pSipMessage);
                 return;
             } else {
@@ -1650,7 +1719,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                     CCSIP_DEBUG_TASK(DEB_F_PREFIX"Recv Unsolicited Notify response\n", 
                         DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
                     (void) subsmanager_handle_ev_sip_unsolicited_notify_response(pSipMessage, tcbp);
-                    cpr_free(sipCseq);
                     free_sip_message(pSipMessage);
                     return;
                 }
@@ -1661,15 +1729,13 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Recv PUBLISH Response.\n", 
                 DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
             (void) publish_handle_ev_sip_response(pSipMessage); 
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
         case sipMethodInfo:
-            // XXX FIXME see the comments in sipSPISendInfo()
+            // the transaction layer has already stopped retransmitting it
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Recv INFO Response (silently dropped).\n", 
                 DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -1718,7 +1784,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                   "bad response. Dropping message.\n", fname);
             }
         }
-        cpr_free(sipCseq);
         free_sip_message(pSipMessage);
         return;
     }
@@ -1744,7 +1809,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
              * options request. pSipMessage will be freed on return.
              */
             sip_cc_options(CC_NO_CALL_ID, CC_NO_LINE, pSipMessage);
-            cpr_free(sipCseq);
             return;
         }
 
@@ -1760,7 +1824,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                 fname, SIP_CLI_ERR_NOT_ALLOWED);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -1783,7 +1846,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                     CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                       fname, SIP_CLI_ERR_NOT_AVAIL);
                 }
-                cpr_free(sipCseq);
                 free_sip_message(pSipMessage);
                 return;
             }
@@ -1796,7 +1858,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             	 */
             	CCSIP_DEBUG_ERROR(DEB_F_PREFIX"gsm msgq depth too large, drop incoming INVITEs!!!\n",
                                      DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname)); 
-                cpr_free(sipCseq);
                 free_sip_message(pSipMessage);
                 return;            
             }
@@ -1817,7 +1878,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                     CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                       fname, SIP_CLI_ERR_BUSY_HERE);
                 }
-                cpr_free(sipCseq);
                 free_sip_message(pSipMessage);
                 return;
             }
@@ -1838,7 +1898,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             if (SipRelDevEnabled) {
                 if (SIPTaskRetransmitPreviousResponse(pSipMessage, fname,
                             pCallID, sipCseq, 0, TRUE) == SIP_OK) {
-                    cpr_free(sipCseq);
                     free_sip_message(pSipMessage);
                     return;
                 }
@@ -1857,7 +1916,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                                0, NULL, NULL);
             }
 
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         } else if (is_previous_call_id && (method == sipMethodAck) &&
@@ -1874,7 +1932,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             }
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Not forwarding response to SIP SM.\n", 
                 DEB_F_PREFIX_ARGS(SIP_FWD, fname));
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         } else if (is_previous_call_id && (!is_request)) {
@@ -1893,7 +1950,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 if (SIPTaskRetransmitPreviousResponse(pSipMessage, fname,
                                                       pCallID, sipCseq,
                                                       response_code, FALSE) == SIP_OK) {
-                    cpr_free(sipCseq);
                     free_sip_message(pSipMessage);
                     return;
                 }
@@ -1911,7 +1967,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                                             response_code,
                                                             previous_call_index);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -1945,7 +2000,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                                           pCallID, sipCseq,
                                                           response_code,
                                                           FALSE) == SIP_OK) {
-                        cpr_free(sipCseq);
                         free_sip_message(pSipMessage);
                         return;
                     }
@@ -1962,7 +2016,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                     }
                 }
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -1980,7 +2033,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
         case SIP_MESSAGING_NEW_CALLID:
             CCSIP_DEBUG_ERROR(SIP_F_PREFIX"sipSPICheckRequest() returned "
                               "SIP_MESSAGING_NEW_CALLID.\n", fname);
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -1994,7 +2046,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                   fname, SIP_CLI_ERR_FORBIDDEN);
             }
 
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -2021,7 +2072,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                                    errortext, 0, NULL, NULL);
                 }
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -2034,7 +2084,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_SERV_ERR_INTERNAL);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -2047,7 +2096,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                 CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_SPI_SEND_ERROR),
                                   fname, SIP_CLI_ERR_BAD_REQ);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
 
@@ -2076,7 +2124,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                     ccb->wait_for_ack = TRUE;
                 }
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -2138,7 +2185,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             CCSIP_DEBUG_TASK(get_debug_string(DEBUG_SIP_MSG_RECV),
                              fname, SIP_METHOD_INFO);
             (void) ccsip_handle_info_package(ccb, pSipMessage);
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
             break;
@@ -2146,7 +2192,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             CCSIP_DEBUG_TASK(DEB_F_PREFIX"Received unknown SIP request message.\n",
                              DEB_F_PREFIX_ARGS(SIP_MSG_RECV, fname));
             /* The message must be deallocated here */
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -2179,18 +2224,23 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                   "returned error. Discarding response\n",
                                   fname);
             }
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
 
-        /* Response is ok.  Cancel the outstanding reTx timer if any */
-        CCSIP_DEBUG_TASK(DEB_F_PREFIX"Stopping any outstanding reTx "
-                         "timers...\n", DEB_F_PREFIX_ARGS(SIP_TIMER, fname));
-        sip_sm_check_retx_timers(ccb, pSipMessage);
+        /*
+         * Response is ok.  Cancel the outstanding reTx timer if any.
+         * Responses to transaction layer requests leave the slot alone,
+         * it may be retransmitting an overlapping INVITE.
+         */
+        if (!sip_trx_method_owned(method)) {
+            CCSIP_DEBUG_TASK(DEB_F_PREFIX"Stopping any outstanding reTx "
+                             "timers...\n", DEB_F_PREFIX_ARGS(SIP_TIMER, fname));
+            sip_sm_check_retx_timers(ccb, pSipMessage);
 
-        /* got a response, re-set re-transmit flag */
-        ccb->retx_flag = FALSE;
+            /* got a response, re-set re-transmit flag */
+            ccb->retx_flag = FALSE;
+        }
         ccb->last_recvd_response_code = response_code;
         /*
          * TEL_CCB_START equates to zero and line_t is an unsigned type,
@@ -2230,7 +2280,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             case SIP_CLI_ERR_PROXY_REQD:
                 if (sipCseq->method == sipMethodAck) {
                     sipSPISendFailureResponseAck(ccb, pSipMessage, FALSE, 0);
-                    cpr_free(sipCseq);
                     free_sip_message(pSipMessage);
                     return;
                 }
@@ -2245,7 +2294,6 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
             /* unknown response, keep re-transmitting */
             ccb->retx_flag = TRUE;
             CCSIP_DEBUG_ERROR(SIP_F_PREFIX"Unknown response class.\n", fname);
-            cpr_free(sipCseq);
             free_sip_message(pSipMessage);
             return;
         }
@@ -2284,17 +2332,14 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                           fname, SIP_SERV_ERR_INTERNAL);
                     }
                 }
-                cpr_free(sipCseq);
                 free_sip_message(pSipMessage);
                 return;
             } else {
-                cpr_free(sipCseq);
                 return;
             }
         }
         CCSIP_DEBUG_TASK(DEB_F_PREFIX"Ignoring non-register event= %d\n",
                          DEB_F_PREFIX_ARGS(SIP_EVT, fname), sip_sm_event.type);
-        cpr_free(sipCseq);
         free_sip_message(pSipMessage);
         return;
     }
@@ -2311,12 +2356,10 @@ SIPTaskProcessSIPMessage (sipMessage_t *pSipMessage)
                                   fname, SIP_SERV_ERR_INTERNAL);
             }
         }
-        cpr_free(sipCseq);
         free_sip_message(pSipMessage);
         return;
     }
 
-    cpr_free(sipCseq);
 }
 
 /**
@@ -2399,7 +2442,7 @@ SIPTaskProcessSIPNotify (sipMessage_t *pSipMessage)
     char            line_name[MAX_LINE_NAME_SIZE];
     char            line_contact[MAX_LINE_CONTACT_SIZE];
     const char     *to = NULL;
-    sipLocation_t  *to_loc = NULL;
+    const sipLocation_t *to_loc = NULL;
     sipUrl_t       *sipToUrl = NULL;
     boolean         to_header_error = TRUE;
     char           *pUser = NULL;
@@ -2495,7 +2538,7 @@ SIPTaskProcessSIPNotify (sipMessage_t *pSipMessage)
      */
     to = sippmh_get_cached_header_val(pSipMessage, TO);
     if (to) {
-        to_loc = sippmh_parse_from_or_to((char *)to, TRUE);
+        to_loc = sippmh_get_parsed_to(pSipMessage);
         if (to_loc) {
             if (to_loc->genUrl->schema == URL_TYPE_SIP) {
                 sipToUrl = to_loc->genUrl->u.sipUrl;
@@ -2511,9 +2554,6 @@ SIPTaskProcessSIPNotify (sipMessage_t *pSipMessage)
                         }
                     }
                 }
-                sippmh_free_location(to_loc);
-            } else {
-                sippmh_free_location(to_loc);
             }
         }
     }
@@ -3057,6 +3097,7 @@ void destroy_sip_thread()
     static const char fname[] = "destroy_sip_thread";
     DEF_DEBUG(DEB_F_PREFIX"Unloading SIP and destroying sip thread\n", 
         DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
+    cc_shutdown_phase_unloaded(CC_SHUTDOWN_PHASE_SIP);
     /* kill msgQ thread first, then itself */
     (void) cprDestroyThread(sip_thread);
 }
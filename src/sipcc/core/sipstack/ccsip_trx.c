@@ -0,0 +1,1023 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+
+#include "cpr_types.h"
+#include "cpr_string.h"
+#include "cpr_strings.h"
+#include "cpr_memory.h"
+#include "cpr_timers.h"
+#include "phntask.h"
+#include "ccsip_trx.h"
+#include "ccsip_core.h"
+#include "ccsip_task.h"
+#include "ccsip_platform.h"
+#include "ccsip_protocol.h"
+#include "ccsip_messaging.h"
+#include "sip_common_transport.h"
+#include "phone_debug.h"
+#include "config.h"
+#include "debug.h"
+#include "cc_capacity.h"
+
+/* Constants */
+#define SIP_TRX_MAX_TIMEOUT_FACTOR  64  /* Timer F and Timer J are 64*T1 */
+#define SIP_TRX_INDEX_MASK          0xffff
+#define SIP_TRX_GEN_SHIFT           16
+#define SIP_TRX_NONE                (-1)
+
+typedef struct sip_trx_t_ {
+    boolean          in_use;
+    uint16_t         generation;
+    sip_trx_kind_e   kind;
+    sip_trx_state_e  state;
+    sipMethod_t      method;
+    sipMethod_t      message_type;
+    line_t           ccb_index;
+    char             branch[SIP_TRX_BRANCH_LEN];
+    int32_t          hash_next;
+    sip_trx_buf_t   *buf;
+    cpr_ip_addr_t    ipaddr;
+    uint16_t         port;
+    boolean          reliable;
+    uint32_t         interval;   /* next Timer E interval */
+    uint32_t         elapsed;    /* since the request was first sent */
+    uint32_t         armed;      /* duration the timer was last started for */
+    uint32_t         retx;
+    cprTimer_t       timer;
+} sip_trx_t;
+
+typedef struct {
+    uint32_t created[SIP_TRX_SERVER + 1];
+    uint32_t retransmits;
+    uint32_t responses_resent;
+    uint32_t responses_absorbed;
+    uint32_t acks_resent;
+    uint32_t acks_absorbed;
+    uint32_t timeouts;
+    uint32_t evicted;
+    uint32_t no_slot;
+} sip_trx_stats_t;
+
+/* Global variables */
+static sip_trx_t *sip_trx_table = NULL;
+static int32_t *sip_trx_buckets = NULL;
+static uint32_t sip_trx_count = 0;
+static sip_trx_stats_t sip_trx_stats;
+
+static const char *sip_trx_state_names[] = {
+    "Terminated", "Trying", "Proceeding", "Completed", "Confirmed"
+};
+
+/*
+ * Branch and call of the INVITE whose 300-699 response is being handled,
+ * so that the ACK sent for it, which goes out without its CCB, can be
+ * told from an ACK for a 2xx and filed under the call.
+ */
+static char sip_trx_failed_invite[SIP_TRX_BRANCH_LEN];
+static line_t sip_trx_failed_invite_ccb;
+
+
+sip_trx_buf_t *
+sip_trx_buf_create (const char *data, uint32_t len)
+{
+    sip_trx_buf_t *buf;
+
+    buf = (sip_trx_buf_t *) cpr_malloc(sizeof(sip_trx_buf_t) + len);
+    if (buf == NULL) {
+        return NULL;
+    }
+    buf->refcount = 1;
+    buf->len = len;
+    memcpy(buf->data, data, len);
+    buf->data[len] = '\0';
+    return buf;
+}
+
+sip_trx_buf_t *
+sip_trx_buf_ref (sip_trx_buf_t *buf)
+{
+    if (buf) {
+        buf->refcount++;
+    }
+    return buf;
+}
+
+void
+sip_trx_buf_unref (sip_trx_buf_t *buf)
+{
+    if (buf && (--buf->refcount == 0)) {
+        cpr_free(buf);
+    }
+}
+
+
+/*
+ * Allocates the transaction table, SIP_TRX_PER_CCB entries per call,
+ * and its branch hash.
+ */
+int
+sip_trx_alloc (void)
+{
+    uint32_t i;
+
+    if (sip_trx_table != NULL) {
+        return SIP_OK;
+    }
+    sip_trx_count = MAX_TEL_LINES * SIP_TRX_PER_CCB;
+    sip_trx_table = (sip_trx_t *)
+        cc_capacity_table_alloc("sip transactions", sip_trx_count,
+                                sizeof(sip_trx_t));
+    sip_trx_buckets = (int32_t *)
+        cc_capacity_table_alloc("sip transaction hash", sip_trx_count,
+                                sizeof(int32_t));
+    if (!sip_trx_table || !sip_trx_buckets) {
+        return SIP_ERROR;
+    }
+    for (i = 0; i < sip_trx_count; i++) {
+        sip_trx_buckets[i] = SIP_TRX_NONE;
+        sip_trx_table[i].hash_next = SIP_TRX_NONE;
+    }
+    return SIP_OK;
+}
+
+int
+sip_trx_init (void)
+{
+    static const char fname[] = "sip_trx_init";
+    static const char sipTrxTimerName[] = "sipTrx";
+    uint32_t i;
+
+    for (i = 0; i < sip_trx_count; i++) {
+        if (sip_trx_table[i].timer != NULL) {
+            continue;
+        }
+        sip_trx_table[i].timer = cprCreateTimer(sipTrxTimerName,
+                                                SIP_TRX_TIMER,
+                                                TIMER_EXPIRATION,
+                                                sip_msgq);
+        if (sip_trx_table[i].timer == NULL) {
+            CCSIP_DEBUG_ERROR(SIP_F_PREFIX"failed to create transaction timer %d\n",
+                              fname, i);
+            return SIP_ERROR;
+        }
+    }
+    memset(&sip_trx_stats, 0, sizeof(sip_trx_stats));
+    return SIP_OK;
+}
+
+
+static uint32_t
+sip_trx_bucket (sip_trx_kind_e kind, sipMethod_t method, const char *branch)
+{
+    uint32_t hash = 5381;
+
+    while (*branch) {
+        hash = (hash * 33) ^ (uint8_t) *branch++;
+    }
+    hash = (hash * 33) ^ (uint32_t) method;
+    hash = (hash * 33) ^ (uint32_t) kind;
+    return (hash % sip_trx_count);
+}
+
+static sip_trx_t *
+sip_trx_find (sip_trx_kind_e kind, sipMethod_t method, const char *branch)
+{
+    int32_t idx;
+
+    if ((sip_trx_table == NULL) || (branch == NULL)) {
+        return NULL;
+    }
+    idx = sip_trx_buckets[sip_trx_bucket(kind, method, branch)];
+    while (idx != SIP_TRX_NONE) {
+        sip_trx_t *trx = &sip_trx_table[idx];
+
+        if ((trx->kind == kind) && (trx->method == method) &&
+            (strcmp(trx->branch, branch) == 0)) {
+            return trx;
+        }
+        idx = trx->hash_next;
+    }
+    return NULL;
+}
+
+static void
+sip_trx_terminate (sip_trx_t *trx)
+{
+    static const char fname[] = "sip_trx_terminate";
+    int32_t *link;
+    int32_t idx = (int32_t) (trx - sip_trx_table);
+
+    (void) cprCancelTimer(trx->timer);
+
+    link = &sip_trx_buckets[sip_trx_bucket(trx->kind, trx->method, trx->branch)];
+    while (*link != SIP_TRX_NONE) {
+        if (*link == idx) {
+            *link = trx->hash_next;
+            break;
+        }
+        link = &sip_trx_table[*link].hash_next;
+    }
+    CCSIP_DEBUG_TRX(DEB_F_PREFIX"%s %s transaction %s terminated\n",
+                    DEB_F_PREFIX_ARGS(SIP_TRX, fname),
+                    (trx->kind == SIP_TRX_CLIENT) ? "client" : "server",
+                    sipGetMethodString(trx->method), trx->branch);
+
+    sip_trx_buf_unref(trx->buf);
+    trx->buf = NULL;
+    trx->hash_next = SIP_TRX_NONE;
+    trx->state = SIP_TRX_STATE_TERMINATED;
+    trx->in_use = FALSE;
+    trx->generation++;
+}
+
+/*
+ * Takes a free entry from the call's share of the table. When all of
+ * them are busy, a completed or confirmed transaction, which is only
+ * waiting to absorb retransmissions, gives way to the new one.
+ */
+static sip_trx_t *
+sip_trx_get_free (line_t ccb_index)
+{
+    sip_trx_t *trx = &sip_trx_table[ccb_index * SIP_TRX_PER_CCB];
+    sip_trx_t *completed = NULL;
+    int i;
+
+    for (i = 0; i < SIP_TRX_PER_CCB; i++, trx++) {
+        if (!trx->in_use) {
+            return trx;
+        }
+        if ((completed == NULL) &&
+            ((trx->state == SIP_TRX_STATE_COMPLETED) ||
+             (trx->state == SIP_TRX_STATE_CONFIRMED))) {
+            completed = trx;
+        }
+    }
+    if (completed) {
+        sip_trx_stats.evicted++;
+        sip_trx_terminate(completed);
+    }
+    return completed;
+}
+
+static void
+sip_trx_start_timer (sip_trx_t *trx, uint32_t msec)
+{
+    static const char fname[] = "sip_trx_start_timer";
+    long data;
+
+    /* a pop queued before this start is recognised as stale */
+    trx->generation++;
+    data = ((long) trx->generation << SIP_TRX_GEN_SHIFT) |
+           (long) (trx - sip_trx_table);
+    trx->armed = msec;
+    if (cprStartTimer(trx->timer, msec, (void *) data) == CPR_FAILURE) {
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"cprStartTimer failed for %s\n",
+                          fname, trx->branch);
+    }
+}
+
+static void
+sip_trx_resend (sip_trx_t *trx)
+{
+    static const char fname[] = "sip_trx_resend";
+    sip_trx_buf_t *buf;
+
+    buf = sip_trx_buf_ref(trx->buf);
+    /* the ACK for a failed INVITE was sent without the CCB, so it is here */
+    if (sipTransportSendMessage((trx->message_type == sipMethodAck) ? NULL :
+                                sip_sm_get_ccb_by_index(trx->ccb_index),
+                                buf->data, buf->len, trx->message_type,
+                                &trx->ipaddr, trx->port,
+                                FALSE, FALSE, 0, NULL) < 0) {
+        CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_GENERAL_FUNCTIONCALL_FAILED),
+                          fname, "sipTransportSendMessage()");
+    }
+    sip_trx_buf_unref(buf);
+}
+
+
+/*
+ * Serialized message helpers. Outgoing messages are only ever built by
+ * this stack, but the compact header forms are accepted anyway.
+ */
+static const char *
+sip_trx_find_header (const char *buf, uint32_t len, const char *name,
+                     const char *compact, uint32_t *value_len)
+{
+    const char *end = buf + len;
+    const char *line = buf;
+    const char *eol;
+    size_t name_len = strlen(name);
+    size_t compact_len = compact ? strlen(compact) : 0;
+
+    /* skip the start line */
+    while ((line < end) && (*line != '\n')) {
+        line++;
+    }
+    while (++line < end) {
+        const char *p = NULL;
+
+        eol = line;
+        while ((eol < end) && (*eol != '\r') && (*eol != '\n')) {
+            eol++;
+        }
+        if (eol == line) {
+            break; /* end of headers */
+        }
+        if (((size_t) (eol - line) > name_len) &&
+            (cpr_strncasecmp(line, name, name_len) == 0)) {
+            p = line + name_len;
+        } else if (compact && ((size_t) (eol - line) > compact_len) &&
+                   (cpr_strncasecmp(line, compact, compact_len) == 0)) {
+            p = line + compact_len;
+        }
+        if (p) {
+            while ((p < eol) && ((*p == ' ') || (*p == '\t'))) {
+                p++;
+            }
+            if ((p < eol) && (*p == ':')) {
+                p++;
+                while ((p < eol) && ((*p == ' ') || (*p == '\t'))) {
+                    p++;
+                }
+                *value_len = (uint32_t) (eol - p);
+                return p;
+            }
+        }
+        line = eol;
+        if ((line < end) && (*line == '\r')) {
+            line++;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Copies the RFC 3261 branch of the top Via. Branches without the magic
+ * cookie, or too long to key on, get no transaction.
+ */
+static boolean
+sip_trx_buf_branch (const char *buf, uint32_t len, char *branch)
+{
+    const char *via;
+    const char *p;
+    const char *end;
+    uint32_t via_len = 0;
+    size_t branch_len = strlen(VIA_BRANCH);
+    uint32_t i = 0;
+
+    via = sip_trx_find_header(buf, len, SIP_HEADER_VIA, SIP_C_HEADER_VIA,
+                              &via_len);
+    if (via == NULL) {
+        return FALSE;
+    }
+    end = via + via_len;
+    for (p = via; p + branch_len < end; p++) {
+        if (*p == ',') {
+            return FALSE; /* only the top Via */
+        }
+        if ((*p == ';') &&
+            (cpr_strncasecmp(p + 1, VIA_BRANCH, branch_len) == 0) &&
+            (p[branch_len + 1] == '=')) {
+            p += branch_len + 2;
+            while ((p < end) && (*p != ';') && (*p != ',') && (*p != ' ') &&
+                   (i < SIP_TRX_BRANCH_LEN - 1)) {
+                branch[i++] = *p++;
+            }
+            branch[i] = '\0';
+            return (((p == end) || (*p == ';') || (*p == ',') || (*p == ' ')) &&
+                    (strncmp(branch, VIA_BRANCH_START,
+                             sizeof(VIA_BRANCH_START) - 1) == 0));
+        }
+    }
+    return FALSE;
+}
+
+static sipMethod_t
+sip_trx_buf_cseq_method (const char *buf, uint32_t len)
+{
+    const char *cseq;
+    const char *p;
+    const char *end;
+    char method[16];
+    uint32_t cseq_len = 0;
+    uint32_t i = 0;
+
+    cseq = sip_trx_find_header(buf, len, SIP_HEADER_CSEQ, NULL,
+                               &cseq_len);
+    if (cseq == NULL) {
+        return sipMethodInvalid;
+    }
+    end = cseq + cseq_len;
+    for (p = cseq; (p < end) && (*p >= '0') && (*p <= '9'); p++) {
+        ;
+    }
+    while ((p < end) && ((*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+    while ((p < end) && (*p != ' ') && (i < sizeof(method) - 1)) {
+        method[i++] = *p++;
+    }
+    method[i] = '\0';
+    return sippmh_get_method_code(method);
+}
+
+static int
+sip_trx_buf_status (const char *buf, uint32_t len)
+{
+    const char *p = buf + sizeof(SIP_VERSION);
+    int status = 0;
+
+    if ((len <= sizeof(SIP_VERSION)) ||
+        (strncmp(buf, SIP_VERSION " ", sizeof(SIP_VERSION)) != 0)) {
+        return -1;
+    }
+    while ((p < buf + len) && (*p >= '0') && (*p <= '9')) {
+        status = status * 10 + (*p++ - '0');
+    }
+    return status;
+}
+
+
+/*
+ * Methods whose requests and responses are owned by this module rather
+ * than by the CCB retransmit slot.
+ */
+boolean
+sip_trx_method_owned (sipMethod_t method)
+{
+    switch (method) {
+    case sipMethodInfo:
+    case sipMethodUpdate:
+    case sipMethodNotify:
+    case sipMethodOptions:
+    case sipMethodMessage:
+    case sipMethodPrack:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * Enters a transaction for branch in the call's share of the table.
+ * buf, if not NULL, is the message kept for retransmission. Returns
+ * NULL when no entry or memory is left.
+ */
+static sip_trx_t *
+sip_trx_add (line_t ccb_index, sip_trx_kind_e kind, sipMethod_t method,
+             sipMethod_t message_type, const char *branch,
+             const char *buf, uint32_t len,
+             cpr_ip_addr_t *ipaddr, uint16_t port, boolean reliable)
+{
+    static const char fname[] = "sip_trx_add";
+    sip_trx_buf_t *trx_buf = NULL;
+    sip_trx_t *trx;
+    int32_t *head;
+
+    /* a retransmission the TU sent itself replaces the stored copy */
+    trx = sip_trx_find(kind, method, branch);
+    if (trx) {
+        sip_trx_terminate(trx);
+    }
+    trx = sip_trx_get_free(ccb_index);
+    if (trx == NULL) {
+        sip_trx_stats.no_slot++;
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"no transaction free on call %d for %s %s\n",
+                          fname, ccb_index, sipGetMethodString(method), branch);
+        return NULL;
+    }
+    if (buf) {
+        trx_buf = sip_trx_buf_create(buf, len);
+        if (trx_buf == NULL) {
+            return NULL;
+        }
+    }
+
+    trx->in_use = TRUE;
+    trx->kind = kind;
+    trx->method = method;
+    trx->message_type = message_type;
+    trx->ccb_index = ccb_index;
+    sstrncpy(trx->branch, branch, sizeof(trx->branch));
+    trx->buf = trx_buf;
+    trx->ipaddr = *ipaddr;
+    trx->port = port;
+    trx->reliable = reliable;
+    trx->elapsed = 0;
+    trx->retx = 0;
+    head = &sip_trx_buckets[sip_trx_bucket(kind, method, branch)];
+    trx->hash_next = *head;
+    *head = (int32_t) (trx - sip_trx_table);
+    sip_trx_stats.created[kind]++;
+
+    CCSIP_DEBUG_TRX(DEB_F_PREFIX"%s %s transaction %s started on call %d\n",
+                    DEB_F_PREFIX_ARGS(SIP_TRX, fname),
+                    (kind == SIP_TRX_CLIENT) ? "client" : "server",
+                    sipGetMethodString(method), branch, ccb_index);
+    return trx;
+}
+
+/*
+ * The INVITE side of sip_trx_message_sent(). The slot keeps
+ * retransmitting INVITEs and the responses to them (Timer A/B and G/H);
+ * a 300-699 to a received INVITE then starts a completed server
+ * transaction here that waits for the ACK until Timer H. It does not
+ * run on a reliable transport, where Timer I is zero.
+ */
+static void
+sip_trx_invite_message_sent (line_t ccb_index, sipMethod_t message_type,
+                             const char *buf, uint32_t len,
+                             cpr_ip_addr_t *ipaddr, uint16_t port,
+                             boolean reliable)
+{
+    char branch[SIP_TRX_BRANCH_LEN];
+    sip_trx_t *trx;
+    uint32_t t1 = 0;
+
+    if ((message_type != sipMethodResponse) || reliable ||
+        !sip_trx_buf_branch(buf, len, branch) ||
+        (sip_trx_buf_status(buf, len) < 300)) {
+        return;
+    }
+    /* the slot's own retransmissions do not come back through here */
+    if (sip_trx_find(SIP_TRX_SERVER, sipMethodInvite, branch)) {
+        return;
+    }
+    trx = sip_trx_add(ccb_index, SIP_TRX_SERVER, sipMethodInvite,
+                      message_type, branch, NULL, 0, ipaddr, port, reliable);
+    if (trx) {
+        config_get_value(CFGID_TIMER_T1, &t1, sizeof(t1));
+        trx->state = SIP_TRX_STATE_COMPLETED;
+        sip_trx_start_timer(trx, SIP_TRX_MAX_TIMEOUT_FACTOR * t1);
+    }
+}
+
+/*
+ * Called by the transport after it sent an ACK that has no CCB. The ACK
+ * for a 300-699 to one of our INVITEs starts a completed client
+ * transaction that resends it to retransmissions of the response until
+ * Timer D; an ACK for a 2xx is a transaction of its own. Timer D is zero
+ * on a reliable transport.
+ */
+void
+sip_trx_ack_sent (const char *buf, uint32_t len, cpr_ip_addr_t *ipaddr,
+                  uint16_t port, boolean reliable)
+{
+    char branch[SIP_TRX_BRANCH_LEN];
+    sip_trx_t *trx;
+
+    if ((sip_trx_table == NULL) || reliable ||
+        (sip_trx_failed_invite[0] == '\0') ||
+        !sip_trx_buf_branch(buf, len, branch) ||
+        (strcmp(branch, sip_trx_failed_invite) != 0)) {
+        return;
+    }
+    sip_trx_failed_invite[0] = '\0';
+    trx = sip_trx_add(sip_trx_failed_invite_ccb, SIP_TRX_CLIENT,
+                      sipMethodInvite, sipMethodAck, branch, buf, len,
+                      ipaddr, port, reliable);
+    if (trx) {
+        trx->state = SIP_TRX_STATE_COMPLETED;
+        sip_trx_start_timer(trx, SIP_TRX_TIMER_D);
+    }
+}
+
+/*
+ * Called by the transport after it sent a message on a call's behalf
+ * with a retransmit request.
+ * Returns TRUE when the message belongs to this module, in which case
+ * the CCB retransmit slot must be left alone. A request sent with a
+ * retransmit timeout starts a client transaction; a final response
+ * sent over an unreliable transport starts a server transaction that
+ * answers retransmitted requests until Timer J. INVITE transactions
+ * are left to the slot, see sip_trx_invite_message_sent().
+ */
+boolean
+sip_trx_message_sent (line_t ccb_index, sipMethod_t message_type,
+                      const char *buf, uint32_t len,
+                      cpr_ip_addr_t *ipaddr, uint16_t port,
+                      boolean reliable, int timeout)
+{
+    sip_trx_kind_e kind = SIP_TRX_CLIENT;
+    sipMethod_t method = message_type;
+    char branch[SIP_TRX_BRANCH_LEN];
+    sip_trx_t *trx;
+    uint32_t t1 = 0;
+
+    if ((sip_trx_table == NULL) || ((int) ccb_index > TEL_CCB_END)) {
+        return FALSE;
+    }
+    if (message_type == sipMethodResponse) {
+        kind = SIP_TRX_SERVER;
+        method = sip_trx_buf_cseq_method(buf, len);
+    }
+    if (method == sipMethodInvite) {
+        sip_trx_invite_message_sent(ccb_index, message_type, buf, len,
+                                    ipaddr, port, reliable);
+        return FALSE;
+    }
+    if (!sip_trx_method_owned(method)) {
+        return FALSE;
+    }
+
+    if (kind == SIP_TRX_CLIENT) {
+        if (timeout <= 0) {
+            return TRUE;
+        }
+    } else if (reliable || (sip_trx_buf_status(buf, len) < 200)) {
+        return TRUE;
+    }
+    if (!sip_trx_buf_branch(buf, len, branch)) {
+        return TRUE;
+    }
+
+    trx = sip_trx_add(ccb_index, kind, method, message_type, branch,
+                      buf, len, ipaddr, port, reliable);
+    if (trx == NULL) {
+        return TRUE;
+    }
+
+    config_get_value(CFGID_TIMER_T1, &t1, sizeof(t1));
+    if (kind == SIP_TRX_CLIENT) {
+        /* Timer E starts at T1; on a reliable transport only Timer F runs */
+        trx->state = SIP_TRX_STATE_TRYING;
+        trx->interval = (uint32_t) timeout;
+        sip_trx_start_timer(trx, reliable ? SIP_TRX_MAX_TIMEOUT_FACTOR * t1 :
+                            (uint32_t) timeout);
+    } else {
+        /* Timer J */
+        trx->state = SIP_TRX_STATE_COMPLETED;
+        sip_trx_start_timer(trx, SIP_TRX_MAX_TIMEOUT_FACTOR * t1);
+    }
+    return TRUE;
+}
+
+/*
+ * A response to one of our INVITEs. Retransmissions of a 300-699 that
+ * was already ACKed are answered with the stored ACK (Timer D) and go
+ * no further; 2xx retransmissions are the call's to ACK. Returns TRUE
+ * when the response must be discarded.
+ */
+static boolean
+sip_trx_invite_response_received (sipMessage_t *response)
+{
+    static const char fname[] = "sip_trx_invite_response_received";
+    const sipVia_t *via;
+    const char *callid;
+    ccsipCCB_t *ccb;
+    sip_trx_t *trx;
+    int response_code = 0;
+
+    via = sippmh_get_parsed_via(response);
+    if ((via == NULL) || (via->branch_param == NULL) ||
+        (sipGetResponseCode(response, &response_code) < 0) ||
+        (response_code < 300)) {
+        return FALSE;
+    }
+    trx = sip_trx_find(SIP_TRX_CLIENT, sipMethodInvite, via->branch_param);
+    if (trx == NULL) {
+        /* the ACK the call is about to send completes the transaction */
+        callid = sippmh_get_cached_header_val(response, CALLID);
+        ccb = callid ? sip_sm_get_ccb_by_callid(callid) : NULL;
+        if ((ccb != NULL) && ((int) ccb->index <= TEL_CCB_END)) {
+            sstrncpy(sip_trx_failed_invite, via->branch_param,
+                     sizeof(sip_trx_failed_invite));
+            sip_trx_failed_invite_ccb = ccb->index;
+        }
+        return FALSE;
+    }
+
+    sip_trx_stats.responses_absorbed++;
+    sip_trx_stats.acks_resent++;
+    trx->retx++;
+    CCSIP_DEBUG_TRX(DEB_F_PREFIX"absorbed retransmitted %d for INVITE %s, "
+                    "resending ACK\n", DEB_F_PREFIX_ARGS(SIP_TRX, fname),
+                    response_code, trx->branch);
+    sip_trx_resend(trx);
+    return TRUE;
+}
+
+/*
+ * An ACK for one of our INVITE responses. The first ACK for a 300-699
+ * confirms the server transaction and goes on to the call, which stops
+ * the slot; later ones are absorbed until Timer I. Returns TRUE when the
+ * ACK must be discarded.
+ */
+static boolean
+sip_trx_ack_received (sipMessage_t *request)
+{
+    static const char fname[] = "sip_trx_ack_received";
+    const sipVia_t *via;
+    sip_trx_t *trx;
+
+    via = sippmh_get_parsed_via(request);
+    if (via == NULL) {
+        return FALSE;
+    }
+    trx = sip_trx_find(SIP_TRX_SERVER, sipMethodInvite, via->branch_param);
+    if (trx == NULL) {
+        return FALSE;
+    }
+    if (trx->state == SIP_TRX_STATE_CONFIRMED) {
+        sip_trx_stats.acks_absorbed++;
+        CCSIP_DEBUG_TRX(DEB_F_PREFIX"absorbed retransmitted ACK for INVITE %s\n",
+                        DEB_F_PREFIX_ARGS(SIP_TRX, fname), trx->branch);
+        return TRUE;
+    }
+
+    /* Timer I */
+    (void) cprCancelTimer(trx->timer);
+    trx->state = SIP_TRX_STATE_CONFIRMED;
+    sip_trx_start_timer(trx, SIP_TRX_TIMER_T4);
+    return FALSE;
+}
+
+/*
+ * Matches a response to its client transaction. Returns TRUE when the
+ * response is a retransmitted final response that the TU has already
+ * seen and must be discarded.
+ */
+boolean
+sip_trx_response_received (sipMessage_t *response)
+{
+    static const char fname[] = "sip_trx_response_received";
+    const sipVia_t *via;
+    const sipCseq_t *cseq;
+    sip_trx_t *trx;
+    int response_code = 0;
+
+    if (sip_trx_table == NULL) {
+        return FALSE;
+    }
+    sip_trx_failed_invite[0] = '\0';
+    cseq = sippmh_get_parsed_cseq(response);
+    if ((cseq != NULL) && (cseq->method == sipMethodInvite)) {
+        return sip_trx_invite_response_received(response);
+    }
+    if ((cseq == NULL) || !sip_trx_method_owned(cseq->method)) {
+        return FALSE;
+    }
+    via = sippmh_get_parsed_via(response);
+    if (via == NULL) {
+        return FALSE;
+    }
+    trx = sip_trx_find(SIP_TRX_CLIENT, cseq->method, via->branch_param);
+    if (trx == NULL) {
+        return FALSE;
+    }
+    if (sipGetResponseCode(response, &response_code) < 0) {
+        return FALSE;
+    }
+
+    if (trx->state == SIP_TRX_STATE_COMPLETED) {
+        sip_trx_stats.responses_absorbed++;
+        CCSIP_DEBUG_TRX(DEB_F_PREFIX"absorbed retransmitted %d for %s %s\n",
+                        DEB_F_PREFIX_ARGS(SIP_TRX, fname), response_code,
+                        sipGetMethodString(trx->method), trx->branch);
+        return TRUE;
+    }
+    if (response_code < 200) {
+        trx->state = SIP_TRX_STATE_PROCEEDING;
+        return FALSE;
+    }
+
+    /* Timer K absorbs final response retransmissions on UDP */
+    (void) cprCancelTimer(trx->timer);
+    if (trx->reliable) {
+        sip_trx_terminate(trx);
+    } else {
+        trx->state = SIP_TRX_STATE_COMPLETED;
+        sip_trx_buf_unref(trx->buf);
+        trx->buf = NULL;
+        sip_trx_start_timer(trx, SIP_TRX_TIMER_T4);
+    }
+    return FALSE;
+}
+
+/*
+ * Answers a retransmitted request from its server transaction. Returns
+ * TRUE when the stored final response was resent and the request must
+ * not reach the TU again.
+ */
+boolean
+sip_trx_request_received (sipMessage_t *request)
+{
+    static const char fname[] = "sip_trx_request_received";
+    const sipVia_t *via;
+    const sipCseq_t *cseq;
+    sip_trx_t *trx;
+
+    if (sip_trx_table == NULL) {
+        return FALSE;
+    }
+    sip_trx_failed_invite[0] = '\0';
+    cseq = sippmh_get_parsed_cseq(request);
+    if ((cseq != NULL) && (cseq->method == sipMethodAck)) {
+        return sip_trx_ack_received(request);
+    }
+    if ((cseq == NULL) || !sip_trx_method_owned(cseq->method)) {
+        return FALSE;
+    }
+    via = sippmh_get_parsed_via(request);
+    if (via == NULL) {
+        return FALSE;
+    }
+    trx = sip_trx_find(SIP_TRX_SERVER, cseq->method, via->branch_param);
+    if ((trx == NULL) || (trx->state != SIP_TRX_STATE_COMPLETED)) {
+        return FALSE;
+    }
+    sip_trx_stats.responses_resent++;
+    trx->retx++;
+    CCSIP_DEBUG_TRX(DEB_F_PREFIX"resending final response for %s %s\n",
+                    DEB_F_PREFIX_ARGS(SIP_TRX, fname),
+                    sipGetMethodString(trx->method), trx->branch);
+    sip_trx_resend(trx);
+    return TRUE;
+}
+
+/*
+ * SIP_TRX_TIMER expiry, in SIP task context. The single per transaction
+ * timer serves as Timer E, F and K (D for INVITE) for client
+ * transactions and Timer J (H and I for INVITE) for server ones: Timer E
+ * is never started past the Timer F deadline, so when it pops with the
+ * deadline reached it is Timer F.
+ */
+void
+sip_trx_timer_expire (void *data)
+{
+    static const char fname[] = "sip_trx_timer_expire";
+    uint32_t idx = (uint32_t) ((long) data & SIP_TRX_INDEX_MASK);
+    uint16_t generation = (uint16_t) ((long) data >> SIP_TRX_GEN_SHIFT);
+    uint32_t t1 = 0;
+    uint32_t t2 = 0;
+    uint32_t deadline;
+    sip_trx_t *trx;
+
+    if ((sip_trx_table == NULL) || (idx >= sip_trx_count)) {
+        return;
+    }
+    trx = &sip_trx_table[idx];
+    if (!trx->in_use || (trx->generation != generation)) {
+        /* popped after the transaction had already ended */
+        return;
+    }
+    trx->elapsed += trx->armed;
+
+    if ((trx->kind == SIP_TRX_SERVER) ||
+        (trx->state == SIP_TRX_STATE_COMPLETED)) {
+        sip_trx_terminate(trx);
+        return;
+    }
+
+    config_get_value(CFGID_TIMER_T1, &t1, sizeof(t1));
+    config_get_value(CFGID_TIMER_T2, &t2, sizeof(t2));
+    deadline = SIP_TRX_MAX_TIMEOUT_FACTOR * t1;
+
+    if (trx->elapsed >= deadline) {
+        ccsipCCB_t *ccb = sip_sm_get_ccb_by_index(trx->ccb_index);
+        sipMethod_t method = trx->method;
+
+        sip_trx_stats.timeouts++;
+        CCSIP_DEBUG_ERROR(SIP_F_PREFIX"%s %s timed out after %d retransmissions\n",
+                          fname, sipGetMethodString(method), trx->branch,
+                          trx->retx);
+        sip_trx_terminate(trx);
+        clean_method_request_trx(ccb, method, TRUE);
+        return;
+    }
+
+    sip_trx_stats.retransmits++;
+    trx->retx++;
+    sip_trx_resend(trx);
+    if (!trx->in_use || (trx->generation != generation)) {
+        return;
+    }
+    if (trx->state == SIP_TRX_STATE_TRYING) {
+        trx->interval = MIN(trx->interval * 2, t2);
+    } else {
+        trx->interval = t2;
+    }
+    sip_trx_start_timer(trx, MIN(trx->interval, deadline - trx->elapsed));
+}
+
+/*
+ * Ends the client transactions of a call that is being cleaned up that
+ * are still waiting for a response. Completed and server transactions
+ * stay to deal with retransmissions until their last timer.
+ */
+void
+sip_trx_ccb_cleanup (line_t ccb_index)
+{
+    sip_trx_t *trx;
+    int i;
+
+    if ((sip_trx_table == NULL) || ((int) ccb_index > TEL_CCB_END)) {
+        return;
+    }
+    trx = &sip_trx_table[ccb_index * SIP_TRX_PER_CCB];
+    for (i = 0; i < SIP_TRX_PER_CCB; i++, trx++) {
+        if (trx->in_use && (trx->kind == SIP_TRX_CLIENT) &&
+            (trx->state != SIP_TRX_STATE_COMPLETED)) {
+            sip_trx_terminate(trx);
+        }
+    }
+}
+
+void
+sip_trx_shutdown (void)
+{
+    uint32_t i;
+
+    if (sip_trx_table == NULL) {
+        return;
+    }
+    for (i = 0; i < sip_trx_count; i++) {
+        if (sip_trx_table[i].in_use) {
+            sip_trx_terminate(&sip_trx_table[i]);
+        }
+        (void) cprDestroyTimer(sip_trx_table[i].timer);
+        sip_trx_table[i].timer = NULL;
+    }
+}
+
+/*
+ *  Function: show_sip_trx_cmd()
+ *
+ *  Description: "show sip-trx" callback.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_sip_trx_cmd (cc_int32_t argc, const char *argv[])
+{
+    uint32_t active[SIP_TRX_SERVER + 1] = {0, 0};
+    uint32_t i;
+
+    debugif_printf("------ SIP Transactions ------\n");
+    debugif_printf("%-5s %-6s %-9s %-10s %5s %s\n",
+                   "Call", "Kind", "Method", "State", "ReTx", "Branch");
+    for (i = 0; i < sip_trx_count; i++) {
+        sip_trx_t *trx = &sip_trx_table[i];
+
+        if (!trx->in_use) {
+            continue;
+        }
+        active[trx->kind]++;
+        debugif_printf("%-5d %-6s %-9s %-10s %5u %s\n", trx->ccb_index,
+                       (trx->kind == SIP_TRX_CLIENT) ? "client" : "server",
+                       sipGetMethodString(trx->method),
+                       sip_trx_state_names[trx->state], trx->retx, trx->branch);
+    }
+    debugif_printf("active client/server     : %u/%u of %u\n",
+                   active[SIP_TRX_CLIENT], active[SIP_TRX_SERVER], sip_trx_count);
+    debugif_printf("created client/server    : %u/%u\n",
+                   sip_trx_stats.created[SIP_TRX_CLIENT],
+                   sip_trx_stats.created[SIP_TRX_SERVER]);
+    debugif_printf("requests retransmitted   : %u\n", sip_trx_stats.retransmits);
+    debugif_printf("responses resent         : %u\n", sip_trx_stats.responses_resent);
+    debugif_printf("responses absorbed       : %u\n", sip_trx_stats.responses_absorbed);
+    debugif_printf("ACKs resent/absorbed     : %u/%u\n",
+                   sip_trx_stats.acks_resent, sip_trx_stats.acks_absorbed);
+    debugif_printf("timeouts                 : %u\n", sip_trx_stats.timeouts);
+    debugif_printf("evicted/no slot          : %u/%u\n",
+                   sip_trx_stats.evicted, sip_trx_stats.no_slot);
+    return (0);
+}
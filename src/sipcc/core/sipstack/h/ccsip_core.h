@@ -609,7 +609,7 @@ typedef struct
 
 
 typedef struct {
-    ccsipCCB_t ccbs[MAX_CCBS];
+    ccsipCCB_t *ccbs;         /* MAX_CCBS entries, see sip_sm_alloc_tables */
     int        backup_active; /* Currently use reduce invite retry count */
 } ccsipGlobInfo_t;
 
@@ -755,10 +755,13 @@ void ccsip_handle_release_ev_cc_feature(ccsipCCB_t *ccb, sipSMEvent_t *event);
 void ccsip_handle_ev_cc_info(ccsipCCB_t *ccb, sipSMEvent_t *event);
 void ccsip_handle_release_ev_release(ccsipCCB_t *ccb, sipSMEvent_t *event);
 
+int sip_sm_alloc_tables(void);
 int sip_sm_init(void);
 void sip_shutdown(void);
 void sip_shutdown_phase1(int, int reason);
 void sip_shutdown_phase2(int);
+void sip_shutdown_timer_expired(int);
+void sip_shutdown_check_progress(void);
 void sip_restart(void);
 int sip_sm_ccb_init(ccsipCCB_t *ccb, line_t index, int DN,
                     sipSMStateType_t initial_state);
@@ -773,7 +776,7 @@ ccsipCCB_t *sip_sm_get_target_call_by_con_call_id(callid_t con_call_id);
 boolean sip_is_releasing(ccsipCCB_t* ccb);
 callid_t sip_sm_get_blind_xfereror_ccb_by_gsm_id(callid_t gsm_id);
 uint16_t sip_sm_determine_ccb(const char *callid,
-                              sipCseq_t *sipCseq,
+                              const sipCseq_t *sipCseq,
                               sipMessage_t *pSipMessage,
                               boolean is_request,
                               ccsipCCB_t **ccb);
@@ -0,0 +1,73 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CCSIP_EVENTBODIES_H_
+#define _CCSIP_EVENTBODIES_H_
+
+#include "cpr_types.h"
+#include "xml_parser_defines.h"
+
+/*
+ * Event package bodies (RFC 4235 dialog-info, RFC 3863/4480 PIDF with
+ * RPID, RFC 4730 KPML request and response).
+ *
+ * Bodies are read with a pull tokenizer that works on slices of the
+ * message buffer: no tree is built and nothing is allocated while a
+ * body is decoded. Values are copied straight into the fixed size
+ * fields of ccsip_event_data_t, truncated where a field is too short.
+ */
+
+/*
+ * Decode a body of the given SIP_CONTENT_TYPE_*_VALUE into 'data'.
+ * Returns FALSE when the body is not well formed, is not the document
+ * the content type names, or the content type has no decoder.
+ */
+boolean ccsip_decode_event_body(uint8_t content_type, const char *body,
+                                uint32_t len, ccsip_event_data_t *data);
+
+/*
+ * Encode one event data element. The returned body is NUL terminated,
+ * allocated with cpr_malloc() and owned by the caller; its length goes
+ * to 'len' and its content type to 'content_type'. EVENT_DATA_RAW is
+ * copied as is. Returns NULL for types that have no encoder.
+ */
+char *ccsip_encode_event_body(const ccsip_event_data_t *data, uint32_t *len,
+                              const char **content_type);
+
+#endif
@@ -81,12 +81,14 @@ typedef struct
 } sipPlatformSupervisionTimer_t;
 
 
-extern sipPlatformUITimer_t sipPlatformUISMSubNotTimers[]; // Array of timers
+extern sipPlatformUITimer_t *sipPlatformUISMSubNotTimers; // Array of timers
 
 /*
  * Prototypes
  */
 int
+sip_platform_timers_alloc(void);
+int
 sip_platform_timers_init(void);
 void
 sip_platform_post_timer(uint32_t cmd, void *data);
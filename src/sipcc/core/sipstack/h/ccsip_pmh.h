@@ -531,6 +531,19 @@ PMH_EXTERN sipCseq_t *sippmh_parse_cseq(const char *cseq);
 
 PMH_EXTERN boolean sippmh_parse_rseq(const char *rseq, uint32_t *rseq_val);
 
+/*
+ * Parsed From, To, top Via, CSeq and Contact of a received message.
+ * The header is parsed on the first call and the same structure is
+ * returned after that; it belongs to the message and goes with
+ * free_sip_message(), so it must not be freed or changed.
+ * NULL if the header is missing or does not parse.
+ */
+PMH_EXTERN const sipLocation_t *sippmh_get_parsed_from(sipMessage_t *msg);
+PMH_EXTERN const sipLocation_t *sippmh_get_parsed_to(sipMessage_t *msg);
+PMH_EXTERN const sipVia_t *sippmh_get_parsed_via(sipMessage_t *msg);
+PMH_EXTERN const sipCseq_t *sippmh_get_parsed_cseq(sipMessage_t *msg);
+PMH_EXTERN const sipContact_t *sippmh_get_parsed_contact(sipMessage_t *msg);
+
 PMH_EXTERN sipRack_t *sippmh_parse_rack(const char *rack);
 
 /*
@@ -72,6 +72,7 @@ typedef struct
     //int                       line;
 } sipRelDevMessageRecord_t;
 
+int sipRelDevAllocList(void);
 void sipRelDevMessageStore(sipRelDevMessageRecord_t *pMessageRecord);
 boolean sipRelDevMessageIsDuplicate(sipRelDevMessageRecord_t *pMessageRecord,
                                     int *index);
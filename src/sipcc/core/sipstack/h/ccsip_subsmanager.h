@@ -420,8 +420,10 @@ extern const char eventNames[MAX_SUB_EVENTS][MAX_SUB_EVENT_NAME_LEN];
  * Externally called function headers
  */
 // For initializing and shutting down
+int sip_subsManager_alloc_scbs(void);
 int sip_subsManager_init();
 int sip_subsManager_shut();
+int sip_subsManager_unsubscribe_all();
 
 // Function to handle subscription requests from applications
 int subsmanager_handle_ev_cc_feature_subscribe(sipSMEvent_t *);
@@ -75,7 +75,8 @@ typedef enum {
     SIP_UNREGISTRATION_TIMER,
     SIP_REGALLFAIL_TIMER,
     SIP_NOTIFY_TIMER,
-	SIP_PASSTHROUGH_TIMER
+	SIP_PASSTHROUGH_TIMER,
+    SIP_TRX_TIMER
 } sipTimerList_t;
 
 
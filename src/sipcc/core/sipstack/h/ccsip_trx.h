@@ -0,0 +1,123 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+
+#ifndef _CCSIP_TRX_H_
+#define _CCSIP_TRX_H_
+
+#include "cpr_types.h"
+#include "ccsip_pmh.h"
+
+/*
+ * SIP transactions (RFC 3261 17).
+ *
+ * The CCB retransmit slot in ccsip_platform_timers.c holds a single
+ * message per call, so a request sent while another one is outstanding
+ * used to stop the first one's retransmissions. The in-dialog methods
+ * below are owned by this module instead: every request gets its own
+ * client transaction (Timer E/F/K) and every final response its own
+ * server transaction (Timer J), keyed by the top Via branch and the
+ * CSeq method, so several of them can overlap a re-INVITE.
+ *
+ * INVITE, BYE, CANCEL, REFER and REGISTER are still retransmitted from
+ * the slot because its expiry drives proxy failover in
+ * ccsip_handle_default_sip_timer(). For INVITE that makes the slot
+ * Timer A/B (ccsip_restart_reTx_timer doubles T1 without the T2 cap,
+ * up to CFGID_SIP_INVITE_RETX) and, for a final response to a received
+ * INVITE, Timer G/H (capped at T2, up to CFGID_SIP_RETX). The states
+ * that follow them are kept here:
+ *  - client Completed (Timer D): after a 300-699 to our INVITE the ACK
+ *    is stored and resent for each retransmission of the response,
+ *    which does not reach the call again;
+ *  - server Completed/Confirmed (Timer H/I): once the ACK for our
+ *    300-699 has arrived, its retransmissions are absorbed.
+ */
+#define SIP_TRX_PER_CCB        4
+#define SIP_TRX_BRANCH_LEN     64
+#define SIP_TRX_TIMER_T4       5000
+#define SIP_TRX_TIMER_D        32000
+
+typedef enum {
+    SIP_TRX_CLIENT,
+    SIP_TRX_SERVER
+} sip_trx_kind_e;
+
+typedef enum {
+    SIP_TRX_STATE_TERMINATED,
+    SIP_TRX_STATE_TRYING,
+    SIP_TRX_STATE_PROCEEDING,
+    SIP_TRX_STATE_COMPLETED,
+    SIP_TRX_STATE_CONFIRMED
+} sip_trx_state_e;
+
+/*
+ * A serialized message. The transaction keeps a reference for as long
+ * as it may retransmit, and takes another around each transport send so
+ * that a transaction terminated from inside the send cannot free the
+ * bytes the transport is writing.
+ */
+typedef struct sip_trx_buf_t_ {
+    uint32_t refcount;
+    uint32_t len;
+    char     data[1];
+} sip_trx_buf_t;
+
+sip_trx_buf_t *sip_trx_buf_create(const char *data, uint32_t len);
+sip_trx_buf_t *sip_trx_buf_ref(sip_trx_buf_t *buf);
+void sip_trx_buf_unref(sip_trx_buf_t *buf);
+
+int sip_trx_alloc(void);
+int sip_trx_init(void);
+void sip_trx_shutdown(void);
+
+boolean sip_trx_method_owned(sipMethod_t method);
+boolean sip_trx_message_sent(line_t ccb_index, sipMethod_t message_type,
+                             const char *buf, uint32_t len,
+                             cpr_ip_addr_t *ipaddr, uint16_t port,
+                             boolean reliable, int timeout);
+void sip_trx_ack_sent(const char *buf, uint32_t len, cpr_ip_addr_t *ipaddr,
+                      uint16_t port, boolean reliable);
+boolean sip_trx_response_received(sipMessage_t *response);
+boolean sip_trx_request_received(sipMessage_t *request);
+void sip_trx_timer_expire(void *data);
+void sip_trx_ccb_cleanup(line_t ccb_index);
+
+cc_int32_t show_sip_trx_cmd(cc_int32_t argc, const char *argv[]);
+
+#endif
@@ -54,13 +54,44 @@ typedef struct h_header
 {
     struct h_header *next;
     char *header;
+    uint32_t len;           /* strlen(header) */
+    boolean in_block;       /* node and line live in the msg's header block */
 } httpish_header;
 
+/*
+ * Headers added to an outgoing message are not allocated one by one.
+ * The node and its "name: value" line are carved together out of a
+ * block owned by the message; the first block is sized for a typical
+ * INVITE and a message that outgrows it chains a block twice as big.
+ * All of them go in httpish_msg_free().
+ */
+#define HTTPISH_HDR_BLOCK_SIZE 1024
+
+typedef struct h_hdr_block
+{
+    struct h_hdr_block *next;
+    uint32_t size;
+    uint32_t used;
+} httpish_hdr_block;
+
 typedef struct {
     char *hdr_start;
     char *val_start;
 } httpish_cache_t;
 
+/*
+ * Structures parsed from the cached header values by the layer above
+ * (see sippmh_get_parsed_cseq and friends). Each slot is filled on
+ * first use and its object freed with the message through free_fn.
+ */
+#define HTTPISH_PARSED_CACHE_SIZE 6
+
+typedef struct {
+    void    *obj;
+    void   (*free_fn)(void *obj);
+    boolean  done;      /* obj is the result, even when NULL */
+} httpish_parsed_t;
+
 #define HTTPISH_MAX_BODY_PARTS 6
 typedef struct {
     uint8_t  msgContentDisp;
@@ -89,6 +120,9 @@ typedef struct _httpMsg
     httpish_cache_t hdr_cache[HTTPISH_HEADER_CACHE_SIZE];
     /* this is the complete message received/sent at the socket */
     char           *complete_message;
+    /* newest first; see httpish_hdr_block */
+    httpish_hdr_block *hdr_blocks;
+    httpish_parsed_t parsed[HTTPISH_PARSED_CACHE_SIZE];
 } httpishMsg_t;
 
 typedef struct
@@ -197,8 +231,8 @@ PMH_EXTERN hStatus_t httpish_msg_add_respline(httpishMsg_t *,
  *  Adds a header with a text value to message.
  *    hname = name of the header for eg. "Content-Type"
  *    hval = value of the header for eg. "application/sdp"
- *    This routine allocates memory internally, which is freed on
- *  calling httpish_msg_free()
+ *    The line is copied into the message's header block, which is
+ *  freed on calling httpish_msg_free()
  */
 PMH_EXTERN hStatus_t httpish_msg_add_text_header(httpishMsg_t *msg,
                                                  const char *hname,
@@ -208,10 +242,9 @@ PMH_EXTERN hStatus_t httpish_msg_add_text_header(httpishMsg_t *msg,
  *  Adds a header with a integer value to message.
  *    hname = name of the header for eg. "Content-Length"
  *    hval = value of the header for eg. 234
- *    This routine allocates memory internally, which is freed on
- *    calling httpish_msg_free()
+ *    The line is copied into the message's header block, which is
+ *    freed on calling httpish_msg_free()
  */
-/* Assumes the int is less than 10 characters*/
 PMH_EXTERN hStatus_t httpish_msg_add_int_header(httpishMsg_t *msg,
                                                 const char *hname,
                                                 int32_t hvalue);
@@ -306,6 +339,8 @@ PMH_EXTERN char *httpish_msg_write_to_string(httpishMsg_t * msg);
  * actual number of bytes written if the return value is SUCCESS.
  * There is no attempt to grow or realloc the buffer ie FAILURE
  * is returned if the buffer is not large enough.
+ * Every line is copied straight into buf; the Content-Length of a
+ * multipart body is filled in once the parts have been written.
  */
 PMH_EXTERN hStatus_t httpish_msg_write(httpishMsg_t *msg,
                                        char *buf,
@@ -133,7 +133,7 @@ PMH_EXTERN pmhWstream_t *pmhutils_wstream_create_with_buf(char *buf,
                                                           uint32_t nbytes);
 
 /*
- * Grows the write streams internal buffer by a default step.
+ * Grows the write streams internal buffer, doubling its size.
  * Mostly used internally by the write functions
  */
 PMH_EXTERN boolean pmhutils_wstream_grow(pmhWstream_t *);
@@ -158,6 +158,14 @@ PMH_EXTERN void pmhutils_wstream_delete(pmhWstream_t *ws, boolean freebuf);
  */
 PMH_EXTERN boolean pmhutils_wstream_write_line(pmhWstream_t *ws, char *line);
 
+/*
+ * Same as pmhutils_wstream_write_line() for a caller that already
+ * knows the length of line. line need not be NULL terminated.
+ */
+PMH_EXTERN boolean pmhutils_wstream_write_line_len(pmhWstream_t *ws,
+                                                   const char *line,
+                                                   uint32_t len);
+
 /*
  * Writes a single character to the output stream.
  * Returns FALSE on failure, TRUE on success.
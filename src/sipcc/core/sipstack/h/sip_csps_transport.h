@@ -72,7 +72,7 @@ void     sip_config_get_proxy_addr(line_t line, char *buffer, int buffer_len);
 uint16_t sip_config_get_backup_proxy_addr(cpr_ip_addr_t *IPAddress,
                                            char *buffer, int buffer_len);
 
-extern sipPlatformUITimer_t sipPlatformUISMTimers[];
+extern sipPlatformUITimer_t *sipPlatformUISMTimers;
 extern ccsipGlobInfo_t gGlobInfo;
 
 extern int dns_error_code; // DNS errror code global
@@ -53,9 +53,20 @@
 
 //#define HTTPISH_DEBUG if (1)
 #define MSG_DELIMIT_SIZE   80
-#define TMP_BODY_BUF_SIZE 200
 #define CMPC_HEADER_SIZE  256
 
+/* Enough for any int32_t in decimal, sign included */
+#define INT_STR_SIZE      12
+
+/* Header nodes carved out of a httpish_hdr_block stay pointer aligned */
+#define HDR_ALIGN(n)      (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define HDR_BLOCK_HDR_SIZE HDR_ALIGN(sizeof(httpish_hdr_block))
+#define HDR_NODE_SIZE      HDR_ALIGN(sizeof(httpish_header))
+
+/* Writes a string literal to a wstream, its length known at compile time */
+#define WSTREAM_WRITE_LITERAL(ws, lit) \
+        pmhutils_wstream_write_bytes((ws), (char *) (lit), sizeof(lit) - 1)
+
 extern sip_header_t sip_cached_headers[];
 httpishMsg_t *
 httpish_msg_create (void)
@@ -169,8 +180,10 @@ httpish_msg_free (httpishMsg_t *msg)
 
         this_header = (httpish_header *) dequeue(msg->headers);
         while (this_header != NULL) {
-            UTILFREE(this_header->header);
-            UTILFREE(this_header);
+            if (!this_header->in_block) {
+                UTILFREE(this_header->header);
+                UTILFREE(this_header);
+            }
             this_header = (httpish_header *) dequeue(msg->headers);
         }
     }
@@ -178,12 +191,24 @@ httpish_msg_free (httpishMsg_t *msg)
     UTILFREE(msg->headers);
     msg->headers = NULL;
 
-    /* Free the header cache */
+    while (msg->hdr_blocks) {
+        httpish_hdr_block *block = msg->hdr_blocks;
+
+        msg->hdr_blocks = block->next;
+        cpr_free(block);
+    }
+
+    /* Free the header cache and what was parsed from it */
     for (i = 0; i < HTTPISH_HEADER_CACHE_SIZE; ++i) {
         if (msg->hdr_cache[i].hdr_start) {
             cpr_free(msg->hdr_cache[i].hdr_start);
         }
     }
+    for (i = 0; i < HTTPISH_PARSED_CACHE_SIZE; ++i) {
+        if (msg->parsed[i].obj && msg->parsed[i].free_fn) {
+            msg->parsed[i].free_fn(msg->parsed[i].obj);
+        }
+    }
 
     /* Free the httpishMsg_t struct itself */
     cpr_free(msg);
@@ -423,77 +448,135 @@ httpish_msg_free_respline (httpishRespLine_t *rspline)
     UTILFREE(rspline->version);
 }
 
-hStatus_t
-httpish_msg_add_text_header (httpishMsg_t *msg,
-                             const char *hname,
-                             const char *hval)
+/*
+ * Formats val the way "%d" would into buf, which must hold
+ * INT_STR_SIZE chars. Returns the number of chars, not NULL terminated.
+ */
+static uint32_t
+httpish_int_to_str (int32_t val, char *buf)
 {
-    uint32_t        linesize = 0;
-    httpish_header *this_header = NULL;
-    char           *header_line = NULL;
+    char     digits[INT_STR_SIZE];
+    uint32_t uval;
+    uint32_t n = 0, len = 0;
 
-    if (!msg || !hname || !hval) {
-        return HSTATUS_FAILURE;
+    if (val < 0) {
+        buf[len++] = '-';
+        uval = 0u - (uint32_t) val;
+    } else {
+        uval = (uint32_t) val;
     }
 
-    linesize = strlen(hname) + 2 + strlen(hval) + 1;
+    do {
+        digits[n++] = (char) ('0' + (uval % 10));
+        uval /= 10;
+    } while (uval);
 
-    header_line = (char *) cpr_malloc(linesize * sizeof(char));
-    if (!header_line)
-        return HSTATUS_FAILURE;
+    while (n) {
+        buf[len++] = digits[--n];
+    }
+    return len;
+}
 
-    this_header = (httpish_header *) cpr_malloc(sizeof(httpish_header));
-    if (!this_header) {
-        cpr_free(header_line);
-        return HSTATUS_FAILURE;
+/*
+ * Takes a header node with room for a line of linelen chars (plus the
+ * NULL) from the message's current header block, chaining a new block
+ * when it is full.
+ */
+static httpish_header *
+httpish_msg_alloc_header (httpishMsg_t *msg, uint32_t linelen)
+{
+    httpish_hdr_block *block = msg->hdr_blocks;
+    httpish_header    *this_header;
+    uint32_t           need = HDR_NODE_SIZE + HDR_ALIGN(linelen + 1);
+    uint32_t           size;
+
+    if (!block || (block->size - block->used) < need) {
+        size = block ? block->size * 2 : HTTPISH_HDR_BLOCK_SIZE;
+        if (size < need) {
+            size = need;
+        }
+        block = (httpish_hdr_block *) cpr_malloc(HDR_BLOCK_HDR_SIZE + size);
+        if (!block) {
+            return NULL;
+        }
+        block->size = size;
+        block->used = 0;
+        block->next = msg->hdr_blocks;
+        msg->hdr_blocks = block;
     }
 
-    snprintf(header_line, linesize, "%s: %s", hname, hval);
+    this_header = (httpish_header *)
+        ((char *) block + HDR_BLOCK_HDR_SIZE + block->used);
+    block->used += need;
 
-    this_header->header = header_line;
     this_header->next = NULL;
+    this_header->header = (char *) this_header + HDR_NODE_SIZE;
+    this_header->len = linelen;
+    this_header->in_block = TRUE;
+
+    return this_header;
+}
+
+/*
+ * Appends "hname: hval" to the headers of msg. hval is val_len chars
+ * long and need not be NULL terminated.
+ */
+static hStatus_t
+httpish_msg_append_header (httpishMsg_t *msg,
+                           const char *hname,
+                           const char *hval,
+                           uint32_t val_len)
+{
+    uint32_t        name_len = strlen(hname);
+    httpish_header *this_header;
+    char           *header_line;
+
+    this_header = httpish_msg_alloc_header(msg, name_len + 2 + val_len);
+    if (!this_header) {
+        return HSTATUS_FAILURE;
+    }
+
+    header_line = this_header->header;
+    memcpy(header_line, hname, name_len);
+    header_line += name_len;
+    *header_line++ = ':';
+    *header_line++ = ' ';
+    memcpy(header_line, hval, val_len);
+    header_line[val_len] = '\0';
 
     enqueue(msg->headers, (void *) this_header);
 
     return HSTATUS_SUCCESS;
 }
 
+hStatus_t
+httpish_msg_add_text_header (httpishMsg_t *msg,
+                             const char *hname,
+                             const char *hval)
+{
+    if (!msg || !hname || !hval) {
+        return HSTATUS_FAILURE;
+    }
+
+    return httpish_msg_append_header(msg, hname, hval, strlen(hval));
+}
+
 
 hStatus_t
 httpish_msg_add_int_header (httpishMsg_t *msg,
                             const char *hname,
                             int32_t hval)
 {
-    uint32_t        linesize = 0;
-    char           *header_line = NULL;
-    httpish_header *this_header = NULL;
+    char     val_str[INT_STR_SIZE];
+    uint32_t val_len;
 
     if (!msg || !hname) {
         return HSTATUS_FAILURE;
     }
 
-    /* Assumes the int is less than 10 characters */
-    linesize = strlen(hname) + 2 + 10 + 1;
-
-    header_line = (char *) cpr_malloc(linesize * sizeof(char));
-    if (!header_line) {
-        return HSTATUS_FAILURE;
-    }
-
-    this_header = (httpish_header *) cpr_malloc(sizeof(httpish_header));
-    if (!this_header) {
-        cpr_free(header_line);
-        return HSTATUS_FAILURE;
-    }
-
-    snprintf(header_line, linesize, "%s: %d", hname, hval);
-
-    this_header->header = header_line;
-    this_header->next = NULL;
-
-    enqueue(msg->headers, (void *) this_header);
+    val_len = httpish_int_to_str(hval, val_str);
 
-    return HSTATUS_SUCCESS;
+    return httpish_msg_append_header(msg, hname, val_str, val_len);
 }
 
 const char *
@@ -659,13 +742,76 @@ httpish_msg_get_content_length (httpishMsg_t *msg)
     return msg->content_length;
 }
 
+/*
+ * Returns the Content-Disposition value written for disp
+ */
+static const char *
+httpish_content_disp_str (uint8_t disp)
+{
+    switch (disp) {
+    case SIP_CONTENT_DISPOSITION_RENDER_VALUE:
+        return SIP_CONTENT_DISPOSITION_RENDER;
+    case SIP_CONTENT_DISPOSITION_SESSION_VALUE:
+    default:
+        return SIP_CONTENT_DISPOSITION_SESSION;
+    case SIP_CONTENT_DISPOSITION_ICON_VALUE:
+        return SIP_CONTENT_DISPOSITION_ICON;
+    case SIP_CONTENT_DISPOSITION_ALERT_VALUE:
+        return SIP_CONTENT_DISPOSITION_ALERT;
+    case SIP_CONTENT_DISPOSITION_PRECONDITION_VALUE:
+        return SIP_CONTENT_DISPOSITION_PRECONDITION;
+    }
+}
+
+#define MULTIPART_FIRST_BOUNDARY  "--" uniqueBoundary "\r\n"
+#define MULTIPART_BOUNDARY        "\r\n--" uniqueBoundary "\r\n"
+#define MULTIPART_LAST_BOUNDARY   "\r\n--" uniqueBoundary "--\r\n"
+#define HANDLING_REQUIRED         ";handling=required\r\n"
+#define HANDLING_OPTIONAL         ";handling=optional\r\n"
+
+/*
+ * Returns the number of bytes httpish_msg_to_wstream writes after the
+ * blank line of a multipart message, for its Content-Length. Has to
+ * follow the writer exactly.
+ */
+static uint32_t
+httpish_multipart_length (httpishMsg_t *msg)
+{
+    uint32_t   total = 0;
+    int        i;
+    msgBody_t *part;
+
+    for (i = 0; i < msg->num_body_parts; i++) {
+        part = &msg->mesg_body[i];
+        total += (i == 0) ? sizeof(MULTIPART_FIRST_BOUNDARY) - 1 :
+                            sizeof(MULTIPART_BOUNDARY) - 1;
+        total += sizeof("Content-Type: ") - 1 +
+                 strlen(part->msgContentType) + 2;
+        total += sizeof("Content-Disposition: ") - 1 +
+                 strlen(httpish_content_disp_str(part->msgContentDisp));
+        total += part->msgRequiredHandling ? sizeof(HANDLING_REQUIRED) - 1 :
+                                             sizeof(HANDLING_OPTIONAL) - 1;
+        if (part->msgContentId) {
+            total += sizeof("Content-Id: ") - 1 +
+                     strlen(part->msgContentId) + 2;
+        }
+        total += 2 + part->msgLength;
+    }
+    total += sizeof(MULTIPART_LAST_BOUNDARY) - 1;
+
+    return total;
+}
+
 static boolean
 httpish_msg_to_wstream (pmhWstream_t *ws,
                         httpishMsg_t *msg)
 {
     nexthelper *p;
-    char        tmp_body_buf[TMP_BODY_BUF_SIZE];
-    int         buf_len, total_length = 0, i, boundary_size;
+    char        len_str[INT_STR_SIZE];
+    uint32_t    len_size;
+    const char *disp;
+    int         i;
+    msgBody_t  *part;
 
     if (!pmhutils_wstream_write_line(ws, msg->mesg_line)) {
         return (FALSE);
@@ -673,8 +819,10 @@ httpish_msg_to_wstream (pmhWstream_t *ws,
 
     p = (nexthelper *) msg->headers->qhead;
     while (p) {
-        if (!pmhutils_wstream_write_line(ws,
-                (char *) (((httpish_header *)p)->header))) {
+        httpish_header *this_header = (httpish_header *) p;
+
+        if (!pmhutils_wstream_write_line_len(ws, this_header->header,
+                                             this_header->len)) {
             return (FALSE);
         }
         p = p->next;
@@ -684,205 +832,76 @@ httpish_msg_to_wstream (pmhWstream_t *ws,
             // Write out the special Content-Type header and the
             // Mime-Version header and the aggregate Content-Length header
             // followed by the unique boundary
-            buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE,
-                               "%s: multipart/mixed; boundary=%s\r\n",
-                               HTTPISH_HEADER_CONTENT_TYPE, uniqueBoundary);
-
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
-                return (FALSE);
-            }
-
-            buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "%s: 1.0\r\n",
-                               HTTPISH_HEADER_MIME_VERSION);
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
-                return (FALSE);
-            }
-
-            // Traverse the list and calculate the total size of the
-            // body
-            boundary_size = strlen("\r\n--\r\n") + strlen(uniqueBoundary);
-            for (i = 0; i < msg->num_body_parts; i++) {
-                total_length += boundary_size;
-                total_length += msg->mesg_body[i].msgLength;
-                total_length += sizeof(HTTPISH_HEADER_CONTENT_TYPE) + 1;
-                switch (msg->mesg_body[i].msgContentTypeValue) {
-                default:
-                case SIP_CONTENT_TYPE_UNKNOWN_VALUE:
-                    total_length += strlen(msg->mesg_body[i].msgContentType) + 2;
-                    break;
-                case SIP_CONTENT_TYPE_SDP_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_SDP) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_SIPFRAG_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_SIPFRAG) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_DIALOG_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_DIALOG) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_KPML_REQUEST_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_KPML_REQUEST) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_KPML_RESPONSE) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_REMOTECC_REQUEST_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_REMOTECC_REQUEST) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_REMOTECC_RESPONSE_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_REMOTECC_RESPONSE) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_CTI_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_CTI) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_CMXML_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_CMXML) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_TEXT_PLAIN_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_TEXT_PLAIN) + 1;
-                    break;
-                case SIP_CONTENT_TYPE_PRESENCE_VALUE:
-                    total_length += sizeof(SIP_CONTENT_TYPE_PRESENCE) + 1;
-                    break;
-                }
-                // Now estimate size of Content-Disposition header
-                total_length += sizeof(SIP_HEADER_CONTENT_DISP) + 1;
-                switch (msg->mesg_body[i].msgContentDisp) {
-                case SIP_CONTENT_DISPOSITION_RENDER_VALUE:
-                    total_length += sizeof(SIP_CONTENT_DISPOSITION_RENDER) - 1;
-                    break;
-                case SIP_CONTENT_DISPOSITION_SESSION_VALUE:
-                default:
-                    total_length += sizeof(SIP_CONTENT_DISPOSITION_SESSION) - 1;
-                    break;
-                case SIP_CONTENT_DISPOSITION_ICON_VALUE:
-                    total_length += sizeof(SIP_CONTENT_DISPOSITION_ICON) - 1;
-                    break;
-                case SIP_CONTENT_DISPOSITION_ALERT_VALUE:
-                    total_length += sizeof(SIP_CONTENT_DISPOSITION_ALERT) - 1;
-                    break;
-                case SIP_CONTENT_DISPOSITION_PRECONDITION_VALUE:
-                    total_length += sizeof(SIP_CONTENT_DISPOSITION_PRECONDITION) - 1;
-                    break;
-                }
-                // Now the handling attribute
-                total_length += sizeof(";handling=") - 1;
-                if (msg->mesg_body[i].msgRequiredHandling) {
-                    total_length += sizeof("required") + 1;
-                } else {
-                    total_length += sizeof("optional") + 1;
-                }
-                // Now the content id
-                if (msg->mesg_body[i].msgContentId) {
-                    total_length += sizeof(HTTPISH_HEADER_CONTENT_ID) + 1 +
-                        strlen(msg->mesg_body[i].msgContentId) + 2;
-
-                }
-            }
-            // Now account for the closing boundary which is 2+boundary_size
-            total_length += 2 + boundary_size + 2;
-
-            // Now write it out
-            buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "%s: %d\r\n",
-                               HTTPISH_HEADER_CONTENT_LENGTH, total_length);
-
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
-                return (FALSE);
-            }
-
-            buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "\r\n--%s\r\n", uniqueBoundary);
-
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
+            len_size = httpish_int_to_str((int32_t)
+                           httpish_multipart_length(msg), len_str);
+            if (!WSTREAM_WRITE_LITERAL(ws, HTTPISH_HEADER_CONTENT_TYPE
+                    ": multipart/mixed; boundary=" uniqueBoundary "\r\n"
+                    HTTPISH_HEADER_MIME_VERSION ": 1.0\r\n"
+                    HTTPISH_HEADER_CONTENT_LENGTH ": ") ||
+                !pmhutils_wstream_write_line_len(ws, len_str, len_size) ||
+                !WSTREAM_WRITE_LITERAL(ws, "\r\n" MULTIPART_FIRST_BOUNDARY)) {
                 return (FALSE);
             }
 
         } else {
             // Write out Content-Length for the first body
-            total_length = msg->mesg_body[0].msgLength;
-            buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "%s: %d\r\n",
-                               HTTPISH_HEADER_CONTENT_LENGTH, total_length);
-
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
+            len_size = httpish_int_to_str((int32_t) msg->mesg_body[0].msgLength,
+                                          len_str);
+            if (!WSTREAM_WRITE_LITERAL(ws, HTTPISH_HEADER_CONTENT_LENGTH ": ") ||
+                !pmhutils_wstream_write_line_len(ws, len_str, len_size)) {
                 return (FALSE);
             }
         }
         for (i = 0; i < msg->num_body_parts; i++) {
+            part = &msg->mesg_body[i];
             if (i > 0) {
                 // If there is another body to come, write the unique boundary
-                buf_len = snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "\r\n--%s\r\n", uniqueBoundary);
-                if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
+                if (!WSTREAM_WRITE_LITERAL(ws, MULTIPART_BOUNDARY)) {
                     return (FALSE);
                 }
             }
-            snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "Content-Type: %s\r\n",
-                    msg->mesg_body[i].msgContentType);
-            strncat(tmp_body_buf, "Content-Disposition: ",
-                    TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-
-            switch (msg->mesg_body[i].msgContentDisp) {
-            case SIP_CONTENT_DISPOSITION_RENDER_VALUE:
-                strncat(tmp_body_buf, SIP_CONTENT_DISPOSITION_RENDER,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                break;
-            case SIP_CONTENT_DISPOSITION_SESSION_VALUE:
-            default:
-                strncat(tmp_body_buf, SIP_CONTENT_DISPOSITION_SESSION,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                break;
-            case SIP_CONTENT_DISPOSITION_ICON_VALUE:
-                strncat(tmp_body_buf, SIP_CONTENT_DISPOSITION_ICON,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                break;
-            case SIP_CONTENT_DISPOSITION_ALERT_VALUE:
-                strncat(tmp_body_buf, SIP_CONTENT_DISPOSITION_ALERT,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                break;
-            case SIP_CONTENT_DISPOSITION_PRECONDITION_VALUE:
-                strncat(tmp_body_buf, SIP_CONTENT_DISPOSITION_PRECONDITION,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                break;
+            disp = httpish_content_disp_str(part->msgContentDisp);
+            if (!WSTREAM_WRITE_LITERAL(ws, "Content-Type: ") ||
+                !pmhutils_wstream_write_line(ws, part->msgContentType) ||
+                !WSTREAM_WRITE_LITERAL(ws, "Content-Disposition: ") ||
+                !pmhutils_wstream_write_bytes(ws, (char *) disp,
+                                              strlen(disp))) {
+                return (FALSE);
             }
-            if (msg->mesg_body[i].msgRequiredHandling) {
-                strncat(tmp_body_buf, ";handling=required\r\n",
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
+            if (part->msgRequiredHandling) {
+                if (!WSTREAM_WRITE_LITERAL(ws, HANDLING_REQUIRED)) {
+                    return (FALSE);
+                }
             } else {
-                strncat(tmp_body_buf, ";handling=optional\r\n",
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
+                if (!WSTREAM_WRITE_LITERAL(ws, HANDLING_OPTIONAL)) {
+                    return (FALSE);
+                }
             }
-            if (msg->mesg_body[i].msgContentId) {
-                strncat(tmp_body_buf, "Content-Id: ",
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                strncat(tmp_body_buf, msg->mesg_body[i].msgContentId,
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-                strncat(tmp_body_buf, "\r\n",
-                        TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
+            if (part->msgContentId) {
+                if (!WSTREAM_WRITE_LITERAL(ws, "Content-Id: ") ||
+                    !pmhutils_wstream_write_line(ws, part->msgContentId)) {
+                    return (FALSE);
+                }
             }
-            strncat(tmp_body_buf, "\r\n",
-                    TMP_BODY_BUF_SIZE - strlen(tmp_body_buf) - 1);
-            buf_len = strlen(tmp_body_buf);
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
+            if (!WSTREAM_WRITE_LITERAL(ws, "\r\n")) {
                 return (FALSE);
             }
 
             // Now write the body
-            if (!pmhutils_wstream_write_bytes(ws, msg->mesg_body[i].msgBody,
-                                              msg->mesg_body[i].msgLength)) {
+            if (!pmhutils_wstream_write_bytes(ws, part->msgBody,
+                                              part->msgLength)) {
                 return (FALSE);
             }
         }
         // After writing out the last body part, write out the last unique
         // boundary line
         if (msg->num_body_parts > 1) {
-            snprintf(tmp_body_buf, TMP_BODY_BUF_SIZE, "\r\n--%s--\r\n", uniqueBoundary);
-            buf_len = strlen(tmp_body_buf);
-            if (!pmhutils_wstream_write_bytes(ws, tmp_body_buf, buf_len)) {
+            if (!WSTREAM_WRITE_LITERAL(ws, MULTIPART_LAST_BOUNDARY)) {
                 return (FALSE);
             }
         }
     } else {
-        if (!pmhutils_wstream_write_byte(ws, '\r')) {
-            return (FALSE);
-        }
-        if (!pmhutils_wstream_write_byte(ws, '\n')) {
+        if (!WSTREAM_WRITE_LITERAL(ws, "\r\n")) {
             return (FALSE);
         }
     }
@@ -1358,6 +1377,8 @@ httpish_msg_process_network_msg (httpishMsg_t *hmsg,
 
                 h->next = NULL;
                 h->header = this_header;
+                h->len = strlen(this_header);
+                h->in_block = FALSE;
                 enqueue(hmsg->headers, (void *)h);
             }
 
@@ -240,17 +240,24 @@ pmhutils_wstream_delete (pmhWstream_t *pmhWstream, boolean freebuf)
 boolean
 pmhutils_wstream_write_line (pmhWstream_t *pmhWstream, char *this_line)
 {
-
-    /* Sanity check */
-    if (this_line == NULL || strlen(this_line) > SANITY_LINE_SIZE) {
+    if (this_line == NULL) {
         return FALSE;
     }
 
-    if (!(pmhWstream && this_line)) {
+    return pmhutils_wstream_write_line_len(pmhWstream, this_line,
+                                           strlen(this_line));
+}
+
+boolean
+pmhutils_wstream_write_line_len (pmhWstream_t *pmhWstream,
+                                 const char *this_line, uint32_t len)
+{
+    /* Sanity check */
+    if (!(pmhWstream && this_line) || len > SANITY_LINE_SIZE) {
         return FALSE;
     }
 
-    while ((pmhWstream->nbytes + (int32_t)strlen(this_line)) >
+    while ((pmhWstream->nbytes + (int32_t) len + 2) >
             pmhWstream->total_bytes) {
         if (!pmhWstream->growable ||
             (FALSE == pmhutils_wstream_grow(pmhWstream))) {
@@ -258,17 +265,10 @@ pmhutils_wstream_write_line (pmhWstream_t *pmhWstream, char *this_line)
         }
     }
 
-    memcpy(&pmhWstream->buff[pmhWstream->nbytes], this_line,
-           strlen(this_line));
-
-    pmhWstream->nbytes += strlen(this_line);
-    if (!pmhutils_wstream_write_byte(pmhWstream, '\r')) {
-        return FALSE;
-    }
-     
-    if (!pmhutils_wstream_write_byte(pmhWstream, '\n')) { 
-        return FALSE;
-    }
+    memcpy(&pmhWstream->buff[pmhWstream->nbytes], this_line, len);
+    pmhWstream->nbytes += len;
+    pmhWstream->buff[pmhWstream->nbytes++] = '\r';
+    pmhWstream->buff[pmhWstream->nbytes++] = '\n';
 
     return TRUE;
 }
@@ -320,24 +320,28 @@ boolean
 pmhutils_wstream_grow (pmhWstream_t *pmhWstream)
 {
     char *newbuf;
+    int32_t new_size;
 
     if (!pmhWstream || !pmhWstream->buff || !pmhWstream->growable) {
         return FALSE;
     }
 
-    newbuf = (char *) cpr_realloc((void *) pmhWstream->buff,
-                                  pmhWstream->total_bytes + WSTREAM_START_SIZE);
+    /* Double rather than step, so a large message costs log(n) reallocs */
+    new_size = pmhWstream->total_bytes * 2;
+    if (new_size < WSTREAM_START_SIZE) {
+        new_size = WSTREAM_START_SIZE;
+    }
+
+    newbuf = (char *) cpr_realloc((void *) pmhWstream->buff, new_size);
     if (newbuf == NULL) {
-        if ((pmhWstream->total_bytes + WSTREAM_START_SIZE) != 0) {
-            cpr_free(pmhWstream->buff);
-        }
+        cpr_free(pmhWstream->buff);
         pmhWstream->buff = NULL;
         return FALSE;
     }
 
     pmhWstream->buff = newbuf;
 
-    pmhWstream->total_bytes += WSTREAM_START_SIZE;
+    pmhWstream->total_bytes = new_size;
 
     return TRUE;
 }
@@ -90,14 +90,17 @@ ccm_failover_table_t CCM_Failover_Table;
 ccm_fallback_table_t CCM_Fallback_Table;
 cc_config_table_t CC_Config_Table[MAX_REG_LINES + 1];
 typedef struct fallback_line_num_t_ {
-    line_t line;
     boolean available;
 } fallback_line_num_t;
 
+/*
+ * Fallback ccbs are numbered right after the last regular ccb, so entry
+ * ndx of this table stands for line MAX_CCBS + ndx.
+ */
 static fallback_line_num_t fallback_lines_available[MAX_CCM - 1] =
 {
-    {MAX_CCBS,     TRUE},
-    {MAX_CCBS + 1, TRUE},
+    {TRUE},
+    {TRUE},
 };
 
 static void sip_regmgr_update_call_ccb(void);
@@ -334,7 +337,7 @@ sip_regmgr_get_fallback_line_num ()
     for (ndx = 0; ndx < (MAX_CCM - 1); ndx++) {
         if (fallback_lines_available[ndx].available) {
             fallback_lines_available[ndx].available = FALSE;
-            line = fallback_lines_available[ndx].line;
+            line = (line_t) (MAX_CCBS + ndx);
             break;
         }
     }
@@ -54,6 +54,7 @@
 #include "ccsip_task.h"
 #include "ccsip_messaging.h"
 #include "ccsip_reldev.h"
+#include "ccsip_trx.h"
 #include "sip_common_transport.h"
 #include "sip_csps_transport.h"
 #include "sip_ccm_transport.h"
@@ -68,6 +69,7 @@
 #include "ccsip_platform_tls.h"
 #include "platform_api.h"
 #include "sessionTypes.h"
+#include "cc_shutdown.h"
 
 uint16_t ccm_config_id_addr_str[MAX_CCM] = {
     CFGID_CCM1_ADDRESS,
@@ -119,7 +121,7 @@ char callid_string[] = " CallId:";
 
 static cpr_socket_t listen_socket = INVALID_SOCKET;
 extern cc_config_table_t CC_Config_Table[];
-extern sipCallHistory_t gCallHistory[];
+extern sipCallHistory_t *gCallHistory;
 extern ccm_act_stdby_table_t CCM_Active_Standby_Table;
 
 //extern uint16_t ccm_config_id_addr_str[MAX_CCM];
@@ -713,6 +715,38 @@ sip_transport_destroy_cc_conn (line_t dn, CCM_ID ccm_id)
     return (disconnect_status);
 }
 
+/*
+ * While a shutdown is draining, the requests whose answers it waits for:
+ * REGISTER, BYE and SUBSCRIBE with Expires 0. Returns
+ * CC_SHUTDOWN_TXN_MAX for anything else.
+ */
+static cc_shutdown_txn_e
+sipTransportShutdownTxnType (sipMessage_t *pSIPMessage,
+                             sipMethod_t message_type)
+{
+    const char *expires;
+
+    /* sippmh_is_request() only answers for parsed messages */
+    if (!cc_shutdown_tracking_txns() || pSIPMessage->mesg_line == NULL ||
+        strncmp(pSIPMessage->mesg_line, SIP_SCHEMA, SIP_SCHEMA_LEN) == 0) {
+        return CC_SHUTDOWN_TXN_MAX;
+    }
+    switch (message_type) {
+    case sipMethodRegister:
+        return CC_SHUTDOWN_TXN_REGISTER;
+    case sipMethodBye:
+        return CC_SHUTDOWN_TXN_BYE;
+    case sipMethodSubscribe:
+        expires = sippmh_get_header_val(pSIPMessage, SIP_HEADER_EXPIRES, NULL);
+        if (expires && strtoul(expires, NULL, 10) == 0) {
+            return CC_SHUTDOWN_TXN_UNSUBSCRIBE;
+        }
+        return CC_SHUTDOWN_TXN_MAX;
+    default:
+        return CC_SHUTDOWN_TXN_MAX;
+    }
+}
+
 /*
  ** sipTransportCreateSendMessage
  *
@@ -750,6 +784,9 @@ sipTransportCreateSendMessage (ccsipCCB_t *ccb,
     static char aOutBuf[SIP_UDP_MESSAGE_SIZE + 1];
     uint32_t    nbytes = SIP_UDP_MESSAGE_SIZE;
     hStatus_t   sippmh_write_status = STATUS_FAILURE;
+    cc_shutdown_txn_e shutdown_txn;
+    char        shutdown_call_id[MAX_SIP_CALL_ID];
+    uint32_t    shutdown_cseq = 0;
 
     /*
      * Check args
@@ -775,6 +812,23 @@ sipTransportCreateSendMessage (ccsipCCB_t *ccb,
     ccsip_dump_send_msg_info(aOutBuf, pSIPMessage, cc_remote_ipaddr,
                             cc_remote_port);
 
+    shutdown_txn = sipTransportShutdownTxnType(pSIPMessage, message_type);
+    if (shutdown_txn != CC_SHUTDOWN_TXN_MAX) {
+        /* an outgoing message has no header cache, look the values up */
+        const char *call_id = sippmh_get_header_val(pSIPMessage,
+                                                    SIP_HEADER_CALLID,
+                                                    SIP_C_HEADER_CALLID);
+        const char *cseq = sippmh_get_header_val(pSIPMessage,
+                                                 SIP_HEADER_CSEQ, NULL);
+
+        if (call_id && cseq) {
+            sstrncpy(shutdown_call_id, call_id, sizeof(shutdown_call_id));
+            shutdown_cseq = strtoul(cseq, NULL, 10);
+        } else {
+            shutdown_txn = CC_SHUTDOWN_TXN_MAX;
+        }
+    }
+
     free_sip_message(pSIPMessage);
     if (sippmh_write_status == STATUS_FAILURE) {
         CCSIP_DEBUG_ERROR(get_debug_string(DEBUG_SIP_FUNCTIONCALL_FAILED),
@@ -804,6 +858,10 @@ sipTransportCreateSendMessage (ccsipCCB_t *ccb,
         return (-1);
     }
 
+    if (shutdown_txn != CC_SHUTDOWN_TXN_MAX) {
+        cc_shutdown_txn_sent(shutdown_txn, shutdown_call_id, shutdown_cseq);
+    }
+
     return (0);
 }
 
@@ -1120,6 +1178,21 @@ sipTransportSendMessage (ccsipCCB_t *ccb,
     }
 
     if (ccb) {
+        boolean unreliable = (!cpr_strcasecmp(conn_type, "UDP") ||
+                              ((tcp_error == CPR_ENOTCONN) &&
+                               (!cpr_strcasecmp(conn_type, "TCP"))));
+
+        /*
+         * Non-INVITE transactions retransmit on their own timers and
+         * must not disturb the message held in the call's reTx slot.
+         */
+        if (reTx && sip_trx_message_sent(ccb->index, message_type,
+                                         pOutMessageBuf, nbytes,
+                                         cc_remote_ipaddr, cc_remote_port,
+                                         !unreliable, timeout)) {
+            reTx = FALSE;
+        }
+
         //
         // Cancel any outstanding reTx timers, if any
         //
@@ -1140,8 +1213,7 @@ sipTransportSendMessage (ccsipCCB_t *ccb,
              * during next retry.
              * 
              */
-            if ((timeout > 0) && ((!cpr_strcasecmp(conn_type, "UDP")
-                || ((tcp_error == CPR_ENOTCONN) && (!cpr_strcasecmp(conn_type, "TCP")))))) {
+            if ((timeout > 0) && unreliable) {
                 void *data;
 
                 data = isRegister ? (void *) ccb : (void *)(long)ccb->index;
@@ -1172,6 +1244,14 @@ sipTransportSendMessage (ccsipCCB_t *ccb,
         ccsip_publish_cb_t *pcb_p = (ccsip_publish_cb_t *)cbp;
         sipTCB_t *tcbp = (sipTCB_t *)cbp;
 
+        /* the ACK for a failed INVITE is resent by the transaction layer */
+        if (message_type == sipMethodAck) {
+            sip_trx_ack_sent(pOutMessageBuf, nbytes,
+                             cc_remote_ipaddr, cc_remote_port,
+                             (conn_type != NULL) &&
+                             cpr_strcasecmp(conn_type, "UDP"));
+        }
+
         if (cbp != NULL) {
             sipPlatformUITimer_t *timer = NULL;
             uint32_t id = 0;
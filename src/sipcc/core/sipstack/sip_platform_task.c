@@ -56,6 +56,7 @@
 #include "ccsip_platform_tcp.h"
 #include "ccsip_task.h"
 #include "sip_socket_api.h"
+#include "cc_latency.h"
 
 /*---------------------------------------------------------
  *
@@ -239,10 +240,10 @@ void sip_platform_task_msgqwait (void *arg)
     const char    *fname = "sip_platform_task_msgqwait";
     cprMsgQueue_t *msgq = (cprMsgQueue_t *)arg;
     unsigned int  wait_main_thread = 0;
-    phn_syshdr_t  *syshdr;
-    void          *msg;
+    cprMsgBatchEntry_t batch[MAX_SIP_MESSAGES];
     uint8_t       num_messages = 0;
     uint8_t       response = 0;
+    uint8_t       i;
 
     if (msgq == NULL) {
         CCSIP_DEBUG_ERROR(SIP_F_PREFIX"task msgq is null, exiting\n", fname);
@@ -295,30 +296,18 @@ void sip_platform_task_msgqwait (void *arg)
     }
 
     while (TRUE) {
-        msg = cprGetMessage(msgq, TRUE, (void **) &syshdr);
-        while (msg != NULL) {
-            /*
-             * There is a message to be forwarded to the main SIP
-             * thread for processing.
-             */
-            sip_int_msgq_buf[num_messages].msg    = msg;
-            sip_int_msgq_buf[num_messages].syshdr = syshdr;
-            num_messages++;
-            if (num_messages == MAX_SIP_MESSAGES) {
-                /*
-                 * Limit the number of messages passed to the main SIP
-                 * thread to MAX_SIP_MESSAGES since SIP main thread only
-                 * process messages up to MAX_SIP_MESSAGES at a time.
-                 */
-                break;
-            }
-            /*
-             * Check to see if there is more message on the queue
-             * before sending IPC message trigger to the main SIP
-             * thread. This is to minimize the overhead of the
-             * the main SIP thread in processing select().
-             */
-            msg = cprGetMessage(msgq, 0, (void **) &syshdr);
+        /*
+         * Take everything already queued, up to MAX_SIP_MESSAGES since
+         * the main SIP thread only processes that many at a time, before
+         * sending the IPC trigger. This minimizes the overhead of the
+         * main SIP thread in processing select(). Timer expirations are
+         * on the control lane so they come out first.
+         */
+        num_messages = (uint8_t) cprGetMessageBatch(msgq, TRUE, batch,
+                                                    MAX_SIP_MESSAGES);
+        for (i = 0; i < num_messages; i++) {
+            sip_int_msgq_buf[i].msg    = batch[i].msg;
+            sip_int_msgq_buf[i].syshdr = (phn_syshdr_t *) batch[i].usrPtr;
         }
 
         if (num_messages) {
@@ -392,8 +381,10 @@ static void sip_process_int_msg (void)
         msg    = int_msg->msg;
         syshdr = int_msg->syshdr;
         if (msg != NULL && syshdr != NULL) {
+            cc_latency_begin(CC_LATENCY_QUEUE_SIP, syshdr);
             SIPTaskProcessListEvent(syshdr->Cmd, msg, syshdr->Usr.UsrPtr,
                 syshdr->Len);
+            cc_latency_end(CC_LATENCY_QUEUE_SIP);
             cprReleaseSysHeader(syshdr);
 
             int_msg->msg    = NULL;
@@ -56,6 +56,7 @@
 #include "util_string.h"
 #include "ccsip_platform_tcp.h"
 #include "ccsip_task.h"
+#include "cc_latency.h"
 
 /*---------------------------------------------------------
  *
@@ -269,7 +270,9 @@ sip_platform_task_loop (void *arg)
                 cmd = syshdr->Cmd;
                 len = syshdr->Len;
                 usr = syshdr->Usr.UsrPtr;
+                cc_latency_begin(CC_LATENCY_QUEUE_SIP, syshdr);
                 SIPTaskProcessListEvent(cmd, msg, usr, len);
+                cc_latency_end(CC_LATENCY_QUEUE_SIP);
                 cprReleaseSysHeader(syshdr);
                 syshdr = NULL;
             } else {
@@ -188,7 +188,7 @@ MatchLineNumber (const line_t templateLine, const line_t line)
 }
 
 /*
- *  Function: MatchDialTemplate()
+ *  Function: MatchDialTemplateLinear()
  *
  *  Parameters: pattern - pattern string to match
  *              line    - line number to match
@@ -202,18 +202,20 @@ MatchLineNumber (const line_t templateLine, const line_t line)
  *                          (May be NULL to not get a routemode)
  *              tone - pointer to location to hold tone returned
  *
- *  Description: Find the best template to match a pattern
+ *  Description: Find the best template to match a pattern by running it
+ *               through every template. MatchDialTemplate() gives the same
+ *               answer from the compiled dial plan.
  *
  *  Returns: DialMatchAction
  */
 DialMatchAction
-MatchDialTemplate (const char *pattern,
-                   const line_t line,
-                   int *timeout,
-                   char *rewrite,
-                   int rewritelen,
-                   RouteMode *pRouteMode,
-                   vcm_tones_t *pTone)
+MatchDialTemplateLinear (const char *pattern,
+                         const line_t line,
+                         int *timeout,
+                         char *rewrite,
+                         int rewritelen,
+                         RouteMode *pRouteMode,
+                         vcm_tones_t *pTone)
 {
     DialMatchAction result = DIAL_NOMATCH;
     struct DialTemplate *ptempl = basetemplate;
@@ -660,6 +662,851 @@ MatchDialTemplate (const char *pattern,
 }
 
 
+/*
+ * Compiled dial plan
+ *
+ * MatchDialTemplateLinear() runs the whole dialed string through every
+ * template, and dp_check_dialplan() calls it on every key press, so the
+ * cost of a key press grows with both the template count and the number
+ * of digits already dialed. When the dial plan is parsed the templates are
+ * compiled into a deterministic automaton over the dialed characters
+ * instead. A state holds where every template's match stands after some
+ * dialed string (templates that can no longer affect the answer are
+ * dropped, and strings that leave every template in the same place share
+ * a state), together with the answer MatchDialTemplateLinear() gives there
+ * for each group of lines. Matching is then one table step per character,
+ * and a DialPlanCursor carries the walk from one key press to the next so
+ * that a key press costs a single step.
+ *
+ * Only the characters a keypad produces (0-9, '*', '#', '+') are compiled,
+ * and with pound dialing nothing after the '#' that says dial now: there
+ * every template has stopped and each further digit would add a state the
+ * size of the plan. A string that goes beyond that, or holds anything
+ * else, or a plan whose automaton would not fit in DIALPLAN_MAX_STATES
+ * states, is matched by MatchDialTemplateLinear().
+ * So is a match that asks for the rewrite: the rewrite buffer carries over
+ * from one adopted template to the next, and it is asked for once per call
+ * rather than per key press.
+ */
+#define DIALPLAN_SYMBOLS       13
+#define DIALPLAN_MAX_STATES    0xFFFE
+#define DIALPLAN_MAX_ENTRIES   0x80000
+#define DIALPLAN_MAX_TEMPLATES 0x7FFF
+#define DIALPLAN_NO_STATE      0xFFFF
+
+/* DialTemplateState flags */
+#define DPT_IN_STAR    0x01     /* inside the '*' at pos */
+#define DPT_DIALNOW    0x02     /* a '#' asked to dial now */
+#define DPT_STOPPED    0x04     /* a '#' ended the match at pos */
+#define DPT_FAILED     0x08     /* mismatch at pos */
+#define DPT_AT_COMMA   0x10     /* the mismatch was on a ',' */
+
+/* DialPlanState flags, the ones beyond POUND only with pound dialing */
+#define DPS_POUND      0x01     /* '#' is the dial now character */
+#define DPS_HAS_POUND  0x02     /* a '#' has been dialed */
+#define DPS_ENDS_POUND 0x04     /* the last character dialed was '#' */
+
+/* DialPlanResult flags */
+#define DPR_TIMEOUT_BEST    0x01    /* timeout from the best template */
+#define DPR_TIMEOUT_DEFAULT 0x02    /* DIAL_TIMEOUT if the timeout is 0 */
+#define DPR_TIMEOUT_ZERO    0x04    /* timeout of 0 */
+#define DPR_ROUTE           0x08    /* route mode from the best template */
+#define DPR_TONE            0x10    /* give tone */
+
+/*
+ * One template's match of the dialed string so far: the state of the
+ * template loop in MatchDialTemplateLinear(), a character at a time.
+ */
+typedef struct {
+    uint16_t tmpl;              /* index into dp_automaton.templates */
+    int16_t pos;                /* pattern position */
+    int16_t matchlen;           /* exact characters matched */
+    uint8_t type;               /* DialMatchAction of the match so far */
+    uint8_t commas;             /* dial tone points passed */
+    uint8_t flags;              /* DPT_ */
+    uint8_t unused;
+} DialTemplateState;
+
+typedef struct {
+    uint32_t first;             /* first entry in dp_automaton.entries */
+    uint16_t count;
+    uint8_t flags;              /* DPS_ */
+    uint16_t next[DIALPLAN_SYMBOLS];    /* DIALPLAN_NO_STATE if not compiled */
+} DialPlanState;
+
+/* What MatchDialTemplateLinear() returns for a state and line */
+typedef struct {
+    uint8_t action;             /* DialMatchAction */
+    uint8_t flags;              /* DPR_ */
+    uint8_t tone;               /* vcm_tones_t when DPR_TONE */
+    uint8_t unused;
+    int16_t best;               /* template for the timeout and route */
+} DialPlanResult;
+
+typedef struct {
+    uint32_t generation;        /* 0 when not compiled */
+    const struct DialTemplate **templates;
+    uint16_t ntemplates;
+    line_t *lines;              /* line of each result column after the first */
+    uint16_t ncolumns;          /* column 0 is every other line */
+    DialPlanState *states;
+    uint32_t nstates;
+    uint32_t maxstates;
+    DialTemplateState *entries;
+    uint32_t nentries;
+    uint32_t maxentries;
+    DialPlanResult *results;    /* nstates rows of ncolumns */
+    uint32_t *hash;             /* state + 1 by key, while compiling */
+    uint32_t hashsize;
+    uint16_t root[2];           /* by pound dialing */
+} DialPlanAutomaton;
+
+static DialPlanAutomaton dp_automaton;
+static uint32_t dp_generation;
+
+static int
+DialSymbol (char c)
+{
+    if ((c >= '0') && (c <= '9')) {
+        return (c - '0');
+    }
+    switch (c) {
+    case '*':
+        return 10;
+    case '#':
+        return 11;
+    case '+':
+        return 12;
+    default:
+        return -1;
+    }
+}
+
+static const char dial_symbols[DIALPLAN_SYMBOLS] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '*', '#', '+'
+};
+
+/*
+ *  Function: StepTemplateState()
+ *
+ *  Parameters: pat   - template pattern
+ *              e     - the template's match so far, updated
+ *              c     - next dialed character
+ *              pound - TRUE when '#' is the dial now character
+ *
+ *  Description: One pass of the template loop in
+ *               MatchDialTemplateLinear(). A '*' is held open
+ *               (DPT_IN_STAR) until the character that follows it in the
+ *               pattern, or a dial now '#', is dialed.
+ *
+ *  Returns: FALSE if the template can no longer affect the match
+ */
+static boolean
+StepTemplateState (const char *pat, DialTemplateState *e, char c,
+                   boolean pound)
+{
+    int p = e->pos;
+
+    if (e->flags & (DPT_STOPPED | DPT_FAILED)) {
+        return TRUE;
+    }
+
+    if (e->flags & DPT_IN_STAR) {
+        char look = pat[p + ((pat[p + 1] == DIAL_ESCAPE) ? 2 : 1)];
+
+        if ((c != look) && !((c == '#') && pound)) {
+            return TRUE;
+        }
+        e->flags &= ~DPT_IN_STAR;
+        p++;
+    }
+
+    if (pat[p] == ',') {
+        e->commas++;
+        while (pat[p] == ',') {
+            p++;
+        }
+    }
+
+    if ((pat[p] == '.') && !((c == '#') && pound)) {
+        e->type = DIAL_FULLPATTERN;
+        p++;
+    } else if (pat[p] == '*') {
+        e->type = DIAL_WILDPATTERN;
+        if ((c == '#') && pound) {
+            e->flags |= DPT_DIALNOW;
+            p++;
+        } else {
+            e->flags |= DPT_IN_STAR;
+        }
+    } else {
+        if ((pat[p] == DIAL_ESCAPE) && (pat[p + 1] != '\0')) {
+            p++;
+        }
+        if (pat[p] != c) {
+            if ((c == '#') && pound) {
+                e->flags |= DPT_DIALNOW | DPT_STOPPED;
+            } else if (pat[p] == ',') {
+                /*
+                 * A failed template only matters for the dial tone it
+                 * gives when it stopped on a ','
+                 */
+                e->flags |= DPT_FAILED | DPT_AT_COMMA;
+            } else {
+                return FALSE;
+            }
+        } else {
+            e->matchlen++;
+            p++;
+        }
+    }
+    e->pos = (int16_t) p;
+    return TRUE;
+}
+
+static uint32_t
+HashDialPlanState (uint8_t flags, const DialTemplateState *e, uint16_t count)
+{
+    const uint8_t *byte = (const uint8_t *) e;
+    size_t len = count * sizeof(DialTemplateState);
+    uint32_t h = 2166136261U ^ flags;
+
+    while (len--) {
+        h = (h ^ *byte++) * 16777619U;
+    }
+    return h;
+}
+
+static boolean
+GrowDialPlanHash (void)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    uint32_t size = dp->hashsize ? dp->hashsize * 2 : 1024;
+    uint32_t *hash = (uint32_t *) cpr_calloc(size, sizeof(uint32_t));
+    uint32_t i;
+
+    if (hash == NULL) {
+        return FALSE;
+    }
+    for (i = 0; i < dp->nstates; i++) {
+        DialPlanState *s = &dp->states[i];
+        uint32_t h = HashDialPlanState(s->flags, &dp->entries[s->first],
+                                       s->count);
+
+        while (hash[h & (size - 1)] != 0) {
+            h++;
+        }
+        hash[h & (size - 1)] = i + 1;
+    }
+    cpr_free(dp->hash);
+    dp->hash = hash;
+    dp->hashsize = size;
+    return TRUE;
+}
+
+/*
+ *  Function: InternDialPlanState()
+ *
+ *  Parameters: flags - DPS_ flags of the state
+ *              first - the state's entries, at the end of the entry pool
+ *              count - number of entries
+ *
+ *  Description: Find the state with these flags and entries, adding it if
+ *               there is none. The entries are given back to the pool when
+ *               the state already exists.
+ *
+ *  Returns: state index, or -1 if the automaton is full
+ */
+static int32_t
+InternDialPlanState (uint8_t flags, uint32_t first, uint16_t count)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    const DialTemplateState *e = &dp->entries[first];
+    uint32_t h = HashDialPlanState(flags, e, count);
+    DialPlanState *s;
+    int i;
+
+    while (dp->hash[h & (dp->hashsize - 1)] != 0) {
+        s = &dp->states[dp->hash[h & (dp->hashsize - 1)] - 1];
+        if ((s->flags == flags) && (s->count == count) &&
+            (memcmp(&dp->entries[s->first], e,
+                    count * sizeof(DialTemplateState)) == 0)) {
+            dp->nentries = first;
+            return (int32_t) (s - dp->states);
+        }
+        h++;
+    }
+
+    if (dp->nstates == DIALPLAN_MAX_STATES) {
+        return -1;
+    }
+    if (dp->nstates == dp->maxstates) {
+        uint32_t max = dp->maxstates ? dp->maxstates * 2 : 256;
+        DialPlanState *states;
+
+        if (max > DIALPLAN_MAX_STATES) {
+            max = DIALPLAN_MAX_STATES;
+        }
+        /* cpr_realloc() does not allocate for a NULL pointer */
+        if (dp->states == NULL) {
+            states = (DialPlanState *)
+                cpr_malloc(max * sizeof(DialPlanState));
+        } else {
+            states = (DialPlanState *)
+                cpr_realloc(dp->states, max * sizeof(DialPlanState));
+        }
+        if (states == NULL) {
+            return -1;
+        }
+        dp->states = states;
+        dp->maxstates = max;
+    }
+    s = &dp->states[dp->nstates];
+    s->first = first;
+    s->count = count;
+    s->flags = flags;
+    for (i = 0; i < DIALPLAN_SYMBOLS; i++) {
+        s->next[i] = DIALPLAN_NO_STATE;
+    }
+    dp->hash[h & (dp->hashsize - 1)] = ++dp->nstates;
+
+    if ((dp->nstates * 2 > dp->hashsize) && !GrowDialPlanHash()) {
+        return -1;
+    }
+    return (int32_t) (dp->nstates - 1);
+}
+
+/*
+ * Room in the entry pool for one more state of every template
+ */
+static boolean
+ReserveDialPlanEntries (void)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    uint32_t need = dp->nentries + dp->ntemplates;
+    uint32_t max;
+    DialTemplateState *entries;
+
+    if (need <= dp->maxentries) {
+        return TRUE;
+    }
+    if (need > DIALPLAN_MAX_ENTRIES) {
+        return FALSE;
+    }
+    max = dp->maxentries ? dp->maxentries * 2 : 4096;
+    while (max < need) {
+        max *= 2;
+    }
+    if (max > DIALPLAN_MAX_ENTRIES) {
+        max = DIALPLAN_MAX_ENTRIES;
+    }
+    if (dp->entries == NULL) {
+        entries = (DialTemplateState *)
+            cpr_malloc(max * sizeof(DialTemplateState));
+    } else {
+        entries = (DialTemplateState *)
+            cpr_realloc(dp->entries, max * sizeof(DialTemplateState));
+    }
+    if (entries == NULL) {
+        return FALSE;
+    }
+    dp->entries = entries;
+    dp->maxentries = max;
+    return TRUE;
+}
+
+/*
+ *  Function: EvaluateDialPlanState()
+ *
+ *  Parameters: s    - state
+ *              line - line to match
+ *              r    - returned result
+ *
+ *  Description: The template selection of MatchDialTemplateLinear(), made
+ *               on the template matches held in a state
+ *
+ *  Returns: None
+ */
+static void
+EvaluateDialPlanState (const DialPlanState *s, line_t line, DialPlanResult *r)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    DialMatchAction result = DIAL_NOMATCH;
+    int best = -1;
+    boolean bestmatch_dialnow = FALSE;
+    int best_comma_count = 0;
+    DialMatchAction partialmatch_type = DIAL_NOMATCH;
+    boolean partialmatch = FALSE;
+    int matchlen = 0;
+    int partialmatchlen = 0;
+    int givedialtone = 0;
+    uint16_t i;
+
+    r->flags = 0;
+    r->tone = 0;
+    r->unused = 0;
+
+    for (i = 0; i < s->count; i++) {
+        const DialTemplateState *e = &dp->entries[s->first + i];
+        const struct DialTemplate *ptempl = dp->templates[e->tmpl];
+        boolean failed = (e->flags & DPT_FAILED) ? TRUE : FALSE;
+        boolean dialnow = (e->flags & DPT_DIALNOW) ? TRUE : FALSE;
+        int thismatchlen = failed ? -1 : e->matchlen;
+        DialMatchAction thismatch = failed ? DIAL_NOMATCH :
+            (DialMatchAction) e->type;
+        char pmatch = ptempl->pattern[e->pos +
+                                      ((e->flags & DPT_IN_STAR) ? 1 : 0)];
+
+        if (!MatchLineNumber(ptempl->line, line)) {
+            continue;
+        }
+
+        /* The whole string was consumed, or a '#' asked to dial now */
+        if (!(e->flags & (DPT_STOPPED | DPT_FAILED)) || dialnow) {
+            if ((thismatchlen > partialmatchlen) ||
+                ((thismatchlen == partialmatchlen) &&
+                 (thismatch > partialmatch_type))) {
+                partialmatch_type = thismatch;
+                partialmatchlen = thismatchlen;
+                best = e->tmpl;
+                partialmatch = TRUE;
+                bestmatch_dialnow = dialnow;
+                best_comma_count = e->commas;
+                result = DIAL_NOMATCH;
+            }
+        }
+
+        if (pmatch == '\0') {
+            if ((thismatchlen > matchlen) ||
+                ((thismatchlen == matchlen) && (thismatch > result)) ||
+                ((thismatch == DIAL_WILDPATTERN) &&
+                 ((result == DIAL_NOMATCH) && (partialmatch == FALSE)))) {
+                best = e->tmpl;
+                bestmatch_dialnow = dialnow;
+                matchlen = thismatchlen;
+                result = thismatch;
+            }
+        } else if (pmatch == ',') {
+            givedialtone = 1;
+        }
+
+        if (thismatchlen > matchlen) {
+            matchlen = thismatchlen;
+        }
+    }
+
+    switch (result) {
+    case DIAL_FULLPATTERN:
+    case DIAL_FULLMATCH:
+        givedialtone = 0;
+        /* FALLTHROUGH */
+    case DIAL_WILDPATTERN:
+        r->flags |= DPR_TIMEOUT_BEST | DPR_ROUTE;
+        break;
+
+    default:
+        if (partialmatch) {
+            r->flags |= DPR_TIMEOUT_DEFAULT;
+        } else if (s->flags & DPS_ENDS_POUND) {
+            result = DIAL_IMMEDIATELY;
+        }
+        break;
+    }
+
+    if (bestmatch_dialnow) {
+        if (!((s->flags & DPS_HAS_POUND) && partialmatch)) {
+            result = DIAL_IMMEDIATELY;
+            r->flags |= DPR_TIMEOUT_ZERO;
+        }
+    }
+
+    if (givedialtone) {
+        r->flags |= DPR_TONE;
+        r->tone = VCM_DEFAULT_TONE;
+        if (best >= 0) {
+            const struct DialTemplate *ptempl = dp->templates[best];
+
+            if (best_comma_count < ptempl->tones_defined) {
+                r->tone = (uint8_t) ptempl->tone[best_comma_count];
+            }
+        }
+        result = DIAL_GIVETONE;
+    }
+
+    r->action = (uint8_t) result;
+    r->best = (int16_t) best;
+}
+
+/*
+ *  Function: FreeCompiledDialPlan()
+ *
+ *  Parameters: None
+ *
+ *  Description: Frees the compiled dial plan. Matching falls back to
+ *               MatchDialTemplateLinear() until the plan is compiled again.
+ *
+ *  Returns: None
+ */
+static void
+FreeCompiledDialPlan (void)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+
+    cpr_free(dp->templates);
+    cpr_free(dp->lines);
+    cpr_free(dp->states);
+    cpr_free(dp->entries);
+    cpr_free(dp->results);
+    cpr_free(dp->hash);
+    memset(dp, 0, sizeof(*dp));
+}
+
+/*
+ *  Function: CompileDialTemplates()
+ *
+ *  Parameters: None
+ *
+ *  Description: Build the automaton for the current templates, breadth
+ *               first from the empty string with and without pound dialing
+ *
+ *  Returns: FALSE if the plan was left uncompiled
+ */
+static boolean
+CompileDialTemplates (void)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    struct DialTemplate *ptempl;
+    uint32_t count = 0;
+    uint32_t s;
+    uint16_t i, col;
+    int pound;
+
+    FreeCompiledDialPlan();
+
+    for (ptempl = basetemplate; ptempl != NULL; ptempl = ptempl->next) {
+        count++;
+    }
+    if ((count == 0) || (count > DIALPLAN_MAX_TEMPLATES)) {
+        return FALSE;
+    }
+
+    dp->ntemplates = (uint16_t) count;
+    dp->templates = (const struct DialTemplate **)
+        cpr_calloc(count, sizeof(struct DialTemplate *));
+    dp->lines = (line_t *) cpr_calloc(count, sizeof(line_t));
+    if ((dp->templates == NULL) || (dp->lines == NULL) ||
+        !GrowDialPlanHash()) {
+        FreeCompiledDialPlan();
+        return FALSE;
+    }
+    dp->ncolumns = 1;
+    for (i = 0, ptempl = basetemplate; ptempl != NULL;
+         i++, ptempl = ptempl->next) {
+        dp->templates[i] = ptempl;
+        if (ptempl->line != 0) {
+            for (col = 1; col < dp->ncolumns; col++) {
+                if (dp->lines[col - 1] == ptempl->line) {
+                    break;
+                }
+            }
+            if (col == dp->ncolumns) {
+                dp->lines[dp->ncolumns++ - 1] = ptempl->line;
+            }
+        }
+    }
+
+    for (pound = 0; pound < 2; pound++) {
+        uint32_t first;
+        int32_t root;
+
+        if (!ReserveDialPlanEntries()) {
+            FreeCompiledDialPlan();
+            return FALSE;
+        }
+        first = dp->nentries;
+        for (i = 0; i < dp->ntemplates; i++) {
+            DialTemplateState *e = &dp->entries[dp->nentries++];
+
+            memset(e, 0, sizeof(*e));
+            e->tmpl = i;
+            e->type = DIAL_FULLMATCH;
+        }
+        root = InternDialPlanState(pound ? DPS_POUND : 0, first,
+                                   dp->ntemplates);
+        if (root < 0) {
+            FreeCompiledDialPlan();
+            return FALSE;
+        }
+        dp->root[pound] = (uint16_t) root;
+    }
+
+    for (s = 0; s < dp->nstates; s++) {
+        int sym;
+
+        if (dp->states[s].flags & DPS_HAS_POUND) {
+            continue;
+        }
+        for (sym = 0; sym < DIALPLAN_SYMBOLS; sym++) {
+            char c = dial_symbols[sym];
+            boolean isPound = (dp->states[s].flags & DPS_POUND) ? TRUE : FALSE;
+            uint8_t flags = dp->states[s].flags;
+            uint32_t first;
+            uint16_t n = 0;
+            int32_t next;
+
+            if (!ReserveDialPlanEntries()) {
+                FreeCompiledDialPlan();
+                return FALSE;
+            }
+            first = dp->nentries;
+            for (i = 0; i < dp->states[s].count; i++) {
+                DialTemplateState *e = &dp->entries[first + n];
+
+                *e = dp->entries[dp->states[s].first + i];
+                if (StepTemplateState(dp->templates[e->tmpl]->pattern, e, c,
+                                      isPound)) {
+                    n++;
+                }
+            }
+            dp->nentries = first + n;
+
+            if (isPound) {
+                flags &= ~DPS_ENDS_POUND;
+                if (c == '#') {
+                    flags |= DPS_HAS_POUND | DPS_ENDS_POUND;
+                }
+            }
+            next = InternDialPlanState(flags, first, n);
+            if (next < 0) {
+                FreeCompiledDialPlan();
+                return FALSE;
+            }
+            dp->states[s].next[sym] = (uint16_t) next;
+        }
+    }
+    cpr_free(dp->hash);
+    dp->hash = NULL;
+    dp->hashsize = 0;
+
+    dp->results = (DialPlanResult *)
+        cpr_calloc(dp->nstates * dp->ncolumns, sizeof(DialPlanResult));
+    if (dp->results == NULL) {
+        FreeCompiledDialPlan();
+        return FALSE;
+    }
+    for (s = 0; s < dp->nstates; s++) {
+        for (col = 0; col < dp->ncolumns; col++) {
+            EvaluateDialPlanState(&dp->states[s],
+                                  col ? dp->lines[col - 1] : 0,
+                                  &dp->results[s * dp->ncolumns + col]);
+        }
+    }
+
+    if (++dp_generation == 0) {
+        dp_generation = 1;
+    }
+    dp->generation = dp_generation;
+    return TRUE;
+}
+
+/*
+ *  Function: ApplyDialPlanResult()
+ *
+ *  Parameters: state   - state reached by the dialed string
+ *              others as MatchDialTemplate()
+ *
+ *  Description: Hand back what MatchDialTemplateLinear() would for the
+ *               dialed string
+ *
+ *  Returns: DialMatchAction
+ */
+static DialMatchAction
+ApplyDialPlanResult (uint16_t state,
+                     const line_t line,
+                     int *timeout,
+                     RouteMode *pRouteMode,
+                     vcm_tones_t *pTone)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    const DialPlanResult *r;
+    uint16_t col;
+
+    for (col = 1; col < dp->ncolumns; col++) {
+        if (dp->lines[col - 1] == line) {
+            break;
+        }
+    }
+    if (col == dp->ncolumns) {
+        col = 0;
+    }
+    r = &dp->results[state * dp->ncolumns + col];
+
+    if (timeout != NULL) {
+        if (r->flags & DPR_TIMEOUT_BEST) {
+            *timeout = dp->templates[r->best]->timeout;
+        } else if ((r->flags & DPR_TIMEOUT_DEFAULT) && (*timeout == 0)) {
+            *timeout = DIAL_TIMEOUT;
+        }
+        if (r->flags & DPR_TIMEOUT_ZERO) {
+            *timeout = 0;
+        }
+    }
+    if ((pRouteMode != NULL) && (r->flags & DPR_ROUTE)) {
+        *pRouteMode = dp->templates[r->best]->routeMode;
+    }
+    if ((pTone != NULL) && (r->flags & DPR_TONE)) {
+        *pTone = (vcm_tones_t) r->tone;
+    }
+    return (DialMatchAction) r->action;
+}
+
+/*
+ *  Function: MatchDialTemplate()
+ *
+ *  Parameters: pattern - pattern string to match
+ *              line    - line number to match
+ *                        (May be 0 to match all lines)
+ *              timeout - returned dial timeout in seconds
+ *                        (May be NULL to not get a timeout)
+ *              rewrite - buffer to hold rewritten string
+ *                        (May be NULL for no rewrite)
+ *              rewritelen - Bytes available in the buffer to write to
+ *              routemode - pointer to location to hold route mode returned
+ *                          (May be NULL to not get a routemode)
+ *              tone - pointer to location to hold tone returned
+ *
+ *  Description: Find the best template to match a pattern
+ *
+ *  Returns: DialMatchAction
+ */
+DialMatchAction
+MatchDialTemplate (const char *pattern,
+                   const line_t line,
+                   int *timeout,
+                   char *rewrite,
+                   int rewritelen,
+                   RouteMode *pRouteMode,
+                   vcm_tones_t *pTone)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    const char *pinput;
+    uint16_t state;
+
+    if ((dp->generation == 0) || (rewrite != NULL)) {
+        return MatchDialTemplateLinear(pattern, line, timeout, rewrite,
+                                       rewritelen, pRouteMode, pTone);
+    }
+
+    state = dp->root[poundDialingEnabled() ? 1 : 0];
+    for (pinput = pattern; *pinput; pinput++) {
+        int sym = DialSymbol(*pinput);
+
+        if ((sym < 0) || (dp->states[state].next[sym] == DIALPLAN_NO_STATE)) {
+            return MatchDialTemplateLinear(pattern, line, timeout, rewrite,
+                                           rewritelen, pRouteMode, pTone);
+        }
+        state = dp->states[state].next[sym];
+    }
+    return ApplyDialPlanResult(state, line, timeout, pRouteMode, pTone);
+}
+
+/*
+ *  Function: ResetDialCursor()
+ *
+ *  Parameters: cursor - cursor to reset
+ *
+ *  Description: Forget the string a cursor last matched
+ *
+ *  Returns: None
+ */
+void
+ResetDialCursor (DialPlanCursor *cursor)
+{
+    cursor->generation = 0;
+    cursor->len = 0;
+}
+
+/*
+ *  Function: MatchDialTemplateCursor()
+ *
+ *  Parameters: cursor  - the walk for the string last matched
+ *              others as MatchDialTemplate()
+ *
+ *  Description: MatchDialTemplate() for a string that is being dialed.
+ *               The walk through the compiled dial plan is kept in the
+ *               cursor and only the characters after the part the string
+ *               shares with the one last matched are stepped, so a key
+ *               press costs one step whatever the size of the plan.
+ *
+ *  Returns: DialMatchAction
+ */
+DialMatchAction
+MatchDialTemplateCursor (DialPlanCursor *cursor,
+                         const char *pattern,
+                         const line_t line,
+                         int *timeout,
+                         char *rewrite,
+                         int rewritelen,
+                         RouteMode *pRouteMode,
+                         vcm_tones_t *pTone)
+{
+    DialPlanAutomaton *dp = &dp_automaton;
+    boolean pound;
+    int len = 0;
+    uint16_t state;
+
+    if ((dp->generation == 0) || (rewrite != NULL)) {
+        return MatchDialTemplateLinear(pattern, line, timeout, rewrite,
+                                       rewritelen, pRouteMode, pTone);
+    }
+
+    pound = poundDialingEnabled();
+    if ((cursor->generation != dp->generation) || (cursor->pound != pound)) {
+        cursor->generation = dp->generation;
+        cursor->pound = pound;
+        cursor->len = 0;
+        cursor->states[0] = dp->root[pound ? 1 : 0];
+    }
+
+    while ((len < cursor->len) && (pattern[len] == cursor->digits[len])) {
+        len++;
+    }
+    state = cursor->states[len];
+    while (pattern[len] != '\0') {
+        int sym = DialSymbol(pattern[len]);
+
+        if ((sym < 0) || (len >= MAX_DIALSTRING) ||
+            (dp->states[state].next[sym] == DIALPLAN_NO_STATE)) {
+            cursor->len = len;
+            return MatchDialTemplateLinear(pattern, line, timeout, rewrite,
+                                           rewritelen, pRouteMode, pTone);
+        }
+        state = dp->states[state].next[sym];
+        cursor->digits[len] = pattern[len];
+        cursor->states[++len] = state;
+    }
+    cursor->len = len;
+
+    return ApplyDialPlanResult(state, line, timeout, pRouteMode, pTone);
+}
+
+/*
+ *  Function: DialPlanStateCount()
+ *
+ *  Parameters: None
+ *
+ *  Description: Size of the compiled dial plan
+ *
+ *  Returns: number of automaton states, 0 when the plan is not compiled
+ */
+uint32_t
+DialPlanStateCount (void)
+{
+    return (dp_automaton.generation != 0) ? dp_automaton.nstates : 0;
+}
+
+
+
 /*
  *  Function: InitDialPlan()
  *
@@ -692,6 +1539,7 @@ FreeDialTemplates (void)
 {
     struct DialTemplate *pnext;
 
+    FreeCompiledDialPlan();
     while (basetemplate != NULL) {
         pnext = basetemplate->next;
         cpr_free(basetemplate);
@@ -829,6 +1677,11 @@ show_dialplan_cmd (int32_t argc, const char *argv[])
         idx++;
 
     }
+    if (DialPlanStateCount() != 0) {
+        debugif_printf("Compiled: %u states\n", DialPlanStateCount());
+    } else {
+        debugif_printf("Not compiled\n");
+    }
     return (0);
 }
 
@@ -1211,6 +2064,14 @@ ParseDialTemplate (char *parseptr)
             LookKey = 0;
         }
     }
+    /*
+     * Compile what was parsed, even when some of it failed
+     */
+    if (!CompileDialTemplates() && (basetemplate != NULL)) {
+        debugif_printf("ParseDialTemplate(): dial plan too large to compile, "
+                       "matching templates one by one\n");
+    }
+
     /*
      * If we had any parse errors, put them into the log
      */
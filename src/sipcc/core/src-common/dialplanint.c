@@ -594,10 +594,10 @@ dp_check_dialplan (line_t line, callid_t call_id, unsigned char digit)
         digit = digit - '0';
     }
 
-    /* see if we match any dial plans */
+    /* see if we match any dial plans, stepping only the new digits */
     action =
-        MatchDialTemplate(g_dp_int.gDialed, line, &timeout, NULL, 0, NULL,
-                          &tone);
+        MatchDialTemplateCursor(&g_dp_int.gCursor, g_dp_int.gDialed, line,
+                                &timeout, NULL, 0, NULL, &tone);
 
     switch (action) {
 
@@ -51,9 +51,14 @@
 #include "misc_apps_task.h"
 #include "pres_sub_not_handler.h"
 #include "configapp.h"
+#include "cc_latency.h"
+#include "cc_shutdown.h"
 
 #define MISC_ERROR err_msg
 
+/* Messages taken off the queue per wakeup */
+#define MISC_MSG_BATCH_SIZE 8
+
 cprMsgQueue_t s_misc_msg_queue;
 void destroy_misc_app_thread(void); 
 extern cprThread_t misc_app_thread;
@@ -62,6 +67,7 @@ cpr_status_e
 MiscAppTaskSendMsg (uint32_t cmd, cprBuffer_t buf, uint16_t len)
 {
     phn_syshdr_t *syshdr_p;
+    cpr_msgq_lane_e lane = CPR_MSGQ_LANE_NORMAL;
 
     syshdr_p = (phn_syshdr_t *) cprGetSysHeader(buf);
     if (!syshdr_p)
@@ -70,8 +76,24 @@ MiscAppTaskSendMsg (uint32_t cmd, cprBuffer_t buf, uint16_t len)
     }
     syshdr_p->Cmd = cmd;
     syshdr_p->Len = len;
+    cc_latency_stamp(syshdr_p);
+
+    /*
+     * BLF presence notifications can arrive in floods; keep them on the
+     * bulk lane so subscribe responses and timers are not stuck behind.
+     * A notify for a subscription terminated meanwhile is dropped by the
+     * presence handler.
+     */
+    if ((cmd == SUB_MSG_PRESENCE_NOTIFY) ||
+        (cmd == SUB_MSG_PRESENCE_UNSOLICITED_NOTIFY)) {
+        lane = CPR_MSGQ_LANE_BULK;
+    } else if (cmd == THREAD_UNLOAD) {
+        /* behind the notifies already queued, so they are not lost */
+        lane = CPR_MSGQ_LANE_BULK;
+    }
 
-    if (cprSendMessage(s_misc_msg_queue, buf, (void **)&syshdr_p) == CPR_FAILURE)
+    if (cprSendMessageLane(s_misc_msg_queue, buf, (void **)&syshdr_p,
+                           lane) == CPR_FAILURE)
     {
         cprReleaseSysHeader(syshdr_p);
         return CPR_FAILURE;
@@ -82,6 +104,8 @@ MiscAppTaskSendMsg (uint32_t cmd, cprBuffer_t buf, uint16_t len)
 void MiscAppTask (void *arg)
 {
     static const char fname[] = "MiscAppTask";    
+    cprMsgBatchEntry_t batch[MISC_MSG_BATCH_SIZE];
+    uint16_t count, i;
     void *msg_p;
     phn_syshdr_t *syshdr_p;
 
@@ -111,9 +135,14 @@ void MiscAppTask (void *arg)
 
     while (1)
     {
-        msg_p = cprGetMessage(s_misc_msg_queue, TRUE, (void **)&syshdr_p);
-        if (msg_p)
+        count = cprGetMessageBatch(s_misc_msg_queue, TRUE, batch,
+                                   MISC_MSG_BATCH_SIZE);
+        for (i = 0; i < count; i++)
         {
+            msg_p = batch[i].msg;
+            syshdr_p = (phn_syshdr_t *) batch[i].usrPtr;
+            cc_latency_begin(CC_LATENCY_QUEUE_MISC, syshdr_p);
+
             switch(syshdr_p->Cmd) {
             case SUB_MSG_PRESENCE_SUBSCRIBE_RESP:
             case SUB_MSG_PRESENCE_NOTIFY:
@@ -143,6 +172,7 @@ void MiscAppTask (void *arg)
                 break;
             }
 
+            cc_latency_end(CC_LATENCY_QUEUE_MISC);
             cprReleaseSysHeader(syshdr_p);
             cprReleaseBuffer(msg_p);
         }
@@ -178,6 +208,7 @@ void destroy_misc_app_thread()
         DEB_F_PREFIX_ARGS(SIP_CC_INIT, fname));
     configapp_shutdown();
     MiscAppTaskShutdown();
+    cc_shutdown_phase_unloaded(CC_SHUTDOWN_PHASE_MISC);
     (void)cprDestroyThread(misc_app_thread);
 }
 
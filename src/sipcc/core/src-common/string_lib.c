@@ -54,9 +54,231 @@
 #define STR_TO_STRUCT(str) ((string_block_t *)((str) - (offsetof(string_block_t,data))))
 #define STRUCT_TO_STR(sbt) ((const char *) (sbt)->data)
 
+#define STRLIB_BLOCK_SIZE(cap)  (offsetof(string_block_t, data) + (cap))
+#define STRLIB_CLASS_NONE       0xff
+#define STRLIB_HASH_BUCKETS     1024    /* power of two */
+#define STRLIB_STRIPES          16      /* power of two, <= buckets */
+#define STRLIB_FREE_MAX         32      /* blocks cached per class and stripe */
+#define STRLIB_PINNED           0x40000000
+
+#define STRLIB_STRIPE(hash) (&strlib_stripes[(hash) & (STRLIB_STRIPES - 1)])
+#define STRLIB_BUCKET(hash) (&strlib_hash[(hash) & (STRLIB_HASH_BUCKETS - 1)])
+
+/* Data capacity, terminating NUL included, of each size class */
+static const uint16_t strlib_class_cap[STRLIB_NUM_CLASSES] = {
+    16, 32, 64, 128, STRLIB_INTERN_MAX + 1
+};
+
+/*
+ * The pool is split in stripes by hash. A stripe's lock guards the hash
+ * buckets that fall in it, its free lists and its share of the stats.
+ * Reference counts are not under any lock: strlib_copy() and
+ * strlib_free() of a block that stays alive never take one.
+ *
+ * A block goes back to the stripe its hash selects. Blocks that are not
+ * interned have no content hash; their hash field only picks a stripe.
+ */
+typedef struct {
+    cprMutex_t lock;
+    string_block_t *free_list[STRLIB_NUM_CLASSES];
+    strlib_stats_t stats;
+} strlib_stripe_t;
+
+static boolean strlib_pooled = FALSE;
+static strlib_stripe_t strlib_stripes[STRLIB_STRIPES];
+static string_block_t *strlib_hash[STRLIB_HASH_BUCKETS];
+
 static string_t empty_str;
 static int strlib_is_string(string_t str);
 
+
+/*
+ *  Function: strlib_hash_string
+ *
+ *  DESCRIPTION: hashes the string contents eight bytes at a time
+ */
+static uint32_t
+strlib_hash_string (const char *str, int length)
+{
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (uint64_t) length;
+    uint64_t word;
+
+    while (length >= (int) sizeof(word)) {
+        memcpy(&word, str, sizeof(word));
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 32;
+        str += sizeof(word);
+        length -= sizeof(word);
+    }
+    if (length > 0) {
+        word = 0;
+        memcpy(&word, str, length);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 32;
+    return (uint32_t) hash;
+}
+
+/*
+ *  Function: strlib_size_class
+ *
+ *  DESCRIPTION: smallest size class holding length characters and the
+ *  NUL, or STRLIB_CLASS_NONE when there is no pool or it is too long
+ */
+static uint8_t
+strlib_size_class (int length)
+{
+    uint8_t i;
+
+    if (!strlib_pooled) {
+        return STRLIB_CLASS_NONE;
+    }
+    for (i = 0; i < STRLIB_NUM_CLASSES; i++) {
+        if (length < strlib_class_cap[i]) {
+            return i;
+        }
+    }
+    return STRLIB_CLASS_NONE;
+}
+
+/*
+ *  Function: strlib_block_alloc
+ *
+ *  DESCRIPTION: gets a block for length characters, from the stripe's
+ *  free list for its size class if one is cached. For a pooled class the
+ *  caller must hold the stripe lock.
+ */
+static string_block_t *
+strlib_block_alloc (strlib_stripe_t *stripe, uint8_t size_class, int length)
+{
+    string_block_t *temp;
+    int size;
+
+    if (size_class == STRLIB_CLASS_NONE) {
+        size = STRLIB_BLOCK_SIZE(length + 1);
+    } else {
+        temp = stripe->free_list[size_class];
+        if (temp) {
+            stripe->free_list[size_class] = temp->next;
+            stripe->stats.class_cached[size_class]--;
+            stripe->stats.class_reused[size_class]++;
+            temp->size_class = size_class;
+            return temp;
+        }
+        size = STRLIB_BLOCK_SIZE(strlib_class_cap[size_class]);
+        stripe->stats.class_allocs[size_class]++;
+    }
+
+    temp = (string_block_t *) cpr_malloc(size);
+    if (!temp) {
+        err_msg("Error: Strlib_Malloc() Failed. Requested Size = %d\n", size);
+        return NULL;
+    }
+    temp->size_class = size_class;
+    return temp;
+}
+
+/*
+ *  Function: strlib_block_release
+ *
+ *  DESCRIPTION: returns a block whose last reference went away to its
+ *  stripe's free list, or frees it. For a pooled class the caller must
+ *  hold the stripe lock.
+ */
+static void
+strlib_block_release (strlib_stripe_t *stripe, string_block_t *temp)
+{
+    uint8_t size_class = temp->size_class;
+
+    temp->signature = 0;
+    if ((size_class != STRLIB_CLASS_NONE) &&
+        (stripe->stats.class_cached[size_class] < STRLIB_FREE_MAX)) {
+        temp->next = stripe->free_list[size_class];
+        stripe->free_list[size_class] = temp;
+        stripe->stats.class_cached[size_class]++;
+        return;
+    }
+    cpr_free(temp);
+}
+
+/*
+ *  Function: strlib_unlink
+ *
+ *  DESCRIPTION: takes an interned block off its hash chain. Caller holds
+ *  the stripe lock.
+ */
+static void
+strlib_unlink (strlib_stripe_t *stripe, string_block_t *temp)
+{
+    string_block_t **link = STRLIB_BUCKET(temp->hash);
+
+    while (*link) {
+        if (*link == temp) {
+            *link = temp->next;
+            temp->interned = FALSE;
+            stripe->stats.interned--;
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+/*
+ *  Function: strlib_block_init
+ *
+ *  DESCRIPTION: fills in a freshly allocated block
+ */
+static string_t
+strlib_block_init (string_block_t *temp, const char *str, int length,
+                   uint32_t hash, const char *fname, int line)
+{
+    temp->next      = NULL;
+    temp->refcount  = 1;
+    temp->hash      = hash;
+    temp->length    = (uint16_t) length;
+    temp->interned  = FALSE;
+    temp->signature = STRING_SIGNATURE;
+    temp->fname     = fname;
+    temp->line      = line;
+    /* There used to be memcpy here which will walk off the end of */
+    /* str pointer which is a bad thing to do */
+    sstrncpy(temp->data, str, length + 1);
+    temp->data[length] = '\0';
+
+    return STRUCT_TO_STR(temp);
+}
+
+/*
+ *  Function: strlib_malloc_private
+ *
+ *  DESCRIPTION: allocates a block nobody else shares, for strlib_open()
+ *  which is about to modify it
+ */
+static string_t
+strlib_malloc_private (const char *str, int length, const char *fname,
+                       int line)
+{
+    string_block_t *temp;
+    strlib_stripe_t *stripe;
+    uint8_t size_class = strlib_size_class(length);
+    uint32_t hash = (uint32_t) length;
+
+    if (size_class != STRLIB_CLASS_NONE) {
+        stripe = STRLIB_STRIPE(hash);
+        (void) cprGetMutex(stripe->lock);
+        temp = strlib_block_alloc(stripe, size_class, length);
+        (void) cprReleaseMutex(stripe->lock);
+    } else {
+        temp = strlib_block_alloc(NULL, size_class, length);
+    }
+    if (!temp) {
+        return (string_t) 0;
+    }
+    return strlib_block_init(temp, str, length, hash, fname, line);
+}
+
 /*
  *  Function: strlib_malloc
  *
@@ -66,6 +288,8 @@ static int strlib_is_string(string_t str);
  *  DESCRIPTION:strlib_malloc : creates a new string and returns a const char*
  *  to the new string. Size of String is equal to length specified or actual
  *  length of the string when length is specified as -1(LEN_UNKNOWN)
+ *  Short strings are interned: when a live string with the same contents
+ *  exists, a reference to it is returned instead.
  *
  *  RETURNS: Pointer to malloc'ed string
  *
@@ -74,7 +298,10 @@ string_t
 strlib_malloc (const char *str, int length, const char *fname, int line)
 {
     string_block_t *temp;
-    int size;
+    string_block_t **bucket;
+    strlib_stripe_t *stripe;
+    uint8_t size_class;
+    uint32_t hash;
 
     // if specified length is unknown or invalid... then calculate it
     // Length < 0 is not expected, but since length is an int, it could
@@ -82,27 +309,53 @@ strlib_malloc (const char *str, int length, const char *fname, int line)
     // avoids a static analysis warning related to same ] 
     if ((length == LEN_UNKNOWN) || (length < 0)) {
         length = strlen(str);
+    } else if (memchr(str, '\0', length) != NULL) {
+        /* Shorter than length, the tail is padding: not worth sharing */
+        return strlib_malloc_private(str, length, fname, line);
     }
 
-    size = sizeof(string_block_t) + length + 1;
-    temp = (string_block_t *) cpr_malloc(size);
+    size_class = strlib_size_class(length);
+    if (size_class == STRLIB_CLASS_NONE) {
+        return strlib_malloc_private(str, length, fname, line);
+    }
 
-    if (!temp) {
-        err_msg("Error: Strlib_Malloc() Failed. Requested Size = %d\n", size);
-        return (string_t) 0;
+    hash = strlib_hash_string(str, length);
+    bucket = STRLIB_BUCKET(hash);
+    stripe = STRLIB_STRIPE(hash);
+
+    (void) cprGetMutex(stripe->lock);
+    stripe->stats.lookups++;
+    for (temp = *bucket; temp; temp = temp->next) {
+        if ((temp->hash != hash) || (temp->length != length) ||
+            (memcmp(temp->data, str, length) != 0)) {
+            continue;
+        }
+        /*
+         * A block whose count already dropped to zero is being freed by
+         * its last holder, which is waiting for the lock to unlink it.
+         * Back the increment out again and leave it alone.
+         */
+        if (cprAtomicIncrement(&temp->refcount) > 1) {
+            stripe->stats.hits++;
+            stripe->stats.bytes_saved +=
+                STRLIB_BLOCK_SIZE(strlib_class_cap[temp->size_class]);
+            (void) cprReleaseMutex(stripe->lock);
+            return STRUCT_TO_STR(temp);
+        }
+        (void) cprAtomicDecrement(&temp->refcount);
     }
 
-    temp->refcount  = 1;
-    temp->length    = (uint16_t) length;
-    temp->signature = STRING_SIGNATURE;
-    temp->fname     = fname;
-    temp->line      = line;
-    /* There used to be memcpy here which will walk off the end of */
-    /* str pointer which is a bad thing to do */
-    sstrncpy(temp->data, str, length + 1);
-    temp->data[length] = '\0';
+    temp = strlib_block_alloc(stripe, size_class, length);
+    if (temp) {
+        (void) strlib_block_init(temp, str, length, hash, fname, line);
+        temp->interned = TRUE;
+        temp->next = *bucket;
+        *bucket = temp;
+        stripe->stats.interned++;
+    }
+    (void) cprReleaseMutex(stripe->lock);
 
-    return STRUCT_TO_STR(temp);
+    return temp ? STRUCT_TO_STR(temp) : (string_t) 0;
 }
 
 
@@ -117,6 +370,7 @@ strlib_malloc (const char *str, int length, const char *fname, int line)
  *  private copy which cannot be modified by any other function.
  *  String should be modified only by calling strlib_open
  *  which checks for the refcount and if its more than 1 allocates new string.
+ *  Safe to call from any thread.
  *
  *  RETURNS: string_t: string whose ref count is  incremented
  *
@@ -132,12 +386,9 @@ strlib_copy (string_t str)
 
     temp = STR_TO_STRUCT(str);
 
-    /*
-     * Refcount is limited to USHRT_MAX since refcount is
-     * of type uint16_t.
-     */
-    if ((temp->refcount < 0xffff) && (str != empty_str)) {
-        temp->refcount++;
+    /* The count is 32 bits wide, it cannot realistically wrap */
+    if (str != empty_str) {
+        (void) cprAtomicIncrement(&temp->refcount);
     }
 
     return STRUCT_TO_STR(temp);
@@ -256,19 +507,58 @@ void
 strlib_free (string_t str)
 {
     string_block_t *temp;
+    strlib_stripe_t *stripe;
 
     if ((!strlib_is_string(str)) || (str == empty_str)) {
         return;
     }
 
     temp = STR_TO_STRUCT(str);
-    temp->refcount--;
-    if (temp->refcount == 0) {
-        temp->signature = 0;
-        cpr_free(temp);
+    if (cprAtomicDecrement(&temp->refcount) != 0) {
+        return;
     }
-    
-    return;
+
+    if (temp->size_class == STRLIB_CLASS_NONE) {
+        strlib_block_release(NULL, temp);
+        return;
+    }
+    stripe = STRLIB_STRIPE(temp->hash);
+    (void) cprGetMutex(stripe->lock);
+    if (temp->interned) {
+        strlib_unlink(stripe, temp);
+    }
+    strlib_block_release(stripe, temp);
+    (void) cprReleaseMutex(stripe->lock);
+}
+
+
+/*
+ *  Function: strlib_make_private
+ *
+ *  DESCRIPTION: takes a string the caller holds the only reference to
+ *  out of the intern hash, so that it can be modified in place. Lookups
+ *  only take references under the lock, so the count is stable there.
+ *
+ *  RETURNS: TRUE when the caller may modify the string
+ */
+static boolean
+strlib_make_private (string_block_t *temp)
+{
+    strlib_stripe_t *stripe;
+    boolean ret = TRUE;
+
+    if (!temp->interned) {
+        return TRUE;
+    }
+    stripe = STRLIB_STRIPE(temp->hash);
+    (void) cprGetMutex(stripe->lock);
+    if (cprAtomicRead(&temp->refcount) == 1) {
+        strlib_unlink(stripe, temp);
+    } else {
+        ret = FALSE;
+    }
+    (void) cprReleaseMutex(stripe->lock);
+    return ret;
 }
 
 
@@ -298,10 +588,11 @@ strlib_open (string_t str, int length, const char *fname, int line)
 
     temp = STR_TO_STRUCT(str);
 
-    if ((temp->refcount == 1) && (length <= temp->length)) {
+    if ((cprAtomicRead(&temp->refcount) == 1) && (length <= temp->length) &&
+        strlib_make_private(temp)) {
         ret_str = (char *) str;
     } else {
-        ret_str = (char *) strlib_malloc(str, length, fname, line);
+        ret_str = (char *) strlib_malloc_private(str, length, fname, line);
         if (!ret_str) {
             /*
              * If a malloc error occurred, give them back what they had.
@@ -406,11 +697,108 @@ strlib_empty (void)
     static boolean empty_str_init = FALSE;
 
     if (empty_str_init == FALSE) {
-        empty_str = strlib_malloc("", LEN_UNKNOWN, __FILE__, __LINE__);
+        empty_str = strlib_malloc_private("", 0, __FILE__, __LINE__);
         temp = STR_TO_STRUCT(empty_str);
-        temp->refcount = 0xffff;
+        temp->refcount = STRLIB_PINNED;
         empty_str_init = TRUE;
     }
     return (empty_str);
 }
 
+
+/*
+ *  Function: strlib_init
+ *
+ *  DESCRIPTION: creates the stripe locks. Called from ccPreInit before
+ *  any task starts; strings made before that are plain cpr_malloc blocks
+ *  and never interned.
+ *
+ *  RETURNS: none
+ */
+void
+strlib_init (void)
+{
+    int i;
+
+    if (strlib_pooled) {
+        return;
+    }
+    for (i = 0; i < STRLIB_STRIPES; i++) {
+        strlib_stripes[i].lock = cprCreateMutex("strlib pool");
+        if (strlib_stripes[i].lock == NULL) {
+            err_msg("Strlib Error: unable to create pool lock\n");
+            while (--i >= 0) {
+                (void) cprDestroyMutex(strlib_stripes[i].lock);
+                strlib_stripes[i].lock = NULL;
+            }
+            return;
+        }
+    }
+    strlib_pooled = TRUE;
+    (void) strlib_empty();
+}
+
+
+/*
+ *  Function: strlib_get_stats
+ *
+ *  PARAMETERS: strlib_stats_t* : filled with the pool counters
+ *
+ *  RETURNS: none
+ */
+void
+strlib_get_stats (strlib_stats_t *stats)
+{
+    strlib_stats_t *st;
+    int i, c;
+
+    memset(stats, 0, sizeof(strlib_stats_t));
+    if (!strlib_pooled) {
+        return;
+    }
+    for (i = 0; i < STRLIB_STRIPES; i++) {
+        (void) cprGetMutex(strlib_stripes[i].lock);
+        st = &strlib_stripes[i].stats;
+        stats->lookups += st->lookups;
+        stats->hits += st->hits;
+        stats->bytes_saved += st->bytes_saved;
+        stats->interned += st->interned;
+        for (c = 0; c < STRLIB_NUM_CLASSES; c++) {
+            stats->class_allocs[c] += st->class_allocs[c];
+            stats->class_reused[c] += st->class_reused[c];
+            stats->class_cached[c] += st->class_cached[c];
+        }
+        (void) cprReleaseMutex(strlib_stripes[i].lock);
+    }
+}
+
+
+/*
+ *  Function: show_strlib_cmd()
+ *
+ *  Description: "show strlib" callback.
+ *
+ *  Returns:     zero(0)
+ */
+cc_int32_t
+show_strlib_cmd (cc_int32_t argc, const char *argv[])
+{
+    strlib_stats_t stats;
+    int i;
+
+    strlib_get_stats(&stats);
+    debugif_printf("\n------ String Pool ------\n");
+    debugif_printf("lookups %u hits %u (%u%%) bytes saved %u live %u\n",
+                   stats.lookups, stats.hits,
+                   stats.lookups ? (uint32_t) (((uint64_t) stats.hits * 100) /
+                                               stats.lookups) : 0,
+                   stats.bytes_saved, stats.interned);
+    debugif_printf("%6s %8s %8s %6s\n", "class", "allocs", "reused",
+                   "cached");
+    for (i = 0; i < STRLIB_NUM_CLASSES; i++) {
+        debugif_printf("%6u %8u %8u %6u\n", strlib_class_cap[i],
+                       stats.class_allocs[i], stats.class_reused[i],
+                       stats.class_cached[i]);
+    }
+    return (0);
+}
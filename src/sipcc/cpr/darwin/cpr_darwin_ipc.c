@@ -39,6 +39,7 @@
 
 #include "cpr.h"
 #include "cpr_stdlib.h"
+#include "cpr_timers.h"
 #include <cpr_stdio.h>
 #include <errno.h>
 #include <sys/time.h>
@@ -69,6 +70,7 @@ typedef struct cpr_msgq_node_s
     struct cpr_msgq_node_s *prev;
     void *msg;
     void *pUserData;
+    uint32_t sendTime;
 } cpr_msgq_node_t;
 
 /*
@@ -101,8 +103,9 @@ typedef struct cpr_msg_queue_s
     uint16_t maxExtendedQDepth;
     pthread_mutex_t mutex;       /* lock for managing extended queue     */
 	pthread_cond_t cond;		 /* signal for queue/dequeue */
-    cpr_msgq_node_t *head;       /* extended queue head (newest element) */
-    cpr_msgq_node_t *tail;       /* extended queue tail (oldest element) */
+    cpr_msgq_node_t *head[CPR_MSGQ_LANES]; /* lane head (newest element) */
+    cpr_msgq_node_t *tail[CPR_MSGQ_LANES]; /* lane tail (oldest element) */
+    cprMsgQueueLaneStats_t lanes[CPR_MSGQ_LANES];
 } cpr_msg_queue_t;
 
 /*
@@ -185,9 +188,12 @@ static const char unnamed_string[] = "unnamed";
  * Prototype declarations
  */
 static cpr_msgq_post_result_e
-cprPostMessage(cpr_msg_queue_t *msgq, void *msg, void **ppUserData);
+cprPostMessage(cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+               cpr_msgq_lane_e lane);
 static void
 cprPegSendMessageStats(cpr_msg_queue_t *msgq, uint16_t numAttempts);
+static cpr_msgq_node_t *
+cprDequeueMessage(cpr_msg_queue_t *msgq);
 
 
 /*
@@ -394,24 +400,16 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
 	}
 	else
 	{
-		while(msgq->tail==NULL)
+		while(msgq->currentCount == 0)
 		{
 			pthread_cond_wait(&msgq->cond, &msgq->mutex);
 		}
 	}
 	
 	// If there is a message on the queue, de-queue it
-	if (msgq->tail)
+	node = cprDequeueMessage(msgq);
+	if (node)
 	{
-		node = msgq->tail;
-		msgq->tail = node->prev;
-		if (msgq->tail) {
-			msgq->tail->next = NULL;
-		}
-		if (msgq->head == node) {
-			msgq->head = NULL;
-		}
-		msgq->currentCount--;
 		/*
 		 * Pull out the data
 		 */
@@ -419,14 +417,125 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
 			*ppUserData = node->pUserData;
 		}
 		buffer = (long) node->msg;
-		
 	}
 	
 	pthread_mutex_unlock(&msgq->mutex);
 	
+	if (node) {
+		cpr_free(node);
+	}
     return (void *)(long) buffer;
 }
 
+/**
+ * Retrieve up to maxMsgs messages from a message queue
+ *
+ * Waits like cprGetMessage for the first message, then takes whatever
+ * else is already queued, up to maxMsgs, under the same lock.
+ *
+ * @param msgQueue    - msg queue from which to retrieve the messages
+ * @param waitForever - wait for the first message (TRUE) or not
+ * @param batch       - array of at least maxMsgs entries
+ * @param maxMsgs     - maximum number of messages to return
+ *
+ * @return number of messages placed in batch, zero if none
+ */
+uint16_t
+cprGetMessageBatch (cprMsgQueue_t msgQueue, boolean waitForever,
+                    cprMsgBatchEntry_t *batch, uint16_t maxMsgs)
+{
+    cpr_msg_queue_t *msgq = (cpr_msg_queue_t *) msgQueue;
+    cpr_msgq_node_t *nodes = NULL;
+    cpr_msgq_node_t *node;
+    uint16_t count = 0;
+    uint16_t depth;
+
+    if ((msgq == NULL) || (batch == NULL) || (maxMsgs == 0)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    pthread_mutex_lock(&msgq->mutex);
+    depth = msgq->currentCount;
+    pthread_mutex_unlock(&msgq->mutex);
+
+    if (depth == 0) {
+        /* let cprGetMessage do the waiting */
+        batch[0].msg = cprGetMessage(msgQueue, waitForever, &batch[0].usrPtr);
+        if (batch[0].msg == NULL) {
+            return 0;
+        }
+        count = 1;
+    }
+
+    pthread_mutex_lock(&msgq->mutex);
+    while (count < maxMsgs) {
+        node = cprDequeueMessage(msgq);
+        if (node == NULL) {
+            break;
+        }
+        batch[count].msg = node->msg;
+        batch[count].usrPtr = node->pUserData;
+        count++;
+        /* chain the nodes to free them outside of the lock */
+        node->next = nodes;
+        nodes = node;
+    }
+    pthread_mutex_unlock(&msgq->mutex);
+
+    while (nodes) {
+        node = nodes;
+        nodes = node->next;
+        cpr_free(node);
+    }
+    return count;
+}
+
+/**
+ * Take the oldest message of the most urgent non-empty lane
+ *
+ * @param msgq - message queue
+ *
+ * @return the node, or NULL if the queue is empty
+ *
+ * @pre (msgq->mutex has been locked)
+ */
+static cpr_msgq_node_t *
+cprDequeueMessage (cpr_msg_queue_t *msgq)
+{
+    cprMsgQueueLaneStats_t *stats;
+    cpr_msgq_node_t *node;
+    uint32_t latency;
+    int lane;
+
+    for (lane = 0; lane < CPR_MSGQ_LANES; lane++) {
+        node = msgq->tail[lane];
+        if (node == NULL) {
+            continue;
+        }
+        msgq->tail[lane] = node->prev;
+        if (msgq->tail[lane]) {
+            msgq->tail[lane]->next = NULL;
+        }
+        if (msgq->head[lane] == node) {
+            msgq->head[lane] = NULL;
+        }
+        msgq->currentCount--;
+
+        stats = &msgq->lanes[lane];
+        if (stats->currentCount) {
+            stats->currentCount--;
+        }
+        latency = cprGetTimeMs() - node->sendTime;
+        stats->totalLatency += latency;
+        if (latency > stats->maxLatency) {
+            stats->maxLatency = latency;
+        }
+        return node;
+    }
+    return NULL;
+}
+
 
 /**
  * Place a message on a particular queue.  Note that caller may
@@ -463,7 +572,27 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
 cprRC_t
 cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
 {
-    static const char fname[] = "cprSendMessage";
+    return cprSendMessageLane(msgQueue, msg, ppUserData, CPR_MSGQ_LANE_NORMAL);
+}
+
+/**
+ * Place a message on a particular lane of a queue
+ *
+ * Same as cprSendMessage, which uses CPR_MSGQ_LANE_NORMAL, but lets the
+ * sender pick the priority lane.
+ *
+ * @param msgQueue   - msg queue on which to place the message
+ * @param msg        - pointer to the msg to place on the queue
+ * @param ppUserData - pointer to a pointer to user defined data
+ * @param lane       - priority lane
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE, errno provided
+ */
+cprRC_t
+cprSendMessageLane (cprMsgQueue_t msgQueue, void *msg, void **ppUserData,
+                    cpr_msgq_lane_e lane)
+{
+    static const char fname[] = "cprSendMessageLane";
     static const char error_str[] = "%s: Msg not sent to %s queue: %s\n";
     cpr_msgq_post_result_e rc;
     cpr_msg_queue_t *msgq;
@@ -471,7 +600,7 @@ cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
     uint16_t numAttempts   = 0;
 	
     /* Bad application? */
-    if (msgQueue == NULL) {
+    if ((msgQueue == NULL) || (lane >= CPR_MSGQ_LANES)) {
         CPR_ERROR(error_str, fname, "undefined", "invalid input");
         errno = EINVAL;
         return CPR_FAILURE;
@@ -487,7 +616,7 @@ cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
 		/* 
 		 * Post the message to the Queue
 		 */
-		rc = cprPostMessage(msgq, msg, ppUserData);
+		rc = cprPostMessage(msgq, msg, ppUserData, lane);
 		
 		if (rc == CPR_MSGQ_POST_SUCCESS) {
 			cprPegSendMessageStats(msgq, numAttempts);
@@ -565,6 +694,7 @@ cprPegSendMessageStats (cpr_msg_queue_t *msgq, uint16_t numAttempts)
  * @param msgq       - message queue
  * @param msg        - message to post
  * @param ppUserData - ptr to ptr to option user data
+ * @param lane       - priority lane
  *
  * @return the post result which is CPR_MSGQ_POST_SUCCESS,
  *         CPR_MSGQ_POST_FAILURE or CPR_MSGQ_POST_PENDING
@@ -573,9 +703,11 @@ cprPegSendMessageStats (cpr_msg_queue_t *msgq, uint16_t numAttempts)
  * @pre (msg not_eq NULL)
  */
 static cpr_msgq_post_result_e
-cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
+cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+                cpr_msgq_lane_e lane)
 {
 	cpr_msgq_node_t *node;
+	cprMsgQueueLaneStats_t *stats;
 	
 	/*
 	 * Allocate new message queue node
@@ -597,22 +729,30 @@ cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
 	} else {
 		node->pUserData = NULL;
 	}
+	node->sendTime = cprGetTimeMs();
 	
 	/*
-	 * Push onto list
+	 * Push onto the lane's list
 	 */
 	node->prev = NULL;
-	node->next = msgq->head;
-	msgq->head = node;
+	node->next = msgq->head[lane];
+	msgq->head[lane] = node;
 	
 	if (node->next) {
 		node->next->prev = node;
 	}
 	
-	if (msgq->tail == NULL) {
-		msgq->tail = node;
+	if (msgq->tail[lane] == NULL) {
+		msgq->tail[lane] = node;
 	}
 	msgq->currentCount++;
+
+	stats = &msgq->lanes[lane];
+	stats->totalCount++;
+	stats->currentCount++;
+	if (stats->currentCount > stats->maxCount) {
+		stats->maxCount = stats->currentCount;
+	}
 	
 	pthread_cond_signal(&msgq->cond);
 	pthread_mutex_unlock(&msgq->mutex);
@@ -650,6 +790,7 @@ cprGetMessageQueueStats (cprMsgQueue_t msgQueue, cprMsgQueueStats_t *stats)
         stats->sendErrors = msgq->sendErrors;
         stats->highAttempts = msgq->highAttempts;
         stats->selfQErrors = msgq->selfQErrors;
+        memcpy(stats->lanes, msgq->lanes, sizeof(stats->lanes));
     }
 }
 
@@ -667,8 +808,14 @@ cprGetMessageQueueStats (cprMsgQueue_t msgQueue, cprMsgQueueStats_t *stats)
 int32_t
 cprShowMessageQueueStats (int32_t argc, const char *argv[])
 {
+    static const char *lane_names[CPR_MSGQ_LANES] = {
+        "control", "normal", "bulk"
+    };
     cpr_msg_queue_t *msgq;
     cprMsgQueueStats_t stats;
+    cprMsgQueueLaneStats_t *lane;
+    uint32_t received;
+    int i;
 
     debugif_printf("CPR Message Queues\n");
 
@@ -686,7 +833,18 @@ cprShowMessageQueueStats (int32_t argc, const char *argv[])
         debugif_printf("   retries: %d\n", stats.reTries);
         debugif_printf("   high attempts: %d\n", stats.highAttempts);
         debugif_printf("   send errors: %d\n", stats.sendErrors);
-        debugif_printf("   self queue errors: %d\n\n", stats.selfQErrors);
+        debugif_printf("   self queue errors: %d\n", stats.selfQErrors);
+        for (i = 0; i < CPR_MSGQ_LANES; i++) {
+            lane = &stats.lanes[i];
+            received = lane->totalCount - lane->currentCount;
+            debugif_printf("   %-7s lane: active %d max %d total %d"
+                           " avg wait %d ms max wait %d ms\n",
+                           lane_names[i], lane->currentCount, lane->maxCount,
+                           lane->totalCount,
+                           received ? lane->totalLatency / received : 0,
+                           lane->maxLatency);
+        }
+        debugif_printf("\n");
 
         msgq = msgq->next;
     }
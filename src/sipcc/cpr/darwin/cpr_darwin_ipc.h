@@ -60,6 +60,15 @@ struct msgbuffer {
     void   *usrPtr;   /* Ptr to user data */
 };
 
+/* Per lane statistics of a message queue */
+typedef struct {
+    uint16_t currentCount;
+    uint16_t maxCount;
+    uint32_t totalCount;
+    uint32_t totalLatency;    /* msec spent queued, all messages */
+    uint32_t maxLatency;      /* msec, worst single message      */
+} cprMsgQueueLaneStats_t;
+
 /* For gathering statistics regarding message queues */
 typedef struct {
     char name[16];
@@ -72,6 +81,7 @@ typedef struct {
     uint32_t highAttempts;
     uint32_t selfQErrors;
     uint16_t extendedDepth;
+    cprMsgQueueLaneStats_t lanes[CPR_MSGQ_LANES];
 } cprMsgQueueStats_t;
 
 /*
@@ -79,16 +89,6 @@ typedef struct {
  */
 extern pthread_mutex_t msgQueueListMutex;
 
-/**
- * cprShowMessageQueueStats
- *
- * Display statistics for all message queues
- *
- * Comments: Function only applicable to CNU
- */
-int32_t
-cprShowMessageQueueStats(int32_t argc, const char *argv[]);
-
 /**
  * cprGetDepth
  * 
@@ -43,6 +43,7 @@
 #include "cpr_stdio.h"
 #include "cpr_memory.h"
 #include "cpr_locks.h"
+#include "cpr_timers.h"
 #include "plat_api.h"
 #include <errno.h>
 #include <sys/syslog.h>
@@ -85,6 +86,8 @@ typedef struct
         uint32_t UsrInfo;
     } Usr;
     uint8_t Misc[MISC_LN];
+    uint32_t EnqTime;
+    uint32_t TraceId;
 //  void *TempPtr;     
 } phn_syshdr_t;
 
@@ -267,6 +270,7 @@ fillInSysHeader (void *buffer, uint16_t cmd, uint16_t len, void *timerMsg)
     syshdr->Cmd = cmd;
     syshdr->Len = len;
     syshdr->Usr.UsrPtr = timerMsg;
+    syshdr->EnqTime = cprGetTimeUs();
     return;
 }
 
@@ -51,6 +51,7 @@
 #include <sys/syslog.h>
 #include <sys/fcntl.h>
 #include <ctype.h>
+#include <poll.h>
 
 
 const cpr_ip_addr_t ip_addr_invalid = {0};
@@ -60,11 +61,28 @@ const cpr_ip_addr_t ip_addr_invalid = {0};
 #define	INADDRSZ	4
 
 #define MAX_RETRY_FOR_EAGAIN 10
+#define EAGAIN_RETRY_WAIT_MS 100
 
 /* Forward declarations of internal (helper) functions */
 static int cpr_inet_pton4(const char *src, uint8_t *dst, int pton);
 static int cpr_inet_pton6(const char *src, uint8_t *dst);
 
+/*
+ * Wait, at most EAGAIN_RETRY_WAIT_MS, for a socket that returned EAGAIN
+ * to become ready again. Returns early as soon as it is, rather than
+ * always sleeping the full period before the retry.
+ */
+static void
+cprWaitSocketReady (cpr_socket_t soc, short events)
+{
+    struct pollfd pfd;
+
+    pfd.fd = soc;
+    pfd.events = events;
+    pfd.revents = 0;
+    (void) poll(&pfd, 1, EAGAIN_RETRY_WAIT_MS);
+}
+
 /**
  * cprBind
  *
@@ -170,7 +188,7 @@ cprConnect (cpr_socket_t soc,
     retval = connect(soc, (struct sockaddr *)addr, addr_len);
 
     while( retval == -1 && ((errno == EAGAIN && retry < MAX_RETRY_FOR_EAGAIN) || errno == EINPROGRESS || errno == EALREADY) ) {
-      cprSleep(100);
+      cprWaitSocketReady(soc, POLLOUT);
       retry++;
       retval = connect(soc, (struct sockaddr *)addr, addr_len);
     }
@@ -316,7 +334,7 @@ cprRecv (cpr_socket_t soc,
 
     rc = recv(soc, buf, len, flags);
     while( rc == -1 && errno == EAGAIN && retry < MAX_RETRY_FOR_EAGAIN ) {
-      cprSleep(100);
+      cprWaitSocketReady(soc, POLLIN);
       retry++;
       rc = recv(soc, buf, len, flags);
     }
@@ -389,7 +407,7 @@ cprRecvFrom (cpr_socket_t soc,
 
     rc = recvfrom(soc, buf, len, flags, (struct sockaddr *)from, fromlen);
     while( rc == -1 && errno == EAGAIN && retry < MAX_RETRY_FOR_EAGAIN ) {
-      cprSleep(100);
+      cprWaitSocketReady(soc, POLLIN);
       retry++;
       rc = recvfrom(soc, buf, len, flags, (struct sockaddr *)from, fromlen);
     }
@@ -530,7 +548,7 @@ cprSend (cpr_socket_t soc,
 
     rc = send(soc, buf, len, flags);
     while( rc == -1 && errno == EAGAIN && retry < MAX_RETRY_FOR_EAGAIN ) {
-      cprSleep(100);
+      cprWaitSocketReady(soc, POLLOUT);
       retry++;
       rc = send(soc, buf, len, flags);
     }
@@ -599,7 +617,7 @@ cprSendTo (cpr_socket_t soc,
 
     rc = sendto(soc, msg, len, flags, (struct sockaddr *)dest_addr, dest_len);
     while( rc == -1 && errno == EAGAIN && retry < MAX_RETRY_FOR_EAGAIN ) {
-      cprSleep(100);
+      cprWaitSocketReady(soc, POLLOUT);
       retry++;
       rc = sendto(soc, msg, len, flags, (struct sockaddr *)dest_addr, dest_len);
     }
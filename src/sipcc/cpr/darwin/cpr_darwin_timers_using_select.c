@@ -96,6 +96,8 @@
 #include "phntask.h"
 #include <errno.h>
 #include <unistd.h>
+#include <sys/time.h>
+#include <mach/mach_time.h>
 #include "cpr_darwin_timers.h"
 
 /*--------------------------------------------------------------------------
@@ -235,6 +237,43 @@ cprSleep (uint32_t duration)
     }
 }
 
+/**
+ * cprGetTimeMs
+ *
+ * @brief Current time in milliseconds, for measuring intervals
+ *
+ * @return milliseconds
+ */
+uint32_t
+cprGetTimeMs (void)
+{
+    struct timeval tv;
+
+    /* no monotonic clock_gettime on this platform */
+    (void) gettimeofday(&tv, NULL);
+    return (uint32_t) ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+}
+
+/**
+ * cprGetTimeUs
+ *
+ * @brief Current time in microseconds, for measuring short intervals
+ *
+ * @return microseconds
+ */
+uint32_t
+cprGetTimeUs (void)
+{
+    static mach_timebase_info_data_t timebase;
+
+    /* the mach clock does not step with the wall clock */
+    if (timebase.denom == 0) {
+        (void) mach_timebase_info(&timebase);
+    }
+    return (uint32_t) ((mach_absolute_time() * timebase.numer) /
+                       (timebase.denom * 1000));
+}
+
 /**
   * @}
   */
@@ -1304,8 +1343,9 @@ void process_expired_timers() {
                         fillInSysHeader(syshdr,
                                         timerListHead->cprTimerPtr->applicationMsgId,
                                         sizeof(cprCallBackTimerMsg_t), timerMsg);
-                        if (cprSendMessage(timerListHead->cprTimerPtr->callBackMsgQueue,
-                                           timerMsg, (void **) &syshdr) == CPR_FAILURE) {
+                        if (cprSendMessageLane(timerListHead->cprTimerPtr->callBackMsgQueue,
+                                               timerMsg, (void **) &syshdr,
+                                               CPR_MSGQ_LANE_CONTROL) == CPR_FAILURE) {
                             cprReleaseSysHeader(syshdr);
                             cprReleaseBuffer(timerMsg);
                             CPR_ERROR("%s - Call to cprSendMessage failed\n", fname);
@@ -56,6 +56,27 @@ typedef void* cprMsgQueue_t;
  */
 #define WAIT_FOREVER -1
 
+/**
+ * Priority lanes of a message queue. A receiver always gets the oldest
+ * message of the most urgent non-empty lane, so timer expirations and
+ * thread control are not stuck behind a burst of bulk notifications.
+ * Messages within a lane stay in FIFO order.
+ */
+typedef enum {
+    CPR_MSGQ_LANE_CONTROL,   /* timer expirations, thread control */
+    CPR_MSGQ_LANE_NORMAL,    /* default lane of cprSendMessage    */
+    CPR_MSGQ_LANE_BULK,      /* notifications and other bulk work */
+    CPR_MSGQ_LANES
+} cpr_msgq_lane_e;
+
+/**
+ * One entry filled in by cprGetMessageBatch
+ */
+typedef struct {
+    void *msg;      /* the message buffer         */
+    void *usrPtr;   /* user data sent with it     */
+} cprMsgBatchEntry_t;
+
 #if defined SIP_OS_LINUX
 #include "../linux/cpr_linux_ipc.h"
 #elif defined SIP_OS_WINDOWS
@@ -194,6 +215,59 @@ cprSendMessage(cprMsgQueue_t msgQueue,
                void* msg,
                void** usrPtr);
 
+/**
+  * cprSendMessageLane
+ * @brief Place a message on a particular lane of a queue
+ *
+ * Same as cprSendMessage, which uses CPR_MSGQ_LANE_NORMAL, but lets the
+ * sender pick the priority lane.
+ *
+ * @param[in] msgQueue   - msg queue on which to place the message
+ * @param[in] msg        - pointer to the msg to place on the queue
+ * @param[in] ppUserData - pointer to a pointer to user defined data
+ * @param[in] lane       - priority lane
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE, errno should be provided
+ *
+ * @note Platforms without lane support (win32) deliver in FIFO order.
+ */
+cprRC_t
+cprSendMessageLane(cprMsgQueue_t msgQueue,
+                   void* msg,
+                   void** usrPtr,
+                   cpr_msgq_lane_e lane);
+
+/**
+  * cprGetMessageBatch
+ * @brief Retrieve up to maxMsgs messages from a message queue
+ *
+ * Waits like cprGetMessage for the first message, then takes whatever
+ * else is already queued, up to maxMsgs, without blocking again. This
+ * lets a task handle a burst per wakeup and run its housekeeping once
+ * per batch.
+ *
+ * @param[in]  msgQueue    - msg queue from which to retrieve the messages
+ * @param[in]  waitForever - wait for the first message (TRUE) or not
+ * @param[out] batch       - array of at least maxMsgs entries
+ * @param[in]  maxMsgs     - maximum number of messages to return
+ *
+ * @return number of messages placed in batch, zero if none
+ */
+uint16_t
+cprGetMessageBatch(cprMsgQueue_t msgQueue,
+                   boolean waitForever,
+                   cprMsgBatchEntry_t *batch,
+                   uint16_t maxMsgs);
+
+/**
+ * cprShowMessageQueueStats
+ * @brief Report statistics, per lane, for all message queues
+ *
+ * @return zero(0)
+ */
+int32_t
+cprShowMessageQueueStats(int32_t argc, const char *argv[]);
+
 __END_DECLS
 
 #endif
@@ -134,6 +134,109 @@ cprGetMutex(cprMutex_t mutex);
 cprRC_t
 cprReleaseMutex(cprMutex_t mutex);
 
+/**
+ * cprAtomicIncrement
+ *
+ * @brief Atomically increment a 32 bit counter
+ *
+ * Full barrier increment, usable for reference counts shared between
+ * the CPR tasks and application threads.
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the incremented value
+ */
+int32_t
+cprAtomicIncrement(volatile int32_t *value);
+
+
+/**
+ * cprAtomicDecrement
+ *
+ * @brief Atomically decrement a 32 bit counter
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the decremented value; zero means the last reference went away
+ */
+int32_t
+cprAtomicDecrement(volatile int32_t *value);
+
+
+/**
+ * cprAtomicRead
+ *
+ * @brief Read a 32 bit counter other threads update with the calls above
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the current value
+ */
+int32_t
+cprAtomicRead(volatile int32_t *value);
+
+
+/**
+ * cprAtomicLoad
+ *
+ * @brief Read a 32 bit value published with cprAtomicStore
+ *
+ * A plain load with acquire ordering: what the storing thread wrote
+ * before the store is visible after it. Cheaper than cprAtomicRead,
+ * which is a full barrier.
+ *
+ * @param[in] value - pointer to the value
+ *
+ * @return the current value
+ */
+int32_t
+cprAtomicLoad(volatile int32_t *value);
+
+
+/**
+ * cprAtomicStore
+ *
+ * @brief Publish a 32 bit value with release ordering
+ *
+ * @param[in] value - pointer to the value
+ * @param[in] newval - the value to store
+ *
+ * @return None
+ */
+void
+cprAtomicStore(volatile int32_t *value, int32_t newval);
+
+
+/**
+ * cprAtomicLoadPtr
+ *
+ * @brief Read a pointer published with cprAtomicStorePtr, acquire ordering
+ *
+ * @param[in] ptr - pointer to the pointer
+ *
+ * @return the current pointer
+ */
+void *
+cprAtomicLoadPtr(void * volatile *ptr);
+
+
+/**
+ * cprAtomicStorePtr
+ *
+ * @brief Publish a pointer
+ *
+ * Full barrier store: what was written before it is visible to a
+ * cprAtomicLoadPtr that sees the new pointer, and loads after it do not
+ * move ahead of it.
+ *
+ * @param[in] ptr - pointer to the pointer
+ * @param[in] newval - the pointer to store
+ *
+ * @return None
+ */
+void
+cprAtomicStorePtr(void * volatile *ptr, void *newval);
+
 
 /**
  * Define handle for conditions
@@ -159,6 +262,74 @@ typedef struct {
 } cpr_signal_t;
 
 
+/**
+ * cprCreateSignal
+ *
+ * @brief Creates a condition
+ *
+ * A condition lets a thread sleep until another thread changes some state
+ * guarded by a CPR mutex. The waiter re-checks that state after every
+ * wakeup, since a wakeup only means it may have changed.
+ *
+ * @param[in] name  - name of the condition, to assist in debugging
+ *
+ * @return Condition handle or NULL if creation failed. If NULL, set errno
+ */
+cprSignal_t
+cprCreateSignal(const char *name);
+
+
+/**
+ * cprDestroySignal
+ *
+ * @brief Destroys the condition passed in
+ *
+ * No thread may be waiting on the condition when it is destroyed.
+ *
+ * @param[in] signal - condition to destroy
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE. errno should be set for CPR_FAILURE.
+ */
+cprRC_t
+cprDestroySignal(cprSignal_t signal);
+
+
+/**
+ * cprWaitSignal
+ *
+ * @brief Wait for a condition to be posted
+ *
+ * Releases the mutex, which the caller must hold, and sleeps until the
+ * condition is posted or the timeout passes. The mutex is held again when
+ * the function returns, whatever the result.
+ *
+ * @param[in] signal  - condition to wait on
+ * @param[in] mutex   - mutex guarding the state the caller waits for
+ * @param[in] timeout - longest wait in milliseconds
+ *
+ * @return CPR_SUCCESS if woken, CPR_FAILURE on timeout (errno ETIMEDOUT)
+ *         or error
+ */
+cprRC_t
+cprWaitSignal(cprSignal_t signal, cprMutex_t mutex, uint32_t timeout);
+
+
+/**
+ * cprPostSignal
+ *
+ * @brief Wake the threads waiting on a condition
+ *
+ * Post while holding the mutex the waiters use, after changing the state
+ * they wait for.
+ *
+ * @param[in] signal - condition to post
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE
+ */
+cprRC_t
+cprPostSignal(cprSignal_t signal);
+
+
 __END_DECLS
 
 #endif
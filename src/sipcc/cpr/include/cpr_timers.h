@@ -86,6 +86,30 @@ typedef struct {
  */
 void cprSleep(uint32_t duration);
 
+/**
+ * cprGetTimeMs
+ *
+ * @brief Current time in milliseconds
+ * Reads a monotonic clock, so the value is only meaningful for measuring
+ * intervals. It wraps after about 49 days; unsigned subtraction of two
+ * readings still gives the right interval.
+ *
+ * @return milliseconds
+ */
+uint32_t cprGetTimeMs(void);
+
+/**
+ * cprGetTimeUs
+ *
+ * @brief Current time in microseconds
+ * Same monotonic clock as cprGetTimeMs, at microsecond resolution. It
+ * wraps after about 71 minutes, so it is only good for short intervals
+ * such as the time a message spends on a queue.
+ *
+ * @return microseconds
+ */
+uint32_t cprGetTimeUs(void);
+
 
 /**
  * cprCreateTimer
@@ -56,6 +56,13 @@
  * enabled by extending the message queue by some size greater than
  * zero (0).
  *
+ * Each queue carries CPR_MSGQ_LANES priority lanes. The lane is encoded
+ * in the System V message type and msgrcv is asked for the lowest type
+ * first, so the kernel hands out control lane messages ahead of normal
+ * and bulk ones while keeping FIFO order within a lane. Messages parked
+ * on the extended queue keep their lane but are re-posted in arrival
+ * order.
+ *
  * @defgroup IPC The Inter Process Communication module
  * @ingroup CPR
  * @brief The module related to IPC abstraction for the pSIPCC
@@ -69,6 +76,8 @@
  */
 #include "cpr.h"
 #include "cpr_stdlib.h"
+#include "cpr_string.h"
+#include "cpr_timers.h"
 #include <cpr_stdio.h>
 #include <errno.h>
 #include <sys/msg.h>
@@ -97,6 +106,8 @@ typedef struct cpr_msgq_node_s
     struct cpr_msgq_node_s *prev;
     void *msg;
     void *pUserData;
+    cpr_msgq_lane_e lane;
+    uint32_t sendTime;
 } cpr_msgq_node_t;
 
 /**
@@ -131,6 +142,7 @@ typedef struct cpr_msg_queue_s
     pthread_mutex_t mutex;       /* lock for managing extended queue     */
     cpr_msgq_node_t *head;       /* extended queue head (newest element) */
     cpr_msgq_node_t *tail;       /* extended queue tail (oldest element) */
+    cprMsgQueueLaneStats_t lanes[CPR_MSGQ_LANES];
 } cpr_msg_queue_t;
 
 /**
@@ -214,11 +226,18 @@ static const char unnamed_string[] = "unnamed";
  * Prototype declarations
  */
 static cpr_msgq_post_result_e
-cprPostMessage(cpr_msg_queue_t *msgq, void *msg, void **ppUserData);
+cprPostMessage(cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+               cpr_msgq_lane_e lane, uint32_t sendTime);
 static void
 cprPegSendMessageStats(cpr_msg_queue_t *msgq, uint16_t numAttempts);
+static void
+cprPegLaneSendStats(cpr_msg_queue_t *msgq, cpr_msgq_lane_e lane);
+static void
+cprPegLaneReceiveStats(cpr_msg_queue_t *msgq, cpr_msgq_lane_e lane,
+                       uint32_t sendTime);
 static cpr_msgq_post_result_e
-cprPostExtendedQMsg(cpr_msg_queue_t *msgq, void *msg, void **ppUserData);
+cprPostExtendedQMsg(cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+                    cpr_msgq_lane_e lane, uint32_t sendTime);
 static void
 cprMoveMsgToQueue(cpr_msg_queue_t *msgq);
 
@@ -521,9 +540,13 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
         msgrcvflags = IPC_NOWAIT;
     }
 
+    /*
+     * A negative type asks for the lowest message type up to the last
+     * lane, i.e. the most urgent lane that has something queued.
+     */
     if (msgrcv(msgq->queueId, rcvMsg,
         sizeof(struct msgbuffer) - offsetof(struct msgbuffer, msgPtr),
-        0, msgrcvflags) == -1) {
+        -(CPR_IPC_MSG + CPR_MSGQ_LANES - 1), msgrcvflags) == -1) {
     	if (!waitForever && errno == ENOMSG) {
     		CPR_INFO("%s: no message on queue %s (non-blocking receive "
                          " operation), returning\n", fname, msgq->name);
@@ -538,6 +561,8 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
     (void) pthread_mutex_lock(&msgq->mutex);
     /* Update statistics */
     msgq->currentCount--;
+    cprPegLaneReceiveStats(msgq, (cpr_msgq_lane_e) (rcvMsg->mtype - CPR_IPC_MSG),
+                           rcvMsg->sendTime);
     (void) pthread_mutex_unlock(&msgq->mutex);
 
     /*
@@ -559,6 +584,53 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
     return buffer;
 }
 
+/**
+  * cprGetMessageBatch
+ * @brief Retrieve up to maxMsgs messages from a message queue
+ *
+ * Waits like cprGetMessage for the first message, then takes whatever
+ * else is already queued, up to maxMsgs, without blocking again.
+ *
+ * @param[in]  msgQueue    - msg queue from which to retrieve the messages
+ * @param[in]  waitForever - wait for the first message (TRUE) or not
+ * @param[out] batch       - array of at least maxMsgs entries
+ * @param[in]  maxMsgs     - maximum number of messages to return
+ *
+ * @return number of messages placed in batch, zero if none
+ */
+uint16_t
+cprGetMessageBatch (cprMsgQueue_t msgQueue, boolean waitForever,
+                    cprMsgBatchEntry_t *batch, uint16_t maxMsgs)
+{
+    cpr_msg_queue_t *msgq = (cpr_msg_queue_t *) msgQueue;
+    uint16_t count = 0;
+    uint16_t depth;
+    void *msg;
+
+    if ((msgq == NULL) || (batch == NULL) || (maxMsgs == 0)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    msg = cprGetMessage(msgQueue, waitForever, &batch[0].usrPtr);
+    while (msg != NULL) {
+        batch[count].msg = msg;
+        count++;
+        if (count == maxMsgs) {
+            break;
+        }
+        /* currentCount is updated by senders under the queue lock */
+        (void) pthread_mutex_lock(&msgq->mutex);
+        depth = msgq->currentCount;
+        (void) pthread_mutex_unlock(&msgq->mutex);
+        if (depth == 0) {
+            break;
+        }
+        msg = cprGetMessage(msgQueue, FALSE, &batch[count].usrPtr);
+    }
+    return count;
+}
+
 
 /**
   * cprSendMessage
@@ -596,21 +668,44 @@ cprGetMessage (cprMsgQueue_t msgQueue, boolean waitForever, void **ppUserData)
 cprRC_t
 cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
 {
-    static const char fname[] = "cprSendMessage";
+    return cprSendMessageLane(msgQueue, msg, ppUserData, CPR_MSGQ_LANE_NORMAL);
+}
+
+/**
+  * cprSendMessageLane
+ * @brief Place a message on a particular lane of a queue
+ *
+ * Same as cprSendMessage, which uses CPR_MSGQ_LANE_NORMAL, but lets the
+ * sender pick the priority lane.
+ *
+ * @param[in] msgQueue   - msg queue on which to place the message
+ * @param[in] msg        - pointer to the msg to place on the queue
+ * @param[in] ppUserData - pointer to a pointer to user defined data
+ * @param[in] lane       - priority lane
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE, errno should be provided
+ */
+cprRC_t
+cprSendMessageLane (cprMsgQueue_t msgQueue, void *msg, void **ppUserData,
+                    cpr_msgq_lane_e lane)
+{
+    static const char fname[] = "cprSendMessageLane";
     static const char error_str[] = "%s: Msg not sent to %s queue: %s\n";
     cpr_msgq_post_result_e rc;
     cpr_msg_queue_t *msgq;
     int16_t attemptsToSend = CPR_ATTEMPTS_TO_SEND;
     uint16_t numAttempts   = 0;
+    uint32_t sendTime;
 
     /* Bad application? */
-    if (msgQueue == NULL) {
+    if ((msgQueue == NULL) || (lane >= CPR_MSGQ_LANES)) {
         CPR_ERROR(error_str, fname, "undefined", "invalid input");
         errno = EINVAL;
         return CPR_FAILURE;
     }
 
     msgq = (cpr_msg_queue_t *) msgQueue;
+    sendTime = cprGetTimeMs();
 
     /* 
      * Attempt to send message
@@ -628,7 +723,10 @@ cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
              * attempt to add the message.
              */
             if (msgq->extendedQDepth < msgq->maxExtendedQDepth) {
-                rc = cprPostExtendedQMsg(msgq, msg, ppUserData);
+                rc = cprPostExtendedQMsg(msgq, msg, ppUserData, lane, sendTime);
+                if (rc == CPR_MSGQ_POST_SUCCESS) {
+                    cprPegLaneSendStats(msgq, lane);
+                }
 
                 (void) pthread_mutex_unlock(&msgq->mutex);
 
@@ -666,7 +764,7 @@ cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
             /*
              * Normal posting of message
              */
-            rc = cprPostMessage(msgq, msg, ppUserData);
+            rc = cprPostMessage(msgq, msg, ppUserData, lane, sendTime);
 
             /*
              * Before releasing the mutex, check if the
@@ -679,9 +777,13 @@ cprSendMessage (cprMsgQueue_t msgQueue, void *msg, void **ppUserData)
                  * support, then attempt to add to the extended queue.
                  */
                 if (msgq->maxExtendedQDepth) {
-                    rc = cprPostExtendedQMsg(msgq, msg, ppUserData);
+                    rc = cprPostExtendedQMsg(msgq, msg, ppUserData, lane,
+                                             sendTime);
                 }
             }
+            if (rc == CPR_MSGQ_POST_SUCCESS) {
+                cprPegLaneSendStats(msgq, lane);
+            }
 
             (void) pthread_mutex_unlock(&msgq->mutex);
 
@@ -769,6 +871,65 @@ cprPegSendMessageStats (cpr_msg_queue_t *msgq, uint16_t numAttempts)
     }
 }
 
+/**
+ * cprPegLaneSendStats
+ * @brief Peg the lane statistics for a message that was queued
+ *
+ * @param[in] msgq - message queue
+ * @param[in] lane - lane the message was queued on
+ *
+ * @return none
+ *
+ * @pre (msgq != NULL)
+ * @pre (msgq->mutex has been locked)
+ */
+static void
+cprPegLaneSendStats (cpr_msg_queue_t *msgq, cpr_msgq_lane_e lane)
+{
+    cprMsgQueueLaneStats_t *stats = &msgq->lanes[lane];
+
+    stats->totalCount++;
+    stats->currentCount++;
+    if (stats->currentCount > stats->maxCount) {
+        stats->maxCount = stats->currentCount;
+    }
+}
+
+/**
+ * cprPegLaneReceiveStats
+ * @brief Peg the lane statistics for a message that was taken off
+ *
+ * @param[in] msgq     - message queue
+ * @param[in] lane     - lane the message was queued on
+ * @param[in] sendTime - cprGetTimeMs() when the message was queued
+ *
+ * @return none
+ *
+ * @pre (msgq != NULL)
+ * @pre (msgq->mutex has been locked)
+ */
+static void
+cprPegLaneReceiveStats (cpr_msg_queue_t *msgq, cpr_msgq_lane_e lane,
+                        uint32_t sendTime)
+{
+    cprMsgQueueLaneStats_t *stats;
+    uint32_t latency;
+
+    if (lane >= CPR_MSGQ_LANES) {
+        return;
+    }
+    stats = &msgq->lanes[lane];
+    latency = cprGetTimeMs() - sendTime;
+
+    if (stats->currentCount) {
+        stats->currentCount--;
+    }
+    stats->totalLatency += latency;
+    if (latency > stats->maxLatency) {
+        stats->maxLatency = latency;
+    }
+}
+
 /**
  * cprPostMessage
  * @brief Post message to system message queue
@@ -776,6 +937,8 @@ cprPegSendMessageStats (cpr_msg_queue_t *msgq, uint16_t numAttempts)
  * @param[in] msgq       - message queue
  * @param[in] msg        - message to post
  * @param[in] ppUserData - ptr to ptr to option user data
+ * @param[in] lane       - priority lane
+ * @param[in] sendTime   - cprGetTimeMs() when first queued
  *
  * @return the post result which is CPR_MSGQ_POST_SUCCESS,
  *         CPR_MSGQ_POST_FAILURE or CPR_MSGQ_POST_PENDING
@@ -784,7 +947,8 @@ cprPegSendMessageStats (cpr_msg_queue_t *msgq, uint16_t numAttempts)
  * @pre (msg != NULL)
  */
 static cpr_msgq_post_result_e
-cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
+cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+                cpr_msgq_lane_e lane, uint32_t sendTime)
 {
     struct msgbuffer mbuf;
 
@@ -793,8 +957,9 @@ cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
      * Copy the address of the msg buffer into the mtext
      * portion of the message.
      */
-    mbuf.mtype = CPR_IPC_MSG;
+    mbuf.mtype = CPR_IPC_MSG + lane;
     mbuf.msgPtr = msg;
+    mbuf.sendTime = sendTime;
 
     if (ppUserData != NULL) {
         mbuf.usrPtr = *ppUserData;
@@ -830,6 +995,8 @@ cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
  * @param[in] msgq       - message queue
  * @param[in] msg        - message to post
  * @param[in] ppUserData - ptr to ptr to option user data
+ * @param[in] lane       - priority lane
+ * @param[in] sendTime   - cprGetTimeMs() when queued
  *
  * @return the post result which is CPR_MSGQ_POST_SUCCESS or
  *         CPR_MSGQ_POST_FAILURE if no memory available
@@ -844,7 +1011,8 @@ cprPostMessage (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
  *       may not be necessary
  */
 static cpr_msgq_post_result_e
-cprPostExtendedQMsg (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
+cprPostExtendedQMsg (cpr_msg_queue_t *msgq, void *msg, void **ppUserData,
+                     cpr_msgq_lane_e lane, uint32_t sendTime)
 {
     cpr_msgq_node_t *node;
 
@@ -866,6 +1034,8 @@ cprPostExtendedQMsg (cpr_msg_queue_t *msgq, void *msg, void **ppUserData)
     } else {
         node->pUserData = NULL;
     }
+    node->lane = lane;
+    node->sendTime = sendTime;
 
     /*
      * Push onto list
@@ -917,7 +1087,8 @@ cprMoveMsgToQueue (cpr_msg_queue_t *msgq)
 
     node = msgq->tail;
 
-    rc = cprPostMessage(msgq, node->msg, &node->pUserData);
+    rc = cprPostMessage(msgq, node->msg, &node->pUserData, node->lane,
+                        node->sendTime);
     if (rc == CPR_MSGQ_POST_SUCCESS) {
         /*
          * Remove node from extended list
@@ -975,3 +1146,61 @@ uint16_t cprGetDepth (cprMsgQueue_t msgQueue)
         return msgq->currentCount;
 }
 
+/**
+ * cprShowMessageQueueStats
+ *
+ * @brief Report statistics for all message queues
+ *
+ * Prints the queue totals followed by the depth and queueing latency of
+ * each priority lane.
+ *
+ * @param[in] argc - not used
+ * @param[in] argv - not used
+ *
+ * @return zero(0)
+ *
+ * @note Prototype is 'canned' so return of zero is necessary
+ */
+int32_t
+cprShowMessageQueueStats (int32_t argc, const char *argv[])
+{
+    static const char *lane_names[CPR_MSGQ_LANES] = {
+        "control", "normal", "bulk"
+    };
+    cpr_msg_queue_t *msgq;
+    cprMsgQueueLaneStats_t *lane;
+    uint32_t received;
+    int i;
+
+    debugif_printf("CPR Message Queues\n");
+
+    pthread_mutex_lock(&msgQueueListMutex);
+    msgq = msgQueueList;
+    while (msgq != NULL) {
+        debugif_printf("Name: %s\n", msgq->name);
+        debugif_printf("   extended depth: %d\n", msgq->maxExtendedQDepth);
+        debugif_printf("   max: %d\n", msgq->maxCount);
+        debugif_printf("   active: %d\n", msgq->currentCount);
+        debugif_printf("   total: %d\n", msgq->totalCount);
+        debugif_printf("   retries: %d\n", msgq->reTries);
+        debugif_printf("   high attempts: %d\n", msgq->highAttempts);
+        debugif_printf("   send errors: %d\n", msgq->sendErrors);
+        debugif_printf("   self queue errors: %d\n", msgq->selfQErrors);
+        for (i = 0; i < CPR_MSGQ_LANES; i++) {
+            lane = &msgq->lanes[i];
+            received = lane->totalCount - lane->currentCount;
+            debugif_printf("   %-7s lane: active %d max %d total %d"
+                           " avg wait %d ms max wait %d ms\n",
+                           lane_names[i], lane->currentCount, lane->maxCount,
+                           lane->totalCount,
+                           received ? lane->totalLatency / received : 0,
+                           lane->maxLatency);
+        }
+        debugif_printf("\n");
+
+        msgq = msgq->next;
+    }
+    pthread_mutex_unlock(&msgQueueListMutex);
+
+    return 0;
+}
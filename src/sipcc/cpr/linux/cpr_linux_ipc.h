@@ -49,17 +49,30 @@
 /* Maximum message size allowed by CNU */
 #define CPR_MAX_MSG_SIZE  4096
 
-/* Our CNU msgtype */
+/* Our CNU msgtype, lanes use CPR_IPC_MSG + lane */
 #define CPR_IPC_MSG 1
 
 
-/* Message buffer layout */
+/*
+ * Message buffer layout. mtype must be a long as msgsnd/msgrcv expect;
+ * the receive selects lanes by type, so no bits of it may be left unset.
+ */
 struct msgbuffer {
-    int32_t mtype;    /* Message type */
+    long    mtype;    /* Message type */
     void   *msgPtr;   /* Ptr to msg */
     void   *usrPtr;   /* Ptr to user data */
+    uint32_t sendTime; /* cprGetTimeMs() when queued */
 };
 
+/* Per lane statistics of a message queue */
+typedef struct {
+    uint16_t currentCount;
+    uint16_t maxCount;
+    uint32_t totalCount;
+    uint32_t totalLatency;    /* msec spent queued, all messages */
+    uint32_t maxLatency;      /* msec, worst single message      */
+} cprMsgQueueLaneStats_t;
+
 /* For gathering statistics regarding message queues */
 typedef struct {
     char name[16];
@@ -72,6 +85,7 @@ typedef struct {
     uint32_t highAttempts;
     uint32_t selfQErrors;
     uint16_t extendedDepth;
+    cprMsgQueueLaneStats_t lanes[CPR_MSGQ_LANES];
 } cprMsgQueueStats_t;
 
 
@@ -43,6 +43,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <sys/time.h>
+#include <time.h>
 
 /**
   * @defgroup MutexIPCAPIs The Mutex/Semaphore IPC APIs
@@ -242,3 +243,288 @@ cprReleaseMutex (cprMutex_t mutex)
     return CPR_FAILURE;
 }
 
+
+/**
+ * cprAtomicIncrement
+ *
+ * @brief Atomically increment a 32 bit counter
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the incremented value
+ */
+int32_t
+cprAtomicIncrement (volatile int32_t *value)
+{
+    return __sync_add_and_fetch(value, 1);
+}
+
+
+/**
+ * cprAtomicDecrement
+ *
+ * @brief Atomically decrement a 32 bit counter
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the decremented value
+ */
+int32_t
+cprAtomicDecrement (volatile int32_t *value)
+{
+    return __sync_sub_and_fetch(value, 1);
+}
+
+
+/**
+ * cprAtomicRead
+ *
+ * @brief Read a 32 bit counter updated with cprAtomicIncrement/Decrement
+ *
+ * @param[in] value - pointer to the counter
+ *
+ * @return the current value
+ */
+int32_t
+cprAtomicRead (volatile int32_t *value)
+{
+    return __sync_fetch_and_add(value, 0);
+}
+
+
+/**
+ * cprAtomicLoad
+ *
+ * @brief Read a 32 bit value published with cprAtomicStore
+ *
+ * @param[in] value - pointer to the value
+ *
+ * @return the current value
+ */
+int32_t
+cprAtomicLoad (volatile int32_t *value)
+{
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * cprAtomicStore
+ *
+ * @brief Publish a 32 bit value with release ordering
+ *
+ * @param[in] value - pointer to the value
+ * @param[in] newval - the value to store
+ *
+ * @return None
+ */
+void
+cprAtomicStore (volatile int32_t *value, int32_t newval)
+{
+    __atomic_store_n(value, newval, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * cprAtomicLoadPtr
+ *
+ * @brief Read a pointer published with cprAtomicStorePtr
+ *
+ * @param[in] ptr - pointer to the pointer
+ *
+ * @return the current pointer
+ */
+void *
+cprAtomicLoadPtr (void * volatile *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * cprAtomicStorePtr
+ *
+ * @brief Publish a pointer, full barrier
+ *
+ * @param[in] ptr - pointer to the pointer
+ * @param[in] newval - the pointer to store
+ *
+ * @return None
+ */
+void
+cprAtomicStorePtr (void * volatile *ptr, void *newval)
+{
+    __atomic_store_n(ptr, newval, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * cprCreateSignal
+ *
+ * @brief Creates a condition
+ *
+ * The condition waits against the monotonic clock, so a change of the
+ * time of day does not stretch or cut short a timed wait.
+ *
+ * @param[in] name  - name of the condition, to assist in debugging
+ *
+ * @return Condition handle or NULL if creation failed. If NULL, set errno
+ */
+cprSignal_t
+cprCreateSignal (const char *name)
+{
+    static const char fname[] = "cprCreateSignal";
+    static uint16_t id = 0;
+    int32_t returnCode;
+    cpr_signal_t *cprSignalPtr;
+    pthread_cond_t *pthreadCondPtr;
+    pthread_condattr_t attr;
+
+    cprSignalPtr = (cpr_signal_t *) cpr_malloc(sizeof(cpr_signal_t));
+    pthreadCondPtr = (pthread_cond_t *) cpr_malloc(sizeof(pthread_cond_t));
+    if ((cprSignalPtr == NULL) || (pthreadCondPtr == NULL)) {
+        cpr_free(pthreadCondPtr);
+        cpr_free(cprSignalPtr);
+        CPR_ERROR("%s - Malloc for condition %s failed.\n", fname, name);
+        errno = ENOMEM;
+        return (cprSignal_t)NULL;
+    }
+
+    (void) pthread_condattr_init(&attr);
+    (void) pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    returnCode = pthread_cond_init(pthreadCondPtr, &attr);
+    (void) pthread_condattr_destroy(&attr);
+    if (returnCode != 0) {
+        CPR_ERROR("%s - Failure trying to init condition %s: %d\n",
+                  fname, name, returnCode);
+        cpr_free(pthreadCondPtr);
+        cpr_free(cprSignalPtr);
+        return (cprSignal_t)NULL;
+    }
+
+    cprSignalPtr->name = name;
+    cprSignalPtr->u.handlePtr = pthreadCondPtr;
+    cprSignalPtr->lockId = ++id;
+    return (cprSignal_t)cprSignalPtr;
+}
+
+
+/**
+ * cprDestroySignal
+ *
+ * @brief Destroys the condition passed in
+ *
+ * @param[in] signal - condition to destroy
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE. errno should be set for CPR_FAILURE.
+ */
+cprRC_t
+cprDestroySignal (cprSignal_t signal)
+{
+    static const char fname[] = "cprDestroySignal";
+    cpr_signal_t *cprSignalPtr;
+    int32_t rc;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    if (cprSignalPtr != NULL) {
+        rc = pthread_cond_destroy(cprSignalPtr->u.handlePtr);
+        if (rc != 0) {
+            CPR_ERROR("%s - Failure destroying condition %s: %d\n",
+                      fname, cprSignalPtr->name, rc);
+            return CPR_FAILURE;
+        }
+        cprSignalPtr->lockId = 0;
+        cpr_free(cprSignalPtr->u.handlePtr);
+        cpr_free(cprSignalPtr);
+        return CPR_SUCCESS;
+    }
+
+    CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+    errno = EINVAL;
+    return CPR_FAILURE;
+}
+
+
+/**
+ * cprWaitSignal
+ *
+ * @brief Wait for a condition to be posted
+ *
+ * @param[in] signal  - condition to wait on
+ * @param[in] mutex   - mutex guarding the state the caller waits for, held
+ * @param[in] timeout - longest wait in milliseconds
+ *
+ * @return CPR_SUCCESS if woken, CPR_FAILURE on timeout (errno ETIMEDOUT)
+ *         or error
+ */
+cprRC_t
+cprWaitSignal (cprSignal_t signal, cprMutex_t mutex, uint32_t timeout)
+{
+    static const char fname[] = "cprWaitSignal";
+    cpr_signal_t *cprSignalPtr;
+    cpr_mutex_t *cprMutexPtr;
+    struct timespec deadline;
+    int32_t rc;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    cprMutexPtr = (cpr_mutex_t *) mutex;
+    if ((cprSignalPtr == NULL) || (cprMutexPtr == NULL)) {
+        CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+        errno = EINVAL;
+        return CPR_FAILURE;
+    }
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long) (timeout % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    rc = pthread_cond_timedwait((pthread_cond_t *) cprSignalPtr->u.handlePtr,
+                                (pthread_mutex_t *) cprMutexPtr->u.handlePtr,
+                                &deadline);
+    if (rc == 0) {
+        return CPR_SUCCESS;
+    }
+    if (rc != ETIMEDOUT) {
+        CPR_ERROR("%s - Error waiting on condition %s: %d\n",
+                  fname, cprSignalPtr->name, rc);
+    }
+    errno = rc;
+    return CPR_FAILURE;
+}
+
+
+/**
+ * cprPostSignal
+ *
+ * @brief Wake the threads waiting on a condition
+ *
+ * @param[in] signal - condition to post
+ *
+ * @return CPR_SUCCESS or CPR_FAILURE
+ */
+cprRC_t
+cprPostSignal (cprSignal_t signal)
+{
+    static const char fname[] = "cprPostSignal";
+    cpr_signal_t *cprSignalPtr;
+    int32_t rc;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    if (cprSignalPtr != NULL) {
+        rc = pthread_cond_broadcast((pthread_cond_t *) cprSignalPtr->u.handlePtr);
+        if (rc != 0) {
+            CPR_ERROR("%s - Error posting condition %s: %d\n",
+                      fname, cprSignalPtr->name, rc);
+            return CPR_FAILURE;
+        }
+        return CPR_SUCCESS;
+    }
+
+    CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+    errno = EINVAL;
+    return CPR_FAILURE;
+}
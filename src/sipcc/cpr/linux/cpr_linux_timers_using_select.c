@@ -94,6 +94,7 @@
 #include "phntask.h"
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
 #include "cpr_linux_timers.h"
 
 /*--------------------------------------------------------------------------
@@ -233,6 +234,38 @@ cprSleep (uint32_t duration)
     }
 }
 
+/**
+ * cprGetTimeMs
+ *
+ * @brief Current time in milliseconds, for measuring intervals
+ *
+ * @return milliseconds
+ */
+uint32_t
+cprGetTimeMs (void)
+{
+    struct timespec ts;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+
+/**
+ * cprGetTimeUs
+ *
+ * @brief Current time in microseconds, for measuring short intervals
+ *
+ * @return microseconds
+ */
+uint32_t
+cprGetTimeUs (void)
+{
+    struct timespec ts;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000));
+}
+
 /**
   * @}
   */
@@ -1302,8 +1335,9 @@ void process_expired_timers() {
                         fillInSysHeader(syshdr,
                                         timerListHead->cprTimerPtr->applicationMsgId,
                                         sizeof(cprCallBackTimerMsg_t), timerMsg);
-                        if (cprSendMessage(timerListHead->cprTimerPtr->callBackMsgQueue,
-                                           timerMsg, (void **) &syshdr) == CPR_FAILURE) {
+                        if (cprSendMessageLane(timerListHead->cprTimerPtr->callBackMsgQueue,
+                                               timerMsg, (void **) &syshdr,
+                                               CPR_MSGQ_LANE_CONTROL) == CPR_FAILURE) {
                             cprReleaseSysHeader(syshdr);
                             cprReleaseBuffer(timerMsg);
                             CPR_ERROR("%s - Call to cprSendMessage failed\n", fname);
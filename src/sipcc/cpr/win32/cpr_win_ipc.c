@@ -203,6 +203,30 @@ cprSendMessage (cprMsgQueue_t msgQueue,
 	return CPR_SUCCESS;
 }
 
+/**
+ * cprSendMessageLane
+ *
+ * Place a message on a particular lane of a queue
+ *
+ * Parameters: msgQueue  - which queue on which to place the message
+ *             msg       - pointer to the msg to place on the queue
+ *             usrPtr    - pointer to a pointer to user defined data
+ *             lane      - priority lane
+ *
+ * Return Value: see cprSendMessage
+ *
+ * Comments: thread message queues have no priorities, so every lane is
+ *           delivered in FIFO order on this platform.
+ */
+cprRC_t
+cprSendMessageLane (cprMsgQueue_t msgQueue,
+                    void *msg,
+                    void **usrPtr,
+                    cpr_msgq_lane_e lane)
+{
+    return cprSendMessage(msgQueue, msg, usrPtr);
+}
+
 void cjni_exit_thread();
 
 /**
@@ -314,3 +338,42 @@ cprGetMessage (cprMsgQueue_t msgQueue,
     return (void *)bufferPtr;
 }
 
+/**
+ * cprGetMessageBatch
+ *
+ * Retrieve up to maxMsgs messages from a message queue
+ *
+ * Parameters: msgQueue    - which queue from which to retrieve the messages
+ *             waitForever - wait for the first message (TRUE) or not
+ *             batch       - array of at least maxMsgs entries [OUT]
+ *             maxMsgs     - maximum number of messages to return
+ *
+ * Return Value: number of messages placed in batch
+ *
+ * Comments: stops at the first thread message that is not a queued
+ *           buffer (timer, echo), as cprGetMessage returns NULL for those.
+ */
+uint16_t
+cprGetMessageBatch (cprMsgQueue_t msgQueue,
+                    boolean waitForever,
+                    cprMsgBatchEntry_t *batch,
+                    uint16_t maxMsgs)
+{
+    uint16_t count = 0;
+    void *msg;
+
+    if ((batch == NULL) || (maxMsgs == 0)) {
+        return 0;
+    }
+
+    msg = cprGetMessage(msgQueue, waitForever, &batch[0].usrPtr);
+    while (msg != NULL) {
+        batch[count].msg = msg;
+        count++;
+        if (count == maxMsgs) {
+            break;
+        }
+        msg = cprGetMessage(msgQueue, FALSE, &batch[count].usrPtr);
+    }
+    return count;
+}
@@ -225,3 +225,282 @@ cprReleaseMutex (cprMutex_t mutex)
     }
 }
 
+
+/**
+ * cprAtomicIncrement
+ *
+ * Atomically increment a 32 bit counter
+ *
+ * Parameters: value - pointer to the counter
+ *
+ * Return Value: the incremented value
+ */
+int32_t
+cprAtomicIncrement (volatile int32_t *value)
+{
+    return (int32_t) InterlockedIncrement((volatile LONG *) value);
+}
+
+
+/**
+ * cprAtomicDecrement
+ *
+ * Atomically decrement a 32 bit counter
+ *
+ * Parameters: value - pointer to the counter
+ *
+ * Return Value: the decremented value
+ */
+int32_t
+cprAtomicDecrement (volatile int32_t *value)
+{
+    return (int32_t) InterlockedDecrement((volatile LONG *) value);
+}
+
+
+/**
+ * cprAtomicRead
+ *
+ * Read a 32 bit counter updated with cprAtomicIncrement/Decrement
+ *
+ * Parameters: value - pointer to the counter
+ *
+ * Return Value: the current value
+ */
+int32_t
+cprAtomicRead (volatile int32_t *value)
+{
+    return (int32_t) InterlockedCompareExchange((volatile LONG *) value, 0, 0);
+}
+
+
+/**
+ * cprAtomicLoad
+ *
+ * Read a 32 bit value published with cprAtomicStore. MSVC gives
+ * volatile reads acquire semantics.
+ *
+ * Parameters: value - pointer to the value
+ *
+ * Return Value: the current value
+ */
+int32_t
+cprAtomicLoad (volatile int32_t *value)
+{
+    return *value;
+}
+
+
+/**
+ * cprAtomicStore
+ *
+ * Publish a 32 bit value
+ *
+ * Parameters: value - pointer to the value
+ *             newval - the value to store
+ *
+ * Return Value: None
+ */
+void
+cprAtomicStore (volatile int32_t *value, int32_t newval)
+{
+    (void) InterlockedExchange((volatile LONG *) value, (LONG) newval);
+}
+
+
+/**
+ * cprAtomicLoadPtr
+ *
+ * Read a pointer published with cprAtomicStorePtr
+ *
+ * Parameters: ptr - pointer to the pointer
+ *
+ * Return Value: the current pointer
+ */
+void *
+cprAtomicLoadPtr (void * volatile *ptr)
+{
+    return *ptr;
+}
+
+
+/**
+ * cprAtomicStorePtr
+ *
+ * Publish a pointer, full barrier
+ *
+ * Parameters: ptr - pointer to the pointer
+ *             newval - the pointer to store
+ *
+ * Return Value: None
+ */
+void
+cprAtomicStorePtr (void * volatile *ptr, void *newval)
+{
+    (void) InterlockedExchangePointer((PVOID volatile *) ptr, newval);
+}
+
+
+/**
+ * cprCreateSignal
+ *
+ * Creates a condition. Windows XP has no condition variables, so waiters
+ * queue on a semaphore and a post releases one count per waiter.
+ *
+ * Parameters: name - name of the condition
+ *
+ * Return Value: Condition handle or NULL if creation failed.
+ */
+cprSignal_t
+cprCreateSignal (const char *name)
+{
+    static const char fname[] = "cprCreateSignal";
+    cpr_signal_t *cprSignalPtr;
+    cpr_condition_t *cond;
+
+    cprSignalPtr = (cpr_signal_t *) cpr_malloc(sizeof(cpr_signal_t));
+    cond = (cpr_condition_t *) cpr_malloc(sizeof(cpr_condition_t));
+    if ((cprSignalPtr == NULL) || (cond == NULL)) {
+        cpr_free(cond);
+        cpr_free(cprSignalPtr);
+        CPR_ERROR("%s - Malloc for condition failed.\n", fname);
+        return NULL;
+    }
+
+    cond->noWaiters = 0;
+    InitializeCriticalSection(&cond->noWaitersLock);
+    cond->sema = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+    if (cond->sema == NULL) {
+        CPR_ERROR("%s - Condition init failure: %d\n", fname, GetLastError());
+        DeleteCriticalSection(&cond->noWaitersLock);
+        cpr_free(cond);
+        cpr_free(cprSignalPtr);
+        return NULL;
+    }
+
+    cprSignalPtr->name = name;
+    cprSignalPtr->u.handlePtr = cond;
+    return cprSignalPtr;
+}
+
+
+/**
+ * cprDestroySignal
+ *
+ * Destroys the condition passed in
+ *
+ * Parameters: signal - condition to destroy
+ *
+ * Return Value: Success or failure indication
+ */
+cprRC_t
+cprDestroySignal (cprSignal_t signal)
+{
+    static const char fname[] = "cprDestroySignal";
+    cpr_signal_t *cprSignalPtr;
+    cpr_condition_t *cond;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    if (cprSignalPtr != NULL) {
+        cond = (cpr_condition_t *) cprSignalPtr->u.handlePtr;
+        CloseHandle(cond->sema);
+        DeleteCriticalSection(&cond->noWaitersLock);
+        cpr_free(cond);
+        cpr_free(cprSignalPtr);
+        return (CPR_SUCCESS);
+    }
+
+    CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+    return (CPR_FAILURE);
+}
+
+
+/**
+ * cprWaitSignal
+ *
+ * Releases the mutex, which the caller holds, and waits for the condition
+ * to be posted or the timeout to pass. The mutex is held again on return.
+ * A post that finds no waiter may leave a count behind, which shows up as
+ * an early wakeup; callers re-check their state after every wakeup.
+ *
+ * Parameters: signal  - condition to wait on
+ *             mutex   - mutex guarding the state the caller waits for
+ *             timeout - longest wait in milliseconds
+ *
+ * Return Value: CPR_SUCCESS if woken, CPR_FAILURE on timeout or error
+ */
+cprRC_t
+cprWaitSignal (cprSignal_t signal, cprMutex_t mutex, uint32_t timeout)
+{
+    static const char fname[] = "cprWaitSignal";
+    cpr_signal_t *cprSignalPtr;
+    cpr_mutex_t *cprMutexPtr;
+    cpr_condition_t *cond;
+    DWORD rc;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    cprMutexPtr = (cpr_mutex_t *) mutex;
+    if ((cprSignalPtr == NULL) || (cprMutexPtr == NULL)) {
+        CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+        return (CPR_FAILURE);
+    }
+    cond = (cpr_condition_t *) cprSignalPtr->u.handlePtr;
+
+    EnterCriticalSection(&cond->noWaitersLock);
+    cond->noWaiters++;
+    LeaveCriticalSection(&cond->noWaitersLock);
+
+    /* release the mutex and start waiting in one step */
+    rc = SignalObjectAndWait((HANDLE) cprMutexPtr->u.handlePtr, cond->sema,
+                             timeout, FALSE);
+
+    EnterCriticalSection(&cond->noWaitersLock);
+    cond->noWaiters--;
+    LeaveCriticalSection(&cond->noWaitersLock);
+
+    (void) WaitForSingleObject((HANDLE) cprMutexPtr->u.handlePtr, INFINITE);
+
+    if (rc == WAIT_OBJECT_0) {
+        return (CPR_SUCCESS);
+    }
+    if (rc != WAIT_TIMEOUT) {
+        CPR_ERROR("%s - Error waiting on condition: %d\n", fname, GetLastError());
+    }
+    return (CPR_FAILURE);
+}
+
+
+/**
+ * cprPostSignal
+ *
+ * Wakes every thread waiting on the condition
+ *
+ * Parameters: signal - condition to post
+ *
+ * Return Value: Success or failure indication
+ */
+cprRC_t
+cprPostSignal (cprSignal_t signal)
+{
+    static const char fname[] = "cprPostSignal";
+    cpr_signal_t *cprSignalPtr;
+    cpr_condition_t *cond;
+    int waiters;
+
+    cprSignalPtr = (cpr_signal_t *) signal;
+    if (cprSignalPtr == NULL) {
+        CPR_ERROR("%s - NULL pointer passed in.\n", fname);
+        return (CPR_FAILURE);
+    }
+    cond = (cpr_condition_t *) cprSignalPtr->u.handlePtr;
+
+    EnterCriticalSection(&cond->noWaitersLock);
+    waiters = cond->noWaiters;
+    LeaveCriticalSection(&cond->noWaitersLock);
+
+    if ((waiters > 0) && (ReleaseSemaphore(cond->sema, waiters, NULL) == 0)) {
+        CPR_ERROR("%s - Error posting condition: %d\n", fname, GetLastError());
+        return (CPR_FAILURE);
+    }
+    return (CPR_SUCCESS);
+}
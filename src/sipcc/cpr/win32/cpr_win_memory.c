@@ -108,6 +108,8 @@ typedef struct
         uint32_t UsrInfo;
     } Usr;
     uint8_t Misc[MISC_LN];
+    uint32_t EnqTime;
+    uint32_t TraceId;
     void *TempPtr;
 } phn_syshdr_t;
 
@@ -365,6 +367,7 @@ fillInSysHeader (void *buffer, uint16_t cmd, uint16_t len, void *timerMsg)
     syshdr->Cmd = cmd;
     syshdr->Len = len;
     syshdr->Usr.UsrPtr = timerMsg;
+    syshdr->EnqTime = cprGetTimeUs();
     return buffer;
 }
 
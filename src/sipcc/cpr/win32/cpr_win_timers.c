@@ -133,6 +133,41 @@ cprSleep (uint32_t duration)
     Sleep(duration);
 };
 
+/**
+ * cprGetTimeMs
+ *
+ * Current time in milliseconds, for measuring intervals
+ *
+ * Return Value: milliseconds since system start
+ */
+uint32_t
+cprGetTimeMs (void)
+{
+    return (uint32_t) GetTickCount();
+}
+
+/**
+ * cprGetTimeUs
+ *
+ * Current time in microseconds, for measuring short intervals
+ *
+ * Return Value: microseconds from the performance counter
+ */
+uint32_t
+cprGetTimeUs (void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (freq.QuadPart == 0) {
+        (void) QueryPerformanceFrequency(&freq);
+    }
+    (void) QueryPerformanceCounter(&now);
+    return (uint32_t) ((now.QuadPart / freq.QuadPart) * 1000000 +
+                       ((now.QuadPart % freq.QuadPart) * 1000000) /
+                       freq.QuadPart);
+}
+
 /*------------------------------------------------------------------------------
  *  NAME:        timer_event_allocate()
  *
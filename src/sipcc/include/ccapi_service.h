@@ -58,6 +58,16 @@
  */
 cc_return_t CCAPI_Service_create();
 
+/**
+ * Set the maximum number of simultaneous calls the stack is sized for.
+ * The call tables and GSM/SIP queue depths are derived from this value,
+ * so it must be called before CCAPI_Service_create(). Once the stack has
+ * been created the capacity is fixed until the process exits.
+ * @param [in] max_calls - number of calls, between 2 and 8192
+ * @return SUCCESS or FAILURE
+ */
+cc_return_t CCAPI_Service_setMaxCalls(int max_calls);
+
 /**
  * Gracefully unload the Sipcc stack. To bring up the pSipcc stack again,
  * follow the function calling sequence starting from CCAPI_Service_create().
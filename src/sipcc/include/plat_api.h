@@ -175,6 +175,14 @@ typedef enum
     CC_DEBUG_SHOW_DIALPLAN,
     CC_DEBUG_SHOW_CPR_MEMORY, /* Has additional parameters -
                                  config/heap-gaurd/stat/tracking. */
+    CC_DEBUG_SHOW_CAPACITY,
+    CC_DEBUG_SHOW_CPR_MSGQ,
+    CC_DEBUG_SHOW_MSG_LATENCY,
+    CC_DEBUG_SHOW_SIP_PARSE_CACHE,
+    CC_DEBUG_SHOW_SIP_TRX,
+    CC_DEBUG_SHOW_STRLIB,
+    CC_DEBUG_SHOW_SHUTDOWN,
+    CC_DEBUG_SHOW_CONFIG_SNAPSHOT,
     CC_DEBUG_SHOW_MAX
 } cc_debug_show_options_e;
 
@@ -96,6 +96,17 @@ typedef enum {
     XML_EVENT_TIMEOUT
 } xml_event_t;
 
+/**
+ * Define the dialog states of a dialog-info document
+ */
+typedef enum {
+    XML_DIALOG_STATE_TRYING = 0,
+    XML_DIALOG_STATE_PROCEEDING,
+    XML_DIALOG_STATE_EARLY,
+    XML_DIALOG_STATE_CONFIRMED,
+    XML_DIALOG_STATE_TERMINATED
+} xml_dialog_state_t;
+
 /**
  * Define the yes or no values
  */
@@ -509,6 +520,35 @@ typedef struct Media_Control_t {
 
 // end of copy from ccsip_eventbodies.h
 
+/*
+ * application/dialog-info+xml (RFC 4235). Enumerated fields hold -1 when
+ * the document leaves them out.
+ */
+#define XML_MAX_DIALOGS 4
+
+typedef struct DialogStruct {
+	char			id[64];
+	char			call_id[128];
+	char			local_tag[64];
+	char			remote_tag[64];
+	xml_signed32		direction;	/* xml_direction_t */
+	State	state;		/* xml_event_t, SIP code, xml_dialog_state_t */
+	xml_unsigned32		duration;
+	Replaces	replaces;
+	RefferedBy	referred_by;
+	Participant	local;
+	Participant	remote;
+} DialogStruct;
+
+typedef struct DialogInfoStruct {
+	xml_unsigned32		version;
+	xml_signed32		state;		/* xml_state_t */
+	char			entity[256];
+	xml_unsigned16		num_dialogs;	/* held in dialog[] */
+	xml_unsigned16		total_dialogs;	/* in the document */
+	DialogStruct	dialog[XML_MAX_DIALOGS];
+} DialogInfoStruct;
+
 typedef struct Presence_ext_t_ {
     PresenceRPIDStruct presence_body;
 /*
@@ -648,6 +688,7 @@ typedef struct ccsip_event_data_t_ {
         rcc_response_t remotecc_data_response;
         Options_ind_t  options_ind;
         Presence_ext_t presence_rpid;
+        DialogInfoStruct dialog_info;
         raw_data_t     raw_data; // used for cmxml and other body types
         ConfigApp_req_data_t configapp_data;
         media_control_ext_t  media_control_data;
@@ -156,8 +156,18 @@ void CC_SIPCCCall::sendIFrame()
 CC_CallInfoPtr CC_SIPCCCall::getCallInfo ()
 {
     cc_callinfo_ref_t callInfo = CCAPI_Call_getCallInfo(callHandle);
+    if (callInfo == NULL)
+    {
+        return NULL_PTR(CC_CallInfo);
+    }
     CC_SIPCCCallInfoPtr callInfoPtr = CC_SIPCCCallInfo::wrap(callInfo);
     callInfoPtr->setMediaData( pMediaData);
+
+    //CCAPI_Call_getCallInfo() hands out the call's current snapshot with one reference for us, which the
+    //CC_SIPCCCallInfo now holds its own of, so release ours.  The wrapper need not stay mapped after this call.
+    CC_SIPCCCallInfo::release(callInfo);
+    CCAPI_Call_releaseCallInfo(callInfo);
+
     return callInfoPtr;
 }
 
@@ -86,6 +86,7 @@ CC_DeviceInfoPtr CC_SIPCCDevice::getDeviceInfo ()
     //here to match up with the call to CCAPI_Device_getDeviceInfo().
 
     CCAPI_Device_releaseDeviceInfo(deviceInfoRef);
+    CC_SIPCCDeviceInfo::release(deviceInfoRef);
 
     //CCAPI_Device_getDeviceInfo() --> requires release be called.
     //CC_SIPCCDeviceInfo::CC_SIPCCDeviceInfo() -> Call retain (wrapped in smart_ptr)
@@ -0,0 +1,601 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "CC_SIPCCEventDispatcher.h"
+
+#include "base/threading/platform_thread.h"
+
+#include <string.h>
+
+#include "CSFLogStream.h"
+static const char* logTag = "CC_SIPCCEventDispatcher";
+
+using namespace std;
+
+#define DEFAULT_OBSERVER_QUEUE_LIMIT 1024
+
+namespace CSF
+{
+
+static bool isCoalescableCallEvent(int type)
+{
+    switch (type)
+    {
+    case CCAPI_CALL_EV_CALLINFO:
+    case CCAPI_CALL_EV_STATUS:
+    case CCAPI_CALL_EV_CAPABILITY:
+    case CCAPI_CALL_EV_SECURITY:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// ObserverQueue
+//
+
+CC_SIPCCEventDispatcher::ObserverQueue::ObserverQueue(CC_Observer * observer, size_t limit, bool coalesce)
+: observer(observer),
+  wakeup(&lock),
+  idle(&lock),
+  limit(limit),
+  coalesce(coalesce),
+  stopping(false),
+  delivering(false),
+  overLimit(false),
+  thread(this, "CCObserver")
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.observer = observer;
+}
+
+CC_SIPCCEventDispatcher::ObserverQueue::~ObserverQueue()
+{
+    stop();
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::start()
+{
+    thread.Start();
+}
+
+bool CC_SIPCCEventDispatcher::ObserverQueue::isDeliveryThread()
+{
+    return thread.HasBeenStarted() && thread.tid() == base::PlatformThread::CurrentId();
+}
+
+// Must not be called with the dispatcher's writerLock held: the delivery thread may be waiting for it.
+void CC_SIPCCEventDispatcher::ObserverQueue::stop()
+{
+    {
+        base::AutoLock l(lock);
+        stopping = true;
+        events.clear();
+        wakeup.Signal();
+        idle.Broadcast();
+
+        // a synchronous delivery on another thread finishes first, one on this thread is the caller's own callback
+        while (hasOtherSyncDelivery())
+        {
+            idle.Wait();
+        }
+    }
+
+    if (thread.HasBeenStarted() && !thread.HasBeenJoined() && !isDeliveryThread())
+    {
+        thread.Join();
+    }
+}
+
+bool CC_SIPCCEventDispatcher::ObserverQueue::hasOtherSyncDelivery()
+{
+    base::PlatformThreadId self = base::PlatformThread::CurrentId();
+    for (vector<base::PlatformThreadId>::iterator it = syncDeliveries.begin(); it != syncDeliveries.end(); it++)
+    {
+        if (*it != self)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CC_SIPCCEventDispatcher::ObserverQueue::beginSyncDelivery()
+{
+    base::AutoLock l(lock);
+    if (stopping)
+    {
+        return false;
+    }
+    syncDeliveries.push_back(base::PlatformThread::CurrentId());
+    return true;
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::endSyncDelivery()
+{
+    base::AutoLock l(lock);
+    base::PlatformThreadId self = base::PlatformThread::CurrentId();
+    for (vector<base::PlatformThreadId>::iterator it = syncDeliveries.begin(); it != syncDeliveries.end(); it++)
+    {
+        if (*it == self)
+        {
+            syncDeliveries.erase(it);
+            break;
+        }
+    }
+    stats.delivered++;
+    idle.Broadcast();
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::setLimits(size_t newLimit, bool newCoalesce)
+{
+    base::AutoLock l(lock);
+    limit = newLimit;
+    coalesce = newCoalesce;
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::post(const Event & event)
+{
+    base::AutoLock l(lock);
+    if (stopping)
+    {
+        return;
+    }
+
+    if (coalesce && event.kind == CallEvent && isCoalescableCallEvent(event.type))
+    {
+        // Only the newest pending event can be replaced, otherwise the refresh would overtake other events for the call.
+        for (deque<Event>::reverse_iterator it = events.rbegin(); it != events.rend(); it++)
+        {
+            if (it->kind == CallEvent && it->call.get() == event.call.get())
+            {
+                if (it->type == event.type)
+                {
+                    base::TimeTicks posted = it->posted;
+                    *it = event;
+                    it->posted = posted;
+                    stats.coalesced++;
+                    return;
+                }
+                break;
+            }
+        }
+    }
+
+    events.push_back(event);
+    if (events.size() > limit)
+    {
+        if (event.kind == CallEvent && isCoalescableCallEvent(event.type))
+        {
+            discardSuperseded(event);
+        }
+        if (events.size() > limit && !overLimit)
+        {
+            // nothing left that a later event replaces, keep going rather than lose a state change
+            overLimit = true;
+            CSFLogWarnS( logTag, "Observer queue over its limit (" << limit << "), " << events.size() <<
+                    " events pending");
+        }
+    }
+    if (events.size() <= limit)
+    {
+        overLimit = false;
+    }
+    stats.queued = events.size();
+    if (stats.queued > stats.maxQueued)
+    {
+        stats.maxQueued = stats.queued;
+    }
+    wakeup.Signal();
+}
+
+// Called with lock held on a full queue, after a call info refresh was appended.  The older pending refresh of the
+// same type for the same call is redundant, the info objects are complete snapshots.  Dropping the oldest one keeps
+// the queue from growing on refreshes alone.
+void CC_SIPCCEventDispatcher::ObserverQueue::discardSuperseded(const Event & newest)
+{
+    deque<Event>::iterator last = events.end() - 1;
+    for (deque<Event>::iterator it = events.begin(); it != last; it++)
+    {
+        if (it->kind == CallEvent && it->type == newest.type && it->call.get() == newest.call.get())
+        {
+            events.erase(it);
+            stats.dropped++;
+            return;
+        }
+    }
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::drain()
+{
+    base::AutoLock l(lock);
+    while (!stopping && (!events.empty() || delivering))
+    {
+        idle.Wait();
+    }
+}
+
+CC_SIPCCEventDispatcher::ObserverStats CC_SIPCCEventDispatcher::ObserverQueue::getStats()
+{
+    base::AutoLock l(lock);
+    return stats;
+}
+
+void CC_SIPCCEventDispatcher::ObserverQueue::Run()
+{
+    for (;;)
+    {
+        Event event;
+        {
+            base::AutoLock l(lock);
+            while (events.empty() && !stopping)
+            {
+                wakeup.Wait();
+            }
+            if (stopping)
+            {
+                return;
+            }
+            event = events.front();
+            events.pop_front();
+            stats.queued = events.size();
+
+            unsigned int lag = (unsigned int) (base::TimeTicks::Now() - event.posted).InMilliseconds();
+            stats.lastLagMs = lag;
+            if (lag > stats.maxLagMs)
+            {
+                stats.maxLagMs = lag;
+            }
+            delivering = true;
+        }
+
+        CC_SIPCCEventDispatcher::deliver(observer, event);
+
+        {
+            base::AutoLock l(lock);
+            delivering = false;
+            stats.delivered++;
+            if (events.empty())
+            {
+                idle.Broadcast();
+            }
+        }
+    }
+}
+
+//
+// CC_SIPCCEventDispatcher
+//
+
+CC_SIPCCEventDispatcher::CC_SIPCCEventDispatcher()
+: async(true),
+  queueLimit(DEFAULT_OBSERVER_QUEUE_LIMIT),
+  coalesce(false),
+  currentList(reinterpret_cast<base::subtle::AtomicWord>(new ObserverList())),
+  activeReaders(0)
+{
+}
+
+CC_SIPCCEventDispatcher::~CC_SIPCCEventDispatcher()
+{
+    ObserverList * list = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        delete *it;
+    }
+    delete list;
+
+    for (vector<ObserverList *>::iterator it = retiredLists.begin(); it != retiredLists.end(); it++)
+    {
+        delete *it;
+    }
+    for (vector<ObserverQueue *>::iterator it = retiredQueues.begin(); it != retiredQueues.end(); it++)
+    {
+        delete *it;
+    }
+}
+
+CC_SIPCCEventDispatcher::ObserverList * CC_SIPCCEventDispatcher::acquireList()
+{
+    base::subtle::Barrier_AtomicIncrement(&activeReaders, 1);
+    return reinterpret_cast<ObserverList *>(base::subtle::Acquire_Load(&currentList));
+}
+
+void CC_SIPCCEventDispatcher::releaseList()
+{
+    base::subtle::Barrier_AtomicIncrement(&activeReaders, -1);
+}
+
+// Called with writerLock held.  A poster that starts after the store below sees the new list.
+void CC_SIPCCEventDispatcher::publishList(ObserverList * list)
+{
+    ObserverList * old = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+    base::subtle::Release_Store(&currentList, reinterpret_cast<base::subtle::AtomicWord>(list));
+    base::subtle::MemoryBarrier();
+    retiredLists.push_back(old);
+}
+
+// Called with writerLock held.  Retired lists, and retired queues, can only be freed once no poster can still be
+// using them; nothing waits for that, whatever is still in use is left for a later call.  The caller frees what is
+// handed back after releasing writerLock, since deleting a queue joins its thread.
+void CC_SIPCCEventDispatcher::collectRetired(vector<ObserverList *> & lists, vector<ObserverQueue *> & queues)
+{
+    if (base::subtle::Acquire_Load(&activeReaders) != 0)
+    {
+        return;
+    }
+
+    lists.swap(retiredLists);
+
+    // A queue removed from inside its own callback cannot be joined from there, keep it for the next time round.
+    vector<ObserverQueue *> keep;
+    for (vector<ObserverQueue *>::iterator it = retiredQueues.begin(); it != retiredQueues.end(); it++)
+    {
+        if ((*it)->isDeliveryThread())
+        {
+            keep.push_back(*it);
+        }
+        else
+        {
+            queues.push_back(*it);
+        }
+    }
+    retiredQueues.swap(keep);
+}
+
+void CC_SIPCCEventDispatcher::freeRetired(vector<ObserverList *> & lists, vector<ObserverQueue *> & queues)
+{
+    for (vector<ObserverList *>::iterator it = lists.begin(); it != lists.end(); it++)
+    {
+        delete *it;
+    }
+    for (vector<ObserverQueue *>::iterator it = queues.begin(); it != queues.end(); it++)
+    {
+        delete *it;
+    }
+}
+
+void CC_SIPCCEventDispatcher::addObserver(CC_Observer * observer)
+{
+    vector<ObserverList *> freeLists;
+    vector<ObserverQueue *> freeQueues;
+    {
+        base::AutoLock lock(writerLock);
+        ObserverList * list = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+        for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+        {
+            if ((*it)->observer == observer)
+            {
+                return;
+            }
+        }
+
+        ObserverQueue * queue = new ObserverQueue(observer, queueLimit, coalesce);
+        queue->start();
+
+        ObserverList * newList = new ObserverList(*list);
+        newList->push_back(queue);
+        publishList(newList);
+        collectRetired(freeLists, freeQueues);
+    }
+    freeRetired(freeLists, freeQueues);
+}
+
+void CC_SIPCCEventDispatcher::removeObserver(CC_Observer * observer)
+{
+    ObserverQueue * removed = NULL;
+    {
+        base::AutoLock lock(writerLock);
+        ObserverList * list = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+        ObserverList * newList = new ObserverList();
+        for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+        {
+            if ((*it)->observer == observer)
+            {
+                removed = *it;
+            }
+            else
+            {
+                newList->push_back(*it);
+            }
+        }
+
+        if (removed == NULL)
+        {
+            delete newList;
+            return;
+        }
+        publishList(newList);
+    }
+
+    // Posters still holding the old list find the queue stopped, so nothing is delivered once this returns.  The
+    // observer's callbacks may add or remove observers, so it is stopped and joined with writerLock released.
+    removed->stop();
+
+    vector<ObserverList *> freeLists;
+    vector<ObserverQueue *> freeQueues;
+    {
+        base::AutoLock lock(writerLock);
+        retiredQueues.push_back(removed);
+        collectRetired(freeLists, freeQueues);
+    }
+    freeRetired(freeLists, freeQueues);
+}
+
+void CC_SIPCCEventDispatcher::setAsync(bool newAsync)
+{
+    base::AutoLock lock(writerLock);
+    async = newAsync;
+}
+
+void CC_SIPCCEventDispatcher::setQueueLimit(size_t limit)
+{
+    base::AutoLock lock(writerLock);
+    queueLimit = limit;
+    ObserverList * list = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        (*it)->setLimits(queueLimit, coalesce);
+    }
+}
+
+void CC_SIPCCEventDispatcher::setCoalescing(bool newCoalesce)
+{
+    base::AutoLock lock(writerLock);
+    coalesce = newCoalesce;
+    ObserverList * list = reinterpret_cast<ObserverList *>(base::subtle::NoBarrier_Load(&currentList));
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        (*it)->setLimits(queueLimit, coalesce);
+    }
+}
+
+void CC_SIPCCEventDispatcher::deliver(CC_Observer * observer, Event & event)
+{
+    switch (event.kind)
+    {
+    case DeviceEvent:
+        observer->onDeviceEvent((ccapi_device_event_e) event.type, event.device, event.deviceInfo);
+        break;
+    case FeatureEvent:
+        observer->onFeatureEvent((ccapi_device_event_e) event.type, event.device, event.featureInfo);
+        break;
+    case LineEvent:
+        observer->onLineEvent((ccapi_line_event_e) event.type, event.line, event.lineInfo);
+        break;
+    case CallEvent:
+        observer->onCallEvent((ccapi_call_event_e) event.type, event.call, event.callInfo,
+                event.sdp.empty() ? NULL : &event.sdp[0]);
+        break;
+    }
+}
+
+void CC_SIPCCEventDispatcher::post(const Event & event)
+{
+    ObserverList * list = acquireList();
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        if (async)
+        {
+            (*it)->post(event);
+        }
+        else if ((*it)->beginSyncDelivery())
+        {
+            // each observer gets its own copy, as it would from its queue
+            Event copy(event);
+            deliver((*it)->observer, copy);
+            (*it)->endSyncDelivery();
+        }
+    }
+    releaseList();
+}
+
+void CC_SIPCCEventDispatcher::postDeviceEvent(ccapi_device_event_e type, CC_DevicePtr device, CC_DeviceInfoPtr info)
+{
+    Event event;
+    event.kind = DeviceEvent;
+    event.type = type;
+    event.device = device;
+    event.deviceInfo = info;
+    event.posted = base::TimeTicks::Now();
+    post(event);
+}
+
+void CC_SIPCCEventDispatcher::postFeatureEvent(ccapi_device_event_e type, CC_DevicePtr device, CC_FeatureInfoPtr info)
+{
+    Event event;
+    event.kind = FeatureEvent;
+    event.type = type;
+    event.device = device;
+    event.featureInfo = info;
+    event.posted = base::TimeTicks::Now();
+    post(event);
+}
+
+void CC_SIPCCEventDispatcher::postLineEvent(ccapi_line_event_e type, CC_LinePtr line, CC_LineInfoPtr info)
+{
+    Event event;
+    event.kind = LineEvent;
+    event.type = type;
+    event.line = line;
+    event.lineInfo = info;
+    event.posted = base::TimeTicks::Now();
+    post(event);
+}
+
+void CC_SIPCCEventDispatcher::postCallEvent(ccapi_call_event_e type, CC_CallPtr call, CC_CallInfoPtr info, const char * sdp)
+{
+    Event event;
+    event.kind = CallEvent;
+    event.type = type;
+    event.call = call;
+    event.callInfo = info;
+    if (sdp != NULL)
+    {
+        // sipcc frees the SDP once the event returns, and observers take a char*
+        event.sdp.assign(sdp, sdp + strlen(sdp) + 1);
+    }
+    event.posted = base::TimeTicks::Now();
+    post(event);
+}
+
+void CC_SIPCCEventDispatcher::drain()
+{
+    ObserverList * list = acquireList();
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        (*it)->drain();
+    }
+    releaseList();
+}
+
+vector<CC_SIPCCEventDispatcher::ObserverStats> CC_SIPCCEventDispatcher::getStats()
+{
+    vector<ObserverStats> result;
+    ObserverList * list = acquireList();
+    for (ObserverList::iterator it = list->begin(); it != list->end(); it++)
+    {
+        result.push_back((*it)->getStats());
+    }
+    releaseList();
+    return result;
+}
+
+}
@@ -0,0 +1,198 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _CC_SIPCC_EVENT_DISPATCHER_H
+#define _CC_SIPCC_EVENT_DISPATCHER_H
+
+#include "CC_Observer.h"
+#include "CC_Call.h"
+#include "CC_CallInfo.h"
+#include "CC_Device.h"
+#include "CC_DeviceInfo.h"
+#include "CC_FeatureInfo.h"
+#include "CC_Line.h"
+#include "CC_LineInfo.h"
+
+#include "base/atomicops.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace CSF
+{
+    /*
+     * CC_SIPCCEventDispatcher - delivers CC_Observer events off the sipcc CCApp thread.
+     *
+     * Every observer gets its own queue and delivery thread, so a slow observer only delays itself.  Events reach
+     * each observer in the order they were posted.  The observer list is copy-on-write: posting an event reads the
+     * current list without taking a lock, and adding or removing an observer never waits for a delivery to another
+     * observer.  Observer callbacks may add and remove observers, themselves included.
+     *
+     * When coalescing is on, a call event that only refreshes the call's info (CCAPI_CALL_EV_CALLINFO, _STATUS,
+     * _CAPABILITY, _SECURITY) replaces an undelivered event of the same type for the same call instead of queueing
+     * behind it; the info objects are complete snapshots so nothing is lost.  When a queue grows past its limit, the
+     * call info refreshes that a later queued refresh of the same type supersedes are discarded and counted as
+     * dropped.  Any other event, call state changes among them, is always queued, so the limit is a soft one.
+     *
+     * With asynchronous dispatch turned off events are delivered on the posting thread, as they used to be.
+     */
+    class CC_SIPCCEventDispatcher
+    {
+    public:
+        struct ObserverStats
+        {
+            CC_Observer * observer;
+            unsigned int queued;       // events waiting now
+            unsigned int maxQueued;
+            unsigned int delivered;
+            unsigned int coalesced;
+            unsigned int dropped;
+            unsigned int lastLagMs;    // post to start of delivery, of the last event delivered
+            unsigned int maxLagMs;
+        };
+
+        CC_SIPCCEventDispatcher();
+        ~CC_SIPCCEventDispatcher();
+
+        void addObserver(CC_Observer * observer);
+        // Once this returns the observer receives no further events, unless called from the observer's own callback,
+        // in which case the event being delivered is the last one.
+        void removeObserver(CC_Observer * observer);
+
+        void setAsync(bool async);
+        void setQueueLimit(size_t limit);
+        void setCoalescing(bool coalesce);
+
+        void postDeviceEvent(ccapi_device_event_e type, CC_DevicePtr device, CC_DeviceInfoPtr info);
+        void postFeatureEvent(ccapi_device_event_e type, CC_DevicePtr device, CC_FeatureInfoPtr info);
+        void postLineEvent(ccapi_line_event_e type, CC_LinePtr line, CC_LineInfoPtr info);
+        void postCallEvent(ccapi_call_event_e type, CC_CallPtr call, CC_CallInfoPtr info, const char * sdp);
+
+        // Waits until every event posted so far has been delivered.  Must not be called from an observer callback.
+        void drain();
+
+        std::vector<ObserverStats> getStats();
+
+    private:
+        enum EventKind { DeviceEvent, FeatureEvent, LineEvent, CallEvent };
+
+        struct Event
+        {
+            EventKind kind;
+            int type;
+            CC_DevicePtr device;
+            CC_DeviceInfoPtr deviceInfo;
+            CC_FeatureInfoPtr featureInfo;
+            CC_LinePtr line;
+            CC_LineInfoPtr lineInfo;
+            CC_CallPtr call;
+            CC_CallInfoPtr callInfo;
+            std::vector<char> sdp;     // empty when the event had no SDP
+            base::TimeTicks posted;
+        };
+
+        class ObserverQueue : public base::DelegateSimpleThread::Delegate
+        {
+        public:
+            ObserverQueue(CC_Observer * observer, size_t limit, bool coalesce);
+            virtual ~ObserverQueue();
+
+            void start();
+            void stop();
+            bool isDeliveryThread();
+            void post(const Event & event);
+            // bracket a delivery made on the posting thread; false once the queue is stopped
+            bool beginSyncDelivery();
+            void endSyncDelivery();
+            void drain();
+            void setLimits(size_t limit, bool coalesce);
+            ObserverStats getStats();
+
+            CC_Observer * observer;
+
+            virtual void Run();
+
+        private:
+            void discardSuperseded(const Event & newest);
+            bool hasOtherSyncDelivery();
+
+            base::Lock lock;
+            base::ConditionVariable wakeup;
+            base::ConditionVariable idle;
+            std::deque<Event> events;
+            size_t limit;
+            bool coalesce;
+            bool stopping;
+            bool delivering;
+            bool overLimit;
+            std::vector<base::PlatformThreadId> syncDeliveries;   // threads delivering synchronously right now
+            ObserverStats stats;
+            base::DelegateSimpleThread thread;
+        };
+
+        typedef std::vector<ObserverQueue *> ObserverList;
+
+        static void deliver(CC_Observer * observer, Event & event);
+        void post(const Event & event);
+        ObserverList * acquireList();
+        void releaseList();
+        void publishList(ObserverList * list);
+        void collectRetired(std::vector<ObserverList *> & lists, std::vector<ObserverQueue *> & queues);
+        static void freeRetired(std::vector<ObserverList *> & lists, std::vector<ObserverQueue *> & queues);
+
+        bool async;
+        size_t queueLimit;
+        bool coalesce;
+
+        // current ObserverList, replaced as a whole on add or remove
+        base::subtle::AtomicWord currentList;
+        base::subtle::Atomic32 activeReaders;
+
+        base::Lock writerLock;                // serializes add, remove and configuration changes
+        std::vector<ObserverList *> retiredLists;
+        std::vector<ObserverQueue *> retiredQueues;
+    };
+}
+
+#endif
@@ -71,6 +71,7 @@ CC_LineInfoPtr CC_SIPCCLine::getLineInfo ()
     //here to match up with the call to CCAPI_Line_getLineInfo().
 
     CCAPI_Line_releaseLineInfo(lineInfoRef);
+    CC_SIPCCLineInfo::release(lineInfoRef);
 
     //CCAPI_Line_getLineInfo() --> requires release be called.
     //CC_SIPCCLineInfo::CC_SIPCCLineInfo() -> Call retain (wrapped in smart_ptr)
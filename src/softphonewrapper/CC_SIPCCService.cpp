@@ -56,7 +56,6 @@
 #include "CSFAudioTermination.h"
 #include "CSFVideoTermination.h"
 
-#include "base/threading/platform_thread.h"
 #include "base/time.h"
 
 extern "C" {
@@ -64,6 +63,8 @@ extern "C" {
 }
 #include "debug-psipcc-types.h"
 #include "VcmSIPCCBinding.h"
+#include "MediaStreamRegistry.h"
+#include "MediaBandwidthManager.h"
 
 #include "csf_common.h"
 
@@ -395,6 +396,7 @@ CC_SIPCCService::CC_SIPCCService()
   bCreated(false),
   bStarted(false),  
   sippStartedEvent(false, false),
+  callsEndedEvent(false, false),
   vcmMediaBridge(MediaProvider::create()),
   bUseConfig(false)
 {
@@ -444,6 +446,9 @@ void CC_SIPCCService::destroy()
 	deviceName = "";
 	loggingMask = 0;
 
+    // Let queued events reach the observers before the objects they carry lose their sipcc data.
+    eventDispatcher.drain();
+
     CC_SIPCCDevice::reset();
     CC_SIPCCDeviceInfo::reset();
     CC_SIPCCFeatureInfo::reset();
@@ -452,6 +457,7 @@ void CC_SIPCCService::destroy()
     CC_SIPCCLineInfo::reset();
     CC_SIPCCCall::reset();
     CC_SIPCCCallInfo::reset();
+    logWrapperCounts();
 
 	if(audioControlWrapper != NULL)
 	{
@@ -478,6 +484,7 @@ void CC_SIPCCService::setLocalAddressAndGateway(const std::string& localAddress,
 {
 	this->localAddress = localAddress;
     this->defaultGW = defaultGW;
+    MediaBandwidthManager::getInstance()->setActiveAddress(localAddress);
 
     CCAPI_Device_IP_Update(CCAPI_Device_getDeviceID(), localAddress.c_str(), "", 0,
                            localAddress.c_str(), "", 0);
@@ -665,6 +672,11 @@ void CC_SIPCCService::endAllActiveCalls()
 		CC_DeviceInfoPtr deviceInfo = device->getDeviceInfo();
 		vector<CC_CallPtr> calls = deviceInfo->getCalls();
 		CSFLogInfo( logTag, "endAllActiveCalls(): %d calls to be ended.", calls.size());
+		{
+			base::AutoLock lock(endingCallsLock);
+			endingCalls.clear();
+			callsEndedEvent.Reset();
+		}
 		for(vector<CC_CallPtr>::iterator it = calls.begin(); it != calls.end(); it++)
 		{
 			// For each active call, if it can be ended, do so.
@@ -675,6 +687,10 @@ void CC_SIPCCService::endAllActiveCalls()
 				CSFLogDebugS( logTag, "endAllActiveCalls(): ending call " <<
 						callInfo->getCallingPartyNumber() << " -> " << callInfo->getCalledPartyNumber() <<
 						" [" << call_state_getname(callInfo->getCallState()) << "]");
+				{
+					base::AutoLock lock(endingCallsLock);
+					endingCalls.insert(call.get());
+				}
 				call->endCall();
 			}
 			else if(callInfo->hasCapability(CC_CallCapabilityEnum::canResume) && callInfo->getCallState() != REMHOLD)
@@ -682,16 +698,28 @@ void CC_SIPCCService::endAllActiveCalls()
 				CSFLogDebugS( logTag, "endAllActiveCalls(): resume then ending call " <<
 						callInfo->getCallingPartyNumber() << " -> " << callInfo->getCalledPartyNumber() <<
 						" [" << call_state_getname(callInfo->getCallState()) << "]");
+				{
+					base::AutoLock lock(endingCallsLock);
+					endingCalls.insert(call.get());
+				}
 				call->muteAudio();
 				call->resume(callInfo->getVideoDirection());
 				call->endCall();
 			}
 		}
 
-		if(!calls.empty())
+		bool waiting;
+		{
+			base::AutoLock lock(endingCallsLock);
+			waiting = !endingCalls.empty();
+		}
+		// Wait for the calls to go on hook, which is when their BYE has been sent,
+		// rather than for a fixed time. The deadline covers calls stuck on the way.
+		if(waiting && !callsEndedEvent.TimedWait(base::TimeDelta::FromMilliseconds(2000)))
 		{
-			// If we had any calls, allow a short time for the SIP messaging to go out
-			base::PlatformThread::Sleep(500);
+			base::AutoLock lock(endingCallsLock);
+			CSFLogInfo( logTag, "endAllActiveCalls(): %d calls still not on hook, giving up.", endingCalls.size());
+			endingCalls.clear();
 		}
     }
 }
@@ -725,6 +753,9 @@ void CC_SIPCCService::onDeviceEvent(ccapi_device_event_e type, cc_device_handle_
     _self->notifyDeviceEventObservers(type, devicePtr, infoPtr);
 
     _self->signalToPhoneWhenInService(type, info);
+
+    // The info is a snapshot for this event, observers that want it have taken their own reference.
+    CC_SIPCCDeviceInfo::release(info);
 }
 
 void CC_SIPCCService::onFeatureEvent(ccapi_device_event_e type, cc_deviceinfo_ref_t /* device_info */, cc_featureinfo_ref_t feature_info)
@@ -754,6 +785,8 @@ void CC_SIPCCService::onFeatureEvent(ccapi_device_event_e type, cc_deviceinfo_re
      CSFLogInfoS( logTag, "onFeatureEvent(" << device_event_getname(type) << ", " << devicePtr->toString() <<
     		 ", [" << infoPtr->getDisplayName() << "] )");
      _self->notifyFeatureEventObservers(type, devicePtr, infoPtr);
+
+     CC_SIPCCFeatureInfo::release(feature_info);
 }
 
 void CC_SIPCCService::onLineEvent(ccapi_line_event_e eventType, cc_lineid_t line, cc_lineinfo_ref_t info)
@@ -781,6 +814,8 @@ void CC_SIPCCService::onLineEvent(ccapi_line_event_e eventType, cc_lineid_t line
     CSFLogInfoS( logTag, "onLineEvent(" << line_event_getname(eventType) << ", " << linePtr->toString() <<
     		", [" << infoPtr->getNumber() << "|" << (infoPtr->getRegState() ? "INS" : "OOS") << "] )");
     _self->notifyLineEventObservers(eventType, linePtr, infoPtr);
+
+    CC_SIPCCLineInfo::release(info);
 }
 
 void CC_SIPCCService::onCallEvent(ccapi_call_event_e eventType, cc_call_handle_t handle, cc_callinfo_ref_t info, char* sdp)
@@ -811,65 +846,78 @@ void CC_SIPCCService::onCallEvent(ccapi_call_event_e eventType, cc_call_handle_t
     CSFLogInfoS( logTag, "onCallEvent(" << call_event_getname(eventType) << ", " << callPtr->toString() <<
     		", [" << call_state_getname(infoPtr->getCallState()) << "|" << CC_CallCapabilityEnum::toString(capSet) << "] )");
     _self->notifyCallEventObservers(eventType, callPtr, infoPtr, sdp);
+
+    CC_SIPCCCallInfo::release(info);
+
+    // Once the call is over its handle may be reused for a new call, so stop mapping it.
+    if (infoPtr->getCallState() == ONHOOK)
+    {
+        {
+            base::AutoLock lock(_self->endingCallsLock);
+            if (_self->endingCalls.erase(callPtr.get()) != 0 && _self->endingCalls.empty())
+            {
+                _self->callsEndedEvent.Signal();
+            }
+        }
+        CC_SIPCCCall::release(handle);
+        _self->logWrapperCounts();
+    }
+}
+
+void CC_SIPCCService::logWrapperCounts()
+{
+    CSFLogDebugS( logTag, "wrappers live/mapped:" <<
+            " Device " << CC_SIPCCDevice::getLiveCount() << "/" << CC_SIPCCDevice::getMappedCount() <<
+            " DeviceInfo " << CC_SIPCCDeviceInfo::getLiveCount() << "/" << CC_SIPCCDeviceInfo::getMappedCount() <<
+            " FeatureInfo " << CC_SIPCCFeatureInfo::getLiveCount() << "/" << CC_SIPCCFeatureInfo::getMappedCount() <<
+            " CallServerInfo " << CC_SIPCCCallServerInfo::getLiveCount() << "/" << CC_SIPCCCallServerInfo::getMappedCount() <<
+            " Line " << CC_SIPCCLine::getLiveCount() << "/" << CC_SIPCCLine::getMappedCount() <<
+            " LineInfo " << CC_SIPCCLineInfo::getLiveCount() << "/" << CC_SIPCCLineInfo::getMappedCount() <<
+            " Call " << CC_SIPCCCall::getLiveCount() << "/" << CC_SIPCCCall::getMappedCount() <<
+            " CallInfo " << CC_SIPCCCallInfo::getLiveCount() << "/" << CC_SIPCCCallInfo::getMappedCount());
 }
 
 void CC_SIPCCService::addCCObserver ( CC_Observer * observer )
 {
-	base::AutoLock lock(m_lock);
     if (observer == NULL)
     {
         CSFLogErrorS( logTag, "NULL value for \"observer\" passed to addCCObserver().");
         return;
     }
 
-    ccObservers.insert(observer);
+    eventDispatcher.addObserver(observer);
 }
 
 void CC_SIPCCService::removeCCObserver ( CC_Observer * observer )
 {
-	base::AutoLock lock(m_lock);
-    ccObservers.erase(observer);
+    eventDispatcher.removeObserver(observer);
+}
+
+CC_SIPCCEventDispatcher & CC_SIPCCService::getEventDispatcher()
+{
+    return eventDispatcher;
 }
 
 //Notify Observers
+//Observers are called from their own delivery threads, see CC_SIPCCEventDispatcher.
 void CC_SIPCCService::notifyDeviceEventObservers (ccapi_device_event_e eventType, CC_DevicePtr devicePtr, CC_DeviceInfoPtr info)
 {
-	base::AutoLock lock(m_lock);
-	set<CC_Observer*>::const_iterator it = ccObservers.begin();
-	for ( ; it != ccObservers.end(); it++ )
-    {
-	    (*it)->onDeviceEvent(eventType, devicePtr, info);
-    }
+    eventDispatcher.postDeviceEvent(eventType, devicePtr, info);
 }
 
 void CC_SIPCCService::notifyFeatureEventObservers (ccapi_device_event_e eventType, CC_DevicePtr devicePtr, CC_FeatureInfoPtr info)
 {
-	base::AutoLock lock(m_lock);
-	set<CC_Observer*>::const_iterator it = ccObservers.begin();
-	for ( ; it != ccObservers.end(); it++ )
-    {
-	    (*it)->onFeatureEvent(eventType, devicePtr, info);
-    }
+    eventDispatcher.postFeatureEvent(eventType, devicePtr, info);
 }
 
 void CC_SIPCCService::notifyLineEventObservers (ccapi_line_event_e eventType, CC_LinePtr linePtr, CC_LineInfoPtr info)
 {
-	base::AutoLock lock(m_lock);
-	set<CC_Observer*>::const_iterator it = ccObservers.begin();
-	for ( ; it != ccObservers.end(); it++ )
-    {
-	    (*it)->onLineEvent(eventType, linePtr, info);
-    }
+    eventDispatcher.postLineEvent(eventType, linePtr, info);
 }
 
 void CC_SIPCCService::notifyCallEventObservers (ccapi_call_event_e eventType, CC_CallPtr callPtr, CC_CallInfoPtr info, char* sdp)
 {
-	base::AutoLock lock(m_lock);
-	set<CC_Observer*>::const_iterator it = ccObservers.begin();
-	for ( ; it != ccObservers.end(); it++ )
-    {
-	    (*it)->onCallEvent(eventType, callPtr, info, sdp);
-    }
+    eventDispatcher.postCallEvent(eventType, callPtr, info, sdp);
 }
 
 // This is called when the SIP stack has caused a new stream to be allocated. This function will
@@ -882,6 +930,8 @@ void CC_SIPCCService::registerStream(cc_call_handle_t call, int streamId, bool i
     if (callPtr != NULL)
     {
     	callPtr->addStream(streamId, isVideo);
+    	MediaStreamRegistry::getInstance()->bindCall(isVideo ? MediaStreamRegistry::VIDEO_STREAM : MediaStreamRegistry::AUDIO_STREAM,
+    			streamId, call);
     }
     else
     {
@@ -891,8 +941,8 @@ void CC_SIPCCService::registerStream(cc_call_handle_t call, int streamId, bool i
 
 void CC_SIPCCService::deregisterStream(cc_call_handle_t call, int streamId)
 {
-	// get the object corresponding to the handle
-    CC_SIPCCCallPtr callPtr = CC_SIPCCCall::wrap(call);
+	// get the object corresponding to the handle, the call may already have ended and been released
+    CC_SIPCCCallPtr callPtr = CC_SIPCCCall::find(call);
     if (callPtr != NULL)
     {
     	callPtr->removeStream(streamId);
@@ -905,52 +955,23 @@ void CC_SIPCCService::deregisterStream(cc_call_handle_t call, int streamId)
 
 void CC_SIPCCService::dtmfBurst(int digit, int direction, int duration)
 {
-	// We haven't a clue what stream to use.  Search for a call which has an audio stream.
-	vector<CC_SIPCCCallPtr> calls;
-	{
-		// First build a list of all the calls.
-		cc_deviceinfo_ref_t deviceInfoRef = CCAPI_Device_getDeviceInfo(CCAPI_Device_getDeviceID());
-		cc_call_handle_t handles[MAX_SUPPORTED_NUM_CALLS] = {};
-		cc_uint16_t numHandles = csf_countof(handles);
-
-		CCAPI_DeviceInfo_getCalls(deviceInfoRef, handles, &numHandles);
+	// We haven't a clue what stream to use.  Send the digit on the first audio stream of any call that takes it.
+	vector<MediaStreamRegistry::Entry> streams;
+	MediaStreamRegistry::getInstance()->getCallStreams(MediaStreamRegistry::AUDIO_STREAM, streams);
 
-		for (int i=0; i<numHandles; i++)
+	AudioTermination * pAudio = VcmSIPCCBinding::getAudioTermination();
+	for (vector<MediaStreamRegistry::Entry>::iterator it = streams.begin(); it != streams.end(); it++)
+	{
+		if (pAudio->sendDtmf(it->streamId, digit))
 		{
-			CC_SIPCCCallPtr callPtr = CC_SIPCCCall::wrap(handles[i]);
-			calls.push_back(callPtr);
+			// We have sent a digit, done.
+			break;
+		}
+		else
+		{
+			CSFLogWarnS( logTag, "dtmfBurst:sendDtmf returned fail");
 		}
-		CCAPI_Device_releaseDeviceInfo(deviceInfoRef);
 	}
-
-	// Using the list of all calls, search for those containing an audio stream.
-	// Send a DTMF digit on the first one we find.
-
-	AudioTermination * pAudio = VcmSIPCCBinding::getAudioTermination();
-	bool bSent = false;
-	for(vector<CC_SIPCCCallPtr>::iterator it = calls.begin(); it != calls.end() && !bSent; it++)
-    {
-    	CC_SIPCCCallMediaDataPtr pMediaData = (*it)->getMediaData();
-
-    	base::AutoLock lock(pMediaData->streamMapMutex);
-		for (StreamMapType::iterator entry =  pMediaData->streamMap.begin(); entry !=  pMediaData->streamMap.end(); entry++)
-	    {
-			if (entry->second.isVideo == false)
-			{
-				// first is the streamId
-				if (pAudio->sendDtmf(entry->first, digit))
-				{
-					// We have sent a digit, done.
-					bSent = true;
-					break;
-				}
-				else
-				{
-					CSFLogWarnS( logTag, "dtmfBurst:sendDtmf returned fail");
-				}
-			}
-	    }
-    }
 }
 
 void CC_SIPCCService::sendIFrame(cc_call_handle_t call_handle)
@@ -1009,62 +1030,40 @@ void CC_SIPCCService::onVideoModeChanged( bool enable )
 void CC_SIPCCService::onKeyFrameRequested( int stream )
 // This is called when the Video Provider indicates that it needs to send a request for new key frame to the sender
 {
-    CSFLogDebugS(logTag, "onKeyFrameRequested for stream ");
-	// We haven't a clue what stream to use.  Search for a call which has an audio stream.
-	vector<CC_SIPCCCallPtr> calls;
-	{
-		// First build a list of all the calls.
-		cc_deviceinfo_ref_t deviceInfoRef = CCAPI_Device_getDeviceInfo(CCAPI_Device_getDeviceID());
-		cc_call_handle_t handles[MAX_SUPPORTED_NUM_CALLS] = {};
-		cc_uint16_t numHandles = csf_countof(handles);
-
-		CCAPI_DeviceInfo_getCalls(deviceInfoRef, handles, &numHandles);
+    CSFLogDebugS(logTag, "onKeyFrameRequested for stream " << stream);
 
-		for (int i=0; i<numHandles; i++)
-		{
-			CC_SIPCCCallPtr callPtr = CC_SIPCCCall::wrap(handles[i]);
-			//CC_SIPCCCallPtr callPtr = wrapCall(handles[i]);
-			calls.push_back(callPtr);
-		}
-		CCAPI_Device_releaseDeviceInfo(deviceInfoRef);
+	// Send the send info SIP message on the call that owns the video stream.
+	MediaStreamRegistry::Entry entry;
+	if (!MediaStreamRegistry::getInstance()->findByStream(MediaStreamRegistry::VIDEO_STREAM, stream, entry) || entry.callHandle == 0)
+	{
+		CSFLogWarnS(logTag, "onKeyFrameRequested: no call for video stream " << stream);
+		return;
 	}
 
-	// Using the list of all calls, search for those containing an video stream.
-	// Send the send info SIP message when we find the one with the correct stream id.
-
-	bool bSent = false;
-	for(vector<CC_SIPCCCallPtr>::iterator it = calls.begin(); it != calls.end() && !bSent; it++)
-    {
-    	CC_SIPCCCallMediaDataPtr pMediaData = (*it)->getMediaData();
-
-    	base::AutoLock lock(pMediaData->streamMapMutex);
-		for (StreamMapType::iterator entry =  pMediaData->streamMap.begin(); entry !=  pMediaData->streamMap.end(); entry++)
-	    {
-			if ((entry->first==stream) && (entry->second.isVideo == true))
-			{
-                CSFLogDebugS(logTag, "Send SIP message to originator for stream id" << stream);
-				if ((*it)->sendInfo ( "","application/media_control+xml", "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
-						"<media_control>\n"
-						"\n"
-						"  <vc_primitive>\n"
-						"    <to_encoder>\n"
-						"      <picture_fast_update/>\n"
-						"    </to_encoder>\n"
-						"  </vc_primitive>\n"
-						"\n"
-						"</media_control>\n"))
-				{
-					CSFLogWarnS(logTag, "sendinfo returned true");
-					bSent = true;
-					break;
-				}
-				else
-				{
-					CSFLogWarnS(logTag, "sendinfo returned false");
-				}
-			}
-	    }
-    }
+	CC_SIPCCCallPtr callPtr = CC_SIPCCCall::find(entry.callHandle);
+	if (callPtr == NULL)
+	{
+		CSFLogWarnS(logTag, "onKeyFrameRequested: call for video stream " << stream << " has ended");
+		return;
+	}
+	CSFLogDebugS(logTag, "Send SIP message to originator for stream id" << stream);
+	if (callPtr->sendInfo ( "","application/media_control+xml", "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+			"<media_control>\n"
+			"\n"
+			"  <vc_primitive>\n"
+			"    <to_encoder>\n"
+			"      <picture_fast_update/>\n"
+			"    </to_encoder>\n"
+			"  </vc_primitive>\n"
+			"\n"
+			"</media_control>\n"))
+	{
+		CSFLogWarnS(logTag, "sendinfo returned true");
+	}
+	else
+	{
+		CSFLogWarnS(logTag, "sendinfo returned false");
+	}
 }
 
 void CC_SIPCCService::onMediaLost( int callId )
@@ -1095,4 +1094,25 @@ bool CC_SIPCCService::setROAPClientMode(bool mode)  {
 	return CCAPI_Config_set_roap_client_mode(mode);
 }
 
+bool CC_SIPCCService::setBandwidthBudget(const std::string& localAddress, int kbps) {
+	if (kbps < 0) {
+		return false;
+	}
+	MediaBandwidthManager::getInstance()->setBudget(localAddress, kbps);
+	return true;
+}
+
+bool CC_SIPCCService::setMeasuredBandwidth(const std::string& localAddress, int kbps) {
+	if (kbps < 0) {
+		return false;
+	}
+	MediaBandwidthManager::getInstance()->setMeasuredCapacity(localAddress, kbps);
+	return true;
+}
+
+bool CC_SIPCCService::getBandwidthUtilization(MediaBandwidthUtilization& utilization) {
+	MediaBandwidthManager::getInstance()->getUtilization(utilization);
+	return true;
+}
+
 } // End of namespace CSF
@@ -60,6 +60,7 @@ extern "C" {
 #include "CSFAudioControlWrapper.h"
 #include "CSFVideoControlWrapper.h"
 #include "CSFMediaProvider.h"
+#include "CC_SIPCCEventDispatcher.h"
 
 #include "lock.h"
 #include "waitable_event.h"
@@ -125,6 +126,13 @@ namespace CSF
 		virtual bool setROAPProxyMode(bool mode);
 		virtual bool setROAPClientMode(bool mode);
 
+		virtual bool setBandwidthBudget(const std::string& localAddress, int kbps);
+		virtual bool setMeasuredBandwidth(const std::string& localAddress, int kbps);
+		virtual bool getBandwidthUtilization(MediaBandwidthUtilization& utilization);
+
+		// Queue limits, coalescing and per-observer delivery statistics
+		CC_SIPCCEventDispatcher & getEventDispatcher();
+
         /**
          * End of public API
          */
@@ -151,6 +159,7 @@ namespace CSF
         bool waitUntilSIPCCFullyStarted();
         void signalToPhoneWhenInService (ccapi_device_event_e type, cc_deviceinfo_ref_t info);
         void endAllActiveCalls();
+        void logWrapperCounts();
 
         void applyLoggingMask(int newMask);
         void applyAudioVideoConfigSettings (PhoneConfig & phoneConfig);
@@ -172,14 +181,18 @@ namespace CSF
 	    // SIPCC lifecycle
         bool bCreated;
         bool bStarted;
-        base::Lock m_lock;
         base::WaitableEvent sippStartedEvent;
 
+        // Calls endAllActiveCalls() has ended and not yet seen go on hook
+        base::Lock endingCallsLock;
+        std::set<CC_Call*> endingCalls;
+        base::WaitableEvent callsEndedEvent;
+
         // Media Lifecycle
         VcmSIPCCBinding vcmMediaBridge;
 
         // Observers
-    	std::set<CC_Observer *> ccObservers;
+        CC_SIPCCEventDispatcher eventDispatcher;
 
 		//AV Control Wrappers
 		AudioControlWrapperPtr audioControlWrapper;
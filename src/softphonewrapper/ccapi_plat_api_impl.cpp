@@ -53,6 +53,7 @@
 #endif
 
 #include "CSFLog.h"
+#include "MediaBandwidthManager.h"
 static const char* logTag = "sipcc";
 
 extern "C"
@@ -229,10 +230,13 @@ cpr_ip_mode_e platGetIpAddressMode() {
 /**
  * Tell whether wifi is supported and active
  *
+ * GSM only runs call admission control (fsmcac) while this is true, so
+ * it is on whenever a bandwidth budget applies to the local address.
+ *
  * @return boolean wether WLAN is active or not
  */
 cc_boolean	platWlanISActive() {
-    return FALSE;
+    return CSF::MediaBandwidthManager::getInstance()->isEnabled() ? TRUE : FALSE;
 }
 
 /**
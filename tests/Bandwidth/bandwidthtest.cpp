@@ -0,0 +1,421 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * bandwidthtest - unit tests for MediaBandwidthManager, the call admission
+ * control behind vcmAllocateBandwidth and vcmRemoveBandwidth.
+ *
+ *   bandwidthtest [-v]
+ *
+ * The media providers are replaced by FakeBandwidthSource, which charges
+ * whatever session cost a test sets. Each test runs on its own manager.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "MediaBandwidthManager.h"
+#include "CSFLog.h"
+
+using namespace CSF;
+
+static bool verbose = false;
+static int checks = 0;
+static int failures = 0;
+
+// The manager logs through CSFLog; keep it quiet unless asked.
+void CSFLogV( CSFLogLevel priority, const char* sourceFile, int sourceLine, const char* tag, const char* format, va_list args )
+{
+	if ( verbose )
+	{
+		fprintf( stderr, "%s: ", tag );
+		vfprintf( stderr, format, args );
+	}
+}
+
+void CSFLog( CSFLogLevel priority, const char* sourceFile, int sourceLine, const char* tag, const char* format, ... )
+{
+	va_list ap;
+	va_start( ap, format );
+	CSFLogV( priority, sourceFile, sourceLine, tag, format, ap );
+	va_end( ap );
+}
+
+#define EXPECT(cond) check( (cond), #cond, __FILE__, __LINE__ )
+#define EXPECT_EQ(a, b) checkEq( (int)(a), (int)(b), #a, __FILE__, __LINE__ )
+
+static void check( bool ok, const char* what, const char* file, int line )
+{
+	checks++;
+	if ( !ok )
+	{
+		printf( "FAIL %s:%d: %s\n", file, line, what );
+		failures++;
+	}
+}
+
+static void checkEq( int actual, int expected, const char* what, const char* file, int line )
+{
+	checks++;
+	if ( actual != expected )
+	{
+		printf( "FAIL %s:%d: %s is %d, expected %d\n", file, line, what, actual, expected );
+		failures++;
+	}
+}
+
+// Stands in for the audio or video provider.
+class FakeBandwidthSource : public MediaBandwidthSource
+{
+public:
+	FakeBandwidthSource( int kbps ) : kbps(kbps) {}
+	int getSessionCostKbps() { return kbps; }
+	int kbps;
+};
+
+static MediaBandwidthUtilization utilization( MediaBandwidthManager& manager )
+{
+	MediaBandwidthUtilization u;
+	memset( &u, 0, sizeof(u) );
+	manager.getUtilization( u );
+	return u;
+}
+
+// ----------------------------------------------------------------------------
+static void testPacketOverhead()
+{
+	// G.711 at 20ms: 64 kbps payload, 50 packets of 40 header bytes
+	EXPECT_EQ( MediaBandwidthManager::addPacketOverhead( 64, 50 ), 80 );
+	// overhead is rounded up to a whole kbps
+	EXPECT_EQ( MediaBandwidthManager::addPacketOverhead( 0, 1 ), 1 );
+	EXPECT_EQ( MediaBandwidthManager::addPacketOverhead( 32, 0 ), 32 );
+}
+
+static void testNoBudgetAdmitsEverything()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 80 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+
+	EXPECT( !manager.isEnabled() );
+	for ( int call = 1; call <= 100; call++ )
+	{
+		EXPECT( manager.reserve( call, 1 ) );
+	}
+	// still reserved, so the numbers are right if a budget turns up mid-call
+	MediaBandwidthUtilization u = utilization( manager );
+	EXPECT_EQ( u.budgetKbps, 0 );
+	EXPECT_EQ( u.reservedKbps, 8000 );
+	EXPECT_EQ( u.reservations, 100 );
+	EXPECT_EQ( u.admitted, 100 );
+	EXPECT_EQ( u.rejected, 0 );
+
+	// a budget set now applies to new calls only
+	manager.setBudget( "", 8000 );
+	EXPECT( manager.isEnabled() );
+	EXPECT( !manager.reserve( 101, 1 ) );
+	manager.release( 1 );
+	EXPECT( manager.reserve( 101, 1 ) );
+}
+
+static void testSessionCost()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 80 );
+	FakeBandwidthSource video( 500 );
+
+	// nothing to send, nothing to charge
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT_EQ( manager.getReservedKbps( 1 ), 0 );
+
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+	manager.setSource( MediaStreamRegistry::VIDEO_STREAM, &video );
+	EXPECT_EQ( utilization( manager ).sessionCostKbps, 580 );
+
+	EXPECT( manager.reserve( 2, 1 ) );
+	EXPECT_EQ( manager.getReservedKbps( 2 ), 580 );
+	EXPECT( manager.reserve( 3, 3 ) );
+	EXPECT_EQ( manager.getReservedKbps( 3 ), 1740 );
+	// no session count is one session
+	EXPECT( manager.reserve( 4, 0 ) );
+	EXPECT_EQ( manager.getReservedKbps( 4 ), 580 );
+
+	manager.setSource( MediaStreamRegistry::VIDEO_STREAM, NULL );
+	EXPECT_EQ( utilization( manager ).sessionCostKbps, 80 );
+	EXPECT( manager.reserve( 5, 1 ) );
+	EXPECT_EQ( manager.getReservedKbps( 5 ), 80 );
+	EXPECT_EQ( manager.getReservedKbps( 99 ), 0 );
+}
+
+static void testBudgetAdmission()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 80 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+	manager.setBudget( "", 240 );
+
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT( manager.reserve( 2, 1 ) );
+	// exactly fills the budget
+	EXPECT( manager.reserve( 3, 1 ) );
+	EXPECT( !manager.reserve( 4, 1 ) );
+	EXPECT_EQ( manager.getReservedKbps( 4 ), 0 );
+
+	MediaBandwidthUtilization u = utilization( manager );
+	EXPECT_EQ( u.budgetKbps, 240 );
+	EXPECT_EQ( u.reservedKbps, 240 );
+	EXPECT_EQ( u.peakReservedKbps, 240 );
+	EXPECT_EQ( u.reservations, 3 );
+	EXPECT_EQ( u.admitted, 3 );
+	EXPECT_EQ( u.rejected, 1 );
+
+	manager.release( 2 );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 160 );
+	EXPECT( manager.reserve( 4, 1 ) );
+
+	// unknown and repeated releases change nothing
+	manager.release( 2 );
+	manager.release( 42 );
+	u = utilization( manager );
+	EXPECT_EQ( u.reservedKbps, 240 );
+	EXPECT_EQ( u.peakReservedKbps, 240 );
+
+	manager.release( 1 );
+	manager.release( 3 );
+	manager.release( 4 );
+	u = utilization( manager );
+	EXPECT_EQ( u.reservedKbps, 0 );
+	EXPECT_EQ( u.reservations, 0 );
+	EXPECT_EQ( u.peakReservedKbps, 240 );
+}
+
+// Offhook, digits and setup each ask again for the same call.
+static void testReserveAgainReplaces()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 100 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+	manager.setBudget( "", 300 );
+
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 100 );
+
+	// growing only needs the difference
+	EXPECT( manager.reserve( 2, 1 ) );
+	EXPECT( manager.reserve( 1, 2 ) );
+	EXPECT_EQ( manager.getReservedKbps( 1 ), 200 );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 300 );
+
+	// growing past the budget is refused and the old reservation stays
+	EXPECT( !manager.reserve( 2, 2 ) );
+	EXPECT_EQ( manager.getReservedKbps( 2 ), 100 );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 300 );
+
+	// shrinking always fits
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 200 );
+	EXPECT_EQ( utilization( manager ).reservations, 2 );
+}
+
+static void testPerAddressBudgets()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 100 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+
+	manager.setBudget( "10.0.0.1", 200 );
+	manager.setActiveAddress( "10.0.0.2" );
+	EXPECT( !manager.isEnabled() );
+
+	// "" covers addresses without a budget of their own
+	manager.setBudget( "", 1000 );
+	EXPECT( manager.isEnabled() );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 1000 );
+
+	manager.setActiveAddress( "10.0.0.1" );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 200 );
+	EXPECT( manager.reserve( 1, 2 ) );
+	EXPECT( !manager.reserve( 2, 1 ) );
+
+	// moving to an address with more room admits again
+	manager.setActiveAddress( "10.0.0.2" );
+	EXPECT( manager.reserve( 2, 1 ) );
+
+	// 0 removes a budget
+	manager.setBudget( "", 0 );
+	EXPECT( !manager.isEnabled() );
+	manager.setBudget( "10.0.0.1", 0 );
+	manager.setActiveAddress( "10.0.0.1" );
+	EXPECT( !manager.isEnabled() );
+}
+
+static void testMeasuredCapacity()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 100 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+	manager.setActiveAddress( "10.0.0.1" );
+
+	// a measurement alone does not turn admission on
+	manager.setMeasuredCapacity( "10.0.0.1", 150 );
+	EXPECT( !manager.isEnabled() );
+
+	// it lowers a budget
+	manager.setBudget( "10.0.0.1", 500 );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 150 );
+	EXPECT( manager.reserve( 1, 1 ) );
+	EXPECT( !manager.reserve( 2, 1 ) );
+
+	// but never raises it
+	manager.setMeasuredCapacity( "10.0.0.1", 900 );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 500 );
+
+	// "" measures every address without its own measurement
+	manager.setMeasuredCapacity( "10.0.0.1", 0 );
+	manager.setMeasuredCapacity( "", 300 );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 300 );
+	manager.setMeasuredCapacity( "", 0 );
+	EXPECT_EQ( utilization( manager ).budgetKbps, 500 );
+}
+
+// ----------------------------------------------------------------------------
+// Several threads place and end calls against one budget; the budget is never overrun.
+#define STRESS_THREADS	8
+#define STRESS_CALLS	20000
+#define STRESS_BUDGET	1000
+
+struct StressArgs
+{
+	MediaBandwidthManager* manager;
+	int firstCall;
+	int admitted;
+};
+
+static void* stressThread( void* arg )
+{
+	StressArgs* args = (StressArgs*)arg;
+	for ( int i = 0; i < STRESS_CALLS; i++ )
+	{
+		int call = args->firstCall + (i % 16);
+		if ( args->manager->reserve( call, 1 + (i & 1) ) )
+		{
+			args->admitted++;
+		}
+		if ( (i % 3) == 0 )
+		{
+			args->manager->release( call );
+		}
+	}
+	return NULL;
+}
+
+static void testConcurrentReservations()
+{
+	MediaBandwidthManager manager;
+	FakeBandwidthSource audio( 80 );
+	manager.setSource( MediaStreamRegistry::AUDIO_STREAM, &audio );
+	manager.setBudget( "", STRESS_BUDGET );
+
+	pthread_t threads[STRESS_THREADS];
+	StressArgs args[STRESS_THREADS];
+	for ( int t = 0; t < STRESS_THREADS; t++ )
+	{
+		args[t].manager = &manager;
+		args[t].firstCall = t * 100;
+		args[t].admitted = 0;
+		pthread_create( &threads[t], NULL, stressThread, &args[t] );
+	}
+	unsigned int admitted = 0;
+	for ( int t = 0; t < STRESS_THREADS; t++ )
+	{
+		pthread_join( threads[t], NULL );
+		admitted += args[t].admitted;
+	}
+
+	MediaBandwidthUtilization u = utilization( manager );
+	EXPECT( u.peakReservedKbps <= STRESS_BUDGET );
+	EXPECT_EQ( u.admitted, admitted );
+	EXPECT_EQ( u.admitted + u.rejected, STRESS_THREADS * STRESS_CALLS );
+
+	// what is left reserved is exactly what the remaining calls hold
+	int held = 0;
+	for ( int t = 0; t < STRESS_THREADS; t++ )
+	{
+		for ( int c = 0; c < 16; c++ )
+		{
+			held += manager.getReservedKbps( t * 100 + c );
+			manager.release( t * 100 + c );
+		}
+	}
+	EXPECT_EQ( u.reservedKbps, held );
+	EXPECT_EQ( utilization( manager ).reservedKbps, 0 );
+	EXPECT_EQ( utilization( manager ).reservations, 0 );
+}
+
+int main( int argc, char** argv )
+{
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "-v" ) == 0 )
+		{
+			verbose = true;
+		}
+		else
+		{
+			fprintf( stderr, "usage: %s [-v]\n", argv[0] );
+			return 2;
+		}
+	}
+
+	testPacketOverhead();
+	testNoBudgetAdmitsEverything();
+	testSessionCost();
+	testBudgetAdmission();
+	testReserveAgainReplaces();
+	testPerAddressBudgets();
+	testMeasuredCapacity();
+	testConcurrentReservations();
+
+	printf( "%d checks, %d failures\n", checks, failures );
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,513 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * configsnapshottest - check the published config snapshots and
+ * reconfigure them from one thread while others read.
+ *
+ *   configsnapshottest [-t readers] [-n updates]
+ *
+ * Checks: a set publishes one new version and a set to the same value
+ * none, sets between config_snapshot_begin_update() and
+ * config_snapshot_end_update() stay invisible until the end and then go
+ * live as one version, the typed accessors agree with config_get_value(),
+ * and subscribers hear about exactly the ids that changed.
+ *
+ * Stress: the writer runs numbered updates. Each batches timerT1 = k,
+ * timerT2 = 2k and ccm1_address set to a pattern made from k, then sets
+ * ccm2_address to a pattern on its own. Readers pin a snapshot and check
+ * the three batched values belong to the same update, read ccm2_address
+ * with config_get_string() and check it is one whole pattern, and check
+ * versions and timerT1 never go backwards. A pattern is a run of one
+ * letter whose length depends on the letter, so a string read while it
+ * was being rewritten shows up as mixed letters or a wrong length.
+ *
+ * Time: config_get_value() and config_get_int() of timerT1, idle and
+ * while the writer runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "config.h"
+#include "config_snapshot.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+
+#define MAX_THREADS     64
+#define PATTERN_LEN     MAX_IPADDR_STR_LEN
+
+extern void protCfgTblInit();
+
+typedef struct {
+    int reads;
+    int pinned;
+} reader_t;
+
+static volatile int failures = 0;
+static volatile int writer_done = 0;
+static volatile int t1_notes = 0;
+static volatile int t2_notes = 0;
+static volatile int quiet_notes = 0;
+static volatile uint32_t last_note_version = 0;
+
+/*
+ * Application callbacks, never called
+ */
+void
+configFetchReq (int device_handle)
+{
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+static void
+fail (const char *what, long got, long expect)
+{
+    __sync_add_and_fetch(&failures, 1);
+    fprintf(stderr, "FAIL %s: got %ld expected %ld\n", what, got, expect);
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* letter 'a' + k % 26, repeated 10 + k % 26 times */
+static void
+make_pattern (int k, char *buf)
+{
+    int len = 10 + (k % 26);
+
+    memset(buf, 'a' + (k % 26), len);
+    buf[len] = 0;
+}
+
+/* the k % 26 a pattern was made from, or -1 if it is not a whole one */
+static int
+check_pattern (const char *buf)
+{
+    int len = (int) strlen(buf);
+    int i;
+
+    if (buf[0] < 'a' || buf[0] > 'z' || len != 10 + (buf[0] - 'a')) {
+        return -1;
+    }
+    for (i = 1; i < len; i++) {
+        if (buf[i] != buf[0]) {
+            return -1;
+        }
+    }
+    return buf[0] - 'a';
+}
+
+static void
+set_int (int id, int value)
+{
+    config_set_value(id, &value, sizeof(value));
+}
+
+static void
+note (int id, uint32_t version, void *data)
+{
+    if (id == CFGID_TIMER_T1) {
+        __sync_add_and_fetch(&t1_notes, 1);
+    } else if (id == CFGID_TIMER_T2) {
+        __sync_add_and_fetch(&t2_notes, 1);
+    } else {
+        __sync_add_and_fetch(&quiet_notes, 1);
+    }
+    last_note_version = version;
+}
+
+static void
+check_basics (void)
+{
+    const config_snapshot_t *snap;
+    char buf[PATTERN_LEN];
+    uint32_t version;
+    int h1, h2, h3;
+    int value = 0;
+
+    snap = config_snapshot_acquire();
+    if (snap == NULL) {
+        fail("no snapshot after init", 0, 1);
+        return;
+    }
+    config_snapshot_release(snap);
+
+    h1 = config_snapshot_subscribe(CFGID_TIMER_T1, 1, note, NULL);
+    h2 = config_snapshot_subscribe(CFGID_TIMER_T2, 1, note, NULL);
+    h3 = config_snapshot_subscribe(CFGID_CCM3_ADDRESS, 1, note, NULL);
+    if (h1 < 0 || h2 < 0 || h3 < 0) {
+        fail("subscribe", -1, 0);
+    }
+    if (config_snapshot_subscribe(CFGID_PROTOCOL_MAX - 1, 2, note,
+                                  NULL) != -1) {
+        fail("subscribe past the table", 0, -1);
+    }
+
+    /* one set, one version */
+    version = config_snapshot_version();
+    set_int(CFGID_TIMER_T1, 500);
+    if (config_snapshot_version() != version + 1) {
+        fail("version after set", config_snapshot_version(), version + 1);
+    }
+    if (config_get_int(CFGID_TIMER_T1) != 500) {
+        fail("config_get_int", config_get_int(CFGID_TIMER_T1), 500);
+    }
+    config_get_value(CFGID_TIMER_T1, &value, sizeof(value));
+    if (value != 500) {
+        fail("config_get_value", value, 500);
+    }
+    if (t1_notes != 1 || t2_notes != 0) {
+        fail("notes after set", t1_notes * 100 + t2_notes, 100);
+    }
+
+    /* same value, no version */
+    set_int(CFGID_TIMER_T1, 500);
+    if (config_snapshot_version() != version + 1) {
+        fail("version after same set", config_snapshot_version(),
+             version + 1);
+    }
+
+    /* a batch goes live at the end, as one version */
+    config_snapshot_begin_update();
+    set_int(CFGID_TIMER_T1, 700);
+    set_int(CFGID_TIMER_T2, 1400);
+    config_set_string(CFGID_CCM1_ADDRESS, "10.0.0.1");
+    if (config_get_int(CFGID_TIMER_T1) != 500) {
+        fail("read inside batch", config_get_int(CFGID_TIMER_T1), 500);
+    }
+    config_snapshot_begin_update();
+    set_int(CFGID_TIMER_T2, 1500);
+    config_snapshot_end_update();
+    if (config_snapshot_version() != version + 1) {
+        fail("version inside nested batch", config_snapshot_version(),
+             version + 1);
+    }
+    config_snapshot_end_update();
+    if (config_snapshot_version() != version + 2) {
+        fail("version after batch", config_snapshot_version(), version + 2);
+    }
+    if (config_get_int(CFGID_TIMER_T2) != 1500) {
+        fail("T2 after batch", config_get_int(CFGID_TIMER_T2), 1500);
+    }
+    config_get_string(CFGID_CCM1_ADDRESS, buf, sizeof(buf));
+    if (strcmp(buf, "10.0.0.1") != 0) {
+        fail("ccm1_address after batch", 0, 1);
+    }
+    if (t1_notes != 2 || t2_notes != 1 || quiet_notes != 0) {
+        fail("notes after batch", t1_notes * 100 + t2_notes * 10 + quiet_notes,
+             210);
+    }
+    if (last_note_version != version + 2) {
+        fail("note version", last_note_version, version + 2);
+    }
+
+    /* line accessor: line 2 of maxnumcalls */
+    config_set_line_value(CFGID_LINE_MAXNUMCALLS, &value, sizeof(value), 2);
+    value = 0;
+    config_get_line_value(CFGID_LINE_MAXNUMCALLS, &value, sizeof(value), 2);
+    if (config_get_line_int(CFGID_LINE_MAXNUMCALLS, 2) != value ||
+        value != 500) {
+        fail("config_get_line_int",
+             config_get_line_int(CFGID_LINE_MAXNUMCALLS, 2), value);
+    }
+    /* a string id is not an int; falls back to config_get_value */
+    (void) config_get_int(CFGID_CCM1_ADDRESS);
+
+    config_snapshot_unsubscribe(h3);
+    config_snapshot_unsubscribe(h2);
+    config_snapshot_unsubscribe(h1);
+    set_int(CFGID_TIMER_T1, 0);
+    if (t1_notes != 2) {
+        fail("note after unsubscribe", t1_notes, 2);
+    }
+    t1_notes = t2_notes = quiet_notes = 0;
+}
+
+static void *
+writer (void *arg)
+{
+    int updates = *(int *) arg;
+    char pattern[PATTERN_LEN];
+    int k;
+
+    for (k = 1; k <= updates; k++) {
+        make_pattern(k, pattern);
+        config_snapshot_begin_update();
+        set_int(CFGID_TIMER_T1, k);
+        set_int(CFGID_TIMER_T2, 2 * k);
+        config_set_string(CFGID_CCM1_ADDRESS, pattern);
+        config_snapshot_end_update();
+
+        make_pattern(k + 13, pattern);
+        config_set_string(CFGID_CCM2_ADDRESS, pattern);
+    }
+    __sync_lock_test_and_set(&writer_done, 1);
+    return NULL;
+}
+
+static void *
+reader (void *arg)
+{
+    reader_t *r = (reader_t *) arg;
+    const config_snapshot_t *snap;
+    char buf[PATTERN_LEN];
+    uint32_t last_version = 0;
+    int last_t1 = 0;
+    int t1, t2;
+    int odd = 0;
+
+    while (!__sync_fetch_and_add(&writer_done, 0)) {
+        /* three values from one pinned version */
+        snap = config_snapshot_acquire();
+        t1 = *(const int *) config_snapshot_addr(snap, CFGID_TIMER_T1);
+        t2 = *(const int *) config_snapshot_addr(snap, CFGID_TIMER_T2);
+        memcpy(buf, config_snapshot_addr(snap, CFGID_CCM1_ADDRESS),
+               sizeof(buf));
+        if (snap->version < last_version) {
+            fail("version went back", snap->version, last_version);
+        }
+        last_version = snap->version;
+        config_snapshot_release(snap);
+        r->pinned++;
+        if (t1 > 0) {
+            if (t2 != 2 * t1) {
+                fail("T2 of the same version", t2, 2 * t1);
+            }
+            if (check_pattern(buf) != t1 % 26) {
+                fail("ccm1_address of the same version",
+                     check_pattern(buf), t1 % 26);
+            }
+        }
+
+        /* single reads through the config API */
+        config_get_string(CFGID_CCM2_ADDRESS, buf, sizeof(buf));
+        if (buf[0] && check_pattern(buf) < 0) {
+            fail("torn ccm2_address", (long) strlen(buf), 0);
+        }
+        t1 = config_get_int(CFGID_TIMER_T1);
+        if (t1 < last_t1) {
+            fail("timerT1 went back", t1, last_t1);
+        }
+        last_t1 = t1;
+        r->reads++;
+        /* let the writer in now and then on a single CPU */
+        if ((++odd & 63) == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void
+stress (int threads, int updates)
+{
+    pthread_t tids[MAX_THREADS], wtid;
+    reader_t readers[MAX_THREADS];
+    config_snapshot_stats_t stats;
+    uint32_t version;
+    double t0, t;
+    int h1, h2, h3;
+    int reads = 0;
+    int i;
+
+    h1 = config_snapshot_subscribe(CFGID_TIMER_T1, 1, note, NULL);
+    h2 = config_snapshot_subscribe(CFGID_TIMER_T2, 1, note, NULL);
+    h3 = config_snapshot_subscribe(CFGID_CCM3_ADDRESS, 1, note, NULL);
+    version = config_snapshot_version();
+
+    memset(readers, 0, sizeof(readers));
+    writer_done = 0;
+    t0 = now_ns();
+    for (i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, reader, &readers[i]);
+    }
+    pthread_create(&wtid, NULL, writer, &updates);
+    pthread_join(wtid, NULL);
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        reads += readers[i].reads;
+    }
+    t = now_ns() - t0;
+
+    /* every update is one batch version and one ccm2_address version */
+    if (config_snapshot_version() != version + 2 * (uint32_t) updates) {
+        fail("versions published", config_snapshot_version(),
+             version + 2 * updates);
+    }
+    if (t1_notes != updates || t2_notes != updates || quiet_notes != 0) {
+        fail("notes", t1_notes, updates);
+    }
+    config_snapshot_get_stats(&stats);
+    printf("stress: %d updates, %d readers, %d reads in %.0f ms; "
+           "%u snapshot buffers\n", updates, threads, reads,
+           t / 1e6, stats.buffers);
+
+    config_snapshot_unsubscribe(h3);
+    config_snapshot_unsubscribe(h2);
+    config_snapshot_unsubscribe(h1);
+}
+
+static void *
+bench_writer (void *arg)
+{
+    int k = 0;
+
+    while (!__sync_fetch_and_add(&writer_done, 0)) {
+        set_int(CFGID_TIMER_T2, ++k);
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void
+bench_reads (const char *label, int iterations)
+{
+    double t0, t_value, t_int;
+    int value = 0;
+    int sum = 0;
+    int i;
+
+    t0 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        config_get_value(CFGID_TIMER_T1, &value, sizeof(value));
+        sum += value;
+    }
+    t_value = now_ns() - t0;
+    t0 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        sum += config_get_int(CFGID_TIMER_T1);
+    }
+    t_int = now_ns() - t0;
+    printf("%s: config_get_value %.1f ns, config_get_int %.1f ns (%d)\n",
+           label, t_value / iterations, t_int / iterations, sum & 1);
+}
+
+static void
+bench (int iterations)
+{
+    pthread_t wtid;
+    double t0;
+    int i;
+
+    bench_reads("idle", iterations);
+
+    writer_done = 0;
+    pthread_create(&wtid, NULL, bench_writer, NULL);
+    bench_reads("writer running", iterations);
+    __sync_lock_test_and_set(&writer_done, 1);
+    pthread_join(wtid, NULL);
+
+    t0 = now_ns();
+    for (i = 0; i < iterations / 100; i++) {
+        set_int(CFGID_TIMER_T2, i + 1);
+    }
+    printf("set and publish: %.0f ns\n",
+           (now_ns() - t0) / (iterations / 100));
+}
+
+int
+main (int argc, char **argv)
+{
+    int threads = 4;
+    int updates = 20000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && (i + 1 < argc)) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            updates = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-t readers] [-n updates]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if ((threads < 1) || (threads > MAX_THREADS)) {
+        threads = MAX_THREADS;
+    }
+
+    protCfgTblInit();
+    check_basics();
+    stress(threads, updates);
+    printf("checks done, %d failures\n", failures);
+    if (failures) {
+        return 1;
+    }
+    bench(1000000);
+    return 0;
+}
@@ -0,0 +1,341 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * converttest - check the SIMD I420/RGB32 kernels in ikran/Convert.cpp
+ * against the C kernels and time each kernel set.
+ *
+ *   converttest [-s seed] [-n frames] [-f frames]
+ *
+ * Check: random planes of many sizes, odd widths and heights included,
+ * with padded strides, are converted both ways with the C kernels and
+ * with every SIMD set the CPU supports. The outputs have to be bit exact
+ * and the stride padding has to be left alone. The packed I420toRGB32 and
+ * RGB32toI420 entry points are checked against the plane variants.
+ *
+ * Time: 640x480 and 1280x720 frames are converted both ways with each
+ * kernel set.
+ */
+
+#include "Convert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+static const char *kernel_names[] = { "C", "SSE2", "AVX2" };
+
+static const unsigned char PAD = 0xa5;
+
+static double
+now_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+fill_random (std::vector<char> &buf)
+{
+	for (size_t i = 0; i < buf.size(); i++)
+		buf[i] = (char) (rand() & 0xff);
+}
+
+/* An I420 frame in separate planes with padded strides. */
+struct Planes {
+	int width, height;
+	int stride_y, stride_c;
+	std::vector<char> y, u, v;
+
+	Planes(int w, int h, int pad)
+		: width(w), height(h),
+		  stride_y(w + pad), stride_c((w + 1) / 2 + pad),
+		  y(stride_y * h, PAD),
+		  u(stride_c * ((h + 1) / 2), PAD),
+		  v(stride_c * ((h + 1) / 2), PAD)
+	{
+	}
+};
+
+static int
+check_i420_to_rgb32 (int kernels, int width, int height, int pad)
+{
+	Planes src(width, height, pad);
+	int dst_stride = width * 4 + pad * 4;
+	std::vector<char> ref(dst_stride * height, PAD);
+	std::vector<char> out(dst_stride * height, PAD);
+
+	fill_random(src.y);
+	fill_random(src.u);
+	fill_random(src.v);
+
+	ConvertSetKernels(CONVERT_KERNELS_C);
+	I420toRGB32Planes(width, height, &src.y[0], src.stride_y,
+		&src.u[0], src.stride_c, &src.v[0], src.stride_c,
+		&ref[0], dst_stride);
+	ConvertSetKernels(kernels);
+	I420toRGB32Planes(width, height, &src.y[0], src.stride_y,
+		&src.u[0], src.stride_c, &src.v[0], src.stride_c,
+		&out[0], dst_stride);
+
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < dst_stride; j++) {
+			int at = i * dst_stride + j;
+
+			if (j >= width * 4 && out[at] != (char) PAD) {
+				printf("FAIL I420->RGB32 %s %dx%d pad %d: wrote padding "
+					"at row %d byte %d\n", kernel_names[kernels],
+					width, height, pad, i, j);
+				return 1;
+			}
+			if (out[at] != ref[at]) {
+				printf("FAIL I420->RGB32 %s %dx%d pad %d: row %d byte %d "
+					"is %02x, C gives %02x\n", kernel_names[kernels],
+					width, height, pad, i, j, out[at] & 0xff,
+					ref[at] & 0xff);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int
+compare_plane (const char *what, int kernels, int width, int height,
+	int pad, const std::vector<char> &ref, const std::vector<char> &out,
+	int rows, int cols, int stride)
+{
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < stride; j++) {
+			int at = i * stride + j;
+
+			if (j >= cols && out[at] != (char) PAD) {
+				printf("FAIL RGB32->I420 %s %s %dx%d pad %d: wrote padding "
+					"at row %d byte %d\n", what, kernel_names[kernels],
+					width, height, pad, i, j);
+				return 1;
+			}
+			if (out[at] != ref[at]) {
+				printf("FAIL RGB32->I420 %s %s %dx%d pad %d: row %d byte %d "
+					"is %02x, C gives %02x\n", what, kernel_names[kernels],
+					width, height, pad, i, j, out[at] & 0xff,
+					ref[at] & 0xff);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int
+check_rgb32_to_i420 (int kernels, int width, int height, int pad)
+{
+	int src_stride = width * 4 + pad * 4;
+	std::vector<char> src(src_stride * height);
+	Planes ref(width, height, pad);
+	Planes out(width, height, pad);
+	int chroma_w = (width + 1) / 2, chroma_h = (height + 1) / 2;
+
+	fill_random(src);
+
+	ConvertSetKernels(CONVERT_KERNELS_C);
+	RGB32toI420Planes(width, height, &src[0], src_stride,
+		&ref.y[0], ref.stride_y, &ref.u[0], ref.stride_c,
+		&ref.v[0], ref.stride_c);
+	ConvertSetKernels(kernels);
+	RGB32toI420Planes(width, height, &src[0], src_stride,
+		&out.y[0], out.stride_y, &out.u[0], out.stride_c,
+		&out.v[0], out.stride_c);
+
+	return compare_plane("Y", kernels, width, height, pad, ref.y, out.y,
+			height, width, ref.stride_y) ||
+		compare_plane("U", kernels, width, height, pad, ref.u, out.u,
+			chroma_h, chroma_w, ref.stride_c) ||
+		compare_plane("V", kernels, width, height, pad, ref.v, out.v,
+			chroma_h, chroma_w, ref.stride_c);
+}
+
+/* The packed entry points lay the planes out back to back. */
+static int
+check_packed (int kernels, int width, int height)
+{
+	int chroma = ((width + 1) / 2) * ((height + 1) / 2);
+	int i420_size = width * height + 2 * chroma;
+	std::vector<char> i420(i420_size), i420_planes(i420_size);
+	std::vector<char> rgb(width * height * 4), rgb_planes(width * height * 4);
+
+	ConvertSetKernels(kernels);
+
+	fill_random(i420);
+	I420toRGB32(width, height, &i420[0], &rgb[0]);
+	I420toRGB32Planes(width, height, &i420[0], width,
+		&i420[width * height], (width + 1) / 2,
+		&i420[width * height + chroma], (width + 1) / 2,
+		&rgb_planes[0], width * 4);
+	if (rgb != rgb_planes) {
+		printf("FAIL I420toRGB32 %s %dx%d differs from the plane variant\n",
+			kernel_names[kernels], width, height);
+		return 1;
+	}
+
+	fill_random(rgb);
+	RGB32toI420(width, height, &rgb[0], &i420[0]);
+	RGB32toI420Planes(width, height, &rgb[0], width * 4,
+		&i420_planes[0], width,
+		&i420_planes[width * height], (width + 1) / 2,
+		&i420_planes[width * height + chroma], (width + 1) / 2);
+	if (i420 != i420_planes) {
+		printf("FAIL RGB32toI420 %s %dx%d differs from the plane variant\n",
+			kernel_names[kernels], width, height);
+		return 1;
+	}
+	return 0;
+}
+
+static int
+check (int best, int frames)
+{
+	static const int sizes[][2] = {
+		{ 1, 1 }, { 2, 2 }, { 15, 3 }, { 16, 2 }, { 17, 5 }, { 31, 7 },
+		{ 32, 4 }, { 33, 9 }, { 47, 2 }, { 48, 6 }, { 63, 1 }, { 64, 64 },
+		{ 65, 33 }, { 176, 144 }, { 321, 241 }, { 640, 480 }
+	};
+	int failures = 0;
+	int checked = 0;
+
+	for (int kernels = CONVERT_KERNELS_SSE2; kernels <= best; kernels++) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			for (int pad = 0; pad <= 3; pad += 3) {
+				failures += check_i420_to_rgb32(kernels,
+					sizes[s][0], sizes[s][1], pad);
+				failures += check_rgb32_to_i420(kernels,
+					sizes[s][0], sizes[s][1], pad);
+				checked += 2;
+			}
+			failures += check_packed(kernels, sizes[s][0], sizes[s][1]);
+			checked++;
+		}
+		/* random sizes */
+		for (int f = 0; f < frames; f++) {
+			int width = 1 + rand() % 200, height = 1 + rand() % 40;
+			int pad = rand() % 8;
+
+			failures += check_i420_to_rgb32(kernels, width, height, pad);
+			failures += check_rgb32_to_i420(kernels, width, height, pad);
+			checked += 2;
+		}
+	}
+
+	printf("check: %d conversions against the C kernels, %d failures\n",
+		checked, failures);
+	return failures;
+}
+
+static void
+bench (int best, int frames)
+{
+	static const int sizes[][2] = { { 640, 480 }, { 1280, 720 } };
+
+	printf("%-10s %-6s %14s %14s\n", "size", "kernel",
+		"I420->RGB32 ms", "RGB32->I420 ms");
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		int width = sizes[s][0], height = sizes[s][1];
+		std::vector<char> i420(width * height * 3 / 2);
+		std::vector<char> rgb(width * height * 4);
+		char size[32];
+
+		fill_random(i420);
+		fill_random(rgb);
+		snprintf(size, sizeof(size), "%dx%d", width, height);
+
+		for (int kernels = CONVERT_KERNELS_C; kernels <= best; kernels++) {
+			double start, to_rgb, to_i420;
+
+			ConvertSetKernels(kernels);
+			start = now_ns();
+			for (int f = 0; f < frames; f++)
+				I420toRGB32(width, height, &i420[0], &rgb[0]);
+			to_rgb = (now_ns() - start) / frames / 1e6;
+
+			start = now_ns();
+			for (int f = 0; f < frames; f++)
+				RGB32toI420(width, height, &rgb[0], &i420[0]);
+			to_i420 = (now_ns() - start) / frames / 1e6;
+
+			printf("%-10s %-6s %14.3f %14.3f\n", size,
+				kernel_names[kernels], to_rgb, to_i420);
+		}
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	unsigned seed = (unsigned) time(NULL);
+	int frames = 200;
+	int bench_frames = 100;
+	int best;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && (i + 1 < argc)) {
+			seed = (unsigned) strtoul(argv[++i], NULL, 10);
+		} else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+			frames = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-f") && (i + 1 < argc)) {
+			bench_frames = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-s seed] [-n frames] [-f frames]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+
+	srand(seed);
+	best = ConvertSetKernels(CONVERT_KERNELS_BEST);
+	printf("seed %u, kernels up to %s\n", seed, kernel_names[best]);
+
+	if (check(best, frames))
+		return 1;
+	bench(best, bench_frames);
+	return 0;
+}
@@ -0,0 +1,491 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * dialplantest - check the compiled dial plan against the template by
+ * template matcher and time a key press with each.
+ *
+ *   dialplantest [-s seed] [-n plans] [-k keypresses]
+ *
+ * Check: random dial plans, every template feature mixed in ('.', '*',
+ * ',', '\' escapes, '#', lines, rewrites, user and route modes, tones),
+ * are parsed with ParseDialTemplate(). Every prefix of a set of random
+ * dialed strings is then matched with MatchDialTemplateLinear(),
+ * MatchDialTemplate() and MatchDialTemplateCursor() on several lines, with
+ * and without pound dialing, and every output has to agree.
+ *
+ * Time: plans of 10, 100 and 1000 templates shaped like a site dial plan
+ * (extensions, trunk access, long distance, emergency, feature codes and
+ * a catch all) are built and a number is dialed one key at a time, the way
+ * dp_check_dialplan() matches, with the linear matcher and with a cursor.
+ *
+ * Pound dialing follows the call control mode, so this program replaces
+ * sip_regmgr_get_cc_mode(). Like sipreplay it is linked with '-z muldefs',
+ * its object first and the replay shim after it for the platform and
+ * application calls libsipcc expects; nothing is started.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpr_types.h"
+#include "phone_types.h"
+#include "regmgrapi.h"
+#include "dialplan.h"
+#include "cc_constants.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "replay_shim.h"
+
+#define MAX_PLAN_SIZE  (256 * 1024)
+#define REWRITE_LEN    48
+
+static int pound_dialing;
+
+reg_mode_t
+sip_regmgr_get_cc_mode (line_t line)
+{
+    return pound_dialing ? REG_MODE_NON_CCM : REG_MODE_CCM;
+}
+
+/*
+ * Application callbacks, never called
+ */
+void
+configFetchReq (int device_handle)
+{
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+static char plan[MAX_PLAN_SIZE];
+static int plan_len;
+
+static void
+plan_begin (void)
+{
+    plan_len = snprintf(plan, sizeof(plan), "<DIALTEMPLATE>\n");
+}
+
+static void
+plan_add (const char *match, int line, int timeout, const char *user,
+          const char *rewrite, const char *route, int tones)
+{
+    static const char *tone_name[] = {
+        "Bellcore-Inside", "Bellcore-Outside", "Bellcore-Stutter"
+    };
+    int i;
+
+    plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                         "<TEMPLATE MATCH=\"%s\" Timeout=\"%d\"", match,
+                         timeout);
+    if (line) {
+        plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                             " Line=\"%d\"", line);
+    }
+    if (user) {
+        plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                             " User=\"%s\"", user);
+    }
+    if (rewrite) {
+        plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                             " Rewrite=\"%s\"", rewrite);
+    }
+    if (route) {
+        plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                             " Route=\"%s\"", route);
+    }
+    for (i = 0; i < tones; i++) {
+        plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len,
+                             " Tone=\"%s\"", tone_name[i]);
+    }
+    plan_len += snprintf(plan + plan_len, sizeof(plan) - plan_len, "/>\n");
+}
+
+static boolean
+plan_load (void)
+{
+    snprintf(plan + plan_len, sizeof(plan) - plan_len, "</DIALTEMPLATE>\n");
+    return ParseDialTemplate(plan);
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Everything a match hands back */
+typedef struct {
+    DialMatchAction action;
+    int timeout;
+    RouteMode route;
+    vcm_tones_t tone;
+    char rewrite[REWRITE_LEN + 1];
+} match_out_t;
+
+typedef enum {
+    BY_LINEAR,
+    BY_COMPILED,
+    BY_CURSOR
+} match_by_t;
+
+static void
+match (match_by_t by, DialPlanCursor *cursor, const char *digits,
+       line_t line, int timeout, int rewritelen, match_out_t *out)
+{
+    /*
+     * rewritelen 0 asks for no rewrite. rewrite[0] stays put, the user
+     * mode code may look one byte back.
+     */
+    char *rewrite = rewritelen ? out->rewrite + 1 : NULL;
+
+    memset(out, 0, sizeof(*out));
+    out->rewrite[0] = '>';
+    out->timeout = timeout;
+    out->route = (RouteMode) -1;
+    out->tone = VCM_MAX_TONE;
+    switch (by) {
+    case BY_LINEAR:
+        out->action = MatchDialTemplateLinear(digits, line, &out->timeout,
+                                              rewrite, rewritelen,
+                                              &out->route, &out->tone);
+        break;
+    case BY_COMPILED:
+        out->action = MatchDialTemplate(digits, line, &out->timeout,
+                                        rewrite, rewritelen,
+                                        &out->route, &out->tone);
+        break;
+    case BY_CURSOR:
+        out->action = MatchDialTemplateCursor(cursor, digits, line,
+                                              &out->timeout, rewrite,
+                                              rewritelen, &out->route,
+                                              &out->tone);
+        break;
+    }
+}
+
+static int
+same (const match_out_t *a, const match_out_t *b)
+{
+    return (a->action == b->action) && (a->timeout == b->timeout) &&
+        (a->route == b->route) && (a->tone == b->tone) &&
+        (strcmp(a->rewrite, b->rewrite) == 0);
+}
+
+static void
+report (const char *what, const char *digits, line_t line, const match_out_t *o)
+{
+    fprintf(stderr, "  %-8s '%s' line %d: action %d timeout %d route %d "
+            "tone %d rewrite '%s'\n", what, digits, line, o->action,
+            o->timeout, o->route, o->tone, o->rewrite + 1);
+}
+
+static const char *
+random_string (const char *alphabet, int maxlen, char *buf)
+{
+    int len = rand() % (maxlen + 1);
+    int n = (int) strlen(alphabet);
+    int i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = alphabet[rand() % n];
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+static int
+check (unsigned seed, int plans)
+{
+    static const char *users[] = { NULL, "Phone", "IP" };
+    static const char *routes[] = { NULL, "Default", "Emergency", "FQDN" };
+    static const char *rewrites[] = {
+        NULL, "", "9%s", "..", "%1-%2", "1.%%", "<%0>", "%3."
+    };
+    DialPlanCursor cursor;
+    int mismatches = 0;
+    long compared = 0;
+    long compiled = 0;
+    int p;
+
+    srand(seed);
+    ResetDialCursor(&cursor);
+
+    for (p = 0; p < plans; p++) {
+        int templates = 1 + rand() % 12;
+        int t, s;
+
+        plan_begin();
+        for (t = 0; t < templates; t++) {
+            char match[16];
+
+            plan_add(random_string("0123..**,,\\#+", 7, match),
+                     (rand() % 3 == 0) ? 1 + rand() % 2 : 0, rand() % 20,
+                     users[rand() % 3], rewrites[rand() % 8],
+                     routes[rand() % 4], rand() % 4);
+        }
+        if (!plan_load()) {
+            fprintf(stderr, "plan %d did not parse\n%s\n", p, plan);
+            return 1;
+        }
+        if (DialPlanStateCount() != 0) {
+            compiled++;
+        }
+
+        for (s = 0; s < 40; s++) {
+            char digits[16];
+            int len, n;
+
+            random_string((rand() % 8) ? "0123#*+" : "0123#*+a", 12, digits);
+            len = (int) strlen(digits);
+            pound_dialing = rand() % 2;
+            for (n = 0; n <= len; n++) {
+                char prefix[16];
+                line_t line;
+
+                memcpy(prefix, digits, n);
+                prefix[n] = '\0';
+                for (line = 0; line < 4; line++) {
+                    int timeout = (rand() % 2) ? 0 : 7;
+                    int rewritelen = (rand() % 4) ? 0 : REWRITE_LEN;
+                    match_out_t lin, comp, cur;
+
+                    match(BY_LINEAR, NULL, prefix, line, timeout, rewritelen,
+                          &lin);
+                    match(BY_COMPILED, NULL, prefix, line, timeout,
+                          rewritelen, &comp);
+                    match(BY_CURSOR, &cursor, prefix, line, timeout,
+                          rewritelen, &cur);
+                    compared++;
+                    if (!same(&lin, &comp) || !same(&lin, &cur)) {
+                        if (mismatches++ < 10) {
+                            fprintf(stderr, "mismatch, pound dialing %s\n%s",
+                                    pound_dialing ? "on" : "off", plan);
+                            report("linear", prefix, line, &lin);
+                            report("compiled", prefix, line, &comp);
+                            report("cursor", prefix, line, &cur);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    printf("check: %d plans (%ld compiled), %ld matches, %d mismatches\n",
+           plans, compiled, compared, mismatches);
+    if (compiled == 0) {
+        /* every lookup went to the linear matcher; nothing was checked */
+        fprintf(stderr, "no plan compiled\n");
+        return 1;
+    }
+    return mismatches ? 1 : 0;
+}
+
+/*
+ * A site dial plan of about 'size' templates: extension ranges, speed
+ * dials and feature codes on some lines, trunk access, long distance,
+ * international with a second dial tone and a catch all.
+ */
+static void
+build_site_plan (int size)
+{
+    char match[32];
+    int t = 0;
+
+    plan_begin();
+    plan_add("911", 0, 0, "Phone", NULL, "Emergency", 0);
+    plan_add("9911", 0, 0, "Phone", "911", "Emergency", 0);
+    plan_add("9,1..........", 0, 0, "Phone", "1%1", NULL, 2);
+    plan_add("9,011*", 0, 20, "Phone", "011%1", NULL, 2);
+    plan_add("9,.......", 0, 5, "Phone", NULL, NULL, 1);
+    plan_add("*..", 0, 0, NULL, NULL, NULL, 0);
+    t = 6;
+    while (t < size - 1) {
+        switch (t % 4) {
+        case 0:
+            /* extension range */
+            snprintf(match, sizeof(match), "%d%02d..", 2 + (t / 4) % 8,
+                     (t / 32) % 100);
+            plan_add(match, 0, 0, "IP", NULL, NULL, 0);
+            break;
+        case 1:
+            /* site code */
+            snprintf(match, sizeof(match), "8%03d....", (t * 7) % 1000);
+            plan_add(match, 0, 2, "Phone", "+1408%1", NULL, 0);
+            break;
+        case 2:
+            /* speed dial on a line */
+            snprintf(match, sizeof(match), "#%03d", t % 1000);
+            plan_add(match, 1 + (t / 4) % 2, 0, NULL, "14085550100", NULL, 0);
+            break;
+        default:
+            /* feature code */
+            snprintf(match, sizeof(match), "\\*%02d*", t % 100);
+            plan_add(match, 0, 4, NULL, NULL, NULL, 0);
+            break;
+        }
+        t++;
+    }
+    plan_add("*", 0, 10, NULL, NULL, NULL, 0);
+}
+
+static int
+bench (int keypresses)
+{
+    static const int sizes[] = { 10, 100, 1000 };
+    static const char *number = "914085550123";
+    int numlen = (int) strlen(number);
+    unsigned i;
+
+    pound_dialing = 0;
+    printf("%9s %8s %12s %14s %14s %8s\n", "templates", "states",
+           "compile(us)", "linear(ns/key)", "cursor(ns/key)", "speedup");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        DialPlanCursor cursor;
+        char digits[MAX_DIALSTRING];
+        double start, compile, linear, cursorns;
+        volatile int sink = 0;
+        int k;
+
+        build_site_plan(sizes[i]);
+        start = now_ns();
+        if (!plan_load()) {
+            fprintf(stderr, "site plan of %d did not parse\n", sizes[i]);
+            return 1;
+        }
+        compile = now_ns() - start;
+        if (DialPlanStateCount() == 0) {
+            fprintf(stderr, "site plan of %d did not compile\n", sizes[i]);
+            FreeDialTemplates();
+            return 1;
+        }
+
+        start = now_ns();
+        for (k = 0; k < keypresses; k++) {
+            int n = k % numlen;
+            int timeout = 0;
+
+            memcpy(digits, number, n + 1);
+            digits[n + 1] = '\0';
+            sink += MatchDialTemplateLinear(digits, 1, &timeout, NULL, 0,
+                                            NULL, NULL);
+        }
+        linear = (now_ns() - start) / keypresses;
+
+        ResetDialCursor(&cursor);
+        start = now_ns();
+        for (k = 0; k < keypresses; k++) {
+            int n = k % numlen;
+            int timeout = 0;
+
+            memcpy(digits, number, n + 1);
+            digits[n + 1] = '\0';
+            sink += MatchDialTemplateCursor(&cursor, digits, 1, &timeout,
+                                            NULL, 0, NULL, NULL);
+        }
+        cursorns = (now_ns() - start) / keypresses;
+
+        printf("%9d %8u %12.0f %14.0f %14.0f %7.0fx\n", sizes[i],
+               DialPlanStateCount(), compile / 1000, linear, cursorns,
+               linear / cursorns);
+    }
+    FreeDialTemplates();
+    return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+    unsigned seed = 1;
+    int plans = 2000;
+    int keypresses = 200000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && (i + 1 < argc)) {
+            seed = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            plans = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-k") && (i + 1 < argc)) {
+            keypresses = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-s seed] [-n plans] [-k keypresses]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (check(seed, plans) != 0) {
+        return 1;
+    }
+    if (keypresses > 0) {
+        return bench(keypresses);
+    }
+    return 0;
+}
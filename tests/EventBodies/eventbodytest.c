@@ -0,0 +1,941 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * eventbodytest - check the event body decoders and encoder and time
+ * them on large NOTIFY bodies.
+ *
+ *   eventbodytest [-s seed] [-n iterations] [-b bodies]
+ *
+ * Corpus: dialog-info, PIDF/RPID and KPML documents as phones and
+ * servers send them, and broken ones that have to be refused, are
+ * decoded with ccsip_decode_event_body() and the fields checked.
+ *
+ * Round trip: random event data of every type is encoded with
+ * ccsip_encode_event_body() and decoded again; the result has to be the
+ * data that went in.
+ *
+ * Fuzz: the corpus is mutated (bytes flipped, markup inserted, ranges
+ * dropped or repeated) and truncated at every length. Every body is
+ * decoded from a heap copy of exactly its size so a read past the end
+ * shows under ASan. A body that decodes has to encode to a document
+ * that decodes, and encoding that gives the same document again.
+ *
+ * Time: BLF presence and dialog NOTIFY bodies of a few KB up to tens of
+ * KB are decoded and encoded in a loop. Heap calls are counted through
+ * the replay shim, which is linked the way sipreplay links it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cc_constants.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "ccsip_protocol.h"
+#include "ccsip_eventbodies.h"
+#include "replay_shim.h"
+
+#define BENCH_BODY_SIZE (128 * 1024)
+
+static int failures;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            failures++; \
+            fprintf(stderr, "FAIL %s:%d %s: %s\n", __FILE__, __LINE__, \
+                    (what), #cond); \
+        } \
+    } while (0)
+
+/*
+ * Application callbacks, never called
+ */
+void
+configFetchReq (int device_handle)
+{
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Decodes from a heap copy of exactly 'len' bytes.
+ */
+static boolean
+decode (uint8_t type, const char *body, uint32_t len, ccsip_event_data_t *data)
+{
+    char *copy = malloc(len ? len : 1);
+    boolean ok;
+
+    memcpy(copy, body, len);
+    ok = ccsip_decode_event_body(type, copy, len, data);
+    free(copy);
+    return ok;
+}
+
+static uint8_t
+content_type_value (const char *content_type)
+{
+    if (!strcmp(content_type, SIP_CONTENT_TYPE_DIALOG)) {
+        return SIP_CONTENT_TYPE_DIALOG_VALUE;
+    }
+    if (!strcmp(content_type, SIP_CONTENT_TYPE_PRESENCE)) {
+        return SIP_CONTENT_TYPE_PRESENCE_VALUE;
+    }
+    if (!strcmp(content_type, SIP_CONTENT_TYPE_KPML_REQUEST)) {
+        return SIP_CONTENT_TYPE_KPML_REQUEST_VALUE;
+    }
+    if (!strcmp(content_type, SIP_CONTENT_TYPE_KPML_RESPONSE)) {
+        return SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE;
+    }
+    return SIP_CONTENT_TYPE_UNKNOWN_VALUE;
+}
+
+static boolean
+decode_str (uint8_t type, const char *body, ccsip_event_data_t *data)
+{
+    return decode(type, body, (uint32_t) strlen(body), data);
+}
+
+
+/*
+ * Corpus
+ */
+static const char rfc4235_dialog[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\"\n"
+    "             version=\"1\" state=\"full\"\n"
+    "             entity=\"sip:alice@example.com\">\n"
+    "  <dialog id=\"as7d900as8\" call-id=\"a84b4c76e66710\"\n"
+    "          local-tag=\"1928301774\" direction=\"initiator\">\n"
+    "    <state event=\"rejected\" code=\"486\">terminated</state>\n"
+    "    <duration>274</duration>\n"
+    "    <local>\n"
+    "      <identity display=\"Alice &amp; Co\">sip:alice@example.com</identity>\n"
+    "      <target uri=\"sip:alice@pc33.example.com\">\n"
+    "        <param pname=\"+sip.rendering\" pval=\"yes\"/>\n"
+    "      </target>\n"
+    "      <session-description type=\"application/sdp\">v=0</session-description>\n"
+    "    </local>\n"
+    "    <remote>\n"
+    "      <identity>sip:bob@example.org</identity>\n"
+    "      <cseq>7</cseq>\n"
+    "    </remote>\n"
+    "  </dialog>\n"
+    "  <dialog id=\"x2\" call-id=\"c2\" direction=\"recipient\">\n"
+    "    <state>confirmed</state>\n"
+    "    <replaces call-id=\"old\" local-tag=\"l\" remote-tag=\"r\"/>\n"
+    "    <referred-by display=\"Carol\">sip:carol@example.com</referred-by>\n"
+    "  </dialog>\n"
+    "</dialog-info>\n";
+
+static const char blf_presence[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\"\n"
+    "  xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\"\n"
+    "  xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\"\n"
+    "  xmlns:ce=\"urn:cisco:params:xml:ns:pidf:rpid\"\n"
+    "  entity=\"sip:2001@10.0.0.1\">\n"
+    "  <!-- line 1 -->\n"
+    "  <tuple id=\"t1\">\n"
+    "    <status><basic>open</basic></status>\n"
+    "    <contact priority=\"0.8\">sip:2001@10.0.0.1</contact>\n"
+    "    <note><![CDATA[<on a call>]]></note>\n"
+    "  </tuple>\n"
+    "  <tuple id=\"t2\"><status><basic>closed</basic></status></tuple>\n"
+    "  <dm:person id=\"p1\">\n"
+    "    <rpid:activities>\n"
+    "      <rpid:on-the-phone/>\n"
+    "      <ce:alerting>ringing</ce:alerting>\n"
+    "      <rpid:unknown-activity/>\n"
+    "    </rpid:activities>\n"
+    "  </dm:person>\n"
+    "  <note xml:lang=\"en\">caf&#xE9; &#8364;</note>\n"
+    "</presence>\n";
+
+static const char kpml_request[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<kpml-request xmlns=\"urn:ietf:params:xml:ns:kpml-request\" version=\"1.0\">\n"
+    "  <pattern persist=\"persist\" interdigittimer=\"7000\">\n"
+    "    <flush>yes</flush>\n"
+    "    <regex tag=\"dtmf\">[x*#ABCD]</regex>\n"
+    "  </pattern>\n"
+    "</kpml-request>\n";
+
+static const char kpml_response[] =
+    "<kpml-response xmlns='urn:ietf:params:xml:ns:kpml-response' version='1.0'"
+    " code='200' text='Success' digits='1234' tag='dtmf' forced_flush='false'/>";
+
+typedef struct {
+    uint8_t type;
+    const char *body;
+    const char *what;
+} bad_body_t;
+
+static const bad_body_t bad_bodies[] = {
+    { SIP_CONTENT_TYPE_DIALOG_VALUE, "", "empty" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE, "<dialog-info>", "unterminated" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE, "<dialog-info></dialog>", "mismatched end" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info/><dialog-info/>", "two roots" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info><dialog id='1'/></dialog-info>", "dialog without state" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info><dialog><state>ringing</state></dialog></dialog-info>",
+      "unknown dialog state" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info version='x'/>", "bad version" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<!DOCTYPE d [<!ENTITY a 'aaaa'>]><dialog-info/>", "internal subset" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info entity='a&bogus;b'/>", "unknown entity" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info entity='&#0;'/>", "NUL character reference" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info entity='a<b'/>", "< in attribute" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE,
+      "<dialog-info entity='a'version='1'/>", "attributes not separated" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE, "<presence/>", "wrong document" },
+    { SIP_CONTENT_TYPE_DIALOG_VALUE, "x<dialog-info/>", "text before root" },
+    { SIP_CONTENT_TYPE_PRESENCE_VALUE,
+      "<presence><!-- open", "unterminated comment" },
+    { SIP_CONTENT_TYPE_PRESENCE_VALUE,
+      "<a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a><a>"
+      "<a><a><a><a><a><a><a><a><a><a><a>", "too deep" },
+    { SIP_CONTENT_TYPE_KPML_REQUEST_VALUE,
+      "<kpml-request version='1.0'/>", "no pattern" },
+    { SIP_CONTENT_TYPE_KPML_REQUEST_VALUE,
+      "<kpml-request><pattern persist='forever'><regex>x</regex></pattern>"
+      "</kpml-request>", "unknown persist" },
+    { SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE,
+      "<kpml-response suppressed='maybe'/>", "bad suppressed" },
+    { SIP_CONTENT_TYPE_CMXML_VALUE, "<x/>", "no decoder" }
+};
+
+static void
+check_corpus (void)
+{
+    ccsip_event_data_t *data = malloc(sizeof(ccsip_event_data_t));
+    const DialogInfoStruct *info = &data->u.dialog_info;
+    const Presence_ext_t *pres = &data->u.presence_rpid;
+    const KPMLRequest *req = &data->u.kpml_request;
+    const KPMLResponse *resp = &data->u.kpml_response;
+    char entity[600];
+    size_t i;
+
+    CHECK(decode_str(SIP_CONTENT_TYPE_DIALOG_VALUE, rfc4235_dialog, data),
+          "dialog-info");
+    CHECK(data->type == EVENT_DATA_DIALOG, "dialog-info");
+    CHECK(info->version == 1 && info->state == XML_STATE_FULL, "dialog-info");
+    CHECK(!strcmp(info->entity, "sip:alice@example.com"), "dialog-info");
+    CHECK(info->num_dialogs == 2 && info->total_dialogs == 2, "dialog-info");
+    CHECK(!strcmp(info->dialog[0].id, "as7d900as8"), "dialog");
+    CHECK(!strcmp(info->dialog[0].call_id, "a84b4c76e66710"), "dialog");
+    CHECK(!strcmp(info->dialog[0].local_tag, "1928301774"), "dialog");
+    CHECK(info->dialog[0].remote_tag[0] == '\0', "dialog");
+    CHECK(info->dialog[0].direction == XML_DIRECTION_INITIATOR, "dialog");
+    CHECK(info->dialog[0].state.event == XML_EVENT_REJECTED, "dialog");
+    CHECK(info->dialog[0].state.code == 486, "dialog");
+    CHECK(info->dialog[0].state.state == XML_DIALOG_STATE_TERMINATED, "dialog");
+    CHECK(info->dialog[0].duration == 274, "dialog");
+    CHECK(!strcmp(info->dialog[0].local.identity.display_name, "Alice & Co"),
+          "local");
+    CHECK(!strcmp(info->dialog[0].local.identity.uri, "sip:alice@example.com"),
+          "local");
+    CHECK(!strcmp(info->dialog[0].local.target.uri,
+                  "sip:alice@pc33.example.com"), "local");
+    CHECK(!strcmp(info->dialog[0].local.target.param[0].pname,
+                  "+sip.rendering"), "local");
+    CHECK(!strcmp(info->dialog[0].local.target.param[0].pval, "yes"), "local");
+    CHECK(!strcmp(info->dialog[0].local.session_description.type,
+                  "application/sdp"), "local");
+    CHECK(!strcmp(info->dialog[0].remote.identity.uri, "sip:bob@example.org"),
+          "remote");
+    CHECK(info->dialog[0].remote.cseq == 7, "remote");
+    CHECK(info->dialog[1].direction == XML_DIRECTION_RECIPIENT, "dialog 2");
+    CHECK(info->dialog[1].state.event == -1, "dialog 2");
+    CHECK(info->dialog[1].state.state == XML_DIALOG_STATE_CONFIRMED, "dialog 2");
+    CHECK(!strcmp(info->dialog[1].replaces.call_id, "old"), "dialog 2");
+    CHECK(!strcmp(info->dialog[1].replaces.remote_tag, "r"), "dialog 2");
+    CHECK(!strcmp(info->dialog[1].referred_by.display_name, "Carol"),
+          "dialog 2");
+    CHECK(!strcmp(info->dialog[1].referred_by.uri, "sip:carol@example.com"),
+          "dialog 2");
+
+    CHECK(decode_str(SIP_CONTENT_TYPE_PRESENCE_VALUE, blf_presence, data),
+          "presence");
+    CHECK(data->type == EVENT_DATA_PRESENCE, "presence");
+    CHECK(!strcmp(pres->presence_body.entity, "sip:2001@10.0.0.1"), "presence");
+    CHECK(!strcmp(pres->presence_body.tuple[0].id, "t1"), "tuple");
+    CHECK(!strcmp(pres->presence_body.tuple[0].status.basic, "open"), "tuple");
+    CHECK(!strcmp(pres->presence_body.tuple[0].contact[0],
+                  "sip:2001@10.0.0.1"), "tuple");
+    CHECK(!strcmp(pres->presence_body.tuple[0].note[0], "<on a call>"), "tuple");
+    CHECK(!strcmp(pres->presence_body.person.id, "p1"), "person");
+    CHECK(pres->onThePhone && pres->alerting, "activities");
+    CHECK(!pres->busy && !pres->away && !pres->meeting, "activities");
+    CHECK(!strcmp(pres->presence_body.person.activities.alerting, "ringing"),
+          "activities");
+    CHECK(!strcmp(pres->presence_body.note[0], "caf\xC3\xA9 \xE2\x82\xAC"),
+          "note");
+
+    CHECK(decode_str(SIP_CONTENT_TYPE_KPML_REQUEST_VALUE, kpml_request, data),
+          "kpml-request");
+    CHECK(data->type == EVENT_DATA_KPML_REQUEST, "kpml-request");
+    CHECK(!strcmp(req->version, "1.0"), "kpml-request");
+    CHECK(req->pattern.persist == XML_PERSIST_TYPE_PERSIST, "kpml-request");
+    CHECK(req->pattern.interdigittimer == 7000, "kpml-request");
+    CHECK(req->pattern.criticaldigittimer == 1000, "kpml-request defaults");
+    CHECK(req->pattern.extradigittimer == 500, "kpml-request defaults");
+    CHECK(req->pattern.flush == XML_YES, "kpml-request");
+    CHECK(!strcmp(req->pattern.regex.regexData, "[x*#ABCD]"), "kpml-request");
+    CHECK(!strcmp(req->pattern.regex.tag, "dtmf"), "kpml-request");
+
+    CHECK(decode_str(SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE, kpml_response, data),
+          "kpml-response");
+    CHECK(data->type == EVENT_DATA_KPML_RESPONSE, "kpml-response");
+    CHECK(!strcmp(resp->code, "200") && !strcmp(resp->text, "Success"),
+          "kpml-response");
+    CHECK(!strcmp(resp->digits, "1234") && !strcmp(resp->tag, "dtmf"),
+          "kpml-response");
+    CHECK(!strcmp(resp->forced_flush, "false"), "kpml-response");
+
+    /* values longer than their field are cut, not refused */
+    memset(entity, 'e', sizeof(entity));
+    memcpy(entity, "<dialog-info entity='", 21);
+    strcpy(entity + 500, "&amp;'/>");
+    CHECK(decode_str(SIP_CONTENT_TYPE_DIALOG_VALUE, entity, data), "long value");
+    CHECK(strlen(info->entity) == sizeof(info->entity) - 1, "long value");
+
+    for (i = 0; i < sizeof(bad_bodies) / sizeof(bad_bodies[0]); i++) {
+        CHECK(!decode_str(bad_bodies[i].type, bad_bodies[i].body, data),
+              bad_bodies[i].what);
+    }
+    free(data);
+}
+
+
+/*
+ * Round trip
+ */
+static void
+random_string (char *dst, size_t size)
+{
+    static const char *pieces[] = {
+        "a", "b", "Z", "0", "7", "@", ":", ";", "=", ".", "/", "-", "_",
+        "<", ">", "&", "\"", "'", "\t", "\n", " ", "\xC3\xA9", "]]>", "&amp;"
+    };
+    size_t npieces = sizeof(pieces) / sizeof(pieces[0]);
+    size_t target = (size_t) rand() % size;
+    size_t len = 0;
+    size_t n;
+    const char *piece;
+
+    if (rand() % 4 == 0) {
+        target = 0;
+    }
+    while (len < target) {
+        piece = pieces[rand() % npieces];
+        n = strlen(piece);
+        if (len + n > size - 1) {
+            break;
+        }
+        memcpy(dst + len, piece, n);
+        len += n;
+    }
+    dst[len] = '\0';
+    /* values are handed back trimmed */
+    while (len && strchr(" \t\n", dst[len - 1])) {
+        dst[--len] = '\0';
+    }
+    n = strspn(dst, " \t\n");
+    memmove(dst, dst + n, len - n + 1);
+    memset(dst + len - n, 0, n);
+}
+
+#define RANDOM_STRING(dst) random_string((dst), sizeof(dst))
+
+static void
+random_participant (Participant *part)
+{
+    int i;
+
+    RANDOM_STRING(part->identity.uri);
+    if (part->identity.uri[0]) {
+        RANDOM_STRING(part->identity.display_name);
+    }
+    RANDOM_STRING(part->target.uri);
+    for (i = 0; part->target.uri[0] && i < rand() % 5; i++) {
+        RANDOM_STRING(part->target.param[i].pname);
+        if (part->target.param[i].pname[0] == '\0') {
+            break;
+        }
+        RANDOM_STRING(part->target.param[i].pval);
+    }
+    RANDOM_STRING(part->session_description.type);
+    part->cseq = (xml_unsigned16) (rand() % 3 ? 0 : rand() % 65536);
+}
+
+static void
+random_dialog_info (DialogInfoStruct *info)
+{
+    DialogStruct *dialog;
+    int i;
+
+    info->version = (xml_unsigned32) rand();
+    info->state = rand() % 3 - 1;
+    RANDOM_STRING(info->entity);
+    info->num_dialogs = info->total_dialogs =
+        (xml_unsigned16) (rand() % (XML_MAX_DIALOGS + 1));
+    for (i = 0; i < info->num_dialogs; i++) {
+        dialog = &info->dialog[i];
+        RANDOM_STRING(dialog->id);
+        RANDOM_STRING(dialog->call_id);
+        RANDOM_STRING(dialog->local_tag);
+        RANDOM_STRING(dialog->remote_tag);
+        dialog->direction = rand() % 3 - 1;
+        dialog->state.event = rand() % 8 - 1;
+        dialog->state.code = rand() % 2 ? 0 : 100 + rand() % 600;
+        dialog->state.state = rand() % 5;
+        dialog->duration = (xml_unsigned32) (rand() % 2 ? 0 : rand());
+        RANDOM_STRING(dialog->replaces.call_id);
+        if (dialog->replaces.call_id[0]) {
+            RANDOM_STRING(dialog->replaces.local_tag);
+            RANDOM_STRING(dialog->replaces.remote_tag);
+        }
+        RANDOM_STRING(dialog->referred_by.uri);
+        if (dialog->referred_by.uri[0]) {
+            RANDOM_STRING(dialog->referred_by.display_name);
+        }
+        random_participant(&dialog->local);
+        random_participant(&dialog->remote);
+    }
+}
+
+static void
+random_presence (Presence_ext_t *ext)
+{
+    PresenceRPIDStruct *pres = &ext->presence_body;
+    ActivitiesStruct *act = &pres->person.activities;
+    int i;
+
+    RANDOM_STRING(pres->entity);
+    RANDOM_STRING(pres->tuple[0].id);
+    RANDOM_STRING(pres->tuple[0].status.basic);
+    if (pres->tuple[0].id[0] || pres->tuple[0].status.basic[0]) {
+        RANDOM_STRING(pres->tuple[0].contact[0]);
+        RANDOM_STRING(pres->tuple[0].note[0]);
+    }
+    RANDOM_STRING(pres->person.id);
+    RANDOM_STRING(pres->person.personStatus.basic);
+    ext->onThePhone = (boolean) (rand() % 2);
+    ext->busy = (boolean) (rand() % 2);
+    ext->away = (boolean) (rand() % 2);
+    ext->meeting = (boolean) (rand() % 2);
+    ext->alerting = (boolean) (rand() % 2);
+    if (ext->onThePhone) {
+        RANDOM_STRING(act->onThePhone);
+    }
+    if (ext->busy) {
+        RANDOM_STRING(act->busy);
+    }
+    if (ext->away) {
+        RANDOM_STRING(act->away);
+    }
+    if (ext->meeting) {
+        RANDOM_STRING(act->meeting);
+    }
+    if (ext->alerting) {
+        RANDOM_STRING(act->alerting);
+    }
+    for (i = 0; i < rand() % 6; i++) {
+        RANDOM_STRING(pres->note[i]);
+        if (pres->note[i][0] == '\0') {
+            break;
+        }
+    }
+}
+
+static void
+random_kpml_request (KPMLRequest *req)
+{
+    Pattern *pattern = &req->pattern;
+
+    RANDOM_STRING(req->version);
+    RANDOM_STRING(req->stream.reverse);
+    pattern->persist = rand() % 3;
+    pattern->interdigittimer = (xml_unsigned32) rand();
+    pattern->criticaldigittimer = (xml_unsigned32) rand();
+    pattern->extradigittimer = (xml_unsigned32) rand();
+    pattern->longhold = (xml_unsigned16) (rand() % 2 ? 0 : rand() % 65536);
+    pattern->longrepeat = (xml_unsigned8) (rand() % 2);
+    pattern->nopartial = (xml_unsigned8) (rand() % 2);
+    pattern->flush = rand() % 2 ? XML_YES : XML_NO;
+    RANDOM_STRING(pattern->enterkey);
+    RANDOM_STRING(pattern->regex.regexData);
+    RANDOM_STRING(pattern->regex.tag);
+    RANDOM_STRING(pattern->regex.pre);
+}
+
+static void
+random_kpml_response (KPMLResponse *resp)
+{
+    RANDOM_STRING(resp->version);
+    RANDOM_STRING(resp->code);
+    RANDOM_STRING(resp->text);
+    resp->suppressed = (xml_unsigned8) (rand() % 2);
+    RANDOM_STRING(resp->forced_flush);
+    RANDOM_STRING(resp->digits);
+    RANDOM_STRING(resp->tag);
+}
+
+static void
+check_round_trip (int iterations)
+{
+    ccsip_event_data_t *in = malloc(sizeof(ccsip_event_data_t));
+    ccsip_event_data_t *out = malloc(sizeof(ccsip_event_data_t));
+    const char *content_type;
+    uint32_t len;
+    char *body;
+    int i;
+
+    for (i = 0; i < iterations; i++) {
+        memset(in, 0, sizeof(*in));
+        switch (i % 4) {
+        case 0:
+            in->type = EVENT_DATA_DIALOG;
+            random_dialog_info(&in->u.dialog_info);
+            break;
+        case 1:
+            in->type = EVENT_DATA_PRESENCE;
+            random_presence(&in->u.presence_rpid);
+            break;
+        case 2:
+            in->type = EVENT_DATA_KPML_REQUEST;
+            random_kpml_request(&in->u.kpml_request);
+            break;
+        default:
+            in->type = EVENT_DATA_KPML_RESPONSE;
+            random_kpml_response(&in->u.kpml_response);
+            break;
+        }
+        body = ccsip_encode_event_body(in, &len, &content_type);
+        CHECK(body != NULL && strlen(body) == len, "encode");
+        if (body == NULL) {
+            continue;
+        }
+        if (!decode(content_type_value(content_type), body, len, out) ||
+            out->type != in->type ||
+            memcmp(&in->u, &out->u, sizeof(in->u)) != 0) {
+            failures++;
+            fprintf(stderr, "FAIL round trip of type %d:\n%s\n", in->type,
+                    body);
+        }
+        cpr_free(body);
+    }
+
+    /* raw bodies are copied through */
+    memset(in, 0, sizeof(*in));
+    in->type = EVENT_DATA_RAW;
+    in->u.raw_data.data = "<x/>";
+    in->u.raw_data.length = 4;
+    body = ccsip_encode_event_body(in, &len, &content_type);
+    CHECK(body && len == 4 && !memcmp(body, "<x/>", 4) &&
+          !strcmp(content_type, SIP_CONTENT_TYPE_CMXML), "raw");
+    cpr_free(body);
+    in->type = EVENT_DATA_REMOTECC_REQUEST;
+    CHECK(ccsip_encode_event_body(in, &len, &content_type) == NULL,
+          "no encoder");
+    free(in);
+    free(out);
+}
+
+
+/*
+ * Fuzz
+ */
+static void
+fuzz_one (uint8_t type, const char *body, uint32_t len,
+          ccsip_event_data_t *data, ccsip_event_data_t *again)
+{
+    const char *content_type;
+    char *first;
+    char *second;
+    uint32_t first_len;
+    uint32_t second_len;
+
+    if (!decode(type, body, len, data)) {
+        return;
+    }
+    first = ccsip_encode_event_body(data, &first_len, &content_type);
+    CHECK(first != NULL, "encode decoded");
+    if (first == NULL) {
+        return;
+    }
+    CHECK(decode(type, first, first_len, again), "decode encoded");
+    second = ccsip_encode_event_body(again, &second_len, &content_type);
+    if (second == NULL || first_len != second_len ||
+        memcmp(first, second, first_len) != 0) {
+        failures++;
+        fprintf(stderr, "FAIL re-encoding differs:\n%s\n%s\n", first,
+                second ? second : "(null)");
+    }
+    cpr_free(first);
+    cpr_free(second);
+}
+
+static void
+check_fuzz (int iterations)
+{
+    static const char *inserts[] = {
+        "<", ">", "&", "/", "\"", "'", "=", "]]>", "<!--", "-->", "<![CDATA[",
+        "</", "/>", "&#", "&#x110000;", "&lt;", "\0", "<x>", "</x>", "<?", "?>",
+        "<!DOCTYPE x>", "\xEF\xBB\xBF"
+    };
+    static const struct {
+        uint8_t type;
+        const char *body;
+    } seeds[] = {
+        { SIP_CONTENT_TYPE_DIALOG_VALUE, rfc4235_dialog },
+        { SIP_CONTENT_TYPE_PRESENCE_VALUE, blf_presence },
+        { SIP_CONTENT_TYPE_KPML_REQUEST_VALUE, kpml_request },
+        { SIP_CONTENT_TYPE_KPML_RESPONSE_VALUE, kpml_response }
+    };
+    size_t nseeds = sizeof(seeds) / sizeof(seeds[0]);
+    size_t ninserts = sizeof(inserts) / sizeof(inserts[0]);
+    ccsip_event_data_t *data = malloc(sizeof(ccsip_event_data_t));
+    ccsip_event_data_t *again = malloc(sizeof(ccsip_event_data_t));
+    char buf[4096];
+    uint32_t len;
+    uint32_t pos;
+    uint32_t n;
+    uint32_t cut;
+    size_t s;
+    int i;
+    int m;
+
+    for (s = 0; s < nseeds; s++) {
+        len = (uint32_t) strlen(seeds[s].body);
+        for (cut = 0; cut <= len; cut++) {
+            fuzz_one(seeds[s].type, seeds[s].body, cut, data, again);
+        }
+    }
+
+    for (i = 0; i < iterations; i++) {
+        s = (size_t) i % nseeds;
+        len = (uint32_t) strlen(seeds[s].body);
+        memcpy(buf, seeds[s].body, len);
+        for (m = 0; m < 1 + rand() % 4; m++) {
+            pos = len ? (uint32_t) rand() % len : 0;
+            switch (rand() % 4) {
+            case 0:
+                if (len) {
+                    buf[pos] = (char) rand();
+                }
+                break;
+            case 1:
+                n = (uint32_t) (rand() % 16);
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                memmove(buf + pos, buf + pos + n, len - pos - n);
+                len -= n;
+                break;
+            case 2: {
+                const char *ins = inserts[rand() % ninserts];
+                n = *ins ? (uint32_t) strlen(ins) : 1;
+                if (len + n < sizeof(buf)) {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    memcpy(buf + pos, ins, n);
+                    len += n;
+                }
+                break;
+            }
+            default:
+                n = (uint32_t) (rand() % 64);
+                if (n > len - pos) {
+                    n = len - pos;
+                }
+                if (len + n < sizeof(buf)) {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    memcpy(buf + pos + n, buf + pos, n);
+                    len += n;
+                }
+                break;
+            }
+        }
+        fuzz_one(seeds[s].type, buf, len, data, again);
+    }
+    free(data);
+    free(again);
+}
+
+
+/*
+ * Time
+ */
+
+/* A BLF NOTIFY: the presentity's lines as tuples, RPID person and notes */
+static uint32_t
+build_blf_body (char *buf, size_t size, int tuples)
+{
+    size_t len;
+    int i;
+
+    len = (size_t) snprintf(buf, size,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" "
+        "xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\" "
+        "xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\" "
+        "xmlns:ce=\"urn:cisco:params:xml:ns:pidf:rpid\" "
+        "entity=\"sip:2001@cucm.example.com\">\n");
+    for (i = 0; i < tuples && len < size; i++) {
+        len += (size_t) snprintf(buf + len, size - len,
+            "  <tuple id=\"line%d\">\n"
+            "    <status><basic>%s</basic></status>\n"
+            "    <contact priority=\"0.%d\">sip:%d@10.1.%d.%d:5060;transport=tcp</contact>\n"
+            "    <note xml:lang=\"en\">Line %d &amp; shared line appearance</note>\n"
+            "  </tuple>\n",
+            i, i % 3 ? "open" : "closed", i % 10, 2001 + i, i / 250, i % 250,
+            i);
+    }
+    if (len < size) {
+        len += (size_t) snprintf(buf + len, size - len,
+            "  <dm:person id=\"p1\">\n"
+            "    <rpid:activities><rpid:on-the-phone/><ce:alerting/>"
+            "</rpid:activities>\n"
+            "  </dm:person>\n"
+            "  <note>Busy on line 1</note>\n"
+            "</presence>\n");
+    }
+    return (uint32_t) (len < size ? len : size - 1);
+}
+
+/* A dialog NOTIFY for a shared line with many calls */
+static uint32_t
+build_dialog_body (char *buf, size_t size, int dialogs)
+{
+    size_t len;
+    int i;
+
+    len = (size_t) snprintf(buf, size,
+        "<?xml version=\"1.0\"?>\n"
+        "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\" "
+        "version=\"42\" state=\"full\" entity=\"sip:2001@cucm.example.com\">\n");
+    for (i = 0; i < dialogs && len < size; i++) {
+        len += (size_t) snprintf(buf + len, size - len,
+            "  <dialog id=\"d%d\" call-id=\"%08x-%04x@10.1.1.%d\" "
+            "local-tag=\"%x\" remote-tag=\"%x\" direction=\"%s\">\n"
+            "    <state event=\"remote-bye\" code=\"200\">%s</state>\n"
+            "    <duration>%d</duration>\n"
+            "    <local>\n"
+            "      <identity display=\"Line %d\">sip:2001@cucm.example.com</identity>\n"
+            "      <target uri=\"sip:2001@10.1.1.%d:5060\">"
+            "<param pname=\"+sip.rendering\" pval=\"yes\"/></target>\n"
+            "      <session-description type=\"application/sdp\"/>\n"
+            "    </local>\n"
+            "    <remote>\n"
+            "      <identity display=\"Caller %d\">sip:%d@example.com</identity>\n"
+            "      <target uri=\"sip:%d@10.2.0.%d\"/>\n"
+            "    </remote>\n"
+            "  </dialog>\n",
+            i, 0x1000 * i, i, i % 250, 0x5000 + i, 0x9000 + i,
+            i % 2 ? "initiator" : "recipient",
+            i % 3 ? "confirmed" : "early", 10 * i, i, i % 250, i, 3000 + i,
+            3000 + i, i % 250);
+    }
+    if (len < size) {
+        len += (size_t) snprintf(buf + len, size - len, "</dialog-info>\n");
+    }
+    return (uint32_t) (len < size ? len : size - 1);
+}
+
+static void
+bench_one (const char *what, uint8_t type, const char *body, uint32_t len,
+           int bodies)
+{
+    ccsip_event_data_t *data = malloc(sizeof(ccsip_event_data_t));
+    const char *content_type;
+    uint32_t allocs;
+    uint32_t enc_allocs;
+    uint32_t out_len;
+    double start;
+    double decode_ns;
+    double encode_ns;
+    char *out;
+    int i;
+
+    if (!ccsip_decode_event_body(type, body, len, data)) {
+        failures++;
+        fprintf(stderr, "FAIL %s does not decode\n", what);
+        free(data);
+        return;
+    }
+
+    allocs = replay_alloc_count();
+    start = now_ns();
+    for (i = 0; i < bodies; i++) {
+        (void) ccsip_decode_event_body(type, body, len, data);
+    }
+    decode_ns = (now_ns() - start) / bodies;
+    allocs = replay_alloc_count() - allocs;
+
+    enc_allocs = replay_alloc_count();
+    start = now_ns();
+    for (i = 0; i < bodies; i++) {
+        out = ccsip_encode_event_body(data, &out_len, &content_type);
+        cpr_free(out);
+    }
+    encode_ns = (now_ns() - start) / bodies;
+    enc_allocs = replay_alloc_count() - enc_allocs;
+
+    if (replay_alloc_supported()) {
+        printf("%-16s %8u %10.2f %10.0f %12.2f %10.2f %12.2f\n", what, len,
+               decode_ns / 1000, len / decode_ns * 1e3,
+               (double) allocs / bodies, encode_ns / 1000,
+               (double) enc_allocs / bodies);
+    } else {
+        printf("%-16s %8u %10.2f %10.0f %12s %10.2f %12s\n", what, len,
+               decode_ns / 1000, len / decode_ns * 1e3, "-",
+               encode_ns / 1000, "-");
+    }
+    free(data);
+}
+
+static void
+bench (int bodies)
+{
+    static const int sizes[] = { 4, 32, 128 };
+    char *buf = malloc(BENCH_BODY_SIZE);
+    char what[32];
+    uint32_t len;
+    unsigned i;
+
+    printf("%-16s %8s %10s %10s %12s %10s %12s\n", "body", "bytes",
+           "decode(us)", "MB/s", "allocs/body", "encode(us)", "allocs/body");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        len = build_blf_body(buf, BENCH_BODY_SIZE, sizes[i]);
+        snprintf(what, sizeof(what), "blf %d tuples", sizes[i]);
+        bench_one(what, SIP_CONTENT_TYPE_PRESENCE_VALUE, buf, len, bodies);
+    }
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        len = build_dialog_body(buf, BENCH_BODY_SIZE, sizes[i]);
+        snprintf(what, sizeof(what), "dialog %d calls", sizes[i]);
+        bench_one(what, SIP_CONTENT_TYPE_DIALOG_VALUE, buf, len, bodies);
+    }
+    len = (uint32_t) strlen(kpml_request);
+    bench_one("kpml-request", SIP_CONTENT_TYPE_KPML_REQUEST_VALUE,
+              kpml_request, len, bodies);
+    free(buf);
+}
+
+int
+main (int argc, char **argv)
+{
+    unsigned seed = 1;
+    int iterations = 200000;
+    int bodies = 20000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && (i + 1 < argc)) {
+            seed = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            iterations = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) {
+            bodies = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-s seed] [-n iterations] [-b bodies]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    srand(seed);
+    check_corpus();
+    check_round_trip(iterations / 10);
+    check_fuzz(iterations);
+    printf("checks done, %d failures\n", failures);
+    if (failures) {
+        return 1;
+    }
+    if (bodies > 0) {
+        bench(bodies);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/* generated by msgbuildtest -g, see msgbuildtest.c */
+
+static const char golden_invite[] =
+    "INVITE sip:1002@10.1.1.1;user=phone SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 101 INVITE\r\n"
+    "User-Agent: Cisco-CP7960G/8.0\r\n"
+    "Contact: <sip:1001@10.1.1.20:5060;transport=udp>;+u.sip!devicename.ccm.cisco.com=\"SEP00127F548F2A\"\r\n"
+    "Expires: 180\r\n"
+    "Allow: ACK,BYE,CANCEL,INVITE,NOTIFY,OPTIONS,REFER,REGISTER,UPDATE,SUBSCRIBE,INFO\r\n"
+    "Supported: replaces,join,sdp-anat,norefersub,extended-refer,X-cisco-callinfo\r\n"
+    "Allow-Events: kpml,dialog\r\n"
+    "Remote-Party-ID: \"Alice\" <sip:1001@10.1.1.1>;party=calling;id-type=subscriber;privacy=off;screen=yes\r\n"
+    "Content-Length: 269\r\n"
+    "Content-Type: application/sdp\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "v=0\r\n"
+    "o=Cisco-SIPUA 7125 0 IN IP4 10.1.1.20\r\n"
+    "s=SIP Call\r\n"
+    "t=0 0\r\n"
+    "m=audio 16384 RTP/AVP 0 8 18 101\r\n"
+    "c=IN IP4 10.1.1.20\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:18 G729/8000\r\n"
+    "a=fmtp:18 annexb=no\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=sendrecv\r\n";
+
+static const char golden_ok[] =
+    "SIP/2.0 200 OK\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 101 INVITE\r\n"
+    "Record-Route: <sip:10.1.1.1:5060;transport=udp;lr>\r\n"
+    "User-Agent: Cisco-CP7960G/8.0\r\n"
+    "Contact: <sip:1001@10.1.1.20:5060;transport=udp>;+u.sip!devicename.ccm.cisco.com=\"SEP00127F548F2A\"\r\n"
+    "Expires: 180\r\n"
+    "Allow: ACK,BYE,CANCEL,INVITE,NOTIFY,OPTIONS,REFER,REGISTER,UPDATE,SUBSCRIBE,INFO\r\n"
+    "Supported: replaces,join,sdp-anat,norefersub,extended-refer,X-cisco-callinfo\r\n"
+    "Allow-Events: kpml,dialog\r\n"
+    "Content-Length: 198\r\n"
+    "Content-Type: application/sdp\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "v=0\r\n"
+    "o=Cisco-SIPUA 3302 0 IN IP4 10.1.1.30\r\n"
+    "s=SIP Call\r\n"
+    "t=0 0\r\n"
+    "m=audio 24580 RTP/AVP 0 101\r\n"
+    "c=IN IP4 10.1.1.30\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=sendrecv\r\n";
+
+static const char golden_ack[] =
+    "ACK sip:1002@10.1.1.30:5060;transport=udp SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 101 ACK\r\n"
+    "Route: <sip:10.1.1.1:5060;transport=udp;lr>\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+static const char golden_notify[] =
+    "NOTIFY sip:1001@10.1.1.20:5060 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 1002 NOTIFY\r\n"
+    "Event: dialog\r\n"
+    "Subscription-State: active;expires=3600\r\n"
+    "Contact: <sip:1002@10.1.1.30:5060>\r\n"
+    "Content-Length: 281\r\n"
+    "Content-Type: application/dialog-info+xml\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\" version=\"3\" state=\"full\" entity=\"sip:1001@10.1.1.1\">\n"
+    "<dialog id=\"5ac91a4b\" call-id=\"00127f54-8f2a0004@10.1.1.20\" direction=\"initiator\">\n"
+    "<state>confirmed</state>\n"
+    "</dialog>\n"
+    "</dialog-info>\n";
+
+static const char golden_notify2[] =
+    "NOTIFY sip:1001@10.1.1.20:5060 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 1002 NOTIFY\r\n"
+    "Event: dialog\r\n"
+    "Subscription-State: active;expires=3600\r\n"
+    "Contact: <sip:1002@10.1.1.30:5060>\r\n"
+    "Content-Type: multipart/mixed; boundary=uniqueBoundary\r\n"
+    "Mime-Version: 1.0\r\n"
+    "Content-Length: 561\r\n"
+    "\r\n"
+    "--uniqueBoundary\r\n"
+    "Content-Type: application/dialog-info+xml\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\" version=\"3\" state=\"full\" entity=\"sip:1001@10.1.1.1\">\n"
+    "<dialog id=\"5ac91a4b\" call-id=\"00127f54-8f2a0004@10.1.1.20\" direction=\"initiator\">\n"
+    "<state>confirmed</state>\n"
+    "</dialog>\n"
+    "</dialog-info>\n"
+    "\r\n"
+    "--uniqueBoundary\r\n"
+    "Content-Type: message/sipfrag\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "Content-Id: <frag@10.1.1.30>\r\n"
+    "\r\n"
+    "SIP/2.0 200 OK\r\n"
+    "\r\n"
+    "--uniqueBoundary--\r\n";
+
+static const char golden_notify3[] =
+    "NOTIFY sip:1001@10.1.1.20:5060 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 1002 NOTIFY\r\n"
+    "Event: dialog\r\n"
+    "Subscription-State: active;expires=3600\r\n"
+    "Contact: <sip:1002@10.1.1.30:5060>\r\n"
+    "Content-Type: multipart/mixed; boundary=uniqueBoundary\r\n"
+    "Mime-Version: 1.0\r\n"
+    "Content-Length: 685\r\n"
+    "\r\n"
+    "--uniqueBoundary\r\n"
+    "Content-Type: application/dialog-info+xml\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\" version=\"3\" state=\"full\" entity=\"sip:1001@10.1.1.1\">\n"
+    "<dialog id=\"5ac91a4b\" call-id=\"00127f54-8f2a0004@10.1.1.20\" direction=\"initiator\">\n"
+    "<state>confirmed</state>\n"
+    "</dialog>\n"
+    "</dialog-info>\n"
+    "\r\n"
+    "--uniqueBoundary\r\n"
+    "Content-Type: message/sipfrag\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "Content-Id: <frag@10.1.1.30>\r\n"
+    "\r\n"
+    "SIP/2.0 200 OK\r\n"
+    "\r\n"
+    "--uniqueBoundary\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Disposition: render;handling=optional\r\n"
+    "\r\n"
+    "Call forwarded to voicemail\r\n"
+    "\r\n"
+    "--uniqueBoundary--\r\n";
+
+static const char golden_long_invite[] =
+    "INVITE sip:1002@10.1.1.1;user=phone SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+    "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+    "To: <sip:1002@10.1.1.1>\r\n"
+    "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+    "Max-Forwards: 70\r\n"
+    "CSeq: 101 INVITE\r\n"
+    "User-Agent: Cisco-CP7960G/8.0\r\n"
+    "Contact: <sip:1001@10.1.1.20:5060;transport=udp>;+u.sip!devicename.ccm.cisco.com=\"SEP00127F548F2A\"\r\n"
+    "Expires: 180\r\n"
+    "Allow: ACK,BYE,CANCEL,INVITE,NOTIFY,OPTIONS,REFER,REGISTER,UPDATE,SUBSCRIBE,INFO\r\n"
+    "Supported: replaces,join,sdp-anat,norefersub,extended-refer,X-cisco-callinfo\r\n"
+    "Allow-Events: kpml,dialog\r\n"
+    "Remote-Party-ID: \"Alice\" <sip:1001@10.1.1.1>;party=calling;id-type=subscriber;privacy=off;screen=yes\r\n"
+    "Record-Route: <sip:proxy0.example.com:5060;lr>\r\n"
+    "X-Hop: -20000000\r\n"
+    "Record-Route: <sip:proxy1.example.com:5060;lr>\r\n"
+    "X-Hop: -18999997\r\n"
+    "Record-Route: <sip:proxy2.example.com:5060;lr>\r\n"
+    "X-Hop: -17999994\r\n"
+    "Record-Route: <sip:proxy3.example.com:5060;lr>\r\n"
+    "X-Hop: -16999991\r\n"
+    "Record-Route: <sip:proxy4.example.com:5060;lr>\r\n"
+    "X-Hop: -15999988\r\n"
+    "Record-Route: <sip:proxy5.example.com:5060;lr>\r\n"
+    "X-Hop: -14999985\r\n"
+    "Record-Route: <sip:proxy6.example.com:5060;lr>\r\n"
+    "X-Hop: -13999982\r\n"
+    "Record-Route: <sip:proxy7.example.com:5060;lr>\r\n"
+    "X-Hop: -12999979\r\n"
+    "Record-Route: <sip:proxy8.example.com:5060;lr>\r\n"
+    "X-Hop: -11999976\r\n"
+    "Record-Route: <sip:proxy9.example.com:5060;lr>\r\n"
+    "X-Hop: -10999973\r\n"
+    "Record-Route: <sip:proxy10.example.com:5060;lr>\r\n"
+    "X-Hop: -9999970\r\n"
+    "Record-Route: <sip:proxy11.example.com:5060;lr>\r\n"
+    "X-Hop: -8999967\r\n"
+    "Record-Route: <sip:proxy12.example.com:5060;lr>\r\n"
+    "X-Hop: -7999964\r\n"
+    "Record-Route: <sip:proxy13.example.com:5060;lr>\r\n"
+    "X-Hop: -6999961\r\n"
+    "Record-Route: <sip:proxy14.example.com:5060;lr>\r\n"
+    "X-Hop: -5999958\r\n"
+    "Record-Route: <sip:proxy15.example.com:5060;lr>\r\n"
+    "X-Hop: -4999955\r\n"
+    "Record-Route: <sip:proxy16.example.com:5060;lr>\r\n"
+    "X-Hop: -3999952\r\n"
+    "Record-Route: <sip:proxy17.example.com:5060;lr>\r\n"
+    "X-Hop: -2999949\r\n"
+    "Record-Route: <sip:proxy18.example.com:5060;lr>\r\n"
+    "X-Hop: -1999946\r\n"
+    "Record-Route: <sip:proxy19.example.com:5060;lr>\r\n"
+    "X-Hop: -999943\r\n"
+    "Record-Route: <sip:proxy20.example.com:5060;lr>\r\n"
+    "X-Hop: 60\r\n"
+    "Record-Route: <sip:proxy21.example.com:5060;lr>\r\n"
+    "X-Hop: 1000063\r\n"
+    "Record-Route: <sip:proxy22.example.com:5060;lr>\r\n"
+    "X-Hop: 2000066\r\n"
+    "Record-Route: <sip:proxy23.example.com:5060;lr>\r\n"
+    "X-Hop: 3000069\r\n"
+    "Record-Route: <sip:proxy24.example.com:5060;lr>\r\n"
+    "X-Hop: 4000072\r\n"
+    "Record-Route: <sip:proxy25.example.com:5060;lr>\r\n"
+    "X-Hop: 5000075\r\n"
+    "Record-Route: <sip:proxy26.example.com:5060;lr>\r\n"
+    "X-Hop: 6000078\r\n"
+    "Record-Route: <sip:proxy27.example.com:5060;lr>\r\n"
+    "X-Hop: 7000081\r\n"
+    "Record-Route: <sip:proxy28.example.com:5060;lr>\r\n"
+    "X-Hop: 8000084\r\n"
+    "Record-Route: <sip:proxy29.example.com:5060;lr>\r\n"
+    "X-Hop: 9000087\r\n"
+    "Record-Route: <sip:proxy30.example.com:5060;lr>\r\n"
+    "X-Hop: 10000090\r\n"
+    "Record-Route: <sip:proxy31.example.com:5060;lr>\r\n"
+    "X-Hop: 11000093\r\n"
+    "Record-Route: <sip:proxy32.example.com:5060;lr>\r\n"
+    "X-Hop: 12000096\r\n"
+    "Record-Route: <sip:proxy33.example.com:5060;lr>\r\n"
+    "X-Hop: 13000099\r\n"
+    "Record-Route: <sip:proxy34.example.com:5060;lr>\r\n"
+    "X-Hop: 14000102\r\n"
+    "Record-Route: <sip:proxy35.example.com:5060;lr>\r\n"
+    "X-Hop: 15000105\r\n"
+    "Record-Route: <sip:proxy36.example.com:5060;lr>\r\n"
+    "X-Hop: 16000108\r\n"
+    "Record-Route: <sip:proxy37.example.com:5060;lr>\r\n"
+    "X-Hop: 17000111\r\n"
+    "Record-Route: <sip:proxy38.example.com:5060;lr>\r\n"
+    "X-Hop: 18000114\r\n"
+    "Record-Route: <sip:proxy39.example.com:5060;lr>\r\n"
+    "X-Hop: 19000117\r\n"
+    "Content-Length: 269\r\n"
+    "Content-Type: application/sdp\r\n"
+    "Content-Disposition: session;handling=required\r\n"
+    "\r\n"
+    "v=0\r\n"
+    "o=Cisco-SIPUA 7125 0 IN IP4 10.1.1.20\r\n"
+    "s=SIP Call\r\n"
+    "t=0 0\r\n"
+    "m=audio 16384 RTP/AVP 0 8 18 101\r\n"
+    "c=IN IP4 10.1.1.20\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:18 G729/8000\r\n"
+    "a=fmtp:18 annexb=no\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=sendrecv\r\n";
+
@@ -0,0 +1,530 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * msgbuildtest - check outgoing SIP messages built with the httpish
+ * header block against the bytes the old per-header builder wrote, and
+ * time building them.
+ *
+ *   msgbuildtest [-n messages] [-g]
+ *
+ * Check: INVITE, 200 OK, ACK and NOTIFY requests with one, two and three
+ * body parts, and an INVITE with enough headers to chain a second header
+ * block, are built through the sippmh_add_* calls the sipSPI senders use
+ * and written with sippmh_write(). The bytes have to match
+ * golden_messages.h, and every Content-Length has to match its body. The
+ * messages are also written into buffers of exactly their size and one
+ * byte too small, and the headers read back.
+ *
+ * golden_messages.h is what -g prints when this test is built with
+ * MSGBUILD_GOLDEN and linked against httpish.c and pmhutils.c from before
+ * the header block, with one exception: the old builder put a
+ * Content-Length 2 bytes short in the three part NOTIFY, which holds the
+ * right length instead.
+ *
+ * Time: heap calls and ns per message built, written and freed, counted
+ * through the replay shim.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cc_constants.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "ccsip_pmh.h"
+#include "ccsip_platform.h"
+#include "replay_shim.h"
+
+static int failures;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            failures++; \
+            fprintf(stderr, "FAIL %s:%d %s: %s\n", __FILE__, __LINE__, \
+                    (what), #cond); \
+        } \
+    } while (0)
+
+/*
+ * Application callbacks, never called
+ */
+void
+configFetchReq (int device_handle)
+{
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const char sdp_offer[] =
+    "v=0\r\n"
+    "o=Cisco-SIPUA 7125 0 IN IP4 10.1.1.20\r\n"
+    "s=SIP Call\r\n"
+    "t=0 0\r\n"
+    "m=audio 16384 RTP/AVP 0 8 18 101\r\n"
+    "c=IN IP4 10.1.1.20\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:18 G729/8000\r\n"
+    "a=fmtp:18 annexb=no\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=sendrecv\r\n";
+
+static const char sdp_answer[] =
+    "v=0\r\n"
+    "o=Cisco-SIPUA 3302 0 IN IP4 10.1.1.30\r\n"
+    "s=SIP Call\r\n"
+    "t=0 0\r\n"
+    "m=audio 24580 RTP/AVP 0 101\r\n"
+    "c=IN IP4 10.1.1.30\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=sendrecv\r\n";
+
+static const char dialog_body[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<dialog-info xmlns=\"urn:ietf:params:xml:ns:dialog-info\" "
+    "version=\"3\" state=\"full\" entity=\"sip:1001@10.1.1.1\">\n"
+    "<dialog id=\"5ac91a4b\" call-id=\"00127f54-8f2a0004@10.1.1.20\" "
+    "direction=\"initiator\">\n"
+    "<state>confirmed</state>\n"
+    "</dialog>\n"
+    "</dialog-info>\n";
+
+static const char sipfrag_body[] = "SIP/2.0 200 OK\r\n";
+
+static const char text_body[] = "Call forwarded to voicemail\r\n";
+
+/*
+ * Headers as sipSPISendInvite and friends add them
+ */
+static void
+add_dialog_headers (sipMessage_t *msg, const char *method, int cseq,
+                    boolean to_tag)
+{
+    char cseq_str[32];
+
+    (void) sippmh_add_text_header(msg, SIP_HEADER_VIA,
+        "SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_FROM,
+        "\"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_TO, to_tag ?
+        "<sip:1002@10.1.1.1>;tag=3a4e8d1c" : "<sip:1002@10.1.1.1>");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_CALLID,
+        "00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20");
+    (void) sippmh_add_int_header(msg, SIP_HEADER_MAX_FORWARDS, 70);
+    snprintf(cseq_str, sizeof(cseq_str), "%d %s", cseq, method);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_CSEQ, cseq_str);
+}
+
+static void
+add_ua_headers (sipMessage_t *msg)
+{
+    (void) sippmh_add_text_header(msg, SIP_HEADER_USER_AGENT,
+        "Cisco-CP7960G/8.0");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_CONTACT,
+        "<sip:1001@10.1.1.20:5060;transport=udp>;+u.sip!devicename.ccm.cisco.com=\"SEP00127F548F2A\"");
+    (void) sippmh_add_int_header(msg, SIP_HEADER_EXPIRES, 180);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_ALLOW,
+        "ACK,BYE,CANCEL,INVITE,NOTIFY,OPTIONS,REFER,REGISTER,UPDATE,SUBSCRIBE,INFO");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_SUPPORTED,
+        "replaces,join,sdp-anat,norefersub,extended-refer,X-cisco-callinfo");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_ALLOW_EVENTS,
+        "kpml,dialog");
+}
+
+static void
+add_body (sipMessage_t *msg, const char *body, const char *content_type,
+          uint8_t disp, boolean required, const char *content_id)
+{
+    uint32_t len = (uint32_t) strlen(body);
+    char *copy = (char *) cpr_malloc(len);
+    char *id = NULL;
+
+    memcpy(copy, body, len);
+    if (content_id) {
+        id = cpr_strdup(content_id);
+    }
+    (void) sippmh_add_message_body(msg, copy, len, content_type, disp,
+                                   required, id);
+}
+
+static sipMessage_t *
+build_invite (void)
+{
+    sipMessage_t *msg = sippmh_message_create();
+
+    (void) sippmh_add_request_line(msg, SIP_METHOD_INVITE,
+                                   "sip:1002@10.1.1.1;user=phone",
+                                   SIP_VERSION);
+    add_dialog_headers(msg, SIP_METHOD_INVITE, 101, FALSE);
+    add_ua_headers(msg);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_REMOTE_PARTY_ID,
+        "\"Alice\" <sip:1001@10.1.1.1>;party=calling;id-type=subscriber;privacy=off;screen=yes");
+    add_body(msg, sdp_offer, SIP_CONTENT_TYPE_SDP,
+             SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
+    return msg;
+}
+
+static sipMessage_t *
+build_200 (void)
+{
+    sipMessage_t *msg = sippmh_message_create();
+
+    (void) sippmh_add_response_line(msg, SIP_VERSION, SIP_STATUS_SUCCESS,
+                                    SIP_SUCCESS_SETUP_PHRASE);
+    add_dialog_headers(msg, SIP_METHOD_INVITE, 101, TRUE);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_RECORD_ROUTE,
+        "<sip:10.1.1.1:5060;transport=udp;lr>");
+    add_ua_headers(msg);
+    add_body(msg, sdp_answer, SIP_CONTENT_TYPE_SDP,
+             SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
+    return msg;
+}
+
+static sipMessage_t *
+build_ack (void)
+{
+    sipMessage_t *msg = sippmh_message_create();
+
+    (void) sippmh_add_request_line(msg, SIP_METHOD_ACK,
+                                   "sip:1002@10.1.1.30:5060;transport=udp",
+                                   SIP_VERSION);
+    add_dialog_headers(msg, SIP_METHOD_ACK, 101, TRUE);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_ROUTE,
+        "<sip:10.1.1.1:5060;transport=udp;lr>");
+    (void) sippmh_add_int_header(msg, SIP_HEADER_CONTENT_LENGTH, 0);
+    return msg;
+}
+
+static sipMessage_t *
+build_notify (int parts)
+{
+    sipMessage_t *msg = sippmh_message_create();
+
+    (void) sippmh_add_request_line(msg, SIP_METHOD_NOTIFY,
+                                   "sip:1001@10.1.1.20:5060",
+                                   SIP_VERSION);
+    add_dialog_headers(msg, SIP_METHOD_NOTIFY, 1002, TRUE);
+    (void) sippmh_add_text_header(msg, SIP_HEADER_EVENT, "dialog");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_SUBSCRIPTION_STATE,
+        "active;expires=3600");
+    (void) sippmh_add_text_header(msg, SIP_HEADER_CONTACT,
+        "<sip:1002@10.1.1.30:5060>");
+    add_body(msg, dialog_body, SIP_CONTENT_TYPE_DIALOG,
+             SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE, NULL);
+    if (parts > 1) {
+        add_body(msg, sipfrag_body, SIP_CONTENT_TYPE_SIPFRAG,
+                 SIP_CONTENT_DISPOSITION_SESSION_VALUE, TRUE,
+                 "<frag@10.1.1.30>");
+    }
+    if (parts > 2) {
+        add_body(msg, text_body, SIP_CONTENT_TYPE_TEXT_PLAIN,
+                 SIP_CONTENT_DISPOSITION_RENDER_VALUE, FALSE, NULL);
+    }
+    return msg;
+}
+
+/* More headers than the first header block holds */
+static sipMessage_t *
+build_long_invite (void)
+{
+    sipMessage_t *msg = build_invite();
+    char route[64];
+    int i;
+
+    for (i = 0; i < 40; i++) {
+        snprintf(route, sizeof(route), "<sip:proxy%d.example.com:5060;lr>", i);
+        (void) sippmh_add_text_header(msg, SIP_HEADER_RECORD_ROUTE, route);
+        (void) sippmh_add_int_header(msg, "X-Hop", i * 1000003 - 20000000);
+    }
+    return msg;
+}
+
+typedef struct {
+    const char *name;
+    sipMessage_t *(*build)(void);
+} Message;
+
+static sipMessage_t *build_notify1 (void) { return build_notify(1); }
+static sipMessage_t *build_notify2 (void) { return build_notify(2); }
+static sipMessage_t *build_notify3 (void) { return build_notify(3); }
+
+static const Message messages[] = {
+    { "invite", build_invite },
+    { "ok", build_200 },
+    { "ack", build_ack },
+    { "notify", build_notify1 },
+    { "notify2", build_notify2 },
+    { "notify3", build_notify3 },
+    { "long_invite", build_long_invite }
+};
+
+#define NUM_MESSAGES (int) (sizeof(messages) / sizeof(messages[0]))
+
+static char out[SIP_UDP_MESSAGE_SIZE * 2];
+
+static uint32_t
+write_message (const Message *m, char *buf, uint32_t size)
+{
+    sipMessage_t *msg = m->build();
+    uint32_t nbytes = size;
+    hStatus_t status;
+
+    status = sippmh_write(msg, buf, &nbytes);
+    httpish_msg_free(msg);
+    return (status == STATUS_SUCCESS) ? nbytes : 0;
+}
+
+/*
+ * -g: print the messages as golden_messages.h
+ */
+static void
+print_golden (void)
+{
+    uint32_t len;
+    uint32_t i;
+    int n;
+
+    printf("/* generated by msgbuildtest -g, see msgbuildtest.c */\n\n");
+    for (n = 0; n < NUM_MESSAGES; n++) {
+        len = write_message(&messages[n], out, sizeof(out));
+        printf("static const char golden_%s[] =\n    \"", messages[n].name);
+        for (i = 0; i < len; i++) {
+            switch (out[i]) {
+            case '\r':
+                printf("\\r");
+                break;
+            case '\n':
+                printf(i + 1 < len ? "\\n\"\n    \"" : "\\n");
+                break;
+            case '"':
+            case '\\':
+                printf("\\%c", out[i]);
+                break;
+            default:
+                putchar(out[i]);
+                break;
+            }
+        }
+        printf("\";\n\n");
+    }
+}
+
+#ifndef MSGBUILD_GOLDEN
+#include "golden_messages.h"
+
+static const char *golden[] = {
+    golden_invite,
+    golden_ok,
+    golden_ack,
+    golden_notify,
+    golden_notify2,
+    golden_notify3,
+    golden_long_invite
+};
+
+/*
+ * The Content-Length header has to give the size of what follows the
+ * blank line.
+ */
+static void
+check_content_length (const char *name, const char *msg, uint32_t len)
+{
+    const char *hdr = strstr(msg, "\r\nContent-Length: ");
+    const char *body = strstr(msg, "\r\n\r\n");
+
+    CHECK(hdr != NULL && body != NULL, name);
+    if (hdr == NULL || body == NULL) {
+        return;
+    }
+    body += 4;
+    CHECK((uint32_t) atoi(hdr + 18) == len - (uint32_t) (body - msg), name);
+}
+
+static void
+check_message (int n)
+{
+    const Message *m = &messages[n];
+    uint32_t golden_len = (uint32_t) strlen(golden[n]);
+    sipMessage_t *msg;
+    const char *val;
+    uint32_t len;
+
+    memset(out, 0x5a, sizeof(out));
+    len = write_message(m, out, sizeof(out));
+    CHECK(len == golden_len, m->name);
+    CHECK(memcmp(out, golden[n], golden_len) == 0, m->name);
+    CHECK(out[len] == 0x5a, m->name);
+    out[len] = '\0';
+    check_content_length(m->name, out, len);
+
+    /* exactly big enough works, one byte short fails without overrunning */
+    memset(out, 0x5a, sizeof(out));
+    CHECK(write_message(m, out, golden_len) == golden_len, m->name);
+    CHECK(memcmp(out, golden[n], golden_len) == 0, m->name);
+    memset(out, 0x5a, sizeof(out));
+    CHECK(write_message(m, out, golden_len - 1) == 0, m->name);
+    CHECK(out[golden_len - 1] == 0x5a, m->name);
+
+    /* the readers still find the headers in the block */
+    msg = m->build();
+    val = sippmh_get_header_val(msg, SIP_HEADER_CALLID, NULL);
+    CHECK(val != NULL &&
+          strcmp(val, "00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20") == 0,
+          m->name);
+    val = sippmh_get_header_val(msg, SIP_HEADER_MAX_FORWARDS, NULL);
+    CHECK(val != NULL && strcmp(val, "70") == 0, m->name);
+    httpish_msg_free(msg);
+}
+
+static void
+check_messages (void)
+{
+    int n;
+
+    for (n = 0; n < NUM_MESSAGES; n++) {
+        check_message(n);
+    }
+}
+#endif
+
+static void
+bench (int count)
+{
+    static const int timed[] = { 0, 1, 2, 5 };
+    uint32_t allocs;
+    uint32_t len = 0;
+    double start;
+    double ns;
+    unsigned t;
+    int i;
+
+    printf("%-12s %8s %12s %10s\n", "message", "bytes", "allocs/msg",
+           "ns/msg");
+    for (t = 0; t < sizeof(timed) / sizeof(timed[0]); t++) {
+        const Message *m = &messages[timed[t]];
+
+        allocs = replay_alloc_count();
+        start = now_ns();
+        for (i = 0; i < count; i++) {
+            len = write_message(m, out, sizeof(out));
+        }
+        ns = (now_ns() - start) / count;
+        allocs = replay_alloc_count() - allocs;
+        if (replay_alloc_supported()) {
+            printf("%-12s %8u %12.1f %10.0f\n", m->name, len,
+                   (double) allocs / count, ns);
+        } else {
+            printf("%-12s %8u %12s %10.0f\n", m->name, len, "-", ns);
+        }
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    int count = 200000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-g")) {
+            print_golden();
+            return 0;
+        } else {
+            fprintf(stderr, "usage: %s [-n messages] [-g]\n", argv[0]);
+            return 2;
+        }
+    }
+
+#ifndef MSGBUILD_GOLDEN
+    check_messages();
+    printf("checks done, %d failures\n", failures);
+    if (failures) {
+        return 1;
+    }
+#endif
+    if (count > 0) {
+        bench(count);
+    }
+    return failures ? 1 : 0;
+}
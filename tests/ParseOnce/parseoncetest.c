@@ -0,0 +1,679 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * parseoncetest - check that the From, To, Via, CSeq and Contact a
+ * received message parses once give the same fields as parsing the header
+ * again on every call did, and time the two.
+ *
+ *   parseoncetest [-n iterations]
+ *
+ * Check: requests and responses as phones and proxies send them, with
+ * display names, tel URLs, compact header names, several Vias and
+ * Contacts, IPv6 addresses and headers that do not parse, are read with
+ * sippmh_process_network_message(). Every sippmh_get_parsed_*() result is
+ * compared field by field with sippmh_parse_*() run on the same cached
+ * header value, which is what the call sites did before. A header that
+ * is missing or does not parse has to give NULL both ways. Asking again
+ * has to give the same object without a heap call, and the header values
+ * the message holds must not change.
+ *
+ * Time: per message, reading To, CSeq and Via six times each the old way
+ * (parse and free each time) and through the accessors. Heap calls are
+ * counted through the replay shim.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cc_constants.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "ccsip_pmh.h"
+#include "replay_shim.h"
+
+/* Header reads per message along the processing path, for the timing */
+#define READS_PER_MESSAGE 6
+
+static int failures;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            failures++; \
+            fprintf(stderr, "FAIL %s:%d %s: %s\n", __FILE__, __LINE__, \
+                    (what), #cond); \
+        } \
+    } while (0)
+
+/*
+ * Application callbacks, never called
+ */
+void
+configFetchReq (int device_handle)
+{
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct {
+    const char *name;
+    const char *text;
+} Message;
+
+static const Message messages[] = {
+    { "invite",
+      "INVITE sip:1002@10.1.1.1;user=phone SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8\r\n"
+      "From: \"Alice Smith\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+      "To: <sip:1002@10.1.1.1>\r\n"
+      "Call-ID: 00127f54-8f2a0004-3bc4e1a9-71d3b01d@10.1.1.20\r\n"
+      "Max-Forwards: 70\r\n"
+      "CSeq: 101 INVITE\r\n"
+      "Contact: <sip:1001@10.1.1.20:5060;transport=udp>\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "ok_two_vias",
+      "SIP/2.0 200 OK\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.1:5060;branch=z9hG4bKproxy.1;received=10.1.1.1\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff8;rport=5062\r\n"
+      "From: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+      "To: Bob <sip:1002@10.1.1.1;user=phone>;tag=3a4e8d1c\r\n"
+      "Call-ID: 00127f54-8f2a0004@10.1.1.20\r\n"
+      "CSeq: 101 INVITE\r\n"
+      "Contact: <sip:1002@10.1.1.30:5060;transport=tcp>\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "compact",
+      "BYE sip:1001@10.1.1.20:5060 SIP/2.0\r\n"
+      "v: SIP/2.0/TCP 10.1.1.30:5060;branch=z9hG4bK77aa,"
+      " SIP/2.0/UDP 10.1.1.1;branch=z9hG4bKbb\r\n"
+      "f: <sip:1002@10.1.1.1>;tag=3a4e8d1c\r\n"
+      "t: \"Alice\" <sip:1001@10.1.1.1>;tag=00127f548f2a0002\r\n"
+      "i: 00127f54-8f2a0004@10.1.1.20\r\n"
+      "CSeq: 4711 BYE\r\n"
+      "l: 0\r\n"
+      "\r\n" },
+    { "register_contacts",
+      "REGISTER sip:10.1.1.1 SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bKreg1\r\n"
+      "From: <sip:1001@10.1.1.1>;tag=reg-1\r\n"
+      "To: <sip:1001@10.1.1.1>\r\n"
+      "Call-ID: reg-call-1@10.1.1.20\r\n"
+      "CSeq: 3 REGISTER\r\n"
+      "Contact: <sip:1001@10.1.1.20:5060>;q=0.8;expires=3600,"
+      " \"Desk\" <sip:1001@10.1.1.21:5070;maddr=10.1.1.99>;q=0.5;expires=600\r\n"
+      "Expires: 3600\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "redirect",
+      "SIP/2.0 302 Moved Temporarily\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.20:5060;branch=z9hG4bK4b43c2ff9\r\n"
+      "From: <sip:1001@10.1.1.1>;tag=abc\r\n"
+      "To: <tel:+14085551234;phone-context=example.com>;tag=xyz\r\n"
+      "Call-ID: redirect-1@10.1.1.20\r\n"
+      "CSeq: 7 INVITE\r\n"
+      "Contact: <sip:2001@10.1.1.40;user=phone>,"
+      " <sip:2002@10.1.1.41:5080>,"
+      " <sip:vm@10.1.1.42;transport=udp>\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "ipv6",
+      "OPTIONS sip:1001@[2001:db8::20]:5060 SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP [2001:db8::1]:5060;branch=z9hG4bKv6;maddr=[2001:db8::99];ttl=16\r\n"
+      "From: <sip:monitor@[2001:db8::1]>;tag=v6\r\n"
+      "To: <sip:1001@[2001:db8::20]:5060>\r\n"
+      "Call-ID: v6-1@2001:db8::1\r\n"
+      "CSeq: 1 OPTIONS\r\n"
+      "Contact: <sip:monitor@[2001:db8::1]:5060>\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "no_contact",
+      "NOTIFY sip:1001@10.1.1.20:5060 SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP 10.1.1.1:5060;branch=z9hG4bKn1\r\n"
+      "From: <sip:1002@10.1.1.1>;tag=n1\r\n"
+      "To: <sip:1001@10.1.1.1>;tag=n2\r\n"
+      "Call-ID: notify-1@10.1.1.1\r\n"
+      "CSeq: 1002 NOTIFY\r\n"
+      "Event: dialog\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" },
+    { "broken",
+      "INFO sip:1001@10.1.1.20 SIP/2.0\r\n"
+      "Via: SIP/2.0\r\n"
+      "From: not a uri\r\n"
+      "To: <sip:1001@10.1.1.1\r\n"
+      "Call-ID: broken-1@10.1.1.1\r\n"
+      "CSeq: seven INFO\r\n"
+      "Contact: <>\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n" }
+};
+
+#define NUM_MESSAGES (int) (sizeof(messages) / sizeof(messages[0]))
+
+static sipMessage_t *
+read_message (const Message *m)
+{
+    sipMessage_t *msg = sippmh_message_create();
+    uint32_t len = (uint32_t) strlen(m->text);
+
+    if (msg == NULL ||
+        sippmh_process_network_message(msg, (char *) m->text, &len) !=
+            STATUS_SUCCESS) {
+        CHECK(FALSE, m->name);
+        if (msg) {
+            sippmh_message_free(msg);
+        }
+        return NULL;
+    }
+    return msg;
+}
+
+static boolean
+str_eq (const char *a, const char *b)
+{
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    return (strcmp(a, b) == 0);
+}
+
+static boolean
+sip_url_eq (const sipUrl_t *a, const sipUrl_t *b)
+{
+    int i;
+
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    if (!str_eq(a->user, b->user) || !str_eq(a->password, b->password) ||
+        !str_eq(a->host, b->host) || !str_eq(a->maddr, b->maddr) ||
+        !str_eq(a->other, b->other) || !str_eq(a->method, b->method) ||
+        a->port != b->port || a->port_present != b->port_present ||
+        a->transport != b->transport || a->is_phone != b->is_phone ||
+        a->ttl_val != b->ttl_val || a->num_headers != b->num_headers ||
+        a->lr_flag != b->lr_flag || a->is_ipv6 != b->is_ipv6) {
+        return FALSE;
+    }
+    for (i = 0; i < a->num_headers; i++) {
+        if (!str_eq(a->headerp[i].attr, b->headerp[i].attr) ||
+            !str_eq(a->headerp[i].value, b->headerp[i].value)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static boolean
+tel_url_eq (const telUrl_t *a, const telUrl_t *b)
+{
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    return (str_eq(a->user, b->user) &&
+            str_eq(a->isdn_subaddr, b->isdn_subaddr) &&
+            str_eq(a->post_dial, b->post_dial) &&
+            str_eq(a->unparsed_tsp, b->unparsed_tsp) &&
+            str_eq(a->future_ext, b->future_ext));
+}
+
+static boolean
+location_eq (const sipLocation_t *a, const sipLocation_t *b)
+{
+    const genUrl_t *ua, *ub;
+    int i;
+
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    if (!str_eq(a->name, b->name) || !str_eq(a->tag, b->tag)) {
+        return FALSE;
+    }
+    ua = a->genUrl;
+    ub = b->genUrl;
+    if (ua == NULL || ub == NULL) {
+        return (ua == ub);
+    }
+    if (ua->schema != ub->schema || ua->sips != ub->sips ||
+        !str_eq(ua->phone_context, ub->phone_context)) {
+        return FALSE;
+    }
+    for (i = 0; i < SIP_MAX_LOCATIONS; i++) {
+        if (!str_eq(ua->other_params[i], ub->other_params[i])) {
+            return FALSE;
+        }
+    }
+    switch (ua->schema) {
+    case URL_TYPE_SIP:
+        return sip_url_eq(ua->u.sipUrl, ub->u.sipUrl);
+    case URL_TYPE_TEL:
+        return tel_url_eq(ua->u.telUrl, ub->u.telUrl);
+    default:
+        return TRUE;
+    }
+}
+
+static boolean
+via_eq (const sipVia_t *a, const sipVia_t *b)
+{
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    return (str_eq(a->version, b->version) &&
+            str_eq(a->transport, b->transport) &&
+            str_eq(a->host, b->host) &&
+            str_eq(a->ttl, b->ttl) &&
+            str_eq(a->maddr, b->maddr) &&
+            str_eq(a->recd_host, b->recd_host) &&
+            str_eq(a->branch_param, b->branch_param) &&
+            str_eq(a->more_via, b->more_via) &&
+            a->remote_port == b->remote_port &&
+            a->flags == b->flags &&
+            a->is_ipv6 == b->is_ipv6);
+}
+
+static boolean
+cseq_eq (const sipCseq_t *a, const sipCseq_t *b)
+{
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    return (a->number == b->number && a->method == b->method);
+}
+
+static boolean
+contact_eq (const sipContact_t *a, const sipContact_t *b)
+{
+    const sipContactParams_t *pa, *pb;
+    int i;
+
+    if (a == NULL || b == NULL) {
+        return (a == b);
+    }
+    if (a->num_locations != b->num_locations || a->new_flag != b->new_flag) {
+        return FALSE;
+    }
+    for (i = 0; i < a->num_locations; i++) {
+        pa = &a->params[i];
+        pb = &b->params[i];
+        if (!location_eq(a->locations[i], b->locations[i]) ||
+            pa->action != pb->action || !str_eq(pa->qval, pb->qval) ||
+            pa->expires != pb->expires ||
+            !str_eq(pa->expires_gmt, pb->expires_gmt) ||
+            !str_eq(pa->extn_attr, pb->extn_attr) ||
+            pa->flags != pb->flags) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * The old per-call parses, as the call sites did them
+ */
+static sipLocation_t *
+old_parse_location (sipMessage_t *msg, int header)
+{
+    const char *val = sippmh_get_cached_header_val(msg, header);
+
+    return (val ? sippmh_parse_from_or_to((char *) val, TRUE) : NULL);
+}
+
+static sipVia_t *
+old_parse_via (sipMessage_t *msg)
+{
+    const char *val = sippmh_get_cached_header_val(msg, VIA);
+
+    return (val ? sippmh_parse_via(val) : NULL);
+}
+
+static sipCseq_t *
+old_parse_cseq (sipMessage_t *msg)
+{
+    const char *val = sippmh_get_cached_header_val(msg, CSEQ);
+
+    return (val ? sippmh_parse_cseq(val) : NULL);
+}
+
+static sipContact_t *
+old_parse_contact (sipMessage_t *msg)
+{
+    const char *val = sippmh_get_cached_header_val(msg, CONTACT);
+
+    return (val ? sippmh_parse_contact(val) : NULL);
+}
+
+/* Copies of the header values, to see that parsing leaves them alone */
+static const int watched[] = { FROM, TO, VIA, CSEQ, CONTACT };
+#define NUM_WATCHED (int) (sizeof(watched) / sizeof(watched[0]))
+
+static void
+save_values (sipMessage_t *msg, char *saved[])
+{
+    const char *val;
+    int i;
+
+    for (i = 0; i < NUM_WATCHED; i++) {
+        val = sippmh_get_cached_header_val(msg, watched[i]);
+        saved[i] = val ? strdup(val) : NULL;
+    }
+}
+
+static void
+check_values (const char *name, sipMessage_t *msg, char *saved[])
+{
+    int i;
+
+    for (i = 0; i < NUM_WATCHED; i++) {
+        CHECK(str_eq(sippmh_get_cached_header_val(msg, watched[i]),
+                     saved[i]), name);
+        free(saved[i]);
+    }
+}
+
+static void
+check_message (const Message *m)
+{
+    sipMessage_t *msg = read_message(m);
+    const sipLocation_t *from, *to;
+    const sipVia_t *via;
+    const sipCseq_t *cseq;
+    const sipContact_t *contact;
+    sipLocation_t *old_from, *old_to;
+    sipVia_t *old_via;
+    sipCseq_t *old_cseq;
+    sipContact_t *old_contact;
+    char *saved[NUM_WATCHED];
+    uint32_t allocs;
+
+    if (msg == NULL) {
+        return;
+    }
+    save_values(msg, saved);
+
+    from = sippmh_get_parsed_from(msg);
+    to = sippmh_get_parsed_to(msg);
+    via = sippmh_get_parsed_via(msg);
+    cseq = sippmh_get_parsed_cseq(msg);
+    contact = sippmh_get_parsed_contact(msg);
+
+    old_from = old_parse_location(msg, FROM);
+    old_to = old_parse_location(msg, TO);
+    old_via = old_parse_via(msg);
+    old_cseq = old_parse_cseq(msg);
+    old_contact = old_parse_contact(msg);
+
+    CHECK(location_eq(from, old_from), m->name);
+    CHECK(location_eq(to, old_to), m->name);
+    CHECK(via_eq(via, old_via), m->name);
+    CHECK(cseq_eq(cseq, old_cseq), m->name);
+    CHECK(contact_eq(contact, old_contact), m->name);
+
+    /* asking again is free and gives the same objects */
+    allocs = replay_alloc_count();
+    CHECK(sippmh_get_parsed_from(msg) == from, m->name);
+    CHECK(sippmh_get_parsed_to(msg) == to, m->name);
+    CHECK(sippmh_get_parsed_via(msg) == via, m->name);
+    CHECK(sippmh_get_parsed_cseq(msg) == cseq, m->name);
+    CHECK(sippmh_get_parsed_contact(msg) == contact, m->name);
+    CHECK(replay_alloc_count() == allocs, m->name);
+
+    check_values(m->name, msg, saved);
+
+    if (old_from) {
+        sippmh_free_location(old_from);
+    }
+    if (old_to) {
+        sippmh_free_location(old_to);
+    }
+    if (old_via) {
+        sippmh_free_via(old_via);
+    }
+    cpr_free(old_cseq);
+    if (old_contact) {
+        sippmh_free_contact(old_contact);
+    }
+    sippmh_message_free(msg);
+}
+
+/*
+ * Fields the corpus is meant to exercise, so a parser that gives NULL
+ * for everything does not pass the comparison trivially
+ */
+static void
+check_expected (void)
+{
+    sipMessage_t *msg;
+    const sipLocation_t *loc;
+    const sipVia_t *via;
+    const sipCseq_t *cseq;
+    const sipContact_t *contact;
+
+    msg = read_message(&messages[0]);
+    if (msg) {
+        loc = sippmh_get_parsed_from(msg);
+        CHECK(loc && str_eq(loc->name, "Alice Smith") &&
+              str_eq(loc->tag, "00127f548f2a0002") &&
+              loc->genUrl->schema == URL_TYPE_SIP &&
+              str_eq(loc->genUrl->u.sipUrl->user, "1001"), "invite from");
+        cseq = sippmh_get_parsed_cseq(msg);
+        CHECK(cseq && cseq->number == 101 && cseq->method == sipMethodInvite,
+              "invite cseq");
+        via = sippmh_get_parsed_via(msg);
+        CHECK(via && str_eq(via->branch_param, "z9hG4bK4b43c2ff8") &&
+              str_eq(via->host, "10.1.1.20"), "invite via");
+        sippmh_message_free(msg);
+    }
+
+    msg = read_message(&messages[2]);
+    if (msg) {
+        via = sippmh_get_parsed_via(msg);
+        CHECK(via && str_eq(via->transport, "TCP") &&
+              str_eq(via->branch_param, "z9hG4bK77aa"), "compact via");
+        loc = sippmh_get_parsed_to(msg);
+        CHECK(loc && str_eq(loc->tag, "00127f548f2a0002"), "compact to");
+        cseq = sippmh_get_parsed_cseq(msg);
+        CHECK(cseq && cseq->number == 4711 && cseq->method == sipMethodBye,
+              "compact cseq");
+        sippmh_message_free(msg);
+    }
+
+    msg = read_message(&messages[3]);
+    if (msg) {
+        contact = sippmh_get_parsed_contact(msg);
+        CHECK(contact && contact->num_locations == 2, "register contacts");
+        sippmh_message_free(msg);
+    }
+
+    msg = read_message(&messages[4]);
+    if (msg) {
+        loc = sippmh_get_parsed_to(msg);
+        CHECK(loc && loc->genUrl && loc->genUrl->schema == URL_TYPE_TEL,
+              "redirect tel to");
+        contact = sippmh_get_parsed_contact(msg);
+        CHECK(contact && contact->num_locations == 3, "redirect contacts");
+        sippmh_message_free(msg);
+    }
+
+    msg = read_message(&messages[6]);
+    if (msg) {
+        CHECK(sippmh_get_parsed_contact(msg) == NULL, "no contact");
+        CHECK(sippmh_get_parsed_contact(msg) == NULL, "no contact again");
+        sippmh_message_free(msg);
+    }
+}
+
+static void
+bench (int count)
+{
+    sipMessage_t *msg;
+    sipLocation_t *to;
+    sipVia_t *via;
+    sipCseq_t *cseq;
+    uint32_t allocs;
+    double start, old_ns, new_ns;
+    int i, r, ok = 0;
+
+    msg = read_message(&messages[1]);
+    if (msg == NULL) {
+        return;
+    }
+
+    allocs = replay_alloc_count();
+    start = now_ns();
+    for (i = 0; i < count; i++) {
+        for (r = 0; r < READS_PER_MESSAGE; r++) {
+            to = old_parse_location(msg, TO);
+            cseq = old_parse_cseq(msg);
+            via = old_parse_via(msg);
+            ok += (to && cseq && via);
+            sippmh_free_location(to);
+            cpr_free(cseq);
+            sippmh_free_via(via);
+        }
+    }
+    old_ns = (now_ns() - start) / count;
+    allocs = replay_alloc_count() - allocs;
+    sippmh_message_free(msg);
+
+    printf("%-10s %12s %10s\n", "reads", "allocs/msg", "ns/msg");
+    if (replay_alloc_supported()) {
+        printf("%-10s %12.1f %10.0f\n", "reparse",
+               (double) allocs / count, old_ns);
+    } else {
+        printf("%-10s %12s %10.0f\n", "reparse", "-", old_ns);
+    }
+
+    /* the message is read again each time so the cache starts cold */
+    new_ns = 0;
+    allocs = 0;
+    for (i = 0; i < count; i++) {
+        msg = read_message(&messages[1]);
+        if (msg == NULL) {
+            return;
+        }
+        allocs -= replay_alloc_count();
+        start = now_ns();
+        for (r = 0; r < READS_PER_MESSAGE; r++) {
+            ok += (sippmh_get_parsed_to(msg) && sippmh_get_parsed_cseq(msg) &&
+                   sippmh_get_parsed_via(msg));
+        }
+        new_ns += now_ns() - start;
+        allocs += replay_alloc_count();
+        sippmh_message_free(msg);
+    }
+    new_ns /= count;
+
+    if (replay_alloc_supported()) {
+        printf("%-10s %12.1f %10.0f\n", "parsed", (double) allocs / count,
+               new_ns);
+    } else {
+        printf("%-10s %12s %10.0f\n", "parsed", "-", new_ns);
+    }
+    CHECK(ok == 2 * count * READS_PER_MESSAGE, "bench parses");
+}
+
+int
+main (int argc, char **argv)
+{
+    int count = 100000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            count = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (i = 0; i < NUM_MESSAGES; i++) {
+        check_message(&messages[i]);
+    }
+    check_expected();
+    printf("checks done, %d failures\n", failures);
+    if (failures) {
+        return 1;
+    }
+
+    if (count > 0) {
+        bench(count);
+    }
+    return failures ? 1 : 0;
+}
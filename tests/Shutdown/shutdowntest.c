@@ -0,0 +1,734 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * shutdowntest - check that a shutdown takes exactly as long as the
+ * network makes it.
+ *
+ *   shutdowntest [-c calls] [-v]
+ *
+ * Transaction checks: the coordinator counts an unREGISTER, BYE or
+ * unSUBSCRIBE once however often it is sent, forgets it when its final
+ * response arrives, and ignores answers to anything it was not waiting
+ * for.
+ *
+ * Unload checks: the stack runs in P2P mode with the replay shim (see
+ * ../SipReplay/replay_shim.h), single threaded on the virtual clock. A
+ * stub peer on the loopback transport calls in the given number of
+ * times; each call is answered, so all but the last end up on hold.
+ * ccUnload() then makes the stack send one BYE per call. The stub holds
+ * on to the 200 OKs and hands them back one at a time, 100ms apart:
+ *
+ *   - all answered: the SIP phase must still be draining before the last
+ *     200 OK and every task must have unloaded right after it, with the
+ *     SIP drain time exactly that of the last answer. A thread blocked
+ *     in cc_shutdown_wait() must be woken.
+ *   - one missing: the SIP phase must drain at the deadline instead, with
+ *     one transaction abandoned.
+ *
+ * Each unload scenario runs in a child process since the stack can only
+ * be brought up once per process.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cpr_ipc.h"
+#include "cpr_socket.h"
+#include "phone.h"
+#include "ccsip_core.h"
+#include "ccsip_task.h"
+#include "ccsip_pmh.h"
+#include "sip_common_transport.h"
+#include "phntask.h"
+#include "gsm.h"
+#include "ccapp_task.h"
+#include "cc_constants.h"
+#include "cc_service.h"
+#include "ccapi_service.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "ccapi_call_info.h"
+#include "config_api.h"
+#include "cc_shutdown.h"
+#include "replay_shim.h"
+
+extern cprMsgQueue_t sip_msgq;
+extern cprMsgQueue_t gsm_msgq;
+extern cprMsgQueue_t ccapp_msgq;
+extern cprMsgQueue_t misc_app_msgq;
+extern cprMsgQueue_t gsm_msg_queue;
+extern cprMsgQueue_t s_misc_msg_queue;
+extern sipGlobal_t sip;
+extern void ccUnload(void);
+extern void destroy_misc_app_thread(void);
+
+#define STUB_LOCAL_IP       "127.0.0.1"
+#define STUB_REMOTE_IP      "127.0.0.2"
+#define STUB_SIP_PORT       5060
+#define STUB_USER           "1000"
+#define STUB_DEVICE         "shutdowntest"
+
+#define STUB_MSG_SIZE       8192
+#define STUB_MAX_MSGS       64
+#define STUB_BATCH          16
+
+#define DEFAULT_CALLS       3
+#define STUB_MAX_CALLS           8
+#define ANSWER_SPACING_MS   100
+/* the SIP drain deadline in ccsip_core.c */
+#define DRAIN_DEADLINE_MS   2000
+
+static int failures = 0;
+
+static void
+fail (const char *what, unsigned int got, unsigned int expect)
+{
+    failures++;
+    fprintf(stderr, "FAIL %s: got %u expected %u\n", what, got, expect);
+}
+
+static void
+check (const char *what, unsigned int got, unsigned int expect)
+{
+    if (got != expect) {
+        fail(what, got, expect);
+    }
+}
+
+/*
+ * Transaction checks
+ */
+static void
+check_txns (void)
+{
+    cc_shutdown_init();
+
+    /* nothing is recorded unless a drain asked for it */
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_BYE, "a@host", 2);
+    check("untracked send", cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_MAX), 0);
+
+    cc_shutdown_track_txns(TRUE);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_REGISTER, "r@host", 7);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_REGISTER, "r@host", 7);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_BYE, "a@host", 2);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_BYE, "b@host", 2);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_UNSUBSCRIBE, "s@host", 3);
+    check("retransmission", cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_REGISTER),
+          1);
+    check("pending bye", cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_BYE), 2);
+    check("pending all", cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_MAX), 4);
+
+    /* a 401 answers CSeq 7; the re-sent REGISTER is a new transaction */
+    check("answer register",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_REGISTER, "r@host", 7),
+          TRUE);
+    cc_shutdown_txn_sent(CC_SHUTDOWN_TXN_REGISTER, "r@host", 8);
+    check("re-sent register",
+          cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_REGISTER), 1);
+    check("repeated answer",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_REGISTER, "r@host", 7),
+          FALSE);
+    check("wrong cseq",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_BYE, "a@host", 1), FALSE);
+    check("wrong type",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_BYE, "s@host", 3), FALSE);
+    check("answer bye",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_BYE, "a@host", 2), TRUE);
+    check("pending after answers",
+          cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_MAX), 3);
+
+    /* stopping forgets everything */
+    cc_shutdown_track_txns(FALSE);
+    check("pending after stop", cc_shutdown_txn_pending(CC_SHUTDOWN_TXN_MAX),
+          0);
+    check("answer after stop",
+          cc_shutdown_txn_answered(CC_SHUTDOWN_TXN_BYE, "b@host", 2), FALSE);
+
+    /* no sequence running: nothing to wait for */
+    check("wait without start", cc_shutdown_wait(0), FALSE);
+}
+
+/*
+ * Stub peer. Whatever the stack sends lands in the outbox; pump() answers
+ * it and feeds the answers back until the stack has nothing more to say.
+ * 200 OKs to BYE are put aside for the test to deliver.
+ */
+typedef struct {
+    char *text[STUB_MAX_MSGS];
+    int count;
+} stub_msgs_t;
+
+static stub_msgs_t outbox;
+static stub_msgs_t inbox;
+static stub_msgs_t held_byes;
+static unsigned int stub_tag = 0;
+
+static cc_call_handle_t ringing_call = 0;
+static unsigned int calls_connected = 0;
+static unsigned int calls_ended = 0;
+
+static void
+msgs_add (stub_msgs_t *msgs, const char *buf, size_t len)
+{
+    if (msgs->count == STUB_MAX_MSGS) {
+        fail("stub message overflow", msgs->count, STUB_MAX_MSGS - 1);
+        return;
+    }
+    msgs->text[msgs->count] = malloc(len + 1);
+    memcpy(msgs->text[msgs->count], buf, len);
+    msgs->text[msgs->count][len] = '\0';
+    msgs->count++;
+}
+
+static char *
+msgs_take (stub_msgs_t *msgs)
+{
+    char *text;
+
+    if (msgs->count == 0) {
+        return NULL;
+    }
+    text = msgs->text[0];
+    memmove(&msgs->text[0], &msgs->text[1],
+            (msgs->count - 1) * sizeof(char *));
+    msgs->count--;
+    return text;
+}
+
+static void
+stub_sent (const char *buf, uint32_t len)
+{
+    msgs_add(&outbox, buf, len);
+}
+
+/* Appends each 'name' header line of 'msg' to 'out' */
+static void
+copy_header (const char *msg, const char *name, char *out, size_t room)
+{
+    const char *p, *eol;
+    size_t name_len = strlen(name);
+    size_t used = strlen(out);
+
+    for (p = strstr(msg, "\r\n"); p && p[2] != '\r'; p = eol) {
+        p += 2;
+        eol = strstr(p, "\r\n");
+        if (eol == NULL) {
+            break;
+        }
+        if (strncasecmp(p, name, name_len) != 0 || p[name_len] != ':') {
+            continue;
+        }
+        if (used + (eol - p) + 3 >= room) {
+            break;
+        }
+        memcpy(out + used, p, eol - p + 2);
+        used += eol - p + 2;
+        out[used] = '\0';
+    }
+}
+
+static void
+stub_answer (const char *req, boolean with_sdp)
+{
+    static char msg[STUB_MSG_SIZE];
+    const char *body = NULL;
+    char to[256] = "";
+    size_t used;
+
+    snprintf(msg, sizeof(msg), "SIP/2.0 200 OK\r\n");
+    copy_header(req, "Via", msg, sizeof(msg));
+    copy_header(req, "From", msg, sizeof(msg));
+    copy_header(req, "To", to, sizeof(to));
+    if (to[0] && strstr(to, "tag=") == NULL) {
+        /* new dialog: add our tag in front of the CRLF */
+        snprintf(to + strlen(to) - 2, sizeof(to) - strlen(to) + 2,
+                 ";tag=stub-%u\r\n", ++stub_tag);
+    }
+    used = strlen(msg);
+    snprintf(msg + used, sizeof(msg) - used, "%s", to);
+    copy_header(req, "Call-ID", msg, sizeof(msg));
+    copy_header(req, "CSeq", msg, sizeof(msg));
+    used = strlen(msg);
+    if (with_sdp) {
+        body = "v=0\r\n"
+               "o=peer 1 2 IN IP4 " STUB_REMOTE_IP "\r\n"
+               "s=-\r\n"
+               "c=IN IP4 " STUB_REMOTE_IP "\r\n"
+               "t=0 0\r\n"
+               "m=audio 20000 RTP/AVP 0\r\n"
+               "a=rtpmap:0 PCMU/8000\r\n";
+        snprintf(msg + used, sizeof(msg) - used,
+                 "Contact: <sip:2000@%s:%d>\r\n"
+                 "Content-Type: application/sdp\r\n"
+                 "Content-Length: %u\r\n\r\n%s",
+                 STUB_REMOTE_IP, STUB_SIP_PORT, (unsigned int) strlen(body),
+                 body);
+    } else {
+        snprintf(msg + used, sizeof(msg) - used, "Content-Length: 0\r\n\r\n");
+    }
+
+    if (strncmp(req, "BYE ", 4) == 0) {
+        msgs_add(&held_byes, msg, strlen(msg));
+    } else {
+        msgs_add(&inbox, msg, strlen(msg));
+    }
+}
+
+static void
+stub_ack (const char *rsp, const char *call_id)
+{
+    static char msg[STUB_MSG_SIZE];
+    unsigned long cseq;
+    const char *p;
+
+    p = strstr(rsp, "\r\nCSeq:");
+    cseq = p ? strtoul(p + 7, NULL, 10) : 1;
+    snprintf(msg, sizeof(msg),
+             "ACK sip:%s@%s:%d SIP/2.0\r\n"
+             "Via: SIP/2.0/UDP %s:%d;branch=z9hG4bK-%s-ack-%lu\r\n"
+             "Max-Forwards: 70\r\n",
+             STUB_USER, STUB_LOCAL_IP, STUB_SIP_PORT,
+             STUB_REMOTE_IP, STUB_SIP_PORT, call_id, cseq);
+    copy_header(rsp, "From", msg, sizeof(msg));
+    copy_header(rsp, "To", msg, sizeof(msg));
+    copy_header(rsp, "Call-ID", msg, sizeof(msg));
+    snprintf(msg + strlen(msg), sizeof(msg) - strlen(msg),
+             "CSeq: %lu ACK\r\nContent-Length: 0\r\n\r\n", cseq);
+    msgs_add(&inbox, msg, strlen(msg));
+}
+
+static void
+stub_receive (const char *text)
+{
+    char call_id[64] = "";
+    const char *p;
+
+    p = strstr(text, "\r\nCall-ID:");
+    if (p) {
+        sscanf(p + 10, " %63[^\r@]", call_id);
+    }
+    if (strncmp(text, "SIP/2.0 200 ", 12) == 0) {
+        /* the stack answered one of our INVITEs */
+        if (strstr(text, " INVITE\r\n")) {
+            stub_ack(text, call_id);
+        }
+    } else if (strncmp(text, "SIP/2.0 ", 8) == 0) {
+        /* provisional responses need nothing */
+    } else if (strncmp(text, "INVITE ", 7) == 0) {
+        /* a hold or resume */
+        stub_answer(text, TRUE);
+    } else if (strncmp(text, "ACK ", 4) != 0) {
+        stub_answer(text, FALSE);
+    }
+}
+
+/* Hands a message to the stack the way the TCP receive path does */
+static void
+stub_deliver (char *text)
+{
+    sipMessage_t *msg = NULL;
+    cpr_sockaddr_storage from;
+    struct sockaddr_in *sin = (struct sockaddr_in *) &from;
+    char *p = text;
+    unsigned long nbytes = strlen(text);
+
+    memset(&from, 0, sizeof(from));
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(STUB_SIP_PORT);
+    sin->sin_addr.s_addr = inet_addr(STUB_REMOTE_IP);
+
+    if (ccsip_process_network_message(&msg, &p, &nbytes, NULL) != SIP_SUCCESS) {
+        fail("stack parsed stub message", 0, 1);
+        fprintf(stderr, "%s\n", text);
+    } else {
+        SIPTaskProcessTCPMessage(msg, from);
+    }
+    free(text);
+}
+
+/*
+ * Take messages off the task queues until all of them are empty. Misc
+ * App messages other than the unload have no part in this test.
+ */
+static void
+drain (void)
+{
+    cprMsgBatchEntry_t batch[STUB_BATCH];
+    phn_syshdr_t *syshdr;
+    uint16_t count, i;
+    boolean busy = TRUE;
+
+    while (busy) {
+        busy = FALSE;
+
+        count = cprGetMessageBatch(sip_msgq, FALSE, batch, STUB_BATCH);
+        for (i = 0; i < count; i++) {
+            syshdr = (phn_syshdr_t *) batch[i].usrPtr;
+            SIPTaskProcessListEvent(syshdr->Cmd, batch[i].msg,
+                                    syshdr->Usr.UsrPtr, syshdr->Len);
+            cprReleaseSysHeader(syshdr);
+            busy = TRUE;
+        }
+
+        count = cprGetMessageBatch(gsm_msgq, FALSE, batch, STUB_BATCH);
+        for (i = 0; i < count; i++) {
+            gsm_task_process_msg((phn_syshdr_t *) batch[i].usrPtr,
+                                 batch[i].msg);
+            busy = TRUE;
+        }
+
+        count = cprGetMessageBatch(ccapp_msgq, FALSE, batch, STUB_BATCH);
+        for (i = 0; i < count; i++) {
+            ccappTaskProcessMsg((phn_syshdr_t *) batch[i].usrPtr,
+                                batch[i].msg);
+            busy = TRUE;
+        }
+
+        count = cprGetMessageBatch(misc_app_msgq, FALSE, batch, STUB_BATCH);
+        for (i = 0; i < count; i++) {
+            syshdr = (phn_syshdr_t *) batch[i].usrPtr;
+            if (syshdr->Cmd == THREAD_UNLOAD) {
+                destroy_misc_app_thread();
+            }
+            cprReleaseSysHeader(syshdr);
+            cprReleaseBuffer(batch[i].msg);
+            busy = TRUE;
+        }
+    }
+}
+
+static void
+pump (void)
+{
+    char *text;
+
+    drain();
+    while (outbox.count || inbox.count) {
+        while ((text = msgs_take(&outbox)) != NULL) {
+            stub_receive(text);
+            free(text);
+        }
+        while ((text = msgs_take(&inbox)) != NULL) {
+            stub_deliver(text);
+            drain();
+        }
+    }
+}
+
+static void
+run_clock (uint32_t until)
+{
+    while (replay_clock_run(until) != 0) {
+        pump();
+    }
+}
+
+/*
+ * Application callbacks
+ */
+void
+configFetchReq (int device_handle)
+{
+    CCAPI_Start_response(device_handle, STUB_DEVICE, STUB_USER, "",
+                         STUB_REMOTE_IP);
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+    switch (CCAPI_CallInfo_getCallState(info)) {
+    case RINGIN:
+        ringing_call = handle;
+        break;
+    case CONNECTED:
+        if (handle == ringing_call) {
+            ringing_call = 0;
+            calls_connected++;
+        }
+        break;
+    case ONHOOK:
+        calls_ended++;
+        break;
+    default:
+        break;
+    }
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+/*
+ * Unload checks
+ */
+static int
+stack_start (void)
+{
+    int max_calls = STUB_MAX_CALLS;
+
+    if (CCAPI_Service_create() != CC_SUCCESS) {
+        return -1;
+    }
+    (void) CCAPI_Config_set_p2p_mode(TRUE);
+    (void) CCAPI_Config_set_transport_udp(TRUE);
+    (void) CCAPI_Config_set_local_voip_port(STUB_SIP_PORT);
+    (void) CCAPI_Config_set_remote_voip_port(STUB_SIP_PORT);
+
+    /* what each task thread does before it starts taking messages */
+    sip.msgQueue = sip_msgq;
+    SIPTaskInit();
+    gsm_msg_queue = gsm_msgq;
+    gsm_task_init();
+    ccappTaskInit();
+    s_misc_msg_queue = misc_app_msgq;
+    pump();
+
+    CCAPI_Device_IP_Update(CCAPI_Device_getDeviceID(), STUB_LOCAL_IP, "", 0,
+                           STUB_LOCAL_IP, "", 0);
+    if (CCAPI_Service_start() != CC_SUCCESS) {
+        return -1;
+    }
+    pump();
+    run_clock(replay_clock_now() + 1000);
+
+    /* the defaults turn a second call on the line away with 486 */
+    config_set_line_value(CFGID_LINE_MAXNUMCALLS, &max_calls,
+                          sizeof(max_calls), 1);
+    config_set_line_value(CFGID_LINE_BUSY_TRIGGER, &max_calls,
+                          sizeof(max_calls), 1);
+    return sip.taskInited ? 0 : -1;
+}
+
+static void
+stub_call_in (unsigned int n)
+{
+    static char msg[STUB_MSG_SIZE];
+    static const char body[] =
+        "v=0\r\n"
+        "o=peer 1 1 IN IP4 " STUB_REMOTE_IP "\r\n"
+        "s=-\r\n"
+        "c=IN IP4 " STUB_REMOTE_IP "\r\n"
+        "t=0 0\r\n"
+        "m=audio 20000 RTP/AVP 0\r\n"
+        "a=rtpmap:0 PCMU/8000\r\n"
+        "a=sendrecv\r\n";
+
+    snprintf(msg, sizeof(msg),
+             "INVITE sip:%s@%s:%d SIP/2.0\r\n"
+             "Via: SIP/2.0/UDP %s:%d;branch=z9hG4bK-in%u-1\r\n"
+             "Max-Forwards: 70\r\n"
+             "From: <sip:2000@%s:%d>;tag=peer-%u\r\n"
+             "To: <sip:%s@%s:%d>\r\n"
+             "Call-ID: in%u@%s\r\n"
+             "CSeq: 1 INVITE\r\n"
+             "Contact: <sip:2000@%s:%d>\r\n"
+             "Content-Type: application/sdp\r\n"
+             "Content-Length: %u\r\n\r\n%s",
+             STUB_USER, STUB_LOCAL_IP, STUB_SIP_PORT,
+             STUB_REMOTE_IP, STUB_SIP_PORT, n,
+             STUB_REMOTE_IP, STUB_SIP_PORT, n,
+             STUB_USER, STUB_LOCAL_IP, STUB_SIP_PORT,
+             n, STUB_REMOTE_IP,
+             STUB_REMOTE_IP, STUB_SIP_PORT,
+             (unsigned int) strlen(body), body);
+    msgs_add(&inbox, msg, strlen(msg));
+    pump();
+
+    if (ringing_call == 0) {
+        fail("incoming call rings", 0, 1);
+        return;
+    }
+    if (CCAPI_Call_answerCall(ringing_call, CC_SDP_DIRECTION_SENDRECV)
+            != CC_SUCCESS) {
+        fail("answer call", 0, 1);
+    }
+    pump();
+}
+
+static void *
+waiter (void *arg)
+{
+    return (void *)(long) cc_shutdown_wait(60000);
+}
+
+static void
+check_unload (unsigned int calls, boolean answer_all)
+{
+    cc_shutdown_stats_t stats;
+    pthread_t waiter_thread;
+    void *woken = NULL;
+    uint32_t t0;
+    unsigned int i, answered;
+    int phase;
+
+    replay_transport_set_sink(stub_sent);
+    if (stack_start() != 0) {
+        fail("stack started", 0, 1);
+        return;
+    }
+    for (i = 1; i <= calls; i++) {
+        stub_call_in(i);
+    }
+    check("calls connected", calls_connected, calls);
+
+    if (pthread_create(&waiter_thread, NULL, waiter, NULL) != 0) {
+        fail("waiter started", 0, 1);
+        return;
+    }
+
+    t0 = replay_clock_now();
+    ccUnload();
+    pump();
+    check("BYEs sent", held_byes.count, calls);
+
+    answered = answer_all ? calls : calls - 1;
+    for (i = 0; i < answered; i++) {
+        run_clock(t0 + (i + 1) * ANSWER_SPACING_MS);
+        (void) cc_shutdown_get_stats(CC_SHUTDOWN_PHASE_SIP, &stats);
+        check("SIP draining until the last answer", stats.state,
+              CC_SHUTDOWN_DRAINING);
+        stub_deliver(msgs_take(&held_byes));
+        pump();
+    }
+    if (!answer_all) {
+        (void) cc_shutdown_get_stats(CC_SHUTDOWN_PHASE_SIP, &stats);
+        check("SIP draining with an answer missing", stats.state,
+              CC_SHUTDOWN_DRAINING);
+        run_clock(t0 + DRAIN_DEADLINE_MS + 1000);
+    }
+
+    (void) cc_shutdown_get_stats(CC_SHUTDOWN_PHASE_SIP, &stats);
+    check("SIP drain ms", stats.drain_ms,
+          answer_all ? calls * ANSWER_SPACING_MS : DRAIN_DEADLINE_MS);
+    check("SIP transactions", stats.txns, calls);
+    check("SIP abandoned", stats.abandoned, answer_all ? 0 : 1);
+    for (phase = 0; phase < CC_SHUTDOWN_PHASE_MAX; phase++) {
+        (void) cc_shutdown_get_stats((cc_shutdown_phase_e) phase, &stats);
+        check("phase unloaded", stats.state, CC_SHUTDOWN_UNLOADED);
+    }
+    check("calls ended", calls_ended, calls);
+
+    (void) pthread_join(waiter_thread, &woken);
+    check("waiter woken", (unsigned int)(long) woken, TRUE);
+
+    printf("%s: %u calls, SIP drained in %u ms of virtual time\n",
+           answer_all ? "all answered" : "one missing", calls,
+           answer_all ? calls * ANSWER_SPACING_MS : DRAIN_DEADLINE_MS);
+}
+
+/* Runs an unload scenario in a child process */
+static void
+run_unload (unsigned int calls, boolean answer_all)
+{
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) {
+        fail("fork", 0, 1);
+        return;
+    }
+    if (pid == 0) {
+        check_unload(calls, answer_all);
+        fflush(stdout);
+        _exit(failures ? 1 : 0);
+    }
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+        fail("unload scenario", WIFEXITED(status) ? WEXITSTATUS(status) : 255,
+             0);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    unsigned int calls = DEFAULT_CALLS;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-c") && (i + 1 < argc)) {
+            calls = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-v")) {
+            replay_set_verbose(1);
+        } else {
+            fprintf(stderr, "usage: %s [-c calls] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((calls < 1) || (calls > STUB_MAX_CALLS)) {
+        calls = STUB_MAX_CALLS;
+    }
+
+    check_txns();
+    run_unload(calls, TRUE);
+    run_unload(calls, FALSE);
+
+    printf("checks done, %d failures\n", failures);
+    return failures ? 1 : 0;
+}
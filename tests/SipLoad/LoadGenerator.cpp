@@ -0,0 +1,634 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "LoadGenerator.h"
+#include "StubProxy.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sys/resource.h>
+
+#include "CC_Call.h"
+#include "CC_CallInfo.h"
+#include "CC_Device.h"
+#include "CSFLogStream.h"
+#include "base/threading/platform_thread.h"
+
+using namespace CSF;
+
+static const char* logTag = "LoadGenerator";
+
+static const int TICK_MS = 5;
+
+static long long cpuNow()
+{
+	rusage usage;
+	if (getrusage( RUSAGE_SELF, &usage ) != 0)
+	{
+		return 0;
+	}
+	return (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+			usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+void LatencyHistogram::add( double ms )
+{
+	samples.push_back( ms );
+	sorted = false;
+}
+
+double LatencyHistogram::percentile( double p )
+{
+	if (samples.empty())
+	{
+		return 0;
+	}
+	if (!sorted)
+	{
+		std::sort( samples.begin(), samples.end() );
+		sorted = true;
+	}
+	size_t index = (size_t) (p / 100.0 * (samples.size() - 1) + 0.5);
+	return samples[std::min( index, samples.size() - 1 )];
+}
+
+double LatencyHistogram::max()
+{
+	return percentile( 100 );
+}
+
+void LatencyHistogram::print( std::ostream & os )
+{
+	static const double bounds[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+	static const int numBounds = sizeof(bounds) / sizeof(bounds[0]);
+	int counts[numBounds + 1] = { 0 };
+
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		int b = 0;
+		while (b < numBounds && samples[i] > bounds[b])
+		{
+			b++;
+		}
+		counts[b]++;
+	}
+
+	int peak = *std::max_element( counts, counts + numBounds + 1 );
+	for (int b = 0; b <= numBounds; b++)
+	{
+		if (counts[b] == 0)
+		{
+			continue;
+		}
+		if (b < numBounds)
+		{
+			os << "  <= " << std::setw(5) << bounds[b] << " ms ";
+		}
+		else
+		{
+			os << "   > " << std::setw(5) << bounds[numBounds - 1] << " ms ";
+		}
+		os << std::setw(7) << counts[b] << " " << std::string( (counts[b] * 40 + peak - 1) / peak, '#' ) << std::endl;
+	}
+}
+
+LoadGenerator::LoadGenerator( CallControlManagerPtr ccm, StubProxy & proxy, const Options & options )
+: ccm(ccm),
+  proxy(proxy),
+  options(options),
+  nextId(0),
+  started(0),
+  completed(0),
+  failed(0),
+  cpuUsec(0),
+  elapsedSec(0)
+{
+}
+
+const char * LoadGenerator::toString( Scenario scenario )
+{
+	switch (scenario)
+	{
+	case BASIC: return "basic";
+	case HOLD_RESUME: return "hold";
+	case TRANSFER: return "transfer";
+	case INBOUND: return "inbound";
+	}
+	return "?";
+}
+
+const char * LoadGenerator::toString( Phase phase )
+{
+	switch (phase)
+	{
+	case DIALING: return "dialing";
+	case RINGING: return "ringing";
+	case TALKING: return "talking";
+	case HOLDING: return "holding";
+	case HELD: return "held";
+	case RESUMING: return "resuming";
+	case CONSULTING: return "consulting";
+	case TRANSFERRING: return "transferring";
+	case RELEASING: return "releasing";
+	case CLOSING: return "closing";
+	}
+	return "?";
+}
+
+void LoadGenerator::onCallEvent( ccapi_call_event_e callEvent, CC_CallPtr call, CC_CallInfoPtr info, char* sdp )
+{
+	if (callEvent != CCAPI_CALL_EV_STATE || info == NULL)
+	{
+		return;
+	}
+
+	Event event;
+	event.call = call;
+	event.state = info->getCallState();
+
+	base::AutoLock lk( lock );
+	events.push_back( event );
+}
+
+void LoadGenerator::run()
+{
+	device = ccm->getActiveDevice();
+	if (device == NULL)
+	{
+		CSFLogErrorS( logTag, "No active device" );
+		return;
+	}
+
+	begin = base::TimeTicks::Now();
+	base::TimeTicks last = begin;
+	base::TimeTicks end = begin + base::TimeDelta::FromSeconds( options.durationSec );
+	base::TimeTicks drainEnd = end + base::TimeDelta::FromMilliseconds( 4 * (options.talkMs + options.timeoutMs) );
+	long long cpuStart = cpuNow();
+	double credit = 0;
+
+	for (;;)
+	{
+		base::TimeTicks now = base::TimeTicks::Now();
+
+		processEvents( now );
+		runTimers( now );
+
+		if (now < end)
+		{
+			double elapsed = (now - begin).InSecondsF();
+			double ramp = (options.rampSec > 0) ? std::min( 1.0, elapsed / options.rampSec ) : 1.0;
+			double rate = options.startRate + (options.maxRate - options.startRate) * ramp;
+
+			current().rate = rate;
+			credit += rate * (now - last).InSecondsF();
+			while (credit >= 1 && (int) calls.size() < options.maxConcurrent)
+			{
+				startCall( now );
+				credit -= 1;
+			}
+			// At the concurrency cap, do not bank calls for later.
+			credit = std::min( credit, 1.0 );
+			current().peakActive = std::max( current().peakActive, calls.size() );
+		}
+		else if (calls.empty() || now >= drainEnd)
+		{
+			break;
+		}
+
+		last = now;
+		base::PlatformThread::Sleep( TICK_MS );
+	}
+
+	for (std::map<int, Call>::iterator it = calls.begin(); it != calls.end(); ++it)
+	{
+		failures[std::string( "stuck " ) + toString( it->second.phase )]++;
+		failed++;
+	}
+
+	cpuUsec = cpuNow() - cpuStart;
+	elapsedSec = (base::TimeTicks::Now() - begin).InSecondsF();
+}
+
+LoadGenerator::Interval & LoadGenerator::current()
+{
+	size_t index = (size_t) ((base::TimeTicks::Now() - begin).InSeconds() / std::max( 1, options.intervalSec ));
+	if (intervals.size() <= index)
+	{
+		Interval blank;
+		blank.rate = 0;
+		blank.started = 0;
+		blank.completed = 0;
+		blank.failed = 0;
+		blank.peakActive = 0;
+		intervals.resize( index + 1, blank );
+	}
+	return intervals[index];
+}
+
+void LoadGenerator::track( Call & c, const CC_CallPtr & call )
+{
+	byHandle[call.get()] = c.id;
+}
+
+void LoadGenerator::startCall( base::TimeTicks now )
+{
+	Call & c = calls[++nextId];
+	c.id = nextId;
+	c.phase = DIALING;
+	c.resumed = false;
+	c.callDone = false;
+	c.consultDone = true;
+	c.started = now;
+	c.deadline = now + base::TimeDelta::FromMilliseconds( options.timeoutMs );
+
+	started++;
+	current().started++;
+
+	if (options.scenario == INBOUND)
+	{
+		c.phase = RINGING;
+		if (proxy.placeCall( "sipload" ).empty())
+		{
+			finish( c, "stub not registered", now );
+			close( c, now );
+			return;
+		}
+		inboundWaiting.push_back( c.id );
+		return;
+	}
+
+	c.call = device->createCall();
+	if (c.call == NULL)
+	{
+		finish( c, "createCall failed", now );
+		close( c, now );
+		return;
+	}
+	track( c, c.call );
+	if (!c.call->originateCall( CC_SDP_DIRECTION_SENDRECV, options.target, (char *) "", 0, 0 ))
+	{
+		// the call was never offered, so no ONHOOK will follow
+		c.callDone = true;
+		finish( c, "originate rejected", now );
+		close( c, now );
+	}
+}
+
+void LoadGenerator::processEvents( base::TimeTicks now )
+{
+	std::deque<Event> pending;
+	{
+		base::AutoLock lk( lock );
+		pending.swap( events );
+	}
+
+	for (std::deque<Event>::iterator ev = pending.begin(); ev != pending.end(); ++ev)
+	{
+		std::map<CC_Call *, int>::iterator h = byHandle.find( ev->call.get() );
+		if (h == byHandle.end())
+		{
+			if (ev->state != RINGIN || inboundWaiting.empty())
+			{
+				continue;
+			}
+			// Inbound calls are matched to the stub's INVITEs in order.
+			Call & c = calls[inboundWaiting.front()];
+			inboundWaiting.pop_front();
+			c.call = ev->call;
+			track( c, c.call );
+			h = byHandle.find( ev->call.get() );
+		}
+
+		std::map<int, Call>::iterator it = calls.find( h->second );
+		if (it == calls.end())
+		{
+			byHandle.erase( h );
+			continue;
+		}
+
+		Call & c = it->second;
+		onState( c, c.consult.get() == ev->call.get(), ev->state, now );
+	}
+}
+
+void LoadGenerator::onState( Call & c, bool consultLeg, cc_call_state_t state, base::TimeTicks now )
+{
+	base::TimeDelta timeout = base::TimeDelta::FromMilliseconds( options.timeoutMs );
+
+	switch (state)
+	{
+	case RINGIN:
+		if (c.phase == RINGING && !c.call->answerCall( CC_SDP_DIRECTION_SENDRECV ))
+		{
+			finish( c, "answer rejected", now );
+		}
+		break;
+
+	case CONNECTED:
+		if (consultLeg)
+		{
+			if (c.phase == CONSULTING)
+			{
+				if (c.call->directTransfer( c.consult ))
+				{
+					c.phase = TRANSFERRING;
+					c.deadline = now + timeout;
+				}
+				else
+				{
+					finish( c, "transfer rejected", now );
+				}
+			}
+		}
+		else if (c.phase == DIALING || c.phase == RINGING)
+		{
+			double ms = (now - c.started).InMillisecondsF();
+			setup.add( ms );
+			current().setup.add( ms );
+			c.phase = TALKING;
+			c.deadline = now + base::TimeDelta::FromMilliseconds( options.talkMs );
+		}
+		else if (c.phase == RESUMING)
+		{
+			c.phase = TALKING;
+			c.resumed = true;
+			c.deadline = now + base::TimeDelta::FromMilliseconds( options.talkMs );
+		}
+		break;
+
+	case HOLD:
+		if (!consultLeg && c.phase == HOLDING)
+		{
+			if (options.scenario == TRANSFER)
+			{
+				c.consult = device->createCall();
+				if (c.consult == NULL)
+				{
+					finish( c, "createCall failed", now );
+					break;
+				}
+				c.consultDone = false;
+				track( c, c.consult );
+				if (!c.consult->originateCall( CC_SDP_DIRECTION_SENDRECV, options.transferTarget, (char *) "", 0, 0 ))
+				{
+					finish( c, "consult originate rejected", now );
+					break;
+				}
+				c.phase = CONSULTING;
+				c.deadline = now + timeout;
+			}
+			else
+			{
+				c.phase = HELD;
+				c.deadline = now + base::TimeDelta::FromMilliseconds( options.talkMs );
+			}
+		}
+		break;
+
+	case BUSY:
+		finish( c, "busy", now );
+		break;
+
+	case REORDER:
+		finish( c, "reorder", now );
+		break;
+
+	case ONHOOK:
+		if (consultLeg)
+		{
+			c.consultDone = true;
+		}
+		else
+		{
+			c.callDone = true;
+		}
+
+		if (c.phase == RELEASING || c.phase == TRANSFERRING)
+		{
+			if (c.callDone && c.consultDone)
+			{
+				finish( c, NULL, now );
+			}
+		}
+		else if (c.phase != CLOSING)
+		{
+			std::string reason = std::string( "released while " ) + toString( c.phase );
+			finish( c, reason.c_str(), now );
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	close( c, now );
+}
+
+void LoadGenerator::runTimers( base::TimeTicks now )
+{
+	std::vector<int> due;
+	for (std::map<int, Call>::iterator it = calls.begin(); it != calls.end(); ++it)
+	{
+		if (it->second.deadline <= now)
+		{
+			due.push_back( it->first );
+		}
+	}
+
+	base::TimeDelta timeout = base::TimeDelta::FromMilliseconds( options.timeoutMs );
+
+	for (size_t i = 0; i < due.size(); i++)
+	{
+		std::map<int, Call>::iterator it = calls.find( due[i] );
+		if (it == calls.end())
+		{
+			continue;
+		}
+
+		Call & c = it->second;
+		switch (c.phase)
+		{
+		case TALKING:
+			if ((options.scenario == HOLD_RESUME && !c.resumed) || (options.scenario == TRANSFER && c.consult == NULL))
+			{
+				if (!c.call->hold( CC_HOLD_REASON_NONE ))
+				{
+					finish( c, "hold rejected", now );
+					break;
+				}
+				c.phase = HOLDING;
+			}
+			else
+			{
+				c.call->endCall();
+				c.phase = RELEASING;
+			}
+			c.deadline = now + timeout;
+			break;
+
+		case HELD:
+			if (!c.call->resume( CC_SDP_DIRECTION_SENDRECV ))
+			{
+				finish( c, "resume rejected", now );
+				break;
+			}
+			c.phase = RESUMING;
+			c.deadline = now + timeout;
+			break;
+
+		case CLOSING:
+			// Legs that never reported ONHOOK are given up on.
+			c.callDone = true;
+			c.consultDone = true;
+			break;
+
+		default:
+		{
+			std::string reason = std::string( "timeout while " ) + toString( c.phase );
+			finish( c, reason.c_str(), now );
+			break;
+		}
+		}
+
+		close( c, now );
+	}
+}
+
+// Records the result and hangs up whatever is still up. NULL means success.
+void LoadGenerator::finish( Call & c, const char * failure, base::TimeTicks now )
+{
+	if (c.phase == CLOSING)
+	{
+		return;
+	}
+
+	if (failure == NULL)
+	{
+		completed++;
+		current().completed++;
+	}
+	else
+	{
+		CSFLogDebugS( logTag, "call " << c.id << " failed: " << failure );
+		failures[failure]++;
+		failed++;
+		current().failed++;
+	}
+
+	c.phase = CLOSING;
+	c.deadline = now + base::TimeDelta::FromMilliseconds( options.timeoutMs );
+
+	if (c.call == NULL)
+	{
+		c.callDone = true;
+	}
+	if (!c.callDone)
+	{
+		c.call->endCall();
+	}
+	if (!c.consultDone)
+	{
+		c.consult->endCall();
+	}
+}
+
+// Forgets a finished call once none of its legs is up.
+void LoadGenerator::close( Call & c, base::TimeTicks now )
+{
+	if (c.phase != CLOSING || !c.callDone || !c.consultDone)
+	{
+		return;
+	}
+
+	if (c.call != NULL)
+	{
+		byHandle.erase( c.call.get() );
+	}
+	if (c.consult != NULL)
+	{
+		byHandle.erase( c.consult.get() );
+	}
+	std::deque<int>::iterator waiting = std::find( inboundWaiting.begin(), inboundWaiting.end(), c.id );
+	if (waiting != inboundWaiting.end())
+	{
+		inboundWaiting.erase( waiting );
+	}
+	calls.erase( c.id );
+}
+
+void LoadGenerator::report( std::ostream & os )
+{
+	os << "scenario " << toString( options.scenario ) << ", " << options.startRate << " -> " << options.maxRate
+	   << " calls/s over " << options.rampSec << " s, at most " << options.maxConcurrent << " in progress, "
+	   << options.durationSec << " s" << std::endl << std::endl;
+
+	os << "   t(s)  rate  started  completed  failed  peak  setup p50   p99" << std::endl;
+	for (size_t i = 0; i < intervals.size(); i++)
+	{
+		Interval & row = intervals[i];
+		os << std::fixed << std::setprecision(1)
+		   << std::setw(7) << (double) (i * std::max( 1, options.intervalSec ))
+		   << std::setw(6) << row.rate
+		   << std::setw(9) << row.started
+		   << std::setw(11) << row.completed
+		   << std::setw(8) << row.failed
+		   << std::setw(6) << row.peakActive
+		   << std::setw(11) << row.setup.percentile( 50 )
+		   << std::setw(6) << row.setup.percentile( 99 ) << std::endl;
+	}
+
+	os << std::endl << "calls started " << started << ", completed " << completed << ", failed " << failed << std::endl;
+	for (std::map<std::string, int>::iterator it = failures.begin(); it != failures.end(); ++it)
+	{
+		os << "  " << std::setw(7) << it->second << "  " << it->first << std::endl;
+	}
+
+	os << std::endl << "setup latency (ms): n " << setup.count()
+	   << ", p50 " << setup.percentile( 50 ) << ", p90 " << setup.percentile( 90 )
+	   << ", p99 " << setup.percentile( 99 ) << ", max " << setup.max() << std::endl;
+	setup.print( os );
+
+	int finished = completed + failed;
+	os << std::endl << "CPU " << cpuUsec / 1000 << " ms over " << elapsedSec << " s";
+	if (finished > 0)
+	{
+		os << ", " << (double) cpuUsec / finished / 1000.0 << " ms per call, stub proxy included";
+	}
+	os << std::endl;
+}
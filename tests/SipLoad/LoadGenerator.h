@@ -0,0 +1,199 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CC_Call.h"
+#include "CC_Observer.h"
+#include "ECC_Observer.h"
+#include "CallControlManager.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+
+class StubProxy;
+
+// Latency samples in milliseconds; keeps every sample so percentiles are exact.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram() : sorted(true) {}
+
+	void add( double ms );
+	size_t count() const { return samples.size(); }
+	double percentile( double p );
+	double max();
+	// One line per bucket: 1, 2, 5, 10, 20, 50 ms and so on.
+	void print( std::ostream & os );
+
+private:
+	std::vector<double> samples;
+	bool sorted;
+};
+
+/*
+ * Drives calls through CallControlManager at a ramped rate and measures them.
+ *
+ * Calls are started at a rate that rises linearly from startRate to maxRate
+ * over rampSec, never with more than maxConcurrent in progress. Each call
+ * runs one scenario:
+ *
+ *  - basic:    dial, talk for talkMs, hang up.
+ *  - hold:     dial, talk, hold, resume after talkMs, talk again, hang up.
+ *  - transfer: dial, talk, hold, dial the transfer target, transfer the
+ *              first call to it once it answers.
+ *  - inbound:  the stub proxy calls the phone, the phone answers, talks and
+ *              hangs up.
+ *
+ * Setup latency is from the dial (or from the stub's INVITE for inbound) to
+ * CONNECTED. A call fails if it is released early, gets busy or reorder, or
+ * stays in any step for longer than timeoutMs.
+ *
+ * Call events arrive on the stack's thread and are queued; everything else
+ * runs on the thread that calls run().
+ */
+class LoadGenerator : public CSF::CC_Observer, public CSF::ECC_Observer
+{
+public:
+	enum Scenario { BASIC, HOLD_RESUME, TRANSFER, INBOUND };
+
+	struct Options
+	{
+		Scenario scenario;
+		int maxConcurrent;
+		double startRate;		// calls per second
+		double maxRate;
+		int rampSec;
+		int durationSec;
+		int intervalSec;		// report row length
+		int talkMs;
+		int timeoutMs;
+		std::string target;
+		std::string transferTarget;
+	};
+
+	LoadGenerator( CSF::CallControlManagerPtr ccm, StubProxy & proxy, const Options & options );
+
+	// Runs for durationSec, then waits for the calls in progress to finish.
+	void run();
+	void report( std::ostream & os );
+	int getFailed() const { return failed; }
+
+	virtual void onDeviceEvent( ccapi_device_event_e deviceEvent, CSF::CC_DevicePtr device, CSF::CC_DeviceInfoPtr info ) {}
+	virtual void onFeatureEvent( ccapi_device_event_e deviceEvent, CSF::CC_DevicePtr device, CSF::CC_FeatureInfoPtr feature_info ) {}
+	virtual void onLineEvent( ccapi_line_event_e lineEvent, CSF::CC_LinePtr line, CSF::CC_LineInfoPtr info ) {}
+	virtual void onCallEvent( ccapi_call_event_e callEvent, CSF::CC_CallPtr call, CSF::CC_CallInfoPtr info, char* sdp );
+
+	virtual void onAvailablePhoneEvent( CSF::AvailablePhoneEventType::AvailablePhoneEvent event, const CSF::PhoneDetailsPtr phoneDetails ) {}
+	virtual void onAuthenticationStatusChange( CSF::AuthenticationStatusEnum::AuthenticationStatus ) {}
+	virtual void onConnectionStatusChange( CSF::ConnectionStatusEnum::ConnectionStatus status ) {}
+
+	static const char * toString( Scenario scenario );
+
+private:
+	enum Phase { DIALING, RINGING, TALKING, HOLDING, HELD, RESUMING, CONSULTING, TRANSFERRING, RELEASING, CLOSING };
+
+	struct Call
+	{
+		int id;
+		CSF::CC_CallPtr call;
+		CSF::CC_CallPtr consult;
+		Phase phase;
+		bool resumed;
+		bool callDone;
+		bool consultDone;
+		base::TimeTicks started;
+		base::TimeTicks deadline;
+	};
+
+	struct Event
+	{
+		CSF::CC_CallPtr call;
+		cc_call_state_t state;
+	};
+
+	struct Interval
+	{
+		double rate;
+		int started;
+		int completed;
+		int failed;
+		size_t peakActive;
+		LatencyHistogram setup;
+	};
+
+	void startCall( base::TimeTicks now );
+	void processEvents( base::TimeTicks now );
+	void onState( Call & c, bool consultLeg, cc_call_state_t state, base::TimeTicks now );
+	void runTimers( base::TimeTicks now );
+	void track( Call & c, const CSF::CC_CallPtr & call );
+	void finish( Call & c, const char * failure, base::TimeTicks now );
+	void close( Call & c, base::TimeTicks now );
+	Interval & current();
+
+	static const char * toString( Phase phase );
+
+	CSF::CallControlManagerPtr ccm;
+	StubProxy & proxy;
+	Options options;
+	CSF::CC_DevicePtr device;
+
+	int nextId;
+	std::map<int, Call> calls;
+	std::map<CSF::CC_Call *, int> byHandle;
+	std::deque<int> inboundWaiting;		// placed by the stub, not yet seen as RINGIN
+
+	base::TimeTicks begin;
+	std::vector<Interval> intervals;
+	LatencyHistogram setup;
+	int started;
+	int completed;
+	int failed;
+	std::map<std::string, int> failures;
+	long long cpuUsec;
+	double elapsedSec;
+
+	base::Lock lock;
+	std::deque<Event> events;
+};
@@ -0,0 +1,738 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include "StubProxy.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "CSFLogStream.h"
+
+static const char* logTag = "StubProxy";
+
+static const int MAX_DATAGRAM = 8192;
+static const int POLL_MS = 20;
+
+/* Message helpers. Header names compare without case; compact forms are accepted. */
+
+static std::string trim( const std::string & s )
+{
+	size_t b = s.find_first_not_of( " \t" );
+	size_t e = s.find_last_not_of( " \t\r" );
+	return (b == std::string::npos) ? std::string() : s.substr( b, e - b + 1 );
+}
+
+static std::vector<std::string> headerLines( const std::string & msg, const char * name, const char * compact )
+{
+	std::vector<std::string> lines;
+	size_t pos = msg.find( "\r\n" );
+
+	while (pos != std::string::npos)
+	{
+		pos += 2;
+		size_t end = msg.find( "\r\n", pos );
+		if (end == std::string::npos || end == pos)
+		{
+			break;
+		}
+
+		std::string line = msg.substr( pos, end - pos );
+		size_t colon = line.find( ':' );
+		if (colon != std::string::npos)
+		{
+			std::string field = trim( line.substr( 0, colon ) );
+			if (strcasecmp( field.c_str(), name ) == 0 || (compact != NULL && strcasecmp( field.c_str(), compact ) == 0))
+			{
+				lines.push_back( line );
+			}
+		}
+		pos = end;
+	}
+	return lines;
+}
+
+static std::string headerValue( const std::string & msg, const char * name, const char * compact )
+{
+	std::vector<std::string> lines = headerLines( msg, name, compact );
+	if (lines.empty())
+	{
+		return "";
+	}
+	return trim( lines[0].substr( lines[0].find( ':' ) + 1 ) );
+}
+
+static std::string bodyOf( const std::string & msg )
+{
+	size_t pos = msg.find( "\r\n\r\n" );
+	return (pos == std::string::npos) ? std::string() : msg.substr( pos + 4 );
+}
+
+static std::string paramOf( const std::string & value, const char * name )
+{
+	std::string key = std::string( ";" ) + name + "=";
+	size_t pos = value.find( key );
+	if (pos == std::string::npos)
+	{
+		return "";
+	}
+	pos += key.size();
+	return value.substr( pos, value.find_first_of( ";>, ", pos ) - pos );
+}
+
+// The URI of a name-addr, or of an addr-spec up to its parameters.
+static std::string uriOf( const std::string & value )
+{
+	size_t lt = value.find( '<' );
+	if (lt != std::string::npos)
+	{
+		return value.substr( lt + 1, value.find( '>', lt ) - lt - 1 );
+	}
+	return trim( value.substr( 0, value.find( ';' ) ) );
+}
+
+static bool resolve( const std::string & host, int port, sockaddr_in & addr )
+{
+	memset( &addr, 0, sizeof(addr) );
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons( port );
+	return inet_pton( AF_INET, host.c_str(), &addr.sin_addr ) == 1;
+}
+
+static bool hostPort( const std::string & hp, sockaddr_in & addr )
+{
+	std::string s = hp.substr( 0, hp.find_first_of( ";>?" ) );
+	size_t colon = s.find( ':' );
+	int port = 5060;
+
+	if (colon != std::string::npos)
+	{
+		port = atoi( s.c_str() + colon + 1 );
+		s.erase( colon );
+	}
+	return resolve( s, port, addr );
+}
+
+static bool uriAddr( const std::string & uri, sockaddr_in & addr )
+{
+	std::string s = uri;
+	if (s.compare( 0, 4, "sip:" ) == 0)
+	{
+		s.erase( 0, 4 );
+	}
+	size_t at = s.find( '@' );
+	if (at != std::string::npos)
+	{
+		s.erase( 0, at + 1 );
+	}
+	return hostPort( s, addr );
+}
+
+// "SIP/2.0/UDP host:port;branch=..."
+static bool viaAddr( const std::string & via, sockaddr_in & addr )
+{
+	std::string value = trim( via.substr( via.find( ':' ) + 1 ) );
+	size_t sp = value.find( ' ' );
+	return sp != std::string::npos && hostPort( trim( value.substr( sp + 1 ) ), addr );
+}
+
+static std::string unescape( const std::string & s )
+{
+	std::string out;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '%' && i + 2 < s.size())
+		{
+			out += (char) strtol( s.substr( i + 1, 2 ).c_str(), NULL, 16 );
+			i += 2;
+		}
+		else
+		{
+			out += s[i];
+		}
+	}
+	return out;
+}
+
+static std::string toString( unsigned int n )
+{
+	char buf[16];
+	snprintf( buf, sizeof(buf), "%u", n );
+	return buf;
+}
+
+StubProxy::StubProxy()
+: sock(-1),
+  localPort(0),
+  stopping(false),
+  ringDelayMs(0),
+  nextId(0),
+  nextMediaPort(40000),
+  cpuUsec(0),
+  registered(false),
+  thread(NULL)
+{
+	memset( &stats, 0, sizeof(stats) );
+	memset( &contactAddr, 0, sizeof(contactAddr) );
+}
+
+StubProxy::~StubProxy()
+{
+	stop();
+}
+
+bool StubProxy::start( const std::string & ip, int port )
+{
+	sockaddr_in addr;
+	if (thread != NULL || !resolve( ip, port, addr ))
+	{
+		return false;
+	}
+
+	sock = socket( AF_INET, SOCK_DGRAM, 0 );
+	if (sock < 0)
+	{
+		CSFLogErrorS( logTag, "socket() failed, errno " << errno );
+		return false;
+	}
+	if (bind( sock, (sockaddr *) &addr, sizeof(addr) ) != 0)
+	{
+		CSFLogErrorS( logTag, "bind(" << ip << ":" << port << ") failed, errno " << errno );
+		close( sock );
+		sock = -1;
+		return false;
+	}
+
+	localIp = ip;
+	localPort = port;
+	stopping = false;
+	thread = new base::DelegateSimpleThread( this, "StubProxy" );
+	thread->Start();
+	CSFLogInfoS( logTag, "Listening on " << ip << ":" << port );
+	return true;
+}
+
+void StubProxy::stop()
+{
+	if (thread == NULL)
+	{
+		return;
+	}
+	{
+		base::AutoLock lk( lock );
+		stopping = true;
+	}
+	thread->Join();
+	delete thread;
+	thread = NULL;
+	close( sock );
+	sock = -1;
+}
+
+void StubProxy::setRingDelayMs( int ms )
+{
+	base::AutoLock lk( lock );
+	ringDelayMs = ms;
+}
+
+StubProxy::Stats StubProxy::getStats()
+{
+	base::AutoLock lk( lock );
+	return stats;
+}
+
+long long StubProxy::getCpuUsec()
+{
+	base::AutoLock lk( lock );
+	return cpuUsec;
+}
+
+void StubProxy::Run()
+{
+	char buf[MAX_DATAGRAM];
+
+	for (;;)
+	{
+		{
+			base::AutoLock lk( lock );
+			if (stopping)
+			{
+				break;
+			}
+			runTimers();
+		}
+
+		pollfd pfd;
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll( &pfd, 1, POLL_MS ) <= 0)
+		{
+			continue;
+		}
+
+		sockaddr_in from;
+		socklen_t fromLen = sizeof(from);
+		int len = recvfrom( sock, buf, sizeof(buf) - 1, 0, (sockaddr *) &from, &fromLen );
+		if (len > 0)
+		{
+			base::AutoLock lk( lock );
+			handle( buf, len, from );
+		}
+	}
+
+#ifdef RUSAGE_THREAD
+	rusage usage;
+	if (getrusage( RUSAGE_THREAD, &usage ) == 0)
+	{
+		base::AutoLock lk( lock );
+		cpuUsec = (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+				usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+	}
+#endif
+}
+
+void StubProxy::handle( const char * buf, int len, const sockaddr_in & from )
+{
+	std::string msg( buf, len );
+	size_t eol = msg.find( "\r\n" );
+
+	if (eol == std::string::npos || headerValue( msg, "Call-ID", "i" ).empty())
+	{
+		stats.malformed++;
+		return;
+	}
+
+	std::string first = msg.substr( 0, eol );
+	if (first.compare( 0, 8, "SIP/2.0 " ) == 0)
+	{
+		stats.responses++;
+		handleResponse( msg, atoi( first.c_str() + 8 ) );
+	}
+	else
+	{
+		handleRequest( msg, first.substr( 0, first.find( ' ' ) ), from );
+	}
+}
+
+void StubProxy::handleRequest( const std::string & msg, const std::string & method, const sockaddr_in & from )
+{
+	std::string callId = headerValue( msg, "Call-ID", "i" );
+
+	if (method == "INVITE")
+	{
+		handleInvite( msg, from );
+	}
+	else if (method == "ACK")
+	{
+		stats.acks++;
+	}
+	else if (method == "REGISTER")
+	{
+		stats.registers++;
+		std::string contactValue = headerValue( msg, "Contact", "m" );
+		std::string expires = paramOf( contactValue, "expires" );
+		if (expires.empty())
+		{
+			expires = headerValue( msg, "Expires", NULL );
+		}
+		if (expires.empty())
+		{
+			expires = "3600";
+		}
+
+		if (atoi( expires.c_str() ) == 0)
+		{
+			registered = false;
+		}
+		else if (uriAddr( uriOf( contactValue ), contactAddr ))
+		{
+			contact = uriOf( contactValue );
+			registered = true;
+		}
+		respond( msg, 200, "OK", makeTag(),
+				"Contact: <" + uriOf( contactValue ) + ">;expires=" + expires + "\r\nExpires: " + expires + "\r\n", "" );
+	}
+	else if (method == "CANCEL")
+	{
+		stats.cancels++;
+		respond( msg, 200, "OK", "", "", "" );
+
+		std::map<std::string, Dialog>::iterator it = dialogs.find( callId );
+		if (it != dialogs.end() && !it->second.uac && !it->second.answered)
+		{
+			respond( it->second.invite, 487, "Request Terminated", it->second.localTag, "", "" );
+			dialogs.erase( it );
+		}
+	}
+	else if (method == "BYE")
+	{
+		stats.byes++;
+		respond( msg, 200, "OK", "", "", "" );
+		dialogs.erase( callId );
+	}
+	else if (method == "REFER")
+	{
+		handleRefer( msg, from );
+	}
+	else
+	{
+		stats.others++;
+		std::string extra;
+		if (method == "SUBSCRIBE")
+		{
+			std::string expires = headerValue( msg, "Expires", NULL );
+			extra = "Expires: " + (expires.empty() ? std::string( "0" ) : expires) + "\r\n";
+		}
+		respond( msg, 200, "OK", makeTag(), extra, "" );
+	}
+}
+
+void StubProxy::handleInvite( const std::string & msg, const sockaddr_in & from )
+{
+	std::string callId = headerValue( msg, "Call-ID", "i" );
+	std::string to = headerValue( msg, "To", "t" );
+	std::map<std::string, Dialog>::iterator it = dialogs.find( callId );
+	std::string stubContact = "Contact: <sip:stub@" + localIp + ":" + toString( localPort ) + ">\r\n";
+
+	if (!paramOf( to, "tag" ).empty())
+	{
+		stats.reinvites++;
+		if (it == dialogs.end())
+		{
+			respond( msg, 481, "Call/Transaction Does Not Exist", "", "", "" );
+			return;
+		}
+		respond( msg, 200, "OK", "", stubContact + "Content-Type: application/sdp\r\n",
+				makeSdp( it->second, bodyOf( msg ) ) );
+		return;
+	}
+
+	if (it != dialogs.end())
+	{
+		// retransmission
+		respond( msg, 100, "Trying", "", "", "" );
+		return;
+	}
+
+	stats.invites++;
+
+	Dialog & dialog = dialogs[callId];
+	dialog.callId = callId;
+	dialog.localTag = makeTag();
+	dialog.localUri = to + ";tag=" + dialog.localTag;
+	dialog.remoteUri = headerValue( msg, "From", "f" );
+	dialog.target = uriOf( headerValue( msg, "Contact", "m" ) );
+	if (!uriAddr( dialog.target, dialog.targetAddr ))
+	{
+		dialog.targetAddr = from;
+	}
+	dialog.invite = msg;
+	dialog.inviteSdp = bodyOf( msg );
+	dialog.localCSeq = 0;
+	dialog.sdpVersion = 0;
+	dialog.mediaPort = nextMediaPort;
+	dialog.uac = false;
+	dialog.answered = false;
+	dialog.answerAt = base::TimeTicks::Now() + base::TimeDelta::FromMilliseconds( ringDelayMs );
+
+	nextMediaPort = (nextMediaPort >= 60000) ? 40000 : nextMediaPort + 2;
+
+	respond( msg, 100, "Trying", "", "", "" );
+	respond( msg, 180, "Ringing", dialog.localTag, stubContact, "" );
+	ringing.push_back( callId );
+}
+
+void StubProxy::runTimers()
+{
+	base::TimeTicks now = base::TimeTicks::Now();
+
+	while (!ringing.empty())
+	{
+		std::map<std::string, Dialog>::iterator it = dialogs.find( ringing.front() );
+		if (it == dialogs.end() || it->second.answered)
+		{
+			ringing.pop_front();
+			continue;
+		}
+		if (it->second.answerAt > now)
+		{
+			break;
+		}
+
+		Dialog & dialog = it->second;
+		respond( dialog.invite, 200, "OK", dialog.localTag,
+				"Contact: <sip:stub@" + localIp + ":" + toString( localPort ) + ">\r\nContent-Type: application/sdp\r\n",
+				makeSdp( dialog, dialog.inviteSdp ) );
+		dialog.answered = true;
+		dialog.invite.clear();
+		stats.callsAnswered++;
+		ringing.pop_front();
+	}
+}
+
+void StubProxy::handleRefer( const std::string & msg, const sockaddr_in & from )
+{
+	stats.refers++;
+
+	std::string callId = headerValue( msg, "Call-ID", "i" );
+	std::map<std::string, Dialog>::iterator it = dialogs.find( callId );
+	if (it == dialogs.end())
+	{
+		respond( msg, 481, "Call/Transaction Does Not Exist", "", "", "" );
+		return;
+	}
+
+	respond( msg, 202, "Accepted", "", "", "" );
+	sendInDialog( it->second, "NOTIFY",
+			"Event: refer\r\nSubscription-State: terminated;reason=noresource\r\nContent-Type: message/sipfrag\r\n",
+			"SIP/2.0 200 OK\r\n" );
+
+	// Refer-To: <sip:target?Replaces=callid%3Bto-tag%3D...%3Bfrom-tag%3D...>
+	std::string referTo = headerValue( msg, "Refer-To", "r" );
+	size_t pos = referTo.find( "Replaces=" );
+	if (pos != std::string::npos)
+	{
+		pos += 9;
+		std::string replaces = unescape( referTo.substr( pos, referTo.find_first_of( "&>", pos ) - pos ) );
+		std::map<std::string, Dialog>::iterator replaced = dialogs.find( replaces.substr( 0, replaces.find( ';' ) ) );
+		if (replaced != dialogs.end() && replaced != it)
+		{
+			sendInDialog( replaced->second, "BYE", "", "" );
+			dialogs.erase( replaced );
+		}
+	}
+}
+
+void StubProxy::handleResponse( const std::string & msg, int status )
+{
+	std::string cseq = headerValue( msg, "CSeq", NULL );
+	if (cseq.find( "INVITE" ) == std::string::npos || status < 200)
+	{
+		return;
+	}
+
+	std::map<std::string, Dialog>::iterator it = dialogs.find( headerValue( msg, "Call-ID", "i" ) );
+	if (it == dialogs.end() || !it->second.uac)
+	{
+		return;
+	}
+
+	Dialog & dialog = it->second;
+	dialog.remoteUri = headerValue( msg, "To", "t" );
+	if (status < 300)
+	{
+		std::string target = uriOf( headerValue( msg, "Contact", "m" ) );
+		if (!target.empty() && uriAddr( target, dialog.targetAddr ))
+		{
+			dialog.target = target;
+		}
+	}
+
+	sendInDialog( dialog, "ACK", "", "" );
+
+	if (status < 300)
+	{
+		if (!dialog.answered)
+		{
+			dialog.answered = true;
+			stats.callsAnswered++;
+		}
+	}
+	else
+	{
+		dialogs.erase( it );
+	}
+}
+
+std::string StubProxy::placeCall( const std::string & caller )
+{
+	base::AutoLock lk( lock );
+
+	if (!registered || thread == NULL)
+	{
+		return "";
+	}
+
+	std::string callId = "sipload-" + toString( ++nextId ) + "@" + localIp;
+	Dialog & dialog = dialogs[callId];
+	dialog.callId = callId;
+	dialog.localTag = makeTag();
+	dialog.localUri = "<sip:" + caller + "@" + localIp + ">;tag=" + dialog.localTag;
+	dialog.remoteUri = "<" + contact + ">";
+	dialog.target = contact;
+	dialog.targetAddr = contactAddr;
+	dialog.localCSeq = 0;
+	dialog.sdpVersion = 0;
+	dialog.mediaPort = nextMediaPort;
+	dialog.uac = true;
+	dialog.answered = false;
+
+	nextMediaPort = (nextMediaPort >= 60000) ? 40000 : nextMediaPort + 2;
+
+	sendInDialog( dialog, "INVITE", "Content-Type: application/sdp\r\n", makeSdp( dialog, "" ) );
+	stats.callsPlaced++;
+	return callId;
+}
+
+void StubProxy::respond( const std::string & request, int status, const char * reason,
+		const std::string & toTag, const std::string & extra, const std::string & body )
+{
+	std::vector<std::string> vias = headerLines( request, "Via", "v" );
+	std::string to = headerValue( request, "To", "t" );
+	sockaddr_in dest;
+
+	if (vias.empty() || !viaAddr( vias[0], dest ))
+	{
+		stats.malformed++;
+		return;
+	}
+	if (!toTag.empty() && paramOf( to, "tag" ).empty())
+	{
+		to += ";tag=" + toTag;
+	}
+
+	std::string msg = "SIP/2.0 " + toString( status ) + " " + reason + "\r\n";
+	for (size_t i = 0; i < vias.size(); i++)
+	{
+		msg += vias[i] + "\r\n";
+	}
+	msg += "From: " + headerValue( request, "From", "f" ) + "\r\n";
+	msg += "To: " + to + "\r\n";
+	msg += "Call-ID: " + headerValue( request, "Call-ID", "i" ) + "\r\n";
+	msg += "CSeq: " + headerValue( request, "CSeq", NULL ) + "\r\n";
+	msg += "Server: sipload-stub\r\n";
+	msg += extra;
+	msg += "Content-Length: " + toString( body.size() ) + "\r\n\r\n";
+	msg += body;
+
+	sendTo( msg, dest );
+}
+
+void StubProxy::sendInDialog( Dialog & dialog, const std::string & method, const std::string & extra, const std::string & body )
+{
+	// ACK carries the INVITE's sequence number
+	if (method != "ACK")
+	{
+		dialog.localCSeq++;
+	}
+
+	std::string msg = method + " " + dialog.target + " SIP/2.0\r\n";
+	msg += "Via: SIP/2.0/UDP " + localIp + ":" + toString( localPort ) + ";branch=z9hG4bK" + makeTag() + "\r\n";
+	msg += "Max-Forwards: 70\r\n";
+	msg += "From: " + dialog.localUri + "\r\n";
+	msg += "To: " + dialog.remoteUri + "\r\n";
+	msg += "Call-ID: " + dialog.callId + "\r\n";
+	msg += "CSeq: " + toString( dialog.localCSeq ) + " " + method + "\r\n";
+	msg += "Contact: <sip:stub@" + localIp + ":" + toString( localPort ) + ">\r\n";
+	msg += extra;
+	msg += "Content-Length: " + toString( body.size() ) + "\r\n\r\n";
+	msg += body;
+
+	sendTo( msg, dialog.targetAddr );
+}
+
+void StubProxy::sendTo( const std::string & msg, const sockaddr_in & to )
+{
+	if (sendto( sock, msg.data(), msg.size(), 0, (const sockaddr *) &to, sizeof(to) ) < 0)
+	{
+		CSFLogWarnS( logTag, "sendto() failed, errno " << errno );
+		return;
+	}
+	stats.sent++;
+}
+
+// G.711u only, plus telephone-event if offered. The direction mirrors the offer.
+std::string StubProxy::makeSdp( Dialog & dialog, const std::string & offer )
+{
+	std::string dir = "a=sendrecv";
+	if (offer.find( "a=sendonly" ) != std::string::npos)
+	{
+		dir = "a=recvonly";
+	}
+	else if (offer.find( "a=recvonly" ) != std::string::npos)
+	{
+		dir = "a=sendonly";
+	}
+	else if (offer.find( "a=inactive" ) != std::string::npos)
+	{
+		dir = "a=inactive";
+	}
+
+	std::string dtmf = "101";
+	size_t pos = offer.find( " telephone-event/" );
+	if (pos != std::string::npos)
+	{
+		size_t start = offer.rfind( ':', pos ) + 1;
+		dtmf = offer.substr( start, pos - start );
+	}
+	else if (!offer.empty())
+	{
+		dtmf.clear();
+	}
+
+	std::string sdp = "v=0\r\n";
+	sdp += "o=stub " + toString( dialog.mediaPort ) + " " + toString( ++dialog.sdpVersion ) + " IN IP4 " + localIp + "\r\n";
+	sdp += "s=-\r\n";
+	sdp += "c=IN IP4 " + localIp + "\r\n";
+	sdp += "t=0 0\r\n";
+	sdp += "m=audio " + toString( dialog.mediaPort ) + " RTP/AVP 0" + (dtmf.empty() ? "" : " " + dtmf) + "\r\n";
+	sdp += "a=rtpmap:0 PCMU/8000\r\n";
+	if (!dtmf.empty())
+	{
+		sdp += "a=rtpmap:" + dtmf + " telephone-event/8000\r\n";
+		sdp += "a=fmtp:" + dtmf + " 0-15\r\n";
+	}
+	sdp += dir + "\r\n";
+	return sdp;
+}
+
+std::string StubProxy::makeTag()
+{
+	char buf[16];
+	snprintf( buf, sizeof(buf), "%08x", ++nextId * 2654435761u );
+	return buf;
+}
@@ -0,0 +1,163 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+
+/*
+ * Registrar, proxy and far end for the load generator, on one UDP socket.
+ *
+ * Every request the phone sends is answered as if the proxy had routed it
+ * to a well behaved peer:
+ *
+ *  - REGISTER gets 200 with the contact and expiry echoed back.
+ *  - A new INVITE gets 100, then 180 and 200 with an SDP answer once the
+ *    configured ring delay has passed. CANCEL before that gets 200 and 487.
+ *  - A re-INVITE gets 200 with an answer that mirrors the offered direction,
+ *    so hold and resume work.
+ *  - REFER gets 202 and a NOTIFY with a 200 sipfrag. If the Refer-To carries
+ *    Replaces, the replaced dialog is cleared with a BYE, as the transfer
+ *    target would do.
+ *  - BYE and anything else gets 200.
+ *
+ * placeCall() has the stub play the calling side of an inbound call.
+ *
+ * Responses go to the host and port in the top Via, requests to the
+ * dialog's Contact.
+ */
+class StubProxy : public base::DelegateSimpleThread::Delegate
+{
+public:
+	struct Stats
+	{
+		unsigned int registers;
+		unsigned int invites;
+		unsigned int reinvites;
+		unsigned int cancels;
+		unsigned int byes;
+		unsigned int refers;
+		unsigned int acks;
+		unsigned int others;
+		unsigned int responses;
+		unsigned int sent;
+		unsigned int malformed;
+		unsigned int callsPlaced;
+		unsigned int callsAnswered;
+	};
+
+	StubProxy();
+	~StubProxy();
+
+	// Binds ip:port and starts the thread.
+	bool start( const std::string & ip, int port );
+	void stop();
+
+	// Time between 180 and 200 for calls the phone makes.
+	void setRingDelayMs( int ms );
+
+	// Sends an INVITE to the phone's contact from 'caller'. Returns the
+	// Call-ID, or an empty string if the phone has not registered yet.
+	std::string placeCall( const std::string & caller );
+
+	Stats getStats();
+	// CPU time the proxy thread used, in microseconds. Valid after stop().
+	long long getCpuUsec();
+
+	virtual void Run();
+
+private:
+	struct Dialog
+	{
+		std::string callId;
+		std::string localTag;
+		std::string localUri;		// our From/To value, tag included
+		std::string remoteUri;		// their From/To value, tag included
+		std::string target;		// request URI for in-dialog requests
+		sockaddr_in targetAddr;
+		std::string invite;		// pending INVITE, for 487 after CANCEL
+		std::string inviteSdp;
+		unsigned int localCSeq;
+		unsigned int sdpVersion;
+		int mediaPort;
+		bool uac;			// the stub sent the INVITE
+		bool answered;
+		base::TimeTicks answerAt;
+	};
+
+	void handle( const char * buf, int len, const sockaddr_in & from );
+	void handleRequest( const std::string & msg, const std::string & method, const sockaddr_in & from );
+	void handleResponse( const std::string & msg, int status );
+	void handleInvite( const std::string & msg, const sockaddr_in & from );
+	void handleRefer( const std::string & msg, const sockaddr_in & from );
+	void runTimers();
+
+	void respond( const std::string & request, int status, const char * reason,
+			const std::string & toTag, const std::string & extra, const std::string & body );
+	void sendInDialog( Dialog & dialog, const std::string & method, const std::string & extra, const std::string & body );
+	void sendTo( const std::string & msg, const sockaddr_in & to );
+
+	std::string makeSdp( Dialog & dialog, const std::string & offer );
+	std::string makeTag();
+
+	int sock;
+	std::string localIp;
+	int localPort;
+	bool stopping;
+	int ringDelayMs;
+	unsigned int nextId;
+	int nextMediaPort;
+	long long cpuUsec;
+	bool registered;
+	std::string contact;			// phone's registered contact URI
+	sockaddr_in contactAddr;
+	Stats stats;
+	std::map<std::string, Dialog> dialogs;	// by Call-ID
+	std::deque<std::string> ringing;	// Call-IDs waiting for their 200
+	base::Lock lock;
+	base::DelegateSimpleThread * thread;
+};
@@ -0,0 +1,258 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * sipload: call load generator for the softphone stack.
+ *
+ * Registers one device against a stub registrar/proxy on loopback and runs
+ * call scenarios through CallControlManager at a ramped rate, then prints
+ * per-interval throughput, setup latency and failures, and CPU per call.
+ * Media is headless: the null media provider is selected, so no devices or
+ * codecs are opened.
+ *
+ * sipcc holds one device per process. To load the stub with several
+ * endpoints, run one "sipload --proxy-only" and point further sipload
+ * processes at it with --no-proxy, each with its own --local-ip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <string>
+
+#include "CSFLogStream.h"
+#include "CallControlManager.h"
+#include "CC_Device.h"
+#include "CC_DeviceInfo.h"
+#include "ECC_Types.h"
+#include "base/threading/platform_thread.h"
+#include "base/time.h"
+
+#include "LoadGenerator.h"
+#include "StubProxy.h"
+
+using namespace std;
+using namespace CSF;
+
+static const char* logTag = "SipLoad";
+
+static const int REGISTER_WAIT_MS = 10000;
+
+static void usage()
+{
+	cerr << "usage: sipload [options]" << endl
+	     << "  --scenario basic|hold|transfer|inbound   call flow (basic)" << endl
+	     << "  --calls N              calls in progress at most (10)" << endl
+	     << "  --start-rate R         calls per second at the start (1)" << endl
+	     << "  --rate R               calls per second after the ramp (5)" << endl
+	     << "  --ramp S               ramp length in seconds (10)" << endl
+	     << "  --duration S           seconds to start calls for (30)" << endl
+	     << "  --interval S           report row length in seconds (5)" << endl
+	     << "  --talk MS              talk and hold time (1000)" << endl
+	     << "  --timeout MS           longest wait for any step (5000)" << endl
+	     << "  --ring MS              stub ring time before answering (0)" << endl
+	     << "  --target DN            number dialled (1000)" << endl
+	     << "  --transfer-target DN   number the transfer goes to (2000)" << endl
+	     << "  --user DN              line number to register (1001)" << endl
+	     << "  --local-ip IP          phone address, not 127.0.0.1 (127.0.0.2)" << endl
+	     << "  --sip-port P           phone SIP port (5060)" << endl
+	     << "  --proxy-ip IP          stub proxy address (127.0.0.1)" << endl
+	     << "  --proxy-port P         stub proxy port (5070)" << endl
+	     << "  --proxy-only           run the stub proxy alone for --duration seconds" << endl
+	     << "  --no-proxy             use a stub proxy run by another sipload" << endl
+	     << "  --verbose              stack logging on" << endl;
+}
+
+int main( int argc, char** argv )
+{
+	LoadGenerator::Options options;
+	options.scenario = LoadGenerator::BASIC;
+	options.maxConcurrent = 10;
+	options.startRate = 1;
+	options.maxRate = 5;
+	options.rampSec = 10;
+	options.durationSec = 30;
+	options.intervalSec = 5;
+	options.talkMs = 1000;
+	options.timeoutMs = 5000;
+	options.target = "1000";
+	options.transferTarget = "2000";
+
+	string user = "1001";
+	string localIp = "127.0.0.2";
+	string proxyIp = "127.0.0.1";
+	string sipPort = "5060";
+	string proxyPort = "5070";
+	int ringMs = 0;
+	bool proxyOnly = false;
+	bool noProxy = false;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		const char * value = hasValue ? argv[i + 1] : "";
+
+		if (arg == "--proxy-only") { proxyOnly = true; continue; }
+		if (arg == "--no-proxy") { noProxy = true; continue; }
+		if (arg == "--verbose") { verbose = true; continue; }
+		if (!hasValue)
+		{
+			usage();
+			return 2;
+		}
+		i++;
+
+		if (arg == "--scenario")
+		{
+			string s = value;
+			if (s == "basic") options.scenario = LoadGenerator::BASIC;
+			else if (s == "hold") options.scenario = LoadGenerator::HOLD_RESUME;
+			else if (s == "transfer") options.scenario = LoadGenerator::TRANSFER;
+			else if (s == "inbound") options.scenario = LoadGenerator::INBOUND;
+			else { usage(); return 2; }
+		}
+		else if (arg == "--calls") options.maxConcurrent = atoi( value );
+		else if (arg == "--start-rate") options.startRate = atof( value );
+		else if (arg == "--rate") options.maxRate = atof( value );
+		else if (arg == "--ramp") options.rampSec = atoi( value );
+		else if (arg == "--duration") options.durationSec = atoi( value );
+		else if (arg == "--interval") options.intervalSec = atoi( value );
+		else if (arg == "--talk") options.talkMs = atoi( value );
+		else if (arg == "--timeout") options.timeoutMs = atoi( value );
+		else if (arg == "--ring") ringMs = atoi( value );
+		else if (arg == "--target") options.target = value;
+		else if (arg == "--transfer-target") options.transferTarget = value;
+		else if (arg == "--user") user = value;
+		else if (arg == "--local-ip") localIp = value;
+		else if (arg == "--sip-port") sipPort = value;
+		else if (arg == "--proxy-ip") proxyIp = value;
+		else if (arg == "--proxy-port") proxyPort = value;
+		else { usage(); return 2; }
+	}
+
+	if (noProxy && (proxyOnly || options.scenario == LoadGenerator::INBOUND))
+	{
+		cerr << "--no-proxy cannot be used with --proxy-only or the inbound scenario" << endl;
+		return 2;
+	}
+
+	// Headless media: the null provider opens no devices.
+	setenv( "CSF_MEDIA_PROVIDER", "null", 1 );
+
+	StubProxy proxy;
+	proxy.setRingDelayMs( ringMs );
+	if (!noProxy && !proxy.start( proxyIp, atoi( proxyPort.c_str() ) ))
+	{
+		cerr << "cannot start the stub proxy on " << proxyIp << ":" << proxyPort << endl;
+		return 1;
+	}
+
+	if (proxyOnly)
+	{
+		base::PlatformThread::Sleep( options.durationSec * 1000 );
+		proxy.stop();
+		StubProxy::Stats stats = proxy.getStats();
+		cout << "stub proxy: " << stats.registers << " REGISTER, " << stats.invites << " INVITE, "
+		     << stats.byes << " BYE, CPU " << proxy.getCpuUsec() / 1000 << " ms" << endl;
+		return 0;
+	}
+
+	CallControlManagerPtr ccm = CallControlManager::create();
+	LoadGenerator generator( ccm, proxy, options );
+	ccm->addCCObserver( &generator );
+	ccm->addECCObserver( &generator );
+	ccm->setLocalIpAddressAndGateway( localIp, "" );
+	ccm->setSIPCCLoggingMask( verbose ? (GSM_DEBUG_BIT | FIM_DEBUG_BIT | SIP_DEBUG_MSG_BIT | CC_APP_DEBUG_BIT) : 0 );
+	ccm->setProperty( ConfigPropertyKeysEnum::eLocalVoipPort, sipPort );
+	ccm->setProperty( ConfigPropertyKeysEnum::eRemoteVoipPort, proxyPort );
+	string transport = "udp";
+	ccm->setProperty( ConfigPropertyKeysEnum::eTransport, transport );
+
+	base::TimeTicks registerStart = base::TimeTicks::Now();
+	bool inService = false;
+	if (ccm->registerUser( "sipload", user, "", proxyIp ))
+	{
+		for (int waited = 0; waited < REGISTER_WAIT_MS; waited += 10)
+		{
+			CC_DevicePtr device = ccm->getActiveDevice();
+			if (device != NULL && device->getDeviceInfo()->getServiceState() == CC_STATE_INS)
+			{
+				inService = true;
+				break;
+			}
+			base::PlatformThread::Sleep( 10 );
+		}
+	}
+
+	int result = 1;
+	if (!inService)
+	{
+		cerr << "device did not come into service" << endl;
+	}
+	else
+	{
+		cout << "registered in " << (base::TimeTicks::Now() - registerStart).InMillisecondsF() << " ms" << endl;
+		CSFLogInfoS( logTag, "Starting " << LoadGenerator::toString( options.scenario ) << " load" );
+		generator.run();
+		generator.report( cout );
+		result = (generator.getFailed() == 0) ? 0 : 1;
+	}
+
+	ccm->removeCCObserver( &generator );
+	ccm->removeECCObserver( &generator );
+	ccm->disconnect();
+	ccm->destroy();
+
+	if (!noProxy)
+	{
+		proxy.stop();
+		StubProxy::Stats stats = proxy.getStats();
+		cout << endl << "stub proxy: " << stats.registers << " REGISTER, " << stats.invites << " INVITE, "
+		     << stats.reinvites << " re-INVITE, " << stats.cancels << " CANCEL, " << stats.byes << " BYE, "
+		     << stats.refers << " REFER, " << stats.acks << " ACK, " << stats.others << " other, "
+		     << stats.responses << " responses, " << stats.malformed << " malformed" << endl;
+		cout << "stub proxy thread CPU " << proxy.getCpuUsec() / 1000 << " ms (part of the total above)" << endl;
+	}
+
+	return result;
+}
@@ -0,0 +1,579 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cpr_ipc.h"
+#include "cpr_timers.h"
+#include "cpr_threads.h"
+#include "cpr_socket.h"
+#include "ccsip_platform_udp.h"
+#include "ccsip_core.h"
+#include "vcm.h"
+#include "config_api.h"
+#include "CSFLog.h"
+#include "replay_shim.h"
+
+extern void fillInSysHeader(void *buffer, uint16_t cmd, uint16_t len,
+                            void *timerMsg);
+
+static int replay_verbose = 0;
+
+/*
+ * Virtual clock
+ *
+ * Running timers are kept on a list sorted by expiry; timers with the same
+ * expiry stay in the order they were started, which is the order the CPR
+ * timer service delivers them in.
+ */
+typedef struct replay_timer_s {
+    const char *name;
+    uint16_t applicationTimerId;
+    uint16_t applicationMsgId;
+    cprMsgQueue_t callBackMsgQueue;
+    void *data;
+    boolean active;
+    uint32_t expires;
+    struct replay_timer_s *next;
+} replay_timer_t;
+
+static uint32_t replay_now = 0;
+static replay_timer_t *replay_running = NULL;
+static uint16_t replay_running_count = 0;
+
+static void
+replay_timer_unlink (replay_timer_t *timer)
+{
+    replay_timer_t **pp;
+
+    for (pp = &replay_running; *pp; pp = &(*pp)->next) {
+        if (*pp == timer) {
+            *pp = timer->next;
+            timer->next = NULL;
+            timer->active = FALSE;
+            replay_running_count--;
+            return;
+        }
+    }
+}
+
+uint32_t
+replay_clock_now (void)
+{
+    return replay_now;
+}
+
+uint16_t
+replay_clock_active_timers (void)
+{
+    return replay_running_count;
+}
+
+uint16_t
+replay_clock_run (uint32_t until)
+{
+    replay_timer_t *timer;
+    cprCallBackTimerMsg_t *timerMsg;
+    void *syshdr;
+    uint16_t posted = 0;
+
+    if (replay_running == NULL || replay_running->expires > until) {
+        if (until > replay_now) {
+            replay_now = until;
+        }
+        return 0;
+    }
+
+    if (replay_running->expires > replay_now) {
+        replay_now = replay_running->expires;
+    }
+    while (replay_running != NULL && replay_running->expires <= replay_now) {
+        timer = replay_running;
+        replay_timer_unlink(timer);
+
+        timerMsg = (cprCallBackTimerMsg_t *)
+            cprGetBuffer(sizeof(cprCallBackTimerMsg_t));
+        if (timerMsg == NULL) {
+            continue;
+        }
+        timerMsg->expiredTimerName = timer->name;
+        timerMsg->expiredTimerId = timer->applicationTimerId;
+        timerMsg->usrData = timer->data;
+        syshdr = cprGetSysHeader(timerMsg);
+        if (syshdr == NULL) {
+            cprReleaseBuffer(timerMsg);
+            continue;
+        }
+        fillInSysHeader(syshdr, timer->applicationMsgId,
+                        sizeof(cprCallBackTimerMsg_t), timerMsg);
+        if (cprSendMessageLane(timer->callBackMsgQueue, timerMsg,
+                               (void **) &syshdr,
+                               CPR_MSGQ_LANE_CONTROL) == CPR_FAILURE) {
+            cprReleaseSysHeader(syshdr);
+            cprReleaseBuffer(timerMsg);
+            continue;
+        }
+        posted++;
+    }
+    return posted;
+}
+
+cprTimer_t
+cprCreateTimer (const char *name,
+                uint16_t applicationTimerId,
+                uint16_t applicationMsgId,
+                cprMsgQueue_t callBackMsgQueue)
+{
+    replay_timer_t *timer;
+
+    if (callBackMsgQueue == NULL) {
+        return NULL;
+    }
+    timer = (replay_timer_t *) cpr_calloc(1, sizeof(replay_timer_t));
+    if (timer == NULL) {
+        return NULL;
+    }
+    timer->name = name;
+    timer->applicationTimerId = applicationTimerId;
+    timer->applicationMsgId = applicationMsgId;
+    timer->callBackMsgQueue = callBackMsgQueue;
+    return timer;
+}
+
+cprRC_t
+cprStartTimer (cprTimer_t timer, uint32_t duration, void *data)
+{
+    replay_timer_t *t = (replay_timer_t *) timer;
+    replay_timer_t **pp;
+
+    if (t == NULL) {
+        return CPR_FAILURE;
+    }
+    if (t->active) {
+        replay_timer_unlink(t);
+    }
+    t->data = data;
+    t->expires = replay_now + duration;
+    for (pp = &replay_running; *pp; pp = &(*pp)->next) {
+        if ((*pp)->expires > t->expires) {
+            break;
+        }
+    }
+    t->next = *pp;
+    *pp = t;
+    t->active = TRUE;
+    replay_running_count++;
+    return CPR_SUCCESS;
+}
+
+boolean
+cprIsTimerRunning (cprTimer_t timer)
+{
+    replay_timer_t *t = (replay_timer_t *) timer;
+
+    return (t != NULL && t->active);
+}
+
+cprRC_t
+cprCancelTimer (cprTimer_t timer)
+{
+    replay_timer_t *t = (replay_timer_t *) timer;
+
+    if (t == NULL) {
+        return CPR_FAILURE;
+    }
+    if (t->active) {
+        replay_timer_unlink(t);
+    }
+    return CPR_SUCCESS;
+}
+
+cprRC_t
+cprUpdateTimer (cprTimer_t timer, uint32_t duration)
+{
+    replay_timer_t *t = (replay_timer_t *) timer;
+
+    if (t == NULL) {
+        return CPR_FAILURE;
+    }
+    return cprStartTimer(timer, duration, t->data);
+}
+
+cprRC_t
+cprDestroyTimer (cprTimer_t timer)
+{
+    if (cprCancelTimer(timer) != CPR_SUCCESS) {
+        return CPR_FAILURE;
+    }
+    cpr_free(timer);
+    return CPR_SUCCESS;
+}
+
+cprRC_t
+cpr_timer_pre_init (void)
+{
+    return CPR_SUCCESS;
+}
+
+cprRC_t
+cpr_timer_de_init (void)
+{
+    return CPR_SUCCESS;
+}
+
+uint32_t
+cprGetTimeMs (void)
+{
+    return replay_now;
+}
+
+void
+cprSleep (uint32_t duration)
+{
+    /* Only reached on unload paths; nothing waits on the virtual clock */
+}
+
+/*
+ * Threads are never started; the harness is the only thread and takes
+ * the messages off each task queue itself.
+ */
+cprThread_t
+cprCreateThread (const char *name,
+                 cprThreadStartRoutine startRoutine,
+                 uint16_t stackSize,
+                 uint16_t priority,
+                 void *data)
+{
+    static uint16_t id = 0;
+    cpr_thread_t *threadPtr;
+
+    threadPtr = (cpr_thread_t *) cpr_calloc(1, sizeof(cpr_thread_t));
+    if (threadPtr == NULL) {
+        return NULL;
+    }
+    threadPtr->name = name;
+    threadPtr->threadId = ++id;
+    return threadPtr;
+}
+
+/*
+ * Loopback transport
+ */
+#define REPLAY_SOCKET 0x5e9
+
+static replay_send_sink_t replay_sink = NULL;
+
+void
+replay_transport_set_sink (replay_send_sink_t sink)
+{
+    replay_sink = sink;
+}
+
+int
+sip_platform_udp_channel_listen (cpr_ip_mode_e ip_mode, cpr_socket_t *s,
+                                 cpr_ip_addr_t *local_ipaddr,
+                                 uint16_t local_port)
+{
+    *s = REPLAY_SOCKET;
+    return SIP_OK;
+}
+
+int
+sip_platform_udp_channel_create (cpr_ip_mode_e ip_mode, cpr_socket_t *s,
+                                 cpr_ip_addr_t *remote_ipaddr,
+                                 uint16_t remote_port,
+                                 uint32_t local_udp_port)
+{
+    *s = REPLAY_SOCKET;
+    return SIP_OK;
+}
+
+int
+sip_platform_udp_channel_destroy (cpr_socket_t s)
+{
+    return SIP_OK;
+}
+
+int
+sip_platform_udp_channel_send (cpr_socket_t s, char *buf, uint16_t len)
+{
+    if (replay_sink) {
+        replay_sink(buf, len);
+    }
+    return SIP_OK;
+}
+
+int
+sip_platform_udp_channel_sendto (cpr_socket_t s, char *buf, uint32_t len,
+                                 cpr_ip_addr_t *dst_ipaddr, uint16_t dst_port)
+{
+    if (replay_sink) {
+        replay_sink(buf, len);
+    }
+    return SIP_OK;
+}
+
+/*
+ * Allocation counting. Builds under a sanitizer, which wraps the malloc
+ * family itself, and threaded tests that have no use for the count
+ * define REPLAY_NO_ALLOC_COUNT.
+ */
+#if defined(__GLIBC__) && !defined(REPLAY_NO_ALLOC_COUNT)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static volatile uint32_t replay_allocs = 0;
+
+void *
+malloc (size_t size)
+{
+    __sync_add_and_fetch(&replay_allocs, 1);
+    return __libc_malloc(size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    __sync_add_and_fetch(&replay_allocs, 1);
+    return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    __sync_add_and_fetch(&replay_allocs, 1);
+    return __libc_realloc(ptr, size);
+}
+
+void
+free (void *ptr)
+{
+    __libc_free(ptr);
+}
+
+boolean
+replay_alloc_supported (void)
+{
+    return TRUE;
+}
+
+uint32_t
+replay_alloc_count (void)
+{
+    return __sync_add_and_fetch(&replay_allocs, 0);
+}
+#else
+boolean
+replay_alloc_supported (void)
+{
+    return FALSE;
+}
+
+uint32_t
+replay_alloc_count (void)
+{
+    return 0;
+}
+#endif
+
+/*
+ * Logging
+ */
+void
+replay_set_verbose (int level)
+{
+    replay_verbose = level;
+}
+
+void
+CSFLogV (CSFLogLevel priority, const char *sourceFile, int sourceLine,
+         const char *tag, const char *format, va_list args)
+{
+    if (replay_verbose == 0 ||
+        (replay_verbose == 1 && priority > CSF_LOG_WARNING)) {
+        return;
+    }
+    fprintf(stderr, "%u %s: ", replay_now, tag);
+    vfprintf(stderr, format, args);
+}
+
+void
+CSFLog (CSFLogLevel priority, const char *sourceFile, int sourceLine,
+        const char *tag, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    CSFLogV(priority, sourceFile, sourceLine, tag, format, ap);
+    va_end(ap);
+}
+
+int
+debugif_printf (const char *_format, ...)
+{
+    va_list ap;
+
+    va_start(ap, _format);
+    CSFLogV(CSF_LOG_DEBUG, __FILE__, __LINE__, "debugif", _format, ap);
+    va_end(ap);
+    return 0;
+}
+
+/* The CPR version prints long messages straight to stdout */
+int32_t
+buginf_msg (const char *str)
+{
+    CSFLog(CSF_LOG_DEBUG, __FILE__, __LINE__, "cpr", "%s", str);
+    return 0;
+}
+
+/*
+ * Platform and media calls the sample plugins do not cover, or cover too
+ * thinly for a call to come up
+ */
+void
+platGetDefaultGW (char *addr)
+{
+    sstrncpy(addr, "127.0.0.1", MAX_IPADDR_STR_LEN);
+}
+
+void
+configApplyConfigNotify (cc_string_t config_version,
+                         cc_string_t dial_plan_version,
+                         cc_string_t fcp_version,
+                         cc_string_t cucm_result,
+                         cc_string_t load_id,
+                         cc_string_t inactive_load_id,
+                         cc_string_t load_server,
+                         cc_string_t log_server,
+                         cc_boolean ppid)
+{
+}
+
+int
+vcmGetVideoMaxSupportedPacketizationMode (void)
+{
+    return 0;
+}
+
+int
+vcmGetRtpStats (cc_mcapid_t mcap_id, cc_groupid_t group_id,
+                cc_streamid_t stream_id, cc_call_handle_t call_handle,
+                char *rx_stats, char *tx_stats)
+{
+    rx_stats[0] = '\0';
+    tx_stats[0] = '\0';
+    return 0;
+}
+
+cc_boolean
+vcmAllocateBandwidth (cc_call_handle_t call_handle, int sessions)
+{
+    return TRUE;
+}
+
+void
+vcmRemoveBandwidth (cc_call_handle_t call_handle)
+{
+}
+
+void
+vcmActivateWlan (cc_boolean is_active)
+{
+}
+
+void
+vcmMediaControl (cc_call_handle_t call_handle,
+                 vcm_media_control_to_encoder_t to_encoder)
+{
+}
+
+void
+vcmSetRtcpDscp (cc_groupid_t group_id, int dscp)
+{
+}
+
+int
+vcmDtmfBurst (int digit, int duration, int direction)
+{
+    return 0;
+}
+
+int
+vcmGetILBCMode (void)
+{
+    return 0;
+}
+
+/*
+ * The sample plugin allocates and opens no port, which leaves our offers
+ * with port 0 and makes every answer look like a rejected media line.
+ * Hand out even ports from the configured media range instead and keep
+ * them when the stream is opened.
+ */
+void
+vcmRxAllocPort (cc_mcapid_t mcap_id, cc_groupid_t group_id,
+                cc_streamid_t stream_id, cc_call_handle_t call_handle,
+                uint16_t port_requested, int *port_allocated)
+{
+    static int next_port = 16384;
+
+    if (port_requested != 0) {
+        *port_allocated = port_requested;
+        return;
+    }
+    *port_allocated = next_port;
+    next_port = (next_port >= 32766) ? 16384 : next_port + 2;
+}
+
+short
+vcmRxOpen (cc_mcapid_t mcap_id, cc_groupid_t group_id,
+           cc_streamid_t stream_id, cc_call_handle_t call_handle,
+           uint16_t port_requested, cpr_ip_addr_t *listen_ip,
+           boolean is_multicast, int *port_allocated)
+{
+    *port_allocated = port_requested;
+    return 0;
+}
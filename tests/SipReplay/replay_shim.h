@@ -0,0 +1,94 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef _REPLAY_SHIM_H_
+#define _REPLAY_SHIM_H_
+
+#include "cpr_types.h"
+#include "cpr_ipc.h"
+
+/*
+ * Platform shim for the SIP replay harness.
+ *
+ * The harness is linked with '-z muldefs' and this file's object goes
+ * first, so the definitions here replace the ones in libsipcc:
+ *
+ *  - CPR timers run on a virtual clock. Nothing expires until the harness
+ *    moves the clock with replay_clock_run(); an expired timer posts its
+ *    message to its queue exactly as the CPR timer service would.
+ *  - cprCreateThread() hands back a thread handle without starting the
+ *    thread. The harness takes the messages off the task queues itself.
+ *  - The SIP UDP channel functions open no sockets. Everything the stack
+ *    sends is handed to the sink set with replay_transport_set_sink().
+ *  - The application callbacks libsipcc expects from the softphone
+ *    wrapper (logging, config fetch, the vcm calls the sample plugins do
+ *    not provide) are answered locally.
+ */
+
+/* Virtual clock */
+uint32_t replay_clock_now(void);
+
+/*
+ * Move the clock towards 'until'. If a timer is due on or before 'until'
+ * the clock stops at the earliest expiry, every timer due at that instant
+ * posts its message and the number posted is returned. Otherwise the clock
+ * is set to 'until' and 0 is returned.
+ */
+uint16_t replay_clock_run(uint32_t until);
+
+/* Number of timers currently running */
+uint16_t replay_clock_active_timers(void);
+
+/* Loopback transport */
+typedef void (*replay_send_sink_t)(const char *buf, uint32_t len);
+void replay_transport_set_sink(replay_send_sink_t sink);
+
+/*
+ * Heap calls made since start up. Counting is only available with glibc,
+ * where the process wide malloc family can be wrapped, and not in builds
+ * that define REPLAY_NO_ALLOC_COUNT; elsewhere replay_alloc_supported()
+ * is FALSE and the count stays 0.
+ */
+boolean replay_alloc_supported(void);
+uint32_t replay_alloc_count(void);
+
+/* Stack logging goes to stderr when set */
+void replay_set_verbose(int level);
+
+#endif /* _REPLAY_SHIM_H_ */
@@ -0,0 +1,976 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * sipreplay - replay captured SIP dialogs through the sipcc stack and
+ * report how long each stage takes per received message.
+ *
+ * The stack runs in P2P mode on one thread. The SIP, GSM and CCApp task
+ * queues are drained by this program instead of their threads, CPR timers
+ * run on the virtual clock in replay_shim.c and the UDP channel is a
+ * loopback that hands every sent message back to the dialog being
+ * replayed. A received message goes through the same calls the TCP
+ * receive path makes: ccsip_process_network_message() parses it and
+ * SIPTaskProcessTCPMessage() hands it to the SIP state machine.
+ *
+ * For every received message four stages are timed, each including the
+ * heap calls made in it:
+ *
+ *   parse  - ccsip_process_network_message()
+ *   sip    - SIPTaskProcessTCPMessage() plus every SIP queue message that
+ *            follows from it (GSM events, SIP timers)
+ *   gsm    - every GSM queue message that follows from it
+ *   ccapp  - every CCApp queue message that follows from it
+ *
+ * Timer expiries and API actions are processed the same way but only
+ * reported as totals.
+ *
+ * Corpus format: one or more dialogs, steps run in order.
+ *
+ *   # comment
+ *   dialog <name>
+ *   recv                  a message for the stack follows, up to a line
+ *                         holding a single "."
+ *   send                  a captured message the stack must send follows,
+ *                         up to "."; only its start line is compared
+ *   wait <ms>             move the virtual clock, expiring timers
+ *   dial <digits>         originate a call
+ *   answer                answer the ringing call
+ *   hangup                end the current call
+ *
+ * In recv messages these are replaced:
+ *
+ *   [call]                unique per dialog run
+ *   [local_ip] [local_port] [remote_ip] [remote_port] [user]
+ *   [last_<Header>:]      that header line from the last matched send
+ *   [len]                 length of the body after the blank line
+ *
+ * Corpus lines end in LF; messages are sent with CRLF.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "cpr_ipc.h"
+#include "cpr_socket.h"
+#include "phone.h"
+#include "ccsip_core.h"
+#include "ccsip_task.h"
+#include "ccsip_pmh.h"
+#include "sip_common_transport.h"
+#include "gsm.h"
+#include "ccapp_task.h"
+#include "cc_constants.h"
+#include "cc_service.h"
+#include "ccapi_service.h"
+#include "ccapi_device.h"
+#include "ccapi_call.h"
+#include "ccapi_call_info.h"
+#include "config_api.h"
+#include "replay_shim.h"
+
+extern cprMsgQueue_t sip_msgq;
+extern cprMsgQueue_t gsm_msgq;
+extern cprMsgQueue_t ccapp_msgq;
+extern cprMsgQueue_t misc_app_msgq;
+extern cprMsgQueue_t gsm_msg_queue;
+extern sipGlobal_t sip;
+
+#define REPLAY_LOCAL_IP     "127.0.0.1"
+#define REPLAY_REMOTE_IP    "127.0.0.2"
+#define REPLAY_SIP_PORT     5060
+#define REPLAY_USER         "1000"
+#define REPLAY_DEVICE       "sipreplay"
+
+#define REPLAY_MSG_SIZE     8192
+#define REPLAY_BATCH        16
+#define REPLAY_SETTLE_MS    64000
+
+/*
+ * Corpus
+ */
+typedef enum {
+    STEP_RECV,
+    STEP_SEND,
+    STEP_WAIT,
+    STEP_DIAL,
+    STEP_ANSWER,
+    STEP_HANGUP
+} replay_step_e;
+
+typedef struct {
+    replay_step_e type;
+    char *text;         /* message, or start line to match, or digits */
+    uint32_t ms;
+    int line;
+} replay_step_t;
+
+typedef struct {
+    char *name;
+    replay_step_t *steps;
+    int count;
+    int alloc;
+} replay_dialog_t;
+
+static replay_dialog_t *dialogs = NULL;
+static int dialog_count = 0;
+
+/*
+ * Stages
+ */
+typedef enum {
+    STAGE_PARSE,
+    STAGE_SIP,
+    STAGE_GSM,
+    STAGE_CCAPP,
+    STAGE_MAX
+} replay_stage_e;
+
+static const char *stage_names[STAGE_MAX] = { "parse", "sip", "gsm", "ccapp" };
+
+typedef struct {
+    uint64_t ns[STAGE_MAX];
+    uint32_t allocs[STAGE_MAX];
+} replay_sample_t;
+
+static replay_sample_t *samples = NULL;
+static uint32_t sample_count = 0;
+static uint32_t sample_alloc = 0;
+
+static replay_sample_t timer_totals;
+static replay_sample_t action_totals;
+static uint32_t timers_fired = 0;
+static uint32_t actions_run = 0;
+static uint32_t misc_dropped = 0;
+
+/*
+ * State of the dialog being replayed
+ */
+typedef struct {
+    char *text;
+    boolean used;
+} replay_sent_t;
+
+static replay_sent_t *outbox = NULL;
+static int outbox_count = 0;
+static int outbox_alloc = 0;
+static int outbox_next = 0;
+static const char *last_matched = NULL;
+static char call_tag[32];
+
+static cc_call_handle_t current_call = 0;
+static cc_call_state_t current_state = ONHOOK;
+
+static uint32_t failures = 0;
+static uint32_t messages_sent = 0;
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec ts;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void *
+xrealloc (void *ptr, size_t size)
+{
+    ptr = realloc(ptr, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "sipreplay: out of memory\n");
+        exit(2);
+    }
+    return ptr;
+}
+
+/*
+ * Corpus loading
+ */
+static char *
+read_block (FILE *fp, int *lineno)
+{
+    char line[1024];
+    char *text = NULL;
+    size_t len = 0, n;
+
+    while (fgets(line, sizeof(line), fp)) {
+        (*lineno)++;
+        n = strlen(line);
+        while (n && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+            line[--n] = '\0';
+        }
+        if (strcmp(line, ".") == 0) {
+            break;
+        }
+        text = xrealloc(text, len + n + 3);
+        memcpy(text + len, line, n);
+        len += n;
+        text[len++] = '\r';
+        text[len++] = '\n';
+        text[len] = '\0';
+    }
+    return text;
+}
+
+static replay_step_t *
+add_step (replay_dialog_t *d, replay_step_e type, int lineno)
+{
+    replay_step_t *step;
+
+    if (d->count == d->alloc) {
+        d->alloc = d->alloc ? d->alloc * 2 : 16;
+        d->steps = xrealloc(d->steps, d->alloc * sizeof(replay_step_t));
+    }
+    step = &d->steps[d->count++];
+    memset(step, 0, sizeof(*step));
+    step->type = type;
+    step->line = lineno;
+    return step;
+}
+
+static int
+load_corpus (const char *path)
+{
+    FILE *fp;
+    char line[1024], *arg, *eol;
+    int lineno = 0;
+    replay_dialog_t *d = NULL;
+    replay_step_t *step;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "sipreplay: cannot open %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        arg = strchr(line, ' ');
+        if (arg) {
+            *arg++ = '\0';
+            while (*arg == ' ') {
+                arg++;
+            }
+        }
+
+        if (strcmp(line, "dialog") == 0) {
+            dialogs = xrealloc(dialogs, (dialog_count + 1) * sizeof(replay_dialog_t));
+            d = &dialogs[dialog_count++];
+            memset(d, 0, sizeof(*d));
+            d->name = strdup(arg ? arg : "unnamed");
+            continue;
+        }
+        if (d == NULL) {
+            fprintf(stderr, "%s:%d: step outside a dialog\n", path, lineno);
+            fclose(fp);
+            return -1;
+        }
+
+        if (strcmp(line, "recv") == 0 || strcmp(line, "send") == 0) {
+            step = add_step(d, line[0] == 'r' ? STEP_RECV : STEP_SEND, lineno);
+            step->text = read_block(fp, &lineno);
+            if (step->text == NULL) {
+                fprintf(stderr, "%s:%d: empty message\n", path, step->line);
+                fclose(fp);
+                return -1;
+            }
+            if (step->type == STEP_SEND) {
+                eol = strstr(step->text, "\r\n");
+                if (eol) {
+                    *eol = '\0';
+                }
+            }
+        } else if (strcmp(line, "wait") == 0 && arg) {
+            step = add_step(d, STEP_WAIT, lineno);
+            step->ms = (uint32_t) strtoul(arg, NULL, 10);
+        } else if (strcmp(line, "dial") == 0 && arg) {
+            step = add_step(d, STEP_DIAL, lineno);
+            step->text = strdup(arg);
+        } else if (strcmp(line, "answer") == 0) {
+            (void) add_step(d, STEP_ANSWER, lineno);
+        } else if (strcmp(line, "hangup") == 0) {
+            (void) add_step(d, STEP_HANGUP, lineno);
+        } else {
+            fprintf(stderr, "%s:%d: unknown step '%s'\n", path, lineno, line);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return dialog_count ? 0 : -1;
+}
+
+/*
+ * Loopback sink: everything the stack sends lands here
+ */
+static void
+replay_sent (const char *buf, uint32_t len)
+{
+    replay_sent_t *sent;
+
+    if (outbox_count == outbox_alloc) {
+        outbox_alloc = outbox_alloc ? outbox_alloc * 2 : 32;
+        outbox = xrealloc(outbox, outbox_alloc * sizeof(replay_sent_t));
+    }
+    sent = &outbox[outbox_count++];
+    sent->text = xrealloc(NULL, len + 1);
+    memcpy(sent->text, buf, len);
+    sent->text[len] = '\0';
+    sent->used = FALSE;
+    messages_sent++;
+}
+
+static void
+outbox_reset (void)
+{
+    int i;
+
+    for (i = 0; i < outbox_count; i++) {
+        free(outbox[i].text);
+    }
+    outbox_count = 0;
+    outbox_next = 0;
+    last_matched = NULL;
+}
+
+/* Compare the method of a request or the status code of a response */
+static boolean
+start_line_matches (const char *sent, const char *expected)
+{
+    size_t n;
+
+    if (strncmp(expected, "SIP/2.0 ", 8) == 0) {
+        return (strncmp(sent, expected, 11) == 0);
+    }
+    n = strcspn(expected, " ");
+    return (strncmp(sent, expected, n) == 0 && sent[n] == ' ');
+}
+
+/*
+ * Message expansion
+ */
+static size_t
+copy_header (char *out, size_t room, const char *name, size_t name_len)
+{
+    const char *p, *eol;
+    size_t used = 0, n;
+
+    if (last_matched == NULL) {
+        return 0;
+    }
+    for (p = strstr(last_matched, "\r\n"); p && p[2] != '\r'; p = eol) {
+        p += 2;
+        eol = strstr(p, "\r\n");
+        if (eol == NULL) {
+            break;
+        }
+        if (strncasecmp(p, name, name_len) != 0) {
+            continue;
+        }
+        n = eol - p;
+        if (used) {
+            n += 2;
+            p -= 2;
+        }
+        if (used + n >= room) {
+            break;
+        }
+        memcpy(out + used, p, n);
+        used += n;
+    }
+    return used;
+}
+
+static int
+expand (const char *tmpl, char *out, size_t room)
+{
+    const char *p = tmpl, *close, *body;
+    char value[64];
+    char *len_at = NULL;
+    size_t used = 0, n;
+
+    while (*p && used + 1 < room) {
+        if (*p != '[' || (close = strchr(p, ']')) == NULL) {
+            out[used++] = *p++;
+            continue;
+        }
+        n = close - p - 1;
+        value[0] = '\0';
+        if (n == 4 && strncmp(p + 1, "call", 4) == 0) {
+            sstrncpy(value, call_tag, sizeof(value));
+        } else if (n == 8 && strncmp(p + 1, "local_ip", 8) == 0) {
+            sstrncpy(value, REPLAY_LOCAL_IP, sizeof(value));
+        } else if (n == 9 && strncmp(p + 1, "remote_ip", 9) == 0) {
+            sstrncpy(value, REPLAY_REMOTE_IP, sizeof(value));
+        } else if ((n == 10 && strncmp(p + 1, "local_port", 10) == 0) ||
+                   (n == 11 && strncmp(p + 1, "remote_port", 11) == 0)) {
+            snprintf(value, sizeof(value), "%d", REPLAY_SIP_PORT);
+        } else if (n == 4 && strncmp(p + 1, "user", 4) == 0) {
+            sstrncpy(value, REPLAY_USER, sizeof(value));
+        } else if (n == 3 && strncmp(p + 1, "len", 3) == 0) {
+            /* filled in once the body is known */
+            len_at = out + used;
+            snprintf(value, sizeof(value), "     ");
+        } else if (n > 6 && strncmp(p + 1, "last_", 5) == 0 &&
+                   p[n] == ':') {
+            used += copy_header(out + used, room - used, p + 6, n - 5);
+            p = close + 1;
+            continue;
+        } else {
+            out[used++] = *p++;
+            continue;
+        }
+        n = strlen(value);
+        if (used + n >= room) {
+            return -1;
+        }
+        memcpy(out + used, value, n);
+        used += n;
+        p = close + 1;
+    }
+    out[used] = '\0';
+
+    if (len_at) {
+        /* the placeholder is five blanks wide, close it up behind the digits */
+        body = strstr(out, "\r\n\r\n");
+        n = (size_t) snprintf(value, sizeof(value), "%u",
+                              (unsigned int) (body ? strlen(body + 4) : 0));
+        memcpy(len_at, value, n);
+        memmove(len_at + n, len_at + 5, strlen(len_at + 5) + 1);
+        used -= 5 - n;
+    }
+    return (int) used;
+}
+
+/*
+ * Task queues
+ */
+static void
+sample_add (replay_sample_t *s, replay_stage_e stage, uint64_t t0,
+            uint32_t a0)
+{
+    s->ns[stage] += now_ns() - t0;
+    s->allocs[stage] += replay_alloc_count() - a0;
+}
+
+/*
+ * Take messages off the task queues until all of them are empty, charging
+ * each one to the stage of the queue it came from.
+ */
+static void
+drain (replay_sample_t *s)
+{
+    cprMsgBatchEntry_t batch[REPLAY_BATCH];
+    phn_syshdr_t *syshdr;
+    uint16_t count, i;
+    boolean busy = TRUE;
+    uint64_t t0;
+    uint32_t a0;
+
+    while (busy) {
+        busy = FALSE;
+
+        count = cprGetMessageBatch(sip_msgq, FALSE, batch, REPLAY_BATCH);
+        for (i = 0; i < count; i++) {
+            syshdr = (phn_syshdr_t *) batch[i].usrPtr;
+            a0 = replay_alloc_count();
+            t0 = now_ns();
+            SIPTaskProcessListEvent(syshdr->Cmd, batch[i].msg,
+                                    syshdr->Usr.UsrPtr, syshdr->Len);
+            cprReleaseSysHeader(syshdr);
+            sample_add(s, STAGE_SIP, t0, a0);
+            busy = TRUE;
+        }
+
+        count = cprGetMessageBatch(gsm_msgq, FALSE, batch, REPLAY_BATCH);
+        for (i = 0; i < count; i++) {
+            a0 = replay_alloc_count();
+            t0 = now_ns();
+            gsm_task_process_msg((phn_syshdr_t *) batch[i].usrPtr,
+                                 batch[i].msg);
+            sample_add(s, STAGE_GSM, t0, a0);
+            busy = TRUE;
+        }
+
+        count = cprGetMessageBatch(ccapp_msgq, FALSE, batch, REPLAY_BATCH);
+        for (i = 0; i < count; i++) {
+            a0 = replay_alloc_count();
+            t0 = now_ns();
+            ccappTaskProcessMsg((phn_syshdr_t *) batch[i].usrPtr,
+                                batch[i].msg);
+            sample_add(s, STAGE_CCAPP, t0, a0);
+            busy = TRUE;
+        }
+
+        /* presence and config app messages have no part in a replay */
+        count = cprGetMessageBatch(misc_app_msgq, FALSE, batch, REPLAY_BATCH);
+        for (i = 0; i < count; i++) {
+            cprReleaseSysHeader(batch[i].usrPtr);
+            cprReleaseBuffer(batch[i].msg);
+            misc_dropped++;
+            busy = TRUE;
+        }
+    }
+}
+
+static void
+run_clock (uint32_t until)
+{
+    uint16_t fired;
+
+    while ((fired = replay_clock_run(until)) != 0) {
+        timers_fired += fired;
+        drain(&timer_totals);
+    }
+}
+
+/*
+ * Application callbacks
+ */
+void
+configFetchReq (int device_handle)
+{
+    CCAPI_Start_response(device_handle, REPLAY_DEVICE, REPLAY_USER, "",
+                         REPLAY_REMOTE_IP);
+}
+
+void
+CCAPI_CallListener_onCallEvent (ccapi_call_event_e event,
+                                cc_call_handle_t handle,
+                                cc_callinfo_ref_t info, char *sdp)
+{
+    cc_call_state_t state;
+
+    state = CCAPI_CallInfo_getCallState(info);
+    if (state == ONHOOK) {
+        if (handle == current_call) {
+            current_call = 0;
+            current_state = ONHOOK;
+        }
+        return;
+    }
+    current_call = handle;
+    current_state = state;
+}
+
+void
+CCAPI_LineListener_onLineEvent (ccapi_line_event_e eventType,
+                                cc_lineid_t line, cc_lineinfo_ref_t info)
+{
+}
+
+void
+CCAPI_DeviceListener_onDeviceEvent (ccapi_device_event_e type,
+                                    cc_device_handle_t hDevice,
+                                    cc_deviceinfo_ref_t dev_info)
+{
+}
+
+void
+CCAPI_DeviceListener_onFeatureEvent (ccapi_device_event_e type,
+                                     cc_deviceinfo_ref_t device_info,
+                                     cc_featureinfo_ref_t feature_info)
+{
+}
+
+/*
+ * Replay
+ */
+static boolean
+step_failed (replay_dialog_t *d, replay_step_t *step, const char *why)
+{
+    int i;
+
+    fprintf(stderr, "sipreplay: dialog %s, line %d: %s\n", d->name,
+            step->line, why);
+    for (i = outbox_next; i < outbox_count; i++) {
+        if (!outbox[i].used) {
+            fprintf(stderr, "  unmatched send: %.*s\n",
+                    (int) strcspn(outbox[i].text, "\r\n"), outbox[i].text);
+        }
+    }
+    failures++;
+    return FALSE;
+}
+
+static boolean
+replay_recv (replay_dialog_t *d, replay_step_t *step, boolean record)
+{
+    static char buf[REPLAY_MSG_SIZE];
+    replay_sample_t s;
+    sipMessage_t *msg = NULL;
+    cpr_sockaddr_storage from;
+    struct sockaddr_in *sin = (struct sockaddr_in *) &from;
+    char *p = buf;
+    unsigned long nbytes;
+    uint64_t t0;
+    uint32_t a0;
+    int len;
+
+    len = expand(step->text, buf, sizeof(buf));
+    if (len < 0) {
+        return step_failed(d, step, "message too long");
+    }
+
+    memset(&from, 0, sizeof(from));
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(REPLAY_SIP_PORT);
+    sin->sin_addr.s_addr = inet_addr(REPLAY_REMOTE_IP);
+
+    memset(&s, 0, sizeof(s));
+    nbytes = len;
+    a0 = replay_alloc_count();
+    t0 = now_ns();
+    if (ccsip_process_network_message(&msg, &p, &nbytes, NULL) != SIP_SUCCESS) {
+        return step_failed(d, step, "stack did not parse the message");
+    }
+    sample_add(&s, STAGE_PARSE, t0, a0);
+
+    a0 = replay_alloc_count();
+    t0 = now_ns();
+    SIPTaskProcessTCPMessage(msg, from);
+    sample_add(&s, STAGE_SIP, t0, a0);
+
+    drain(&s);
+
+    if (record) {
+        if (sample_count == sample_alloc) {
+            sample_alloc = sample_alloc ? sample_alloc * 2 : 1024;
+            samples = xrealloc(samples, sample_alloc * sizeof(replay_sample_t));
+        }
+        samples[sample_count++] = s;
+    }
+    return TRUE;
+}
+
+static boolean
+replay_send (replay_dialog_t *d, replay_step_t *step)
+{
+    char why[160];
+    int i;
+
+    for (i = outbox_next; i < outbox_count; i++) {
+        if (!outbox[i].used && start_line_matches(outbox[i].text, step->text)) {
+            outbox[i].used = TRUE;
+            last_matched = outbox[i].text;
+            /* anything skipped before it was a retransmission or extra */
+            while (outbox_next < outbox_count && outbox[outbox_next].used) {
+                outbox_next++;
+            }
+            return TRUE;
+        }
+    }
+    snprintf(why, sizeof(why), "stack did not send '%s'", step->text);
+    return step_failed(d, step, why);
+}
+
+static boolean
+replay_action (replay_dialog_t *d, replay_step_t *step)
+{
+    char empty_sdp[] = "empty SDP string";
+    cc_call_handle_t handle;
+    cc_return_t rc = CC_FAILURE;
+
+    switch (step->type) {
+    case STEP_DIAL:
+        (void) CCAPI_Config_set_server_address(REPLAY_REMOTE_IP);
+        handle = CCAPI_Device_CreateCall(CCAPI_Device_getDeviceID());
+        rc = CCAPI_Call_originateCall(handle, CC_SDP_DIRECTION_SENDRECV,
+                                      step->text, empty_sdp, 0, 0);
+        break;
+    case STEP_ANSWER:
+        if (current_call == 0 || current_state != RINGIN) {
+            return step_failed(d, step, "no ringing call to answer");
+        }
+        rc = CCAPI_Call_answerCall(current_call, CC_SDP_DIRECTION_SENDRECV);
+        break;
+    case STEP_HANGUP:
+        if (current_call == 0) {
+            return step_failed(d, step, "no call to hang up");
+        }
+        rc = CCAPI_Call_endCall(current_call);
+        break;
+    default:
+        break;
+    }
+    if (rc != CC_SUCCESS) {
+        return step_failed(d, step, "API call failed");
+    }
+    actions_run++;
+    drain(&action_totals);
+    return TRUE;
+}
+
+static void
+replay_dialog (replay_dialog_t *d, unsigned int run, boolean record)
+{
+    replay_step_t *step;
+    boolean ok = TRUE;
+    int i;
+
+    snprintf(call_tag, sizeof(call_tag), "%u.%u", run, (unsigned int) (d - dialogs));
+    outbox_reset();
+
+    for (i = 0; ok && i < d->count; i++) {
+        step = &d->steps[i];
+        switch (step->type) {
+        case STEP_RECV:
+            ok = replay_recv(d, step, record);
+            break;
+        case STEP_SEND:
+            ok = replay_send(d, step);
+            break;
+        case STEP_WAIT:
+            run_clock(replay_clock_now() + step->ms);
+            break;
+        default:
+            ok = replay_action(d, step);
+            break;
+        }
+    }
+
+    /* let the transaction timers of this dialog run out */
+    run_clock(replay_clock_now() + REPLAY_SETTLE_MS);
+    if (ok && !gsm_is_idle()) {
+        fprintf(stderr, "sipreplay: dialog %s left a call up\n", d->name);
+        failures++;
+    }
+}
+
+/*
+ * Start up
+ */
+static int
+replay_start (void)
+{
+    if (CCAPI_Service_create() != CC_SUCCESS) {
+        return -1;
+    }
+    (void) CCAPI_Config_set_p2p_mode(TRUE);
+    (void) CCAPI_Config_set_transport_udp(TRUE);
+    (void) CCAPI_Config_set_local_voip_port(REPLAY_SIP_PORT);
+    (void) CCAPI_Config_set_remote_voip_port(REPLAY_SIP_PORT);
+
+    /* what each task thread does before it starts taking messages */
+    sip.msgQueue = sip_msgq;
+    SIPTaskInit();
+    gsm_msg_queue = gsm_msgq;
+    gsm_task_init();
+    ccappTaskInit();
+    drain(&action_totals);
+
+    CCAPI_Device_IP_Update(CCAPI_Device_getDeviceID(), REPLAY_LOCAL_IP, "", 0,
+                           REPLAY_LOCAL_IP, "", 0);
+    if (CCAPI_Service_start() != CC_SUCCESS) {
+        return -1;
+    }
+    drain(&action_totals);
+    run_clock(replay_clock_now() + 1000);
+
+    if (!sip.taskInited) {
+        fprintf(stderr, "sipreplay: SIP task did not come up\n");
+        return -1;
+    }
+    memset(&action_totals, 0, sizeof(action_totals));
+    return 0;
+}
+
+/*
+ * Report
+ */
+static int
+compare_u64 (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+static void
+report (unsigned int runs, double wall)
+{
+    uint64_t *ns;
+    uint64_t total, allocs;
+    uint32_t i;
+    int stage;
+
+    ns = xrealloc(NULL, (sample_count ? sample_count : 1) * sizeof(uint64_t));
+    printf("sipreplay: %d dialogs x %u runs, %u messages received, %u sent, "
+           "%u failures, %.2f s\n", dialog_count, runs, sample_count,
+           messages_sent, failures, wall);
+    printf("%-8s %12s %10s %10s %12s\n", "stage", "msgs/s", "p50 us",
+           "p99 us", "allocs/msg");
+    for (stage = 0; stage <= STAGE_MAX; stage++) {
+        total = 0;
+        allocs = 0;
+        for (i = 0; i < sample_count; i++) {
+            if (stage == STAGE_MAX) {
+                ns[i] = samples[i].ns[STAGE_PARSE] + samples[i].ns[STAGE_SIP] +
+                        samples[i].ns[STAGE_GSM] + samples[i].ns[STAGE_CCAPP];
+                allocs += samples[i].allocs[STAGE_PARSE] +
+                          samples[i].allocs[STAGE_SIP] +
+                          samples[i].allocs[STAGE_GSM] +
+                          samples[i].allocs[STAGE_CCAPP];
+            } else {
+                ns[i] = samples[i].ns[stage];
+                allocs += samples[i].allocs[stage];
+            }
+            total += ns[i];
+        }
+        if (sample_count == 0) {
+            break;
+        }
+        qsort(ns, sample_count, sizeof(uint64_t), compare_u64);
+        printf("%-8s %12.0f %10.1f %10.1f ",
+               stage == STAGE_MAX ? "total" : stage_names[stage],
+               total ? sample_count / (total / 1e9) : 0.0,
+               ns[sample_count / 2] / 1e3,
+               ns[(sample_count * 99) / 100] / 1e3);
+        if (replay_alloc_supported()) {
+            printf("%12.1f\n", (double) allocs / sample_count);
+        } else {
+            printf("%12s\n", "n/a");
+        }
+    }
+
+    total = 0;
+    allocs = 0;
+    for (stage = 0; stage < STAGE_MAX; stage++) {
+        total += timer_totals.ns[stage];
+        allocs += timer_totals.allocs[stage];
+    }
+    printf("timers   %u fired, %.1f us each, %.1f allocs each\n", timers_fired,
+           timers_fired ? total / 1e3 / timers_fired : 0.0,
+           timers_fired ? (double) allocs / timers_fired : 0.0);
+    total = 0;
+    allocs = 0;
+    for (stage = 0; stage < STAGE_MAX; stage++) {
+        total += action_totals.ns[stage];
+        allocs += action_totals.allocs[stage];
+    }
+    printf("actions  %u run, %.1f us each, %.1f allocs each\n", actions_run,
+           actions_run ? total / 1e3 / actions_run : 0.0,
+           actions_run ? (double) allocs / actions_run : 0.0);
+    if (misc_dropped) {
+        printf("misc     %u messages dropped\n", misc_dropped);
+    }
+    free(ns);
+}
+
+static void
+usage (void)
+{
+    fprintf(stderr,
+            "usage: sipreplay [-n runs] [-w warmup] [-v] corpus\n"
+            "  -n runs    times to replay the corpus (default 100)\n"
+            "  -w warmup  runs before measuring (default 1)\n"
+            "  -v         stack errors to stderr, -vv everything\n");
+}
+
+int
+main (int argc, char **argv)
+{
+    unsigned int runs = 100, warmup = 1, run;
+    const char *corpus = NULL;
+    uint64_t t0;
+    int i, d;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            replay_set_verbose(1);
+        } else if (strcmp(argv[i], "-vv") == 0) {
+            replay_set_verbose(2);
+        } else if (argv[i][0] != '-' && corpus == NULL) {
+            corpus = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (corpus == NULL) {
+        usage();
+        return 2;
+    }
+    if (load_corpus(corpus) != 0) {
+        return 2;
+    }
+
+    replay_transport_set_sink(replay_sent);
+    if (replay_start() != 0) {
+        fprintf(stderr, "sipreplay: stack failed to start\n");
+        return 2;
+    }
+
+    for (run = 0; run < warmup; run++) {
+        for (d = 0; d < dialog_count; d++) {
+            replay_dialog(&dialogs[d], run, FALSE);
+        }
+    }
+    failures = 0;
+    messages_sent = 0;
+    timers_fired = 0;
+    actions_run = 0;
+    memset(&timer_totals, 0, sizeof(timer_totals));
+    memset(&action_totals, 0, sizeof(action_totals));
+
+    t0 = now_ns();
+    for (run = warmup; run < warmup + runs; run++) {
+        for (d = 0; d < dialog_count; d++) {
+            replay_dialog(&dialogs[d], run, TRUE);
+        }
+    }
+    report(runs, (now_ns() - t0) / 1e9);
+
+    return failures ? 1 : 0;
+}
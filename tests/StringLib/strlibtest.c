@@ -0,0 +1,457 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * strlibtest - check the interned string pool and hammer it from
+ * several threads.
+ *
+ *   strlibtest [-s seed] [-t threads] [-n iterations]
+ *
+ * Checks: identical strings share a block, copies and frees keep the
+ * count right, strlib_open() hands out a private block before anything
+ * is modified in place, long strings bypass the pool, and the pool
+ * counters add up.
+ *
+ * Stress: every thread keeps a handful of strings and at random mallocs
+ * one from a shared vocabulary, copies, frees, appends, modifies one in
+ * place through strlib_open(), or swaps one with a shared mailbox so
+ * that a string made on one thread is released on another, the way
+ * session data strings go from the CCApp task to application threads.
+ * Each string is checked against the text it should have whenever it is
+ * touched. Build strlibtest_tsan to run this under ThreadSanitizer.
+ *
+ * Time: malloc/free of strings that are already interned, from one
+ * thread and from all of them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cpr_types.h"
+#include "cpr_stdlib.h"
+#include "string_lib.h"
+
+#define VOCAB_SIZE      256
+#define VOCAB_LONG      16      /* entries past STRLIB_INTERN_MAX */
+#define STRESS_MAX_LEN  512
+#define STRESS_HELD     16
+#define STRESS_MAILBOX  64
+#define MAX_THREADS     64
+
+typedef struct {
+    string_t str;
+    char expect[STRESS_MAX_LEN];
+} held_t;
+
+typedef struct {
+    unsigned seed;
+    int iterations;
+} worker_t;
+
+static volatile int failures = 0;
+static char vocab[VOCAB_SIZE + VOCAB_LONG][STRESS_MAX_LEN];
+static string_t vocab_held[VOCAB_SIZE];
+static pthread_mutex_t mailbox_lock = PTHREAD_MUTEX_INITIALIZER;
+static held_t mailbox[STRESS_MAILBOX];
+
+static void
+fail (const char *what, const char *got, const char *expect)
+{
+    __sync_add_and_fetch(&failures, 1);
+    fprintf(stderr, "FAIL %s: got '%s' expected '%s'\n", what,
+            got ? got : "(null)", expect);
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * SIP URIs and display names of a few hundred users, and a few long
+ * strings the pool does not intern.
+ */
+static void
+build_vocab (void)
+{
+    int i;
+
+    for (i = 0; i < VOCAB_SIZE; i++) {
+        if (i & 1) {
+            snprintf(vocab[i], STRESS_MAX_LEN, "sip:%d@10.1.%d.%d;user=phone",
+                     2000 + i, i / 200, i % 200);
+        } else {
+            snprintf(vocab[i], STRESS_MAX_LEN, "Extension %d", 2000 + i);
+        }
+    }
+    for (i = 0; i < VOCAB_LONG; i++) {
+        memset(vocab[VOCAB_SIZE + i], 'a' + i, STRLIB_INTERN_MAX + 1 + i * 8);
+        vocab[VOCAB_SIZE + i][STRLIB_INTERN_MAX + 1 + i * 8] = '\0';
+    }
+}
+
+static string_block_t *
+block_of (string_t str)
+{
+    return (string_block_t *) (str - offsetof(string_block_t, data));
+}
+
+static void
+check_basics (void)
+{
+    strlib_stats_t before, after;
+    string_t a, b, c, d;
+    char *w;
+
+    strlib_get_stats(&before);
+
+    a = strlib_malloc("sip:1000@example.com", LEN_UNKNOWN);
+    b = strlib_malloc("sip:1000@example.com", LEN_UNKNOWN);
+    if (a != b) {
+        fail("identical strings share a block", b, a);
+    }
+    c = strlib_malloc("sip:1000@example.com;tag=1", 20);
+    if (c != a) {
+        fail("prefix of a longer string is interned", c, a);
+    }
+    if (block_of(a)->refcount != 3) {
+        fail("refcount after three mallocs", "", "3");
+    }
+    d = strlib_copy(a);
+    if ((d != a) || (block_of(a)->refcount != 4)) {
+        fail("copy takes a reference", d, a);
+    }
+    strlib_free(d);
+    strlib_free(c);
+
+    /* b is shared with a, so opening it has to give a new block */
+    w = strlib_open(b, (int) strlen(b));
+    if ((w == a) || strcmp(w, a)) {
+        fail("open of a shared string copies it", w, a);
+    }
+    w[0] = 'S';
+    b = strlib_close(w);
+    if (strcmp(a, "sip:1000@example.com") ||
+        strcmp(b, "Sip:1000@example.com")) {
+        fail("modifying an opened string leaves others alone", a,
+             "sip:1000@example.com");
+    }
+    /* the modified string is private: an equal malloc does not find it */
+    c = strlib_malloc("Sip:1000@example.com", LEN_UNKNOWN);
+    if (c == b) {
+        fail("an opened string is not interned", c, "a new block");
+    }
+    strlib_free(c);
+
+    /* a is the only reference now: open modifies in place */
+    w = strlib_open(a, 4);
+    if (w != a) {
+        fail("open of an unshared string is in place", w, a);
+    }
+    w[3] = 'S';
+    a = strlib_close(w);
+    c = strlib_malloc("sip:1000@example.com", LEN_UNKNOWN);
+    if (c == a) {
+        fail("a string opened in place left the pool", c, "a new block");
+    }
+    strlib_free(c);
+
+    b = strlib_append(b, ";tag=2");
+    if (strcmp(b, "Sip:1000@example.com;tag=2")) {
+        fail("append", b, "Sip:1000@example.com;tag=2");
+    }
+    strlib_free(a);
+    strlib_free(b);
+
+    a = strlib_malloc(vocab[VOCAB_SIZE], LEN_UNKNOWN);
+    b = strlib_malloc(vocab[VOCAB_SIZE], LEN_UNKNOWN);
+    if ((a == b) || strcmp(a, b)) {
+        fail("long strings are not interned", b, "a new block");
+    }
+    strlib_free(a);
+    strlib_free(b);
+
+    a = strlib_malloc("", LEN_UNKNOWN);
+    if ((a[0] != '\0') || (strlib_empty()[0] != '\0')) {
+        fail("empty string", a, "");
+    }
+    strlib_free(a);
+
+    strlib_get_stats(&after);
+    if ((after.interned != before.interned) ||
+        (after.hits - before.hits != 2)) {
+        char got[64];
+
+        snprintf(got, sizeof(got), "%u live %u hits",
+                 after.interned - before.interned, after.hits - before.hits);
+        fail("pool counters", got, "0 live 2 hits");
+    }
+}
+
+static void
+check_held (const held_t *h, const char *what)
+{
+    if (h->str && strcmp(h->str, h->expect)) {
+        fail(what, h->str, h->expect);
+    }
+}
+
+static void
+set_held (held_t *h, string_t str, const char *expect)
+{
+    h->str = str;
+    strcpy(h->expect, expect);
+}
+
+static void *
+stress_worker (void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    held_t held[STRESS_HELD];
+    held_t tmp;
+    char *buf;
+    int i, n, slot, other;
+    size_t len;
+
+    memset(held, 0, sizeof(held));
+    for (i = 0; i < w->iterations; i++) {
+        slot = rand_r(&w->seed) % STRESS_HELD;
+        check_held(&held[slot], "held string changed");
+
+        switch (rand_r(&w->seed) % 10) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            n = rand_r(&w->seed) % (VOCAB_SIZE + VOCAB_LONG / 4);
+            strlib_free(held[slot].str);
+            set_held(&held[slot], strlib_malloc(vocab[n], LEN_UNKNOWN),
+                     vocab[n]);
+            break;
+        case 4:
+        case 5:
+            other = rand_r(&w->seed) % STRESS_HELD;
+            if ((other == slot) || !held[other].str) {
+                break;
+            }
+            strlib_free(held[slot].str);
+            set_held(&held[slot], strlib_copy(held[other].str),
+                     held[other].expect);
+            break;
+        case 6:
+            strlib_free(held[slot].str);
+            held[slot].str = NULL;
+            break;
+        case 7:
+            len = held[slot].str ? strlen(held[slot].expect) : 0;
+            if (!held[slot].str || (len + 3 >= STRESS_MAX_LEN)) {
+                break;
+            }
+            held[slot].str = strlib_append(held[slot].str, "-x");
+            strcat(held[slot].expect, "-x");
+            check_held(&held[slot], "append");
+            break;
+        case 8:
+            if (!held[slot].str || !held[slot].expect[0]) {
+                break;
+            }
+            buf = strlib_open(held[slot].str,
+                              (int) strlen(held[slot].expect));
+            buf[0] = (char) ('A' + (rand_r(&w->seed) % 26));
+            held[slot].expect[0] = buf[0];
+            held[slot].str = strlib_close(buf);
+            check_held(&held[slot], "open in place");
+            break;
+        default:
+            n = rand_r(&w->seed) % STRESS_MAILBOX;
+            pthread_mutex_lock(&mailbox_lock);
+            tmp = mailbox[n];
+            mailbox[n] = held[slot];
+            held[slot] = tmp;
+            pthread_mutex_unlock(&mailbox_lock);
+            check_held(&held[slot], "string handed over");
+            break;
+        }
+    }
+
+    for (slot = 0; slot < STRESS_HELD; slot++) {
+        check_held(&held[slot], "held string changed");
+        strlib_free(held[slot].str);
+    }
+    return NULL;
+}
+
+static void
+stress (unsigned seed, int threads, int iterations)
+{
+    pthread_t tid[MAX_THREADS];
+    worker_t work[MAX_THREADS];
+    strlib_stats_t stats;
+    double start;
+    int i;
+
+    start = now_ns();
+    for (i = 0; i < threads; i++) {
+        work[i].seed = seed * 7919 + i;
+        work[i].iterations = iterations;
+        pthread_create(&tid[i], NULL, stress_worker, &work[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+    }
+    for (i = 0; i < STRESS_MAILBOX; i++) {
+        check_held(&mailbox[i], "mailbox string changed");
+        strlib_free(mailbox[i].str);
+        mailbox[i].str = NULL;
+    }
+
+    strlib_get_stats(&stats);
+    printf("stress: %d threads x %d ops in %.0f ms\n", threads, iterations,
+           (now_ns() - start) / 1e6);
+    if (stats.interned != 0) {
+        char got[32];
+
+        snprintf(got, sizeof(got), "%u", stats.interned);
+        fail("strings left interned after the stress run", got, "0");
+    }
+}
+
+static void *
+bench_worker (void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    string_t str;
+    int i;
+
+    for (i = 0; i < w->iterations; i++) {
+        str = strlib_malloc(vocab[(w->seed + i) % VOCAB_SIZE], LEN_UNKNOWN);
+        strlib_free(strlib_copy(str));
+        strlib_free(str);
+    }
+    return NULL;
+}
+
+static void
+bench (int threads, int iterations)
+{
+    pthread_t tid[MAX_THREADS];
+    worker_t work[MAX_THREADS];
+    strlib_stats_t before, after;
+    double start;
+    int counts[2];
+    int c, i;
+
+    /* Keep every vocabulary string alive, as the live calls would */
+    for (i = 0; i < VOCAB_SIZE; i++) {
+        vocab_held[i] = strlib_malloc(vocab[i], LEN_UNKNOWN);
+    }
+
+    counts[0] = 1;
+    counts[1] = threads;
+    printf("%-8s %12s %10s %8s %12s\n", "threads", "ops", "ns/op", "hit%",
+           "bytes saved");
+    for (c = 0; c < 2; c++) {
+        strlib_get_stats(&before);
+        start = now_ns();
+        for (i = 0; i < counts[c]; i++) {
+            work[i].seed = (unsigned) i * 37;
+            work[i].iterations = iterations;
+            pthread_create(&tid[i], NULL, bench_worker, &work[i]);
+        }
+        for (i = 0; i < counts[c]; i++) {
+            pthread_join(tid[i], NULL);
+        }
+        strlib_get_stats(&after);
+        printf("%-8d %12d %10.1f %8.1f %12u\n", counts[c],
+               iterations * counts[c],
+               (now_ns() - start) / ((double) iterations * counts[c]),
+               100.0 * (after.hits - before.hits) /
+               (after.lookups - before.lookups),
+               after.bytes_saved - before.bytes_saved);
+    }
+
+    for (i = 0; i < VOCAB_SIZE; i++) {
+        strlib_free(vocab_held[i]);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    unsigned seed = 1;
+    int threads = 8;
+    int iterations = 200000;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && (i + 1 < argc)) {
+            seed = (unsigned) strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-t") && (i + 1 < argc)) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && (i + 1 < argc)) {
+            iterations = atoi(argv[++i]);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [-s seed] [-t threads] [-n iterations]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if ((threads < 1) || (threads > MAX_THREADS)) {
+        threads = MAX_THREADS;
+    }
+
+    strlib_init();
+    build_vocab();
+    check_basics();
+    stress(seed, threads, iterations);
+    printf("checks done, %d failures\n", failures);
+    if (failures) {
+        return 1;
+    }
+    bench(threads, iterations);
+    return 0;
+}
@@ -0,0 +1,356 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is the Cisco Systems SIP Stack.
+ *
+ * The Initial Developer of the Original Code is
+ * Cisco Systems (CSCO).
+ * Portions created by the Initial Developer are Copyright (C) 2002
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *  Enda Mannion <emannion@cisco.com>
+ *  Suhas Nandakumar <snandaku@cisco.com>
+ *  Ethan Hugg <ehugg@cisco.com>
+ *
+ * Alternatively, the contents of this file may be used under the terms of
+ * either the GNU General Public License Version 2 or later (the "GPL"), or
+ * the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+ * in which case the provisions of the GPL or the LGPL are applicable instead
+ * of those above. If you wish to allow use of your version of this file only
+ * under the terms of either the GPL or the LGPL, and not to allow others to
+ * use your version of this file under the terms of the MPL, indicate your
+ * decision by deleting the provisions above and replace them with the notice
+ * and other provisions required by the GPL or the LGPL. If you do not delete
+ * the provisions above, a recipient may use your version of this file under
+ * the terms of any one of the MPL, the GPL or the LGPL.
+ *
+ * ***** END LICENSE BLOCK ***** */
+
+/*
+ * tonecachetest - golden comparison of the PCM that WebrtcToneCache hands
+ * out against the generators it replaced (golden_generators.cpp).
+ *
+ *   tonecachetest [-t reads]
+ *
+ * Rings: every RingMode, with and without once, at several volumes, has to
+ * match the old generator sample for sample.
+ *
+ * Tones: the first pass of every ToneType cadence has to match the old
+ * oscillator sample for sample. Continuous tones are a loop of the nominal
+ * frequencies now, so they only have to stay close to the oscillator for
+ * the first cycles, and the loop has to join without a click. Later passes
+ * have to repeat the first one, and a tone with a repeat count has to end
+ * where the old generator ended.
+ *
+ * Volume: WebrtcToneCache::scaleSamples has to match (s * scale) / 100 for
+ * every 16-bit sample.
+ *
+ * Time: ns per 10ms Read for a tone and a scaled ring, old against cached.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "WebrtcToneCache.h"
+#include "WebrtcToneGenerator.h"
+#include "WebrtcRingGenerator.h"
+#include "golden_generators.h"
+
+using namespace CSF;
+
+#define FRAME_SAMPLES		80			// 10ms at 8kHz, what the engine reads
+#define GOLDEN_READ_SAMPLES	8			// every cadence duration is a multiple of 1ms
+#define MAX_SAMPLES			(8000 * 120)
+#define LOOP_CHECK_SAMPLES	400			// continuous tones: first 50ms against the oscillator
+#define LOOP_TOLERANCE		100			// 0.3% of full scale
+#define NUM_TONES			(ToneType_SECUREWARNING_TONE + 1)
+#define NUM_RINGS			(RingMode_PRECEDENCE_RING + 1)
+
+static int failures = 0;
+
+static void fail( const char* what, int id, const char* detail, long where )
+{
+	printf( "FAIL %s %d: %s at sample %ld\n", what, id, detail, where );
+	failures++;
+}
+
+static double nowNs()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Reads until the generator stops or max samples, in reads of readSamples.
+template <class Generator>
+static std::vector<short> readAll( Generator& gen, int readSamples, long max )
+{
+	std::vector<short> pcm;
+	std::vector<short> buf( readSamples );
+	while ( (long)pcm.size() < max )
+	{
+		int bytes = gen.Read( &buf[0], readSamples * sizeof(short) );
+		if ( bytes <= 0 )
+		{
+			break;
+		}
+		pcm.insert( pcm.end(), buf.begin(), buf.begin() + bytes / sizeof(short) );
+	}
+	return pcm;
+}
+
+static long firstDifference( const std::vector<short>& a, const std::vector<short>& b, long from, long to )
+{
+	for ( long i = from; i < to; i++ )
+	{
+		if ( a[i] != b[i] )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+static void checkRings()
+{
+	static const int volumes[] = { 100, 73, 0 };
+	int checks = 0;
+
+	for ( int mode = 0; mode < NUM_RINGS; mode++ )
+	{
+		for ( int once = 0; once <= 1; once++ )
+		{
+			for ( size_t v = 0; v < sizeof(volumes)/sizeof(volumes[0]); v++ )
+			{
+				GoldenRingGenerator golden( (RingMode)mode, once != 0 );
+				WebrtcRingGenerator cached( (RingMode)mode, once != 0 );
+				golden.SetScaleFactor( volumes[v] );
+				cached.SetScaleFactor( volumes[v] );
+
+				std::vector<short> expected = readAll( golden, FRAME_SAMPLES, MAX_SAMPLES );
+				std::vector<short> actual = readAll( cached, FRAME_SAMPLES, MAX_SAMPLES );
+				if ( expected.size() != actual.size() )
+				{
+					fail( "ring", mode, "length differs", (long)actual.size() );
+					continue;
+				}
+				long diff = firstDifference( expected, actual, 0, (long)expected.size() );
+				if ( diff >= 0 )
+				{
+					fail( "ring", mode, "sample differs", diff );
+				}
+				checks++;
+			}
+		}
+	}
+	printf( "rings: %d checks\n", checks );
+}
+
+// ----------------------------------------------------------------------------
+static void checkTone( int type )
+{
+	const PcmSequence* sequence = WebrtcToneCache::getInstance()->getTone( (ToneType)type );
+
+	// the finite part of one pass, and whether a continuous step follows it
+	long passLength = 0;
+	bool continuous = false;
+	for ( size_t i = 0; i < sequence->steps.size(); i++ )
+	{
+		if ( sequence->steps[i].duration == PCM_CONTINUOUS )
+		{
+			continuous = true;
+			break;
+		}
+		passLength += sequence->steps[i].duration;
+	}
+
+	GoldenToneGenerator golden( (ToneType)type );
+	WebrtcToneGenerator cached( (ToneType)type );
+	std::vector<short> expected = readAll( golden, GOLDEN_READ_SAMPLES, MAX_SAMPLES );
+	std::vector<short> actual = readAll( cached, FRAME_SAMPLES, MAX_SAMPLES );
+
+	// the cache has no read state of its own, any read size gives the same PCM
+	WebrtcToneGenerator oddReads( (ToneType)type );
+	std::vector<short> odd = readAll( oddReads, 7, MAX_SAMPLES );
+	// (past the end both are zero padding up to their own read size)
+	long common = (long)(actual.size() < odd.size() ? actual.size() : odd.size());
+	if ( labs( (long)actual.size() - (long)odd.size() ) >= FRAME_SAMPLES ||
+		 firstDifference( odd, actual, 0, common ) >= 0 )
+	{
+		fail( "tone", type, "output depends on the read size", 0 );
+	}
+
+	if ( (long)expected.size() < passLength || (long)actual.size() < passLength )
+	{
+		fail( "tone", type, "first pass is short", (long)actual.size() );
+		return;
+	}
+
+	long diff = firstDifference( expected, actual, 0, passLength );
+	if ( diff >= 0 )
+	{
+		fail( "tone", type, "first pass differs", diff );
+	}
+
+	if ( continuous )
+	{
+		const PcmStep& loop = sequence->steps[sequence->steps.size() - 1];
+		for ( long i = passLength; i < passLength + LOOP_CHECK_SAMPLES; i++ )
+		{
+			if ( abs( expected[i] - actual[i] ) > LOOP_TOLERANCE )
+			{
+				fail( "tone", type, "continuous tone drifts from the oscillator", i );
+				break;
+			}
+		}
+		// the largest step inside the loop bounds the step across its seam
+		int maxStep = 0;
+		for ( int i = 1; i < loop.sampleCnt; i++ )
+		{
+			int step = abs( loop.samples[i] - loop.samples[i - 1] );
+			maxStep = step > maxStep ? step : maxStep;
+		}
+		if ( abs( loop.samples[0] - loop.samples[loop.sampleCnt - 1] ) > maxStep )
+		{
+			fail( "tone", type, "loop clicks at the seam", loop.sampleCnt );
+		}
+		return;
+	}
+
+	if ( sequence->repeatCount != PCM_REPEAT_FOREVER )
+	{
+		// the cached generator pads the frame the tone ends in
+		long expectedLength = (long)expected.size();
+		long paddedLength = (expectedLength + FRAME_SAMPLES - 1) / FRAME_SAMPLES * FRAME_SAMPLES;
+		if ( (long)actual.size() != paddedLength )
+		{
+			fail( "tone", type, "ends somewhere else", (long)actual.size() );
+		}
+	}
+	for ( long pass = passLength; pass + passLength <= (long)actual.size(); pass += passLength )
+	{
+		for ( long i = 0; i < passLength; i++ )
+		{
+			if ( actual[pass + i] != actual[i] )
+			{
+				fail( "tone", type, "later pass differs from the first", pass + i );
+				return;
+			}
+		}
+	}
+}
+
+static void checkTones()
+{
+	for ( int type = 0; type < NUM_TONES; type++ )
+	{
+		checkTone( type );
+	}
+	printf( "tones: %d checks\n", NUM_TONES );
+}
+
+// ----------------------------------------------------------------------------
+static void checkScaling()
+{
+	std::vector<short> all( 65536 );
+	std::vector<short> buf( 65536 );
+	for ( int i = 0; i < 65536; i++ )
+	{
+		all[i] = (short)(i - 32768);
+	}
+
+	int checks = 0;
+	for ( int scale = -5; scale <= 130; scale++ )
+	{
+		int clamped = scale < 0 ? 0 : (scale > 100 ? 100 : scale);
+		// odd offset and length, so the tail and an unaligned start are both covered
+		buf = all;
+		WebrtcToneCache::scaleSamples( &buf[1], 65533, scale );
+		for ( int i = 1; i < 65534; i++ )
+		{
+			if ( buf[i] != (short)((all[i] * clamped)/100) )
+			{
+				fail( "scale", scale, "sample differs", i );
+				break;
+			}
+		}
+		if ( buf[0] != all[0] || buf[65534] != all[65534] )
+		{
+			fail( "scale", scale, "wrote outside the buffer", 0 );
+		}
+		checks++;
+	}
+	printf( "scaling: %d checks\n", checks );
+}
+
+// ----------------------------------------------------------------------------
+template <class Generator>
+static double timeReads( Generator& gen, int reads )
+{
+	short buf[FRAME_SAMPLES];
+	double start = nowNs();
+	for ( int i = 0; i < reads; i++ )
+	{
+		gen.Read( buf, sizeof(buf) );
+	}
+	return (nowNs() - start) / reads;
+}
+
+static void timeGenerators( int reads )
+{
+	GoldenToneGenerator goldenTone( ToneType_ALERTING_TONE );
+	WebrtcToneGenerator cachedTone( ToneType_ALERTING_TONE );
+	GoldenRingGenerator goldenRing( RingMode_INSIDE_RING, false );
+	WebrtcRingGenerator cachedRing( RingMode_INSIDE_RING, false );
+	goldenRing.SetScaleFactor( 73 );
+	cachedRing.SetScaleFactor( 73 );
+
+	printf( "alerting tone: %.0f ns/read old, %.0f ns/read cached\n",
+			timeReads( goldenTone, reads ), timeReads( cachedTone, reads ) );
+	printf( "inside ring at 73%%: %.0f ns/read old, %.0f ns/read cached\n",
+			timeReads( goldenRing, reads ), timeReads( cachedRing, reads ) );
+}
+
+int main( int argc, char** argv )
+{
+	int reads = 200000;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "-t" ) == 0 && i + 1 < argc )
+		{
+			reads = atoi( argv[++i] );
+		}
+		else
+		{
+			fprintf( stderr, "usage: %s [-t reads]\n", argv[0] );
+			return 2;
+		}
+	}
+
+	checkRings();
+	checkTones();
+	checkScaling();
+	printf( "%d failures\n", failures );
+
+	if ( reads > 0 )
+	{
+		timeGenerators( reads );
+	}
+	return failures == 0 ? 0 : 1;
+}